@@ -42,6 +42,7 @@ class hyperonRecipe(ConanFile):
 
     def build_requirements(self):
         self.test_requires("gtest/1.13.0")
+        self.test_requires("benchmark/1.7.1")
 
     def layout(self):
         cmake_layout(self)
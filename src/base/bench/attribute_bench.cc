@@ -0,0 +1,152 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/storage/attribute_store.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr uint32_t kCities = 1000000;
+constexpr uint32_t kRegions = 50;
+constexpr double kMaxPopulation = 10e6;
+
+std::string city_name(uint32_t i) { return "city " + std::to_string(i); }
+std::string region_name(uint32_t i) { return "region " + std::to_string(i); }
+
+// Every value of one attribute.
+AttributeQuery whole(const std::string& attribute) {
+  AttributeQuery query;
+  query.attribute = attribute;
+  return query;
+}
+
+// A million cities in 50 regions, with populations and areas.
+struct AttributeFixture {
+  Hyperbase hyperbase{"attributes", "bench"};
+  NumericAttributeStore store{hyperbase};
+
+  AttributeFixture() {
+    std::string error;
+    store.DefineQuality("area");
+    store.DefineUnit("square meter", "area", "", 1, 0, error);
+    store.DefineUnit("square kilometer", "area", "square meter", 1e6, 0,
+                     error);
+    std::vector<Mutation> batch;
+    for (uint32_t i = 0; i < kRegions; ++i) {
+      Mutation mut;
+      mut.concept_kind = Mutation::KIND_ENTITY;
+      mut.subject = region_name(i);
+      batch.push_back(std::move(mut));
+    }
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> population(0, kMaxPopulation);
+    for (uint32_t i = 0; i < kCities; ++i) {
+      Mutation mut;
+      mut.concept_kind = Mutation::KIND_ENTITY;
+      mut.subject = city_name(i);
+      mut.objects.push_back(region_name(rng() % kRegions));
+      store.Set(mut.subject, "population", population(rng), "", error);
+      store.Set(mut.subject, "area", rng() % 5000, "square kilometer",
+                error);
+      batch.push_back(std::move(mut));
+    }
+    hyperbase.ApplyBatch(batch);
+    // Sort the columns ahead of the measured loops.
+    AttributeAggregate all;
+    store.Aggregate(whole("population"), all, error);
+    store.Aggregate(whole("area"), all, error);
+  }
+};
+
+AttributeFixture& fixture() {
+  static AttributeFixture instance;
+  return instance;
+}
+
+void BM_AttributeSet(benchmark::State& state) {
+  std::mt19937 rng(7);
+  std::string error;
+  for (auto _ : state) {
+    state.PauseTiming();
+    Hyperbase hyperbase("attributes", "bench");
+    NumericAttributeStore store(hyperbase);
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      names.push_back(city_name(rng() % kCities));
+    }
+    state.ResumeTiming();
+    for (const auto& name : names) {
+      store.Set(name, "population", rng() % 10000000, "", error);
+    }
+    // The first read sorts the column.
+    AttributeAggregate all;
+    store.Aggregate(whole("population"), all, error);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AttributeSet)->Arg(100000);
+
+// Cities with a population within a 1% wide band.
+void BM_AttributeRange(benchmark::State& state) {
+  AttributeFixture& f = fixture();
+  std::mt19937 rng(11);
+  std::vector<AttributeValue> out;
+  std::string error;
+  AttributeQuery query;
+  query.attribute = "population";
+  for (auto _ : state) {
+    out.clear();
+    query.low = rng() % static_cast<uint32_t>(kMaxPopulation * 0.99);
+    query.high = query.low + kMaxPopulation / 100;
+    f.store.Range(query, out, error);
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_AttributeRange);
+
+// The ten largest cities above a million inhabitants in one region.
+void BM_AttributeTopKUnder(benchmark::State& state) {
+  AttributeFixture& f = fixture();
+  std::mt19937 rng(13);
+  std::vector<AttributeValue> out;
+  std::string error;
+  AttributeQuery query;
+  query.attribute = "population";
+  query.low = 1e6;
+  query.descending = true;
+  query.limit = 10;
+  for (auto _ : state) {
+    out.clear();
+    query.under = region_name(rng() % kRegions);
+    f.store.Range(query, out, error);
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_AttributeTopKUnder);
+
+// Total area of the cities between 1000 and 2000 km2.
+void BM_AttributeAggregate(benchmark::State& state) {
+  AttributeFixture& f = fixture();
+  std::string error;
+  AttributeQuery query;
+  query.attribute = "area";
+  query.unit = "square kilometer";
+  query.low = 1000;
+  query.high = 2000;
+  AttributeAggregate result;
+  for (auto _ : state) {
+    f.store.Aggregate(query, result, error);
+    benchmark::DoNotOptimize(result);
+  }
+  state.counters["rows"] = static_cast<double>(result.count);
+}
+BENCHMARK(BM_AttributeAggregate);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,17 @@
+#include <benchmark/benchmark.h>
+
+namespace hyperon {
+namespace base {
+namespace {
+
+// Tag every report with the release it measures, so that JSON results of
+// successive releases can be compared.
+const bool kContextAdded = [] {
+  benchmark::AddCustomContext("hyperon_version", HYPERON_VERSION);
+  benchmark::AddCustomContext("hyperon_scone_dir", HYPERON_SCONE_DIR);
+  return true;
+}();
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
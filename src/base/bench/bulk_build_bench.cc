@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/bulk_builder.h"
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr uint32_t kTypes = 1000;
+
+std::string type_name(uint32_t i) { return "type " + std::to_string(i); }
+
+// Types in a shallow tree and instances below two or three of them, in
+// random order as an import would name them.
+std::vector<Mutation> make_batch(uint32_t instances) {
+  std::mt19937 rng(42);
+  std::vector<Mutation> batch;
+  for (uint32_t i = 0; i < kTypes; ++i) {
+    Mutation mut;
+    mut.subject = type_name(i);
+    if (i > 0) mut.objects.push_back(type_name(rng() % i));
+    batch.push_back(std::move(mut));
+  }
+  for (uint32_t i = 0; i < instances; ++i) {
+    Mutation mut;
+    mut.concept_kind = Mutation::KIND_ENTITY;
+    mut.subject = "instance " + std::to_string(rng());
+    if (i % 4 == 0) mut.category = "category " + std::to_string(i % 16);
+    for (uint32_t j = 2 + rng() % 2; j > 0; --j) {
+      mut.objects.push_back(type_name(rng() % kTypes));
+    }
+    batch.push_back(std::move(mut));
+  }
+  return batch;
+}
+
+void BM_IncrementalBuild(benchmark::State& state) {
+  std::vector<Mutation> batch = make_batch(state.range(0));
+  for (auto _ : state) {
+    Hyperbase hyperbase("bulk", "bench");
+    hyperbase.ApplyBatch(batch);
+    benchmark::DoNotOptimize(hyperbase.Version());
+  }
+  state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_IncrementalBuild)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+void BM_BulkBuild(benchmark::State& state) {
+  std::vector<Mutation> batch = make_batch(state.range(0));
+  for (auto _ : state) {
+    Hyperbase hyperbase("bulk", "bench");
+    BulkBuilder builder;
+    for (const auto& mut : batch) builder.Add(mut);
+    builder.Build(hyperbase);
+    benchmark::DoNotOptimize(hyperbase.Version());
+  }
+  state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_BulkBuild)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,223 @@
+#include <benchmark/benchmark.h>
+
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/category.h"
+#include "base/core/entity.h"
+#include "base/core/relation.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+std::string concept_name(int64_t i) { return "c" + std::to_string(i); }
+
+// Random picks from [0, count) drawn ahead of the timed loop.
+std::vector<std::string> sample_names(int64_t count, size_t picks,
+                                      int64_t miss_every = 0) {
+  std::mt19937 rng(42);
+  std::vector<std::string> names;
+  names.reserve(picks);
+  for (size_t i = 0; i < picks; ++i) {
+    bool miss = miss_every > 0 && i % miss_every == 0;
+    names.push_back(miss ? "absent" + std::to_string(i)
+                         : concept_name(rng() % count));
+  }
+  return names;
+}
+
+// A category holding `count` concepts, cycling through the concrete types
+// so that typed lookups see both matching and mismatching concepts.
+CategoryPtr make_category(int64_t count) {
+  auto category = std::make_shared<Category>("bench");
+  for (int64_t i = 0; i < count; ++i) {
+    ConceptPtr cnpt;
+    switch (i % 3) {
+      case 0:
+        cnpt = create_entity<Entity>(concept_name(i));
+        break;
+      case 1:
+        cnpt = create_relation<Relation>(concept_name(i));
+        break;
+      default:
+        cnpt = std::make_shared<Concept>(concept_name(i));
+    }
+    category->AddConcept(cnpt);
+  }
+  return category;
+}
+
+template <typename T>
+void BM_CategoryGetConcept(benchmark::State& state) {
+  CategoryPtr category = make_category(state.range(0));
+  std::vector<std::string> names = sample_names(state.range(0), 1 << 14);
+  std::shared_ptr<T> result;
+  size_t i = 0;
+  for (auto _ : state) {
+    category->GetConcept<T>(names[i++ & (names.size() - 1)], result);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_CategoryGetConcept, Concept)->Range(1 << 10, 1 << 17);
+BENCHMARK_TEMPLATE(BM_CategoryGetConcept, Entity)->Range(1 << 10, 1 << 17);
+BENCHMARK_TEMPLATE(BM_CategoryGetConcept, Relation)->Range(1 << 10, 1 << 17);
+
+// One lookup in four misses.
+void BM_CategoryHasElement(benchmark::State& state) {
+  CategoryPtr category = make_category(state.range(0));
+  std::vector<std::string> names = sample_names(state.range(0), 1 << 14, 4);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        category->HasElement(names[i++ & (names.size() - 1)]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CategoryHasElement)->Range(1 << 10, 1 << 17);
+
+// `count` parents of a fresh child, in both directions as the hyperbase
+// links them.
+void BM_LineageAddParent(benchmark::State& state) {
+  std::vector<ConceptPtr> parents;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    parents.push_back(std::make_shared<Concept>(concept_name(i)));
+  }
+  for (auto _ : state) {
+    auto child = std::make_shared<Concept>("child");
+    for (const auto& parent : parents) {
+      child->AddParent(parent);
+      parent->AddChild(child);
+    }
+    state.PauseTiming();
+    for (const auto& parent : parents) parent->ClearLineage();
+    child->ClearLineage();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LineageAddParent)->Range(1, 1 << 10);
+
+void BM_LineageHasParent(benchmark::State& state) {
+  auto child = std::make_shared<Concept>("child");
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    child->AddParent(std::make_shared<Concept>(concept_name(i)));
+  }
+  // Twice the range, so half of the probes miss.
+  std::vector<std::string> names = sample_names(2 * state.range(0), 1 << 12);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        child->HasParent(names[i++ & (names.size() - 1)]));
+  }
+  state.SetItemsProcessed(state.iterations());
+  child->ClearLineage();
+}
+BENCHMARK(BM_LineageHasParent)->Range(1, 1 << 10);
+
+// Disjoint splits of `range(0)` children each, 64 per iteration. Every
+// call checks the existing splits before adding its own.
+void BM_LineageAddChildrenSplit(benchmark::State& state) {
+  constexpr int64_t kSplits = 64;
+  std::vector<std::list<ElementPtr>> splits(kSplits);
+  for (int64_t s = 0; s < kSplits; ++s) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      splits[s].push_back(
+          std::make_shared<Concept>(concept_name(s * state.range(0) + i)));
+    }
+  }
+  for (auto _ : state) {
+    auto parent = std::make_shared<Concept>("parent");
+    for (const auto& split : splits) parent->AddChildrenSplit(split);
+    benchmark::DoNotOptimize(parent);
+  }
+  state.SetItemsProcessed(state.iterations() * kSplits);
+}
+BENCHMARK(BM_LineageAddChildrenSplit)->RangeMultiplier(4)->Range(2, 128);
+
+std::vector<EntityPtr> make_entities(int64_t count) {
+  std::vector<EntityPtr> entities;
+  for (int64_t i = 0; i < count; ++i) {
+    entities.push_back(create_entity<Entity>(concept_name(i)));
+  }
+  return entities;
+}
+
+void BM_RelationAddEntity(benchmark::State& state) {
+  std::vector<EntityPtr> entities = make_entities(state.range(0));
+  for (auto _ : state) {
+    auto relation = create_relation<Relation>("relation");
+    for (const auto& entity : entities) relation->AddEntity(entity);
+    benchmark::DoNotOptimize(relation);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RelationAddEntity)->Range(2, 1 << 12);
+
+void BM_RelationEraseEntityOrRelation(benchmark::State& state) {
+  std::vector<EntityPtr> entities = make_entities(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto relation = create_relation<Relation>("relation");
+    for (const auto& entity : entities) relation->AddEntity(entity);
+    state.ResumeTiming();
+    for (const auto& entity : entities) {
+      relation->EraseEntityOrRelation(entity->SemName());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RelationEraseEntityOrRelation)->Range(2, 1 << 12);
+
+// Downcasts of the helpers in element.h and concept.h, half of which fail.
+void BM_CastFromConcept(benchmark::State& state) {
+  std::vector<ConceptPtr> concepts;
+  for (int64_t i = 0; i < 1024; ++i) {
+    if (i % 2 == 0) {
+      concepts.push_back(create_entity<Entity>(concept_name(i)));
+    } else {
+      concepts.push_back(create_relation<Relation>(concept_name(i)));
+    }
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        cast_from_concept<Entity>(concepts[i++ & (concepts.size() - 1)]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CastFromConcept);
+
+void BM_CastFromElement(benchmark::State& state) {
+  ElementPtr element = create_relation<Relation>("relation");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cast_from_element<Relation>(element));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CastFromElement);
+
+void BM_CastToConcept(benchmark::State& state) {
+  std::shared_ptr<const Entity> entity = create_entity<Entity>("entity");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cast_to_concept<Entity>(entity));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CastToConcept);
+
+// Virtual type tests, the cheap alternative to a failing cast.
+void BM_ConceptIsEntity(benchmark::State& state) {
+  ConceptPtr cnpt = create_relation<Relation>("relation");
+  for (auto _ : state) benchmark::DoNotOptimize(cnpt->IsEntity());
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConceptIsEntity);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+
+#include "base/bench/scone_fixture.h"
+#include "base/core/hyperbase.h"
+#include "base/datalog/datalog_engine.h"
+#include "base/datalog/datalog_view.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+using bench::load_scone_core;
+using bench::scone_core;
+
+void run_program(benchmark::State& state, const char* text,
+                 const char* predicate) {
+  DatalogProgram program;
+  std::string error;
+  if (!program.Parse(text, error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  const Hyperbase& hyperbase = scone_core();
+  DatalogEngine::Options options;
+  options.threads = static_cast<size_t>(state.range(0));
+  size_t facts = 0;
+  for (auto _ : state) {
+    DatalogEngine engine(program, options);
+    if (!engine.Evaluate(hyperbase, error)) {
+      state.SkipWithError(error.c_str());
+      return;
+    }
+    facts = engine.FactCount(predicate);
+    benchmark::DoNotOptimize(facts);
+  }
+  state.counters["facts"] = static_cast<double>(facts);
+  state.counters["facts/s"] =
+      benchmark::Counter(static_cast<double>(facts),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void BM_DatalogTransitiveClosure(benchmark::State& state) {
+  run_program(state,
+              "anc(X, Y) :- isa(X, Y).\n"
+              "anc(X, Z) :- isa(X, Y), anc(Y, Z).\n",
+              "anc");
+}
+BENCHMARK(BM_DatalogTransitiveClosure)->Arg(1);
+
+void BM_DatalogSameGeneration(benchmark::State& state) {
+  run_program(state,
+              "sg(X, Y) :- isa(X, P), isa(Y, P), X != Y.\n"
+              "sg(X, Y) :- isa(X, A), sg(A, B), isa(Y, B).\n",
+              "sg");
+}
+BENCHMARK(BM_DatalogSameGeneration)->Arg(1);
+
+// Both queries as independent strata of one program, evaluated in one wave.
+void BM_DatalogIndependentStrata(benchmark::State& state) {
+  run_program(state,
+              "anc(X, Y) :- isa(X, Y).\n"
+              "anc(X, Z) :- isa(X, Y), anc(Y, Z).\n"
+              "sg(X, Y) :- isa(X, P), isa(Y, P), X != Y.\n"
+              "sg(X, Y) :- isa(X, A), sg(A, B), isa(Y, B).\n",
+              "sg");
+}
+BENCHMARK(BM_DatalogIndependentStrata)->Arg(1)->Arg(2)->UseRealTime();
+
+// One lineage edge removed and added back per iteration, with the transitive
+// closure and same-generation facts maintained incrementally.
+void BM_DatalogIncrementalEdit(benchmark::State& state) {
+  std::shared_ptr<Hyperbase> hyperbase = load_scone_core();
+  DatalogProgram program;
+  std::string error;
+  program.Parse(
+      "anc(X, Y) :- isa(X, Y).\n"
+      "anc(X, Z) :- isa(X, Y), anc(Y, Z).\n"
+      "sg(X, Y) :- isa(X, P), isa(Y, P), X != Y.\n"
+      "sg(X, Y) :- isa(X, A), sg(A, B), isa(Y, B).\n",
+      error);
+  auto view = std::make_shared<DatalogView>(*hyperbase, program);
+  hyperbase->AddCommitObserver(view);
+  if (!view->Refresh(error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+
+  // Edges towards mid-level types, whose removal changes a few facts.
+  std::vector<Mutation> edges;
+  hyperbase->ForEachConcept([&edges](const ConceptPtr& cnpt) {
+    if (cnpt->ChildCount() != 0 || edges.size() >= 64) return;
+    cnpt->ForEachParent([&edges, &cnpt](const ElementPtr& parent) {
+      Mutation mut;
+      mut.subject = cnpt->SemName();
+      mut.objects = {parent->SemName()};
+      edges.push_back(std::move(mut));
+    });
+  });
+  size_t next = 0;
+  for (auto _ : state) {
+    Mutation edge = edges[next++ % edges.size()];
+    edge.kind = Mutation::MUT_REMOVE_PARENT;
+    hyperbase->ApplyBatch({edge});
+    view->Refresh(error);
+    edge.kind = Mutation::MUT_ADD_PARENT;
+    hyperbase->ApplyBatch({edge});
+    view->Refresh(error);
+  }
+  DatalogStats stats = view->Stats();
+  state.counters["facts/edit"] = benchmark::Counter(
+      static_cast<double>(stats.inserted_facts + stats.erased_facts),
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_DatalogIncrementalEdit);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
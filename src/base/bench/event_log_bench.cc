@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/storage/event_log_store.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr uint32_t kConcepts = 10000;
+constexpr uint32_t kEvents = 1000000;
+// Ten events per millisecond, i.e. ingestion at 10k events/s.
+constexpr int64_t kEventsPerMilli = 10;
+
+EventRecord synthetic_event(std::mt19937& rng, int64_t start) {
+  EventRecord record;
+  record.start = start;
+  record.end = start + rng() % 5000;
+  record.type = 1 + rng() % 100;
+  record.agent = 1 + rng() % kConcepts;
+  record.object = 1 + rng() % kConcepts;
+  record.location = 1 + rng() % 1000;
+  return record;
+}
+
+void intern_concepts(EventLogStore& store) {
+  for (uint32_t i = 0; i < kConcepts; ++i) {
+    store.Intern("concept " + std::to_string(i));
+  }
+}
+
+// A million events over 100 seconds, sealed.
+struct EventLogFixture {
+  EventLogStore store;
+
+  EventLogFixture() {
+    intern_concepts(store);
+    std::mt19937 rng(42);
+    for (uint32_t i = 0; i < kEvents; ++i) {
+      store.Append(synthetic_event(rng, i / kEventsPerMilli));
+    }
+    store.Flush();
+  }
+};
+
+EventLogFixture& fixture() {
+  static EventLogFixture instance;
+  return instance;
+}
+
+std::unique_ptr<EventLogStore> append_store;
+
+// Concurrent producers appending in time order.
+void BM_EventLogAppend(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    append_store = std::make_unique<EventLogStore>();
+    intern_concepts(*append_store);
+  }
+  std::mt19937 rng(state.thread_index());
+  int64_t start = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        append_store->Append(synthetic_event(rng, start++ / kEventsPerMilli)));
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    EventLogStats stats = append_store->Stats();
+    state.counters["packed_bytes"] = static_cast<double>(stats.packed_bytes);
+    state.counters["events"] = static_cast<double>(stats.events);
+    append_store.reset();
+  }
+}
+BENCHMARK(BM_EventLogAppend)->Threads(1)->Threads(4)->UseRealTime();
+
+void BM_EventLogOverlapping(benchmark::State& state) {
+  EventLogFixture& f = fixture();
+  std::mt19937 rng(7);
+  int64_t span = kEvents / kEventsPerMilli;
+  std::vector<EventView> out;
+  std::string error;
+  for (auto _ : state) {
+    out.clear();
+    int64_t start = rng() % span;
+    if (!f.store.Overlapping(start, start + state.range(0), out, error)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  EventLogStats stats = f.store.Stats();
+  state.counters["bytes_per_event"] =
+      static_cast<double>(stats.packed_bytes) / stats.events;
+}
+BENCHMARK(BM_EventLogOverlapping)->Arg(10)->Arg(1000);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,175 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/bench/scone_fixture.h"
+#include "base/bench/synthetic_graph.h"
+#include "base/core/hyperbase.h"
+#include "base/query/batch_query.h"
+#include "base/query/lineage_cursor.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr size_t kMaxOrigins = 4096;
+
+void add_synthetic_sizes(benchmark::internal::Benchmark* b) {
+  for (int64_t size : bench::synthetic_sizes()) b->Arg(size);
+}
+
+// The synthetic hierarchy of the last requested size, so that only one
+// large graph is alive at a time.
+const Hyperbase& synthetic(int64_t count) {
+  static int64_t built = -1;
+  static std::unique_ptr<Hyperbase> hyperbase;
+  if (built != count) {
+    hyperbase.reset();
+    hyperbase = bench::synthetic_hierarchy(count);
+    built = count;
+  }
+  return *hyperbase;
+}
+
+size_t walk(const Hyperbase& hb, const std::vector<std::string>& origins,
+            LineageCursor::DIRECTION direction,
+            common::ProfileNode* profile = nullptr) {
+  std::vector<std::vector<std::string>> out;
+  walk_lineage(hb, origins, direction, 0, out, profile);
+  size_t visited = 0;
+  for (const auto& names : out) visited += names.size();
+  return visited;
+}
+
+void BM_SconeLoadCore(benchmark::State& state) {
+  uint64_t concepts = 0;
+  for (auto _ : state) {
+    std::unique_ptr<Hyperbase> hb = bench::load_scone_core();
+    if (!hb) {
+      state.SkipWithError("cannot load " HYPERON_SCONE_DIR);
+      return;
+    }
+    concepts = hb->ConceptCount();
+  }
+  state.counters["concepts"] = static_cast<double>(concepts);
+  state.SetItemsProcessed(state.iterations() * concepts);
+}
+BENCHMARK(BM_SconeLoadCore)->Unit(benchmark::kMillisecond);
+
+std::vector<std::string> scone_leaves(const Hyperbase& hb) {
+  std::vector<std::string> leaves;
+  hb.ForEachConcept([&leaves](const ConceptPtr& cnpt) {
+    if (cnpt->ChildCount() == 0 && leaves.size() < kMaxOrigins) {
+      leaves.push_back(cnpt->SemName());
+    }
+  });
+  return leaves;
+}
+
+// Every ancestor of every leaf of the Scone core.
+void BM_SconeAncestors(benchmark::State& state) {
+  const Hyperbase& hb = bench::scone_core();
+  std::vector<std::string> leaves = scone_leaves(hb);
+  size_t visited = 0;
+  for (auto _ : state) {
+    visited = walk(hb, leaves, LineageCursor::ANCESTORS);
+  }
+  state.counters["origins"] = static_cast<double>(leaves.size());
+  state.counters["visited"] = static_cast<double>(visited);
+  state.SetItemsProcessed(state.iterations() * visited);
+}
+BENCHMARK(BM_SconeAncestors)->Unit(benchmark::kMicrosecond);
+
+// The same walks with an execution profile, for its overhead.
+void BM_SconeAncestorsProfiled(benchmark::State& state) {
+  const Hyperbase& hb = bench::scone_core();
+  std::vector<std::string> leaves = scone_leaves(hb);
+  size_t visited = 0;
+  common::ProfileNode profile;
+  for (auto _ : state) {
+    visited = walk(hb, leaves, LineageCursor::ANCESTORS, &profile);
+  }
+  state.counters["visited"] = static_cast<double>(visited);
+  state.SetItemsProcessed(state.iterations() * visited);
+}
+BENCHMARK(BM_SconeAncestorsProfiled)->Unit(benchmark::kMicrosecond);
+
+// Every descendant of every root of the Scone core.
+void BM_SconeDescendants(benchmark::State& state) {
+  const Hyperbase& hb = bench::scone_core();
+  std::vector<std::string> roots;
+  hb.ForEachConcept([&roots](const ConceptPtr& cnpt) {
+    if (cnpt->ParentCount() == 0) roots.push_back(cnpt->SemName());
+  });
+  size_t visited = 0;
+  for (auto _ : state) {
+    visited = walk(hb, roots, LineageCursor::DESCENDANTS);
+  }
+  state.counters["origins"] = static_cast<double>(roots.size());
+  state.counters["visited"] = static_cast<double>(visited);
+  state.SetItemsProcessed(state.iterations() * visited);
+}
+BENCHMARK(BM_SconeDescendants)->Unit(benchmark::kMicrosecond);
+
+void BM_SyntheticBuild(benchmark::State& state) {
+  for (auto _ : state) {
+    std::unique_ptr<Hyperbase> hb = bench::synthetic_hierarchy(state.range(0));
+    benchmark::DoNotOptimize(hb);
+    state.counters["memory"] = static_cast<double>(hb->MemoryUsage());
+    state.PauseTiming();
+    hb.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SyntheticBuild)
+    ->Apply(add_synthetic_sizes)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+// Ancestors of random deep concepts, about ten each.
+void BM_SyntheticAncestors(benchmark::State& state) {
+  const Hyperbase& hb = synthetic(state.range(0));
+  std::mt19937_64 rng(7);
+  std::vector<std::string> origins;
+  uint64_t half = state.range(0) / 2;
+  for (size_t i = 0; i < kMaxOrigins; ++i) {
+    origins.push_back(bench::synthetic_name(half + rng() % half));
+  }
+  size_t visited = 0;
+  for (auto _ : state) {
+    visited = walk(hb, origins, LineageCursor::ANCESTORS);
+  }
+  state.counters["visited"] = static_cast<double>(visited);
+  state.SetItemsProcessed(state.iterations() * visited);
+}
+BENCHMARK(BM_SyntheticAncestors)
+    ->Apply(add_synthetic_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+// Subtree of a third-level concept pulled through a cursor in chunks.
+void BM_SyntheticDescendants(benchmark::State& state) {
+  const Hyperbase& hb = synthetic(state.range(0));
+  std::vector<std::string> chunk;
+  size_t visited = 0;
+  for (auto _ : state) {
+    LineageCursor cursor(bench::synthetic_name(73), LineageCursor::DESCENDANTS);
+    visited = 0;
+    while (!cursor.Exhausted()) {
+      chunk.clear();
+      visited += cursor.Next(hb, 4096, chunk);
+    }
+  }
+  state.counters["visited"] = static_cast<double>(visited);
+  state.SetItemsProcessed(state.iterations() * visited);
+}
+BENCHMARK(BM_SyntheticDescendants)
+    ->Apply(add_synthetic_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,112 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bench/scone_fixture.h"
+#include "base/core/hyperbase.h"
+#include "base/query/inheritance.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr size_t kMaxLookups = 4096;
+
+// Scone core with a resolver fed by its role and cancellation assertions,
+// and the applicable (leaf type, role) pairs to look up.
+struct InheritanceFixture {
+  std::shared_ptr<Hyperbase> hyperbase;
+  std::shared_ptr<InheritanceResolver> resolver;
+  std::vector<std::pair<std::string, std::string>> lookups;
+
+  InheritanceFixture() {
+    hyperbase = std::make_shared<Hyperbase>("scone", "bench");
+    resolver = std::make_shared<InheritanceResolver>(*hyperbase);
+    hyperbase->AddCommitObserver(resolver);
+    SconeLoader loader(*hyperbase);
+    register_inheritance_forms(loader, *resolver);
+    bench::load_scone_core(loader);
+
+    std::vector<std::string> leaves;
+    std::vector<std::string> roles;
+    hyperbase->ForEachConcept([&](const ConceptPtr& cnpt) {
+      if (cnpt->IsRole()) {
+        roles.push_back(cnpt->SemName());
+      } else if (cnpt->ChildCount() == 0) {
+        leaves.push_back(cnpt->SemName());
+      }
+    });
+    RoleValue value;
+    for (const auto& leaf : leaves) {
+      for (const auto& role : roles) {
+        if (lookups.size() == kMaxLookups) break;
+        if (resolver->Resolve(leaf, role, value) && value.applicable) {
+          lookups.emplace_back(leaf, role);
+        }
+      }
+    }
+  }
+};
+
+InheritanceFixture& fixture() {
+  static InheritanceFixture instance;
+  return instance;
+}
+
+void resolve_all(InheritanceFixture& f) {
+  RoleValue value;
+  for (const auto& lookup : f.lookups) {
+    f.resolver->Resolve(lookup.first, lookup.second, value);
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+// Every lookup walks the lineage.
+void BM_InheritanceResolveCold(benchmark::State& state) {
+  InheritanceFixture& f = fixture();
+  for (auto _ : state) {
+    f.resolver->Clear();
+    resolve_all(f);
+  }
+  state.SetItemsProcessed(state.iterations() * f.lookups.size());
+}
+BENCHMARK(BM_InheritanceResolveCold);
+
+// Every lookup is served from the cache.
+void BM_InheritanceResolveCached(benchmark::State& state) {
+  InheritanceFixture& f = fixture();
+  resolve_all(f);
+  for (auto _ : state) resolve_all(f);
+  state.SetItemsProcessed(state.iterations() * f.lookups.size());
+}
+BENCHMARK(BM_InheritanceResolveCached);
+
+// A lineage edge removed and added back between lookup rounds, dropping
+// only the entries below it.
+void BM_InheritanceResolveAfterEdit(benchmark::State& state) {
+  InheritanceFixture& f = fixture();
+  Mutation edge;
+  ConceptPtr leaf;
+  f.hyperbase->GetConcept(f.lookups.front().first, leaf);
+  edge.subject = leaf->SemName();
+  leaf->ForEachParent([&edge](const ElementPtr& parent) {
+    if (edge.objects.empty()) edge.objects.push_back(parent->SemName());
+  });
+  resolve_all(f);
+  for (auto _ : state) {
+    edge.kind = Mutation::MUT_REMOVE_PARENT;
+    f.hyperbase->ApplyBatch({edge});
+    edge.kind = Mutation::MUT_ADD_PARENT;
+    f.hyperbase->ApplyBatch({edge});
+    resolve_all(f);
+  }
+  state.SetItemsProcessed(state.iterations() * f.lookups.size());
+}
+BENCHMARK(BM_InheritanceResolveAfterEdit);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "common/metrics/metrics.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+// Cost added to every instrumented operation, to be compared with the
+// operations themselves, e.g. BM_CategoryHasElement.
+
+void BM_MetricsCounterAdd(benchmark::State& state) {
+  static const common::Counter counter("bench_counter_total", "Bench.");
+  for (auto _ : state) counter.Add();
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricsCounterAdd)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_MetricsHistogramRecord(benchmark::State& state) {
+  static const common::Histogram histogram("bench_latency_seconds", "Bench.");
+  uint64_t value = 1;
+  for (auto _ : state) {
+    histogram.Record(value);
+    value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+    value >>= 40;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricsHistogramRecord)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_MetricsScopedLatency(benchmark::State& state) {
+  static const common::Histogram histogram("bench_scope_seconds", "Bench.");
+  for (auto _ : state) common::ScopedLatency latency(histogram);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricsScopedLatency);
+
+void BM_MetricsScrape(benchmark::State& state) {
+  common::MetricsSnapshot snapshot;
+  for (auto _ : state) {
+    snapshot.clear();
+    common::MetricsRegistry::Instance().Snapshot(snapshot);
+    benchmark::DoNotOptimize(common::format_prometheus(snapshot));
+  }
+}
+BENCHMARK(BM_MetricsScrape)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/batch_query.h"
+#include "base/query/result_cache.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr uint32_t kTypes = 10000;
+constexpr uint32_t kInstances = 200000;
+// Distinct queries asked over and over.
+constexpr uint32_t kHotQueries = 1000;
+
+std::string type_name(uint32_t i) { return "type " + std::to_string(i); }
+// Hot types two levels above the instances, whose descendant sets of
+// about 170 concepts all fit in the default cache together.
+std::string hot_type(uint32_t i) { return type_name(kTypes / 8 + i); }
+std::string instance_name(uint32_t i) {
+  return "instance " + std::to_string(i);
+}
+
+// A deep type tree with instances below its leaves.
+struct CacheFixture {
+  std::shared_ptr<Hyperbase> hyperbase =
+      std::make_shared<Hyperbase>("cache", "bench");
+
+  CacheFixture() {
+    std::mt19937 rng(42);
+    std::vector<Mutation> batch;
+    for (uint32_t i = 0; i < kTypes; ++i) {
+      Mutation mut;
+      mut.subject = type_name(i);
+      if (i > 0) mut.objects.push_back(type_name((i - 1) / 4));
+      batch.push_back(std::move(mut));
+    }
+    for (uint32_t i = 0; i < kInstances; ++i) {
+      Mutation mut;
+      mut.concept_kind = Mutation::KIND_ENTITY;
+      mut.subject = instance_name(i);
+      mut.objects.push_back(type_name(kTypes / 2 + rng() % (kTypes / 2)));
+      batch.push_back(std::move(mut));
+    }
+    hyperbase->ApplyBatch(batch);
+  }
+};
+
+CacheFixture& fixture() {
+  static CacheFixture instance;
+  return instance;
+}
+
+// Descendants of one of the hot types, recomputed every time.
+void BM_DescendantsUncached(benchmark::State& state) {
+  CacheFixture& f = fixture();
+  std::mt19937 rng(7);
+  std::vector<std::vector<std::string>> out;
+  for (auto _ : state) {
+    out.clear();
+    walk_lineage(*f.hyperbase, {hot_type(rng() % kHotQueries)},
+                 LineageCursor::DESCENDANTS, 0, out);
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_DescendantsUncached);
+
+// The same through the cache, with an unrelated concept added every
+// `range(0)` queries, 0 for none.
+void BM_DescendantsCached(benchmark::State& state) {
+  CacheFixture& f = fixture();
+  auto cache = std::make_shared<QueryResultCache>(*f.hyperbase);
+  f.hyperbase->AddCommitObserver(cache);
+  for (uint32_t i = 0; i < kHotQueries; ++i) {
+    cache->Lineage(hot_type(i), LineageCursor::DESCENDANTS);
+  }
+  std::mt19937 rng(7);
+  uint64_t queries = 0;
+  // Runs of the benchmark share the hyperbase, name the concepts anew.
+  static uint64_t added = 0;
+  for (auto _ : state) {
+    if (state.range(0) > 0 && ++queries % state.range(0) == 0) {
+      state.PauseTiming();
+      Mutation mut;
+      mut.subject = "unrelated " + std::to_string(++added);
+      f.hyperbase->ApplyBatch({mut});
+      state.ResumeTiming();
+    }
+    CachedResultPtr result = cache->Lineage(hot_type(rng() % kHotQueries),
+                                            LineageCursor::DESCENDANTS);
+    benchmark::DoNotOptimize(result);
+  }
+  f.hyperbase->RemoveCommitObserver(cache);
+  ResultCacheStats stats = cache->Stats();
+  state.counters["hit_rate"] =
+      static_cast<double>(stats.hits) / (stats.hits + stats.misses);
+  state.counters["evicted"] = static_cast<double>(stats.evicted);
+}
+BENCHMARK(BM_DescendantsCached)->Arg(0)->Arg(100);
+
+void BM_IsAUncached(benchmark::State& state) {
+  CacheFixture& f = fixture();
+  std::mt19937 rng(11);
+  std::vector<std::vector<std::string>> out;
+  for (auto _ : state) {
+    out.clear();
+    walk_lineage(*f.hyperbase, {instance_name(rng() % kHotQueries)},
+                 LineageCursor::ANCESTORS, 0, out);
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_IsAUncached);
+
+void BM_IsACached(benchmark::State& state) {
+  CacheFixture& f = fixture();
+  auto cache = std::make_shared<QueryResultCache>(*f.hyperbase);
+  f.hyperbase->AddCommitObserver(cache);
+  std::mt19937 rng(11);
+  for (auto _ : state) {
+    bool is_a =
+        cache->IsA(instance_name(rng() % kHotQueries), type_name(rng() % 8));
+    benchmark::DoNotOptimize(is_a);
+  }
+  f.hyperbase->RemoveCommitObserver(cache);
+}
+BENCHMARK(BM_IsACached);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
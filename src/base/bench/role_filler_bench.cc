@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/storage/role_filler_store.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr uint32_t kOwners = 100000;
+constexpr uint32_t kRoles = 16;
+constexpr uint32_t kFillers = 200000;
+constexpr uint32_t kStatements = 1000000;
+
+std::string owner_name(uint32_t i) { return "owner " + std::to_string(i); }
+std::string role_name(uint32_t i) { return "role " + std::to_string(i); }
+std::string filler_name(uint32_t i) { return "filler " + std::to_string(i); }
+
+// A million synthetic statements over an empty hyperbase.
+struct RoleFillerFixture {
+  Hyperbase hyperbase{"roles", "bench"};
+  RoleFillerStore store{hyperbase};
+
+  RoleFillerFixture() {
+    std::mt19937 rng(42);
+    for (uint32_t i = 0; i < kStatements; ++i) {
+      store.Add(owner_name(rng() % kOwners), role_name(rng() % kRoles),
+                filler_name(rng() % kFillers));
+    }
+  }
+};
+
+RoleFillerFixture& fixture() {
+  static RoleFillerFixture instance;
+  return instance;
+}
+
+void BM_RoleFillerAdd(benchmark::State& state) {
+  std::mt19937 rng(7);
+  for (auto _ : state) {
+    state.PauseTiming();
+    Hyperbase hyperbase("roles", "bench");
+    RoleFillerStore store(hyperbase);
+    std::vector<std::string> owners, roles, fillers;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      owners.push_back(owner_name(rng() % kOwners));
+      roles.push_back(role_name(rng() % kRoles));
+      fillers.push_back(filler_name(rng() % kFillers));
+    }
+    state.ResumeTiming();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      store.Add(owners[i], roles[i], fillers[i]);
+    }
+    // Includes merging the out-of-order statements.
+    benchmark::DoNotOptimize(store.Stats());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RoleFillerAdd)->Arg(100000);
+
+// Few owners with long filler lists, the fillers interned beforehand in
+// another order, so nearly every statement lands below the largest id.
+void BM_RoleFillerAddLongLists(benchmark::State& state) {
+  std::mt19937 rng(9);
+  for (auto _ : state) {
+    state.PauseTiming();
+    Hyperbase hyperbase("roles", "bench");
+    RoleFillerStore store(hyperbase);
+    std::vector<std::string> fillers;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      fillers.push_back(filler_name(i));
+      store.Add("seed", "seed", fillers.back());
+    }
+    std::shuffle(fillers.begin(), fillers.end(), rng);
+    state.ResumeTiming();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      store.Add(owner_name(i % 4), role_name(0), fillers[i]);
+    }
+    benchmark::DoNotOptimize(store.Stats());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RoleFillerAddLongLists)->Arg(20000);
+
+void BM_RoleFillerForward(benchmark::State& state) {
+  RoleFillerFixture& f = fixture();
+  std::mt19937 rng(11);
+  std::vector<std::string> out;
+  for (auto _ : state) {
+    out.clear();
+    f.store.Fillers(owner_name(rng() % kOwners), role_name(rng() % kRoles),
+                    false, out);
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_RoleFillerForward);
+
+void BM_RoleFillerReverse(benchmark::State& state) {
+  RoleFillerFixture& f = fixture();
+  std::mt19937 rng(13);
+  std::vector<std::string> out;
+  for (auto _ : state) {
+    out.clear();
+    f.store.Owners(filler_name(rng() % kFillers), role_name(rng() % kRoles),
+                   false, out);
+    benchmark::DoNotOptimize(out);
+  }
+  RoleFillerStats stats = f.store.Stats();
+  state.counters["list_bytes"] = static_cast<double>(stats.list_bytes);
+  state.counters["statements"] = static_cast<double>(stats.statements);
+}
+BENCHMARK(BM_RoleFillerReverse);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
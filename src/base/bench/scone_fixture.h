@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "base/core/hyperbase.h"
+#include "base/storage/scone_loader.h"
+
+namespace hyperon {
+namespace base {
+namespace bench {
+
+// Load the Scone core components through `loader`.
+inline bool load_scone_core(SconeLoader& loader) {
+  std::string error;
+  return loader.LoadCore(HYPERON_SCONE_DIR, error);
+}
+
+// A fresh hyperbase with the Scone core components, null if loading failed.
+inline std::unique_ptr<Hyperbase> load_scone_core() {
+  auto hb = std::make_unique<Hyperbase>("scone", "bench");
+  SconeLoader loader(*hb);
+  if (!load_scone_core(loader)) hb.reset();
+  return hb;
+}
+
+// The Scone core components, loaded once for all read-only benchmarks.
+inline const Hyperbase& scone_core() {
+  static std::unique_ptr<Hyperbase> hyperbase = load_scone_core();
+  return *hyperbase;
+}
+
+}  // namespace bench
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+namespace bench {
+
+// Name of the i-th synthetic concept, "n0" being the root.
+inline std::string synthetic_name(uint64_t i) {
+  return "n" + std::to_string(i);
+}
+
+/**
+ * @brief A hyperbase of `count` concepts forming a DAG: concept i > 0 is
+ * the child of (i - 1) / fanout, and one in `extra_every` concepts also gets
+ * a second, random earlier parent. Deterministic for a given seed.
+ */
+inline std::unique_ptr<Hyperbase> synthetic_hierarchy(
+    uint64_t count, uint32_t fanout = 8, uint32_t extra_every = 10,
+    uint32_t seed = 42) {
+  constexpr size_t kBatch = 1 << 16;
+  auto hb = std::make_unique<Hyperbase>("synthetic", "bench");
+  std::mt19937_64 rng(seed);
+  std::vector<Mutation> batch;
+  batch.reserve(kBatch);
+  for (uint64_t i = 0; i < count; ++i) {
+    Mutation mut;
+    mut.subject = synthetic_name(i);
+    if (i > 0) {
+      uint64_t parent = (i - 1) / fanout;
+      mut.objects.push_back(synthetic_name(parent));
+      if (extra_every > 0 && i % extra_every == 0) {
+        uint64_t extra = rng() % i;
+        if (extra != parent) mut.objects.push_back(synthetic_name(extra));
+      }
+    }
+    batch.push_back(std::move(mut));
+    if (batch.size() == kBatch) {
+      hb->ApplyBatch(batch);
+      batch.clear();
+    }
+  }
+  if (!batch.empty()) hb->ApplyBatch(batch);
+  return hb;
+}
+
+/**
+ * @brief Sizes of the synthetic benchmarks: 1M and 10M concepts, capped by
+ * the HYPERON_BENCH_MAX_CONCEPTS environment variable (default 1M) since
+ * 10M concepts need several gigabytes.
+ */
+inline std::vector<int64_t> synthetic_sizes() {
+  int64_t cap = 1000000;
+  if (const char* env = std::getenv("HYPERON_BENCH_MAX_CONCEPTS")) {
+    cap = std::strtoll(env, nullptr, 10);
+  }
+  std::vector<int64_t> sizes;
+  for (int64_t size : {int64_t{1000000}, int64_t{10000000}}) {
+    if (size <= cap) sizes.push_back(size);
+  }
+  return sizes;
+}
+
+}  // namespace bench
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/event.h"
+#include "base/core/hyperbase.h"
+#include "base/query/temporal_query.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr uint32_t kEvents = 200000;
+// Time points between event starts, and the width of query windows.
+constexpr int64_t kStep = 10;
+constexpr int64_t kWindow = 1000;
+
+std::string event_name(uint32_t i) { return "event " + std::to_string(i); }
+
+Mutation set_interval(uint32_t i, int64_t start, int64_t end) {
+  Mutation mut;
+  mut.kind = Mutation::MUT_SET_INTERVAL;
+  mut.subject = event_name(i);
+  mut.objects = {std::to_string(start),
+                 end == Event::kOpenEnd ? "" : std::to_string(end)};
+  return mut;
+}
+
+// An append-ordered stream of events lasting up to 100 steps, one in a
+// thousand still going on. `events` keeps a copy for the scan baseline.
+struct TemporalFixture {
+  Hyperbase hyperbase{"temporal", "bench"};
+  std::vector<TimedEvent> events;
+
+  TemporalFixture() {
+    std::mt19937 rng(42);
+    std::vector<Mutation> batch;
+    for (uint32_t i = 0; i < kEvents; ++i) {
+      Mutation add;
+      add.kind = Mutation::MUT_ADD_CONCEPT;
+      add.concept_kind = Mutation::KIND_EVENT;
+      add.subject = event_name(i);
+      batch.push_back(std::move(add));
+    }
+    for (uint32_t i = 0; i < kEvents; ++i) {
+      int64_t start = i * kStep;
+      int64_t end = rng() % 1000 == 0 ? Event::kOpenEnd
+                                      : start + rng() % (100 * kStep);
+      batch.push_back(set_interval(i, start, end));
+      events.push_back({event_name(i), start, end});
+    }
+    hyperbase.ApplyBatch(batch);
+  }
+};
+
+TemporalFixture& fixture() {
+  static TemporalFixture instance;
+  return instance;
+}
+
+// Windows of kWindow points anywhere in the stream, by relation.
+void BM_FindEvents(benchmark::State& state) {
+  TemporalFixture& f = fixture();
+  auto relation = static_cast<TEMPORAL_RELATION>(state.range(0));
+  std::mt19937 rng(7);
+  std::vector<TimedEvent> out;
+  size_t rows = 0;
+  for (auto _ : state) {
+    out.clear();
+    int64_t start = rng() % (kEvents * kStep);
+    rows += find_events(f.hyperbase, relation, start, start + kWindow, out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetLabel(temporal_relation_name(relation));
+  state.counters["rows"] = benchmark::Counter(
+      static_cast<double>(rows), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_FindEvents)
+    ->Arg(TEMPORAL_OVERLAPS)
+    ->Arg(TEMPORAL_DURING)
+    ->Arg(TEMPORAL_CONTAINS)
+    ->Arg(TEMPORAL_AS_OF);
+
+// Baseline: the overlaps query as a scan over all events.
+void BM_ScanEvents(benchmark::State& state) {
+  TemporalFixture& f = fixture();
+  std::mt19937 rng(7);
+  std::vector<TimedEvent> out;
+  for (auto _ : state) {
+    out.clear();
+    int64_t start = rng() % (kEvents * kStep);
+    int64_t end = start + kWindow;
+    for (const auto& event : f.events) {
+      if (event.start <= end && event.end >= start) out.push_back(event);
+    }
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_ScanEvents);
+
+// Re-timing moves an event within the interval index. Uses a fixture of
+// its own, so that the queries above keep their baseline.
+void BM_SetInterval(benchmark::State& state) {
+  static TemporalFixture f;
+  std::mt19937 rng(11);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Mutation> batch;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      int64_t start = rng() % (kEvents * kStep);
+      batch.push_back(
+          set_interval(rng() % kEvents, start, start + rng() % kWindow));
+    }
+    state.ResumeTiming();
+    f.hyperbase.ApplyBatch(batch);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetInterval)->Arg(1000);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
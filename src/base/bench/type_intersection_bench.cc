@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/batch_query.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+constexpr uint32_t kPeople = 200000;
+
+// Every person is a {person}, with overlapping high-fanout subtypes.
+struct TypeFixture {
+  Hyperbase hyperbase{"types", "bench"};
+
+  TypeFixture() {
+    std::vector<Mutation> batch;
+    for (const char* type : {"person", "musician", "female", "adult"}) {
+      Mutation mut;
+      mut.concept_kind = Mutation::KIND_ENTITY;
+      mut.subject = type;
+      batch.push_back(std::move(mut));
+    }
+    std::mt19937 rng(42);
+    for (uint32_t i = 0; i < kPeople; ++i) {
+      Mutation mut;
+      mut.concept_kind = Mutation::KIND_ENTITY;
+      mut.subject = "person " + std::to_string(i);
+      mut.objects.push_back("person");
+      if (rng() % 10 == 0) mut.objects.push_back("musician");
+      if (rng() % 2 == 0) mut.objects.push_back("female");
+      if (rng() % 4 != 0) mut.objects.push_back("adult");
+      batch.push_back(std::move(mut));
+    }
+    hyperbase.ApplyBatch(batch);
+  }
+};
+
+TypeFixture& fixture() {
+  static TypeFixture instance;
+  return instance;
+}
+
+void BM_CommonChildren(benchmark::State& state) {
+  TypeFixture& f = fixture();
+  std::vector<std::string> types{"person", "female", "adult", "musician"};
+  types.resize(state.range(0));
+  std::vector<std::string> out;
+  for (auto _ : state) {
+    out.clear();
+    common_children(f.hyperbase, types, out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.counters["rows"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_CommonChildren)->Arg(2)->Arg(3)->Arg(4);
+
+// Cardinality alone never visits a child.
+void BM_CommonChildCount(benchmark::State& state) {
+  TypeFixture& f = fixture();
+  ConceptPtr female, adult;
+  f.hyperbase.GetConcept("female", female);
+  f.hyperbase.GetConcept("adult", adult);
+  uint64_t count = 0;
+  for (auto _ : state) {
+    count = female->CommonChildCount(*adult);
+    benchmark::DoNotOptimize(count);
+  }
+  state.counters["rows"] = static_cast<double>(count);
+}
+BENCHMARK(BM_CommonChildCount);
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,515 @@
+#include "base/core/bulk_builder.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include "base/core/entity.h"
+#include "base/core/relation.h"
+
+namespace hyperon {
+namespace base {
+
+using common::profile_child;
+using common::ProfileNode;
+using common::ProfileTimer;
+
+namespace {
+
+// Below this many items per thread, threads cost more than they save.
+constexpr size_t kMinSlice = 4096;
+
+// Even cuts of [0, n) into at most `threads` slices.
+std::vector<size_t> even_cuts(size_t threads, size_t n) {
+  size_t slices = std::max<size_t>(1, std::min(threads, n / kMinSlice));
+  std::vector<size_t> cuts;
+  for (size_t i = 0; i <= slices; ++i) cuts.push_back(n * i / slices);
+  return cuts;
+}
+
+// Even cuts moved forward so that no two slices share a key.
+template <typename Key>
+std::vector<size_t> group_cuts(size_t threads, size_t n, Key&& key) {
+  std::vector<size_t> cuts = even_cuts(threads, n);
+  for (size_t i = 1; i + 1 < cuts.size(); ++i) {
+    size_t& cut = cuts[i];
+    cut = std::max(cut, cuts[i - 1]);
+    while (cut > 0 && cut < n && key(cut) == key(cut - 1)) ++cut;
+  }
+  return cuts;
+}
+
+// Run fn(begin, end) on every slice between cuts, one thread each.
+template <typename Fn>
+void run_slices(const std::vector<size_t>& cuts, Fn&& fn) {
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i + 1 < cuts.size(); ++i) {
+    pool.emplace_back([&fn, &cuts, i] { fn(cuts[i], cuts[i + 1]); });
+  }
+  if (cuts.size() > 1) fn(cuts[0], cuts[1]);
+  for (auto& worker : pool) worker.join();
+}
+
+// Sort slices in parallel, then merge neighbouring runs pairwise.
+template <typename T, typename Less>
+void parallel_sort(std::vector<T>& items, Less less, size_t threads) {
+  std::vector<size_t> cuts = even_cuts(threads, items.size());
+  run_slices(cuts, [&](size_t begin, size_t end) {
+    std::sort(items.begin() + begin, items.begin() + end, less);
+  });
+  while (cuts.size() > 2) {
+    std::vector<size_t> merged;
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i + 1 < cuts.size(); i += 2) {
+      merged.push_back(cuts[i]);
+      if (i + 2 >= cuts.size()) continue;
+      size_t begin = cuts[i], mid = cuts[i + 1], end = cuts[i + 2];
+      pool.emplace_back([&items, &less, begin, mid, end] {
+        std::inplace_merge(items.begin() + begin, items.begin() + mid,
+                           items.begin() + end, less);
+      });
+    }
+    merged.push_back(cuts.back());
+    for (auto& worker : pool) worker.join();
+    cuts.swap(merged);
+  }
+}
+
+using Slot = const ConceptPtr*;
+
+struct Edge {
+  Slot child;
+  Slot parent;
+
+  inline bool operator==(const Edge& other) const {
+    return child == other.child && parent == other.parent;
+  }
+};
+
+}  // namespace
+
+BulkBuilder::BulkBuilder(size_t threads)
+    : mThreads(threads ? threads
+                       : std::max(1u, std::thread::hardware_concurrency())) {}
+
+void BulkBuilder::AddConcept(const std::string& name,
+                             Mutation::CONCEPT_KIND kind,
+                             const std::string& category) {
+  uint32_t index = 0;
+  if (!category.empty()) {
+    auto inserted = mCategoryIds.emplace(
+        category, static_cast<uint32_t>(mCategories.size()));
+    if (inserted.second) mCategories.push_back(category);
+    index = inserted.first->second;
+  }
+  mConcepts.push_back({name, kind, index});
+}
+
+void BulkBuilder::AddEdge(const std::string& child,
+                          const std::string& parent) {
+  mChildren.push_back(child);
+  mParents.push_back(parent);
+}
+
+void BulkBuilder::AddSplit(const std::string& parent,
+                           const std::vector<std::string>& children) {
+  mSplitParents.push_back(parent);
+  mSplitChildren.insert(mSplitChildren.end(), children.begin(),
+                        children.end());
+  mSplitOffsets.push_back(mSplitChildren.size());
+}
+
+void BulkBuilder::AddMember(const std::string& relation,
+                            const std::string& member) {
+  mRelations.push_back(relation);
+  mMembers.push_back(member);
+}
+
+bool BulkBuilder::Add(const Mutation& mut) {
+  switch (mut.kind) {
+    case Mutation::MUT_ADD_CONCEPT:
+      AddConcept(mut.subject, mut.concept_kind, mut.category);
+      for (const auto& parent : mut.objects) AddEdge(mut.subject, parent);
+      return true;
+    case Mutation::MUT_ADD_PARENT:
+      for (const auto& parent : mut.objects) AddEdge(mut.subject, parent);
+      return true;
+    case Mutation::MUT_ADD_SPLIT:
+      AddSplit(mut.subject, mut.objects);
+      return true;
+    case Mutation::MUT_ADD_MEMBER:
+      for (const auto& member : mut.objects) AddMember(mut.subject, member);
+      return true;
+    default:
+      return false;
+  }
+}
+
+size_t BulkBuilder::Size() const {
+  return mConcepts.size() + mChildren.size() + mSplitParents.size() +
+         mRelations.size();
+}
+
+void BulkBuilder::Clear() {
+  mConcepts.clear();
+  mCategories.assign(1, "");
+  mCategoryIds.clear();
+  mChildren.clear();
+  mParents.clear();
+  mSplitParents.clear();
+  mSplitChildren.clear();
+  mSplitOffsets.assign(1, 0);
+  mRelations.clear();
+  mMembers.clear();
+}
+
+const ConceptPtr* BulkBuilder::Find(const Hyperbase& hyperbase,
+                                    const std::string& name) {
+  auto found = hyperbase.mConcepts.find(name);
+  return found == hyperbase.mConcepts.end() ? nullptr : &found->second;
+}
+
+std::vector<Mutation> BulkBuilder::ToMutations() const {
+  std::vector<Mutation> batch;
+  batch.reserve(Size());
+  for (const auto& row : mConcepts) {
+    Mutation& mut = batch.emplace_back();
+    mut.concept_kind = row.kind;
+    mut.category = mCategories[row.category];
+    mut.subject = row.name;
+  }
+  for (size_t i = 0; i < mChildren.size(); ++i) {
+    Mutation& mut = batch.emplace_back();
+    mut.kind = Mutation::MUT_ADD_PARENT;
+    mut.subject = mChildren[i];
+    mut.objects = {mParents[i]};
+  }
+  for (size_t i = 0; i < mSplitParents.size(); ++i) {
+    Mutation& mut = batch.emplace_back();
+    mut.kind = Mutation::MUT_ADD_SPLIT;
+    mut.subject = mSplitParents[i];
+    mut.objects.assign(mSplitChildren.begin() + mSplitOffsets[i],
+                       mSplitChildren.begin() + mSplitOffsets[i + 1]);
+  }
+  for (size_t i = 0; i < mRelations.size(); ++i) {
+    Mutation& mut = batch.emplace_back();
+    mut.kind = Mutation::MUT_ADD_MEMBER;
+    mut.subject = mRelations[i];
+    mut.objects = {mMembers[i]};
+  }
+  return batch;
+}
+
+BulkBuildStats BulkBuilder::Build(Hyperbase& hyperbase,
+                                  ProfileNode* profile) {
+  if (profile) {
+    *profile = ProfileNode("bulk_build", fmt::format("{} threads", mThreads));
+    profile->loops = 1;
+    profile->rows_in = Size();
+  }
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  BulkBuildStats stats;
+
+  ProfileTimer wait_timer(wait);
+  std::unique_lock<std::shared_mutex> lock(hyperbase.mMutex);
+  wait_timer.Stop();
+  if (!hyperbase.mObservers.empty()) {
+    uint64_t concepts = hyperbase.ConceptCount();
+    uint64_t edges = hyperbase.mLineageEdges;
+    uint64_t splits = hyperbase.mSplits;
+    uint64_t members = hyperbase.mRelationMembers;
+    BatchResult result = hyperbase.ApplyLocked(ToMutations(), 0);
+    stats.concepts = hyperbase.ConceptCount() - concepts;
+    stats.edges = hyperbase.mLineageEdges - edges;
+    stats.splits = hyperbase.mSplits - splits;
+    stats.members = hyperbase.mRelationMembers - members;
+    stats.failed = result.failed;
+    stats.version = result.version;
+  } else if (hyperbase.OverQuota()) {
+    stats.failed = Size();
+    stats.version = hyperbase.Version();
+  } else {
+    CreateConcepts(hyperbase, stats,
+                   profile_child(profile, "create_concepts", "", "sort"));
+    LinkLineage(hyperbase, stats,
+                profile_child(profile, "link_lineage", "", "sort"));
+    BindMembers(hyperbase, stats,
+                profile_child(profile, "bind_members", "", "sort"));
+    bool changed = stats.concepts + stats.edges + stats.splits +
+                       stats.members > 0;
+    stats.version = changed ? hyperbase.Commit() : hyperbase.Version();
+  }
+  if (profile) {
+    profile->rows_out =
+        stats.concepts + stats.edges + stats.splits + stats.members;
+  }
+  Clear();
+  return stats;
+}
+
+void BulkBuilder::CreateConcepts(Hyperbase& hyperbase, BulkBuildStats& stats,
+                                 ProfileNode* profile) {
+  ProfileTimer timer(profile);
+  size_t n = mConcepts.size();
+  std::vector<uint32_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  // The first row of a name wins, as with ApplyBatch.
+  parallel_sort(
+      order,
+      [this](uint32_t a, uint32_t b) {
+        int cmp = mConcepts[a].name.compare(mConcepts[b].name);
+        return cmp < 0 || (cmp == 0 && a < b);
+      },
+      mThreads);
+  std::vector<uint8_t> fresh(n);
+  run_slices(even_cuts(mThreads, n), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const std::string& name = mConcepts[order[i]].name;
+      fresh[i] = !name.empty() &&
+                 (i == 0 || name != mConcepts[order[i - 1]].name) &&
+                 !hyperbase.HasConcept(name);
+    }
+  });
+  std::vector<uint32_t> rows;
+  rows.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (fresh[i]) rows.push_back(order[i]);
+  }
+
+  std::vector<CategoryPtr> categories;
+  for (const auto& name : mCategories) {
+    categories.push_back(hyperbase.GetOrCreateCategory(name));
+  }
+  std::vector<ConceptPtr> created(rows.size());
+  run_slices(even_cuts(mThreads, rows.size()), [&](size_t begin,
+                                                   size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const ConceptRow& row = mConcepts[rows[i]];
+      common::MemoryAccount* memory = categories[row.category]->Memory();
+      created[i] = hyperbase.CreateConcept(row.kind, row.name, memory);
+      created[i]->BindMemory(memory);
+    }
+  });
+
+  // Index, ids and categories are single containers, filled in name order.
+  // Rows past the last free id are dropped.
+  hyperbase.mConcepts.reserve(hyperbase.mConcepts.size() + created.size());
+  std::vector<std::vector<ConceptPtr>> by_category(categories.size());
+  size_t added = 0;
+  for (size_t i = 0; i < created.size(); ++i) {
+    if (!hyperbase.AssignDenseId(*created[i])) break;
+    hyperbase.mConcepts.emplace(mConcepts[rows[i]].name, created[i]);
+    by_category[mConcepts[rows[i]].category].push_back(
+        std::move(created[i]));
+    ++added;
+  }
+  for (size_t i = 0; i < categories.size(); ++i) {
+    categories[i]->AddConcepts(by_category[i]);
+  }
+  stats.concepts = added;
+  stats.failed += n - added;
+  if (profile) {
+    profile->loops = 1;
+    profile->rows_in = n;
+    profile->rows_out = added;
+  }
+}
+
+void BulkBuilder::LinkLineage(Hyperbase& hyperbase, BulkBuildStats& stats,
+                              ProfileNode* profile) {
+  ProfileTimer timer(profile);
+  std::vector<Edge> edges(mChildren.size());
+  run_slices(even_cuts(mThreads, edges.size()), [&](size_t begin,
+                                                    size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      edges[i] = {Find(hyperbase, mChildren[i]), Find(hyperbase, mParents[i])};
+    }
+  });
+  edges.erase(std::remove_if(edges.begin(), edges.end(),
+                             [](const Edge& edge) {
+                               return !edge.child || !edge.parent;
+                             }),
+              edges.end());
+  stats.failed += mChildren.size() - edges.size();
+
+  // A split needs all of its concepts, as with ApplySplit; its children
+  // become children of the parent like any other edge.
+  std::vector<Slot> split_slots(mSplitChildren.size());
+  std::vector<std::pair<Slot, uint32_t>> splits;
+  for (size_t i = 0; i < mSplitParents.size(); ++i) {
+    Slot parent = Find(hyperbase, mSplitParents[i]);
+    bool known = parent && mSplitOffsets[i] < mSplitOffsets[i + 1];
+    for (size_t k = mSplitOffsets[i]; k < mSplitOffsets[i + 1]; ++k) {
+      split_slots[k] = Find(hyperbase, mSplitChildren[k]);
+      known &= split_slots[k] != nullptr;
+    }
+    if (!known) {
+      ++stats.failed;
+      continue;
+    }
+    splits.emplace_back(parent, static_cast<uint32_t>(i));
+    for (size_t k = mSplitOffsets[i]; k < mSplitOffsets[i + 1]; ++k) {
+      edges.push_back({split_slots[k], parent});
+    }
+  }
+
+  // Children side, one parent per thread at a time.
+  std::less<Slot> before;
+  parallel_sort(
+      edges,
+      [&before](const Edge& a, const Edge& b) {
+        if (a.parent != b.parent) return before(a.parent, b.parent);
+        return before(a.child, b.child);
+      },
+      mThreads);
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  std::atomic<uint64_t> added{0};
+  run_slices(group_cuts(mThreads, edges.size(),
+                        [&edges](size_t i) { return edges[i].parent; }),
+             [&](size_t begin, size_t end) {
+               uint64_t local = 0;
+               for (size_t i = begin; i < end;) {
+                 size_t last = i;
+                 while (last < end && edges[last].parent == edges[i].parent) {
+                   ++last;
+                 }
+                 const ConceptPtr& parent = *edges[i].parent;
+                 parent->ReserveLineage(0, last - i);
+                 for (; i < last; ++i) {
+                   local += parent->AddChild(*edges[i].child);
+                 }
+               }
+               added += local;
+             });
+
+  // Parent side, one child per thread at a time.
+  parallel_sort(
+      edges,
+      [&before](const Edge& a, const Edge& b) {
+        if (a.child != b.child) return before(a.child, b.child);
+        return before(a.parent, b.parent);
+      },
+      mThreads);
+  run_slices(group_cuts(mThreads, edges.size(),
+                        [&edges](size_t i) { return edges[i].child; }),
+             [&](size_t begin, size_t end) {
+               for (size_t i = begin; i < end;) {
+                 size_t last = i;
+                 while (last < end && edges[last].child == edges[i].child) {
+                   ++last;
+                 }
+                 const ConceptPtr& child = *edges[i].child;
+                 child->ReserveLineage(last - i, 0);
+                 for (; i < last; ++i) child->AddParent(*edges[i].parent);
+               }
+             });
+  stats.edges = added;
+  hyperbase.mLineageEdges += stats.edges;
+
+  // Splits of one parent stay on one thread.
+  std::sort(splits.begin(), splits.end(),
+            [&before](const std::pair<Slot, uint32_t>& a,
+                      const std::pair<Slot, uint32_t>& b) {
+              if (a.first != b.first) return before(a.first, b.first);
+              return a.second < b.second;
+            });
+  std::atomic<uint64_t> grouped{0};
+  run_slices(group_cuts(mThreads, splits.size(),
+                        [&splits](size_t i) { return splits[i].first; }),
+             [&](size_t begin, size_t end) {
+               uint64_t local = 0;
+               for (size_t i = begin; i < end; ++i) {
+                 uint32_t split = splits[i].second;
+                 std::list<ElementPtr> children;
+                 for (size_t k = mSplitOffsets[split];
+                      k < mSplitOffsets[split + 1]; ++k) {
+                   children.push_back(*split_slots[k]);
+                 }
+                 const ConceptPtr& parent = *splits[i].first;
+                 local += !parent->HasSplitChildren(children);
+                 parent->AddChildrenSplit(children);
+               }
+               grouped += local;
+             });
+  stats.splits = grouped;
+  hyperbase.mSplits += stats.splits;
+  if (profile) {
+    profile->loops = 1;
+    profile->rows_in = mChildren.size() + mSplitParents.size();
+    profile->rows_out = stats.edges + stats.splits;
+  }
+}
+
+void BulkBuilder::BindMembers(Hyperbase& hyperbase, BulkBuildStats& stats,
+                              ProfileNode* profile) {
+  ProfileTimer timer(profile);
+  std::vector<Edge> pairs(mRelations.size());
+  run_slices(even_cuts(mThreads, pairs.size()), [&](size_t begin,
+                                                    size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      Slot relation = Find(hyperbase, mRelations[i]);
+      Slot member = Find(hyperbase, mMembers[i]);
+      if (relation && !(*relation)->IsRelation()) relation = nullptr;
+      if (member && !(*member)->IsEntity() && !(*member)->IsRelation()) {
+        member = nullptr;
+      }
+      // The relation plays the parent, the member the child.
+      pairs[i] = {member, relation};
+    }
+  });
+  pairs.erase(std::remove_if(pairs.begin(), pairs.end(),
+                             [](const Edge& pair) {
+                               return !pair.child || !pair.parent;
+                             }),
+              pairs.end());
+  stats.failed += mRelations.size() - pairs.size();
+
+  // Members also bind back to their relations, so relations sharing a
+  // member cannot be filled concurrently; this pass is sequential.
+  std::less<Slot> before;
+  parallel_sort(
+      pairs,
+      [&before](const Edge& a, const Edge& b) {
+        if (a.parent != b.parent) return before(a.parent, b.parent);
+        return before(a.child, b.child);
+      },
+      mThreads);
+  for (size_t i = 0; i < pairs.size();) {
+    Slot slot = pairs[i].parent;
+    auto relation = std::static_pointer_cast<Relation>(*slot);
+    int64_t count = 0;
+    for (; i < pairs.size() && pairs[i].parent == slot; ++i) {
+      const ConceptPtr& member = *pairs[i].child;
+      bool done =
+          member->IsEntity()
+              ? relation->AddEntity(std::static_pointer_cast<Entity>(member))
+              : relation->AddRelation(
+                    std::static_pointer_cast<Relation>(member));
+      if (!done) continue;
+      ++count;
+      hyperbase.mDistinctMembers.Add(
+          std::hash<std::string>{}(member->SemName()));
+    }
+    if (count == 0) continue;
+    hyperbase.mMemberFanout.Add(
+        std::hash<std::string>{}(relation->SemName()), count);
+    stats.members += count;
+  }
+  hyperbase.mRelationMembers += stats.members;
+  if (profile) {
+    profile->loops = 1;
+    profile->rows_in = mRelations.size();
+    profile->rows_out = stats.members;
+  }
+}
+
+}  // namespace base
+}  // namespace hyperon
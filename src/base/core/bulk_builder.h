@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/core/mutation.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Counters of a bulk build. Rows naming unknown concepts, concepts
+ * defined twice and members of the wrong kind are counted as failed.
+ */
+struct BulkBuildStats {
+  uint64_t concepts{0};
+  uint64_t edges{0};
+  uint64_t splits{0};
+  uint64_t members{0};
+  uint64_t failed{0};
+  // Hyperbase version after the build became visible.
+  uint64_t version{0};
+};
+
+/**
+ * @brief Builds the concepts, lineage and relation members of a hyperbase
+ * from columns in one pass, for full rebuilds and imports.
+ *
+ * Rows are collected by column: concepts, is-a edges, splits and members.
+ * Build() then sorts and deduplicates the columns on all cores, creates
+ * the concepts in parallel, inserts them into the concept index and into
+ * their categories in name order, and fills the lineage and the members
+ * concept by concept with every container sized once. It takes the
+ * exclusive lock once and commits one version.
+ *
+ * Unlike ApplyBatch, the order of the rows does not matter: an edge may
+ * name a concept added after it. Edges to unknown concepts are dropped,
+ * the concepts themselves are still created. Hyperbases with commit
+ * observers are built through ApplyBatch, so that observers still see
+ * every mutation.
+ */
+class BulkBuilder {
+public:
+  // Use all cores if 0.
+  explicit BulkBuilder(size_t threads = 0);
+
+  // Create `name` of `kind` in `category`, the root category if empty.
+  void AddConcept(const std::string& name,
+                  Mutation::CONCEPT_KIND kind = Mutation::KIND_CONCEPT,
+                  const std::string& category = "");
+  void AddEdge(const std::string& child, const std::string& parent);
+  void AddSplit(const std::string& parent,
+                const std::vector<std::string>& children);
+  void AddMember(const std::string& relation, const std::string& member);
+
+  /**
+   * @brief Add the rows of an additive mutation, i.e. one adding concepts,
+   * parents, splits or members.
+   * @return false for other kinds, which are left to ApplyBatch.
+   */
+  bool Add(const Mutation& mut);
+
+  // Rows added since the last build.
+  size_t Size() const;
+  void Clear();
+
+  /**
+   * @brief Apply all rows to `hyperbase` and clear them.
+   *
+   * @param profile Filled with the execution profile if set
+   */
+  BulkBuildStats Build(Hyperbase& hyperbase,
+                       common::ProfileNode* profile = nullptr);
+
+private:
+  struct ConceptRow {
+    std::string name;
+    Mutation::CONCEPT_KIND kind;
+    uint32_t category;
+  };
+
+  // Slot of a concept in the concept index, nullptr if unknown.
+  static const ConceptPtr* Find(const Hyperbase& hyperbase,
+                                const std::string& name);
+
+  void CreateConcepts(Hyperbase& hyperbase, BulkBuildStats& stats,
+                      common::ProfileNode* profile);
+  void LinkLineage(Hyperbase& hyperbase, BulkBuildStats& stats,
+                   common::ProfileNode* profile);
+  void BindMembers(Hyperbase& hyperbase, BulkBuildStats& stats,
+                   common::ProfileNode* profile);
+
+  // Rows as mutations, for hyperbases with observers.
+  std::vector<Mutation> ToMutations() const;
+
+  size_t mThreads;
+  std::vector<ConceptRow> mConcepts;
+  // Category names by index, the root category first.
+  std::vector<std::string> mCategories{""};
+  std::unordered_map<std::string, uint32_t> mCategoryIds;
+  // Is-a edges.
+  std::vector<std::string> mChildren;
+  std::vector<std::string> mParents;
+  // Split i groups mSplitChildren[mSplitOffsets[i], mSplitOffsets[i + 1]).
+  std::vector<std::string> mSplitParents;
+  std::vector<std::string> mSplitChildren;
+  std::vector<size_t> mSplitOffsets{0};
+  std::vector<std::string> mRelations;
+  std::vector<std::string> mMembers;
+};
+
+}  // namespace base
+}  // namespace hyperon
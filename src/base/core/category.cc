@@ -1,9 +1,62 @@
 #include "base/core/category.h"
 
+#include "base/core/context.h"
+#include "base/core/entity.h"
+#include "base/core/event.h"
+#include "base/core/relation.h"
+#include "base/core/role.h"
+
 namespace hyperon {
 
 namespace base {
 
+void CategoryStatistics::Add(const CategoryStatistics& other) {
+  categories += other.categories;
+  concepts += other.concepts;
+  entities += other.entities;
+  relations += other.relations;
+  roles += other.roles;
+  contexts += other.contexts;
+}
+
+void CategoryStatistics::Subtract(const CategoryStatistics& other) {
+  categories -= other.categories;
+  concepts -= other.concepts;
+  entities -= other.entities;
+  relations -= other.relations;
+  roles -= other.roles;
+  contexts -= other.contexts;
+}
+
+CategoryStatistics CategoryStatistics::Of(const Concept& cnpt) {
+  CategoryStatistics stats;
+  stats.concepts = 1;
+  stats.entities = cnpt.IsEntity() ? 1 : 0;
+  stats.relations = cnpt.IsRelation() ? 1 : 0;
+  stats.roles = cnpt.IsRole() ? 1 : 0;
+  stats.contexts = cnpt.IsContext() ? 1 : 0;
+  return stats;
+}
+
+Category::Category(const std::string& name, common::MemoryAccount* memory)
+    : mMemory(common::MemoryAccountRef::Create(memory)),
+      mSubnsMap(NameMap<CategoryPtr>::allocator_type(mMemory.get())),
+      mCnptMap(NameMap<ConceptPtr>::allocator_type(mMemory.get())),
+      mNonCnptMap(NameMap<ElementPtr>::allocator_type(mMemory.get())),
+      mName(name) {}
+
+void Category::RollUp(const CategoryStatistics& delta, bool add) {
+  for (Category* cur = this; cur != nullptr;) {
+    if (add) {
+      cur->mTotalStats.Add(delta);
+    } else {
+      cur->mTotalStats.Subtract(delta);
+    }
+    CategoryPtr superior = cur->Superior();
+    cur = superior.get();
+  }
+}
+
 void Category::GetEnclosedCategory(const std::string& ns,
                                    CategoryPtr& result) const {
   auto cf = mSubnsMap.find(ns);
@@ -14,6 +67,31 @@ void Category::GetEnclosedCategory(const std::string& ns,
   }
 };
 
+bool Category::AddEnclosedCategory(const CategoryPtr& category) {
+  if (!category || !category->mSuperior.expired()) return false;
+  if (!mSubnsMap.insert({category->Name(), category}).second) return false;
+  category->mSuperior = shared_from_this();
+
+  CategoryStatistics delta = category->mTotalStats;
+  delta.categories += 1;
+  mLocalStats.categories += 1;
+  RollUp(delta, true);
+  return true;
+}
+
+void Category::ForEachEnclosedCategory(
+    const std::function<void(const CategoryPtr&)>& fn) const {
+  for (const auto& kv : mSubnsMap) fn(kv.second);
+}
+
+void Category::ForEachConceptAfter(
+    const std::string& after,
+    const std::function<bool(const ConceptPtr&)>& fn) const {
+  for (auto it = mCnptMap.upper_bound(after); it != mCnptMap.end(); ++it) {
+    if (!fn(it->second)) return;
+  }
+}
+
 void Category::GetElement(const std::string& uuid, ElementPtr& result) const {
   auto cf = mCnptMap.find(uuid);
   if (cf != mCnptMap.end()) {
@@ -25,16 +103,56 @@ void Category::GetElement(const std::string& uuid, ElementPtr& result) const {
   }
 };
 
+bool Category::AddConcept(const ConceptPtr& cnpt) {
+  if (!cnpt) return false;
+  if (!mCnptMap.insert({cnpt->SemName(), cnpt}).second) return false;
+  cnpt->mCategory = shared_from_this();
+  cnpt->BindMemory(mMemory.get());
+
+  CategoryStatistics delta = CategoryStatistics::Of(*cnpt);
+  mLocalStats.Add(delta);
+  RollUp(delta, true);
+  return true;
+}
+
+size_t Category::AddConcepts(const std::vector<ConceptPtr>& sorted) {
+  CategoryStatistics delta;
+  CategoryPtr self = shared_from_this();
+  auto hint = mCnptMap.end();
+  for (const auto& cnpt : sorted) {
+    size_t before = mCnptMap.size();
+    auto at = mCnptMap.emplace_hint(hint, cnpt->SemName(), cnpt);
+    hint = std::next(at);
+    if (mCnptMap.size() == before) continue;
+    cnpt->mCategory = self;
+    cnpt->BindMemory(mMemory.get());
+    delta.Add(CategoryStatistics::Of(*cnpt));
+  }
+  mLocalStats.Add(delta);
+  RollUp(delta, true);
+  return delta.concepts;
+}
+
+bool Category::RemoveConcept(const std::string& iname) {
+  auto found = mCnptMap.find(iname);
+  if (found == mCnptMap.end()) return false;
+  found->second->mCategory.reset();
+
+  CategoryStatistics delta = CategoryStatistics::Of(*found->second);
+  mLocalStats.Subtract(delta);
+  RollUp(delta, false);
+  mCnptMap.erase(found);
+  return true;
+}
+
 template <typename T>
 typename std::enable_if_t<std::is_base_of<Concept, T>::value, uint64_t>
 Category::ConceptCount() const {
-  if constexpr (std::is_same<T, class Concept>::value) return mConceptEleNum;
-  if constexpr (std::is_same<T, class Entity>::value) return mEntityNum;
-  if constexpr (std::is_same<T, class Relation>::value) return mRelationNum;
-  if constexpr (std::is_same<T, class Indv>::value) return mIndvNum;
-  if constexpr (std::is_same<T, class Link>::value) return mLinkNum;
-  if constexpr (std::is_same<T, class Role>::value) return mRoleNum;
-  if constexpr (std::is_same<T, class Context>::value) return mContextNum;
+  if constexpr (std::is_same<T, Concept>::value) return mLocalStats.concepts;
+  if constexpr (std::is_same<T, Entity>::value) return mLocalStats.entities;
+  if constexpr (std::is_same<T, Relation>::value) return mLocalStats.relations;
+  if constexpr (std::is_same<T, Role>::value) return mLocalStats.roles;
+  if constexpr (std::is_same<T, Context>::value) return mLocalStats.contexts;
   return 0;
 }
 
@@ -58,5 +176,20 @@ Category::HasConcept(const std::string& iname) const {
   return GetConcept<T>(iname, csp);
 }
 
-}  // namespace core
+#define HYPERON_INSTANTIATE_CATEGORY_CONCEPT(T)                          \
+  template uint64_t Category::ConceptCount<T>() const;                   \
+  template bool Category::GetConcept<T>(const std::string&,              \
+                                        std::shared_ptr<T>&) const;      \
+  template bool Category::HasConcept<T>(const std::string&) const;
+
+HYPERON_INSTANTIATE_CATEGORY_CONCEPT(Concept)
+HYPERON_INSTANTIATE_CATEGORY_CONCEPT(Entity)
+HYPERON_INSTANTIATE_CATEGORY_CONCEPT(Relation)
+HYPERON_INSTANTIATE_CATEGORY_CONCEPT(Role)
+HYPERON_INSTANTIATE_CATEGORY_CONCEPT(Context)
+HYPERON_INSTANTIATE_CATEGORY_CONCEPT(Event)
+
+#undef HYPERON_INSTANTIATE_CATEGORY_CONCEPT
+
+}  // namespace base
 }  // namespace hyperon
\ No newline at end of file
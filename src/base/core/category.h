@@ -1,12 +1,15 @@
 #pragma once
 
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/core/concept.h"
 #include "common/memory/esft.h"
+#include "common/memory/tracking_allocator.h"
 
 namespace hyperon {
 namespace base {
@@ -14,6 +17,25 @@ namespace base {
 class Category;
 using CategoryPtr = std::shared_ptr<Category>;
 
+/**
+ * @brief Exact counts of a category by concept type, maintained on every
+ * insertion and removal. Events are counted as relations.
+ */
+struct CategoryStatistics {
+  uint64_t categories{0};
+  uint64_t concepts{0};
+  uint64_t entities{0};
+  uint64_t relations{0};
+  uint64_t roles{0};
+  uint64_t contexts{0};
+
+  void Add(const CategoryStatistics& other);
+  void Subtract(const CategoryStatistics& other);
+
+  // Counts contributed by a single concept.
+  static CategoryStatistics Of(const Concept& cnpt);
+};
+
 /**
  * @brief A category is a logical closure that includes a bunch of related
  * concepts. Each concept has its own category, as a one-to-one projection.
@@ -25,7 +47,28 @@ using CategoryPtr = std::shared_ptr<Category>;
  */
 class Category : public common::inheritable_esft<Category> {
 public:
-  explicit Category(const std::string& name) : mName(name){};
+  /**
+   * @param name Category name
+   * @param memory Account the memory of this category rolls up into, e.g.
+   * that of its hyperbase, or nullptr
+   */
+  explicit Category(const std::string& name,
+                    common::MemoryAccount* memory = nullptr);
+
+  inline std::string Name() const { return mName; }
+
+  /**
+   * @brief Bytes held by this category (non-recursively) and its concepts,
+   * by kind of structure.
+   */
+  inline common::MemoryAccount* Memory() const { return mMemory.get(); }
+
+  /**
+   * @brief Get the superior (enclosing) category.
+   *
+   * @return CategoryPtr The superior category or nullptr for a root category.
+   */
+  inline CategoryPtr Superior() const { return mSuperior.lock(); }
 
   /**
    * @brief Get the number of enclosed/nested categories. (non-recursively)
@@ -52,6 +95,31 @@ public:
    */
   void GetEnclosedCategory(const std::string& ns, CategoryPtr& result) const;
 
+  /**
+   * @brief Enclose a category as a nested sub-category.
+   *
+   * @param category Category to enclose, which must not have a superior yet.
+   * @return true if enclosed successfully.
+   * @return false if a category of the same name is already enclosed.
+   */
+  bool AddEnclosedCategory(const CategoryPtr& category);
+
+  /**
+   * @brief Visit every enclosed category (non-recursively), ordered by name.
+   * @param fn Visitor
+   */
+  void ForEachEnclosedCategory(
+      const std::function<void(const CategoryPtr&)>& fn) const;
+
+  /**
+   * @brief Visit the concepts of this category (non-recursively) named
+   * after `after` in name order, all of them if empty, until `fn` returns
+   * false.
+   */
+  void ForEachConceptAfter(
+      const std::string& after,
+      const std::function<bool(const ConceptPtr&)>& fn) const;
+
   /**
    * @brief The number of contained elements in the category, without enclosed
    * categories. The elements includ both concept and non-concept types.
@@ -59,7 +127,7 @@ public:
    * @return uint64_t
    */
   inline uint64_t ElementCount() const {
-    return mNonConceptEleNum + mConceptEleNum;
+    return mNonCnptMap.size() + mLocalStats.concepts;
   }
 
   /**
@@ -82,6 +150,35 @@ public:
   void GetElement(const std::string& uuid,
                   std::shared_ptr<Element>& result) const;
 
+  /**
+   * @brief Add a concept to the category (non-recursively). The concept is
+   * bound to this category as its owner, and its memory is charged to the
+   * category from now on.
+   *
+   * @param cnpt Concept pointer
+   * @return true if the concept is added.
+   * @return false if a concept of the same name is already contained.
+   */
+  bool AddConcept(const ConceptPtr& cnpt);
+
+  /**
+   * @brief Add many concepts sorted by name, as AddConcept() would but with
+   * hinted inserts and a single statistics roll-up.
+   *
+   * @param sorted Concepts in ascending name order
+   * @return size_t Number of concepts added
+   */
+  size_t AddConcepts(const std::vector<ConceptPtr>& sorted);
+
+  /**
+   * @brief Remove a concept from the category (non-recursively).
+   *
+   * @param iname Inner name of concept
+   * @return true if the concept is removed.
+   * @return false if the concept is absent.
+   */
+  bool RemoveConcept(const std::string& iname);
+
   /**
    * @brief The number of Concept elements. We use template to control the
    * number of APIs in case that new concepts would be added in the future.
@@ -94,6 +191,21 @@ public:
   typename std::enable_if_t<std::is_base_of<Concept, T>::value, uint64_t>
   ConceptCount() const;
 
+  /**
+   * @brief Concept counts by type of this category alone.
+   */
+  inline const CategoryStatistics& LocalStatistics() const {
+    return mLocalStats;
+  }
+
+  /**
+   * @brief Concept counts by type rolled up over all enclosed categories,
+   * including this one. Kept up to date incrementally, never by a scan.
+   */
+  inline const CategoryStatistics& TotalStatistics() const {
+    return mTotalStats;
+  }
+
   /**
    * @brief Get the concept object
    *
@@ -118,26 +230,30 @@ public:
   HasConcept(const std::string& iname) const;
 
 protected:
-  // Parent category, default nullptr
-  CategoryPtr mSuperior;
+  template <typename T>
+  using NameMap = common::TrackedMap<std::string, T, common::MEM_CATEGORY_MAPS>;
+
+  // Declared first, the maps below charge it.
+  common::MemoryAccountRef mMemory;
+
+  // Parent category, default empty. Weak since the parent owns its enclosed
+  // categories.
+  std::weak_ptr<Category> mSuperior;
   // All enclosed categories, as map<ns_name, ptr>
-  std::map<std::string, CategoryPtr> mSubnsMap;
+  NameMap<CategoryPtr> mSubnsMap;
 
   // Currently the concept set is equivelent with element set.
   // mNonCnptMap reserved for future use.
-  std::map<std::string, ConceptPtr> mCnptMap;
-  std::map<std::string, std::shared_ptr<Element>> mNonCnptMap;
+  NameMap<ConceptPtr> mCnptMap;
+  NameMap<std::shared_ptr<Element>> mNonCnptMap;
 
 private:
+  // Apply a change of counts to the totals of this and all superiors.
+  void RollUp(const CategoryStatistics& delta, bool add);
+
   std::string mName;
-  uint64_t mNonConceptEleNum;
-  uint64_t mConceptEleNum;
-  uint64_t mEntityNum;
-  uint64_t mRelationNum;
-  uint64_t mIndvNum;
-  uint64_t mLinkNum;
-  uint64_t mRoleNum;
-  uint64_t mContextNum;
+  CategoryStatistics mLocalStats;
+  CategoryStatistics mTotalStats;
 };
 
 }  // namespace base
@@ -2,6 +2,8 @@
 
 #include <fmt/core.h>
 
+#include <functional>
+
 #include "base/core/category.h"
 #include "base/core/context.h"
 
@@ -18,6 +20,9 @@ Concept::Concept(const std::string& sname, const ConceptPtr& parent)
 Concept::Concept(const std::string& sname, const CategoryPtr& category)
     : sname(sname), mCategory(category) {}
 
+Concept::Concept(const std::string& sname, const ContextPtr& context)
+    : sname(sname), mContext(context) {}
+
 Concept::Concept(const std::string& sname, const ConceptPtr& parent,
                  const CategoryPtr& category, const ContextPtr& context)
     : sname(sname), mCategory(category), mContext(context) {
@@ -40,15 +45,18 @@ ContextPtr Concept::GetContext() const {
 
 void Concept::AddRepr(const ConceptReprPtr& repr,
                       const ConceptRepr::REPR_MODAL modal) {
-  auto repr_vec = mReprMap[modal];
-  repr_vec.push_back(repr);
+  auto found = mReprMap.find(modal);
+  if (found == mReprMap.end()) {
+    found = mReprMap.emplace(modal, ReprList(mReprMap.get_allocator())).first;
+  }
+  found->second.push_back(repr);
 }
 
 std::list<ConceptReprPtr> Concept::GetRepr(
     const ConceptRepr::REPR_MODAL modal) const {
   auto found = mReprMap.find(modal);
   if (found != mReprMap.end()) {
-    return found->second;
+    return {found->second.begin(), found->second.end()};
   }
   return std::list<ConceptReprPtr>{};
 }
@@ -62,9 +70,31 @@ uint32_t Concept::ReprCount() const {
 }
 
 uint32_t Concept::ReprCount(const ConceptRepr::REPR_MODAL modal) const {
-  return GetRepr(modal).size();
+  auto found = mReprMap.find(modal);
+  return found != mReprMap.end() ? found->second.size() : 0;
 }
 
+void Concept::BindMemory(common::MemoryAccount* account) {
+  BindLineageMemory(account);
+  if (mReprMap.get_allocator().Account() == account) return;
+  ReprMap rebound{ReprMap::allocator_type(account)};
+  for (const auto& kv : mReprMap) {
+    rebound.emplace(kv.first, ReprList(kv.second.begin(), kv.second.end(),
+                                       rebound.get_allocator()));
+  }
+  mReprMap.swap(rebound);
+}
+
+bool Concept::operator==(const Element& other) const {
+  return other.IsConcept() && SemName() == other.SemName();
+}
+
+bool Concept::operator<(const Element& other) const {
+  return SemName() < other.SemName();
+}
+
+HashVal Concept::ComputeHash() const { return std::hash<std::string>{}(sname); }
+
 std::string Concept::ToString() const { return fmt::format("\\{{}\\}", sname); }
 
 }  // namespace base
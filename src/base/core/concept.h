@@ -40,11 +40,18 @@ public:
           const CategoryPtr& category, const ContextPtr& context);
 
   /*override*/ inline std::string SemName() const { return sname; }
+  // The semantic name without a copy, e.g. for serializing results.
+  inline const std::string& SemNameRef() const { return sname; }
+  /*override*/ inline bool IsConcept() const { return true; }
 
-  inline bool IsEntity() const { return false; }
-  inline bool IsRelation() const { return false; }
-  inline bool IsRole() const { return false; }
-  inline bool IsContext() const { return false; }
+  virtual bool IsEntity() const { return false; }
+  virtual bool IsRelation() const { return false; }
+  virtual bool IsRole() const { return false; }
+  virtual bool IsContext() const { return false; }
+
+  // Concepts are identified by their semantic names.
+  /*override*/ bool operator==(const Element& other) const;
+  /*override*/ bool operator<(const Element& other) const;
 
   CategoryPtr GetCategory() const;
   ContextPtr GetContext() const;
@@ -74,10 +81,19 @@ public:
   // Concept in string is denoted by curly braces.
   virtual std::string ToString() const;
 
+  /**
+   * @brief Charge the containers of this concept to `account` from now on.
+   * Called when the concept joins a category.
+   * @param account Memory account of the category
+   */
+  virtual void BindMemory(common::MemoryAccount* account);
+
 protected:
   explicit Concept(const Concept&) {}
   explicit Concept(Concept&&) {}
 
+  /*override*/ HashVal ComputeHash() const;
+
 protected:
   // Semantic name
   std::string sname;
@@ -93,8 +109,13 @@ protected:
 private:
   // TODO: support general properties
 
+  using ReprList =
+      common::TrackedList<ConceptReprPtr, common::MEM_REPRESENTATIONS>;
+  using ReprMap = common::TrackedMap<ConceptRepr::REPR_MODAL, ReprList,
+                                     common::MEM_REPRESENTATIONS>;
+
   // stored representations
-  std::map<ConceptRepr::REPR_MODAL, std::list<ConceptReprPtr>> mReprMap;
+  ReprMap mReprMap;
 };
 
 /**
@@ -5,6 +5,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace hyperon {
 
@@ -30,6 +31,9 @@ public:
 
   virtual std::string ToString() const = 0;
 
+  // The bytes of ToString() in place, valid while the representation is.
+  virtual std::string_view View() const { return {}; }
+
 protected:
   ConceptRepr() = default;
   explicit ConceptRepr(const ConceptRepr&){};
@@ -61,7 +65,7 @@ cast_to_ConceptRepr(const std::shared_ptr<const T>& obj) {
 /**
  * @brief Natural language representation.
  */
-class ConceptReprNL : ConceptRepr {
+class ConceptReprNL : public ConceptRepr {
 public:
   enum MODAL_NATLANG_TYPE { ENGLISH, CHINESE };
 
@@ -73,7 +77,9 @@ public:
 
   inline std::string& GetRepr() { return mLangDesc; }
 
-  std::string ToString() { return mLangDesc; }
+  std::string ToString() const { return mLangDesc; }
+
+  std::string_view View() const { return mLangDesc; }
 
 protected:
   MODAL_NATLANG_TYPE mLangType;
@@ -81,14 +87,53 @@ protected:
   std::string mLangDesc;
 };
 
-class ConceptReprImage : ConceptRepr {
+class ConceptReprImage : public ConceptRepr {
 public:
   ConceptReprImage() { this->mModal = MODAL_IMAGE; }
+
+  std::string ToString() const { return ""; }
+};
+
+/**
+ * @brief Procedural attachment in Guile Scheme. The expression evaluates to
+ * a procedure which is called with the semantic name of the concept, e.g.
+ * "(lambda (self) (length (kb-ancestors (list self))))".
+ */
+class ConceptReprGuile : public ConceptRepr {
+public:
+  explicit ConceptReprGuile(const std::string& expression)
+      : mExpression(expression) {
+    this->mModal = MODAL_GUILE_E;
+  }
+
+  inline const std::string& GetExpression() const { return mExpression; }
+
+  std::string ToString() const { return mExpression; }
+
+  std::string_view View() const { return mExpression; }
+
+protected:
+  std::string mExpression;
 };
 
-class ConceptReprGuile : ConceptRepr {
+/**
+ * @brief Datalog rules in Prolog syntax, evaluated by the built-in Datalog
+ * engine, e.g. "ancestor(X, Y) :- isa(X, Y).".
+ */
+class ConceptReprProlog : public ConceptRepr {
 public:
-  ConceptReprGuile() { this->mModal = MODAL_GUILE_E; }
+  explicit ConceptReprProlog(const std::string& rules) : mRules(rules) {
+    this->mModal = MODAL_PROLOG_E;
+  }
+
+  inline const std::string& GetRules() const { return mRules; }
+
+  std::string ToString() const { return mRules; }
+
+  std::string_view View() const { return mRules; }
+
+protected:
+  std::string mRules;
 };
 
 }  // namespace base
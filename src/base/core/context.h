@@ -9,6 +9,8 @@ using ContextPtr = std::shared_ptr<Context>;
 
 class Context : public Concept {
 public:
+  using Concept::Concept;
+
   /* override */ inline bool IsContext() const { return true; }
 
 private:
@@ -0,0 +1,34 @@
+#include "base/core/dense_ids.h"
+
+#include <algorithm>
+
+namespace hyperon {
+namespace base {
+
+DenseIds::DenseIds(const allocator_type& allocator, uint32_t limit)
+    : mLimit(std::min(limit, kNone)), mSlots(allocator), mFree(allocator) {}
+
+uint32_t DenseIds::Allocate(Element* element) {
+  if (!mFree.empty()) {
+    uint32_t id = mFree.back();
+    mFree.pop_back();
+    mSlots[id] = element;
+    return id;
+  }
+  if (mSlots.size() >= mLimit) return kNone;
+  mSlots.push_back(element);
+  return static_cast<uint32_t>(mSlots.size() - 1);
+}
+
+void DenseIds::Release(uint32_t id) {
+  if (id >= mSlots.size() || mSlots[id] == nullptr) return;
+  mSlots[id] = nullptr;
+  if (id + 1 == mSlots.size()) {
+    mSlots.pop_back();
+    return;
+  }
+  mFree.push_back(id);
+}
+
+}  // namespace base
+}  // namespace hyperon
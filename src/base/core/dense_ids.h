@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common/memory/tracking_allocator.h"
+
+namespace hyperon {
+namespace base {
+
+class Element;
+
+/**
+ * @brief Numbering of the elements of one hyperbase, see
+ * Element::DenseId().
+ *
+ * Ids start from 0 and freed ones are handed out again before the range
+ * grows, so the id sets of a hyperbase stay as dense as its live elements.
+ * Ids map back to their elements, which lets a result of set operations be
+ * resolved without visiting the operands. Not synchronized.
+ */
+class DenseIds {
+public:
+  using allocator_type =
+      common::TrackingAllocator<Element*, common::MEM_CONCEPT_INDEX>;
+
+  static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * @param limit Number of ids, kNone and above are never handed out.
+   */
+  explicit DenseIds(const allocator_type& allocator = allocator_type(),
+                    uint32_t limit = kNone);
+
+  /**
+   * @brief Take an id for `element`.
+   * @return The id, kNone if all `limit` ids are taken.
+   */
+  uint32_t Allocate(Element* element);
+
+  // Free `id` for reuse, a no-op for ids not taken.
+  void Release(uint32_t id);
+
+  // Ids taken already stay valid.
+  inline void SetLimit(uint32_t limit) { mLimit = std::min(limit, kNone); }
+
+  // The element holding `id`, nullptr if none.
+  inline Element* Find(uint32_t id) const {
+    return id < mSlots.size() ? mSlots[id] : nullptr;
+  }
+
+  // Number of ids taken.
+  inline size_t Size() const { return mSlots.size() - mFree.size(); }
+
+private:
+  uint32_t mLimit;
+  std::vector<Element*, allocator_type> mSlots;
+  // Freed ids, the last one reused first.
+  std::vector<uint32_t,
+              common::TrackingAllocator<uint32_t, common::MEM_CONCEPT_INDEX>>
+      mFree;
+};
+
+}  // namespace base
+}  // namespace hyperon
@@ -1,12 +1,64 @@
 #include "base/core/element.h"
 
+#include <mutex>
+#include <stdexcept>
+
+#include "base/core/dense_ids.h"
+
 namespace hyperon {
 namespace base {
 
+namespace {
+
+// Ids of the elements outside any hyperbase.
+struct SharedIds {
+  std::mutex mutex;
+  DenseIds ids;
+};
+
+SharedIds& shared_ids() {
+  // Never destroyed, elements may outlive static destruction.
+  static SharedIds* shared = new SharedIds();
+  return *shared;
+}
+
+void release_shared(uint32_t id) {
+  SharedIds& shared = shared_ids();
+  std::lock_guard<std::mutex> lock(shared.mutex);
+  shared.ids.Release(id);
+}
+
+}  // namespace
+
+Element::~Element() {
+  if (mSharedId) release_shared(mDenseId.load(std::memory_order_relaxed));
+}
+
 HashVal Element::Hash() const {
   if (Element::INVALID_HASH != mHashedVal) return mHashedVal;
   mHashedVal = ComputeHash();
   return mHashedVal;
 }
+
+uint32_t Element::SharedDenseId() const {
+  SharedIds& shared = shared_ids();
+  std::lock_guard<std::mutex> lock(shared.mutex);
+  uint32_t id = mDenseId.load(std::memory_order_relaxed);
+  if (id != kUnnumbered) return id;
+  id = shared.ids.Allocate(const_cast<Element*>(this));
+  if (id == DenseIds::kNone) {
+    throw std::length_error("out of dense ids for detached elements");
+  }
+  mSharedId = true;
+  mDenseId.store(id, std::memory_order_release);
+  return id;
+}
+
+void Element::BindDenseId(uint32_t id) {
+  if (mSharedId) release_shared(mDenseId.load(std::memory_order_relaxed));
+  mDenseId.store(id, std::memory_order_release);
+  mSharedId = false;
+}
+
 }  // namespace core
 }  // namespace hyperon
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <limits>
 #include <memory>
 #include <string>
@@ -26,12 +27,20 @@ public:
   static const ElementType INVALID_TYPE = 0x0;
 
   Element() = default;
-  virtual ~Element() = default;
+  virtual ~Element();
 
   // Global and local identifier
   inline std::string GlobalId() const { return mIdentifier; }
   inline std::string LocalId() const { return mLocalIdentifier; }
 
+  // Dense number of the element for id sets, unique among the elements of
+  // its hyperbase. Elements outside any hyperbase share another numbering,
+  // drawn on first use.
+  inline uint32_t DenseId() const {
+    uint32_t id = mDenseId.load(std::memory_order_acquire);
+    return id != kUnnumbered ? id : SharedDenseId();
+  }
+
   // Globally unique semantic name, as the same as identifier by default.
   virtual inline std::string SemName() const { return mIdentifier; }
 
@@ -70,6 +79,22 @@ protected:
   mutable HashVal mHashedVal{Element::INVALID_HASH};
   virtual ElementType GetElementType() { return INVALID_TYPE; }
   virtual HashVal ComputeHash() const = 0;
+
+private:
+  friend class Hyperbase;
+
+  static constexpr uint32_t kUnnumbered = std::numeric_limits<uint32_t>::max();
+
+  // Draw an id of the shared numbering, once.
+  uint32_t SharedDenseId() const;
+  // Take `id` of the owning hyperbase, freeing a shared one.
+  void BindDenseId(uint32_t id);
+
+  // Unnumbered for copies too, elements are told apart by it. Elements
+  // created for a hyperbase are bound before any use and never touch the
+  // shared numbering.
+  mutable std::atomic<uint32_t> mDenseId{kUnnumbered};
+  mutable bool mSharedId{false};
 };
 
 /**
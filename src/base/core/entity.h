@@ -13,7 +13,13 @@ using RelationPtr = std::shared_ptr<Relation>;
 
 class Entity : public Concept, public SimpleRelationBoundable {
 public:
+  using Concept::Concept;
+
   /* override */ inline bool IsEntity() const { return true; }
+  /* override */ void BindMemory(common::MemoryAccount* account) {
+    Concept::BindMemory(account);
+    BindRelationsMemory(account);
+  }
 };
 
 template <typename T, typename... Args>
@@ -1,11 +1,44 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+
 #include "base/core/relation.h"
 
 namespace hyperon {
 namespace base {
 
-class Event : public Relation {};
+class Event;
+using EventPtr = std::shared_ptr<Event>;
+
+/**
+ * @brief A relation that happens over a closed time interval [start, end],
+ * in the time points of Scone's time model. Points are plain integers; the
+ * server uses milliseconds since epoch. An event still going on has an
+ * open end.
+ *
+ * Times are set through Mutation::MUT_SET_INTERVAL, so that the interval
+ * index of the hyperbase follows them.
+ */
+class Event : public Relation {
+  friend class Hyperbase;
+
+public:
+  using Relation::Relation;
+
+  static constexpr int64_t kOpenEnd = std::numeric_limits<int64_t>::max();
+  static constexpr uint32_t kUnindexed = std::numeric_limits<uint32_t>::max();
+
+  inline bool HasInterval() const { return mIndexSlot != kUnindexed; }
+  inline int64_t Start() const { return mStart; }
+  inline int64_t End() const { return mEnd; }
+
+private:
+  int64_t mStart{0};
+  int64_t mEnd{kOpenEnd};
+  // Handle in the interval index of the hyperbase.
+  uint32_t mIndexSlot{kUnindexed};
+};
 
 }  // namespace base
-}  // namespace hyperon
\ No newline at end of file
+}  // namespace hyperon
@@ -0,0 +1,466 @@
+#include "base/core/hyperbase.h"
+
+#include <algorithm>
+#include <charconv>
+#include <mutex>
+
+#include "base/core/context.h"
+#include "base/core/entity.h"
+#include "base/core/event.h"
+#include "base/core/relation.h"
+#include "base/core/role.h"
+#include "common/metrics/metrics.h"
+#include "common/utils/time.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+// A concept of type T whose object is charged to `memory`.
+template <typename T>
+ConceptPtr create_tracked(common::MemoryAccount* memory,
+                          const std::string& sname) {
+  return std::allocate_shared<T>(
+      common::TrackingAllocator<T, common::MEM_CONCEPTS>(memory), sname);
+}
+
+// A decimal time point filling the whole field.
+bool parse_time(const std::string& field, int64_t& value) {
+  const char* end = field.data() + field.size();
+  auto parsed = std::from_chars(field.data(), end, value);
+  return !field.empty() && parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+const common::Counter kLookupHits("hyperon_concept_lookups_total",
+                                  "Concept lookups by name.",
+                                  "result=\"hit\"");
+const common::Counter kLookupMisses("hyperon_concept_lookups_total",
+                                    "Concept lookups by name.",
+                                    "result=\"miss\"");
+const common::Counter kParentsAdded("hyperon_lineage_mutations_total",
+                                    "Lineage edges added or removed.",
+                                    "op=\"add_parent\"");
+const common::Counter kParentsRemoved("hyperon_lineage_mutations_total",
+                                      "Lineage edges added or removed.",
+                                      "op=\"remove_parent\"");
+const common::Counter kSplitsAdded("hyperon_lineage_mutations_total",
+                                   "Lineage edges added or removed.",
+                                   "op=\"add_split\"");
+const common::Counter kUnionsAdded("hyperon_lineage_mutations_total",
+                                   "Lineage edges added or removed.",
+                                   "op=\"add_union\"");
+const common::Counter kMutationsApplied("hyperon_mutations_total",
+                                        "Mutations by outcome.",
+                                        "result=\"applied\"");
+const common::Counter kMutationsFailed("hyperon_mutations_total",
+                                       "Mutations by outcome.",
+                                       "result=\"failed\"");
+const common::Histogram kCommitLatency(
+    "hyperon_commit_latency_seconds",
+    "Time to apply and commit a batch, including the lock wait.");
+
+}  // namespace
+
+Hyperbase::Hyperbase(const std::string& name, const std::string& owner)
+    : mName(name),
+      mOwner(owner),
+      mMemory(common::MemoryAccountRef::Create()),
+      mRoot(std::make_shared<Category>(name, mMemory.get())),
+      mConcepts(decltype(mConcepts)::allocator_type(mRoot->Memory())),
+      mDenseIds(DenseIds::allocator_type(mRoot->Memory())),
+      mEvents(EventIntervalIndex::allocator_type(mRoot->Memory())) {
+  uint64_t now = common::now_millis();
+  mCreatedTime = now;
+  mUpdatedTime = now;
+  mLastReadTime = now;
+}
+
+Hyperbase::~Hyperbase() {
+  for (auto& kv : mConcepts) kv.second->ClearLineage();
+}
+
+HyperbaseStatus Hyperbase::Status() const {
+  HyperbaseStatus status;
+  status.created_time = mCreatedTime.load(std::memory_order_relaxed);
+  status.updated_time = mUpdatedTime.load(std::memory_order_relaxed);
+  status.last_read_time = mLastReadTime.load(std::memory_order_relaxed);
+  return status;
+}
+
+HyperbaseStatistics Hyperbase::Statistics() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  HyperbaseStatistics stats;
+  stats.totals = mRoot->TotalStatistics();
+  stats.lineage_edges = mLineageEdges;
+  stats.splits = mSplits;
+  stats.relation_members = mRelationMembers;
+  stats.distinct_members = mDistinctMembers.Estimate();
+  stats.memory_usage = MemoryUsage();
+  stats.memory = MemoryBreakdown();
+  return stats;
+}
+
+std::vector<CategoryMemory> Hyperbase::MemoryBreakdown() const {
+  std::vector<CategoryMemory> breakdown;
+  auto add = [&breakdown](const CategoryPtr& category) {
+    for (uint32_t k = 0; k < common::MEM_KIND_COUNT; ++k) {
+      auto kind = static_cast<common::MEMORY_KIND>(k);
+      uint64_t bytes = category->Memory()->Bytes(kind);
+      if (bytes > 0) breakdown.push_back({category->Name(), kind, bytes});
+    }
+  };
+  add(mRoot);
+  mRoot->ForEachEnclosedCategory(add);
+  return breakdown;
+}
+
+uint64_t Hyperbase::EstimateRelationFanout(const std::string& relation) const {
+  return mMemberFanout.Estimate(std::hash<std::string>{}(relation));
+}
+
+double Hyperbase::AverageRelationFanout() const {
+  uint64_t relations = mRoot->TotalStatistics().relations;
+  return relations == 0 ? 0.0
+                        : static_cast<double>(mRelationMembers) / relations;
+}
+
+void Hyperbase::Restore(uint64_t version, const HyperbaseStatus& status) {
+  mVersion.store(version, std::memory_order_release);
+  mCreatedTime.store(status.created_time, std::memory_order_relaxed);
+  mUpdatedTime.store(status.updated_time, std::memory_order_relaxed);
+  mLastReadTime.store(status.last_read_time, std::memory_order_relaxed);
+}
+
+void Hyperbase::TouchRead() {
+  mLastReadTime.store(common::now_millis(), std::memory_order_relaxed);
+}
+
+CategoryPtr Hyperbase::GetOrCreateCategory(const std::string& name) {
+  if (name.empty()) return mRoot;
+  CategoryPtr category;
+  mRoot->GetEnclosedCategory(name, category);
+  if (!category) {
+    category = std::make_shared<Category>(name, mMemory.get());
+    mRoot->AddEnclosedCategory(category);
+  }
+  return category;
+}
+
+bool Hyperbase::GetConcept(const std::string& sname,
+                           ConceptPtr& result) const {
+  auto found = mConcepts.find(sname);
+  if (found == mConcepts.end()) {
+    kLookupMisses.Add();
+    result = nullptr;
+    return false;
+  }
+  kLookupHits.Add();
+  result = found->second;
+  return true;
+}
+
+void Hyperbase::ForEachConcept(
+    const std::function<void(const ConceptPtr&)>& fn) const {
+  for (const auto& kv : mConcepts) fn(kv.second);
+}
+
+void Hyperbase::ForEachElementIn(
+    const UnionSplitLineage::IdSet& ids,
+    const std::function<void(const Element&)>& fn) const {
+  ids.ForEach([this, &fn](uint32_t id) {
+    if (const Element* element = mDenseIds.Find(id)) fn(*element);
+    return true;
+  });
+}
+
+bool Hyperbase::Apply(const Mutation& mut) {
+  bool grows = mut.kind != Mutation::MUT_REMOVE_PARENT &&
+               mut.kind != Mutation::MUT_ERASE_MEMBER;
+  if (grows && OverQuota()) return false;
+
+  switch (mut.kind) {
+    case Mutation::MUT_ADD_CONCEPT:
+      return ApplyAddConcept(mut);
+    case Mutation::MUT_ADD_PARENT:
+    case Mutation::MUT_REMOVE_PARENT:
+      return ApplyLineage(mut);
+    case Mutation::MUT_ADD_SPLIT:
+      return ApplySplit(mut);
+    case Mutation::MUT_ADD_MEMBER:
+    case Mutation::MUT_ERASE_MEMBER:
+      return ApplyMembers(mut);
+    case Mutation::MUT_SET_INTERVAL:
+      return ApplyInterval(mut);
+    case Mutation::MUT_ADD_UNION:
+      return ApplyUnion(mut);
+  }
+  return false;
+}
+
+BatchResult Hyperbase::ApplyBatch(const std::vector<Mutation>& batch,
+                                  std::vector<uint32_t>* failed) {
+  common::ScopedLatency latency(kCommitLatency);
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  return ApplyLocked(batch, 0, failed);
+}
+
+BatchResult Hyperbase::ApplyReplicatedBatch(const std::vector<Mutation>& batch,
+                                            uint64_t version) {
+  common::ScopedLatency latency(kCommitLatency);
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (version <= Version()) {
+    // Already applied, or from a leader that went back in time.
+    BatchResult result;
+    result.failed = batch.size();
+    result.version = Version();
+    return result;
+  }
+  return ApplyLocked(batch, version);
+}
+
+BatchResult Hyperbase::ApplyLocked(const std::vector<Mutation>& batch,
+                                   uint64_t version,
+                                   std::vector<uint32_t>* failed) {
+  BatchResult result;
+  std::vector<const Mutation*> applied;
+  for (size_t i = 0; i < batch.size(); ++i) {
+    const Mutation& mut = batch[i];
+    if (Apply(mut)) {
+      ++result.applied;
+      if (!mObservers.empty()) applied.push_back(&mut);
+    } else {
+      ++result.failed;
+      if (failed) failed->push_back(static_cast<uint32_t>(i));
+    }
+  }
+  kMutationsApplied.Add(result.applied);
+  kMutationsFailed.Add(result.failed);
+  if (result.applied == 0 && version == 0) {
+    result.version = Version();
+    return result;
+  }
+
+  result.version = Commit();
+  if (version > 0) {
+    mVersion.store(version, std::memory_order_release);
+    result.version = version;
+  }
+  for (const auto& observer : mObservers) {
+    observer->OnCommit(*this, result.version, applied);
+  }
+  return result;
+}
+
+void Hyperbase::AddCommitObserver(const CommitObserverPtr& observer) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mObservers.push_back(observer);
+}
+
+void Hyperbase::RemoveCommitObserver(const CommitObserverPtr& observer) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mObservers.erase(
+      std::remove(mObservers.begin(), mObservers.end(), observer),
+      mObservers.end());
+}
+
+uint64_t Hyperbase::Commit() {
+  mUpdatedTime.store(common::now_millis(), std::memory_order_relaxed);
+  return mVersion.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+ConceptPtr Hyperbase::CreateConcept(Mutation::CONCEPT_KIND kind,
+                                    const std::string& sname,
+                                    common::MemoryAccount* memory) const {
+  switch (kind) {
+    case Mutation::KIND_ENTITY:
+      return create_tracked<Entity>(memory, sname);
+    case Mutation::KIND_RELATION:
+      return create_tracked<Relation>(memory, sname);
+    case Mutation::KIND_ROLE:
+      return create_tracked<Role>(memory, sname);
+    case Mutation::KIND_CONTEXT:
+      return create_tracked<Context>(memory, sname);
+    case Mutation::KIND_EVENT:
+      return create_tracked<Event>(memory, sname);
+    default:
+      return create_tracked<Concept>(memory, sname);
+  }
+}
+
+void Hyperbase::LimitDenseIds(uint32_t limit) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mDenseIds.SetLimit(limit);
+}
+
+bool Hyperbase::AssignDenseId(Element& element) {
+  uint32_t id = mDenseIds.Allocate(&element);
+  if (id == DenseIds::kNone) return false;
+  element.BindDenseId(id);
+  return true;
+}
+
+bool Hyperbase::ApplyAddConcept(const Mutation& mut) {
+  if (mut.subject.empty() || HasConcept(mut.subject)) return false;
+
+  std::vector<ConceptPtr> parents;
+  parents.reserve(mut.objects.size());
+  for (const auto& name : mut.objects) {
+    ConceptPtr parent;
+    if (!GetConcept(name, parent)) return false;
+    parents.push_back(parent);
+  }
+
+  CategoryPtr category = GetOrCreateCategory(mut.category);
+  ConceptPtr cnpt =
+      CreateConcept(mut.concept_kind, mut.subject, category->Memory());
+  if (!AssignDenseId(*cnpt)) return false;
+  category->AddConcept(cnpt);
+  mConcepts.emplace(mut.subject, cnpt);
+  for (const auto& parent : parents) {
+    cnpt->AddParent(parent);
+    parent->AddChild(cnpt);
+    ++mLineageEdges;
+  }
+  return true;
+}
+
+bool Hyperbase::ApplyLineage(const Mutation& mut) {
+  ConceptPtr child;
+  if (!GetConcept(mut.subject, child)) return false;
+
+  bool changed = false;
+  for (const auto& name : mut.objects) {
+    ConceptPtr parent;
+    if (!GetConcept(name, parent)) continue;
+    if (mut.kind == Mutation::MUT_ADD_PARENT) {
+      if (child->AddParent(parent)) {
+        parent->AddChild(child);
+        ++mLineageEdges;
+        kParentsAdded.Add();
+        changed = true;
+      }
+    } else if (child->RemoveParent(name)) {
+      parent->RemoveChild(mut.subject);
+      --mLineageEdges;
+      kParentsRemoved.Add();
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+bool Hyperbase::ApplySplit(const Mutation& mut) {
+  ConceptPtr parent;
+  if (!GetConcept(mut.subject, parent) || mut.objects.empty()) return false;
+
+  std::list<ElementPtr> children;
+  for (const auto& name : mut.objects) {
+    ConceptPtr child;
+    if (!GetConcept(name, child)) return false;
+    children.push_back(child);
+  }
+  bool changed = !parent->HasSplitChildren(children);
+  for (const auto& name : mut.objects) {
+    // The parent side is linked by AddChildrenSplit below.
+    if (mConcepts[name]->AddParent(parent)) {
+      ++mLineageEdges;
+      changed = true;
+    }
+  }
+  if (!changed) return false;
+  if (!parent->HasSplitChildren(children)) ++mSplits;
+  kSplitsAdded.Add();
+  parent->AddChildrenSplit(children);
+  return true;
+}
+
+bool Hyperbase::ApplyUnion(const Mutation& mut) {
+  ConceptPtr child;
+  if (!GetConcept(mut.subject, child) || mut.objects.empty()) return false;
+
+  std::list<ElementPtr> parents;
+  for (const auto& name : mut.objects) {
+    ConceptPtr parent;
+    if (!GetConcept(name, parent)) return false;
+    parents.push_back(parent);
+  }
+  bool changed = !child->HasUnionedParents(parents);
+  for (const auto& name : mut.objects) {
+    // The child side is linked by AddParentsUnion below.
+    if (mConcepts[name]->AddChild(child)) {
+      ++mLineageEdges;
+      changed = true;
+    }
+  }
+  if (!changed) return false;
+  kUnionsAdded.Add();
+  child->AddParentsUnion(parents);
+  return true;
+}
+
+bool Hyperbase::ApplyMembers(const Mutation& mut) {
+  ConceptPtr subject;
+  if (!GetConcept(mut.subject, subject) || !subject->IsRelation()) {
+    return false;
+  }
+  auto relation = std::static_pointer_cast<Relation>(subject);
+
+  uint64_t relation_hash = std::hash<std::string>{}(mut.subject);
+  bool changed = false;
+  for (const auto& name : mut.objects) {
+    bool done = false;
+    if (mut.kind == Mutation::MUT_ERASE_MEMBER) {
+      done = relation->EraseEntityOrRelation(name);
+      if (done) {
+        mMemberFanout.Add(relation_hash, -1);
+        --mRelationMembers;
+      }
+    } else {
+      ConceptPtr member;
+      if (!GetConcept(name, member)) continue;
+      if (member->IsEntity()) {
+        done = relation->AddEntity(std::static_pointer_cast<Entity>(member));
+      } else if (member->IsRelation()) {
+        done =
+            relation->AddRelation(std::static_pointer_cast<Relation>(member));
+      }
+      if (done) {
+        mMemberFanout.Add(relation_hash, 1);
+        mDistinctMembers.Add(std::hash<std::string>{}(name));
+        ++mRelationMembers;
+      }
+    }
+    changed |= done;
+  }
+  return changed;
+}
+
+bool Hyperbase::ApplyInterval(const Mutation& mut) {
+  ConceptPtr subject;
+  if (!GetConcept(mut.subject, subject) || mut.objects.empty() ||
+      mut.objects.size() > 2) {
+    return false;
+  }
+  auto event = std::dynamic_pointer_cast<Event>(subject);
+  int64_t start = 0;
+  int64_t end = Event::kOpenEnd;
+  if (!event || !parse_time(mut.objects[0], start)) return false;
+  if (mut.objects.size() == 2 && !mut.objects[1].empty() &&
+      !parse_time(mut.objects[1], end)) {
+    return false;
+  }
+  if (end < start) return false;
+
+  if (event->HasInterval()) {
+    if (event->mStart == start && event->mEnd == end) return false;
+    mEvents.Erase(event->mIndexSlot);
+  }
+  event->mStart = start;
+  event->mEnd = end;
+  event->mIndexSlot = mEvents.Insert(start, end, event);
+  return true;
+}
+
+}  // namespace base
+}  // namespace hyperon
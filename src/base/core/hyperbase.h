@@ -1,6 +1,335 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/core/category.h"
+#include "base/core/concept.h"
+#include "base/core/dense_ids.h"
+#include "base/core/event.h"
+#include "base/core/mutation.h"
+#include "common/index/interval_tree.h"
+#include "common/memory/tracking_allocator.h"
+#include "common/sketch/count_min.h"
+#include "common/sketch/hyperloglog.h"
+
 namespace hyperon {
+namespace base {
+
+class Hyperbase;
+using HyperbasePtr = std::shared_ptr<Hyperbase>;
+
+/**
+ * @brief Timestamps of a hyperbase, in milliseconds since epoch.
+ */
+struct HyperbaseStatus {
+  uint64_t created_time{0};
+  uint64_t updated_time{0};
+  uint64_t last_read_time{0};
+};
+
+/**
+ * @brief Live bytes of one kind of structure in one category, mirrors
+ * api.v1.CategoryMemory.
+ */
+struct CategoryMemory {
+  std::string category;
+  common::MEMORY_KIND kind{common::MEM_CONCEPTS};
+  uint64_t bytes{0};
+};
+
+/**
+ * @brief Statistics of a hyperbase, mirrors api.v1.HyperbaseStatistics.
+ * Counts are exact, `distinct_members` is a HyperLogLog estimate.
+ */
+struct HyperbaseStatistics {
+  CategoryStatistics totals;
+  uint64_t lineage_edges{0};
+  uint64_t splits{0};
+  uint64_t relation_members{0};
+  uint64_t distinct_members{0};
+  uint64_t memory_usage{0};
+  // Non-zero entries only, by category then kind.
+  std::vector<CategoryMemory> memory;
+};
+
+/**
+ * @brief Events with times by interval, see Hyperbase::Events().
+ */
+using EventIntervalIndex = common::IntervalTree<
+    EventPtr, common::TrackingAllocator<EventPtr, common::MEM_EVENT_INDEX>>;
+
+/**
+ * @brief Outcome of a batch of mutations applied as one group commit.
+ */
+struct BatchResult {
+  uint64_t applied{0};
+  uint64_t failed{0};
+  // Hyperbase version after the batch became visible.
+  uint64_t version{0};
+};
+
+/**
+ * @brief Receives every committed batch of a hyperbase in version order,
+ * while the exclusive lock is still held. Implementations must be quick and
+ * must not lock the hyperbase again.
+ */
+class CommitObserver {
+public:
+  virtual ~CommitObserver() = default;
+
+  /**
+   * @param hyperbase Committing hyperbase
+   * @param version Version of the commit
+   * @param applied Mutations that took effect, in application order
+   */
+  virtual void OnCommit(const Hyperbase& hyperbase, uint64_t version,
+                        const std::vector<const Mutation*>& applied) = 0;
+};
+using CommitObserverPtr = std::shared_ptr<CommitObserver>;
+
+/**
+ * @brief A hyperbase is a named, independently hosted knowledge base. It owns
+ * a root category with flatly enclosed sub-categories, and a global index of
+ * concepts by semantic name since Scone-style names are unique per KB.
+ *
+ * Readers take the shared side of Mutex(), writers the exclusive side. Every
+ * committed write bumps Version() once, no matter how many mutations it
+ * carries.
+ */
+class Hyperbase {
+  friend class BulkBuilder;
+
+public:
+  explicit Hyperbase(const std::string& name, const std::string& owner = "");
+  ~Hyperbase();
+
+  inline std::string Name() const { return mName; }
+  inline std::string Owner() const { return mOwner; }
+  inline CategoryPtr RootCategory() const { return mRoot; }
+  inline std::shared_mutex& Mutex() const { return mMutex; }
+  inline uint64_t Version() const {
+    return mVersion.load(std::memory_order_acquire);
+  }
+
+  HyperbaseStatus Status() const;
+
+  /**
+   * @brief Restore the version and timestamps of a hyperbase recovered from
+   * persistent state, so that versions keep increasing across reloads.
+   */
+  void Restore(uint64_t version, const HyperbaseStatus& status);
+
+  /**
+   * @brief Record a read access, refreshing last_read_time.
+   */
+  void TouchRead();
+
+  /**
+   * @brief Get an enclosed category of the root by name, creating it if
+   * absent. The empty name denotes the root category itself.
+   *
+   * @param name Category name
+   * @return CategoryPtr
+   */
+  CategoryPtr GetOrCreateCategory(const std::string& name);
+
+  /**
+   * @brief Find a concept by semantic name in any category.
+   *
+   * @param sname Semantic name
+   * @param result Concept pointer or nullptr
+   * @return true if found.
+   */
+  bool GetConcept(const std::string& sname, ConceptPtr& result) const;
+  inline bool HasConcept(const std::string& sname) const {
+    return mConcepts.find(sname) != mConcepts.end();
+  }
+  inline uint64_t ConceptCount() const { return mConcepts.size(); }
+
+  /**
+   * @brief Visit every concept. The caller must hold at least the shared
+   * lock.
+   * @param fn Visitor
+   */
+  void ForEachConcept(const std::function<void(const ConceptPtr&)>& fn) const;
+
+  /**
+   * @brief Visit the elements of this hyperbase numbered in `ids`, e.g. an
+   * intersection of child id sets, in time proportional to the set. The
+   * caller must hold at least the shared lock.
+   * @param fn Visitor
+   */
+  void ForEachElementIn(const UnionSplitLineage::IdSet& ids,
+                        const std::function<void(const Element&)>& fn) const;
+
+  /**
+   * @brief Bound the dense ids, and so the concepts, of this hyperbase.
+   * Concepts beyond are rejected as if out of ids. Takes the exclusive
+   * lock.
+   */
+  void LimitDenseIds(uint32_t limit);
+
+  /**
+   * @brief All events with times, indexed by interval. Maintained by
+   * Mutation::MUT_SET_INTERVAL. The caller must hold at least the shared
+   * lock.
+   */
+  inline const EventIntervalIndex& Events() const { return mEvents; }
+
+  /**
+   * @brief Snapshot of the statistics, taken under the shared lock. Nothing
+   * is scanned: all figures are maintained by the mutations.
+   */
+  HyperbaseStatistics Statistics() const;
+
+  /**
+   * @brief Estimated number of members of a relation, for query planning
+   * without touching the relation itself. Never underestimates. The caller
+   * must hold at least the shared lock.
+   *
+   * @param relation Semantic name of the relation
+   * @return uint64_t
+   */
+  uint64_t EstimateRelationFanout(const std::string& relation) const;
+
+  /**
+   * @brief Average number of members per relation, for planning joins over
+   * relations that are not bound yet. The caller must hold at least the
+   * shared lock.
+   */
+  double AverageRelationFanout() const;
+
+  /**
+   * @brief Resident footprint in bytes: everything allocated for concepts,
+   * categories, lineage, relation members and representations, as charged
+   * by their tracking allocators. Name strings longer than the small
+   * string buffer are not included.
+   */
+  inline uint64_t MemoryUsage() const { return mMemory->Total(); }
+
+  /**
+   * @brief Footprint of the whole hyperbase by kind of structure.
+   */
+  inline uint64_t MemoryUsage(common::MEMORY_KIND kind) const {
+    return mMemory->Bytes(kind);
+  }
+
+  /**
+   * @brief Footprint by category and kind of structure, non-zero entries
+   * only. The caller must hold at least the shared lock.
+   */
+  std::vector<CategoryMemory> MemoryBreakdown() const;
+
+  /**
+   * @brief Limit the footprint of this hyperbase. Growing mutations fail
+   * once the quota is exceeded, shrinking ones are still accepted.
+   *
+   * @param bytes Quota in bytes, 0 for unlimited.
+   */
+  inline void SetMemoryQuota(uint64_t bytes) { mMemoryQuota = bytes; }
+  inline uint64_t MemoryQuota() const { return mMemoryQuota; }
+  inline bool OverQuota() const {
+    return mMemoryQuota > 0 && MemoryUsage() > mMemoryQuota;
+  }
+
+  /**
+   * @brief Apply a single mutation. The caller must hold the exclusive lock
+   * and is responsible for bumping the version through Commit().
+   *
+   * @param mut Mutation to apply
+   * @return true if applied, false if it is invalid against current state.
+   */
+  bool Apply(const Mutation& mut);
+
+  /**
+   * @brief Apply a batch of mutations under a single exclusive lock, making
+   * them visible to readers at once with a single version bump. Invalid
+   * mutations are skipped and counted.
+   *
+   * @param batch Mutations in application order
+   * @param failed Appended positions of the skipped mutations, if set
+   * @return BatchResult
+   */
+  BatchResult ApplyBatch(const std::vector<Mutation>& batch,
+                         std::vector<uint32_t>* failed = nullptr);
+
+  /**
+   * @brief Apply a batch replicated from another hyperbase and adopt its
+   * version, so that versions are comparable between leader and followers.
+   *
+   * @param batch Mutations committed by the leader
+   * @param version Leader version after the batch
+   * @return BatchResult, with the whole batch failed and nothing applied if
+   * `version` is not past the current version.
+   */
+  BatchResult ApplyReplicatedBatch(const std::vector<Mutation>& batch,
+                                   uint64_t version);
+
+  /**
+   * @brief Register an observer of committed batches.
+   */
+  void AddCommitObserver(const CommitObserverPtr& observer);
+  void RemoveCommitObserver(const CommitObserverPtr& observer);
+
+protected:
+  // Publish writes made through Apply(). Caller holds the exclusive lock.
+  uint64_t Commit();
+
+  // Apply and commit a batch, at `version` if non-zero. Caller holds the
+  // exclusive lock.
+  BatchResult ApplyLocked(const std::vector<Mutation>& batch,
+                          uint64_t version,
+                          std::vector<uint32_t>* failed = nullptr);
+
+  ConceptPtr CreateConcept(Mutation::CONCEPT_KIND kind,
+                           const std::string& sname,
+                           common::MemoryAccount* memory) const;
+  // Number `element` as one of this hyperbase, false once out of ids.
+  bool AssignDenseId(Element& element);
+  bool ApplyAddConcept(const Mutation& mut);
+  bool ApplyLineage(const Mutation& mut);
+  bool ApplySplit(const Mutation& mut);
+  bool ApplyUnion(const Mutation& mut);
+  bool ApplyMembers(const Mutation& mut);
+  bool ApplyInterval(const Mutation& mut);
+
+private:
+  std::string mName;
+  std::string mOwner;
+  // Sum of all categories, declared before them.
+  common::MemoryAccountRef mMemory;
+  CategoryPtr mRoot;
+  // Charged to the root category.
+  common::TrackedHashMap<std::string, ConceptPtr, common::MEM_CONCEPT_INDEX>
+      mConcepts;
+  // Charged to the root category.
+  DenseIds mDenseIds;
+  // Charged to the root category.
+  EventIntervalIndex mEvents;
+
+  mutable std::shared_mutex mMutex;
+  std::atomic<uint64_t> mVersion{0};
+  std::atomic<uint64_t> mCreatedTime{0};
+  std::atomic<uint64_t> mUpdatedTime{0};
+  std::atomic<uint64_t> mLastReadTime{0};
+
+  std::vector<CommitObserverPtr> mObservers;
+
+  std::atomic<uint64_t> mMemoryQuota{0};
+
+  // Statistics beyond the category counts, guarded by mMutex.
+  uint64_t mLineageEdges{0};
+  uint64_t mSplits{0};
+  uint64_t mRelationMembers{0};
+  common::CountMinSketch mMemberFanout;
+  common::HyperLogLog<> mDistinctMembers;
+};
 
-class Hyperbase {};
+}  // namespace base
 }  // namespace hyperon
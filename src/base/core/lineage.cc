@@ -5,6 +5,43 @@
 namespace hyperon {
 namespace base {
 
+namespace {
+
+void rebind_groups(UnionSplitLineage::NameGroups& groups,
+                   common::MemoryAccount* account) {
+  if (groups.get_allocator().Account() == account) return;
+  UnionSplitLineage::NameGroups::allocator_type allocator(account);
+  UnionSplitLineage::NameGroups rebound(allocator);
+  for (const auto& group : groups) {
+    auto& copy = rebound.emplace_back(allocator);
+    copy.names.insert(group.names.begin(), group.names.end());
+    copy.ids = group.ids;
+  }
+  groups.swap(rebound);
+}
+
+void rebind_ids(UnionSplitLineage::IdSet& ids,
+                common::MemoryAccount* account) {
+  if (ids.get_allocator().Account() == account) return;
+  UnionSplitLineage::IdSet rebound{
+      UnionSplitLineage::IdSet::allocator_type(account)};
+  rebound = ids;
+  ids = std::move(rebound);
+}
+
+}  // namespace
+
+void UnionSplitLineage::NameGroup::Insert(const ElementPtr& member) {
+  if (names.insert(member->SemName()).second) ids.Insert(member->DenseId());
+}
+
+bool UnionSplitLineage::NameGroup::Erase(const std::string& name,
+                                         uint32_t id) {
+  if (names.erase(name) == 0) return false;
+  ids.Erase(id);
+  return true;
+}
+
 bool UnionSplitLineage::HasParent(const std::string& parent) const {
   return mParentsMap.find(parent) != mParentsMap.end();
 }
@@ -14,36 +51,43 @@ bool UnionSplitLineage::HasChild(const std::string& child) const {
 }
 
 bool UnionSplitLineage::AddParent(const ElementPtr& parent) {
-  return mParentsMap
-      .insert(std::pair<std::string, ElementPtr>(parent->SemName(), parent))
-      .second;
+  if (!mParentsMap
+           .insert(std::pair<std::string, ElementPtr>(parent->SemName(),
+                                                      parent))
+           .second) {
+    return false;
+  }
+  mParentIds.Insert(parent->DenseId());
+  return true;
 }
 
 bool UnionSplitLineage::AddChild(const ElementPtr& child) {
-  return mChildrenMap
-      .insert(std::pair<std::string, ElementPtr>(child->SemName(), child))
-      .second;
+  if (!mChildrenMap
+           .insert(std::pair<std::string, ElementPtr>(child->SemName(), child))
+           .second) {
+    return false;
+  }
+  mChildIds.Insert(child->DenseId());
+  return true;
 }
 
 bool UnionSplitLineage::RemoveParent(const std::string& parent) {
   if (parent.empty()) return false;
 
+  auto found = mParentsMap.find(parent);
+  uint32_t id = found != mParentsMap.end() ? found->second->DenseId() : 0;
   auto it = mUnions.begin();
   while (it != mUnions.end()) {
-    auto found = it->find(parent);
-    if (found != it->end()) {
-      if (it->size() == 1) {
-        it = mUnions.erase(it);
-      } else {
-        it->erase(found);
-      }
+    if (it->Erase(parent, id) && it->size() == 0) {
+      it = mUnions.erase(it);
     } else {
       ++it;
     }
   }
 
-  if (auto it = mParentsMap.find(parent); it != mParentsMap.end()) {
-    mParentsMap.erase(it);
+  if (found != mParentsMap.end()) {
+    mParentsMap.erase(found);
+    mParentIds.Erase(id);
     return true;
   }
   return false;
@@ -52,37 +96,73 @@ bool UnionSplitLineage::RemoveParent(const std::string& parent) {
 bool UnionSplitLineage::RemoveChild(const std::string& child) {
   if (child.empty()) return false;
 
+  auto found = mChildrenMap.find(child);
+  uint32_t id = found != mChildrenMap.end() ? found->second->DenseId() : 0;
   auto it = mSplits.begin();
   while (it != mSplits.end()) {
-    auto found = it->find(child);
-    if (found != it->end()) {
-      if (it->size() == 1) {
-        it = mSplits.erase(it);
-      } else {
-        it->erase(found);
-      }
+    if (it->Erase(child, id) && it->size() == 0) {
+      it = mSplits.erase(it);
     } else {
       ++it;
     }
   }
 
-  if (auto it = mChildrenMap.find(child); it != mChildrenMap.end()) {
-    mChildrenMap.erase(it);
+  if (found != mChildrenMap.end()) {
+    mChildrenMap.erase(found);
+    mChildIds.Erase(id);
     return true;
   }
   return false;
 }
 
+void UnionSplitLineage::ClearLineage() {
+  mParentsMap.clear();
+  mChildrenMap.clear();
+  mParentIds.Clear();
+  mChildIds.Clear();
+  mUnions.clear();
+  mSplits.clear();
+}
+
+void UnionSplitLineage::BindLineageMemory(common::MemoryAccount* account) {
+  common::rebind_container(mParentsMap, account);
+  common::rebind_container(mChildrenMap, account);
+  rebind_ids(mParentIds, account);
+  rebind_ids(mChildIds, account);
+  rebind_groups(mUnions, account);
+  rebind_groups(mSplits, account);
+}
+
+void UnionSplitLineage::ForEachParent(
+    const std::function<void(const ElementPtr&)>& fn) const {
+  for (const auto& kv : mParentsMap) fn(kv.second);
+}
+
+void UnionSplitLineage::ForEachChild(
+    const std::function<void(const ElementPtr&)>& fn) const {
+  for (const auto& kv : mChildrenMap) fn(kv.second);
+}
+
+void UnionSplitLineage::ReserveLineage(size_t parents, size_t children) {
+  if (parents > 0) mParentsMap.reserve(mParentsMap.size() + parents);
+  if (children > 0) mChildrenMap.reserve(mChildrenMap.size() + children);
+}
+
+uint64_t UnionSplitLineage::CommonChildCount(
+    const UnionSplitLineage& other) const {
+  return IdSet::IntersectionCount(mChildIds, other.mChildIds);
+}
+
 bool UnionSplitLineage::AddParentsUnion(const std::list<ElementPtr>& parents) {
   for_each(parents.begin(), parents.end(),
            [this](const ElementPtr& ele) { this->AddParent(ele); });
   bool found = HasUnionedParents(parents);
   if (!found) {
-    std::set<std::string> newUnion;
+    NameGroup newUnion(mUnions.get_allocator());
     for (auto it = parents.begin(); it != parents.end(); ++it) {
-      newUnion.insert((*it)->GlobalId());
+      newUnion.Insert(*it);
     }
-    mUnions.push_back(newUnion);
+    mUnions.push_back(std::move(newUnion));
     found = true;
   }
   return found;
@@ -94,11 +174,11 @@ bool UnionSplitLineage::AddChildrenSplit(
            [this](const ElementPtr& ele) { this->AddChild(ele); });
   bool found = HasSplitChildren(children);
   if (!found) {
-    std::set<std::string> newSplit;
+    NameGroup newSplit(mSplits.get_allocator());
     for (auto it = children.begin(); it != children.end(); ++it) {
-      newSplit.insert((*it)->GlobalId());
+      newSplit.Insert(*it);
     }
-    mSplits.push_back(newSplit);
+    mSplits.push_back(std::move(newSplit));
     found = true;
   }
   return found;
@@ -109,7 +189,7 @@ bool UnionSplitLineage::HasUnionedParents(
   bool found = false;
   for (auto it = mUnions.begin(); it != mUnions.end(); ++it) {
     found = all_of(parents.begin(), parents.end(), [it](const ElementPtr& ele) {
-      return it->find(ele->GlobalId()) != it->end();
+      return it->ids.Contains(ele->DenseId());
     });
     if (found) {
       break;
@@ -124,7 +204,7 @@ bool UnionSplitLineage::HasSplitChildren(
   for (auto it = mSplits.begin(); it != mSplits.end(); ++it) {
     found =
         all_of(children.begin(), children.end(), [it](const ElementPtr& ele) {
-          return it->find(ele->GlobalId()) != it->end();
+          return it->ids.Contains(ele->DenseId());
         });
     if (found) {
       break;
@@ -140,7 +220,7 @@ bool UnionSplitLineage::DismissParentsUnion(
   while (it != mUnions.end()) {
     bool all_found =
         all_of(parents.begin(), parents.end(), [it](const ElementPtr& ele) {
-          return it->find(ele->GlobalId()) != it->end();
+          return it->ids.Contains(ele->DenseId());
         });
     if (all_found) {
       it = mUnions.erase(it);
@@ -159,7 +239,7 @@ bool UnionSplitLineage::DismissChildrenSplit(
   while (it != mSplits.end()) {
     bool all_found =
         all_of(children.begin(), children.end(), [it](const ElementPtr& e) {
-          return it->find(e->GlobalId()) != it->end();
+          return it->ids.Contains(e->DenseId());
         });
     if (all_found) {
       it = mSplits.erase(it);
@@ -1,15 +1,52 @@
 #pragma once
 
+#include <functional>
+
 #include "base/core/lineagable.h"
+#include "common/index/roaring.h"
+#include "common/memory/tracking_allocator.h"
 
 namespace hyperon {
 namespace base {
 
 /**
  * @brief A kind of lineage with parent unions and children splits.
+ *
+ * Parents, children and the members of every union and split are also
+ * kept as sets of dense element ids, inline while small and as roaring
+ * bitmaps for high-fanout types, so that type intersections and overlaps
+ * between large siblings are set operations on compressed ids.
  */
 class UnionSplitLineage : public Lineagable {
 public:
+  using IdSet =
+      common::IdSet<common::TrackingAllocator<uint32_t, common::MEM_LINEAGE>>;
+  using NameSet = common::TrackedSet<std::string, common::MEM_LINEAGE>;
+
+  /**
+   * @brief Members of a union or split, by semantic name and by dense id.
+   * Iterates the names in order.
+   */
+  struct NameGroup {
+    using allocator_type = NameSet::allocator_type;
+    using const_iterator = NameSet::const_iterator;
+
+    explicit NameGroup(const allocator_type& allocator)
+        : names(allocator), ids(IdSet::allocator_type(allocator)) {}
+
+    inline const_iterator begin() const { return names.begin(); }
+    inline const_iterator end() const { return names.end(); }
+    inline size_t size() const { return names.size(); }
+
+    void Insert(const ElementPtr& member);
+    // @return false if the member was absent.
+    bool Erase(const std::string& name, uint32_t id);
+
+    NameSet names;
+    IdSet ids;
+  };
+  using NameGroups = common::TrackedList<NameGroup, common::MEM_LINEAGE>;
+
   /* override */ bool HasParent(const std::string& parent) const;
   /* override */ bool HasChild(const std::string& child) const;
   /* override */ bool AddParent(const ElementPtr& parent);
@@ -71,15 +108,66 @@ public:
    */
   bool DismissChildrenSplit(const std::list<ElementPtr>& children);
 
+  inline size_t ParentCount() const { return mParentsMap.size(); }
+  inline size_t ChildCount() const { return mChildrenMap.size(); }
+
+  // Make room for this many more parents and children.
+  void ReserveLineage(size_t parents, size_t children);
+
+  // Dense ids of the direct parents and children, see Element::DenseId().
+  inline const IdSet& ParentIds() const { return mParentIds; }
+  inline const IdSet& ChildIds() const { return mChildIds; }
+
+  /**
+   * @brief Number of direct children shared with `other`, counted on the
+   * id sets without visiting any child.
+   */
+  uint64_t CommonChildCount(const UnionSplitLineage& other) const;
+
+  /**
+   * @brief Visit every direct parent, in no particular order.
+   * @param fn Visitor
+   */
+  void ForEachParent(const std::function<void(const ElementPtr&)>& fn) const;
+
+  /**
+   * @brief Visit every direct child, in no particular order.
+   * @param fn Visitor
+   */
+  void ForEachChild(const std::function<void(const ElementPtr&)>& fn) const;
+
+  /**
+   * @brief Drop all parents, children, unions and splits. Lineage holds
+   * strong references in both directions, so owners must clear it to break
+   * the cycles before releasing a graph.
+   */
+  void ClearLineage();
+
+  // Parent unions and children splits as groups of semantic names.
+  inline const NameGroups& Unions() const { return mUnions; }
+  inline const NameGroups& Splits() const { return mSplits; }
+
+protected:
+  /**
+   * @brief Charge the lineage to `account` from now on.
+   */
+  void BindLineageMemory(common::MemoryAccount* account);
+
 private:
+  using ElementIndex =
+      common::TrackedHashMap<std::string, ElementPtr, common::MEM_LINEAGE>;
+
   // All parents map for fast indexing
-  std::unordered_map<std::string, ElementPtr> mParentsMap;
+  ElementIndex mParentsMap;
   // All children map for fast indexing
-  std::unordered_map<std::string, ElementPtr> mChildrenMap;
+  ElementIndex mChildrenMap;
+  // The same parents and children by dense id, for set operations
+  IdSet mParentIds;
+  IdSet mChildIds;
   // Parents group representing composites of a concept
-  std::list<std::set<std::string>> mUnions;
+  NameGroups mUnions;
   // Children group representing mutually exclusive relation
-  std::list<std::set<std::string>> mSplits;
+  NameGroups mSplits;
 };
 }  // namespace base
 }  // namespace hyperon
\ No newline at end of file
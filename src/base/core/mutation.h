@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief A single write against a hyperbase in a flat, wire-friendly form.
+ * Mutations are the unit of bulk ingestion: they are decoded from the client
+ * stream, grouped into batches and applied by Hyperbase::ApplyBatch.
+ */
+struct Mutation {
+  enum MUTATION_KIND {
+    MUT_ADD_CONCEPT,    // subject: new concept, objects: its parents
+    MUT_ADD_PARENT,     // subject: child, objects: parents
+    MUT_REMOVE_PARENT,  // subject: child, objects: parents
+    MUT_ADD_SPLIT,      // subject: parent, objects: disjoint children
+    MUT_ADD_MEMBER,     // subject: relation, objects: entities or relations
+    MUT_ERASE_MEMBER,   // subject: relation, objects: entities or relations
+    MUT_SET_INTERVAL,   // subject: event, objects: start [, end] in decimal
+    MUT_ADD_UNION,      // subject: child, objects: parents forming a union
+  };
+
+  /**
+   * Concrete Concept subclass to create for MUT_ADD_CONCEPT.
+   */
+  enum CONCEPT_KIND {
+    KIND_CONCEPT,
+    KIND_ENTITY,
+    KIND_RELATION,
+    KIND_ROLE,
+    KIND_CONTEXT,
+    KIND_EVENT,
+  };
+
+  MUTATION_KIND kind{MUT_ADD_CONCEPT};
+  CONCEPT_KIND concept_kind{KIND_CONCEPT};
+  // Owning category for MUT_ADD_CONCEPT, the root category if empty.
+  std::string category;
+  std::string subject;
+  std::vector<std::string> objects;
+};
+
+}  // namespace base
+}  // namespace hyperon
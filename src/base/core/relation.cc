@@ -2,10 +2,22 @@
 
 #include "base/core/concept.h"
 #include "base/core/entity.h"
+#include "common/metrics/metrics.h"
 
 namespace hyperon {
 namespace base {
 
+namespace {
+
+const common::Counter kBinds("hyperon_relation_binds_total",
+                             "Members bound into or unbound from relations.",
+                             "op=\"bind\"");
+const common::Counter kUnbinds("hyperon_relation_binds_total",
+                               "Members bound into or unbound from relations.",
+                               "op=\"unbind\"");
+
+}  // namespace
+
 bool Relation::HasEntity(const std::string& sname) const {
   auto it = mContainedConcepts.find(sname);
   if (it != mContainedConcepts.end() && it->second->IsEntity()) {
@@ -27,18 +39,21 @@ bool Relation::HasEntityOrRelation(const std::string& sname) const {
 }
 
 bool Relation::AddEntity(const EntityPtr& entity) {
-  if (mContainedConcepts.find(sname) == mContainedConcepts.end()) {
+  if (mContainedConcepts.find(entity->SemName()) == mContainedConcepts.end()) {
     mContainedConcepts[entity->SemName()] = entity;
     entity->BindRelation(shared_from_base<Relation>());
+    kBinds.Add();
     return true;
   }
   return false;
 }
 
 bool Relation::AddRelation(const RelationPtr& relation) {
-  if (mContainedConcepts.find(sname) == mContainedConcepts.end()) {
+  if (mContainedConcepts.find(relation->SemName()) ==
+      mContainedConcepts.end()) {
     mContainedConcepts[relation->SemName()] = relation;
     relation->BindRelation(shared_from_base<Relation>());
+    kBinds.Add();
     return true;
   }
   return false;
@@ -73,11 +88,23 @@ bool Relation::EraseEntityOrRelation(const std::string& sname) {
       return false;
     }
     mContainedConcepts.erase(it);
+    kUnbinds.Add();
     return true;
   }
   return false;
 }
 
+void Relation::ForEachMember(
+    const std::function<void(const ConceptPtr&)>& fn) const {
+  for (const auto& kv : mContainedConcepts) fn(kv.second);
+}
+
+void Relation::BindMemory(common::MemoryAccount* account) {
+  Concept::BindMemory(account);
+  BindRelationsMemory(account);
+  common::rebind_container(mContainedConcepts, account);
+}
+
 ConceptPtr Relation::operator[](const std::string& sname) {
   if (mContainedConcepts.find(sname) != mContainedConcepts.end()) {
     return mContainedConcepts[sname];
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include "base/core/concept.h"
 #include "base/core/relation_boundable.h"
 
@@ -17,7 +19,10 @@ using RelationPtr = std::shared_ptr<Relation>;
  */
 class Relation : public Concept, public SimpleRelationBoundable {
 public:
+  using Concept::Concept;
+
   /* override */ inline bool IsRelation() const { return true; }
+  /* override */ void BindMemory(common::MemoryAccount* account);
 
   virtual bool HasEntity(const std::string& sname) const;
   virtual bool HasRelation(const std::string& sname) const;
@@ -30,8 +35,17 @@ public:
 
   ConceptPtr operator[](const std::string& sname);
 
+  inline size_t MemberCount() const { return mContainedConcepts.size(); }
+
+  /**
+   * @brief Visit every contained entity or relation, ordered by name.
+   * @param fn Visitor
+   */
+  void ForEachMember(const std::function<void(const ConceptPtr&)>& fn) const;
+
 protected:
-  std::map<std::string, ConceptPtr> mContainedConcepts;
+  common::TrackedMap<std::string, ConceptPtr, common::MEM_MEMBERS>
+      mContainedConcepts;
 };
 
 template <typename T, typename... Args>
@@ -21,5 +21,10 @@ bool SimpleRelationBoundable::UnbindRelation(const std::string& sname) {
   }
   return false;
 }
+
+void SimpleRelationBoundable::BindRelationsMemory(
+    common::MemoryAccount* account) {
+  common::rebind_container(mBoundRelations, account);
+}
 }  // namespace base
 }  // namespace hyperon
\ No newline at end of file
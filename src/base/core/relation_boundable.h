@@ -4,6 +4,8 @@
 #include <memory>
 #include <string>
 
+#include "common/memory/tracking_allocator.h"
+
 namespace hyperon {
 namespace base {
 
@@ -22,8 +24,14 @@ public:
   virtual bool BindRelation(const RelationPtr& relation);
   virtual bool UnbindRelation(const std::string& sname);
 
+protected:
+  // Charge the bound relations to `account` from now on.
+  void BindRelationsMemory(common::MemoryAccount* account);
+
 private:
-  std::map<std::string, std::weak_ptr<Relation>> mBoundRelations;
+  common::TrackedMap<std::string, std::weak_ptr<Relation>,
+                     common::MEM_MEMBERS>
+      mBoundRelations;
 };
 
 }  // namespace base
@@ -12,6 +12,8 @@ using RolePtr = std::shared_ptr<Role>;
 
 class Role : public Concept {
 public:
+  using Concept::Concept;
+
   /* override */ inline bool IsRole() const { return true; }
 };
 
@@ -0,0 +1,1395 @@
+#include "base/datalog/datalog_engine.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "base/core/relation.h"
+#include "base/storage/mutation_codec.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+constexpr uint32_t kMaxArity = 31;
+constexpr size_t kWriteBatch = 8192;
+// PlanRule() seed position binding the head, for rederivation.
+constexpr int kSeedHead = -2;
+constexpr size_t kNever = static_cast<size_t>(-1);
+
+// Base predicates answered from the hyperbase, all binary.
+constexpr const char* kBasePredicates[] = {"isa", "split", "member", "kind",
+                                           "category"};
+
+std::string mask_string(uint32_t mask, uint32_t arity) {
+  std::string bits;
+  for (uint32_t col = 0; col < arity; ++col) {
+    bits += (mask & (1u << col)) ? 'b' : 'f';
+  }
+  return bits;
+}
+
+}  // namespace
+
+struct DatalogEngine::Predicate {
+  std::string name;
+  uint32_t arity{0};
+  bool base{false};
+  bool used{false};
+  int stratum{-1};
+  std::unique_ptr<DatalogTable> full;
+  // Facts new in the last round, and facts derived in the current one.
+  std::unique_ptr<DatalogTable> delta;
+  std::unique_ptr<DatalogTable> next;
+  // Net changes of the update in progress.
+  std::unique_ptr<DatalogTable> inserted;
+  std::unique_ptr<DatalogTable> erased;
+  // Derivations per row of `full`, for non-recursive derived predicates.
+  std::vector<int64_t> counts;
+  // Index masks the plans probe on the full table.
+  std::set<uint32_t> full_masks;
+
+  inline bool Changed() const {
+    return inserted && (!inserted->Empty() || !erased->Empty());
+  }
+};
+
+struct DatalogEngine::PlanStep {
+  DatalogLiteral::TYPE type{DatalogLiteral::ATOM};
+  int predicate{-1};
+  // Reads the seed table of the pass instead of the full one.
+  bool delta{false};
+  // Position in the rule body.
+  size_t body{0};
+  // Columns bound before the step.
+  uint32_t mask{0};
+  // Per column: variable slot, or -1 for a constant.
+  std::vector<int> slots;
+  std::vector<uint32_t> consts;
+  // Per column: whether the step binds the slot rather than compares it.
+  std::vector<bool> binds;
+};
+
+struct DatalogEngine::RulePlan {
+  const DatalogRule* rule{nullptr};
+  int head{-1};
+  std::vector<int> head_slots;
+  std::vector<uint32_t> head_consts;
+  std::vector<PlanStep> steps;
+  uint32_t slot_count{0};
+  // Body literal read from the seed table, -1 for the initial round.
+  int delta_atom{-1};
+};
+
+struct DatalogEngine::Stratum {
+  std::vector<int> predicates;
+  bool recursive{false};
+  // Strata this one reads from.
+  std::set<int> depends;
+  int wave{0};
+  std::vector<RulePlan> initial;
+  std::vector<RulePlan> deltas;
+  // Plans seeded by changes of a lower predicate, one per body literal.
+  std::vector<RulePlan> seeds;
+  // Plans seeded by the head, checking that a fact is still derivable.
+  std::vector<RulePlan> rederive;
+  uint64_t iterations{0};
+  uint64_t derived{0};
+};
+
+/**
+ * @brief Hyperbase statistics the planner estimates rows from, taken once
+ * per compilation.
+ */
+struct DatalogEngine::Estimates {
+  HyperbaseStatistics stats;
+  double average_fanout{0};
+  // Estimated members of the relations named as constants in member/2.
+  std::unordered_map<std::string, double> fanout;
+};
+
+struct DatalogEngine::Pass {
+  // Table read by the seed step, the delta of its predicate if null.
+  const DatalogTable* seed{nullptr};
+  // Body literals from this position on read the state before the update.
+  size_t old_from{kNever};
+  // Per step, rows read and rows passed on when profiling.
+  uint64_t* scanned{nullptr};
+  uint64_t* matched{nullptr};
+};
+
+struct DatalogEngine::Profiling {
+  struct Plan {
+    common::ProfileNode* node{nullptr};
+    std::vector<common::ProfileNode*> steps;
+    std::vector<uint64_t> scanned;
+    std::vector<uint64_t> matched;
+  };
+  std::unordered_map<const Stratum*, common::ProfileNode*> strata;
+  std::unordered_map<const RulePlan*, Plan> plans;
+};
+
+DatalogEngine::DatalogEngine(const DatalogProgram& program)
+    : DatalogEngine(program, Options()) {}
+
+DatalogEngine::DatalogEngine(const DatalogProgram& program,
+                             const Options& options)
+    : mProgram(program), mOptions(options) {}
+
+DatalogEngine::~DatalogEngine() = default;
+
+int DatalogEngine::PredicateId(const std::string& name) const {
+  auto found = mPredicateIds.find(name);
+  return found == mPredicateIds.end() ? -1 : found->second;
+}
+
+bool DatalogEngine::Compile(std::string& error) {
+  if (mCompiled) return true;
+  if (!CheckPredicates(error) || !Stratify(error)) return false;
+
+  const auto& rules = mProgram.Rules();
+  for (const auto& rule : rules) {
+    Stratum& stratum = *mStrata[mPredicates[PredicateId(
+                                                rule.head.predicate)]
+                                    ->stratum];
+    stratum.initial.emplace_back();
+    if (!PlanRule(rule, -1, stratum.initial.back(), error)) return false;
+    if (stratum.recursive) {
+      stratum.rederive.emplace_back();
+      if (!PlanRule(rule, kSeedHead, stratum.rederive.back(), error)) {
+        return false;
+      }
+    }
+    for (size_t i = 0; i < rule.body.size(); ++i) {
+      const DatalogLiteral& literal = rule.body[i];
+      if (!literal.IsAtom()) continue;
+      const Predicate& body = *mPredicates[PredicateId(literal.predicate)];
+      bool own = !body.base && mStrata[body.stratum].get() == &stratum;
+      auto& plans = own ? stratum.deltas : stratum.seeds;
+      plans.emplace_back();
+      if (!PlanRule(rule, static_cast<int>(i), plans.back(), error)) {
+        return false;
+      }
+    }
+  }
+  mCompiled = true;
+  return true;
+}
+
+bool DatalogEngine::Compile(const Hyperbase& hyperbase,
+                            std::string& error) {
+  if (mCompiled) return true;
+  mEstimates = std::make_unique<Estimates>();
+  mEstimates->stats = hyperbase.Statistics();
+  {
+    std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+    mEstimates->average_fanout = hyperbase.AverageRelationFanout();
+    for (const auto& rule : mProgram.Rules()) {
+      for (const auto& literal : rule.body) {
+        if (!literal.IsAtom() || literal.predicate != "member" ||
+            literal.terms.empty() || literal.terms[0].variable) {
+          continue;
+        }
+        const std::string& relation = literal.terms[0].text;
+        mEstimates->fanout[relation] = static_cast<double>(
+            hyperbase.EstimateRelationFanout(relation));
+      }
+    }
+  }
+  bool compiled = Compile(error);
+  mEstimates.reset();
+  return compiled;
+}
+
+double DatalogEngine::EstimateRows(const DatalogLiteral& literal,
+                                   uint32_t mask) const {
+  if (!mEstimates) return 0;
+  uint32_t full = (1u << literal.terms.size()) - 1;
+  if (mask == full) return 1;
+  const HyperbaseStatistics& stats = mEstimates->stats;
+  const CategoryStatistics& totals = stats.totals;
+  double concepts = std::max<double>(totals.concepts, 1);
+  bool first = mask & 1;
+  bool second = mask & 2;
+  const std::string& name = literal.predicate;
+  if (name == "isa") {
+    return first || second ? stats.lineage_edges / concepts
+                           : stats.lineage_edges;
+  }
+  if (name == "split") {
+    return first || second ? stats.splits / concepts : stats.splits;
+  }
+  if (name == "member") {
+    if (first) {
+      const DatalogTerm& relation = literal.terms[0];
+      return relation.variable ? mEstimates->average_fanout
+                               : mEstimates->fanout.at(relation.text);
+    }
+    // Relations per member.
+    if (second) {
+      return stats.relation_members /
+             std::max<double>(stats.distinct_members, 1);
+    }
+    return stats.relation_members;
+  }
+  if (name == "kind") {
+    if (first) return 1;
+    if (!second) return concepts;
+    const DatalogTerm& kind = literal.terms[1];
+    if (kind.variable) return concepts;
+    if (kind.text == "entity") return totals.entities;
+    if (kind.text == "relation") return totals.relations;
+    if (kind.text == "role") return totals.roles;
+    if (kind.text == "context") return totals.contexts;
+    return concepts;
+  }
+  if (name == "category") {
+    if (first) return 1;
+    return second ? concepts / std::max<double>(totals.categories, 1)
+                  : concepts;
+  }
+  // Derived predicates have no statistics before they are evaluated, taken
+  // as one fact per concept and unbound column.
+  double rows = 1;
+  for (size_t col = 0; col < literal.terms.size(); ++col) {
+    if (!(mask & (1u << col))) rows *= concepts;
+  }
+  return rows;
+}
+
+bool DatalogEngine::CheckPredicates(std::string& error) {
+  auto declare = [this](const std::string& name, uint32_t arity, bool base) {
+    auto predicate = std::make_unique<Predicate>();
+    predicate->name = name;
+    predicate->arity = arity;
+    predicate->base = base;
+    mPredicateIds[name] = static_cast<int>(mPredicates.size());
+    mPredicates.push_back(std::move(predicate));
+  };
+  for (const char* name : kBasePredicates) declare(name, 2, true);
+
+  auto check_arity = [this, &error](const DatalogLiteral& literal,
+                                    const DatalogRule& rule) {
+    const Predicate& predicate =
+        *mPredicates[PredicateId(literal.predicate)];
+    if (predicate.arity == literal.terms.size()) return true;
+    error = fmt::format("line {}: {} used with {} arguments, expected {}",
+                        rule.line, literal.predicate, literal.terms.size(),
+                        predicate.arity);
+    return false;
+  };
+
+  for (const auto& rule : mProgram.Rules()) {
+    const DatalogLiteral& head = rule.head;
+    if (head.terms.size() > kMaxArity) {
+      error = fmt::format("line {}: {} has more than {} arguments",
+                          rule.line, head.predicate, kMaxArity);
+      return false;
+    }
+    int id = PredicateId(head.predicate);
+    if (id < 0) {
+      declare(head.predicate, static_cast<uint32_t>(head.terms.size()),
+              false);
+    } else if (mPredicates[id]->base) {
+      error = fmt::format("line {}: {} is provided by the hyperbase",
+                          rule.line, head.predicate);
+      return false;
+    } else if (!check_arity(head, rule)) {
+      return false;
+    }
+  }
+
+  for (const auto& rule : mProgram.Rules()) {
+    for (const auto& literal : rule.body) {
+      if (!literal.IsAtom()) continue;
+      int id = PredicateId(literal.predicate);
+      if (id < 0) {
+        error = fmt::format("line {}: undefined predicate {}", rule.line,
+                            literal.predicate);
+        return false;
+      }
+      if (!check_arity(literal, rule)) return false;
+      mPredicates[id]->used = true;
+    }
+  }
+  return true;
+}
+
+bool DatalogEngine::Stratify(std::string& error) {
+  // Dependency graph between derived predicates, by head.
+  size_t n = mPredicates.size();
+  std::vector<std::vector<std::pair<int, bool>>> edges(n);
+  for (const auto& rule : mProgram.Rules()) {
+    int head = PredicateId(rule.head.predicate);
+    for (const auto& literal : rule.body) {
+      if (!literal.IsAtom()) continue;
+      int body = PredicateId(literal.predicate);
+      if (mPredicates[body]->base) continue;
+      edges[head].emplace_back(body,
+                               literal.type == DatalogLiteral::NEGATED);
+    }
+  }
+
+  // Tarjan's algorithm emits components dependencies first.
+  std::vector<int> index(n, -1);
+  std::vector<int> low(n, 0);
+  std::vector<bool> on_stack(n, false);
+  std::vector<int> stack;
+  int counter = 0;
+  std::function<void(int)> connect = [&](int v) {
+    index[v] = low[v] = counter++;
+    stack.push_back(v);
+    on_stack[v] = true;
+    for (const auto& edge : edges[v]) {
+      int w = edge.first;
+      if (index[w] < 0) {
+        connect(w);
+        low[v] = std::min(low[v], low[w]);
+      } else if (on_stack[w]) {
+        low[v] = std::min(low[v], index[w]);
+      }
+    }
+    if (low[v] != index[v]) return;
+    auto stratum = std::make_unique<Stratum>();
+    int id = static_cast<int>(mStrata.size());
+    int w;
+    do {
+      w = stack.back();
+      stack.pop_back();
+      on_stack[w] = false;
+      mPredicates[w]->stratum = id;
+      stratum->predicates.push_back(w);
+    } while (w != v);
+    mStrata.push_back(std::move(stratum));
+  };
+  for (size_t v = 0; v < n; ++v) {
+    if (!mPredicates[v]->base && index[v] < 0) connect(static_cast<int>(v));
+  }
+
+  for (size_t v = 0; v < n; ++v) {
+    if (mPredicates[v]->base) continue;
+    Stratum& stratum = *mStrata[mPredicates[v]->stratum];
+    for (const auto& edge : edges[v]) {
+      int other = mPredicates[edge.first]->stratum;
+      if (other != mPredicates[v]->stratum) {
+        stratum.depends.insert(other);
+        continue;
+      }
+      if (edge.second) {
+        error = fmt::format("program is not stratifiable: {} depends on "
+                            "the negation of {}",
+                            mPredicates[v]->name,
+                            mPredicates[edge.first]->name);
+        return false;
+      }
+      stratum.recursive = true;
+    }
+  }
+
+  // Strata are in dependency order, so waves are assigned in one pass.
+  for (auto& stratum : mStrata) {
+    for (int dep : stratum->depends) {
+      stratum->wave = std::max(stratum->wave, mStrata[dep]->wave + 1);
+    }
+    if (static_cast<size_t>(stratum->wave) >= mWaves.size()) {
+      mWaves.resize(stratum->wave + 1);
+    }
+    mWaves[stratum->wave].push_back(stratum.get());
+  }
+  return true;
+}
+
+bool DatalogEngine::PlanRule(const DatalogRule& rule, int delta_atom,
+                             RulePlan& plan, std::string& error) {
+  plan.rule = &rule;
+  plan.delta_atom = delta_atom;
+  plan.head = PredicateId(rule.head.predicate);
+
+  std::unordered_map<std::string, int> slots;
+  std::vector<bool> bound;
+  auto slot_of = [&](const std::string& var) {
+    auto found = slots.find(var);
+    if (found != slots.end()) return found->second;
+    int slot = static_cast<int>(slots.size());
+    slots.emplace(var, slot);
+    bound.push_back(false);
+    return slot;
+  };
+  auto is_bound = [&](const DatalogTerm& term) {
+    return !term.variable || bound[slot_of(term.text)];
+  };
+
+  auto add_step = [&](const DatalogLiteral& literal, size_t body,
+                      bool delta) {
+    PlanStep step;
+    step.type = literal.type;
+    step.predicate = literal.IsAtom() ? PredicateId(literal.predicate) : -1;
+    step.delta = delta;
+    step.body = body;
+    // Slots bound by this step, marked only once the step is complete so
+    // that repeated variables compare against the first occurrence.
+    std::vector<int> binding;
+    for (size_t col = 0; col < literal.terms.size(); ++col) {
+      const DatalogTerm& term = literal.terms[col];
+      if (!term.variable) {
+        step.slots.push_back(-1);
+        step.consts.push_back(mSymbols.Intern(term.text));
+        step.binds.push_back(false);
+        step.mask |= 1u << col;
+        continue;
+      }
+      int slot = slot_of(term.text);
+      step.slots.push_back(slot);
+      step.consts.push_back(0);
+      bool first = !bound[slot] && std::find(binding.begin(), binding.end(),
+                                             slot) == binding.end();
+      step.binds.push_back(first);
+      if (bound[slot]) step.mask |= 1u << col;
+      if (first) binding.push_back(slot);
+    }
+    for (int slot : binding) bound[slot] = true;
+
+    // Seed tables are scanned, other tables are probed on the bound columns.
+    if (step.predicate >= 0 && !delta) {
+      Predicate& predicate = *mPredicates[step.predicate];
+      uint32_t full = (1u << predicate.arity) - 1;
+      if (step.mask != 0 && step.mask != full) {
+        predicate.full_masks.insert(step.mask);
+      }
+    }
+    plan.steps.push_back(std::move(step));
+  };
+
+  std::vector<int> pending;
+  if (delta_atom == kSeedHead) add_step(rule.head, kNever, true);
+  for (size_t i = 0; i < rule.body.size(); ++i) {
+    if (static_cast<int>(i) == delta_atom) {
+      add_step(rule.body[i], i, true);
+    } else {
+      pending.push_back(static_cast<int>(i));
+    }
+  }
+
+  while (!pending.empty()) {
+    // Filters go first as soon as they can be checked, an equality with one
+    // side bound binds the other.
+    int pick = -1;
+    for (size_t k = 0; k < pending.size() && pick < 0; ++k) {
+      const DatalogLiteral& literal = rule.body[pending[k]];
+      if (literal.type == DatalogLiteral::ATOM) continue;
+      size_t ready = std::count_if(literal.terms.begin(), literal.terms.end(),
+                                   is_bound);
+      bool placeable = literal.type == DatalogLiteral::EQUAL
+                           ? ready >= 1
+                           : ready == literal.terms.size();
+      if (placeable) pick = static_cast<int>(k);
+    }
+    // Otherwise the positive atom expected to produce the fewest rows, then
+    // the one with the most bound columns.
+    bool filtered = pick >= 0;
+    int best_bound = -1;
+    double best_rows = 0;
+    for (size_t k = 0; k < pending.size() && !filtered; ++k) {
+      const DatalogLiteral& literal = rule.body[pending[k]];
+      if (literal.type != DatalogLiteral::ATOM) continue;
+      uint32_t mask = 0;
+      int ready = 0;
+      for (size_t col = 0; col < literal.terms.size(); ++col) {
+        if (!is_bound(literal.terms[col])) continue;
+        mask |= 1u << col;
+        ++ready;
+      }
+      double rows = EstimateRows(literal, mask);
+      if (pick < 0 || rows < best_rows ||
+          (rows == best_rows && ready > best_bound)) {
+        best_rows = rows;
+        best_bound = ready;
+        pick = static_cast<int>(k);
+      }
+    }
+    if (pick < 0) {
+      error = fmt::format("line {}: unsafe rule, {} has unbound variables",
+                          rule.line, rule.body[pending[0]].ToString());
+      return false;
+    }
+    add_step(rule.body[pending[pick]], pending[pick], false);
+    pending.erase(pending.begin() + pick);
+  }
+
+  for (const auto& term : rule.head.terms) {
+    if (!term.variable) {
+      plan.head_slots.push_back(-1);
+      plan.head_consts.push_back(mSymbols.Intern(term.text));
+      continue;
+    }
+    auto found = slots.find(term.text);
+    if (found == slots.end() || !bound[found->second]) {
+      error = fmt::format("line {}: unsafe rule, head variable {} is not "
+                          "bound by the body",
+                          rule.line, term.text);
+      return false;
+    }
+    plan.head_slots.push_back(found->second);
+    plan.head_consts.push_back(0);
+  }
+  plan.slot_count = static_cast<uint32_t>(slots.size());
+  return true;
+}
+
+bool DatalogEngine::LoadBaseFacts(const Hyperbase& hyperbase) {
+  for (auto& predicate : mPredicates) {
+    predicate->full = std::make_unique<DatalogTable>(predicate->arity);
+    predicate->delta = std::make_unique<DatalogTable>(predicate->arity);
+    predicate->next = std::make_unique<DatalogTable>(predicate->arity);
+    predicate->inserted = std::make_unique<DatalogTable>(predicate->arity);
+    predicate->erased = std::make_unique<DatalogTable>(predicate->arity);
+    predicate->counts.clear();
+  }
+  auto table = [this](const char* name) -> DatalogTable* {
+    const Predicate& predicate = *mPredicates[PredicateId(name)];
+    return predicate.used ? predicate.full.get() : nullptr;
+  };
+  DatalogTable* isa = table("isa");
+  DatalogTable* split = table("split");
+  DatalogTable* member = table("member");
+  DatalogTable* kind = table("kind");
+  DatalogTable* category = table("category");
+
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  mStats.version = hyperbase.Version();
+  CategoryPtr root = hyperbase.RootCategory();
+  uint32_t tuple[2];
+  hyperbase.ForEachConcept([&](const ConceptPtr& cnpt) {
+    tuple[0] = mSymbols.Intern(cnpt->SemName());
+    if (isa) {
+      cnpt->ForEachParent([&](const ElementPtr& parent) {
+        tuple[1] = mSymbols.Intern(parent->SemName());
+        isa->Insert(tuple);
+      });
+    }
+    if (split) {
+      for (const auto& children : cnpt->Splits()) {
+        for (const auto& child : children) {
+          tuple[1] = mSymbols.Intern(child);
+          split->Insert(tuple);
+        }
+      }
+    }
+    if (member && cnpt->IsRelation()) {
+      std::static_pointer_cast<Relation>(cnpt)->ForEachMember(
+          [&](const ConceptPtr& m) {
+            tuple[1] = mSymbols.Intern(m->SemName());
+            member->Insert(tuple);
+          });
+    }
+    if (kind) {
+      tuple[1] = mSymbols.Intern(concept_kind_name(concept_kind_of(cnpt)));
+      kind->Insert(tuple);
+    }
+    CategoryPtr owner = category ? cnpt->GetCategory() : nullptr;
+    if (owner && owner != root) {
+      tuple[1] = mSymbols.Intern(owner->Name());
+      category->Insert(tuple);
+    }
+  });
+  for (DatalogTable* base : {isa, split, member, kind, category}) {
+    if (base) mStats.base_facts += base->Size();
+  }
+  return true;
+}
+
+void DatalogEngine::PrepareIndexes(const Stratum& stratum) {
+  auto prepare = [this, &stratum](const std::vector<RulePlan>& plans) {
+    for (const auto& plan : plans) {
+      for (const auto& step : plan.steps) {
+        if (step.predicate < 0) continue;
+        Predicate& predicate = *mPredicates[step.predicate];
+        if (predicate.base ||
+            mStrata[predicate.stratum].get() != &stratum) {
+          for (uint32_t mask : predicate.full_masks) {
+            predicate.full->Prepare(mask);
+          }
+        }
+      }
+    }
+  };
+  prepare(stratum.initial);
+  prepare(stratum.deltas);
+}
+
+template <typename Sink>
+void DatalogEngine::Run(const RulePlan& plan, Pass pass,
+                        std::vector<uint32_t>& slots, Sink& sink) const {
+  slots.assign(std::max<uint32_t>(plan.slot_count, 1), 0);
+  Profiling::Plan* profile = nullptr;
+  if (mProfiling) {
+    auto found = mProfiling->plans.find(&plan);
+    if (found != mProfiling->plans.end()) profile = &found->second;
+  }
+  if (!profile) {
+    Execute(plan, pass, 0, slots.data(), sink);
+    return;
+  }
+  pass.scanned = profile->scanned.data();
+  pass.matched = profile->matched.data();
+  uint64_t emitted = 0;
+  auto counted = [&sink, &emitted](const uint32_t* tuple) {
+    ++emitted;
+    sink(tuple);
+  };
+  common::ProfileTimer timer(profile->node);
+  Execute(plan, pass, 0, slots.data(), counted);
+  ++profile->node->loops;
+  profile->node->rows_out += emitted;
+}
+
+template <typename Sink>
+void DatalogEngine::Execute(const RulePlan& plan, const Pass& pass, size_t k,
+                            uint32_t* slots, Sink& sink) const {
+  uint32_t tuple[kMaxArity];
+  if (k == plan.steps.size()) {
+    for (size_t col = 0; col < plan.head_slots.size(); ++col) {
+      int slot = plan.head_slots[col];
+      tuple[col] = slot >= 0 ? slots[slot] : plan.head_consts[col];
+    }
+    sink(static_cast<const uint32_t*>(tuple));
+    return;
+  }
+
+  const PlanStep& step = plan.steps[k];
+  auto value = [&](size_t col) {
+    return step.slots[col] >= 0 ? slots[step.slots[col]] : step.consts[col];
+  };
+
+  if (step.type == DatalogLiteral::EQUAL ||
+      step.type == DatalogLiteral::NOT_EQUAL) {
+    if (pass.scanned) ++pass.scanned[k];
+    if (step.binds[0] || step.binds[1]) {
+      size_t target = step.binds[0] ? 0 : 1;
+      slots[step.slots[target]] = value(1 - target);
+    } else if ((value(0) == value(1)) !=
+               (step.type == DatalogLiteral::EQUAL)) {
+      return;
+    }
+    if (pass.matched) ++pass.matched[k];
+    Execute(plan, pass, k + 1, slots, sink);
+    return;
+  }
+
+  const Predicate& predicate = *mPredicates[step.predicate];
+  for (size_t col = 0; col < step.slots.size(); ++col) {
+    if (step.mask & (1u << col)) tuple[col] = value(col);
+  }
+  auto visit = [&](const uint32_t* row) {
+    for (size_t col = 0; col < step.slots.size(); ++col) {
+      if (step.mask & (1u << col)) {
+        if (row[col] != tuple[col]) return;
+      } else if (step.binds[col]) {
+        slots[step.slots[col]] = row[col];
+      } else if (slots[step.slots[col]] != row[col]) {
+        return;
+      }
+    }
+    if (pass.matched) ++pass.matched[k];
+    Execute(plan, pass, k + 1, slots, sink);
+  };
+  auto scan = [&](const DatalogTable& table, bool skip_inserted) {
+    auto each = [&](size_t row) {
+      const uint32_t* values = table.Row(row);
+      if (pass.scanned) ++pass.scanned[k];
+      if (skip_inserted && predicate.inserted->Contains(values)) return;
+      visit(values);
+    };
+    if (step.mask != 0 && table.HasIndex(step.mask)) {
+      const std::vector<uint32_t>* rows = table.Probe(step.mask, tuple);
+      if (!rows) return;
+      for (uint32_t row : *rows) each(row);
+    } else {
+      for (size_t row = 0; row < table.Size(); ++row) each(row);
+    }
+  };
+
+  if (step.delta) {
+    scan(pass.seed ? *pass.seed : *predicate.delta, false);
+    return;
+  }
+  // The old state is the full table without inserted and with erased facts.
+  bool old = step.body >= pass.old_from && predicate.Changed();
+  const DatalogTable& table = *predicate.full;
+  if (step.type == DatalogLiteral::NEGATED || step.mask == table.FullMask()) {
+    if (pass.scanned) ++pass.scanned[k];
+    bool present = table.Contains(tuple);
+    if (old) {
+      present = present ? !predicate.inserted->Contains(tuple)
+                        : predicate.erased->Contains(tuple);
+    }
+    if (present != (step.type == DatalogLiteral::NEGATED)) {
+      if (pass.matched) ++pass.matched[k];
+      Execute(plan, pass, k + 1, slots, sink);
+    }
+    return;
+  }
+  scan(table, old);
+  if (old) scan(*predicate.erased, false);
+}
+
+void DatalogEngine::EvaluateStratum(Stratum& stratum) {
+  common::ProfileTimer timer(StratumProfile(stratum));
+  for (int id : stratum.predicates) {
+    for (uint32_t mask : mPredicates[id]->full_masks) {
+      mPredicates[id]->full->Prepare(mask);
+    }
+  }
+  std::vector<uint32_t> slots;
+  Pass pass;
+  if (!stratum.recursive) {
+    // The head is not read by its own rules, count derivations in place.
+    Predicate& head = *mPredicates[stratum.predicates.front()];
+    auto count = [&head, &stratum](const uint32_t* tuple) {
+      size_t row = head.full->Find(tuple);
+      if (row == DatalogTable::kNoRow) {
+        head.full->Insert(tuple);
+        head.counts.push_back(1);
+        ++stratum.derived;
+      } else {
+        ++head.counts[row];
+      }
+    };
+    for (const auto& plan : stratum.initial) Run(plan, pass, slots, count);
+    return;
+  }
+
+  for (const auto& plan : stratum.initial) {
+    Predicate& head = *mPredicates[plan.head];
+    auto derive = [&head, &stratum](const uint32_t* tuple) {
+      if (!head.full->Contains(tuple) && head.next->Insert(tuple)) {
+        ++stratum.derived;
+      }
+    };
+    Run(plan, pass, slots, derive);
+  }
+  Saturate(stratum, false);
+}
+
+void DatalogEngine::Saturate(Stratum& stratum, bool record) {
+  std::vector<uint32_t> slots;
+  Pass pass;
+  while (true) {
+    bool changed = false;
+    for (int id : stratum.predicates) {
+      Predicate& predicate = *mPredicates[id];
+      std::swap(predicate.delta, predicate.next);
+      predicate.next->Clear();
+      predicate.full->InsertAll(*predicate.delta);
+      if (record) predicate.inserted->InsertAll(*predicate.delta);
+      changed |= !predicate.delta->Empty();
+    }
+    if (!changed) break;
+    ++stratum.iterations;
+    for (const auto& plan : stratum.deltas) {
+      int atom = plan.steps.front().predicate;
+      if (mPredicates[atom]->delta->Empty()) continue;
+      Predicate& head = *mPredicates[plan.head];
+      auto derive = [&head, &stratum](const uint32_t* tuple) {
+        if (!head.full->Contains(tuple) && head.next->Insert(tuple)) {
+          ++stratum.derived;
+        }
+      };
+      Run(plan, pass, slots, derive);
+    }
+  }
+  for (int id : stratum.predicates) {
+    mPredicates[id]->delta->Clear();
+  }
+}
+
+void DatalogEngine::Recount(Stratum& stratum) {
+  common::ProfileTimer timer(StratumProfile(stratum));
+  Predicate& head = *mPredicates[stratum.predicates.front()];
+  // Derivation count changes per head tuple. Derivations are expanded over
+  // the body in order: literals before the seed read the new state, those
+  // after it the old one, so each derivation is counted exactly once.
+  DatalogTable changed(head.arity);
+  std::vector<int64_t> deltas;
+  int64_t sign = 0;
+  auto count = [&changed, &deltas, &sign](const uint32_t* tuple) {
+    size_t row = changed.Find(tuple);
+    if (row == DatalogTable::kNoRow) {
+      changed.Insert(tuple);
+      deltas.push_back(sign);
+    } else {
+      deltas[row] += sign;
+    }
+  };
+
+  std::vector<uint32_t> slots;
+  for (const auto& plan : stratum.seeds) {
+    const Predicate& input = *mPredicates[plan.steps.front().predicate];
+    if (!input.Changed()) continue;
+    bool negated =
+        plan.rule->body[plan.delta_atom].type == DatalogLiteral::NEGATED;
+    Pass pass;
+    pass.old_from = plan.delta_atom + 1;
+    for (const DatalogTable* seed : {input.inserted.get(),
+                                     input.erased.get()}) {
+      if (seed->Empty()) continue;
+      pass.seed = seed;
+      sign = (seed == input.inserted.get()) != negated ? 1 : -1;
+      Run(plan, pass, slots, count);
+    }
+  }
+
+  for (size_t row = 0; row < changed.Size(); ++row) {
+    if (deltas[row] == 0) continue;
+    const uint32_t* tuple = changed.Row(row);
+    size_t at = head.full->Find(tuple);
+    if (at == DatalogTable::kNoRow) {
+      head.full->Insert(tuple);
+      head.counts.push_back(deltas[row]);
+      head.inserted->Insert(tuple);
+      continue;
+    }
+    head.counts[at] += deltas[row];
+    if (head.counts[at] > 0) continue;
+    // Erase() moves the last row into the erased one.
+    head.counts[at] = head.counts.back();
+    head.counts.pop_back();
+    head.full->Erase(tuple);
+    head.erased->Insert(tuple);
+  }
+}
+
+void DatalogEngine::Rederive(Stratum& stratum) {
+  common::ProfileTimer timer(StratumProfile(stratum));
+  std::map<int, std::unique_ptr<DatalogTable>> deleted;
+  for (int id : stratum.predicates) {
+    deleted[id] = std::make_unique<DatalogTable>(mPredicates[id]->arity);
+  }
+  std::vector<uint32_t> slots;
+  auto run = [this, &slots](const RulePlan& plan, const Pass& pass,
+                            auto& sink) { Run(plan, pass, slots, sink); };
+
+  // Overdelete everything with a derivation in the old state that uses a
+  // removed fact, propagating through the stratum semi-naively.
+  Pass old;
+  old.old_from = 0;
+  for (const auto& plan : stratum.seeds) {
+    const Predicate& input = *mPredicates[plan.steps.front().predicate];
+    bool negated =
+        plan.rule->body[plan.delta_atom].type == DatalogLiteral::NEGATED;
+    old.seed = negated ? input.inserted.get() : input.erased.get();
+    if (!old.seed || old.seed->Empty()) continue;
+    Predicate& head = *mPredicates[plan.head];
+    DatalogTable& marked = *deleted[plan.head];
+    auto overdelete = [&head, &marked](const uint32_t* tuple) {
+      if (head.full->Contains(tuple) && marked.Insert(tuple)) {
+        head.next->Insert(tuple);
+      }
+    };
+    run(plan, old, overdelete);
+  }
+  old.seed = nullptr;
+  while (true) {
+    bool changed = false;
+    for (int id : stratum.predicates) {
+      Predicate& predicate = *mPredicates[id];
+      std::swap(predicate.delta, predicate.next);
+      predicate.next->Clear();
+      changed |= !predicate.delta->Empty();
+    }
+    if (!changed) break;
+    for (const auto& plan : stratum.deltas) {
+      if (mPredicates[plan.steps.front().predicate]->delta->Empty()) continue;
+      Predicate& head = *mPredicates[plan.head];
+      DatalogTable& marked = *deleted[plan.head];
+      auto overdelete = [&head, &marked](const uint32_t* tuple) {
+        if (head.full->Contains(tuple) && marked.Insert(tuple)) {
+          head.next->Insert(tuple);
+        }
+      };
+      run(plan, old, overdelete);
+    }
+  }
+  for (int id : stratum.predicates) {
+    mPredicates[id]->delta->Clear();
+    const DatalogTable& marked = *deleted[id];
+    for (size_t row = 0; row < marked.Size(); ++row) {
+      mPredicates[id]->full->Erase(marked.Row(row));
+    }
+  }
+
+  // Put back overdeleted facts with a derivation in the new state, and
+  // derive from inserted facts.
+  Pass fresh;
+  for (const auto& plan : stratum.rederive) {
+    fresh.seed = deleted[plan.head].get();
+    if (fresh.seed->Empty()) continue;
+    Predicate& head = *mPredicates[plan.head];
+    auto rederive = [&head](const uint32_t* tuple) {
+      if (!head.full->Contains(tuple)) head.next->Insert(tuple);
+    };
+    run(plan, fresh, rederive);
+  }
+  for (const auto& plan : stratum.seeds) {
+    const Predicate& input = *mPredicates[plan.steps.front().predicate];
+    bool negated =
+        plan.rule->body[plan.delta_atom].type == DatalogLiteral::NEGATED;
+    fresh.seed = negated ? input.erased.get() : input.inserted.get();
+    if (!fresh.seed || fresh.seed->Empty()) continue;
+    Predicate& head = *mPredicates[plan.head];
+    auto derive = [&head](const uint32_t* tuple) {
+      if (!head.full->Contains(tuple)) head.next->Insert(tuple);
+    };
+    run(plan, fresh, derive);
+  }
+  Saturate(stratum, true);
+
+  // Rederived facts are no change.
+  for (int id : stratum.predicates) {
+    Predicate& predicate = *mPredicates[id];
+    const DatalogTable& marked = *deleted[id];
+    for (size_t row = 0; row < marked.Size(); ++row) {
+      if (!predicate.inserted->Erase(marked.Row(row))) {
+        predicate.erased->Insert(marked.Row(row));
+      }
+    }
+  }
+}
+
+bool DatalogEngine::Evaluate(const Hyperbase& hyperbase, std::string& error,
+                             common::ProfileNode* profile) {
+  if (profile) {
+    *profile = common::ProfileNode(
+        "datalog_evaluate", fmt::format("{} rules", mProgram.Rules().size()));
+    profile->loops = 1;
+  }
+  common::ProfileTimer timer(profile);
+  {
+    common::ProfileTimer compile_timer(
+        common::profile_child(profile, "compile"));
+    if (!Compile(hyperbase, error)) return false;
+  }
+  mStats = DatalogStats();
+  mStats.strata = static_cast<uint32_t>(mStrata.size());
+  mStats.waves = static_cast<uint32_t>(mWaves.size());
+  {
+    common::ProfileNode* load =
+        common::profile_child(profile, "load_base_facts", "", "hyperbase");
+    common::ProfileTimer load_timer(load);
+    if (!LoadBaseFacts(hyperbase)) return false;
+    if (load) load->rows_out = mStats.base_facts;
+  }
+  if (profile) StartProfile(*profile);
+
+  size_t threads = mOptions.threads;
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  for (auto& stratum : mStrata) {
+    stratum->iterations = 0;
+    stratum->derived = 0;
+  }
+
+  for (const auto& wave : mWaves) {
+    for (Stratum* stratum : wave) PrepareIndexes(*stratum);
+    size_t workers = std::min(threads, wave.size());
+    if (workers <= 1) {
+      for (Stratum* stratum : wave) EvaluateStratum(*stratum);
+      continue;
+    }
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < workers; ++i) {
+      pool.emplace_back([this, &wave, &next] {
+        size_t k;
+        while ((k = next.fetch_add(1)) < wave.size()) {
+          EvaluateStratum(*wave[k]);
+        }
+      });
+    }
+    for (auto& worker : pool) worker.join();
+  }
+
+  for (const auto& stratum : mStrata) {
+    mStats.iterations += stratum->iterations;
+    mStats.derived_facts += stratum->derived;
+    if (common::ProfileNode* node = StratumProfile(*stratum)) {
+      node->loops = stratum->iterations + 1;
+      node->rows_out = stratum->derived;
+    }
+  }
+  if (profile) {
+    FinishProfile();
+    profile->rows_in = mStats.base_facts;
+    profile->rows_out = mStats.derived_facts;
+  }
+  mEvaluated = true;
+  return true;
+}
+
+bool DatalogEngine::Update(const std::vector<DatalogChange>& changes,
+                           std::string& error, common::ProfileNode* profile) {
+  if (!mEvaluated) {
+    error = "Update() needs a previous Evaluate()";
+    return false;
+  }
+  if (profile) {
+    *profile = common::ProfileNode(
+        "datalog_update", fmt::format("{} changes", changes.size()));
+    profile->loops = 1;
+    profile->rows_in = changes.size();
+  }
+  common::ProfileTimer timer(profile);
+  common::ProfileNode* apply =
+      common::profile_child(profile, "apply_changes", "", "hash");
+  common::ProfileTimer apply_timer(apply);
+  uint32_t tuple[kMaxArity];
+  for (const auto& change : changes) {
+    int id = PredicateId(change.predicate);
+    if (id < 0 || !mPredicates[id]->base) {
+      error = fmt::format("{} is not a base predicate", change.predicate);
+      return false;
+    }
+    Predicate& predicate = *mPredicates[id];
+    // Unused base predicates are not loaded.
+    if (!predicate.used || change.args.size() != predicate.arity) continue;
+    for (size_t col = 0; col < change.args.size(); ++col) {
+      tuple[col] = mSymbols.Intern(change.args[col]);
+    }
+    if (change.insert) {
+      if (predicate.full->Insert(tuple) && !predicate.erased->Erase(tuple)) {
+        predicate.inserted->Insert(tuple);
+      }
+    } else if (predicate.full->Erase(tuple) &&
+               !predicate.inserted->Erase(tuple)) {
+      predicate.erased->Insert(tuple);
+    }
+  }
+
+  apply_timer.Stop();
+  if (apply) {
+    apply->loops = 1;
+    apply->rows_in = changes.size();
+    for (const auto& predicate : mPredicates) {
+      if (predicate->base && predicate->inserted) {
+        apply->rows_out +=
+            predicate->inserted->Size() + predicate->erased->Size();
+      }
+    }
+  }
+  if (profile) StartProfile(*profile);
+
+  // Strata are in dependency order, each sees the net changes of its
+  // inputs.
+  for (auto& stratum : mStrata) {
+    if (stratum->recursive) {
+      Rederive(*stratum);
+    } else {
+      Recount(*stratum);
+    }
+  }
+  for (auto& predicate : mPredicates) {
+    if (!predicate->base) {
+      mStats.inserted_facts += predicate->inserted->Size();
+      mStats.erased_facts += predicate->erased->Size();
+      if (profile) {
+        profile->rows_out +=
+            predicate->inserted->Size() + predicate->erased->Size();
+      }
+    }
+    predicate->inserted->Clear();
+    predicate->erased->Clear();
+  }
+  if (profile) FinishProfile();
+  ++mStats.updates;
+  return true;
+}
+
+void DatalogEngine::StartProfile(common::ProfileNode& root) {
+  mProfiling = std::make_unique<Profiling>();
+  for (size_t i = 0; i < mStrata.size(); ++i) {
+    const Stratum& stratum = *mStrata[i];
+    std::string predicates;
+    for (int id : stratum.predicates) {
+      if (!predicates.empty()) predicates += ", ";
+      predicates += mPredicates[id]->name;
+    }
+    common::ProfileNode& node = root.AddChild(
+        fmt::format("stratum {}", i), predicates,
+        stratum.recursive ? "semi-naive" : "counting");
+    mProfiling->strata[&stratum] = &node;
+
+    auto add = [this, &node](const RulePlan& plan) {
+      std::string detail = plan.rule->ToString();
+      if (plan.delta_atom >= 0) {
+        detail += fmt::format(", delta {}", plan.delta_atom);
+      } else if (plan.delta_atom == kSeedHead) {
+        detail += ", rederive";
+      }
+      Profiling::Plan& profile = mProfiling->plans[&plan];
+      profile.node = &node.AddChild("rule", detail, PlanPath(plan));
+      for (const auto& step : plan.steps) {
+        const char* op = "scan";
+        std::string index;
+        if (step.predicate < 0) {
+          op = step.binds[0] || step.binds[1] ? "bind" : "filter";
+        } else {
+          const Predicate& predicate = *mPredicates[step.predicate];
+          uint32_t full = (1u << predicate.arity) - 1;
+          if (step.type == DatalogLiteral::NEGATED) {
+            op = "anti_join";
+          } else if (step.delta) {
+            op = "scan";
+          } else if (step.mask == full) {
+            op = "exists";
+          } else if (step.mask != 0) {
+            op = "probe";
+          }
+          index = fmt::format("{}{}[{}]", step.delta ? "delta " : "",
+                              predicate.name,
+                              mask_string(step.mask, predicate.arity));
+        }
+        const DatalogLiteral& literal = step.body == kNever
+                                            ? plan.rule->head
+                                            : plan.rule->body[step.body];
+        profile.steps.push_back(
+            &profile.node->AddChild(op, literal.ToString(), index));
+      }
+      profile.scanned.assign(plan.steps.size(), 0);
+      profile.matched.assign(plan.steps.size(), 0);
+    };
+    for (const auto& plan : stratum.initial) add(plan);
+    for (const auto& plan : stratum.deltas) add(plan);
+    for (const auto& plan : stratum.seeds) add(plan);
+    for (const auto& plan : stratum.rederive) add(plan);
+  }
+}
+
+void DatalogEngine::FinishProfile() {
+  for (auto& kv : mProfiling->plans) {
+    Profiling::Plan& profile = kv.second;
+    for (size_t k = 0; k < profile.steps.size(); ++k) {
+      profile.steps[k]->loops = profile.node->loops;
+      profile.steps[k]->rows_in = profile.scanned[k];
+      profile.steps[k]->rows_out = profile.matched[k];
+    }
+    profile.node->rows_in = profile.steps.empty() ? 0 : profile.scanned[0];
+  }
+  for (auto& kv : mProfiling->strata) {
+    kv.second->children.remove_if(
+        [](const common::ProfileNode& plan) { return plan.loops == 0; });
+  }
+  mProfiling.reset();
+}
+
+common::ProfileNode* DatalogEngine::StratumProfile(
+    const Stratum& stratum) const {
+  if (!mProfiling) return nullptr;
+  auto found = mProfiling->strata.find(&stratum);
+  return found == mProfiling->strata.end() ? nullptr : found->second;
+}
+
+void DatalogEngine::BaseChanges(const Hyperbase& hyperbase,
+                                const std::vector<const Mutation*>& mutations,
+                                std::vector<DatalogChange>& changes) {
+  auto add = [&changes](const char* predicate, const std::string& first,
+                        const std::string& second, bool insert) {
+    changes.push_back(DatalogChange{predicate, {first, second}, insert});
+  };
+  CategoryPtr root = hyperbase.RootCategory();
+  for (const Mutation* mut : mutations) {
+    ConceptPtr subject;
+    if (!hyperbase.GetConcept(mut->subject, subject)) continue;
+    // Mutations may apply partially, so insertions are checked against the
+    // state after the commit. Removing an absent fact is a no-op anyway.
+    switch (mut->kind) {
+      case Mutation::MUT_ADD_CONCEPT: {
+        add("kind", mut->subject,
+            concept_kind_name(concept_kind_of(subject)), true);
+        CategoryPtr owner = subject->GetCategory();
+        if (owner && owner != root) {
+          add("category", mut->subject, owner->Name(), true);
+        }
+        [[fallthrough]];
+      }
+      case Mutation::MUT_ADD_PARENT:
+      case Mutation::MUT_ADD_UNION:
+        for (const auto& parent : mut->objects) {
+          if (subject->HasParent(parent)) {
+            add("isa", mut->subject, parent, true);
+          }
+        }
+        break;
+      case Mutation::MUT_REMOVE_PARENT:
+        for (const auto& parent : mut->objects) {
+          add("isa", mut->subject, parent, false);
+        }
+        break;
+      case Mutation::MUT_ADD_SPLIT:
+        for (const auto& child : mut->objects) {
+          add("split", mut->subject, child, true);
+          add("isa", child, mut->subject, true);
+        }
+        break;
+      case Mutation::MUT_ADD_MEMBER:
+      case Mutation::MUT_ERASE_MEMBER: {
+        if (!subject->IsRelation()) break;
+        auto relation = std::static_pointer_cast<Relation>(subject);
+        bool insert = mut->kind == Mutation::MUT_ADD_MEMBER;
+        for (const auto& member : mut->objects) {
+          if (!insert || relation->HasEntityOrRelation(member)) {
+            add("member", mut->subject, member, insert);
+          }
+        }
+        break;
+      }
+      case Mutation::MUT_SET_INTERVAL:
+        // Times are not facts.
+        break;
+    }
+  }
+}
+
+size_t DatalogEngine::FactCount(const std::string& predicate) const {
+  int id = PredicateId(predicate);
+  if (id < 0 || !mPredicates[id]->full) return 0;
+  return mPredicates[id]->full->Size();
+}
+
+bool DatalogEngine::HasFact(const std::string& predicate,
+                            const std::vector<std::string>& args) const {
+  int id = PredicateId(predicate);
+  if (id < 0 || !mPredicates[id]->full) return false;
+  const DatalogTable& table = *mPredicates[id]->full;
+  if (args.size() != table.Arity()) return false;
+  uint32_t tuple[kMaxArity];
+  for (size_t col = 0; col < args.size(); ++col) {
+    if (!mSymbols.Find(args[col], tuple[col])) return false;
+  }
+  return table.Contains(tuple);
+}
+
+void DatalogEngine::ForEachFact(
+    const std::string& predicate,
+    const std::function<void(const std::vector<std::string>&)>& fn) const {
+  int id = PredicateId(predicate);
+  if (id < 0 || !mPredicates[id]->full) return;
+  const DatalogTable& table = *mPredicates[id]->full;
+  std::vector<std::string> args(table.Arity());
+  for (size_t row = 0; row < table.Size(); ++row) {
+    for (uint32_t col = 0; col < table.Arity(); ++col) {
+      args[col] = mSymbols.Name(table.Row(row)[col]);
+    }
+    fn(args);
+  }
+}
+
+std::string DatalogEngine::FactName(const Predicate& predicate,
+                                    const uint32_t* tuple) const {
+  std::string name = predicate.name + '(';
+  for (uint32_t col = 0; col < predicate.arity; ++col) {
+    if (col > 0) name += ", ";
+    name += mSymbols.Name(tuple[col]);
+  }
+  return name + ')';
+}
+
+BatchResult DatalogEngine::WriteBack(
+    Hyperbase& hyperbase, const std::vector<std::string>& predicates) const {
+  std::vector<Mutation> mutations;
+  {
+    std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+    for (const auto& name : predicates) {
+      int id = PredicateId(name);
+      if (id < 0 || mPredicates[id]->base || !mPredicates[id]->full) continue;
+      const Predicate& predicate = *mPredicates[id];
+      if (!hyperbase.HasConcept(name)) {
+        Mutation mut;
+        mut.kind = Mutation::MUT_ADD_CONCEPT;
+        mut.concept_kind = Mutation::KIND_RELATION;
+        mut.category = kCategory;
+        mut.subject = name;
+        mutations.push_back(std::move(mut));
+      }
+      const DatalogTable& table = *predicate.full;
+      for (size_t row = 0; row < table.Size(); ++row) {
+        std::string fact = FactName(predicate, table.Row(row));
+        if (hyperbase.HasConcept(fact)) continue;
+        Mutation add;
+        add.kind = Mutation::MUT_ADD_CONCEPT;
+        add.concept_kind = Mutation::KIND_RELATION;
+        add.category = kCategory;
+        add.subject = fact;
+        add.objects = {name};
+        mutations.push_back(std::move(add));
+
+        Mutation members;
+        members.kind = Mutation::MUT_ADD_MEMBER;
+        members.subject = fact;
+        for (uint32_t col = 0; col < predicate.arity; ++col) {
+          const std::string& arg = mSymbols.Name(table.Row(row)[col]);
+          ConceptPtr cnpt;
+          if (hyperbase.GetConcept(arg, cnpt) &&
+              (cnpt->IsEntity() || cnpt->IsRelation())) {
+            members.objects.push_back(arg);
+          }
+        }
+        if (!members.objects.empty()) mutations.push_back(std::move(members));
+      }
+    }
+  }
+
+  BatchResult result;
+  result.version = hyperbase.Version();
+  for (size_t begin = 0; begin < mutations.size(); begin += kWriteBatch) {
+    size_t end = std::min(begin + kWriteBatch, mutations.size());
+    BatchResult part = hyperbase.ApplyBatch(std::vector<Mutation>(
+        mutations.begin() + begin, mutations.begin() + end));
+    result.applied += part.applied;
+    result.failed += part.failed;
+    result.version = part.version;
+  }
+  return result;
+}
+
+std::string DatalogEngine::PlanPath(const RulePlan& plan) const {
+  std::string path;
+  for (const auto& step : plan.steps) {
+    if (!path.empty()) path += " -> ";
+    if (step.predicate < 0) {
+      path += step.binds[0] || step.binds[1] ? "bind" : "filter";
+      continue;
+    }
+    const Predicate& predicate = *mPredicates[step.predicate];
+    path += fmt::format(
+        "{}{}{}[{}]", step.type == DatalogLiteral::NEGATED ? "\\+" : "",
+        step.delta ? "delta " : "", predicate.name,
+        mask_string(step.mask, predicate.arity));
+  }
+  return path;
+}
+
+std::string DatalogEngine::Explain() const {
+  std::string text;
+  auto explain = [this, &text](const RulePlan& plan, size_t stratum) {
+    text += fmt::format("stratum {} ", stratum);
+    if (plan.delta_atom >= 0) text += fmt::format("delta {} ", plan.delta_atom);
+    text += plan.rule->ToString();
+    if (!plan.steps.empty()) text += " -> " + PlanPath(plan);
+    text += '\n';
+  };
+  for (size_t i = 0; i < mStrata.size(); ++i) {
+    for (const auto& plan : mStrata[i]->initial) explain(plan, i);
+    for (const auto& plan : mStrata[i]->deltas) explain(plan, i);
+  }
+  return text;
+}
+
+}  // namespace base
+}  // namespace hyperon
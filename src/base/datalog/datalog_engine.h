@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/datalog/datalog_program.h"
+#include "base/datalog/datalog_table.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Counters of the last evaluation.
+ */
+struct DatalogStats {
+  uint32_t strata{0};
+  // Groups of strata evaluated in parallel.
+  uint32_t waves{0};
+  // Semi-naive rounds over all strata.
+  uint64_t iterations{0};
+  uint64_t base_facts{0};
+  uint64_t derived_facts{0};
+  // Hyperbase version the base facts were read at.
+  uint64_t version{0};
+  // Incremental updates since the evaluation and the derived facts they
+  // inserted and erased.
+  uint64_t updates{0};
+  uint64_t inserted_facts{0};
+  uint64_t erased_facts{0};
+};
+
+/**
+ * @brief Insertion or removal of a base fact, see DatalogEngine::Update().
+ */
+struct DatalogChange {
+  std::string predicate;
+  std::vector<std::string> args;
+  bool insert{true};
+};
+
+/**
+ * @brief Bottom-up Datalog engine over the lineage and relation store.
+ *
+ * Base predicates read from the hyperbase:
+ *
+ *   isa(X, Y)        Y is a direct parent of X
+ *   split(P, C)      C is in a split of P
+ *   member(R, X)     X is a member of relation R
+ *   kind(X, K)       K is concept, entity, relation, role, context or event
+ *   category(X, C)   X belongs to category C, the root category excluded
+ *
+ * Compile() checks the program for safety and stratified negation, groups
+ * the derived predicates into strata, i.e. strongly connected components of
+ * the dependency graph, and turns every rule into join plans. A rule gets
+ * one plan per body atom of its own stratum, reading the delta of that atom
+ * and the full relations otherwise. Atoms are ordered greedily by the rows
+ * a lookup is expected to produce, then by the number of bound columns, and
+ * each one is looked up through a hash index on those columns. The row
+ * estimates come from the maintained hyperbase statistics, e.g. the
+ * relation fan-out sketch for member(R, X), so planning never scans; a
+ * program compiled without a hyperbase is ordered by bound columns only.
+ *
+ * Evaluate() reads the base facts under the shared lock, then evaluates the
+ * strata semi-naively without holding the lock. Strata which do not depend
+ * on each other are evaluated in parallel.
+ *
+ * Update() maintains the derived facts under base fact changes. Facts of
+ * non-recursive strata carry their number of derivations and are adjusted
+ * by counting; recursive strata use delete and rederive (DRed): facts with
+ * a derivation through a removed fact are deleted, those still derivable
+ * from what remains are put back, then insertions are propagated
+ * semi-naively. Both only visit derivations touching a changed fact.
+ */
+class DatalogEngine {
+public:
+  struct Options {
+    // Threads evaluating independent strata, hardware concurrency if 0.
+    size_t threads{0};
+  };
+
+  explicit DatalogEngine(const DatalogProgram& program);
+  DatalogEngine(const DatalogProgram& program, const Options& options);
+  ~DatalogEngine();
+
+  DatalogEngine(const DatalogEngine&) = delete;
+  DatalogEngine& operator=(const DatalogEngine&) = delete;
+
+  bool Compile(std::string& error);
+
+  /**
+   * @brief Compile with join orders chosen from the statistics of
+   * `hyperbase`. Takes its shared lock.
+   */
+  bool Compile(const Hyperbase& hyperbase, std::string& error);
+
+  /**
+   * @brief Compute all derived facts from the current hyperbase state.
+   * Compiles the program first if needed; results of a previous evaluation
+   * are discarded.
+   *
+   * @param profile Filled with the execution profile if set: per stratum
+   * and rule plan the time, rounds and derived facts, per join step the
+   * rows scanned and matched and the index probed
+   */
+  bool Evaluate(const Hyperbase& hyperbase, std::string& error,
+                common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Apply base fact changes to the derived facts of the last
+   * evaluation. Changes are applied in order; inserting a present fact or
+   * removing an absent one is a no-op.
+   *
+   * @param profile Filled with the execution profile if set, as for
+   * Evaluate(); only plans seeded by the changes appear
+   */
+  bool Update(const std::vector<DatalogChange>& changes, std::string& error,
+              common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Base fact changes made by committed mutations. Reads the state
+   * after the commit, so call it under the hyperbase lock, e.g. from
+   * CommitObserver::OnCommit().
+   */
+  static void BaseChanges(const Hyperbase& hyperbase,
+                          const std::vector<const Mutation*>& mutations,
+                          std::vector<DatalogChange>& changes);
+
+  size_t FactCount(const std::string& predicate) const;
+
+  bool HasFact(const std::string& predicate,
+               const std::vector<std::string>& args) const;
+
+  void ForEachFact(
+      const std::string& predicate,
+      const std::function<void(const std::vector<std::string>&)>& fn) const;
+
+  /**
+   * @brief Store derived facts as relations. Each fact p(a, b) becomes a
+   * relation concept named "p(a, b)" in the "datalog" category, child of a
+   * relation concept "p" and with the arguments that are entities or
+   * relations as members. Facts stored before are skipped.
+   *
+   * @param hyperbase Target hyperbase
+   * @param predicates Derived predicates to store
+   * @return BatchResult of the applied mutations
+   */
+  BatchResult WriteBack(Hyperbase& hyperbase,
+                        const std::vector<std::string>& predicates) const;
+
+  // Compiled plans, one line per plan.
+  std::string Explain() const;
+
+  inline const DatalogStats& Stats() const { return mStats; }
+
+  static constexpr const char* kCategory = "datalog";
+
+private:
+  struct Predicate;
+  struct PlanStep;
+  struct RulePlan;
+  struct Stratum;
+  struct Pass;
+  struct Profiling;
+  struct Estimates;
+
+  bool CheckPredicates(std::string& error);
+  bool Stratify(std::string& error);
+  bool PlanRule(const DatalogRule& rule, int delta_atom, RulePlan& plan,
+                std::string& error);
+  // Rows a lookup of `literal` on the columns of `mask` is expected to
+  // produce, 0 without estimates.
+  double EstimateRows(const DatalogLiteral& literal, uint32_t mask) const;
+  bool LoadBaseFacts(const Hyperbase& hyperbase);
+  void PrepareIndexes(const Stratum& stratum);
+  void EvaluateStratum(Stratum& stratum);
+  void Saturate(Stratum& stratum, bool record);
+  void Recount(Stratum& stratum);
+  void Rederive(Stratum& stratum);
+  // Execute() from the first step, counted into the plan's profile if one
+  // is being taken.
+  template <typename Sink>
+  void Run(const RulePlan& plan, Pass pass, std::vector<uint32_t>& slots,
+           Sink& sink) const;
+  template <typename Sink>
+  void Execute(const RulePlan& plan, const Pass& pass, size_t step,
+               uint32_t* slots, Sink& sink) const;
+  // Operator nodes for every stratum and plan under `root`, created up
+  // front since strata run in parallel.
+  void StartProfile(common::ProfileNode& root);
+  // Copy the step counters into their nodes and drop plans that never ran.
+  void FinishProfile();
+  common::ProfileNode* StratumProfile(const Stratum& stratum) const;
+  // Access path of a plan, one arrow per step.
+  std::string PlanPath(const RulePlan& plan) const;
+  int PredicateId(const std::string& name) const;
+  std::string FactName(const Predicate& predicate,
+                       const uint32_t* tuple) const;
+
+  DatalogProgram mProgram;
+  Options mOptions;
+  bool mCompiled{false};
+  bool mEvaluated{false};
+
+  DatalogSymbols mSymbols;
+  std::vector<std::unique_ptr<Predicate>> mPredicates;
+  std::map<std::string, int> mPredicateIds;
+  std::vector<std::unique_ptr<Stratum>> mStrata;
+  // Strata per wave, in evaluation order.
+  std::vector<std::vector<Stratum*>> mWaves;
+  DatalogStats mStats;
+  // Set while Evaluate() or Update() takes a profile.
+  std::unique_ptr<Profiling> mProfiling;
+  // Set while compiling for a hyperbase.
+  std::unique_ptr<Estimates> mEstimates;
+};
+
+}  // namespace base
+}  // namespace hyperon
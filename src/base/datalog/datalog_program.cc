@@ -0,0 +1,258 @@
+#include "base/datalog/datalog_program.h"
+
+#include <fmt/core.h>
+
+#include <cctype>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+
+#include "base/core/concept_repr.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+struct Token {
+  enum TYPE { IDENT, VARIABLE, CONSTANT, PUNCT, END };
+  TYPE type{END};
+  std::string text;
+  uint32_t line{0};
+};
+
+bool is_ident_char(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool tokenize(const std::string& text, std::vector<Token>& tokens,
+              std::string& error) {
+  uint32_t line = 1;
+  size_t i = 0;
+  auto push = [&tokens, &line](Token::TYPE type, std::string value) {
+    tokens.push_back(Token{type, std::move(value), line});
+  };
+  while (i < text.size()) {
+    char c = text[i];
+    if (c == '\n') {
+      ++line;
+      ++i;
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      ++i;
+    } else if (c == '%') {
+      while (i < text.size() && text[i] != '\n') ++i;
+    } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      size_t start = i;
+      while (i < text.size() && is_ident_char(text[i])) ++i;
+      std::string word = text.substr(start, i - start);
+      bool variable = std::isupper(static_cast<unsigned char>(c)) || c == '_';
+      push(variable ? Token::VARIABLE : Token::IDENT, std::move(word));
+    } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+               (c == '-' && i + 1 < text.size() &&
+                std::isdigit(static_cast<unsigned char>(text[i + 1])))) {
+      size_t start = i++;
+      while (i < text.size() &&
+             (std::isdigit(static_cast<unsigned char>(text[i])) ||
+              (text[i] == '.' && i + 1 < text.size() &&
+               std::isdigit(static_cast<unsigned char>(text[i + 1]))))) {
+        ++i;
+      }
+      push(Token::CONSTANT, text.substr(start, i - start));
+    } else if (c == '\'' || c == '"' || c == '{') {
+      char close = c == '{' ? '}' : c;
+      uint32_t start_line = line;
+      std::string value;
+      for (++i; i < text.size() && text[i] != close; ++i) {
+        if (text[i] == '\n') ++line;
+        if (text[i] == '\\' && close != '}' && i + 1 < text.size()) ++i;
+        value.push_back(text[i]);
+      }
+      if (i == text.size()) {
+        error = fmt::format("line {}: unterminated constant", start_line);
+        return false;
+      }
+      ++i;
+      push(Token::CONSTANT, std::move(value));
+    } else if (text.compare(i, 2, ":-") == 0 ||
+               text.compare(i, 2, "\\+") == 0 ||
+               text.compare(i, 2, "!=") == 0 ||
+               text.compare(i, 2, "\\=") == 0) {
+      push(Token::PUNCT, text.substr(i, 2));
+      i += 2;
+    } else if (c == '(' || c == ')' || c == ',' || c == '.' || c == '=') {
+      push(Token::PUNCT, std::string(1, c));
+      ++i;
+    } else {
+      error = fmt::format("line {}: unexpected character '{}'", line, c);
+      return false;
+    }
+  }
+  push(Token::END, "");
+  return true;
+}
+
+class Parser {
+public:
+  Parser(const std::vector<Token>& tokens, uint32_t& anonymous)
+      : mTokens(tokens), mAnonymous(anonymous) {}
+
+  bool AtEnd() const { return Peek().type == Token::END; }
+
+  bool Clause(DatalogRule& rule, std::string& error) {
+    rule.line = Peek().line;
+    if (!Atom(rule.head, error)) return false;
+    if (Accept(":-")) {
+      do {
+        rule.body.emplace_back();
+        if (!Literal(rule.body.back(), error)) return false;
+      } while (Accept(","));
+    }
+    return Expect(".", error);
+  }
+
+private:
+  const Token& Peek(size_t ahead = 0) const {
+    size_t pos = std::min(mPos + ahead, mTokens.size() - 1);
+    return mTokens[pos];
+  }
+
+  bool Accept(const char* punct) {
+    if (Peek().type != Token::PUNCT || Peek().text != punct) return false;
+    ++mPos;
+    return true;
+  }
+
+  bool Expect(const char* punct, std::string& error) {
+    if (Accept(punct)) return true;
+    return Fail(fmt::format("expected '{}'", punct), error);
+  }
+
+  bool Fail(const std::string& what, std::string& error) const {
+    const Token& token = Peek();
+    error = fmt::format("line {}: {}, found '{}'", token.line, what,
+                        token.type == Token::END ? "end of input"
+                                                 : token.text);
+    return false;
+  }
+
+  bool Term(DatalogTerm& term, std::string& error) {
+    const Token& token = Peek();
+    if (token.type == Token::VARIABLE) {
+      term.variable = true;
+      // Every '_' is a distinct variable.
+      term.text = token.text == "_" ? fmt::format("_{}", ++mAnonymous)
+                                    : token.text;
+    } else if (token.type == Token::IDENT || token.type == Token::CONSTANT) {
+      term.variable = false;
+      term.text = token.text;
+    } else {
+      return Fail("expected a term", error);
+    }
+    ++mPos;
+    return true;
+  }
+
+  bool Atom(DatalogLiteral& atom, std::string& error) {
+    if (Peek().type != Token::IDENT) return Fail("expected a predicate", error);
+    atom.predicate = Peek().text;
+    ++mPos;
+    if (!Accept("(")) return true;
+    do {
+      atom.terms.emplace_back();
+      if (!Term(atom.terms.back(), error)) return false;
+    } while (Accept(","));
+    return Expect(")", error);
+  }
+
+  bool Literal(DatalogLiteral& literal, std::string& error) {
+    if (Accept("\\+") ||
+        (Peek().type == Token::IDENT && Peek().text == "not" &&
+         Peek(1).type == Token::IDENT)) {
+      if (Peek().text == "not") ++mPos;
+      literal.type = DatalogLiteral::NEGATED;
+      return Atom(literal, error);
+    }
+    bool comparison = Peek(1).type == Token::PUNCT &&
+                      (Peek(1).text == "=" || Peek(1).text == "!=" ||
+                       Peek(1).text == "\\=");
+    if (!comparison) return Atom(literal, error);
+
+    literal.terms.resize(2);
+    if (!Term(literal.terms[0], error)) return false;
+    literal.type = Peek().text == "=" ? DatalogLiteral::EQUAL
+                                      : DatalogLiteral::NOT_EQUAL;
+    literal.predicate = literal.type == DatalogLiteral::EQUAL ? "=" : "!=";
+    ++mPos;
+    return Term(literal.terms[1], error);
+  }
+
+  const std::vector<Token>& mTokens;
+  uint32_t& mAnonymous;
+  size_t mPos{0};
+};
+
+std::string term_string(const DatalogTerm& term) {
+  if (term.variable) return term.text;
+  bool plain = !term.text.empty() &&
+               std::islower(static_cast<unsigned char>(term.text[0]));
+  for (char c : term.text) plain = plain && is_ident_char(c);
+  return plain ? term.text : fmt::format("{{{}}}", term.text);
+}
+
+}  // namespace
+
+std::string DatalogLiteral::ToString() const {
+  if (type == EQUAL || type == NOT_EQUAL) {
+    return fmt::format("{} {} {}", term_string(terms[0]), predicate,
+                       term_string(terms[1]));
+  }
+  std::string text = type == NEGATED ? "\\+ " + predicate : predicate;
+  if (terms.empty()) return text;
+  text += '(';
+  for (size_t i = 0; i < terms.size(); ++i) {
+    if (i > 0) text += ", ";
+    text += term_string(terms[i]);
+  }
+  return text + ')';
+}
+
+std::string DatalogRule::ToString() const {
+  std::string text = head.ToString();
+  for (size_t i = 0; i < body.size(); ++i) {
+    text += i == 0 ? " :- " : ", ";
+    text += body[i].ToString();
+  }
+  return text + '.';
+}
+
+bool DatalogProgram::Parse(const std::string& text, std::string& error) {
+  std::vector<Token> tokens;
+  if (!tokenize(text, tokens, error)) return false;
+  Parser parser(tokens, mAnonymous);
+  while (!parser.AtEnd()) {
+    DatalogRule rule;
+    if (!parser.Clause(rule, error)) return false;
+    mRules.push_back(std::move(rule));
+  }
+  return true;
+}
+
+bool collect_rules(const Hyperbase& hyperbase, DatalogProgram& program,
+                   std::string& error) {
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  bool ok = true;
+  hyperbase.ForEachConcept([&](const ConceptPtr& cnpt) {
+    if (!ok || cnpt->ReprCount(ConceptRepr::MODAL_PROLOG_E) == 0) return;
+    for (const auto& repr : cnpt->GetRepr(ConceptRepr::MODAL_PROLOG_E)) {
+      if (!program.Parse(repr->ToString(), error)) {
+        error = fmt::format("rules of '{}': {}", cnpt->SemName(), error);
+        ok = false;
+        return;
+      }
+    }
+  });
+  return ok;
+}
+
+}  // namespace base
+}  // namespace hyperon
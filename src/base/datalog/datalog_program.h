@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Variable or constant argument of a literal.
+ */
+struct DatalogTerm {
+  bool variable{false};
+  std::string text;
+};
+
+/**
+ * @brief Atom, negated atom or comparison in a rule.
+ */
+struct DatalogLiteral {
+  enum TYPE {
+    ATOM,       // p(X, y)
+    NEGATED,    // \+ p(X, y) or not p(X, y)
+    EQUAL,      // X = Y
+    NOT_EQUAL,  // X != Y or X \= Y
+  };
+
+  TYPE type{ATOM};
+  std::string predicate;
+  std::vector<DatalogTerm> terms;
+
+  inline bool IsAtom() const { return type == ATOM || type == NEGATED; }
+  std::string ToString() const;
+};
+
+/**
+ * @brief Horn clause. Facts are rules with a ground head and no body.
+ */
+struct DatalogRule {
+  DatalogLiteral head;
+  std::vector<DatalogLiteral> body;
+  // Line of the rule in its source text.
+  uint32_t line{0};
+
+  std::string ToString() const;
+};
+
+/**
+ * @brief A Datalog program in Prolog syntax:
+ *
+ *   % comment
+ *   ancestor(X, Y) :- isa(X, Y).
+ *   ancestor(X, Z) :- isa(X, Y), ancestor(Y, Z).
+ *   unrelated(X, Y) :- kind(X, entity), kind(Y, entity), X != Y,
+ *                      \+ ancestor(X, Y).
+ *   likes(alice, {ice cream}).
+ *
+ * Variables start with an upper-case letter or '_', a lone '_' is
+ * anonymous. Constants are lower-case identifiers, numbers, quoted strings
+ * or Scone-style {element names}.
+ */
+class DatalogProgram {
+public:
+  /**
+   * @brief Parse clauses and append them to the program.
+   *
+   * @param text Program text
+   * @param error Error message with line number on failure
+   * @return true if the whole text was parsed.
+   */
+  bool Parse(const std::string& text, std::string& error);
+
+  inline void AddRule(const DatalogRule& rule) { mRules.push_back(rule); }
+  inline const std::vector<DatalogRule>& Rules() const { return mRules; }
+
+private:
+  std::vector<DatalogRule> mRules;
+  uint32_t mAnonymous{0};
+};
+
+/**
+ * @brief Gather the rules stored as MODAL_PROLOG_E representations of the
+ * concepts of a hyperbase. Takes the shared lock.
+ *
+ * @return false if a stored rule does not parse.
+ */
+bool collect_rules(const Hyperbase& hyperbase, DatalogProgram& program,
+                   std::string& error);
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,136 @@
+#include "base/datalog/datalog_table.h"
+
+#include <algorithm>
+
+#include "common/sketch/mix.h"
+
+namespace hyperon {
+namespace base {
+
+uint32_t DatalogSymbols::Intern(const std::string& name) {
+  auto found = mIds.find(name);
+  if (found != mIds.end()) return found->second;
+  uint32_t id = static_cast<uint32_t>(mNames.size());
+  mNames.push_back(name);
+  mIds.emplace(name, id);
+  return id;
+}
+
+bool DatalogSymbols::Find(const std::string& name, uint32_t& id) const {
+  auto found = mIds.find(name);
+  if (found == mIds.end()) return false;
+  id = found->second;
+  return true;
+}
+
+DatalogTable::DatalogTable(uint32_t arity)
+    : mArity(arity), mFullMask(arity >= 32 ? ~0u : (1u << arity) - 1) {
+  mIndexes.emplace(mFullMask, Index());
+}
+
+uint64_t DatalogTable::KeyHash(uint32_t mask, const uint32_t* tuple) const {
+  uint64_t hash = mask;
+  for (uint32_t col = 0; col < mArity; ++col) {
+    if (mask & (1u << col)) hash = common::mix64(hash ^ tuple[col]);
+  }
+  return hash;
+}
+
+bool DatalogTable::Equal(uint32_t mask, const uint32_t* a,
+                         const uint32_t* b) const {
+  for (uint32_t col = 0; col < mArity; ++col) {
+    if ((mask & (1u << col)) && a[col] != b[col]) return false;
+  }
+  return true;
+}
+
+bool DatalogTable::Insert(const uint32_t* tuple) {
+  if (mArity == 0) {
+    if (mRows > 0) return false;
+    mRows = 1;
+    return true;
+  }
+  if (Contains(tuple)) return false;
+  uint32_t row = static_cast<uint32_t>(Size());
+  mData.insert(mData.end(), tuple, tuple + mArity);
+  for (auto& kv : mIndexes) {
+    kv.second[KeyHash(kv.first, tuple)].push_back(row);
+  }
+  return true;
+}
+
+bool DatalogTable::Contains(const uint32_t* tuple) const {
+  return Find(tuple) != kNoRow;
+}
+
+size_t DatalogTable::Find(const uint32_t* tuple) const {
+  if (mArity == 0) return mRows > 0 ? 0 : kNoRow;
+  const std::vector<uint32_t>* rows = Probe(mFullMask, tuple);
+  if (!rows) return kNoRow;
+  for (uint32_t row : *rows) {
+    if (Equal(mFullMask, Row(row), tuple)) return row;
+  }
+  return kNoRow;
+}
+
+bool DatalogTable::Erase(const uint32_t* tuple) {
+  size_t row = Find(tuple);
+  if (row == kNoRow) return false;
+  if (mArity == 0) {
+    mRows = 0;
+    return true;
+  }
+  uint32_t erased = static_cast<uint32_t>(row);
+  uint32_t last = static_cast<uint32_t>(Size() - 1);
+  for (auto& kv : mIndexes) {
+    auto bucket = kv.second.find(KeyHash(kv.first, Row(erased)));
+    std::vector<uint32_t>& rows = bucket->second;
+    rows.erase(std::find(rows.begin(), rows.end(), erased));
+    if (rows.empty()) kv.second.erase(bucket);
+    if (erased == last) continue;
+    std::vector<uint32_t>& moved = kv.second[KeyHash(kv.first, Row(last))];
+    *std::find(moved.begin(), moved.end(), last) = erased;
+  }
+  if (erased != last) {
+    std::copy(Row(last), Row(last) + mArity, mData.begin() + row * mArity);
+  }
+  mData.resize(mData.size() - mArity);
+  return true;
+}
+
+void DatalogTable::Prepare(uint32_t mask) {
+  if (mask == 0 || mIndexes.count(mask)) return;
+  Index& index = mIndexes[mask];
+  for (size_t row = 0; row < Size(); ++row) {
+    index[KeyHash(mask, Row(row))].push_back(static_cast<uint32_t>(row));
+  }
+}
+
+const std::vector<uint32_t>* DatalogTable::Probe(
+    uint32_t mask, const uint32_t* tuple) const {
+  auto index = mIndexes.find(mask);
+  if (index == mIndexes.end()) return nullptr;
+  auto bucket = index->second.find(KeyHash(mask, tuple));
+  return bucket == index->second.end() ? nullptr : &bucket->second;
+}
+
+bool DatalogTable::HasIndex(uint32_t mask) const {
+  return mIndexes.count(mask) > 0;
+}
+
+void DatalogTable::InsertAll(const DatalogTable& other) {
+  if (mArity == 0) {
+    mRows = mRows || other.mRows;
+    return;
+  }
+  for (size_t row = 0; row < other.Size(); ++row) Insert(other.Row(row));
+}
+
+void DatalogTable::Clear() {
+  mData.clear();
+  mRows = 0;
+  for (auto& kv : mIndexes) kv.second.clear();
+}
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Interned constants of a Datalog evaluation. Tuples hold symbol ids
+ * instead of strings.
+ */
+class DatalogSymbols {
+public:
+  uint32_t Intern(const std::string& name);
+  bool Find(const std::string& name, uint32_t& id) const;
+  inline const std::string& Name(uint32_t id) const { return mNames[id]; }
+  inline size_t Size() const { return mNames.size(); }
+
+private:
+  std::vector<std::string> mNames;
+  std::unordered_map<std::string, uint32_t> mIds;
+};
+
+/**
+ * @brief Set of fixed-arity tuples stored row-major in one flat vector.
+ *
+ * Lookups go through hash indexes on column subsets, given as bit masks.
+ * The index on all columns exists from the start and de-duplicates rows.
+ * Other indexes are created by Prepare() and kept up to date by Insert()
+ * and Erase(). Erase() moves the last row into the erased one, so row
+ * numbers are only stable while nothing is erased. Concurrent readers are
+ * safe as long as nobody modifies the table or prepares an index.
+ */
+class DatalogTable {
+public:
+  static constexpr size_t kNoRow = static_cast<size_t>(-1);
+
+  explicit DatalogTable(uint32_t arity);
+
+  DatalogTable(const DatalogTable&) = delete;
+  DatalogTable& operator=(const DatalogTable&) = delete;
+
+  inline uint32_t Arity() const { return mArity; }
+  inline uint32_t FullMask() const { return mFullMask; }
+  inline size_t Size() const { return mArity ? mData.size() / mArity : mRows; }
+  inline bool Empty() const { return Size() == 0; }
+
+  inline const uint32_t* Row(size_t row) const {
+    return mData.data() + row * mArity;
+  }
+
+  /**
+   * @brief Add a tuple of Arity() symbols.
+   * @return false if the tuple was already present.
+   */
+  bool Insert(const uint32_t* tuple);
+
+  bool Contains(const uint32_t* tuple) const;
+
+  // Row number of `tuple`, kNoRow if absent.
+  size_t Find(const uint32_t* tuple) const;
+
+  /**
+   * @brief Remove a tuple, moving the last row into its place.
+   * @return false if the tuple was not present.
+   */
+  bool Erase(const uint32_t* tuple);
+
+  // Build the index on the columns of `mask` unless present.
+  void Prepare(uint32_t mask);
+
+  /**
+   * @brief Candidate rows matching `tuple` on the columns of `mask`. Rows of
+   * colliding keys may be included, callers compare the columns.
+   *
+   * @return nullptr if nothing matches or the index was not prepared.
+   */
+  const std::vector<uint32_t>* Probe(uint32_t mask,
+                                     const uint32_t* tuple) const;
+
+  bool HasIndex(uint32_t mask) const;
+
+  // Insert all rows of a table of the same arity.
+  void InsertAll(const DatalogTable& other);
+
+  void Clear();
+
+private:
+  using Index = std::unordered_map<uint64_t, std::vector<uint32_t>>;
+
+  uint64_t KeyHash(uint32_t mask, const uint32_t* tuple) const;
+  bool Equal(uint32_t mask, const uint32_t* a, const uint32_t* b) const;
+
+  const uint32_t mArity;
+  const uint32_t mFullMask;
+  std::vector<uint32_t> mData;
+  // Row count of nullary tables, which hold at most the empty tuple.
+  size_t mRows{0};
+  std::unordered_map<uint32_t, Index> mIndexes;
+};
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,88 @@
+#include "base/datalog/datalog_view.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace hyperon {
+namespace base {
+
+DatalogView::DatalogView(const Hyperbase& hyperbase,
+                         const DatalogProgram& program)
+    : DatalogView(hyperbase, program, DatalogEngine::Options()) {}
+
+DatalogView::DatalogView(const Hyperbase& hyperbase,
+                         const DatalogProgram& program,
+                         const DatalogEngine::Options& options)
+    : mHyperbase(hyperbase), mEngine(program, options) {}
+
+void DatalogView::OnCommit(const Hyperbase& hyperbase, uint64_t version,
+                           const std::vector<const Mutation*>& applied) {
+  PendingCommit commit{version, {}};
+  DatalogEngine::BaseChanges(hyperbase, applied, commit.changes);
+  std::lock_guard<std::mutex> lock(mPendingMutex);
+  mPending.push_back(std::move(commit));
+}
+
+bool DatalogView::Refresh(std::string& error) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (!mEvaluated) {
+    if (!mEngine.Evaluate(mHyperbase, error)) return false;
+    mEvaluated = true;
+    mVersion = mEngine.Stats().version;
+  }
+
+  std::vector<PendingCommit> pending;
+  {
+    std::lock_guard<std::mutex> pending_lock(mPendingMutex);
+    pending.swap(mPending);
+  }
+  std::vector<DatalogChange> changes;
+  uint64_t version = mVersion;
+  for (auto& commit : pending) {
+    // Commits before the evaluation are part of its base facts.
+    if (commit.version <= mVersion) continue;
+    version = std::max(version, commit.version);
+    std::move(commit.changes.begin(), commit.changes.end(),
+              std::back_inserter(changes));
+  }
+  if (version == mVersion) return true;
+  if (!mEngine.Update(changes, error)) return false;
+  mVersion = version;
+  return true;
+}
+
+uint64_t DatalogView::Version() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mVersion;
+}
+
+size_t DatalogView::PendingCommits() const {
+  std::lock_guard<std::mutex> lock(mPendingMutex);
+  return mPending.size();
+}
+
+size_t DatalogView::FactCount(const std::string& predicate) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mEngine.FactCount(predicate);
+}
+
+bool DatalogView::HasFact(const std::string& predicate,
+                          const std::vector<std::string>& args) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mEngine.HasFact(predicate, args);
+}
+
+void DatalogView::ForEachFact(
+    const std::string& predicate,
+    const std::function<void(const std::vector<std::string>&)>& fn) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  mEngine.ForEachFact(predicate, fn);
+}
+
+DatalogStats DatalogView::Stats() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  return mEngine.Stats();
+}
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/datalog/datalog_engine.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Derived facts of a Datalog program, maintained incrementally as the
+ * hyperbase changes.
+ *
+ * Commits only record their base fact changes, so writers do not wait for
+ * the maintenance. Refresh() applies the recorded changes through
+ * DatalogEngine::Update(), evaluating the program in full only the first
+ * time. Register the view with Hyperbase::AddCommitObserver() before the
+ * first Refresh() so that no commit is missed.
+ */
+class DatalogView : public CommitObserver {
+public:
+  DatalogView(const Hyperbase& hyperbase, const DatalogProgram& program);
+  DatalogView(const Hyperbase& hyperbase, const DatalogProgram& program,
+              const DatalogEngine::Options& options);
+
+  /* override */ void OnCommit(const Hyperbase& hyperbase, uint64_t version,
+                               const std::vector<const Mutation*>& applied);
+
+  /**
+   * @brief Bring the derived facts up to the last observed commit.
+   */
+  bool Refresh(std::string& error);
+
+  // Hyperbase version the derived facts reflect, 0 before Refresh().
+  uint64_t Version() const;
+
+  // Commits observed but not applied yet.
+  size_t PendingCommits() const;
+
+  size_t FactCount(const std::string& predicate) const;
+
+  bool HasFact(const std::string& predicate,
+               const std::vector<std::string>& args) const;
+
+  void ForEachFact(
+      const std::string& predicate,
+      const std::function<void(const std::vector<std::string>&)>& fn) const;
+
+  DatalogStats Stats() const;
+
+private:
+  struct PendingCommit {
+    uint64_t version;
+    std::vector<DatalogChange> changes;
+  };
+
+  const Hyperbase& mHyperbase;
+  // Guards the engine and mVersion, never held while taking the hyperbase
+  // lock from OnCommit().
+  mutable std::shared_mutex mMutex;
+  DatalogEngine mEngine;
+  bool mEvaluated{false};
+  uint64_t mVersion{0};
+
+  mutable std::mutex mPendingMutex;
+  std::vector<PendingCommit> mPending;
+};
+
+}  // namespace base
+}  // namespace hyperon
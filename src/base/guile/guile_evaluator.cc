@@ -0,0 +1,279 @@
+#include "base/guile/guile_evaluator.h"
+
+#include <fmt/core.h>
+#include <libguile.h>
+
+#include <cstdlib>
+#include <list>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "base/core/concept_repr.h"
+#include "base/guile/kb_module.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+// Module setup mutates (guile-user), which is not safe to do concurrently.
+std::mutex module_setup_mutex;
+
+std::string to_string(SCM obj) {
+  if (!scm_is_string(obj)) obj = scm_object_to_string(obj, SCM_UNDEFINED);
+  size_t len = 0;
+  char* chars = scm_to_utf8_stringn(obj, &len);
+  std::string result(chars, len);
+  free(chars);
+  return result;
+}
+
+/**
+ * @brief Arguments and outcome of a body run under scm_internal_catch.
+ * Bodies only touch SCM values, so a throw unwinding them skips no C++
+ * destructors.
+ */
+struct GuileCall {
+  SCM text{SCM_BOOL_F};
+  SCM procedure{SCM_BOOL_F};
+  SCM argument{SCM_BOOL_F};
+  SCM thrown{SCM_BOOL_F};
+};
+
+SCM compile_body(void* data) {
+  auto* call = static_cast<GuileCall*>(data);
+  SCM expression = scm_read(scm_open_input_string(call->text));
+  SCM compile = scm_c_public_ref("system base compile", "compile");
+  return scm_call_3(compile, expression, scm_from_utf8_keyword("env"),
+                    scm_current_module());
+}
+
+SCM call_body(void* data) {
+  auto* call = static_cast<GuileCall*>(data);
+  return scm_call_1(call->procedure, call->argument);
+}
+
+SCM eval_body(void* data) {
+  return scm_eval_string(static_cast<GuileCall*>(data)->text);
+}
+
+SCM catch_handler(void* data, SCM key, SCM args) {
+  static_cast<GuileCall*>(data)->thrown = scm_cons(key, args);
+  return SCM_BOOL_F;
+}
+
+SCM run_caught(scm_t_catch_body body, GuileCall& call) {
+  return scm_internal_catch(SCM_BOOL_T, body, &call, catch_handler, &call);
+}
+
+}  // namespace
+
+/**
+ * @brief Compiled procedures by expression text. Procedures are protected
+ * from the garbage collector while cached.
+ */
+struct GuileEvaluator::ProcedureCache {
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, SCM> procedures;
+
+  // Caller is in Guile mode.
+  bool Get(const std::string& expression, SCM& procedure,
+           std::string& error) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto found = procedures.find(expression);
+      if (found != procedures.end()) {
+        procedure = found->second;
+        return true;
+      }
+    }
+
+    // Compiled outside the lock, a concurrent miss compiles twice and the
+    // first insertion wins.
+    GuileCall call;
+    call.text = scm_from_utf8_stringn(expression.data(), expression.size());
+    SCM compiled = run_caught(compile_body, call);
+    if (scm_is_true(call.thrown)) {
+      error = "compile error: " + to_string(call.thrown);
+      return false;
+    }
+    if (scm_is_false(scm_procedure_p(compiled))) {
+      error = "attachment is not a procedure: " + to_string(compiled);
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto inserted = procedures.emplace(expression, compiled);
+    if (inserted.second) scm_gc_protect_object(compiled);
+    procedure = inserted.first->second;
+    return true;
+  }
+
+  // Caller is in Guile mode.
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& kv : procedures) scm_gc_unprotect_object(kv.second);
+    procedures.clear();
+  }
+};
+
+GuileEvaluator::GuileEvaluator(const HyperbasePtr& hyperbase, size_t threads)
+    : mHyperbase(hyperbase), mCache(new ProcedureCache()) {
+  if (threads == 0) threads = 1;
+  mLiveWorkers = threads;
+  for (size_t i = 0; i < threads; ++i) {
+    mWorkers.emplace_back([this] { scm_with_guile(&WorkerEntry, this); });
+  }
+}
+
+GuileEvaluator::~GuileEvaluator() {
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosing = true;
+  }
+  mQueueCv.notify_all();
+  for (auto& worker : mWorkers) worker.join();
+}
+
+bool GuileEvaluator::Attach(const std::string& cnpt,
+                            const std::string& expression,
+                            std::string& error) {
+  std::unique_lock<std::shared_mutex> lock(mHyperbase->Mutex());
+  ConceptPtr found;
+  if (!mHyperbase->GetConcept(cnpt, found)) {
+    error = fmt::format("concept '{}' does not exist", cnpt);
+    return false;
+  }
+  found->AddRepr(std::make_shared<ConceptReprGuile>(expression),
+                 ConceptRepr::MODAL_GUILE_E);
+  return true;
+}
+
+std::future<GuileResult> GuileEvaluator::Evaluate(const std::string& cnpt) {
+  return Submit(cnpt, true);
+}
+
+std::vector<GuileResult> GuileEvaluator::EvaluateBatch(
+    const std::vector<std::string>& concepts) {
+  std::vector<std::future<GuileResult>> pending;
+  pending.reserve(concepts.size());
+  for (const auto& cnpt : concepts) pending.push_back(Submit(cnpt, true));
+  std::vector<GuileResult> results;
+  results.reserve(pending.size());
+  for (auto& result : pending) results.push_back(result.get());
+  return results;
+}
+
+std::future<GuileResult> GuileEvaluator::EvaluateString(
+    const std::string& code) {
+  return Submit(code, false);
+}
+
+size_t GuileEvaluator::CachedProcedures() const {
+  std::lock_guard<std::mutex> lock(mCache->mutex);
+  return mCache->procedures.size();
+}
+
+std::future<GuileResult> GuileEvaluator::Submit(const std::string& text,
+                                                bool attachment) {
+  Task task;
+  task.text = text;
+  task.attachment = attachment;
+  std::future<GuileResult> result = task.promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQueue.push_back(std::move(task));
+  }
+  mQueueCv.notify_one();
+  return result;
+}
+
+void* GuileEvaluator::WorkerEntry(void* self) {
+  static_cast<GuileEvaluator*>(self)->RunWorker();
+  return nullptr;
+}
+
+void GuileEvaluator::RunWorker() {
+  {
+    std::lock_guard<std::mutex> lock(module_setup_mutex);
+    init_kb_module();
+    scm_set_current_module(scm_c_resolve_module("guile-user"));
+    scm_c_use_module("hyperon kb");
+  }
+  KbBinding binding(mHyperbase.get());
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (true) {
+    mQueueCv.wait(lock, [this] { return mClosing || !mQueue.empty(); });
+    if (mQueue.empty()) break;
+    Task task = std::move(mQueue.front());
+    mQueue.pop_front();
+    lock.unlock();
+
+    GuileResult result;
+    if (task.attachment) {
+      result = RunAttachment(task.text);
+    } else {
+      GuileCall call;
+      call.text = scm_from_utf8_stringn(task.text.data(), task.text.size());
+      SCM value = run_caught(eval_body, call);
+      result.ok = scm_is_false(call.thrown);
+      if (result.ok) {
+        result.value = to_string(value);
+      } else {
+        result.error = to_string(call.thrown);
+      }
+    }
+    task.promise.set_value(std::move(result));
+    lock.lock();
+  }
+  lock.unlock();
+
+  // The last worker still in Guile mode releases the cached procedures.
+  if (--mLiveWorkers == 0) mCache->Clear();
+}
+
+GuileResult GuileEvaluator::RunAttachment(const std::string& cnpt) {
+  GuileResult result;
+  std::string expression;
+  GuileCall call;
+  if (!FindExpression(cnpt, expression, result.error) ||
+      !mCache->Get(expression, call.procedure, result.error)) {
+    return result;
+  }
+
+  call.argument = scm_from_utf8_stringn(cnpt.data(), cnpt.size());
+  SCM value = run_caught(call_body, call);
+  if (scm_is_true(call.thrown)) {
+    result.error = to_string(call.thrown);
+    return result;
+  }
+  result.ok = true;
+  result.value = to_string(value);
+  return result;
+}
+
+bool GuileEvaluator::FindExpression(const std::string& cnpt,
+                                    std::string& expression,
+                                    std::string& error) const {
+  std::shared_lock<std::shared_mutex> lock(mHyperbase->Mutex());
+  ConceptPtr found;
+  if (!mHyperbase->GetConcept(cnpt, found)) {
+    error = fmt::format("concept '{}' does not exist", cnpt);
+    return false;
+  }
+  std::list<ConceptReprPtr> reprs =
+      found->GetRepr(ConceptRepr::MODAL_GUILE_E);
+  for (auto it = reprs.rbegin(); it != reprs.rend(); ++it) {
+    auto guile = cast_from_ConceptRepr<ConceptReprGuile>(*it);
+    if (guile) {
+      expression = guile->GetExpression();
+      return true;
+    }
+  }
+  error = fmt::format("concept '{}' has no Guile attachment", cnpt);
+  return false;
+}
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Outcome of one Guile evaluation. `value` is the printed result, or
+ * the string itself for string results.
+ */
+struct GuileResult {
+  bool ok{false};
+  std::string value;
+  std::string error;
+};
+
+/**
+ * @brief Runs the Guile procedural attachments (MODAL_GUILE_E
+ * representations) of the concepts of a hyperbase.
+ *
+ * The expression of an attachment evaluates to a procedure, which is called
+ * with the semantic name of the concept. Each distinct expression is compiled
+ * to bytecode once; the compiled procedure is cached and shared by all
+ * threads, so repeated evaluations only pay for the call.
+ *
+ * Evaluations run on a fixed pool of threads, each entered into Guile once
+ * for its whole lifetime, with the hyperbase bound for the procedures of
+ * (hyperon kb). Attachments and code given to EvaluateString() are evaluated
+ * in the shared (guile-user) module, so helper definitions loaded once are
+ * visible to every attachment.
+ */
+class GuileEvaluator {
+public:
+  static constexpr size_t kDefaultThreads = 4;
+
+  explicit GuileEvaluator(const HyperbasePtr& hyperbase,
+                          size_t threads = kDefaultThreads);
+  ~GuileEvaluator();
+
+  GuileEvaluator(const GuileEvaluator&) = delete;
+  GuileEvaluator& operator=(const GuileEvaluator&) = delete;
+
+  /**
+   * @brief Add a Guile attachment to a concept. Takes the exclusive lock.
+   *
+   * @param cnpt Semantic name of the concept
+   * @param expression Expression evaluating to a procedure of one argument
+   * @param error Error message on failure
+   * @return true if the concept exists.
+   */
+  bool Attach(const std::string& cnpt, const std::string& expression,
+              std::string& error);
+
+  /**
+   * @brief Call the most recently added attachment of a concept.
+   */
+  std::future<GuileResult> Evaluate(const std::string& cnpt);
+
+  /**
+   * @brief Call the attachments of many concepts, spread over the pool.
+   *
+   * @return One result per concept, in request order.
+   */
+  std::vector<GuileResult> EvaluateBatch(
+      const std::vector<std::string>& concepts);
+
+  /**
+   * @brief Evaluate top-level code, e.g. definitions used by attachments.
+   */
+  std::future<GuileResult> EvaluateString(const std::string& code);
+
+  // Number of compiled procedures in the cache.
+  size_t CachedProcedures() const;
+
+private:
+  struct Task {
+    // Concept name for attachments, code otherwise.
+    std::string text;
+    bool attachment{false};
+    std::promise<GuileResult> promise;
+  };
+  struct ProcedureCache;
+
+  static void* WorkerEntry(void* self);
+  std::future<GuileResult> Submit(const std::string& text, bool attachment);
+  void RunWorker();
+  GuileResult RunAttachment(const std::string& cnpt);
+  bool FindExpression(const std::string& cnpt, std::string& expression,
+                      std::string& error) const;
+
+  HyperbasePtr mHyperbase;
+  std::unique_ptr<ProcedureCache> mCache;
+
+  std::mutex mMutex;
+  std::condition_variable mQueueCv;
+  std::deque<Task> mQueue;
+  bool mClosing{false};
+  std::atomic<size_t> mLiveWorkers{0};
+  std::vector<std::thread> mWorkers;
+};
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,225 @@
+#include "base/guile/kb_module.h"
+
+#include <libguile.h>
+
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/query/batch_query.h"
+#include "base/query/lineage_cursor.h"
+#include "base/storage/mutation_codec.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+thread_local const Hyperbase* tls_hyperbase = nullptr;
+std::once_flag kb_module_once;
+SCM cursor_type = SCM_BOOL_F;
+
+// Guile errors unwind with longjmp and skip C++ destructors. Procedures
+// therefore convert and validate all arguments before creating any C++
+// object, run the query in a helper frame, and only raise afterwards.
+
+std::string to_string(SCM str) {
+  size_t len = 0;
+  char* chars = scm_to_utf8_stringn(str, &len);
+  std::string result(chars, len);
+  free(chars);
+  return result;
+}
+
+SCM from_string(const std::string& str) {
+  return scm_from_utf8_stringn(str.data(), str.size());
+}
+
+const Hyperbase* bound_hyperbase(const char* subr) {
+  if (!tls_hyperbase) {
+    scm_misc_error(subr, "no hyperbase bound to this thread", SCM_EOL);
+  }
+  return tls_hyperbase;
+}
+
+// Raise unless `names` is a proper list of strings.
+void check_names(SCM names, int pos, const char* subr) {
+  SCM_ASSERT_TYPE(scm_is_true(scm_list_p(names)), names, pos, subr,
+                  "list of strings");
+  for (SCM it = names; !scm_is_null(it); it = scm_cdr(it)) {
+    SCM_ASSERT_TYPE(scm_is_string(scm_car(it)), names, pos, subr,
+                    "list of strings");
+  }
+}
+
+std::vector<std::string> to_names(SCM names) {
+  std::vector<std::string> result;
+  for (SCM it = names; !scm_is_null(it); it = scm_cdr(it)) {
+    result.push_back(to_string(scm_car(it)));
+  }
+  return result;
+}
+
+SCM to_list(const std::vector<std::string>& names) {
+  SCM result = SCM_EOL;
+  for (auto it = names.rbegin(); it != names.rend(); ++it) {
+    result = scm_cons(from_string(*it), result);
+  }
+  return result;
+}
+
+SCM to_list_of_lists(const std::vector<std::vector<std::string>>& lists) {
+  SCM result = SCM_EOL;
+  for (auto it = lists.rbegin(); it != lists.rend(); ++it) {
+    result = scm_cons(to_list(*it), result);
+  }
+  return result;
+}
+
+SCM lookup(const Hyperbase& hyperbase, SCM names) {
+  std::vector<ConceptPtr> found;
+  lookup_concepts(hyperbase, to_names(names), found);
+  SCM result = SCM_EOL;
+  for (auto it = found.rbegin(); it != found.rend(); ++it) {
+    SCM kind = *it ? scm_from_utf8_symbol(
+                         concept_kind_name(concept_kind_of(*it)))
+                   : SCM_BOOL_F;
+    result = scm_cons(kind, result);
+  }
+  return result;
+}
+
+SCM walk(const Hyperbase& hyperbase, SCM names,
+         LineageCursor::DIRECTION direction, uint32_t max_depth) {
+  std::vector<std::vector<std::string>> walks;
+  walk_lineage(hyperbase, to_names(names), direction, max_depth, walks);
+  return to_list_of_lists(walks);
+}
+
+SCM members(const Hyperbase& hyperbase, SCM names) {
+  std::vector<std::vector<std::string>> lists;
+  relation_members(hyperbase, to_names(names), lists);
+  return to_list_of_lists(lists);
+}
+
+SCM next_chunk(const Hyperbase& hyperbase, LineageCursor* cursor,
+               size_t count) {
+  std::vector<std::string> chunk;
+  cursor->Next(hyperbase, count, chunk);
+  return to_list(chunk);
+}
+
+uint32_t optional_depth(SCM max_depth) {
+  if (SCM_UNBNDP(max_depth)) return 0;
+  return scm_to_uint32(max_depth);
+}
+
+SCM kb_version() {
+  return scm_from_uint64(bound_hyperbase("kb-version")->Version());
+}
+
+SCM kb_lookup(SCM names) {
+  const Hyperbase* hyperbase = bound_hyperbase("kb-lookup");
+  check_names(names, SCM_ARG1, "kb-lookup");
+  return lookup(*hyperbase, names);
+}
+
+SCM kb_parents(SCM names) {
+  const Hyperbase* hyperbase = bound_hyperbase("kb-parents");
+  check_names(names, SCM_ARG1, "kb-parents");
+  return walk(*hyperbase, names, LineageCursor::ANCESTORS, 1);
+}
+
+SCM kb_children(SCM names) {
+  const Hyperbase* hyperbase = bound_hyperbase("kb-children");
+  check_names(names, SCM_ARG1, "kb-children");
+  return walk(*hyperbase, names, LineageCursor::DESCENDANTS, 1);
+}
+
+SCM kb_ancestors(SCM names, SCM max_depth) {
+  const Hyperbase* hyperbase = bound_hyperbase("kb-ancestors");
+  check_names(names, SCM_ARG1, "kb-ancestors");
+  uint32_t depth = optional_depth(max_depth);
+  return walk(*hyperbase, names, LineageCursor::ANCESTORS, depth);
+}
+
+SCM kb_descendants(SCM names, SCM max_depth) {
+  const Hyperbase* hyperbase = bound_hyperbase("kb-descendants");
+  check_names(names, SCM_ARG1, "kb-descendants");
+  uint32_t depth = optional_depth(max_depth);
+  return walk(*hyperbase, names, LineageCursor::DESCENDANTS, depth);
+}
+
+SCM kb_members(SCM relations) {
+  const Hyperbase* hyperbase = bound_hyperbase("kb-members");
+  check_names(relations, SCM_ARG1, "kb-members");
+  return members(*hyperbase, relations);
+}
+
+void finalize_cursor(SCM cursor) {
+  delete static_cast<LineageCursor*>(scm_foreign_object_ref(cursor, 0));
+}
+
+SCM kb_query(SCM origin, SCM direction) {
+  SCM_ASSERT_TYPE(scm_is_string(origin), origin, SCM_ARG1, "kb-query",
+                  "string");
+  bool ancestors =
+      scm_is_eq(direction, scm_from_utf8_symbol("ancestors"));
+  SCM_ASSERT_TYPE(ancestors || scm_is_eq(direction, scm_from_utf8_symbol(
+                                                        "descendants")),
+                  direction, SCM_ARG2, "kb-query",
+                  "'ancestors or 'descendants");
+  auto* cursor = new LineageCursor(
+      to_string(origin),
+      ancestors ? LineageCursor::ANCESTORS : LineageCursor::DESCENDANTS);
+  return scm_make_foreign_object_1(cursor_type, cursor);
+}
+
+SCM kb_next(SCM cursor, SCM count) {
+  const Hyperbase* hyperbase = bound_hyperbase("kb-next");
+  scm_assert_foreign_object_type(cursor_type, cursor);
+  size_t n = scm_to_size_t(count);
+  auto* walk = static_cast<LineageCursor*>(scm_foreign_object_ref(cursor, 0));
+  return next_chunk(*hyperbase, walk, n);
+}
+
+void define_kb_module(void*) {
+  cursor_type = scm_make_foreign_object_type(
+      scm_from_utf8_symbol("kb-cursor"),
+      scm_list_1(scm_from_utf8_symbol("walk")), finalize_cursor);
+  scm_gc_protect_object(cursor_type);
+
+  auto subr = [](const char* name, int req, int opt, scm_t_subr fn) {
+    scm_c_define_gsubr(name, req, opt, 0, fn);
+    scm_c_export(name, nullptr);
+  };
+  subr("kb-version", 0, 0, reinterpret_cast<scm_t_subr>(kb_version));
+  subr("kb-lookup", 1, 0, reinterpret_cast<scm_t_subr>(kb_lookup));
+  subr("kb-parents", 1, 0, reinterpret_cast<scm_t_subr>(kb_parents));
+  subr("kb-children", 1, 0, reinterpret_cast<scm_t_subr>(kb_children));
+  subr("kb-ancestors", 1, 1, reinterpret_cast<scm_t_subr>(kb_ancestors));
+  subr("kb-descendants", 1, 1,
+       reinterpret_cast<scm_t_subr>(kb_descendants));
+  subr("kb-members", 1, 0, reinterpret_cast<scm_t_subr>(kb_members));
+  subr("kb-query", 2, 0, reinterpret_cast<scm_t_subr>(kb_query));
+  subr("kb-next", 2, 0, reinterpret_cast<scm_t_subr>(kb_next));
+}
+
+}  // namespace
+
+void init_kb_module() {
+  std::call_once(kb_module_once, [] {
+    scm_c_define_module("hyperon kb", define_kb_module, nullptr);
+  });
+}
+
+KbBinding::KbBinding(const Hyperbase* hyperbase)
+    : mPrevious(tls_hyperbase) {
+  tls_hyperbase = hyperbase;
+}
+
+KbBinding::~KbBinding() { tls_hyperbase = mPrevious; }
+
+}  // namespace base
+}  // namespace hyperon
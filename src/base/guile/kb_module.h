@@ -0,0 +1,47 @@
+#pragma once
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Define the Guile module (hyperon kb), which exposes the hyperbase
+ * bound to the calling thread through bulk procedures. Every procedure
+ * takes a list of names and answers for all of them in one call, under a
+ * single shared lock, so Scheme code crosses the FFI once per batch rather
+ * than once per concept:
+ *
+ *   (kb-version)                        version of the bound hyperbase
+ *   (kb-lookup names)                   kind symbol per name, #f if unknown
+ *   (kb-parents names)                  direct parents per name
+ *   (kb-children names)                 direct children per name
+ *   (kb-ancestors names [max-depth])    transitive ancestors per name
+ *   (kb-descendants names [max-depth])  transitive descendants per name
+ *   (kb-members relations)              members per relation
+ *   (kb-query origin direction)         cursor over 'ancestors or
+ *                                       'descendants of origin
+ *   (kb-next cursor count)              next names of a cursor, '() at end
+ *
+ * Must be called in Guile mode. Safe to call more than once.
+ */
+void init_kb_module();
+
+/**
+ * @brief Binds a hyperbase to the calling thread for the procedures of
+ * (hyperon kb) while in scope.
+ */
+class KbBinding {
+public:
+  explicit KbBinding(const Hyperbase* hyperbase);
+  ~KbBinding();
+
+  KbBinding(const KbBinding&) = delete;
+  KbBinding& operator=(const KbBinding&) = delete;
+
+private:
+  const Hyperbase* mPrevious;
+};
+
+}  // namespace base
+}  // namespace hyperon
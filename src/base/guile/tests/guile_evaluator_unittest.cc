@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/guile/guile_evaluator.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation isa(const std::string& cnpt, std::vector<std::string> parents) {
+  Mutation mut;
+  mut.kind = Mutation::MUT_ADD_CONCEPT;
+  mut.subject = cnpt;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+// animal <- bird <- {robin, penguin}.
+class GuileEvaluatorTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mHyperbase->ApplyBatch({isa("animal", {}), isa("bird", {"animal"}),
+                            isa("robin", {"bird"}),
+                            isa("penguin", {"bird"})});
+  }
+
+  void Attach(const std::string& cnpt, const std::string& expression) {
+    std::string error;
+    ASSERT_TRUE(mEvaluator.Attach(cnpt, expression, error)) << error;
+  }
+
+  // Printed value of `code`, or the error prefixed by "error: ".
+  std::string Eval(const std::string& code) {
+    GuileResult result = mEvaluator.EvaluateString(code).get();
+    return result.ok ? result.value : "error: " + result.error;
+  }
+
+  HyperbasePtr mHyperbase = std::make_shared<Hyperbase>("guile");
+  GuileEvaluator mEvaluator{mHyperbase, 2};
+};
+
+TEST_F(GuileEvaluatorTest, AnswersBatchProceduresPerName) {
+  EXPECT_EQ(Eval("(kb-lookup '(\"robin\" \"unicorn\"))"), "(concept #f)");
+  EXPECT_EQ(Eval("(kb-parents '(\"robin\" \"bird\" \"unicorn\"))"),
+            "((\"bird\") (\"animal\") ())");
+  // Siblings come in no particular order.
+  EXPECT_EQ(Eval("(sort (car (kb-children '(\"bird\"))) string<?)"),
+            "(\"penguin\" \"robin\")");
+  EXPECT_EQ(Eval("(kb-ancestors '(\"robin\") 2)"),
+            "((\"bird\" \"animal\"))");
+  EXPECT_EQ(Eval("(let ((walk (car (kb-descendants '(\"animal\")))))"
+                 "  (cons (car walk) (sort (cdr walk) string<?)))"),
+            "(\"bird\" \"penguin\" \"robin\")");
+  EXPECT_EQ(Eval("(kb-version)"), std::to_string(mHyperbase->Version()));
+}
+
+TEST_F(GuileEvaluatorTest, PagesThroughCursors) {
+  EXPECT_EQ(Eval("(let* ((walk (kb-query \"animal\" 'descendants))"
+                 "       (pages (list (kb-next walk 2) (kb-next walk 2)"
+                 "                    (kb-next walk 2))))"
+                 "  (list (map length pages)"
+                 "        (sort (apply append pages) string<?)))"),
+            "((2 1 0) (\"bird\" \"penguin\" \"robin\"))");
+}
+
+TEST_F(GuileEvaluatorTest, RaisesOnBadArguments) {
+  EXPECT_NE(Eval("(kb-parents \"robin\")").find("error: "),
+            std::string::npos);
+  EXPECT_NE(Eval("(kb-lookup '(robin))").find("error: "), std::string::npos);
+  EXPECT_NE(Eval("(kb-query \"robin\" 'sideways)").find("error: "),
+            std::string::npos);
+  // The worker survives the errors.
+  EXPECT_EQ(Eval("(+ 1 2)"), "3");
+}
+
+TEST_F(GuileEvaluatorTest, CompilesEachExpressionOnce) {
+  const std::string shout = "(lambda (name) (string-append name \"!\"))";
+  Attach("robin", shout);
+  Attach("penguin", shout);
+  Attach("bird", "(lambda (name) (length (car (kb-children (list name)))))");
+  EXPECT_EQ(mEvaluator.CachedProcedures(), 0u);
+
+  std::vector<GuileResult> results =
+      mEvaluator.EvaluateBatch({"robin", "bird", "penguin", "robin"});
+  ASSERT_EQ(results.size(), 4u);
+  for (const auto& result : results) EXPECT_TRUE(result.ok) << result.error;
+  EXPECT_EQ(results[0].value, "robin!");
+  EXPECT_EQ(results[1].value, "2");
+  EXPECT_EQ(results[2].value, "penguin!");
+  EXPECT_EQ(results[3].value, "robin!");
+  EXPECT_EQ(mEvaluator.CachedProcedures(), 2u);
+
+  // The most recent attachment wins.
+  Attach("robin", "(lambda (name) 'replaced)");
+  EXPECT_EQ(mEvaluator.Evaluate("robin").get().value, "replaced");
+  EXPECT_EQ(mEvaluator.CachedProcedures(), 3u);
+}
+
+TEST_F(GuileEvaluatorTest, SharesDefinitionsAcrossWorkers) {
+  EXPECT_TRUE(mEvaluator
+                  .EvaluateString("(define (shout name) (string-upcase name))")
+                  .get()
+                  .ok);
+  Attach("robin", "(lambda (name) (shout name))");
+  Attach("penguin", "(lambda (name) (shout name))");
+  std::vector<std::string> batch(16, "robin");
+  batch.push_back("penguin");
+  for (const auto& result : mEvaluator.EvaluateBatch(batch)) {
+    ASSERT_TRUE(result.ok) << result.error;
+  }
+  EXPECT_EQ(mEvaluator.Evaluate("penguin").get().value, "PENGUIN");
+}
+
+TEST_F(GuileEvaluatorTest, ReportsFailingAttachments) {
+  std::string error;
+  EXPECT_FALSE(mEvaluator.Attach("unicorn", "(lambda (n) n)", error));
+  EXPECT_EQ(error, "concept 'unicorn' does not exist");
+
+  GuileResult missing = mEvaluator.Evaluate("animal").get();
+  EXPECT_FALSE(missing.ok);
+  EXPECT_EQ(missing.error, "concept 'animal' has no Guile attachment");
+
+  Attach("robin", "42");
+  GuileResult constant = mEvaluator.Evaluate("robin").get();
+  EXPECT_FALSE(constant.ok);
+  EXPECT_EQ(constant.error, "attachment is not a procedure: 42");
+
+  Attach("robin", "(lambda (n");
+  EXPECT_EQ(mEvaluator.Evaluate("robin").get().error.find("compile error"),
+            0u);
+
+  Attach("penguin", "(lambda (n) (error \"cannot fly\" n))");
+  GuileResult thrown = mEvaluator.Evaluate("penguin").get();
+  EXPECT_FALSE(thrown.ok);
+  EXPECT_NE(thrown.error.find("cannot fly"), std::string::npos);
+  // Failed compilations are not cached.
+  EXPECT_EQ(mEvaluator.CachedProcedures(), 1u);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
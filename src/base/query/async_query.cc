@@ -0,0 +1,72 @@
+#include "base/query/async_query.h"
+
+#include <mutex>
+#include <utility>
+
+#include "base/query/batch_query.h"
+
+namespace hyperon {
+namespace base {
+
+common::Task<ConceptsResult> lookup_concepts_async(
+    HyperbasePtr hyperbase, std::vector<std::string> names,
+    common::Executor& executor) {
+  std::shared_mutex& mutex = hyperbase->Mutex();
+  return common::run_shared_async(
+      executor, mutex,
+      [hyperbase = std::move(hyperbase), names = std::move(names)](
+          std::shared_lock<std::shared_mutex>& lock) {
+        ConceptsResult result;
+        result.found =
+            lookup_concepts(*hyperbase, names, result.concepts, lock);
+        return result;
+      });
+}
+
+common::Task<ListsResult> walk_lineage_async(
+    HyperbasePtr hyperbase, std::vector<std::string> origins,
+    LineageCursor::DIRECTION direction, uint32_t max_depth,
+    common::Executor& executor) {
+  std::shared_mutex& mutex = hyperbase->Mutex();
+  return common::run_shared_async(
+      executor, mutex,
+      [hyperbase = std::move(hyperbase), origins = std::move(origins),
+       direction, max_depth](std::shared_lock<std::shared_mutex>& lock) {
+        ListsResult result;
+        result.found = walk_lineage(*hyperbase, origins, direction, max_depth,
+                                    result.lists, lock);
+        return result;
+      });
+}
+
+common::Task<ListsResult> relation_members_async(
+    HyperbasePtr hyperbase, std::vector<std::string> relations,
+    common::Executor& executor) {
+  std::shared_mutex& mutex = hyperbase->Mutex();
+  return common::run_shared_async(
+      executor, mutex,
+      [hyperbase = std::move(hyperbase), relations = std::move(relations)](
+          std::shared_lock<std::shared_mutex>& lock) {
+        ListsResult result;
+        result.found =
+            relation_members(*hyperbase, relations, result.lists, lock);
+        return result;
+      });
+}
+
+common::Task<NamesResult> common_children_async(
+    HyperbasePtr hyperbase, std::vector<std::string> types,
+    common::Executor& executor) {
+  std::shared_mutex& mutex = hyperbase->Mutex();
+  return common::run_shared_async(
+      executor, mutex,
+      [hyperbase = std::move(hyperbase), types = std::move(types)](
+          std::shared_lock<std::shared_mutex>& lock) {
+        NamesResult result;
+        result.found = common_children(*hyperbase, types, result.names, lock);
+        return result;
+      });
+}
+
+}  // namespace base
+}  // namespace hyperon
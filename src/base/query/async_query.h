@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/lineage_cursor.h"
+#include "common/async/task.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Result of lookup_concepts_async(), as lookup_concepts().
+ */
+struct ConceptsResult {
+  size_t found{0};
+  std::vector<ConceptPtr> concepts;
+};
+
+/**
+ * @brief Result of the list-per-name queries, as walk_lineage() and
+ * relation_members().
+ */
+struct ListsResult {
+  size_t found{0};
+  std::vector<std::vector<std::string>> lists;
+};
+
+/**
+ * @brief Result of common_children_async(), as common_children().
+ */
+struct NamesResult {
+  size_t found{0};
+  std::vector<std::string> names;
+};
+
+/*
+ * Batch queries run on an executor, for callers that must not block on the
+ * hyperbase lock. While a batch is being applied the query is posted again
+ * instead of parking an executor thread on the lock, see
+ * common::run_shared_async(). Each task holds on to the hyperbase until it
+ * completes.
+ */
+
+common::Task<ConceptsResult> lookup_concepts_async(
+    HyperbasePtr hyperbase, std::vector<std::string> names,
+    common::Executor& executor = common::Executor::Default());
+
+common::Task<ListsResult> walk_lineage_async(
+    HyperbasePtr hyperbase, std::vector<std::string> origins,
+    LineageCursor::DIRECTION direction, uint32_t max_depth,
+    common::Executor& executor = common::Executor::Default());
+
+common::Task<ListsResult> relation_members_async(
+    HyperbasePtr hyperbase, std::vector<std::string> relations,
+    common::Executor& executor = common::Executor::Default());
+
+common::Task<NamesResult> common_children_async(
+    HyperbasePtr hyperbase, std::vector<std::string> types,
+    common::Executor& executor = common::Executor::Default());
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,279 @@
+#include "base/query/batch_query.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+#include <utility>
+
+#include "base/core/relation.h"
+
+namespace hyperon {
+namespace base {
+
+using common::profile_child;
+using common::ProfileNode;
+using common::ProfileTimer;
+
+size_t lookup_concepts(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& names,
+                       std::vector<ConceptPtr>& out, ProfileNode* profile) {
+  std::shared_lock<std::shared_mutex> lock;
+  return lookup_concepts(hyperbase, names, out, lock, profile);
+}
+
+size_t lookup_concepts(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& names,
+                       std::vector<ConceptPtr>& out,
+                       std::shared_lock<std::shared_mutex>& lock,
+                       ProfileNode* profile) {
+  if (profile) *profile = ProfileNode("lookup_concepts");
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileNode* index = profile_child(profile, "concept_index", "", "hash");
+
+  size_t found = 0;
+  out.reserve(out.size() + names.size());
+  ProfileTimer wait_timer(wait);
+  if (!lock.owns_lock()) {
+    lock = std::shared_lock<std::shared_mutex>(hyperbase.Mutex());
+  }
+  wait_timer.Stop();
+  ProfileTimer index_timer(index);
+  for (const auto& name : names) {
+    ConceptPtr cnpt;
+    if (hyperbase.GetConcept(name, cnpt)) ++found;
+    out.push_back(std::move(cnpt));
+  }
+  if (profile) {
+    profile->loops = index->loops = 1;
+    profile->rows_in = index->rows_in = names.size();
+    profile->rows_out = index->rows_out = found;
+  }
+  return found;
+}
+
+size_t walk_lineage(const Hyperbase& hyperbase,
+                    const std::vector<std::string>& origins,
+                    LineageCursor::DIRECTION direction, uint32_t max_depth,
+                    std::vector<std::vector<std::string>>& out,
+                    ProfileNode* profile) {
+  std::shared_lock<std::shared_mutex> lock;
+  return walk_lineage(hyperbase, origins, direction, max_depth, out, lock,
+                      profile);
+}
+
+size_t walk_lineage(const Hyperbase& hyperbase,
+                    const std::vector<std::string>& origins,
+                    LineageCursor::DIRECTION direction, uint32_t max_depth,
+                    std::vector<std::vector<std::string>>& out,
+                    std::shared_lock<std::shared_mutex>& lock,
+                    ProfileNode* profile) {
+  bool descend = direction == LineageCursor::DESCENDANTS;
+  if (profile) {
+    *profile = ProfileNode(
+        "walk_lineage", descend ? "descendants" : "ancestors");
+    if (max_depth > 0) profile->detail += fmt::format(", depth {}", max_depth);
+  }
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileNode* bfs = profile_child(profile, "lineage_bfs", "",
+                                   descend ? "children" : "parents");
+  // Untimed: a clock read per lookup would cost as much as the lookup.
+  ProfileNode* index = profile_child(bfs, "concept_index", "", "hash");
+  uint64_t edges = 0;
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+
+  size_t found = 0;
+  size_t produced = 0;
+  out.reserve(out.size() + origins.size());
+  std::unordered_set<std::string> visited;
+  // Frontier entries carry the depth they were discovered at.
+  std::deque<std::pair<ConceptPtr, uint32_t>> frontier;
+
+  ProfileTimer wait_timer(wait);
+  if (!lock.owns_lock()) {
+    lock = std::shared_lock<std::shared_mutex>(hyperbase.Mutex());
+  }
+  wait_timer.Stop();
+  ProfileTimer bfs_timer(bfs);
+  for (const auto& origin : origins) {
+    out.emplace_back();
+    ConceptPtr cnpt;
+    ++lookups;
+    if (!hyperbase.GetConcept(origin, cnpt)) continue;
+    ++found;
+
+    std::vector<std::string>& walk = out.back();
+    visited.clear();
+    visited.insert(origin);
+    frontier.emplace_back(std::move(cnpt), 0);
+    while (!frontier.empty()) {
+      ConceptPtr current = std::move(frontier.front().first);
+      uint32_t depth = frontier.front().second;
+      frontier.pop_front();
+      if (max_depth > 0 && depth >= max_depth) continue;
+      auto discover = [&](const ElementPtr& next) {
+        ++edges;
+        std::string name = next->SemName();
+        if (!visited.insert(name).second) return;
+        ConceptPtr found_cnpt;
+        ++lookups;
+        if (hyperbase.GetConcept(name, found_cnpt)) {
+          ++hits;
+          frontier.emplace_back(std::move(found_cnpt), depth + 1);
+        }
+        walk.push_back(std::move(name));
+      };
+      if (descend) {
+        current->ForEachChild(discover);
+      } else {
+        current->ForEachParent(discover);
+      }
+    }
+    produced += walk.size();
+  }
+  if (profile) {
+    profile->loops = 1;
+    profile->rows_in = origins.size();
+    profile->rows_out = produced;
+    bfs->loops = found;
+    bfs->rows_in = edges;
+    bfs->rows_out = produced;
+    index->loops = 1;
+    index->rows_in = lookups;
+    index->rows_out = hits + found;
+  }
+  return found;
+}
+
+size_t relation_members(const Hyperbase& hyperbase,
+                        const std::vector<std::string>& relations,
+                        std::vector<std::vector<std::string>>& out,
+                        ProfileNode* profile) {
+  std::shared_lock<std::shared_mutex> lock;
+  return relation_members(hyperbase, relations, out, lock, profile);
+}
+
+size_t relation_members(const Hyperbase& hyperbase,
+                        const std::vector<std::string>& relations,
+                        std::vector<std::vector<std::string>>& out,
+                        std::shared_lock<std::shared_mutex>& lock,
+                        ProfileNode* profile) {
+  if (profile) *profile = ProfileNode("relation_members");
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileNode* members_node = profile_child(profile, "members", "", "hash");
+
+  size_t found = 0;
+  size_t produced = 0;
+  out.reserve(out.size() + relations.size());
+  ProfileTimer wait_timer(wait);
+  if (!lock.owns_lock()) {
+    lock = std::shared_lock<std::shared_mutex>(hyperbase.Mutex());
+  }
+  wait_timer.Stop();
+  ProfileTimer members_timer(members_node);
+  for (const auto& name : relations) {
+    out.emplace_back();
+    ConceptPtr cnpt;
+    if (!hyperbase.GetConcept(name, cnpt) || !cnpt->IsRelation()) continue;
+    ++found;
+    std::vector<std::string>& members = out.back();
+    std::static_pointer_cast<Relation>(cnpt)->ForEachMember(
+        [&members](const ConceptPtr& member) {
+          members.push_back(member->SemName());
+        });
+    produced += members.size();
+  }
+  if (profile) {
+    profile->loops = members_node->loops = 1;
+    profile->rows_in = relations.size();
+    profile->rows_out = members_node->rows_out = produced;
+    members_node->rows_in = found;
+  }
+  return found;
+}
+
+size_t common_children(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& types,
+                       std::vector<std::string>& out, ProfileNode* profile) {
+  std::shared_lock<std::shared_mutex> lock;
+  return common_children(hyperbase, types, out, lock, profile);
+}
+
+size_t common_children(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& types,
+                       std::vector<std::string>& out,
+                       std::shared_lock<std::shared_mutex>& lock,
+                       ProfileNode* profile) {
+  if (profile) {
+    *profile = ProfileNode("common_children", fmt::format("{} types",
+                                                          types.size()));
+  }
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileNode* index = profile_child(profile, "concept_index", "", "hash");
+  ProfileNode* sets = profile_child(profile, "intersect", "", "child_ids");
+  ProfileNode* names = profile_child(profile, "children", "", "dense_ids");
+
+  ProfileTimer wait_timer(wait);
+  if (!lock.owns_lock()) {
+    lock = std::shared_lock<std::shared_mutex>(hyperbase.Mutex());
+  }
+  wait_timer.Stop();
+  ProfileTimer index_timer(index);
+  std::vector<ConceptPtr> found;
+  found.reserve(types.size());
+  for (const auto& name : types) {
+    ConceptPtr cnpt;
+    if (!hyperbase.GetConcept(name, cnpt)) break;
+    found.push_back(std::move(cnpt));
+  }
+  index_timer.Stop();
+  if (profile) {
+    profile->loops = index->loops = 1;
+    profile->rows_in = index->rows_in = types.size();
+    index->rows_out = found.size();
+  }
+  if (found.empty() || found.size() < types.size()) return 0;
+
+  // Smallest first keeps every intermediate set small.
+  std::sort(found.begin(), found.end(),
+            [](const ConceptPtr& a, const ConceptPtr& b) {
+              return a->ChildCount() < b->ChildCount();
+            });
+  ProfileTimer sets_timer(sets);
+  // Not charged to the hyperbase, unlike the sets it copies.
+  UnionSplitLineage::IdSet common;
+  common = found[0]->ChildIds();
+  uint64_t examined = common.Size();
+  for (size_t i = 1; i < found.size() && !common.Empty(); ++i) {
+    examined += found[i]->ChildIds().Size();
+    UnionSplitLineage::IdSet::Intersect(common, found[i]->ChildIds(), common);
+  }
+  sets_timer.Stop();
+
+  ProfileTimer names_timer(names);
+  size_t before = out.size();
+  out.reserve(before + common.Size());
+  hyperbase.ForEachElementIn(common, [&out](const Element& child) {
+    out.push_back(child.SemName());
+  });
+  size_t produced = out.size() - before;
+  if (profile) {
+    sets->loops = names->loops = 1;
+    sets->rows_in = examined;
+    sets->rows_out = names->rows_out = produced;
+    names->rows_in = common.Size();
+    profile->rows_out = produced;
+  }
+  return produced;
+}
+
+}  // namespace base
+}  // namespace hyperon
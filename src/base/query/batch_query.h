@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/lineage_cursor.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Look up many concepts under a single shared lock.
+ *
+ * @param hyperbase Hyperbase to read
+ * @param names Semantic names
+ * @param out One entry per name, nullptr for unknown names
+ * @param profile Filled with the execution profile if set
+ * @return size_t Number of names found
+ */
+size_t lookup_concepts(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& names,
+                       std::vector<ConceptPtr>& out,
+                       common::ProfileNode* profile = nullptr);
+
+/**
+ * @brief Lineage walks from many origins under a single shared lock.
+ *
+ * @param hyperbase Hyperbase to read
+ * @param origins Semantic names to start from
+ * @param direction Walk towards descendants or ancestors
+ * @param max_depth Levels to follow, 1 for direct lineage, 0 for unbounded
+ * @param out One list per origin in breadth-first order, excluding the
+ * origin itself; empty for unknown origins
+ * @param profile Filled with the execution profile if set
+ * @return size_t Number of origins found
+ */
+size_t walk_lineage(const Hyperbase& hyperbase,
+                    const std::vector<std::string>& origins,
+                    LineageCursor::DIRECTION direction, uint32_t max_depth,
+                    std::vector<std::vector<std::string>>& out,
+                    common::ProfileNode* profile = nullptr);
+
+/**
+ * @brief Members of many relations under a single shared lock.
+ *
+ * @param out One list per name, empty for unknown names or non-relations
+ * @return size_t Number of relations found
+ */
+size_t relation_members(const Hyperbase& hyperbase,
+                        const std::vector<std::string>& relations,
+                        std::vector<std::vector<std::string>>& out,
+                        common::ProfileNode* profile = nullptr);
+
+/**
+ * @brief Type intersection: the concepts that are direct children of all
+ * given types, e.g. {person} and {musician}, under a single shared lock.
+ * The child id sets are intersected smallest first, and only the common
+ * children are visited to name the result.
+ *
+ * @param types Semantic names of the types
+ * @param out Names of the common children are appended, in no order
+ * @return size_t Number of common children, 0 if a type is unknown
+ */
+size_t common_children(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& types,
+                       std::vector<std::string>& out,
+                       common::ProfileNode* profile = nullptr);
+
+/*
+ * The same queries under a shared lock of the hyperbase the caller may
+ * already hold, e.g. one taken without blocking, see
+ * common::run_shared_async(). They take `lock` if it is not owned.
+ */
+
+size_t lookup_concepts(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& names,
+                       std::vector<ConceptPtr>& out,
+                       std::shared_lock<std::shared_mutex>& lock,
+                       common::ProfileNode* profile = nullptr);
+
+size_t walk_lineage(const Hyperbase& hyperbase,
+                    const std::vector<std::string>& origins,
+                    LineageCursor::DIRECTION direction, uint32_t max_depth,
+                    std::vector<std::vector<std::string>>& out,
+                    std::shared_lock<std::shared_mutex>& lock,
+                    common::ProfileNode* profile = nullptr);
+
+size_t relation_members(const Hyperbase& hyperbase,
+                        const std::vector<std::string>& relations,
+                        std::vector<std::vector<std::string>>& out,
+                        std::shared_lock<std::shared_mutex>& lock,
+                        common::ProfileNode* profile = nullptr);
+
+size_t common_children(const Hyperbase& hyperbase,
+                       const std::vector<std::string>& types,
+                       std::vector<std::string>& out,
+                       std::shared_lock<std::shared_mutex>& lock,
+                       common::ProfileNode* profile = nullptr);
+
+}  // namespace base
+}  // namespace hyperon
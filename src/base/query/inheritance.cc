@@ -0,0 +1,423 @@
+#include "base/query/inheritance.h"
+
+#include <fmt/core.h>
+
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "base/storage/scone_loader.h"
+#include "common/metrics/metrics.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+// Dependency lists are pruned of stale stamps when they reach a power of
+// two at least this long.
+constexpr size_t kPruneLength = 64;
+
+const common::Counter kCacheHits("hyperon_cache_lookups_total",
+                                 "Lookups of memoizing caches.",
+                                 "cache=\"inheritance\",result=\"hit\"");
+const common::Counter kCacheMisses("hyperon_cache_lookups_total",
+                                   "Lookups of memoizing caches.",
+                                   "cache=\"inheritance\",result=\"miss\"");
+const common::Counter kCacheInvalidations(
+    "hyperon_cache_invalidations_total",
+    "Entries dropped from memoizing caches by changes.",
+    "cache=\"inheritance\"");
+
+}  // namespace
+
+InheritanceResolver::InheritanceResolver(const Hyperbase& hyperbase)
+    : mHyperbase(hyperbase) {}
+
+void InheritanceResolver::OnCommit(
+    const Hyperbase&, uint64_t, const std::vector<const Mutation*>& applied) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (mCache.empty()) return;
+  for (const Mutation* mut : applied) {
+    switch (mut->kind) {
+      case Mutation::MUT_ADD_PARENT:
+      case Mutation::MUT_REMOVE_PARENT:
+      case Mutation::MUT_ADD_UNION:
+        Invalidate(mut->subject);
+        break;
+      case Mutation::MUT_ADD_SPLIT:
+        for (const auto& child : mut->objects) Invalidate(child);
+        break;
+      default:
+        // New concepts have no entries yet, members are not inherited.
+        break;
+    }
+  }
+}
+
+void InheritanceResolver::DeclareRole(const std::string& role,
+                                      const std::string& owner) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  auto found = mOwners.find(role);
+  if (found != mOwners.end()) {
+    if (found->second == owner) return;
+    mAssertions[found->second].roles.erase(role);
+  }
+  mOwners[role] = owner;
+  mAssertions[owner].roles.insert(role);
+  InvalidateRole(role);
+}
+
+void InheritanceResolver::AddIsNotA(const std::string& cnpt,
+                                    const std::string& type) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (mAssertions[cnpt].not_a.insert(type).second) Invalidate(cnpt);
+}
+
+bool InheritanceResolver::RemoveIsNotA(const std::string& cnpt,
+                                       const std::string& type) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  auto found = mAssertions.find(cnpt);
+  if (found == mAssertions.end() || !found->second.not_a.erase(type)) {
+    return false;
+  }
+  Invalidate(cnpt);
+  return true;
+}
+
+void InheritanceResolver::SetValue(const std::string& owner,
+                                   const std::string& role,
+                                   const std::string& value) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  std::string& current = mAssertions[owner].values[role];
+  if (current == value) return;
+  current = value;
+  Invalidate(owner, role);
+}
+
+bool InheritanceResolver::ClearValue(const std::string& owner,
+                                     const std::string& role) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  auto found = mAssertions.find(owner);
+  if (found == mAssertions.end() || !found->second.values.erase(role)) {
+    return false;
+  }
+  Invalidate(owner, role);
+  return true;
+}
+
+void InheritanceResolver::SetType(const std::string& owner,
+                                  const std::string& role,
+                                  const std::string& type) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  std::string& current = mAssertions[owner].types[role];
+  if (current == type) return;
+  current = type;
+  Invalidate(owner, role);
+}
+
+bool InheritanceResolver::ClearType(const std::string& owner,
+                                    const std::string& role) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  auto found = mAssertions.find(owner);
+  if (found == mAssertions.end() || !found->second.types.erase(role)) {
+    return false;
+  }
+  Invalidate(owner, role);
+  return true;
+}
+
+bool InheritanceResolver::Resolve(const std::string& cnpt,
+                                  const std::string& role,
+                                  RoleValue& result,
+                                  common::ProfileNode* profile) {
+  if (profile) {
+    *profile =
+        common::ProfileNode("resolve_role", fmt::format("{}, {}", cnpt, role));
+    profile->loops = profile->rows_in = 1;
+  }
+  common::ProfileTimer timer(profile);
+  common::ProfileNode* memo =
+      common::profile_child(profile, "memo_cache", "", "hash");
+  {
+    common::ProfileTimer memo_timer(memo);
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    auto found = mCache.find(cnpt);
+    if (found != mCache.end()) {
+      auto entry = found->second.find(role);
+      if (entry != found->second.end()) {
+        mHits.fetch_add(1, std::memory_order_relaxed);
+        kCacheHits.Add();
+        result = entry->second.value;
+        if (profile) {
+          profile->cache_hits = memo->cache_hits = 1;
+          profile->rows_out = memo->rows_out = 1;
+        }
+        return true;
+      }
+    }
+  }
+  mMisses.fetch_add(1, std::memory_order_relaxed);
+  kCacheMisses.Add();
+  if (profile) profile->cache_misses = memo->cache_misses = 1;
+
+  common::ProfileNode* wait = common::profile_child(profile, "lock_wait");
+  common::ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> hyperbase_lock(mHyperbase.Mutex());
+  wait_timer.Stop();
+  ConceptPtr origin;
+  if (!mHyperbase.GetConcept(cnpt, origin)) return false;
+  std::vector<std::string> visited;
+  uint64_t epoch;
+  {
+    common::ProfileNode* walk =
+        common::profile_child(profile, "inheritance_walk", "", "parents");
+    common::ProfileTimer walk_timer(walk);
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    epoch = mEpoch;
+    Walk(origin, role, result, visited, walk);
+  }
+  if (profile) profile->rows_out = 1;
+
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  if (epoch != mEpoch) return true;
+  // A concurrent miss may have cached the same result already.
+  auto slot = mCache[cnpt].emplace(role, Entry{result, mStamp + 1});
+  if (!slot.second) return true;
+  uint64_t stamp = ++mStamp;
+  ++mEntries;
+  for (const auto& name : visited) {
+    std::vector<Dependent>& dependents = mDependents[name];
+    dependents.push_back(Dependent{cnpt, role, stamp});
+    size_t size = dependents.size();
+    if (size < kPruneLength || (size & (size - 1)) != 0) continue;
+    std::vector<Dependent> live;
+    for (auto& dependent : dependents) {
+      auto owner = mCache.find(dependent.cnpt);
+      if (owner == mCache.end()) continue;
+      auto cached = owner->second.find(dependent.role);
+      if (cached != owner->second.end() &&
+          cached->second.stamp == dependent.stamp) {
+        live.push_back(std::move(dependent));
+      }
+    }
+    dependents.swap(live);
+  }
+  return true;
+}
+
+void InheritanceResolver::Walk(const ConceptPtr& cnpt, const std::string& role,
+                               RoleValue& result,
+                               std::vector<std::string>& visited,
+                               common::ProfileNode* profile) const {
+  result = RoleValue();
+  auto owner = mOwners.find(role);
+  bool typed = false;
+
+  std::deque<std::pair<ConceptPtr, uint32_t>> frontier;
+  std::unordered_set<std::string> seen{cnpt->SemName()};
+  std::unordered_set<std::string> cancelled;
+  uint64_t dequeued = 0;
+  frontier.emplace_back(cnpt, 0);
+  while (!frontier.empty()) {
+    ConceptPtr node = std::move(frontier.front().first);
+    uint32_t distance = frontier.front().second;
+    frontier.pop_front();
+    const std::string name = node->SemName();
+    ++dequeued;
+    // Cancellations of nearer concepts cut this one off, and so its
+    // ancestors unless reachable otherwise.
+    if (cancelled.count(name)) continue;
+    visited.push_back(name);
+
+    auto assertions = mAssertions.find(name);
+    if (assertions != mAssertions.end()) {
+      const Assertions& here = assertions->second;
+      cancelled.insert(here.not_a.begin(), here.not_a.end());
+      auto value = here.values.find(role);
+      if (result.source.empty() && value != here.values.end()) {
+        result.value = value->second;
+        result.source = name;
+        result.distance = distance;
+      }
+      auto type = here.types.find(role);
+      if (!typed && type != here.types.end()) {
+        result.type = type->second;
+        typed = true;
+      }
+    }
+    if (owner != mOwners.end() && owner->second == name) {
+      result.applicable = true;
+    }
+    if (result.applicable && !result.source.empty() && typed) break;
+
+    node->ForEachParent([&](const ElementPtr& parent) {
+      if (seen.insert(parent->SemName()).second) {
+        frontier.emplace_back(std::static_pointer_cast<Concept>(parent),
+                              distance + 1);
+      }
+    });
+  }
+
+  if (profile) {
+    ++profile->loops;
+    profile->rows_in += dequeued;
+    profile->rows_out += visited.size();
+    common::ProfileNode& cut = profile->AddChild("cancellation_filter");
+    cut.rows_in = dequeued;
+    cut.rows_out = visited.size();
+  }
+
+  if (!typed) {
+    // The filler type the role was declared with.
+    ConceptPtr declared;
+    if (mHyperbase.GetConcept(role, declared)) {
+      visited.push_back(role);
+      declared->ForEachParent([&result](const ElementPtr& parent) {
+        if (result.type.empty()) result.type = parent->SemName();
+      });
+    }
+  }
+}
+
+bool InheritanceResolver::IsA(const std::string& cnpt,
+                              const std::string& type) const {
+  std::shared_lock<std::shared_mutex> hyperbase_lock(mHyperbase.Mutex());
+  ConceptPtr origin;
+  if (!mHyperbase.GetConcept(cnpt, origin)) return false;
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+
+  std::deque<ConceptPtr> frontier{origin};
+  std::unordered_set<std::string> seen{cnpt};
+  std::unordered_set<std::string> cancelled;
+  while (!frontier.empty()) {
+    ConceptPtr node = std::move(frontier.front());
+    frontier.pop_front();
+    const std::string name = node->SemName();
+    if (cancelled.count(name)) continue;
+    if (name == type) return true;
+    auto assertions = mAssertions.find(name);
+    if (assertions != mAssertions.end()) {
+      const auto& not_a = assertions->second.not_a;
+      if (not_a.count(type)) return false;
+      cancelled.insert(not_a.begin(), not_a.end());
+    }
+    node->ForEachParent([&](const ElementPtr& parent) {
+      if (seen.insert(parent->SemName()).second) {
+        frontier.push_back(std::static_pointer_cast<Concept>(parent));
+      }
+    });
+  }
+  return false;
+}
+
+void InheritanceResolver::Invalidate(const std::string& cnpt,
+                                     const std::string& role) {
+  ++mEpoch;
+  auto found = mDependents.find(cnpt);
+  if (found == mDependents.end()) return;
+  std::vector<Dependent> kept;
+  for (auto& dependent : found->second) {
+    auto owner = mCache.find(dependent.cnpt);
+    if (owner == mCache.end()) continue;
+    auto cached = owner->second.find(dependent.role);
+    if (cached == owner->second.end() ||
+        cached->second.stamp != dependent.stamp) {
+      continue;
+    }
+    if (!role.empty() && dependent.role != role) {
+      kept.push_back(std::move(dependent));
+      continue;
+    }
+    owner->second.erase(cached);
+    if (owner->second.empty()) mCache.erase(owner);
+    --mEntries;
+    ++mInvalidated;
+    kCacheInvalidations.Add();
+  }
+  if (kept.empty()) {
+    mDependents.erase(found);
+  } else {
+    found->second.swap(kept);
+  }
+}
+
+void InheritanceResolver::InvalidateRole(const std::string& role) {
+  ++mEpoch;
+  for (auto owner = mCache.begin(); owner != mCache.end();) {
+    if (owner->second.erase(role)) {
+      --mEntries;
+      ++mInvalidated;
+      kCacheInvalidations.Add();
+    }
+    owner = owner->second.empty() ? mCache.erase(owner) : std::next(owner);
+  }
+}
+
+InheritanceStats InheritanceResolver::Stats() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  InheritanceStats stats;
+  stats.hits = mHits.load(std::memory_order_relaxed);
+  stats.misses = mMisses.load(std::memory_order_relaxed);
+  stats.invalidated = mInvalidated;
+  stats.entries = mEntries;
+  return stats;
+}
+
+void InheritanceResolver::Clear() {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  ++mEpoch;
+  mCache.clear();
+  mDependents.clear();
+  mEntries = 0;
+}
+
+void register_inheritance_forms(SconeLoader& loader,
+                                InheritanceResolver& resolver) {
+  // (new-is-not-a {x} {y})
+  loader.ChainForm("new-is-not-a", [&resolver](SconeLoader& target,
+                                               const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 2, args)) return false;
+    target.Ensure(args[0], Mutation::KIND_ENTITY);
+    target.Ensure(args[1], Mutation::KIND_ENTITY);
+    resolver.AddIsNotA(args[0], args[1]);
+    return true;
+  });
+  // (new-type-role {role} {owner} {type} ...)
+  auto declare = [&resolver](SconeLoader&, const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 2, args)) return false;
+    resolver.DeclareRole(args[0], args[1]);
+    return true;
+  };
+  loader.ChainForm("new-type-role", declare);
+  loader.ChainForm("new-indv-role", declare);
+  // (x-is-the-y-of-z {x} {y} {z})
+  loader.ChainForm("x-is-the-y-of-z", [&resolver](SconeLoader&,
+                                                  const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 3, args)) return false;
+    resolver.SetValue(args[2], args[1], args[0]);
+    return true;
+  });
+  // (the-x-of-y-is-z {x} {y} {z})
+  loader.ChainForm("the-x-of-y-is-z", [&resolver](SconeLoader&,
+                                                  const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 3, args)) return false;
+    resolver.SetValue(args[1], args[0], args[2]);
+    return true;
+  });
+  // (the-x-of-y-is-a {x} {y} {z})
+  loader.ChainForm("the-x-of-y-is-a", [&resolver](SconeLoader&,
+                                                  const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 3, args)) return false;
+    resolver.SetType(args[1], args[0], args[2]);
+    return true;
+  });
+}
+
+}  // namespace base
+}  // namespace hyperon
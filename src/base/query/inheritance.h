@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+class SconeLoader;
+
+/**
+ * @brief Resolved value of a role for one concept.
+ */
+struct RoleValue {
+  // The role is declared on the concept or an inherited type.
+  bool applicable{false};
+  // Filler, empty if no value is inherited.
+  std::string value;
+  // Concept the value was asserted on and its distance in lineage steps.
+  std::string source;
+  uint32_t distance{0};
+  // Most specific type restriction of the filler, the role's own parent if
+  // none was asserted.
+  std::string type;
+};
+
+/**
+ * @brief Counters of an inheritance resolver.
+ */
+struct InheritanceStats {
+  uint64_t hits{0};
+  uint64_t misses{0};
+  // Cached entries dropped by lineage or assertion changes.
+  uint64_t invalidated{0};
+  uint64_t entries{0};
+};
+
+/**
+ * @brief Default inheritance of role values with exceptions.
+ *
+ * Role declarations (new-type-role), values (x-is-the-y-of-z,
+ * the-x-of-y-is-z), filler type restrictions (the-x-of-y-is-a) and
+ * cancellations (new-is-not-a) are asserted on concepts by name. A concept
+ * inherits the value asserted on its nearest ancestor, walking the lineage
+ * breadth-first. A type it is declared not to be is cut off together with
+ * everything only reachable through it.
+ *
+ * Resolve() memoizes its results per (concept, role). Each entry remembers
+ * the concepts its walk visited, and is dropped exactly when one of them
+ * gains or loses a parent, a cancellation or an assertion for its role.
+ * Lineage changes are observed through OnCommit(); register the resolver
+ * with Hyperbase::AddCommitObserver().
+ */
+class InheritanceResolver : public CommitObserver {
+public:
+  explicit InheritanceResolver(const Hyperbase& hyperbase);
+
+  /* override */ void OnCommit(const Hyperbase& hyperbase, uint64_t version,
+                               const std::vector<const Mutation*>& applied);
+
+  // Declare `role` on `owner` and its descendants.
+  void DeclareRole(const std::string& role, const std::string& owner);
+
+  // `cnpt` and its descendants are not `type`, whatever their lineage says.
+  void AddIsNotA(const std::string& cnpt, const std::string& type);
+  bool RemoveIsNotA(const std::string& cnpt, const std::string& type);
+
+  // The `role` of `owner` is `value`.
+  void SetValue(const std::string& owner, const std::string& role,
+                const std::string& value);
+  bool ClearValue(const std::string& owner, const std::string& role);
+
+  // The `role` of `owner` is a `type`.
+  void SetType(const std::string& owner, const std::string& role,
+               const std::string& type);
+  bool ClearType(const std::string& owner, const std::string& role);
+
+  /**
+   * @brief Resolve the `role` of `cnpt`. Takes the shared lock of the
+   * hyperbase on a cache miss.
+   *
+   * @param profile Filled with the execution profile if set
+   * @return false if `cnpt` is not in the hyperbase
+   */
+  bool Resolve(const std::string& cnpt, const std::string& role,
+               RoleValue& result, common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Whether `cnpt` is `type` or inherits from it, honoring
+   * cancellations. Not memoized.
+   */
+  bool IsA(const std::string& cnpt, const std::string& type) const;
+
+  InheritanceStats Stats() const;
+
+  // Drop every cached entry.
+  void Clear();
+
+private:
+  struct Assertions {
+    std::unordered_set<std::string> not_a;
+    // Role to value and role to type restriction.
+    std::unordered_map<std::string, std::string> values;
+    std::unordered_map<std::string, std::string> types;
+    // Roles declared on the concept.
+    std::unordered_set<std::string> roles;
+  };
+
+  struct Entry {
+    RoleValue value;
+    uint64_t stamp;
+  };
+
+  // A cached entry depending on a concept.
+  struct Dependent {
+    std::string cnpt;
+    std::string role;
+    uint64_t stamp;
+  };
+
+  /**
+   * @brief Walk the lineage of `cnpt` for `role`. Needs the shared lock of
+   * the hyperbase and at least the shared side of mMutex.
+   *
+   * @param visited Concepts whose changes affect the result
+   * @param profile Counts of the walk, if set
+   */
+  void Walk(const ConceptPtr& cnpt, const std::string& role,
+            RoleValue& result, std::vector<std::string>& visited,
+            common::ProfileNode* profile = nullptr) const;
+
+  // Drop entries depending on `cnpt`, only those of `role` unless empty.
+  // Needs the exclusive side of mMutex.
+  void Invalidate(const std::string& cnpt, const std::string& role = "");
+  void InvalidateRole(const std::string& role);
+
+  const Hyperbase& mHyperbase;
+
+  mutable std::shared_mutex mMutex;
+  std::unordered_map<std::string, Assertions> mAssertions;
+  // Role to declaring concept.
+  std::unordered_map<std::string, std::string> mOwners;
+  // Concept to role to entry.
+  std::unordered_map<std::string, std::unordered_map<std::string, Entry>>
+      mCache;
+  // Concept to the entries whose walk visited it. Lists may hold stale
+  // stamps of entries already dropped.
+  std::unordered_map<std::string, std::vector<Dependent>> mDependents;
+  uint64_t mStamp{0};
+  // Bumped by every invalidation, so that a walk racing with one does not
+  // cache its outdated result.
+  uint64_t mEpoch{0};
+  uint64_t mEntries{0};
+  uint64_t mInvalidated{0};
+
+  mutable std::atomic<uint64_t> mHits{0};
+  mutable std::atomic<uint64_t> mMisses{0};
+};
+
+/**
+ * @brief Feed inheritance assertions of Scone files to a resolver:
+ * new-is-not-a, new-type-role, new-indv-role, x-is-the-y-of-z,
+ * the-x-of-y-is-z and the-x-of-y-is-a. Existing handlers of these forms
+ * still run first.
+ */
+void register_inheritance_forms(SconeLoader& loader,
+                                InheritanceResolver& resolver);
+
+}  // namespace base
+}  // namespace hyperon
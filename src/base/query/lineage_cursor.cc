@@ -0,0 +1,108 @@
+#include "base/query/lineage_cursor.h"
+
+#include <fmt/core.h>
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace hyperon {
+namespace base {
+
+LineageCursor::LineageCursor(const std::string& origin, DIRECTION direction,
+                             size_t max_visited)
+    : mOrigin(origin), mDirection(direction), mMaxVisited(max_visited) {}
+
+size_t LineageCursor::Next(const Hyperbase& hyperbase, size_t max_count,
+                           std::vector<std::string>& out,
+                           common::ProfileNode* profile) {
+  bool descend = mDirection == DESCENDANTS;
+  common::ProfileNode* wait = nullptr;
+  common::ProfileNode* bfs = nullptr;
+  common::ProfileNode* index = nullptr;
+  if (profile) {
+    if (profile->op.empty()) {
+      *profile = common::ProfileNode(
+          "lineage_cursor", fmt::format("{}, {}", mOrigin,
+                                        descend ? "descendants" : "ancestors"));
+    }
+    wait = &profile->Child("lock_wait");
+    bfs = &profile->Child("lineage_bfs", descend ? "children" : "parents");
+    index = &bfs->Child("concept_index", "hash");
+  }
+  common::ProfileTimer timer(profile);
+  common::ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  wait_timer.Stop();
+  common::ProfileTimer bfs_timer(bfs);
+  if (!mStarted) {
+    mStarted = true;
+    mStartVersion = hyperbase.Version();
+    mVisited.insert(mOrigin);
+    mFrontier.push_back(mOrigin);
+  }
+
+  uint64_t edges = 0;
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+  auto discover = [this, &edges, descend](const ElementPtr& next) {
+    ++edges;
+    std::string name = next->SemName();
+    // A concept with a single incoming edge is reached once, from the one
+    // visit of its parent. Cycles enter through a shared concept or the
+    // origin, which are both recorded.
+    bool shared = true;
+    if (next->IsConcept()) {
+      const auto& cnpt = static_cast<const Concept&>(*next);
+      shared = (descend ? cnpt.ParentCount() : cnpt.ChildCount()) > 1;
+    }
+    if (shared || name == mOrigin) {
+      if (mVisited.count(name) > 0) return;
+      if (mVisited.size() >= mMaxVisited) {
+        mOverflowed = true;
+        return;
+      }
+      mVisited.insert(name);
+    }
+    mFrontier.push_back(std::move(name));
+  };
+
+  // Concepts are emitted when dequeued rather than when discovered, so a
+  // chunk never exceeds `max_count` even below a high-fanout node.
+  size_t appended = 0;
+  while (appended < max_count && !mFrontier.empty()) {
+    std::string name = std::move(mFrontier.front());
+    mFrontier.pop_front();
+    ConceptPtr cnpt;
+    ++lookups;
+    if (!hyperbase.GetConcept(name, cnpt)) continue;
+    ++hits;
+    if (descend) {
+      cnpt->ForEachChild(discover);
+    } else {
+      cnpt->ForEachParent(discover);
+    }
+    if (mOverflowed) {
+      mFrontier.clear();
+      break;
+    }
+    if (name != mOrigin) {
+      out.push_back(std::move(name));
+      ++appended;
+    }
+  }
+  mProduced += appended;
+  if (profile) {
+    ++profile->loops;
+    ++bfs->loops;
+    ++index->loops;
+    profile->rows_out += appended;
+    bfs->rows_in += edges;
+    bfs->rows_out += appended;
+    index->rows_in += lookups;
+    index->rows_out += hits;
+  }
+  return appended;
+}
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Resumable breadth-first walk over the transitive lineage of a
+ * concept. Results are pulled in chunks, so a query over a huge subtree never
+ * materializes the whole result at once.
+ *
+ * The cursor keeps only names: the pending frontier and the visited concepts
+ * with more than one parent (children when walking ancestors), the only ones
+ * a walk over a DAG can reach twice. Their number is capped by `max_visited`,
+ * a walk over more of them stops as overflowed.
+ *
+ * It holds no lock between chunks and therefore survives concurrent writes.
+ * Concepts removed in the meantime are skipped; concepts added below an
+ * unvisited node are picked up. A concept given a second parent during the
+ * walk may be produced twice.
+ */
+class LineageCursor {
+public:
+  enum DIRECTION { DESCENDANTS, ANCESTORS };
+
+  static constexpr size_t kDefaultMaxVisited = 1 << 20;
+
+  LineageCursor(const std::string& origin, DIRECTION direction,
+                size_t max_visited = kDefaultMaxVisited);
+
+  inline const std::string& Origin() const { return mOrigin; }
+  inline DIRECTION Direction() const { return mDirection; }
+  inline bool Exhausted() const { return mStarted && mFrontier.empty(); }
+  // The walk reached more shared concepts than allowed and was cut short,
+  // it is exhausted then.
+  inline bool Overflowed() const { return mOverflowed; }
+  inline size_t MaxVisited() const { return mMaxVisited; }
+  // Number of concepts produced so far.
+  inline uint64_t Produced() const { return mProduced; }
+  // Hyperbase version observed when the walk started.
+  inline uint64_t StartVersion() const { return mStartVersion; }
+
+  /**
+   * @brief Produce up to `max_count` further concepts, excluding the origin.
+   * Takes the shared lock of the hyperbase for the duration of the chunk.
+   *
+   * @param hyperbase Hyperbase to walk
+   * @param max_count Chunk size
+   * @param out Appended semantic names
+   * @param profile Execution profile, accumulated over the chunks it is
+   * passed to
+   * @return size_t Number of names appended
+   */
+  size_t Next(const Hyperbase& hyperbase, size_t max_count,
+              std::vector<std::string>& out,
+              common::ProfileNode* profile = nullptr);
+
+private:
+  std::string mOrigin;
+  DIRECTION mDirection;
+  size_t mMaxVisited;
+  bool mStarted{false};
+  bool mOverflowed{false};
+  uint64_t mStartVersion{0};
+  uint64_t mProduced{0};
+  std::deque<std::string> mFrontier;
+  std::unordered_set<std::string> mVisited;
+};
+
+}  // namespace base
+}  // namespace hyperon
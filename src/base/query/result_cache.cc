@@ -0,0 +1,382 @@
+#include "base/query/result_cache.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <shared_mutex>
+#include <utility>
+
+#include "base/query/batch_query.h"
+#include "common/metrics/metrics.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+// Bookkeeping of an entry besides its rows: hash nodes, the rank and the
+// result itself.
+constexpr uint64_t kEntryOverhead = 192;
+// A node of a result index: the view, the cached hash and the link.
+constexpr uint64_t kIndexNodeBytes = 40;
+
+const common::Counter kCacheHits("hyperon_cache_lookups_total",
+                                 "Lookups of memoizing caches.",
+                                 "cache=\"result\",result=\"hit\"");
+const common::Counter kCacheMisses("hyperon_cache_lookups_total",
+                                   "Lookups of memoizing caches.",
+                                   "cache=\"result\",result=\"miss\"");
+const common::Counter kCacheInvalidations(
+    "hyperon_cache_invalidations_total",
+    "Entries dropped from memoizing caches by changes.", "cache=\"result\"");
+const common::Counter kCacheEvictions(
+    "hyperon_cache_evictions_total",
+    "Entries dropped from memoizing caches for space.", "cache=\"result\"");
+
+uint64_t string_bytes(const std::string& text) {
+  // Short strings live inline.
+  return sizeof(std::string) +
+         (text.capacity() > 15 ? text.capacity() + 1 : 0);
+}
+
+// Query kind and arguments, separated by a character names do not use.
+std::string make_key(const char* kind,
+                     const std::vector<std::string>& args) {
+  std::string key = kind;
+  for (const auto& arg : args) {
+    key += '\x1f';
+    key += arg;
+  }
+  return key;
+}
+
+std::string lineage_key(const std::string& origin,
+                        LineageCursor::DIRECTION direction,
+                        uint32_t max_depth) {
+  return make_key(direction == LineageCursor::DESCENDANTS ? "descendants"
+                                                          : "ancestors",
+                  {std::to_string(max_depth), origin});
+}
+
+void profile_lineage(common::ProfileNode* profile, const std::string& origin,
+                     LineageCursor::DIRECTION direction, uint32_t max_depth) {
+  if (!profile) return;
+  profile->detail = fmt::format(
+      "{} of {}",
+      direction == LineageCursor::DESCENDANTS ? "descendants" : "ancestors",
+      origin);
+  if (max_depth > 0) profile->detail += fmt::format(", depth {}", max_depth);
+}
+
+}  // namespace
+
+QueryResultCache::QueryResultCache(const Hyperbase& hyperbase,
+                                   uint64_t capacity)
+    : mHyperbase(hyperbase),
+      mCapacity(capacity),
+      mVersion(hyperbase.Version()) {}
+
+void QueryResultCache::OnCommit(const Hyperbase&, uint64_t version,
+                                const std::vector<const Mutation*>& applied) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  ++mEpoch;
+  mVersion = version;
+  if (mEntries.empty()) return;
+  for (const Mutation* mut : applied) {
+    // Both ends of an edge or a membership change: the subject gains a
+    // parent or a member, the objects a child or a relation.
+    Touch(mConcepts, mut->subject, version);
+    if (mut->kind == Mutation::MUT_SET_INTERVAL) continue;
+    for (const auto& object : mut->objects) {
+      Touch(mConcepts, object, version);
+    }
+    if (mut->kind == Mutation::MUT_ADD_CONCEPT) {
+      Touch(mCategories, mut->category, version);
+    }
+  }
+}
+
+void QueryResultCache::Touch(StampMap& stamps, const std::string& name,
+                             uint64_t version) {
+  auto found = stamps.find(name);
+  if (found == stamps.end()) return;
+  found->second.version = version;
+  mTouched = version;
+}
+
+CachedResultPtr QueryResultCache::Lookup(const std::string& key,
+                                         const Compute& compute,
+                                         common::ProfileNode* profile) {
+  if (profile) {
+    *profile = common::ProfileNode("result_cache", "", "hash");
+    profile->loops = profile->rows_in = 1;
+  }
+  common::ProfileTimer timer(profile);
+  uint64_t epoch;
+  uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    CachedResultPtr hit =
+        FindLocked(key, std::numeric_limits<size_t>::max(), profile);
+    if (hit) return hit;
+    ++mMisses;
+    epoch = mEpoch;
+    version = mVersion;
+  }
+  kCacheMisses.Add();
+
+  auto result = std::make_shared<CachedResult>();
+  result->version = version;
+  QueryDependencies dependencies;
+  common::ProfileNode* inner = common::profile_child(profile, "");
+  auto start = std::chrono::steady_clock::now();
+  compute(*result, dependencies, inner);
+  double cost = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+  if (profile) {
+    profile->cache_misses = 1;
+    profile->rows_out = result->rows.size();
+  }
+
+  uint64_t bytes = kEntryOverhead + 2 * string_bytes(key) +
+                   (dependencies.concepts.size() +
+                    dependencies.categories.size()) *
+                       sizeof(Stamp*);
+  for (const auto& row : result->rows) bytes += string_bytes(row);
+  bytes += result->index.size() * kIndexNodeBytes +
+           result->index.bucket_count() * sizeof(void*);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  // A commit since the start of the miss may have changed what the result
+  // depends on before it was tracked.
+  if (epoch != mEpoch || bytes > mCapacity / 2) return result;
+  auto slot = mEntries.emplace(key, Entry());
+  // A concurrent miss cached the same result already.
+  if (!slot.second) return result;
+  Entry& entry = slot.first->second;
+  entry.result = result;
+  entry.checked = version;
+  entry.bytes = bytes;
+  entry.cost = std::max(cost, 1.0);
+  entry.stamps.reserve(dependencies.concepts.size() +
+                       dependencies.categories.size());
+  for (const auto& name : dependencies.concepts) {
+    entry.stamps.push_back(Track(mConcepts, name));
+  }
+  for (const auto& name : dependencies.categories) {
+    Stamp* stamp = Track(mCategories, name);
+    stamp->category = true;
+    entry.stamps.push_back(stamp);
+  }
+  entry.rank = mRanks.end();
+  MakeRoom(bytes);
+  mBytes += bytes;
+  Rank(slot.first);
+  return result;
+}
+
+CachedResultPtr QueryResultCache::Find(const std::string& key,
+                                       size_t max_rows,
+                                       common::ProfileNode* profile) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  CachedResultPtr hit = FindLocked(key, max_rows, nullptr);
+  if (hit && profile) {
+    *profile = common::ProfileNode("result_cache", "", "hash");
+    profile->loops = profile->rows_in = profile->cache_hits = 1;
+    profile->rows_out = hit->rows.size();
+  }
+  return hit;
+}
+
+CachedResultPtr QueryResultCache::FindLocked(const std::string& key,
+                                             size_t max_rows,
+                                             common::ProfileNode* profile) {
+  auto found = mEntries.find(key);
+  if (found == mEntries.end()) return nullptr;
+  Entry& entry = found->second;
+  if (entry.result->rows.size() > max_rows) return nullptr;
+  if (entry.checked != mVersion && !Valid(entry)) {
+    Drop(found);
+    ++mInvalidated;
+    kCacheInvalidations.Add();
+    return nullptr;
+  }
+  entry.checked = mVersion;
+  Rank(found);
+  ++mHits;
+  kCacheHits.Add();
+  if (profile) {
+    profile->cache_hits = 1;
+    profile->rows_out = entry.result->rows.size();
+  }
+  return entry.result;
+}
+
+QueryResultCache::Stamp* QueryResultCache::Track(StampMap& stamps,
+                                                 const std::string& name) {
+  auto slot = stamps.emplace(name, Stamp());
+  Stamp& stamp = slot.first->second;
+  if (slot.second) {
+    // Unchanged as far as entries cached from now on are concerned.
+    stamp.version = 0;
+    stamp.name = &slot.first->first;
+  }
+  ++stamp.refs;
+  return &stamp;
+}
+
+bool QueryResultCache::Valid(const Entry& entry) const {
+  if (mTouched <= entry.checked) return true;
+  for (const Stamp* stamp : entry.stamps) {
+    if (stamp->version > entry.checked) return false;
+  }
+  return true;
+}
+
+void QueryResultCache::Rank(EntryMap::iterator entry) {
+  Entry& cached = entry->second;
+  if (cached.rank != mRanks.end()) mRanks.erase(cached.rank);
+  cached.rank = mRanks.emplace(mInflation + cached.cost / cached.bytes,
+                               &entry->first);
+}
+
+void QueryResultCache::Drop(EntryMap::iterator entry) {
+  Entry& cached = entry->second;
+  if (cached.rank != mRanks.end()) mRanks.erase(cached.rank);
+  for (Stamp* stamp : cached.stamps) {
+    if (--stamp->refs > 0) continue;
+    StampMap& stamps = stamp->category ? mCategories : mConcepts;
+    stamps.erase(stamps.find(*stamp->name));
+  }
+  mBytes -= cached.bytes;
+  mEntries.erase(entry);
+}
+
+void QueryResultCache::MakeRoom(uint64_t bytes) {
+  while (!mRanks.empty() && mBytes + bytes > mCapacity) {
+    auto least = mRanks.begin();
+    mInflation = least->first;
+    Drop(mEntries.find(*least->second));
+    ++mEvicted;
+    kCacheEvictions.Add();
+  }
+}
+
+bool QueryResultCache::IsA(const std::string& cnpt, const std::string& type,
+                           common::ProfileNode* profile) {
+  if (cnpt == type) {
+    std::shared_lock<std::shared_mutex> lock(mHyperbase.Mutex());
+    return mHyperbase.HasConcept(cnpt);
+  }
+  CachedResultPtr ancestors =
+      Lineage(cnpt, LineageCursor::ANCESTORS, 0, profile);
+  return ancestors->index.count(type) > 0;
+}
+
+CachedResultPtr QueryResultCache::Lineage(const std::string& origin,
+                                          LineageCursor::DIRECTION direction,
+                                          uint32_t max_depth,
+                                          common::ProfileNode* profile) {
+  auto compute = [&](CachedResult& result, QueryDependencies& dependencies,
+                     common::ProfileNode* inner) {
+    std::vector<std::vector<std::string>> out;
+    result.found =
+        walk_lineage(mHyperbase, {origin}, direction, max_depth, out,
+                     inner) > 0;
+    result.rows = std::move(out.front());
+    // Ancestor sets answer IsA(), and are small next to descendant sets.
+    if (direction == LineageCursor::ANCESTORS) {
+      result.index.reserve(result.rows.size());
+      for (const auto& row : result.rows) result.index.insert(row);
+    }
+    // The walk changes with the lineage of any concept it reached.
+    dependencies.concepts = result.rows;
+    dependencies.concepts.push_back(origin);
+  };
+  CachedResultPtr result =
+      Lookup(lineage_key(origin, direction, max_depth), compute, profile);
+  profile_lineage(profile, origin, direction, max_depth);
+  return result;
+}
+
+CachedResultPtr QueryResultCache::CachedLineage(
+    const std::string& origin, LineageCursor::DIRECTION direction,
+    uint32_t max_depth, size_t max_rows, common::ProfileNode* profile) {
+  CachedResultPtr result =
+      Find(lineage_key(origin, direction, max_depth), max_rows, profile);
+  if (result) profile_lineage(profile, origin, direction, max_depth);
+  return result;
+}
+
+CachedResultPtr QueryResultCache::CommonChildren(
+    const std::vector<std::string>& types, common::ProfileNode* profile) {
+  std::vector<std::string> sorted = types;
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  auto compute = [&](CachedResult& result, QueryDependencies& dependencies,
+                     common::ProfileNode* inner) {
+    result.found =
+        common_children(mHyperbase, sorted, result.rows, inner) > 0;
+    // Children are added and removed through the types themselves.
+    dependencies.concepts = sorted;
+  };
+  CachedResultPtr result =
+      Lookup(make_key("common_children", sorted), compute, profile);
+  if (profile) {
+    profile->detail = fmt::format("common children of {} types",
+                                  sorted.size());
+  }
+  return result;
+}
+
+CachedResultPtr QueryResultCache::Members(const std::string& relation,
+                                          common::ProfileNode* profile) {
+  auto compute = [&](CachedResult& result, QueryDependencies& dependencies,
+                     common::ProfileNode* inner) {
+    std::vector<std::vector<std::string>> out;
+    result.found = relation_members(mHyperbase, {relation}, out, inner) > 0;
+    result.rows = std::move(out.front());
+    dependencies.concepts.push_back(relation);
+  };
+  CachedResultPtr result =
+      Lookup(make_key("members", {relation}), compute, profile);
+  if (profile) profile->detail = fmt::format("members of {}", relation);
+  return result;
+}
+
+ResultCacheStats QueryResultCache::Stats() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  ResultCacheStats stats;
+  stats.hits = mHits;
+  stats.misses = mMisses;
+  stats.invalidated = mInvalidated;
+  stats.evicted = mEvicted;
+  stats.entries = mEntries.size();
+  stats.bytes = mBytes;
+  stats.capacity = mCapacity;
+  return stats;
+}
+
+void QueryResultCache::SetCapacity(uint64_t capacity) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mCapacity = capacity;
+  MakeRoom(0);
+}
+
+void QueryResultCache::Clear() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mEntries.clear();
+  mConcepts.clear();
+  mCategories.clear();
+  mRanks.clear();
+  mInflation = 0;
+  mTouched = 0;
+  mBytes = 0;
+}
+
+}  // namespace base
+}  // namespace hyperon
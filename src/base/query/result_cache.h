@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/lineage_cursor.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Result of a cached query. Shared between lookups, never modified
+ * once cached.
+ */
+struct CachedResult {
+  // The query named known concepts.
+  bool found{false};
+  std::vector<std::string> rows;
+  // The rows as a hash set, for results probed by membership such as the
+  // ancestors behind IsA(). Empty for other results.
+  std::unordered_set<std::string_view> index;
+  // Hyperbase version the result was computed at. It still holds at the
+  // version of the lookup returning it.
+  uint64_t version{0};
+};
+using CachedResultPtr = std::shared_ptr<const CachedResult>;
+
+/**
+ * @brief What a cached result was derived from. A change to any of these
+ * concepts, or a concept added to any of these categories, drops it.
+ */
+struct QueryDependencies {
+  std::vector<std::string> concepts;
+  // Category names, empty for the root category.
+  std::vector<std::string> categories;
+};
+
+/**
+ * @brief Counters of a result cache.
+ */
+struct ResultCacheStats {
+  uint64_t hits{0};
+  uint64_t misses{0};
+  // Entries found outdated by a change on lookup.
+  uint64_t invalidated{0};
+  // Entries dropped to stay within the capacity.
+  uint64_t evicted{0};
+  uint64_t entries{0};
+  uint64_t bytes{0};
+  uint64_t capacity{0};
+};
+
+/**
+ * @brief Results of repeated queries, e.g. is-a checks and descendant sets,
+ * keyed by the normalized query.
+ *
+ * Every committed mutation stamps the concepts it names, and a concept
+ * added to a category stamps the category, with the version of its
+ * commit. Stamps are kept only for concepts and categories some entry
+ * depends on. An entry is valid as long as none of its dependencies was
+ * stamped after the version it was computed at: lookups at the version of
+ * the entry, or after commits changing nothing any entry depends on, are a
+ * hash probe, other lookups check the stamps of the entry once and carry
+ * it over to the new version. A write thus only drops
+ * the entries depending on what it changed. Outdated entries are dropped
+ * when looked up, or evicted in time as they are no longer hit.
+ *
+ * The cache is bounded in bytes and evicts by GreedyDual-Size: an entry
+ * is worth the time it took to compute per byte it holds, plus an
+ * inflation value raised to the worth of every evicted entry, so that
+ * cheap, large and long unused results go first.
+ *
+ * Changes are observed through OnCommit(); register the cache with
+ * Hyperbase::AddCommitObserver().
+ */
+class QueryResultCache : public CommitObserver {
+public:
+  static constexpr uint64_t kDefaultCapacity = uint64_t{64} << 20;
+
+  using Compute = std::function<void(CachedResult& result,
+                                     QueryDependencies& dependencies,
+                                     common::ProfileNode* profile)>;
+
+  /**
+   * @param capacity Bytes of cached results at most, 0 disables caching
+   */
+  explicit QueryResultCache(const Hyperbase& hyperbase,
+                            uint64_t capacity = kDefaultCapacity);
+
+  /* override */ void OnCommit(const Hyperbase& hyperbase, uint64_t version,
+                               const std::vector<const Mutation*>& applied);
+
+  /**
+   * @brief Cached result of the query named `key`, computed on a miss.
+   * `compute` takes the locks it needs and lists what its result depends
+   * on. Results too large for the cache are returned but not kept.
+   *
+   * @param key Normalized query, equal for queries with equal results
+   * @param profile Filled with the execution profile if set
+   */
+  CachedResultPtr Lookup(const std::string& key, const Compute& compute,
+                         common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Cached result of the query named `key` if a valid one of at most
+   * `max_rows` rows is cached, nullptr otherwise. Nothing is computed and
+   * only hits count.
+   *
+   * @param profile Filled with the execution profile on a hit
+   */
+  CachedResultPtr Find(const std::string& key, size_t max_rows,
+                       common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Whether `cnpt` is `type` or below it in the lineage, probing the
+   * cached ancestor set of `cnpt`.
+   */
+  bool IsA(const std::string& cnpt, const std::string& type,
+           common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Lineage walk as walk_lineage(), for one origin.
+   * @return Concepts in breadth-first order, not found if `origin` is
+   * unknown
+   */
+  CachedResultPtr Lineage(const std::string& origin,
+                          LineageCursor::DIRECTION direction,
+                          uint32_t max_depth = 0,
+                          common::ProfileNode* profile = nullptr);
+
+  // Lineage() if cached, without walking on a miss, see Find().
+  CachedResultPtr CachedLineage(const std::string& origin,
+                                LineageCursor::DIRECTION direction,
+                                uint32_t max_depth, size_t max_rows,
+                                common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Type intersection as common_children(), found if not empty.
+   * The order of `types` does not matter.
+   */
+  CachedResultPtr CommonChildren(const std::vector<std::string>& types,
+                                 common::ProfileNode* profile = nullptr);
+
+  // Members of a relation as relation_members().
+  CachedResultPtr Members(const std::string& relation,
+                          common::ProfileNode* profile = nullptr);
+
+  ResultCacheStats Stats() const;
+
+  // Change the capacity, evicting entries as needed.
+  void SetCapacity(uint64_t capacity);
+
+  // Drop every cached entry.
+  void Clear();
+
+private:
+  // Version of the last change of a concept or category.
+  struct Stamp {
+    uint64_t version{0};
+    // Entries depending on it.
+    uint64_t refs{0};
+    // Its key, and whether it stamps a category.
+    const std::string* name{nullptr};
+    bool category{false};
+  };
+  using StampMap = std::unordered_map<std::string, Stamp>;
+
+  struct Entry {
+    CachedResultPtr result;
+    // Version the entry was last checked at.
+    uint64_t checked{0};
+    uint64_t bytes{0};
+    // Nanoseconds it took to compute.
+    double cost{0};
+    std::vector<Stamp*> stamps;
+    std::multimap<double, const std::string*>::iterator rank;
+  };
+  using EntryMap = std::unordered_map<std::string, Entry>;
+
+  // Whether no dependency of `entry` changed since it was checked.
+  bool Valid(const Entry& entry) const;
+  // The valid entry of `key` as a hit if it has at most `max_rows` rows,
+  // dropping an outdated one.
+  CachedResultPtr FindLocked(const std::string& key, size_t max_rows,
+                             common::ProfileNode* profile);
+  // Give `entry` its worth in the eviction order.
+  void Rank(EntryMap::iterator entry);
+  void Drop(EntryMap::iterator entry);
+  // Evict entries until `bytes` more fit.
+  void MakeRoom(uint64_t bytes);
+  // Track `name` for one more entry.
+  Stamp* Track(StampMap& stamps, const std::string& name);
+  // Stamp `name` with `version` if tracked.
+  void Touch(StampMap& stamps, const std::string& name, uint64_t version);
+
+  const Hyperbase& mHyperbase;
+
+  mutable std::mutex mMutex;
+  uint64_t mCapacity;
+  EntryMap mEntries;
+  StampMap mConcepts;
+  StampMap mCategories;
+  // Entries by worth, the least worth first.
+  std::multimap<double, const std::string*> mRanks;
+  double mInflation{0};
+  uint64_t mBytes{0};
+  // Latest committed version seen.
+  uint64_t mVersion;
+  // Version of the latest stamp, entries checked since are still valid.
+  uint64_t mTouched{0};
+  // Bumped by every commit, so that a miss racing with one does not cache
+  // its result under an outdated version.
+  uint64_t mEpoch{0};
+
+  uint64_t mHits{0};
+  uint64_t mMisses{0};
+  uint64_t mInvalidated{0};
+  uint64_t mEvicted{0};
+};
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,116 @@
+#include "base/query/temporal_query.h"
+
+#include <fmt/core.h>
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace hyperon {
+namespace base {
+
+using common::profile_child;
+using common::ProfileNode;
+using common::ProfileTimer;
+
+namespace {
+
+constexpr const char* kRelationNames[] = {"overlaps", "during", "contains",
+                                          "before",   "after",  "as_of"};
+
+constexpr int64_t kMin = EventIntervalIndex::kMin;
+constexpr int64_t kMax = EventIntervalIndex::kMax;
+
+/**
+ * @brief Bounds on the start and end of matching intervals.
+ */
+struct Bounds {
+  int64_t start_lo{kMin};
+  int64_t start_hi{kMax};
+  int64_t end_lo{kMin};
+  int64_t end_hi{kMax};
+};
+
+// False if no interval can match, e.g. events before the smallest point.
+bool bounds_of(TEMPORAL_RELATION relation, int64_t start, int64_t end,
+               Bounds& bounds) {
+  switch (relation) {
+    case TEMPORAL_OVERLAPS:
+      bounds.start_hi = end;
+      bounds.end_lo = start;
+      return start <= end;
+    case TEMPORAL_DURING:
+      bounds.start_lo = start;
+      bounds.start_hi = end;
+      bounds.end_hi = end;
+      return start <= end;
+    case TEMPORAL_CONTAINS:
+      bounds.start_hi = start;
+      bounds.end_lo = end;
+      return start <= end;
+    case TEMPORAL_BEFORE:
+      // Intervals never end before they start.
+      if (start == kMin) return false;
+      bounds.start_hi = start - 1;
+      bounds.end_hi = start - 1;
+      return true;
+    case TEMPORAL_AFTER:
+      if (end == kMax) return false;
+      bounds.start_lo = end + 1;
+      return true;
+    case TEMPORAL_AS_OF:
+      bounds.start_hi = start;
+      bounds.end_lo = start;
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+const char* temporal_relation_name(TEMPORAL_RELATION relation) {
+  return kRelationNames[relation];
+}
+
+size_t find_events(const Hyperbase& hyperbase, TEMPORAL_RELATION relation,
+                   int64_t start, int64_t end, std::vector<TimedEvent>& out,
+                   size_t limit, ProfileNode* profile) {
+  if (profile) {
+    *profile = ProfileNode(
+        "find_events",
+        fmt::format("{} [{}, {}]", temporal_relation_name(relation), start,
+                    end));
+    profile->loops = 1;
+  }
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileNode* scan = profile_child(profile, "interval_scan", "",
+                                    "interval_tree");
+
+  Bounds bounds;
+  if (!bounds_of(relation, start, end, bounds)) return 0;
+  size_t first = out.size();
+  ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  wait_timer.Stop();
+  ProfileTimer scan_timer(scan);
+  const EventIntervalIndex& events = hyperbase.Events();
+  size_t examined = events.Visit(
+      bounds.start_lo, bounds.start_hi, bounds.end_lo, bounds.end_hi,
+      [&](EventIntervalIndex::Handle handle) {
+        out.push_back({events.Value(handle)->SemName(), events.Start(handle),
+                       events.End(handle)});
+        return limit == 0 || out.size() - first < limit;
+      });
+  scan_timer.Stop();
+  size_t found = out.size() - first;
+  if (profile) {
+    scan->loops = 1;
+    scan->rows_in = examined;
+    profile->rows_in = events.Size();
+    profile->rows_out = scan->rows_out = found;
+  }
+  return found;
+}
+
+}  // namespace base
+}  // namespace hyperon
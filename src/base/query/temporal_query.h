@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * Relations of an event interval to a query window [start, end], after
+ * the Allen relations of Scone's time model. Bounds are inclusive.
+ */
+enum TEMPORAL_RELATION {
+  // Shares a time point with the window.
+  TEMPORAL_OVERLAPS,
+  // Lies inside the window.
+  TEMPORAL_DURING,
+  // Covers the window.
+  TEMPORAL_CONTAINS,
+  // Ends before the window starts.
+  TEMPORAL_BEFORE,
+  // Starts after the window ends.
+  TEMPORAL_AFTER,
+  // Goes on at the window start; the window end is ignored.
+  TEMPORAL_AS_OF,
+};
+
+const char* temporal_relation_name(TEMPORAL_RELATION relation);
+
+/**
+ * @brief An event found by find_events.
+ */
+struct TimedEvent {
+  std::string name;
+  int64_t start{0};
+  // Event::kOpenEnd for events still going on.
+  int64_t end{0};
+};
+
+/**
+ * @brief Events standing in `relation` to the window [start, end], ordered
+ * by start, under a single shared lock. Served by the interval index of
+ * the hyperbase in O(log n + k) for append-ordered events.
+ *
+ * @param hyperbase Hyperbase to read
+ * @param relation Relation to the window
+ * @param start First time point of the window
+ * @param end Last time point of the window
+ * @param out Found events are appended
+ * @param limit Stop after this many events, 0 for all
+ * @param profile Filled with the execution profile if set
+ * @return size_t Number of events appended
+ */
+size_t find_events(const Hyperbase& hyperbase, TEMPORAL_RELATION relation,
+                   int64_t start, int64_t end, std::vector<TimedEvent>& out,
+                   size_t limit = 0, common::ProfileNode* profile = nullptr);
+
+}  // namespace base
+}  // namespace hyperon
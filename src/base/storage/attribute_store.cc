@@ -0,0 +1,732 @@
+#include "base/storage/attribute_store.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+
+#include "base/storage/scone_loader.h"
+
+namespace hyperon {
+namespace base {
+
+using common::profile_child;
+using common::ProfileNode;
+using common::ProfileTimer;
+
+namespace {
+
+// Positions filtered per pass, small enough to stay in L1.
+constexpr size_t kChunk = 1024;
+
+/**
+ * @brief Positions among `count` ids whose concept is set in `mask`. The
+ * loop has no branch on the data, every position is written and only the
+ * count advances by the mask, so a miss costs no misprediction.
+ */
+size_t filter_ids(const uint32_t* ids, size_t count,
+                  const std::vector<uint8_t>& mask, uint32_t* selected) {
+  size_t n = 0;
+  for (size_t i = 0; i < count; ++i) {
+    selected[n] = static_cast<uint32_t>(i);
+    n += mask[ids[i]];
+  }
+  return n;
+}
+
+// Independent lanes, so that the adds pipeline and vectorize.
+double sum_values(const double* values, size_t count) {
+  double lanes[4] = {0, 0, 0, 0};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    for (size_t lane = 0; lane < 4; ++lane) lanes[lane] += values[i + lane];
+  }
+  double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < count; ++i) sum += values[i];
+  return sum;
+}
+
+}  // namespace
+
+NumericAttributeStore::NumericAttributeStore(const Hyperbase& hyperbase)
+    : mHyperbase(hyperbase) {}
+
+uint32_t NumericAttributeStore::Intern(const std::string& name) {
+  auto found = mIds.find(name);
+  if (found != mIds.end()) return found->second;
+  uint32_t id = static_cast<uint32_t>(mNames.size());
+  mNames.push_back(name);
+  mIds.emplace(name, id);
+  return id;
+}
+
+bool NumericAttributeStore::Find(const std::string& name, uint32_t& id) const {
+  auto found = mIds.find(name);
+  if (found == mIds.end()) return false;
+  id = found->second;
+  return true;
+}
+
+const NumericAttributeStore::Unit* NumericAttributeStore::FindUnit(
+    const std::string& name) const {
+  uint32_t unit;
+  if (!Find(name, unit) || mUnits.count(unit) == 0) {
+    auto alias = mAliases.find(name);
+    if (alias == mAliases.end() || alias->second == kNone) return nullptr;
+    unit = alias->second;
+  }
+  return &mUnits.at(unit);
+}
+
+void NumericAttributeStore::DefineQuality(const std::string& quality) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mBaseUnits.emplace(Intern(quality), kNone);
+}
+
+bool NumericAttributeStore::DefineUnit(const std::string& unit,
+                                       const std::string& quality,
+                                       const std::string& relative,
+                                       double ratio, double offset,
+                                       std::string& error) {
+  if (!(ratio > 0) || !std::isfinite(ratio) || !std::isfinite(offset)) {
+    error = fmt::format("unit {}: bad ratio {} or offset {}", unit, ratio,
+                        offset);
+    return false;
+  }
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  uint32_t quality_id;
+  auto base = Find(quality, quality_id) ? mBaseUnits.find(quality_id)
+                                        : mBaseUnits.end();
+  if (base == mBaseUnits.end()) {
+    error = fmt::format("unit {}: unknown quality {}", unit, quality);
+    return false;
+  }
+
+  Unit defined;
+  defined.quality = quality_id;
+  if (relative.empty()) {
+    uint32_t id = Intern(unit);
+    if (base->second != kNone && base->second != id) {
+      error = fmt::format("{} already has the base unit {}", quality,
+                          mNames[base->second]);
+      return false;
+    }
+    base->second = id;
+    defined.factor = ratio;
+    defined.offset = offset;
+    AddUnit(id, defined);
+    return true;
+  }
+  const Unit* to = FindUnit(relative);
+  if (!to || to->quality != quality_id) {
+    error = fmt::format("unit {}: {} is no unit of {}", unit, relative,
+                        quality);
+    return false;
+  }
+  defined.factor = ratio * to->factor;
+  defined.offset = offset * to->factor + to->offset;
+  AddUnit(Intern(unit), defined);
+  return true;
+}
+
+void NumericAttributeStore::AddUnitAlias(const std::string& alias,
+                                         const std::string& unit) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  uint32_t id;
+  if (Find(unit, id) && mUnits.count(id)) Alias(alias, id);
+}
+
+void NumericAttributeStore::Alias(const std::string& alias, uint32_t unit) {
+  auto inserted = mAliases.emplace(alias, unit);
+  if (!inserted.second && inserted.first->second != unit) {
+    inserted.first->second = kNone;
+  }
+}
+
+void NumericAttributeStore::AddUnit(uint32_t id, const Unit& unit) {
+  mUnits[id] = unit;
+  // Scone looks names up regardless of case, e.g. {watt} for {Watt}.
+  std::string lower = mNames[id];
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (lower != mNames[id]) Alias(lower, id);
+}
+
+bool NumericAttributeStore::UnitQuality(const std::string& unit,
+                                        std::string& quality) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  const Unit* found = FindUnit(unit);
+  if (!found) return false;
+  quality = mNames[found->quality];
+  return true;
+}
+
+bool NumericAttributeStore::Convert(double value, const std::string& from,
+                                    const std::string& to, double& result,
+                                    std::string& error) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  const Unit* source = FindUnit(from);
+  const Unit* target = FindUnit(to);
+  if (!source || !target) {
+    error = fmt::format("unknown unit {}", source ? to : from);
+    return false;
+  }
+  if (source->quality != target->quality) {
+    error = fmt::format("cannot convert {} to {}", from, to);
+    return false;
+  }
+  result =
+      (value * source->factor + source->offset - target->offset) /
+      target->factor;
+  return true;
+}
+
+bool NumericAttributeStore::DeclareAttribute(const std::string& attribute,
+                                             const std::string& quality,
+                                             std::string& error) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  uint32_t quality_id = kNone;
+  if (!quality.empty() &&
+      (!Find(quality, quality_id) || mBaseUnits.count(quality_id) == 0)) {
+    error = fmt::format("unknown quality {}", quality);
+    return false;
+  }
+  Column& column = mColumns[Intern(attribute)];
+  if (column.typed && column.quality != quality_id &&
+      !column.current.empty()) {
+    error = fmt::format("attribute {} already has values of another quality",
+                        attribute);
+    return false;
+  }
+  column.typed = true;
+  column.quality = quality_id;
+  return true;
+}
+
+bool NumericAttributeStore::Set(const std::string& cnpt,
+                                const std::string& attribute, double value,
+                                const std::string& unit, std::string& error) {
+  if (!std::isfinite(value)) {
+    error = fmt::format("{} of {}: {} is no number", attribute, cnpt, value);
+    return false;
+  }
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  Unit given;
+  if (!unit.empty()) {
+    const Unit* found = FindUnit(unit);
+    if (!found) {
+      error = fmt::format("unknown unit {}", unit);
+      return false;
+    }
+    given = *found;
+  }
+
+  // Undeclared attributes are qualities themselves or take the quality of
+  // the unit.
+  uint32_t quality = given.quality;
+  uint32_t attribute_id;
+  if (Find(attribute, attribute_id)) {
+    auto column = mColumns.find(attribute_id);
+    if (column != mColumns.end() && column->second.typed) {
+      quality = column->second.quality;
+    } else if (mBaseUnits.count(attribute_id)) {
+      quality = attribute_id;
+    }
+  }
+  if (!unit.empty() && given.quality != quality) {
+    error = fmt::format("{} is no unit of attribute {}", unit, attribute);
+    return false;
+  }
+
+  Column& column = mColumns[Intern(attribute)];
+  column.typed = true;
+  column.quality = quality;
+  uint32_t id = Intern(cnpt);
+  double normalized = value * given.factor + given.offset;
+  auto inserted = column.current.emplace(id, normalized);
+  if (!inserted.second) {
+    if (inserted.first->second == normalized) return true;
+    inserted.first->second = normalized;
+  }
+  column.dirty.push_back(id);
+  ++mPending;
+  return true;
+}
+
+bool NumericAttributeStore::Get(const std::string& cnpt,
+                                const std::string& attribute,
+                                double& value) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  uint32_t attribute_id, id;
+  if (!Find(attribute, attribute_id) || !Find(cnpt, id)) return false;
+  auto column = mColumns.find(attribute_id);
+  if (column == mColumns.end()) return false;
+  auto found = column->second.current.find(id);
+  if (found == column->second.current.end()) return false;
+  value = found->second;
+  return true;
+}
+
+bool NumericAttributeStore::Erase(const std::string& cnpt,
+                                  const std::string& attribute) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  uint32_t attribute_id, id;
+  if (!Find(attribute, attribute_id) || !Find(cnpt, id)) return false;
+  auto column = mColumns.find(attribute_id);
+  if (column == mColumns.end() || column->second.current.erase(id) == 0) {
+    return false;
+  }
+  column->second.dirty.push_back(id);
+  ++mPending;
+  return true;
+}
+
+void NumericAttributeStore::Merge(Column& column) const {
+  if (column.dirty.empty()) return;
+  mPending -= column.dirty.size();
+  std::vector<uint32_t> dirty;
+  dirty.swap(column.dirty);
+  std::sort(dirty.begin(), dirty.end());
+  dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+  // Drop the stale entries of changed concepts...
+  size_t kept = 0;
+  for (size_t i = 0; i < column.ids.size(); ++i) {
+    if (std::binary_search(dirty.begin(), dirty.end(), column.ids[i])) {
+      continue;
+    }
+    column.values[kept] = column.values[i];
+    column.ids[kept] = column.ids[i];
+    ++kept;
+  }
+  column.values.resize(kept);
+  column.ids.resize(kept);
+
+  // ...and merge their current values in.
+  std::vector<std::pair<double, uint32_t>> fresh;
+  for (uint32_t id : dirty) {
+    auto found = column.current.find(id);
+    if (found != column.current.end()) fresh.emplace_back(found->second, id);
+  }
+  std::sort(fresh.begin(), fresh.end());
+  std::vector<double> values;
+  std::vector<uint32_t> ids;
+  values.reserve(kept + fresh.size());
+  ids.reserve(kept + fresh.size());
+  size_t i = 0;
+  for (const auto& entry : fresh) {
+    while (i < kept && std::make_pair(column.values[i], column.ids[i]) <
+                           entry) {
+      values.push_back(column.values[i]);
+      ids.push_back(column.ids[i++]);
+    }
+    values.push_back(entry.first);
+    ids.push_back(entry.second);
+  }
+  values.insert(values.end(), column.values.begin() + i, column.values.end());
+  ids.insert(ids.end(), column.ids.begin() + i, column.ids.end());
+  column.values.swap(values);
+  column.ids.swap(ids);
+}
+
+void NumericAttributeStore::Sort(const std::string& attribute,
+                                 std::shared_lock<std::shared_mutex>& lock,
+                                 ProfileNode* profile) const {
+  uint32_t id;
+  if (!Find(attribute, id)) return;
+  auto column = mColumns.find(id);
+  if (column == mColumns.end() || column->second.dirty.empty()) return;
+  lock.unlock();
+  {
+    ProfileNode* merge = profile_child(profile, "merge_pending");
+    ProfileTimer merge_timer(merge);
+    std::unique_lock<std::shared_mutex> exclusive(mMutex);
+    Column& sorted = mColumns[id];
+    if (merge) {
+      merge->loops = 1;
+      merge->rows_in = sorted.dirty.size();
+    }
+    Merge(sorted);
+    if (merge) merge->rows_out = sorted.ids.size();
+  }
+  lock.lock();
+}
+
+bool NumericAttributeStore::Prepare(const AttributeQuery& query,
+                                    Slice& slice, std::string& error) const {
+  uint32_t id;
+  auto column =
+      Find(query.attribute, id) ? mColumns.find(id) : mColumns.end();
+  if (column == mColumns.end()) {
+    error = fmt::format("unknown attribute {}", query.attribute);
+    return false;
+  }
+  slice.column = &column->second;
+  slice.unit = Unit();
+  if (!query.unit.empty()) {
+    const Unit* unit = FindUnit(query.unit);
+    if (!unit || unit->quality != column->second.quality) {
+      error = fmt::format("{} is no unit of attribute {}", query.unit,
+                          query.attribute);
+      return false;
+    }
+    slice.unit = *unit;
+  }
+  const std::vector<double>& values = column->second.values;
+  double low = query.low * slice.unit.factor + slice.unit.offset;
+  double high = query.high * slice.unit.factor + slice.unit.offset;
+  slice.first =
+      std::lower_bound(values.begin(), values.end(), low) - values.begin();
+  slice.last =
+      std::upper_bound(values.begin(), values.end(), high) - values.begin();
+  slice.last = std::max(slice.first, slice.last);
+  return true;
+}
+
+void NumericAttributeStore::Under(const std::string& under,
+                                  std::vector<uint8_t>& mask,
+                                  ProfileNode* profile) const {
+  ProfileTimer timer(profile);
+  mask.assign(mNames.size(), 0);
+  uint64_t marked = 0;
+  uint32_t id;
+  auto mark = [&](const std::string& name) {
+    if (Find(name, id)) {
+      marked += !mask[id];
+      mask[id] = 1;
+    }
+  };
+  mark(under);
+  uint64_t visited = 1;
+  ConceptPtr top;
+  if (mHyperbase.GetConcept(under, top)) {
+    std::deque<ConceptPtr> frontier{top};
+    std::unordered_set<std::string> seen{under};
+    while (!frontier.empty()) {
+      ConceptPtr node = std::move(frontier.front());
+      frontier.pop_front();
+      node->ForEachChild([&](const ElementPtr& child) {
+        const std::string name = child->SemName();
+        if (!seen.insert(name).second) return;
+        ++visited;
+        mark(name);
+        frontier.push_back(std::static_pointer_cast<Concept>(child));
+      });
+    }
+  }
+  if (profile) {
+    profile->loops = 1;
+    profile->rows_in = visited;
+    profile->rows_out = marked;
+  }
+}
+
+bool NumericAttributeStore::Within(
+    const std::string& cnpt, const std::string& under,
+    std::unordered_map<std::string, bool>& within) const {
+  if (cnpt == under) return true;
+  auto found = within.find(cnpt);
+  if (found != within.end()) return found->second;
+  // Settled as outside first, which also cuts lineage cycles.
+  within[cnpt] = false;
+  ConceptPtr node;
+  bool result = false;
+  if (mHyperbase.GetConcept(cnpt, node)) {
+    node->ForEachParent([&](const ElementPtr& parent) {
+      if (!result) result = Within(parent->SemName(), under, within);
+    });
+  }
+  within[cnpt] = result;
+  return result;
+}
+
+bool NumericAttributeStore::Range(const AttributeQuery& query,
+                                  std::vector<AttributeValue>& out,
+                                  std::string& error,
+                                  ProfileNode* profile) const {
+  if (profile) {
+    *profile = ProfileNode(
+        "attribute_range",
+        fmt::format("{} [{}, {}] {}", query.attribute, query.low, query.high,
+                    query.unit));
+    profile->loops = 1;
+  }
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> hyperbase_lock(mHyperbase.Mutex(),
+                                                     std::defer_lock);
+  if (!query.under.empty()) hyperbase_lock.lock();
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  wait_timer.Stop();
+  Sort(query.attribute, lock, profile);
+  Slice slice;
+  if (!Prepare(query, slice, error)) return false;
+
+  // Top-k probes the ancestors of its few candidates, whole ranges mark
+  // the subtree once and filter by it.
+  bool probe = !query.under.empty() && query.limit > 0;
+  std::vector<uint8_t> mask;
+  if (!query.under.empty() && !probe) {
+    Under(query.under, mask,
+          profile_child(profile, "lineage", query.under, "children"));
+  }
+  ProfileNode* scan = profile_child(profile, "column_scan", "",
+                                    probe ? "sorted_column, parents"
+                                          : "sorted_column");
+  ProfileTimer scan_timer(scan);
+  const Column& column = *slice.column;
+  const Unit& unit = slice.unit;
+  size_t before = out.size();
+  size_t limit = query.limit ? query.limit : slice.last - slice.first;
+  uint64_t examined = 0;
+  auto emit = [&](size_t pos) {
+    out.push_back({mNames[column.ids[pos]],
+                   (column.values[pos] - unit.offset) / unit.factor});
+  };
+  std::unordered_map<std::string, bool> within;
+  // Chunks from the near end of the slice, filtered if restricted.
+  uint32_t selected[kChunk];
+  for (size_t done = 0;
+       done < slice.last - slice.first && out.size() - before < limit;) {
+    size_t count = std::min(kChunk, slice.last - slice.first - done);
+    size_t first = query.descending ? slice.last - done - count
+                                    : slice.first + done;
+    done += count;
+    size_t n = count;
+    if (!mask.empty()) {
+      n = filter_ids(column.ids.data() + first, count, mask, selected);
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        selected[i] = static_cast<uint32_t>(i);
+      }
+    }
+    for (size_t i = 0; i < n && out.size() - before < limit; ++i) {
+      size_t pos = first + selected[query.descending ? n - 1 - i : i];
+      ++examined;
+      if (!probe || Within(mNames[column.ids[pos]], query.under, within)) {
+        emit(pos);
+      }
+    }
+  }
+  if (profile) {
+    scan->loops = 1;
+    scan->rows_in = examined;
+    profile->rows_in = column.ids.size();
+    profile->rows_out = scan->rows_out = out.size() - before;
+  }
+  return true;
+}
+
+bool NumericAttributeStore::Aggregate(const AttributeQuery& query,
+                                      AttributeAggregate& result,
+                                      std::string& error,
+                                      ProfileNode* profile) const {
+  if (profile) {
+    *profile = ProfileNode(
+        "attribute_aggregate",
+        fmt::format("{} [{}, {}] {}", query.attribute, query.low, query.high,
+                    query.unit));
+    profile->loops = 1;
+  }
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> hyperbase_lock(mHyperbase.Mutex(),
+                                                     std::defer_lock);
+  if (!query.under.empty()) hyperbase_lock.lock();
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  wait_timer.Stop();
+  Sort(query.attribute, lock, profile);
+  Slice slice;
+  if (!Prepare(query, slice, error)) return false;
+
+  std::vector<uint8_t> mask;
+  if (!query.under.empty()) {
+    Under(query.under, mask,
+          profile_child(profile, "lineage", query.under, "children"));
+  }
+  ProfileNode* scan = profile_child(profile, "column_scan", "",
+                                    "sorted_column");
+  ProfileTimer scan_timer(scan);
+  const Column& column = *slice.column;
+  result = AttributeAggregate();
+  size_t lowest = slice.last;
+  size_t highest = slice.last;
+  if (mask.empty()) {
+    result.count = slice.last - slice.first;
+    result.sum = sum_values(column.values.data() + slice.first, result.count);
+    lowest = slice.first;
+    highest = slice.last - 1;
+  } else {
+    uint32_t selected[kChunk];
+    double gathered[kChunk];
+    for (size_t first = slice.first; first < slice.last; first += kChunk) {
+      size_t count = std::min(kChunk, slice.last - first);
+      size_t n = filter_ids(column.ids.data() + first, count, mask, selected);
+      if (n == 0) continue;
+      for (size_t i = 0; i < n; ++i) {
+        gathered[i] = column.values[first + selected[i]];
+      }
+      result.sum += sum_values(gathered, n);
+      result.count += n;
+      if (lowest == slice.last) lowest = first + selected[0];
+      highest = first + selected[n - 1];
+    }
+  }
+  // Values are sorted, the extremes are the ends of the selection.
+  const Unit& unit = slice.unit;
+  if (result.count > 0) {
+    result.min = (column.values[lowest] - unit.offset) / unit.factor;
+    result.max = (column.values[highest] - unit.offset) / unit.factor;
+    result.sum = (result.sum - result.count * unit.offset) / unit.factor;
+  }
+  if (profile) {
+    scan->loops = 1;
+    scan->rows_in = slice.last - slice.first;
+    profile->rows_in = column.ids.size();
+    profile->rows_out = scan->rows_out = result.count;
+  }
+  return true;
+}
+
+AttributeStats NumericAttributeStore::Stats() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  AttributeStats stats;
+  stats.qualities = mBaseUnits.size();
+  stats.units = mUnits.size();
+  stats.attributes = mColumns.size();
+  stats.pending = mPending;
+  for (const auto& kv : mColumns) {
+    const Column& column = kv.second;
+    stats.values += column.current.size();
+    stats.column_bytes += column.values.capacity() * sizeof(double) +
+                          column.ids.capacity() * sizeof(uint32_t);
+  }
+  return stats;
+}
+
+namespace {
+
+constexpr struct {
+  const char* name;
+  int exponent;
+  const char* abbrev;
+} kMetricPrefixes[] = {
+    {"kilo", 3, "k"},    {"mega", 6, "M"},   {"giga", 9, "G"},
+    {"tera", 12, "T"},   {"centi", -2, "c"}, {"milli", -3, "m"},
+    {"micro", -6, "u"},  {"nano", -9, "n"},  {"pico", -12, "p"},
+};
+
+// Scone leaves the zero points of temperature scales to lambdas in
+// {unit converts to} statements, in relative units here.
+constexpr struct {
+  const char* unit;
+  double offset;
+} kScaleOffsets[] = {
+    {"degree Celsius", 273.15},
+    {"degree Fahrenheit", 459.67 * 5 / 9},
+};
+
+// A number such as 12, 2.54, 1/8, 9.405284e15 or (expt 1/100 2).
+bool scone_number(const SconeForm& form, double& value) {
+  if (form.IsList()) {
+    double base, power;
+    if (form.Head() != "expt" || form.items.size() != 3 ||
+        !scone_number(form.items[1], base) ||
+        !scone_number(form.items[2], power)) {
+      return false;
+    }
+    value = std::pow(base, power);
+    return true;
+  }
+  if (form.type != SconeForm::SYMBOL || form.text.empty()) return false;
+  const char* text = form.text.c_str();
+  char* end;
+  value = std::strtod(text, &end);
+  if (end == text) return false;
+  if (*end == '/') {
+    const char* denominator = end + 1;
+    double divisor = std::strtod(denominator, &end);
+    if (end == denominator || divisor == 0) return false;
+    value /= divisor;
+  }
+  return *end == '\0';
+}
+
+}  // namespace
+
+void register_unit_forms(SconeLoader& loader, NumericAttributeStore& store) {
+  // (new-measurable-quality {quality} "english" ...)
+  loader.ChainForm("new-measurable-quality", [&store](SconeLoader& loader,
+                                                      const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 1, args)) return false;
+    store.DefineQuality(args[0]);
+    loader.Ensure(args[0], Mutation::KIND_ENTITY, {"measurable quality"});
+    return true;
+  });
+  // (new-unit {unit} {quality} [{relative} | nil] [ratio] "abbrev" ...)
+  loader.ChainForm("new-unit", [&store](SconeLoader& loader,
+                                        const SconeForm& form) {
+    std::vector<const SconeForm*> args = form.Args();
+    if (args.size() < 2 || !args[0]->IsName() || !args[1]->IsName()) {
+      return false;
+    }
+    const std::string& unit = args[0]->text;
+    std::string relative;
+    if (args.size() > 2 && args[2]->IsName()) relative = args[2]->text;
+    double ratio = 1;
+    if (args.size() > 3 && !scone_number(*args[3], ratio)) return false;
+    double offset = 0;
+    for (const auto& scale : kScaleOffsets) {
+      if (unit == scale.unit) offset = scale.offset;
+    }
+    std::string error;
+    if (!store.DefineUnit(unit, args[1]->text, relative, ratio, offset,
+                          error)) {
+      return false;
+    }
+    for (size_t i = 4; i < args.size(); ++i) {
+      if (args[i]->type == SconeForm::STRING) {
+        store.AddUnitAlias(args[i]->text, unit);
+      }
+    }
+    loader.Ensure(unit, Mutation::KIND_ENTITY, {"unit"});
+    return true;
+  });
+  // (metric-prefix-expand {base unit} "abbrev")
+  loader.ChainForm("metric-prefix-expand", [&store](SconeLoader& loader,
+                                                    const SconeForm& form) {
+    std::vector<const SconeForm*> args = form.Args();
+    std::string quality;
+    if (args.empty() || !args[0]->IsName() ||
+        !store.UnitQuality(args[0]->text, quality)) {
+      return false;
+    }
+    const std::string& base = args[0]->text;
+    std::string abbrev;
+    if (args.size() > 1 && args[1]->type == SconeForm::STRING) {
+      abbrev = args[1]->text;
+    }
+    std::string error;
+    for (const auto& prefix : kMetricPrefixes) {
+      std::string unit = prefix.name + base;
+      if (!store.DefineUnit(unit, quality, base,
+                            std::pow(10.0, prefix.exponent), 0, error)) {
+        return false;
+      }
+      if (!abbrev.empty()) store.AddUnitAlias(prefix.abbrev + abbrev, unit);
+      loader.Ensure(unit, Mutation::KIND_ENTITY, {"unit"});
+    }
+    return true;
+  });
+}
+
+}  // namespace base
+}  // namespace hyperon
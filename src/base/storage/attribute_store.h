@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+class SconeLoader;
+
+/**
+ * @brief Values of one attribute within a range, e.g. the cities with a
+ * population above a million under {Europe}.
+ */
+struct AttributeQuery {
+  std::string attribute;
+  // Inclusive bounds, in `unit`.
+  double low{-std::numeric_limits<double>::infinity()};
+  double high{std::numeric_limits<double>::infinity()};
+  // Unit of the bounds and of the returned values, the base unit if empty.
+  std::string unit;
+  // Only concepts at or below this one in the lineage, if set.
+  std::string under;
+  // Largest values first, for top-k queries.
+  bool descending{false};
+  // Stop after this many values, 0 for all.
+  size_t limit{0};
+};
+
+struct AttributeValue {
+  std::string cnpt;
+  double value{0};
+};
+
+struct AttributeAggregate {
+  uint64_t count{0};
+  double sum{0};
+  double min{0};
+  double max{0};
+
+  inline double Mean() const { return count ? sum / count : 0; }
+};
+
+/**
+ * @brief Counters of an attribute store.
+ */
+struct AttributeStats {
+  uint64_t qualities{0};
+  uint64_t units{0};
+  uint64_t attributes{0};
+  uint64_t values{0};
+  // Values set since the columns were last sorted.
+  uint64_t pending{0};
+  uint64_t column_bytes{0};
+};
+
+/**
+ * @brief Numeric attributes of concepts, with units.
+ *
+ * Units belong to a measurable quality and convert to its base unit by a
+ * factor and an offset, the latter only for scales such as degrees
+ * Celsius. An attribute has a quality, or none for plain numbers such as
+ * a population, and values are normalized to the base unit when set, so
+ * a length given in miles and one given in meters compare directly.
+ *
+ * Every attribute keeps its values in a column sorted by value, as
+ * parallel value and concept id arrays. Ranges are two binary searches,
+ * top-k reads a range from its far end and aggregates run over the
+ * contiguous values. Writes only mark the concept and the column is
+ * re-sorted on the next read, so bulk loads cost one sort.
+ *
+ * Queries restricted to a part of the lineage take the shared lock of the
+ * hyperbase. Top-k queries walk up from their candidates until enough
+ * are found, other ranges mark the concepts below once and filter the
+ * column by them.
+ */
+class NumericAttributeStore {
+public:
+  explicit NumericAttributeStore(const Hyperbase& hyperbase);
+
+  // Declare a measurable quality, e.g. {length}.
+  void DefineQuality(const std::string& quality);
+
+  /**
+   * @brief Define `unit` as `ratio` times `relative`, plus `offset`
+   * relative units, e.g. degree Celsius as 1 kelvin plus 273.15. Without
+   * `relative`, the unit becomes the base unit of its quality.
+   *
+   * @param error Error message on failure
+   * @return false for unknown qualities or relative units of another
+   * quality, or a second base unit.
+   */
+  bool DefineUnit(const std::string& unit, const std::string& quality,
+                  const std::string& relative, double ratio, double offset,
+                  std::string& error);
+
+  /**
+   * @brief Accept `alias` for a unit, e.g. "km". An alias given to two
+   * units, like "m" for meter and minute, resolves to neither. Unit names
+   * are also accepted in lower case.
+   */
+  void AddUnitAlias(const std::string& alias, const std::string& unit);
+
+  // Quality a unit or alias measures, false if unknown.
+  bool UnitQuality(const std::string& unit, std::string& quality) const;
+
+  /**
+   * @brief Convert between units of the same quality.
+   * @return false for unknown units or different qualities
+   */
+  bool Convert(double value, const std::string& from, const std::string& to,
+               double& result, std::string& error) const;
+
+  /**
+   * @brief Give `attribute` values of `quality`, empty for plain numbers.
+   * Undeclared attributes take the quality of the unit of their first
+   * value, or are qualities themselves.
+   *
+   * @return false if the attribute has values of another quality.
+   */
+  bool DeclareAttribute(const std::string& attribute,
+                        const std::string& quality, std::string& error);
+
+  /**
+   * @brief Set the value of an attribute of a concept.
+   *
+   * @param unit Unit of `value`, the base unit if empty
+   * @param error Error message on failure
+   * @return false if the unit is unknown or of another quality.
+   */
+  bool Set(const std::string& cnpt, const std::string& attribute,
+           double value, const std::string& unit, std::string& error);
+  // Value in the base unit, false if not set.
+  bool Get(const std::string& cnpt, const std::string& attribute,
+           double& value) const;
+  // @return false if the value was not set.
+  bool Erase(const std::string& cnpt, const std::string& attribute);
+
+  /**
+   * @brief Values within the query range, ordered by value then concept.
+   *
+   * @param out Found values are appended, in the query unit
+   * @param error Error message on failure
+   * @param profile Filled with the execution profile if set
+   * @return false for unknown attributes or units.
+   */
+  bool Range(const AttributeQuery& query, std::vector<AttributeValue>& out,
+             std::string& error,
+             common::ProfileNode* profile = nullptr) const;
+
+  /**
+   * @brief Count, sum, min and max of the values within the query range,
+   * in the query unit. The order and the limit of the query are ignored.
+   */
+  bool Aggregate(const AttributeQuery& query, AttributeAggregate& result,
+                 std::string& error,
+                 common::ProfileNode* profile = nullptr) const;
+
+  AttributeStats Stats() const;
+
+private:
+  static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+  struct Unit {
+    uint32_t quality{kNone};
+    // base = value * factor + offset
+    double factor{1};
+    double offset{0};
+  };
+
+  struct Column {
+    // Set once declared or given its first value.
+    bool typed{false};
+    uint32_t quality{kNone};
+    // Sorted by value, then concept id.
+    std::vector<double> values;
+    std::vector<uint32_t> ids;
+    // Value of every concept, the column may lag behind for `dirty` ones.
+    std::unordered_map<uint32_t, double> current;
+    std::vector<uint32_t> dirty;
+  };
+
+  // The values within [low, high] in base units of a query.
+  struct Slice {
+    const Column* column{nullptr};
+    size_t first{0};
+    size_t last{0};
+    // Base unit to query unit.
+    Unit unit;
+  };
+
+  uint32_t Intern(const std::string& name);
+  bool Find(const std::string& name, uint32_t& id) const;
+  void AddUnit(uint32_t id, const Unit& unit);
+  void Alias(const std::string& alias, uint32_t unit);
+  // Unit of a name or alias, nullptr if unknown.
+  const Unit* FindUnit(const std::string& name) const;
+
+  // Sort the pending values of a column in. Needs the exclusive lock.
+  void Merge(Column& column) const;
+  // Sort the column of `attribute` if needed, trading `lock` for the
+  // exclusive lock meanwhile.
+  void Sort(const std::string& attribute,
+            std::shared_lock<std::shared_mutex>& lock,
+            common::ProfileNode* profile) const;
+
+  // Resolve the attribute, unit and bounds of a query.
+  bool Prepare(const AttributeQuery& query, Slice& slice,
+               std::string& error) const;
+  // Concepts at or below `under`, by id. Needs the shared hyperbase lock.
+  void Under(const std::string& under, std::vector<uint8_t>& mask,
+             common::ProfileNode* profile) const;
+  // Whether `cnpt` is `under` or below it, memoized in `within`. Needs the
+  // shared hyperbase lock.
+  bool Within(const std::string& cnpt, const std::string& under,
+              std::unordered_map<std::string, bool>& within) const;
+
+  const Hyperbase& mHyperbase;
+
+  mutable std::shared_mutex mMutex;
+  std::vector<std::string> mNames;
+  std::unordered_map<std::string, uint32_t> mIds;
+  // Quality to its base unit, kNone until defined.
+  std::unordered_map<uint32_t, uint32_t> mBaseUnits;
+  std::unordered_map<uint32_t, Unit> mUnits;
+  std::unordered_map<std::string, uint32_t> mAliases;
+  // Mutable since reads sort pending values in.
+  mutable std::unordered_map<uint32_t, Column> mColumns;
+  mutable uint64_t mPending{0};
+};
+
+/**
+ * @brief Feed the units of Scone files to a store: new-measurable-quality,
+ * new-unit with its English abbreviations and metric-prefix-expand. The
+ * qualities and units also become elements of the loaded hyperbase.
+ */
+void register_unit_forms(SconeLoader& loader, NumericAttributeStore& store);
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,557 @@
+#include "base/storage/event_log_store.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "common/compress/varint.h"
+
+namespace hyperon {
+namespace base {
+
+using common::get_varint;
+using common::profile_child;
+using common::ProfileNode;
+using common::ProfileTimer;
+using common::put_varint;
+using common::zigzag_decode;
+using common::zigzag_encode;
+
+/**
+ * @brief A write segment. Slots are claimed by `claimed`, which runs past
+ * the capacity once the segment is full, and flagged in `ready` once their
+ * record is written.
+ */
+struct EventLogStore::Segment {
+  explicit Segment(uint32_t capacity)
+      : records(new EventRecord[capacity]),
+        ready(new std::atomic<uint8_t>[capacity]) {}
+
+  std::atomic<uint64_t> index{0};
+  std::atomic<uint64_t> claimed{0};
+  std::atomic<uint64_t> published{0};
+  std::unique_ptr<EventRecord[]> records;
+  std::unique_ptr<std::atomic<uint8_t>[]> ready;
+};
+
+/**
+ * @brief Sealed events of one partition, sorted by start and encoded as
+ * columns, in memory or at `offset` in the partition file.
+ */
+struct EventLogStore::Block {
+  uint32_t count{0};
+  int64_t min_start{0};
+  int64_t max_start{0};
+  int64_t max_end{0};
+  std::string bytes;
+  bool spilled{false};
+  uint64_t offset{0};
+  uint64_t size{0};
+};
+
+namespace {
+
+constexpr int64_t kNoTime = std::numeric_limits<int64_t>::min();
+// Events of a block, which bounds the rows decoded past the time window.
+constexpr ptrdiff_t kBlockEvents = 4096;
+
+uint32_t EventRecord::*const kConceptColumns[] = {
+    &EventRecord::type,      &EventRecord::agent,    &EventRecord::object,
+    &EventRecord::recipient, &EventRecord::location, &EventRecord::context};
+
+// Columns of events sorted by start: ids and concepts as zigzag deltas to
+// the previous row, starts as deltas, ends as duration + 1 or 0 if open.
+void encode_block(std::vector<EventView>::const_iterator first,
+                  std::vector<EventView>::const_iterator last,
+                  std::string& out) {
+  uint64_t id = 0;
+  int64_t start = 0;
+  for (auto it = first; it != last; ++it) {
+    put_varint(out, zigzag_encode(static_cast<int64_t>(it->id - id)));
+    id = it->id;
+  }
+  for (auto it = first; it != last; ++it) {
+    put_varint(out, zigzag_encode(it->record.start - start));
+    start = it->record.start;
+  }
+  for (auto it = first; it != last; ++it) {
+    const EventRecord& record = it->record;
+    put_varint(out, record.end == Event::kOpenEnd
+                        ? 0
+                        : static_cast<uint64_t>(record.end - record.start) + 1);
+  }
+  for (auto column : kConceptColumns) {
+    uint32_t previous = 0;
+    for (auto it = first; it != last; ++it) {
+      uint32_t value = it->record.*column;
+      put_varint(out, zigzag_encode(static_cast<int64_t>(value) - previous));
+      previous = value;
+    }
+  }
+}
+
+bool decode_block(const std::string& bytes, uint32_t count,
+                  std::vector<EventView>& out) {
+  size_t first = out.size();
+  out.resize(first + count);
+  EventView* rows = out.data() + first;
+  size_t pos = 0;
+  uint64_t value;
+  uint64_t id = 0;
+  int64_t start = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!get_varint(bytes, pos, value)) return false;
+    id += zigzag_decode(value);
+    rows[i].id = id;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!get_varint(bytes, pos, value)) return false;
+    start += zigzag_decode(value);
+    rows[i].record.start = start;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!get_varint(bytes, pos, value)) return false;
+    rows[i].record.end =
+        value == 0 ? Event::kOpenEnd
+                   : rows[i].record.start + static_cast<int64_t>(value - 1);
+  }
+  for (auto column : kConceptColumns) {
+    int64_t previous = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (!get_varint(bytes, pos, value)) return false;
+      previous += zigzag_decode(value);
+      rows[i].record.*column = static_cast<uint32_t>(previous);
+    }
+  }
+  return true;
+}
+
+EventLogOptions sanitize(EventLogOptions options) {
+  options.segment_records = std::max<uint32_t>(options.segment_records, 1);
+  options.partition_millis = std::max<int64_t>(options.partition_millis, 1);
+  options.hot_millis = std::max<int64_t>(options.hot_millis, 0);
+  return options;
+}
+
+inline bool overlaps(const EventRecord& record, int64_t start, int64_t end) {
+  return record.start <= end && record.end >= start;
+}
+
+inline bool view_less(const EventView& a, const EventView& b) {
+  return a.record.start < b.record.start ||
+         (a.record.start == b.record.start && a.id < b.id);
+}
+
+}  // namespace
+
+EventLogStore::EventLogStore(const EventLogOptions& options)
+    : mOptions(sanitize(options)) {
+  if (!mOptions.directory.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(mOptions.directory, ec);
+  }
+  mNames.emplace_back();
+  std::lock_guard<std::mutex> lock(mRollMutex);
+  Segment* segment = NewSegment();
+  mOpen.push_back(segment);
+  mActive.store(segment, std::memory_order_release);
+}
+
+EventLogStore::~EventLogStore() {
+  std::error_code ec;
+  for (const auto& kv : mPartitions) {
+    if (kv.second.file_bytes > 0) {
+      std::filesystem::remove(PartitionPath(kv.first), ec);
+    }
+  }
+}
+
+uint32_t EventLogStore::Intern(const std::string& name) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mNamesMutex);
+    auto found = mIds.find(name);
+    if (found != mIds.end()) return found->second;
+  }
+  std::unique_lock<std::shared_mutex> lock(mNamesMutex);
+  auto inserted = mIds.emplace(name, static_cast<uint32_t>(mNames.size()));
+  if (inserted.second) mNames.push_back(name);
+  return inserted.first->second;
+}
+
+std::string EventLogStore::Name(uint32_t id) const {
+  std::shared_lock<std::shared_mutex> lock(mNamesMutex);
+  return id < mNames.size() ? mNames[id] : std::string();
+}
+
+int64_t EventLogStore::PartitionOf(int64_t time) const {
+  int64_t width = mOptions.partition_millis;
+  // Floor, also for times before the epoch.
+  return time / width - (time % width < 0 ? 1 : 0);
+}
+
+std::string EventLogStore::PartitionPath(int64_t key) const {
+  return fmt::format("{}/partition-{}.evl", mOptions.directory, key);
+}
+
+EventLogStore::Segment* EventLogStore::NewSegment() {
+  const uint32_t capacity = mOptions.segment_records;
+  Segment* segment;
+  if (!mFreeSegments.empty()) {
+    segment = mFreeSegments.back();
+    mFreeSegments.pop_back();
+  } else {
+    mSegments.push_back(std::make_unique<Segment>(capacity));
+    segment = mSegments.back().get();
+  }
+  for (uint32_t slot = 0; slot < capacity; ++slot) {
+    segment->ready[slot].store(0, std::memory_order_relaxed);
+  }
+  segment->published.store(0, std::memory_order_relaxed);
+  segment->index.store(mNextSegment++, std::memory_order_relaxed);
+  // Last, so that a producer claiming a slot sees the rest reset.
+  segment->claimed.store(0, std::memory_order_release);
+  return segment;
+}
+
+uint64_t EventLogStore::Append(const EventRecord& record) {
+  const uint64_t capacity = mOptions.segment_records;
+  for (;;) {
+    Segment* segment = mActive.load(std::memory_order_acquire);
+    uint64_t slot = segment->claimed.fetch_add(1, std::memory_order_acq_rel);
+    if (slot < capacity) {
+      uint64_t id =
+          segment->index.load(std::memory_order_relaxed) * capacity + slot;
+      segment->records[slot] = record;
+      segment->ready[slot].store(1, std::memory_order_release);
+      segment->published.fetch_add(1, std::memory_order_release);
+      return id;
+    }
+    // The first producer past the end rolls, the others wait for it.
+    if (slot == capacity) {
+      Roll(segment, capacity);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void EventLogStore::Flush() {
+  const uint64_t capacity = mOptions.segment_records;
+  Segment* segment = mActive.load(std::memory_order_acquire);
+  uint64_t claimed = segment->claimed.load(std::memory_order_acquire);
+  // Jump past the end, so that no producer claims the rolling slot.
+  while (claimed > 0 && claimed < capacity) {
+    if (segment->claimed.compare_exchange_weak(claimed, capacity + 1,
+                                               std::memory_order_acq_rel)) {
+      Roll(segment, claimed);
+      return;
+    }
+  }
+}
+
+void EventLogStore::Roll(Segment* segment, uint64_t count) {
+  const uint64_t capacity = mOptions.segment_records;
+  {
+    std::lock_guard<std::mutex> lock(mRollMutex);
+    Segment* next = NewSegment();
+    {
+      std::unique_lock<std::shared_mutex> lock(mMutex);
+      mOpen.push_back(next);
+    }
+    mActive.store(next, std::memory_order_release);
+  }
+  // Producers holding a slot are a record copy away from publishing it.
+  while (segment->published.load(std::memory_order_acquire) < count) {
+    std::this_thread::yield();
+  }
+
+  std::vector<EventView> views(count);
+  uint64_t base = segment->index.load(std::memory_order_relaxed) * capacity;
+  for (uint64_t slot = 0; slot < count; ++slot) {
+    views[slot].id = base + slot;
+    views[slot].record = segment->records[slot];
+  }
+  std::sort(views.begin(), views.end(), view_less);
+
+  std::vector<std::pair<int64_t, std::unique_ptr<Block>>> blocks;
+  for (auto first = views.begin(); first != views.end();) {
+    int64_t key = PartitionOf(first->record.start);
+    auto last = first;
+    auto block = std::make_unique<Block>();
+    block->min_start = first->record.start;
+    block->max_end = kNoTime;
+    for (; last != views.end() && last - first < kBlockEvents &&
+           PartitionOf(last->record.start) == key;
+         ++last) {
+      block->max_end = std::max(block->max_end, last->record.end);
+    }
+    block->count = static_cast<uint32_t>(last - first);
+    block->max_start = (last - 1)->record.start;
+    encode_block(first, last, block->bytes);
+    block->bytes.shrink_to_fit();
+    block->size = block->bytes.size();
+    blocks.emplace_back(key, std::move(block));
+    first = last;
+  }
+
+  {
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    for (auto& kv : blocks) {
+      Partition& partition = mPartitions[kv.first];
+      partition.max_end = std::max(partition.max_end, kv.second->max_end);
+      partition.blocks.push_back(std::move(kv.second));
+    }
+    mOpen.erase(std::remove(mOpen.begin(), mOpen.end(), segment),
+                mOpen.end());
+    if (!views.empty()) {
+      mNewestStart = std::max(mNewestStart, views.back().record.start);
+    }
+    ++mSealedSegments;
+    mSealedEvents += count;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mRollMutex);
+    mFreeSegments.push_back(segment);
+  }
+  if (!mOptions.directory.empty()) Spill();
+}
+
+void EventLogStore::Spill() {
+  std::lock_guard<std::mutex> spill_lock(mSpillMutex);
+  std::vector<std::pair<int64_t, Block*>> cold;
+  {
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    if (mNewestStart < kNoTime + mOptions.hot_millis) return;
+    // Partitions ending at or before the horizon.
+    int64_t horizon = PartitionOf(mNewestStart - mOptions.hot_millis);
+    for (const auto& kv : mPartitions) {
+      if (kv.first >= horizon) break;
+      for (const auto& block : kv.second.blocks) {
+        if (!block->spilled) cold.emplace_back(kv.first, block.get());
+      }
+    }
+  }
+  if (cold.empty()) return;
+
+  // Blocks only change under mSpillMutex, so they are read without mMutex.
+  std::vector<std::pair<Block*, uint64_t>> written;
+  for (size_t i = 0; i < cold.size();) {
+    int64_t key = cold[i].first;
+    Partition* partition;
+    {
+      std::shared_lock<std::shared_mutex> lock(mMutex);
+      partition = &mPartitions.find(key)->second;
+    }
+    uint64_t file_bytes = partition->file_bytes;
+    size_t mark = written.size();
+    // Positioned writes, so that a failed spill is overwritten by the next.
+    std::fstream file(PartitionPath(key),
+                      file_bytes == 0
+                          ? std::ios::out | std::ios::binary | std::ios::trunc
+                          : std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(file_bytes);
+    for (; i < cold.size() && cold[i].first == key; ++i) {
+      Block* block = cold[i].second;
+      file.write(block->bytes.data(), block->bytes.size());
+      written.emplace_back(block, file_bytes);
+      file_bytes += block->bytes.size();
+    }
+    file.flush();
+    if (file) {
+      partition->file_bytes = file_bytes;
+    } else {
+      // Keep the blocks in memory, they are retried on the next seal.
+      written.resize(mark);
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  for (const auto& placed : written) {
+    Block* block = placed.first;
+    block->offset = placed.second;
+    block->spilled = true;
+    std::string().swap(block->bytes);
+  }
+}
+
+bool EventLogStore::ReadBlock(int64_t key, const Block& block,
+                              std::string& bytes) const {
+  std::ifstream file(PartitionPath(key), std::ios::binary);
+  if (!file.seekg(block.offset)) return false;
+  bytes.resize(block.size);
+  return static_cast<bool>(file.read(&bytes[0], block.size));
+}
+
+bool EventLogStore::Overlapping(int64_t start, int64_t end,
+                                std::vector<EventView>& out,
+                                std::string& error, size_t limit,
+                                ProfileNode* profile) const {
+  if (profile) {
+    *profile = ProfileNode("event_log_scan",
+                           fmt::format("[{}, {}]", start, end));
+    profile->loops = 1;
+  }
+  ProfileTimer timer(profile);
+  ProfileNode* wait = profile_child(profile, "lock_wait");
+  ProfileNode* sealed =
+      profile_child(profile, "sealed_blocks", "", "time_partition");
+  ProfileNode* open = profile_child(profile, "open_segments");
+  if (start > end) return true;
+
+  std::vector<EventView> found;
+  ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  wait_timer.Stop();
+  {
+    ProfileTimer sealed_timer(sealed);
+    uint64_t blocks = 0;
+    uint64_t examined = 0;
+    std::vector<EventView> decoded;
+    std::string scratch;
+    auto last = mPartitions.upper_bound(PartitionOf(end));
+    for (auto it = mPartitions.begin(); it != last; ++it) {
+      if (it->second.max_end < start) continue;
+      for (const auto& block : it->second.blocks) {
+        if (block->min_start > end || block->max_end < start) continue;
+        const std::string* bytes = &block->bytes;
+        if (block->spilled) {
+          if (!ReadBlock(it->first, *block, scratch)) {
+            error = fmt::format("cannot read {} bytes at {} of {}",
+                                block->size, block->offset,
+                                PartitionPath(it->first));
+            return false;
+          }
+          bytes = &scratch;
+          if (sealed) ++sealed->cache_misses;
+        }
+        decoded.clear();
+        if (!decode_block(*bytes, block->count, decoded)) {
+          error = fmt::format("corrupt block of partition {}", it->first);
+          return false;
+        }
+        ++blocks;
+        examined += decoded.size();
+        for (const auto& view : decoded) {
+          if (overlaps(view.record, start, end)) found.push_back(view);
+        }
+      }
+    }
+    if (sealed) {
+      sealed->loops = blocks;
+      sealed->rows_in = examined;
+      sealed->rows_out = found.size();
+    }
+  }
+  {
+    ProfileTimer open_timer(open);
+    const uint64_t capacity = mOptions.segment_records;
+    size_t before = found.size();
+    uint64_t examined = 0;
+    for (const Segment* segment : mOpen) {
+      uint64_t claimed = std::min(
+          segment->claimed.load(std::memory_order_acquire), capacity);
+      uint64_t base = segment->index.load(std::memory_order_relaxed) * capacity;
+      for (uint64_t slot = 0; slot < claimed; ++slot) {
+        if (!segment->ready[slot].load(std::memory_order_acquire)) continue;
+        ++examined;
+        const EventRecord& record = segment->records[slot];
+        if (overlaps(record, start, end)) {
+          found.push_back({base + slot, record});
+        }
+      }
+    }
+    if (open) {
+      open->loops = mOpen.size();
+      open->rows_in = examined;
+      open->rows_out = found.size() - before;
+    }
+  }
+  lock.unlock();
+
+  std::sort(found.begin(), found.end(), view_less);
+  if (limit > 0 && found.size() > limit) found.resize(limit);
+  out.insert(out.end(), found.begin(), found.end());
+  if (profile) profile->rows_out = found.size();
+  return true;
+}
+
+bool EventLogStore::Materialize(const EventView& view, Hyperbase& hyperbase,
+                                std::string& name, std::string& error) const {
+  const EventRecord& record = view.record;
+  std::string type = Name(record.type);
+  name = fmt::format("{}#{}", type.empty() ? "event" : type, view.id);
+  {
+    std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+    if (hyperbase.HasConcept(name)) return true;
+  }
+
+  std::vector<Mutation> batch(1);
+  batch[0].concept_kind = Mutation::KIND_EVENT;
+  batch[0].subject = name;
+  if (!type.empty()) {
+    Mutation parent;
+    parent.kind = Mutation::MUT_ADD_PARENT;
+    parent.subject = name;
+    parent.objects.push_back(type);
+    batch.push_back(std::move(parent));
+  }
+  Mutation members;
+  members.kind = Mutation::MUT_ADD_MEMBER;
+  members.subject = name;
+  for (uint32_t id :
+       {record.agent, record.object, record.recipient, record.location}) {
+    if (id != 0) members.objects.push_back(Name(id));
+  }
+  if (!members.objects.empty()) batch.push_back(std::move(members));
+  Mutation interval;
+  interval.kind = Mutation::MUT_SET_INTERVAL;
+  interval.subject = name;
+  interval.objects.push_back(std::to_string(record.start));
+  if (record.end != Event::kOpenEnd) {
+    interval.objects.push_back(std::to_string(record.end));
+  }
+  batch.push_back(std::move(interval));
+  hyperbase.ApplyBatch(batch);
+
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  if (!hyperbase.HasConcept(name)) {
+    error = fmt::format("hyperbase {} refused event {}", hyperbase.Name(),
+                        name);
+    return false;
+  }
+  return true;
+}
+
+EventLogStats EventLogStore::Stats() const {
+  EventLogStats stats;
+  {
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    stats.events = mSealedEvents;
+    stats.sealed_segments = mSealedSegments;
+    stats.partitions = mPartitions.size();
+    for (const auto& kv : mPartitions) {
+      for (const auto& block : kv.second.blocks) {
+        ++stats.blocks;
+        if (block->spilled) {
+          ++stats.spilled_blocks;
+          stats.spilled_bytes += block->size;
+        } else {
+          stats.packed_bytes += block->size;
+        }
+      }
+    }
+    for (const Segment* segment : mOpen) {
+      stats.events += segment->published.load(std::memory_order_relaxed);
+      stats.open_bytes += mOptions.segment_records * sizeof(EventRecord);
+    }
+  }
+  std::shared_lock<std::shared_mutex> lock(mNamesMutex);
+  stats.names = mNames.size() - 1;
+  return stats;
+}
+
+}  // namespace base
+}  // namespace hyperon
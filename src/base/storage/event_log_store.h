@@ -0,0 +1,199 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/core/event.h"
+#include "base/core/hyperbase.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief One observed event of the episodic model in 40 bytes. Concepts
+ * are ids interned by EventLogStore::Intern, 0 for none.
+ */
+struct EventRecord {
+  int64_t start{0};
+  // Event::kOpenEnd for events still going on.
+  int64_t end{Event::kOpenEnd};
+  // Action or event type, e.g. {eat}.
+  uint32_t type{0};
+  // {action agent}, {action object} and {action recipient}.
+  uint32_t agent{0};
+  uint32_t object{0};
+  uint32_t recipient{0};
+  // {event location}
+  uint32_t location{0};
+  // Context the event happened in.
+  uint32_t context{0};
+};
+
+static_assert(sizeof(EventRecord) == 40, "EventRecord is fixed-width");
+
+/**
+ * @brief A logged event with its id, which stays valid across sealing and
+ * spilling.
+ */
+struct EventView {
+  uint64_t id{0};
+  EventRecord record;
+};
+
+struct EventLogOptions {
+  // Records of a write segment; a full segment is sealed.
+  uint32_t segment_records{65536};
+  // Width of a time partition.
+  int64_t partition_millis{3600 * 1000};
+  // Partitions ending this long before the newest event start are spilled.
+  int64_t hot_millis{24 * 3600 * 1000};
+  // Directory for spilled partitions, empty to keep all in memory.
+  std::string directory;
+};
+
+/**
+ * @brief Counters of an event log store.
+ */
+struct EventLogStats {
+  uint64_t events{0};
+  uint64_t sealed_segments{0};
+  uint64_t partitions{0};
+  uint64_t blocks{0};
+  uint64_t spilled_blocks{0};
+  // Fixed-width records of the open segments.
+  uint64_t open_bytes{0};
+  // Encoded blocks in memory and on disk.
+  uint64_t packed_bytes{0};
+  uint64_t spilled_bytes{0};
+  uint64_t names{0};
+};
+
+/**
+ * @brief Append-only store of observed events for high-rate episodic
+ * ingestion, next to the hyperbase rather than inside it: an event costs
+ * a 40-byte record instead of a heap Event with string-keyed maps.
+ *
+ * Producers append into a write segment of fixed-width records without
+ * locks: a slot is claimed with one atomic add and published with another.
+ * The producer that claims the slot past the end rolls a fresh segment in
+ * and seals the full one: its records are sorted by start, split by time
+ * partition and encoded column-wise as varint deltas into blocks. Blocks
+ * of partitions that fall behind the hot window are spilled to one file
+ * per partition and read back on demand.
+ *
+ * Queries see every published record. Events are turned into hyperbase
+ * concepts only when asked, by Materialize(). Spilled files are a cache,
+ * not a durable log: the block directory and the name table live in
+ * memory.
+ */
+class EventLogStore {
+public:
+  explicit EventLogStore(const EventLogOptions& options = EventLogOptions());
+  ~EventLogStore();
+
+  EventLogStore(const EventLogStore&) = delete;
+  EventLogStore& operator=(const EventLogStore&) = delete;
+
+  // Id of a concept name, taking a lock only for names not seen yet.
+  uint32_t Intern(const std::string& name);
+  // Name of an id, empty for 0 and unknown ids.
+  std::string Name(uint32_t id) const;
+
+  /**
+   * @brief Append an event, lock-free unless it fills the write segment.
+   * @return Id of the event
+   */
+  uint64_t Append(const EventRecord& record);
+
+  /**
+   * @brief Seal the write segment now, e.g. from a timer so that quiet
+   * periods get spilled too. A no-op on an empty segment.
+   */
+  void Flush();
+
+  /**
+   * @brief Events sharing a time point with [start, end], ordered by start
+   * and id.
+   *
+   * @param error Error message if a spilled block cannot be read back
+   * @param limit Stop after this many events, 0 for all
+   * @param profile Filled with the execution profile if set
+   * @return false if a block could not be read, nothing is appended then.
+   */
+  bool Overlapping(int64_t start, int64_t end, std::vector<EventView>& out,
+                   std::string& error, size_t limit = 0,
+                   common::ProfileNode* profile = nullptr) const;
+
+  /**
+   * @brief Turn a logged event into an Event of the hyperbase, named
+   * "<type>#<id>", under its type, with its role fillers as members and
+   * its interval set. Concepts missing from the hyperbase are left out.
+   * Members are unordered, the roles they filled stay in the view.
+   *
+   * @param name Name of the event concept
+   * @param error Error message on failure
+   * @return true if the event exists in the hyperbase afterwards.
+   */
+  bool Materialize(const EventView& view, Hyperbase& hyperbase,
+                   std::string& name, std::string& error) const;
+
+  EventLogStats Stats() const;
+
+private:
+  struct Segment;
+  struct Block;
+
+  struct Partition {
+    std::vector<std::unique_ptr<Block>> blocks;
+    int64_t max_end{std::numeric_limits<int64_t>::min()};
+    // Bytes written to the partition file, only touched by Spill().
+    uint64_t file_bytes{0};
+  };
+
+  Segment* NewSegment();
+  // Seal `segment` holding `count` claimed slots, rolling a fresh one in.
+  void Roll(Segment* segment, uint64_t count);
+  void Spill();
+  bool ReadBlock(int64_t key, const Block& block, std::string& bytes) const;
+  std::string PartitionPath(int64_t key) const;
+  int64_t PartitionOf(int64_t time) const;
+
+  const EventLogOptions mOptions;
+
+  // Segment producers append to.
+  std::atomic<Segment*> mActive{nullptr};
+  // Every segment made and those free for reuse. Segments are recycled,
+  // never freed, since a late producer may still add to a full one.
+  std::mutex mRollMutex;
+  std::vector<std::unique_ptr<Segment>> mSegments;
+  std::vector<Segment*> mFreeSegments;
+  uint64_t mNextSegment{0};
+
+  // Guards the block directory and the open segments list.
+  mutable std::shared_mutex mMutex;
+  std::map<int64_t, Partition> mPartitions;
+  std::vector<Segment*> mOpen;
+  int64_t mNewestStart{std::numeric_limits<int64_t>::min()};
+  uint64_t mSealedSegments{0};
+  uint64_t mSealedEvents{0};
+
+  // Serializes spilling, which writes without holding mMutex.
+  std::mutex mSpillMutex;
+
+  mutable std::shared_mutex mNamesMutex;
+  std::deque<std::string> mNames;
+  std::unordered_map<std::string, uint32_t> mIds;
+};
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,357 @@
+#include "base/storage/json_dump.h"
+
+#include <fmt/core.h>
+
+#include <functional>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <shared_mutex>
+#include <vector>
+
+#include "base/core/event.h"
+#include "base/storage/mutation_codec.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+constexpr size_t kImportBatch = 8192;
+constexpr size_t kExportChunk = 4096;
+
+/**
+ * @brief Layout of one section: the mutation its records become, the field
+ * holding the subject and the array holding the objects.
+ */
+struct Section {
+  const char* name;
+  Mutation::MUTATION_KIND kind;
+  const char* subject;
+  const char* objects;
+};
+
+constexpr Section kSections[] = {
+    {"concepts", Mutation::MUT_ADD_CONCEPT, "name", ""},
+    {"lineage", Mutation::MUT_ADD_PARENT, "concept", "parents"},
+    {"splits", Mutation::MUT_ADD_SPLIT, "concept", "children"},
+    {"unions", Mutation::MUT_ADD_UNION, "concept", "parents"},
+    {"relations", Mutation::MUT_ADD_MEMBER, "relation", "members"},
+    {"intervals", Mutation::MUT_SET_INTERVAL, "event", "times"},
+};
+
+void write_names(common::JsonWriter& writer, const char* key,
+                 const std::vector<std::string>& names) {
+  writer.Key(key).BeginArray();
+  for (const auto& name : names) writer.String(name);
+  writer.EndArray();
+}
+
+/**
+ * @brief Visit every concept in category and name order, kExportChunk
+ * concepts at a time under the shared lock. The lock is released and the
+ * writer flushed between chunks, so commits are not held back for the
+ * whole export nor by a slow sink.
+ *
+ * @return false if the sink failed.
+ */
+bool for_each_chunked(const Hyperbase& hyperbase, common::JsonWriter& writer,
+                      const std::function<void(const ConceptPtr&)>& fn) {
+  // The root category, then the enclosed ones by name.
+  std::vector<std::string> categories(1);
+  {
+    std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+    hyperbase.RootCategory()->ForEachEnclosedCategory(
+        [&categories](const CategoryPtr& category) {
+          categories.push_back(category->Name());
+        });
+  }
+  for (size_t i = 0; i < categories.size(); ++i) {
+    // Resume after the last concept visited, which may be gone by now.
+    std::string after;
+    bool more = true;
+    while (more) {
+      more = false;
+      {
+        std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+        CategoryPtr category = hyperbase.RootCategory();
+        if (i > 0) category->GetEnclosedCategory(categories[i], category);
+        if (!category) break;
+        size_t visited = 0;
+        const std::string* last = nullptr;
+        category->ForEachConceptAfter(after, [&](const ConceptPtr& cnpt) {
+          if (visited == kExportChunk) {
+            more = true;
+            return false;
+          }
+          fn(cnpt);
+          last = &cnpt->SemNameRef();
+          ++visited;
+          return true;
+        });
+        if (last) after = *last;
+      }
+      if (!writer.Flush()) return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief SAX handler turning the records of a dump into batched mutations.
+ * Depth 1 holds the sections, depth 3 the record fields and depth 4 the
+ * name arrays.
+ */
+class DumpHandler : public nlohmann::json_sax<nlohmann::json> {
+public:
+  DumpHandler(Hyperbase& hyperbase, JsonImportResult& result,
+              std::string& error)
+      : mHyperbase(hyperbase), mResult(result), mError(error) {
+    mBatch.reserve(kImportBatch);
+  }
+
+  bool Finish() {
+    Drain();
+    return true;
+  }
+
+  /* override */ bool null() { return Scalar(""); }
+  /* override */ bool boolean(bool val) {
+    return Scalar(val ? "true" : "false");
+  }
+  /* override */ bool number_integer(number_integer_t val) {
+    return Scalar(std::to_string(val));
+  }
+  /* override */ bool number_unsigned(number_unsigned_t val) {
+    return Scalar(std::to_string(val));
+  }
+  /* override */ bool number_float(number_float_t, const string_t& s) {
+    return Scalar(s);
+  }
+  /* override */ bool string(string_t& val) { return Scalar(val); }
+  /* override */ bool binary(binary_t&) { return Scalar(""); }
+
+  /* override */ bool start_object(std::size_t) {
+    ++mDepth;
+    if (mDepth == 3 && mSection) {
+      mRecord = Mutation();
+      mRecord.kind = mSection->kind;
+      mInRecord = true;
+    }
+    return true;
+  }
+
+  /* override */ bool end_object() {
+    if (mDepth == 3 && mInRecord) {
+      mInRecord = false;
+      if (!EndRecord()) return false;
+    }
+    --mDepth;
+    return true;
+  }
+
+  /* override */ bool start_array(std::size_t) {
+    ++mDepth;
+    mInNames = mDepth == 4 && mInRecord && mField == mSection->objects;
+    return true;
+  }
+
+  /* override */ bool end_array() {
+    --mDepth;
+    mInNames = false;
+    return true;
+  }
+
+  /* override */ bool key(string_t& val) {
+    if (mDepth == 1) {
+      mHeader = val == "hyperbase";
+      mSection = nullptr;
+      for (const auto& section : kSections) {
+        if (val == section.name) mSection = &section;
+      }
+    } else if (mDepth == 2 || mDepth == 3) {
+      mField = val;
+    }
+    return true;
+  }
+
+  /* override */ bool parse_error(std::size_t position, const std::string&,
+                                 const nlohmann::detail::exception& ex) {
+    mError = fmt::format("malformed JSON dump at byte {}: {}", position,
+                         ex.what());
+    return false;
+  }
+
+private:
+  bool Scalar(const std::string& value) {
+    if (mDepth == 2 && mHeader) {
+      if (mField == "name") mResult.name = value;
+      if (mField == "owner") mResult.owner = value;
+    } else if (mDepth == 3 && mInRecord) {
+      if (mField == mSection->subject) {
+        mRecord.subject = value;
+      } else if (mField == "category") {
+        mRecord.category = value;
+      } else if (mField == "kind" &&
+                 !parse_concept_kind(value, mRecord.concept_kind)) {
+        mError = fmt::format("{} record {}: unknown kind '{}'",
+                             mSection->name, mResult.records + 1, value);
+        return false;
+      }
+    } else if (mInNames) {
+      mRecord.objects.push_back(value);
+    }
+    return true;
+  }
+
+  bool EndRecord() {
+    ++mResult.records;
+    if (mRecord.subject.empty()) {
+      mError = fmt::format("{} record {}: missing '{}'", mSection->name,
+                           mResult.records, mSection->subject);
+      return false;
+    }
+    mBatch.push_back(std::move(mRecord));
+    if (mBatch.size() == kImportBatch) Drain();
+    return true;
+  }
+
+  void Drain() {
+    if (mBatch.empty()) return;
+    BatchResult applied = mHyperbase.ApplyBatch(mBatch);
+    mResult.applied += applied.applied;
+    mResult.failed += applied.failed;
+    mBatch.clear();
+  }
+
+  Hyperbase& mHyperbase;
+  JsonImportResult& mResult;
+  std::string& mError;
+
+  std::vector<Mutation> mBatch;
+  Mutation mRecord;
+  const Section* mSection{nullptr};
+  std::string mField;
+  int mDepth{0};
+  bool mHeader{false};
+  bool mInRecord{false};
+  bool mInNames{false};
+};
+
+}  // namespace
+
+bool write_json_dump(const Hyperbase& hyperbase, common::JsonWriter& writer,
+                     std::string& error) {
+  std::vector<std::string> names;
+  CategoryPtr root;
+  {
+    std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+    root = hyperbase.RootCategory();
+    writer.BeginObject();
+    writer.Key("hyperbase").BeginObject();
+    writer.Key("name").String(hyperbase.Name());
+    writer.Key("owner").String(hyperbase.Owner());
+    writer.Key("version").Uint(hyperbase.Version());
+    writer.EndObject().Newline();
+  }
+
+  writer.Key("concepts").BeginArray();
+  bool ok = for_each_chunked(hyperbase, writer, [&](const ConceptPtr& cnpt) {
+    writer.Newline().BeginObject();
+    writer.Key("name").String(cnpt->SemName());
+    writer.Key("kind").String(concept_kind_name(concept_kind_of(cnpt)));
+    CategoryPtr category = cnpt->GetCategory();
+    if (category && category != root) {
+      writer.Key("category").String(category->Name());
+    }
+    writer.EndObject();
+  });
+  writer.EndArray().Newline();
+
+  writer.Key("lineage").BeginArray();
+  ok = ok && for_each_chunked(hyperbase, writer, [&](const ConceptPtr& cnpt) {
+    if (cnpt->ParentCount() == 0) return;
+    names.clear();
+    cnpt->ForEachParent([&names](const ElementPtr& parent) {
+      names.push_back(parent->SemName());
+    });
+    writer.Newline().BeginObject();
+    writer.Key("concept").String(cnpt->SemName());
+    write_names(writer, "parents", names);
+    writer.EndObject();
+  });
+  writer.EndArray().Newline();
+
+  writer.Key("splits").BeginArray();
+  ok = ok && for_each_chunked(hyperbase, writer, [&](const ConceptPtr& cnpt) {
+    for (const auto& split : cnpt->Splits()) {
+      names.assign(split.begin(), split.end());
+      writer.Newline().BeginObject();
+      writer.Key("concept").String(cnpt->SemName());
+      write_names(writer, "children", names);
+      writer.EndObject();
+    }
+  });
+  writer.EndArray().Newline();
+
+  writer.Key("unions").BeginArray();
+  ok = ok && for_each_chunked(hyperbase, writer, [&](const ConceptPtr& cnpt) {
+    for (const auto& parents : cnpt->Unions()) {
+      names.assign(parents.begin(), parents.end());
+      writer.Newline().BeginObject();
+      writer.Key("concept").String(cnpt->SemName());
+      write_names(writer, "parents", names);
+      writer.EndObject();
+    }
+  });
+  writer.EndArray().Newline();
+
+  writer.Key("relations").BeginArray();
+  ok = ok && for_each_chunked(hyperbase, writer, [&](const ConceptPtr& cnpt) {
+    if (!cnpt->IsRelation()) return;
+    auto relation = std::static_pointer_cast<Relation>(cnpt);
+    if (relation->MemberCount() == 0) return;
+    names.clear();
+    relation->ForEachMember([&names](const ConceptPtr& member) {
+      names.push_back(member->SemName());
+    });
+    writer.Newline().BeginObject();
+    writer.Key("relation").String(cnpt->SemName());
+    write_names(writer, "members", names);
+    writer.EndObject();
+  });
+  writer.EndArray().Newline();
+
+  writer.Key("intervals").BeginArray();
+  ok = ok && for_each_chunked(hyperbase, writer, [&](const ConceptPtr& cnpt) {
+    if (!cnpt->IsRelation()) return;
+    auto event = std::dynamic_pointer_cast<Event>(cnpt);
+    if (!event || !event->HasInterval()) return;
+    writer.Newline().BeginObject();
+    writer.Key("event").String(cnpt->SemName());
+    writer.Key("times").BeginArray().Int(event->Start());
+    if (event->End() != Event::kOpenEnd) writer.Int(event->End());
+    writer.EndArray().EndObject();
+  });
+  writer.EndArray().Newline();
+  writer.EndObject().Newline();
+
+  if (!ok || !writer.Flush()) {
+    error = fmt::format("failed writing JSON dump of '{}'", hyperbase.Name());
+    return false;
+  }
+  return true;
+}
+
+bool read_json_dump(std::istream& in, Hyperbase& hyperbase,
+                    JsonImportResult& result, std::string& error) {
+  DumpHandler handler(hyperbase, result, error);
+  bool ok = nlohmann::json::sax_parse(in, &handler);
+  // Records parsed before an error are applied as well, like a partially
+  // replayed snapshot.
+  handler.Finish();
+  if (!ok && error.empty()) error = "malformed JSON dump";
+  return ok;
+}
+
+}  // namespace base
+}  // namespace hyperon
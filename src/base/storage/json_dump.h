@@ -0,0 +1,72 @@
+#pragma once
+
+#include <istream>
+#include <string>
+
+#include "base/core/hyperbase.h"
+#include "common/json/json_writer.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Outcome of a JSON import.
+ */
+struct JsonImportResult {
+  // Name and owner found in the dump header, empty if absent.
+  std::string name;
+  std::string owner;
+  uint64_t records{0};
+  uint64_t applied{0};
+  uint64_t failed{0};
+};
+
+/**
+ * @brief Export a hyperbase as a JSON document, streamed to `writer`.
+ * Memory use does not depend on the size of the hyperbase.
+ *
+ * Every section is written in chunks of concepts, each under the shared
+ * lock, which is released between chunks. The dump is thus a consistent
+ * state only if no batch commits during the export; otherwise records may
+ * reflect any state since the version in the header.
+ *
+ * The document has one array per section, each record on its own line:
+ *
+ *   {"hyperbase": {"name": .., "owner": .., "version": ..},
+ *    "concepts":  [{"name": .., "kind": "entity", "category": ..}, ..],
+ *    "lineage":   [{"concept": .., "parents": [..]}, ..],
+ *    "splits":    [{"concept": .., "children": [..]}, ..],
+ *    "unions":    [{"concept": .., "parents": [..]}, ..],
+ *    "relations": [{"relation": .., "members": [..]}, ..],
+ *    "intervals": [{"event": .., "times": [start, end]}, ..]}
+ *
+ * "category" is omitted for concepts of the root category, the end of
+ * "times" for events still going on.
+ *
+ * @param hyperbase Hyperbase to export
+ * @param writer Destination
+ * @param error Error message on failure
+ * @return true if the whole document reached the sink.
+ */
+bool write_json_dump(const Hyperbase& hyperbase, common::JsonWriter& writer,
+                     std::string& error);
+
+/**
+ * @brief Import a JSON dump into a hyperbase. The document is parsed with
+ * SAX callbacks and every record is turned into a mutation right away, then
+ * applied in batches, so no DOM of the dump is ever built. Sections are
+ * applied in document order, i.e. "concepts" must precede the others.
+ * Unknown sections and fields are skipped.
+ *
+ * @param in Input stream, e.g. a file or a common::ChunkStreambuf
+ * @param hyperbase Target hyperbase
+ * @param result Import counters
+ * @param error Error message on failure
+ * @return true if the document was well-formed. Records rejected by the
+ * hyperbase are counted in `result.failed`.
+ */
+bool read_json_dump(std::istream& in, Hyperbase& hyperbase,
+                    JsonImportResult& result, std::string& error);
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,135 @@
+#include "base/storage/mutation_codec.h"
+
+#include <vector>
+
+#include "base/core/event.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+constexpr const char* kConceptKindNames[] = {"concept", "entity", "relation",
+                                             "role",    "context", "event"};
+
+void append_escaped(const std::string& field, std::string& out) {
+  for (char c : field) {
+    switch (c) {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        out += c;
+    }
+  }
+}
+
+bool split_fields(const std::string& line, std::vector<std::string>& fields) {
+  fields.emplace_back();
+  for (size_t i = 0; i < line.size(); ++i) {
+    char c = line[i];
+    if (c == '\t') {
+      fields.emplace_back();
+    } else if (c == '\\') {
+      if (++i == line.size()) return false;
+      switch (line[i]) {
+        case '\\':
+          fields.back() += '\\';
+          break;
+        case 't':
+          fields.back() += '\t';
+          break;
+        case 'n':
+          fields.back() += '\n';
+          break;
+        default:
+          return false;
+      }
+    } else {
+      fields.back() += c;
+    }
+  }
+  return true;
+}
+
+bool parse_int(const std::string& field, int& value) {
+  if (field.empty() || field.size() > 4) return false;
+  value = 0;
+  for (char c : field) {
+    if (c < '0' || c > '9') return false;
+    value = value * 10 + (c - '0');
+  }
+  return true;
+}
+
+}  // namespace
+
+void encode_mutation(const Mutation& mut, std::string& out) {
+  out += std::to_string(static_cast<int>(mut.kind));
+  out += '\t';
+  out += std::to_string(static_cast<int>(mut.concept_kind));
+  out += '\t';
+  append_escaped(mut.category, out);
+  out += '\t';
+  append_escaped(mut.subject, out);
+  for (const auto& object : mut.objects) {
+    out += '\t';
+    append_escaped(object, out);
+  }
+}
+
+bool decode_mutation(const std::string& line, Mutation& mut) {
+  std::vector<std::string> fields;
+  if (!split_fields(line, fields) || fields.size() < 4) return false;
+
+  int kind = 0;
+  int concept_kind = 0;
+  if (!parse_int(fields[0], kind) || !parse_int(fields[1], concept_kind)) {
+    return false;
+  }
+  if (kind < Mutation::MUT_ADD_CONCEPT || kind > Mutation::MUT_ADD_UNION ||
+      concept_kind < Mutation::KIND_CONCEPT ||
+      concept_kind > Mutation::KIND_EVENT) {
+    return false;
+  }
+  mut.kind = static_cast<Mutation::MUTATION_KIND>(kind);
+  mut.concept_kind = static_cast<Mutation::CONCEPT_KIND>(concept_kind);
+  mut.category = std::move(fields[2]);
+  mut.subject = std::move(fields[3]);
+  mut.objects.assign(std::make_move_iterator(fields.begin() + 4),
+                     std::make_move_iterator(fields.end()));
+  return true;
+}
+
+Mutation::CONCEPT_KIND concept_kind_of(const ConceptPtr& cnpt) {
+  if (std::dynamic_pointer_cast<Event>(cnpt)) return Mutation::KIND_EVENT;
+  if (cnpt->IsRelation()) return Mutation::KIND_RELATION;
+  if (cnpt->IsEntity()) return Mutation::KIND_ENTITY;
+  if (cnpt->IsRole()) return Mutation::KIND_ROLE;
+  if (cnpt->IsContext()) return Mutation::KIND_CONTEXT;
+  return Mutation::KIND_CONCEPT;
+}
+
+const char* concept_kind_name(Mutation::CONCEPT_KIND kind) {
+  return kConceptKindNames[kind];
+}
+
+bool parse_concept_kind(const std::string& name,
+                        Mutation::CONCEPT_KIND& kind) {
+  for (int i = Mutation::KIND_CONCEPT; i <= Mutation::KIND_EVENT; ++i) {
+    if (name == kConceptKindNames[i]) {
+      kind = static_cast<Mutation::CONCEPT_KIND>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace base
+}  // namespace hyperon
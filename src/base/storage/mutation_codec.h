@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+
+#include "base/core/concept.h"
+#include "base/core/mutation.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Append the line encoding of a mutation to `out`, without the
+ * trailing newline. Fields are tab separated; tabs, newlines and backslashes
+ * in names are escaped.
+ *
+ * @param mut Mutation
+ * @param out Output buffer
+ */
+void encode_mutation(const Mutation& mut, std::string& out);
+
+/**
+ * @brief Decode a line produced by encode_mutation.
+ *
+ * @param line Encoded line, without the trailing newline
+ * @param mut Decoded mutation
+ * @return true if the line is well-formed.
+ */
+bool decode_mutation(const std::string& line, Mutation& mut);
+
+/**
+ * @brief Concept kind recorded when re-creating `cnpt` from a dump.
+ */
+Mutation::CONCEPT_KIND concept_kind_of(const ConceptPtr& cnpt);
+
+/**
+ * @brief Lower-case name of a concept kind, e.g. "entity".
+ */
+const char* concept_kind_name(Mutation::CONCEPT_KIND kind);
+
+/**
+ * @brief Parse a name produced by concept_kind_name.
+ *
+ * @return true if `name` is a known kind.
+ */
+bool parse_concept_kind(const std::string& name, Mutation::CONCEPT_KIND& kind);
+
+}  // namespace base
+}  // namespace hyperon
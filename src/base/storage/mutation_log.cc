@@ -0,0 +1,186 @@
+#include "base/storage/mutation_log.h"
+
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "base/storage/mutation_codec.h"
+#include "common/utils/fsync.h"
+#include "common/utils/time.h"
+
+namespace hyperon {
+namespace base {
+
+MutationLog::MutationLog(size_t retention, const std::string& path)
+    : mRetention(std::max<size_t>(retention, 1)) {
+  if (path.empty()) return;
+  mFile = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+                 0644);
+  if (mFile < 0 || !common::sync_parent_dir(path)) {
+    mLastError = fmt::format("cannot open '{}' for appending", path);
+  }
+}
+
+MutationLog::~MutationLog() {
+  if (mFile >= 0) ::close(mFile);
+}
+
+bool MutationLog::Replay(const std::string& path, Hyperbase& hyperbase,
+                         std::string& error) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return true;
+  std::string line;
+  uint64_t lineno = 0;
+  // End of the last complete entry.
+  std::streamoff end = 0;
+  bool torn = false;
+  std::vector<Mutation> batch;
+  while (std::getline(in, line)) {
+    ++lineno;
+    // Marker line: version, commit time and number of following records.
+    uint64_t version = 0;
+    uint64_t count = 0;
+    try {
+      if (in.eof() || line.empty() || line[0] != '@') {
+        throw std::invalid_argument(line);
+      }
+      size_t time = line.find('\t');
+      size_t records = line.find('\t', time + 1);
+      if (time == std::string::npos || records == std::string::npos) {
+        throw std::invalid_argument(line);
+      }
+      version = std::stoull(line.substr(1, time - 1));
+      count = std::stoull(line.substr(records + 1));
+    } catch (const std::exception&) {
+      // Entries are appended whole, an unterminated one is torn.
+      torn = in.eof();
+      if (torn) break;
+      error = fmt::format("{}:{}: malformed log marker", path, lineno);
+      return false;
+    }
+    batch.resize(count);
+    for (uint64_t i = 0; i < count && !torn; ++i) {
+      ++lineno;
+      torn = !std::getline(in, line) || in.eof();
+      if (!torn && !decode_mutation(line, batch[i])) {
+        error = fmt::format("{}:{}: malformed mutation", path, lineno);
+        return false;
+      }
+    }
+    if (torn) break;
+    end = in.tellg();
+    if (version <= hyperbase.Version()) continue;
+    BatchResult result = hyperbase.ApplyReplicatedBatch(batch, version);
+    if (result.failed > 0) {
+      error = fmt::format("{}: entry at version {} did not apply", path,
+                          version);
+      return false;
+    }
+  }
+  if (torn) {
+    in.close();
+    std::error_code ec;
+    std::filesystem::resize_file(path, end, ec);
+    if (ec) {
+      error = fmt::format("cannot truncate '{}': {}", path, ec.message());
+      return false;
+    }
+  }
+  return true;
+}
+
+void MutationLog::OnCommit(const Hyperbase&, uint64_t version,
+                           const std::vector<const Mutation*>& applied) {
+  LogEntry entry;
+  entry.version = version;
+  entry.commit_time = common::now_millis();
+  entry.mutations.reserve(applied.size());
+  for (const Mutation* mut : applied) entry.mutations.push_back(*mut);
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mFile >= 0) {
+    mBuffer.clear();
+    mBuffer += '@';
+    mBuffer += std::to_string(version);
+    mBuffer += '\t';
+    mBuffer += std::to_string(entry.commit_time);
+    mBuffer += '\t';
+    mBuffer += std::to_string(entry.mutations.size());
+    mBuffer += '\n';
+    for (const auto& mut : entry.mutations) {
+      encode_mutation(mut, mBuffer);
+      mBuffer += '\n';
+    }
+    if (!common::write_all(mFile, mBuffer.data(), mBuffer.size()) ||
+        ::fdatasync(mFile) != 0) {
+      // Later entries are kept in memory only.
+      mLastError = fmt::format("write-ahead log failed at version {}: {}",
+                               version, std::strerror(errno));
+      ::close(mFile);
+      mFile = -1;
+    }
+  }
+
+  mLastVersion = version;
+  mLastCommitTime = entry.commit_time;
+  mEntries.push_back(std::move(entry));
+  while (mEntries.size() > mRetention) {
+    mBaseVersion = mEntries.front().version;
+    mEntries.pop_front();
+  }
+  mAppended.notify_all();
+}
+
+bool MutationLog::ReadAfter(uint64_t after_version, size_t max_entries,
+                            uint64_t wait_millis,
+                            std::vector<LogEntry>& out) const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (after_version < mBaseVersion) return false;
+  if (wait_millis > 0) {
+    mAppended.wait_for(lock, std::chrono::milliseconds(wait_millis),
+                       [this, after_version] {
+                         return mLastVersion > after_version;
+                       });
+  }
+  // Entries are in version order, find the first one past the reader.
+  auto it = std::upper_bound(
+      mEntries.begin(), mEntries.end(), after_version,
+      [](uint64_t v, const LogEntry& entry) { return v < entry.version; });
+  for (size_t n = 0; it != mEntries.end() && n < max_entries; ++it, ++n) {
+    out.push_back(*it);
+  }
+  return true;
+}
+
+uint64_t MutationLog::LastVersion() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLastVersion;
+}
+
+uint64_t MutationLog::LastCommitTime() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLastCommitTime;
+}
+
+std::string MutationLog::LastError() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLastError;
+}
+
+void MutationLog::Reset(uint64_t version) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mEntries.clear();
+  mBaseVersion = version;
+  mLastVersion = version;
+}
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief One committed batch of the leader.
+ */
+struct LogEntry {
+  uint64_t version{0};
+  uint64_t commit_time{0};
+  std::vector<Mutation> mutations;
+};
+
+/**
+ * @brief Log of the committed batches of a hyperbase, tailed by read
+ * replicas. Attached as a commit observer, it records exactly the mutations
+ * that took effect, so replaying it reproduces the leader state.
+ *
+ * The most recent `retention` entries are kept in memory. With a non-empty
+ * `path` every entry is also appended to a write-ahead file in the snapshot
+ * line format, prefixed by a version marker line, and synced to disk before
+ * the commit returns. Replay() applies such a file on top of the snapshot
+ * it was started after. A follower that fell behind the retained window has
+ * to resync from a snapshot.
+ */
+class MutationLog : public CommitObserver {
+public:
+  static constexpr size_t kDefaultRetention = 4096;
+
+  explicit MutationLog(size_t retention = kDefaultRetention,
+                       const std::string& path = "");
+  ~MutationLog();
+
+  MutationLog(const MutationLog&) = delete;
+  MutationLog& operator=(const MutationLog&) = delete;
+
+  /**
+   * @brief Apply the entries of the write-ahead file at `path` that are
+   * past the version of `hyperbase`, with their leader versions. An entry
+   * torn by a crash ends the log and is cut off the file, so that appending
+   * can resume after it. Call before a log is opened on the file.
+   *
+   * @return false if the file is malformed or an entry did not apply.
+   */
+  static bool Replay(const std::string& path, Hyperbase& hyperbase,
+                     std::string& error);
+
+  /* override */ void OnCommit(const Hyperbase&, uint64_t version,
+                               const std::vector<const Mutation*>& applied);
+
+  /**
+   * @brief Entries committed after `after_version`, waiting up to
+   * `wait_millis` for new ones if there are none yet.
+   *
+   * @param after_version Last version the reader has applied
+   * @param max_entries Upper bound of returned entries
+   * @param wait_millis Time to wait for new entries, 0 to poll
+   * @param out Appended entries in version order
+   * @return false if entries after `after_version` were already dropped.
+   */
+  bool ReadAfter(uint64_t after_version, size_t max_entries,
+                 uint64_t wait_millis, std::vector<LogEntry>& out) const;
+
+  // Latest committed version and its commit time, 0 if nothing logged.
+  uint64_t LastVersion() const;
+  uint64_t LastCommitTime() const;
+
+  /**
+   * @brief Mark the log as starting at `version`, e.g. right after the
+   * hyperbase was loaded from a snapshot at that version.
+   */
+  void Reset(uint64_t version);
+
+  // Why the write-ahead file was abandoned, empty if it was not.
+  std::string LastError() const;
+
+private:
+  const size_t mRetention;
+  mutable std::mutex mMutex;
+  mutable std::condition_variable mAppended;
+  std::deque<LogEntry> mEntries;
+  // Version right before the first retained entry.
+  uint64_t mBaseVersion{0};
+  uint64_t mLastVersion{0};
+  uint64_t mLastCommitTime{0};
+  int mFile{-1};
+  std::string mBuffer;
+  std::string mLastError;
+};
+
+}  // namespace base
+}  // namespace hyperon
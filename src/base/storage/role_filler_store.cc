@@ -0,0 +1,391 @@
+#include "base/storage/role_filler_store.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+
+#include "base/storage/scone_loader.h"
+
+namespace hyperon {
+namespace base {
+
+RoleFillerStore::RoleFillerStore(const Hyperbase& hyperbase)
+    : mHyperbase(hyperbase) {}
+
+uint32_t RoleFillerStore::Intern(const std::string& name) {
+  auto found = mIds.find(name);
+  if (found != mIds.end()) return found->second;
+  uint32_t id = static_cast<uint32_t>(mNames.size());
+  mNames.push_back(name);
+  mIds.emplace(name, id);
+  return id;
+}
+
+bool RoleFillerStore::Find(const std::string& name, uint32_t& id) const {
+  auto found = mIds.find(name);
+  if (found == mIds.end()) return false;
+  id = found->second;
+  return true;
+}
+
+void RoleFillerStore::DeclareRole(const std::string& role,
+                                  const std::string& owner) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  mDeclared[Intern(role)] = Intern(owner);
+}
+
+bool RoleFillerStore::DeclaredOwner(const std::string& role,
+                                    std::string& owner) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  uint32_t id;
+  if (!Find(role, id)) return false;
+  auto found = mDeclared.find(id);
+  if (found == mDeclared.end()) return false;
+  owner = mNames[found->second];
+  return true;
+}
+
+void RoleFillerStore::Add(const std::string& owner, const std::string& role,
+                          const std::string& filler) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  uint32_t owner_id = Intern(owner);
+  uint32_t role_id = Intern(role);
+  uint32_t filler_id = Intern(filler);
+  mDistinctFillers.Add(filler_id);
+  uint64_t forward_key = Key(owner_id, role_id);
+  common::IdList& fillers = mForward[forward_key];
+  if (!fillers.Empty() && filler_id == fillers.Back()) return;
+  if (fillers.Empty() || filler_id > fillers.Back()) {
+    fillers.Insert(filler_id);
+    ++mStatements;
+    mRoleFillers.Add(role_id);
+  } else {
+    mPendingForward.emplace_back(forward_key, filler_id);
+  }
+  uint64_t reverse_key = Key(filler_id, role_id);
+  common::IdList& owners = mReverse[reverse_key];
+  if (owners.Empty() || owner_id > owners.Back()) {
+    owners.Insert(owner_id);
+  } else if (owner_id != owners.Back()) {
+    mPendingReverse.emplace_back(reverse_key, owner_id);
+  }
+}
+
+namespace {
+
+// Merge (key, id) entries into their lists, one re-encoding per list, and
+// count the ids that were absent per role into `roles` if set.
+// @return Number of ids that were absent
+uint64_t merge_pending(std::unordered_map<uint64_t, common::IdList>& index,
+                       std::vector<std::pair<uint64_t, uint32_t>>& pending,
+                       common::CountMinSketch* roles = nullptr) {
+  std::sort(pending.begin(), pending.end());
+  pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+  uint64_t added = 0;
+  std::vector<uint32_t> ids;
+  for (size_t i = 0; i < pending.size();) {
+    uint64_t key = pending[i].first;
+    ids.clear();
+    for (; i < pending.size() && pending[i].first == key; ++i) {
+      ids.push_back(pending[i].second);
+    }
+    size_t merged = index[key].Merge(ids);
+    if (roles && merged > 0) roles->Add(key & 0xffffffffu, merged);
+    added += merged;
+  }
+  pending.clear();
+  return added;
+}
+
+}  // namespace
+
+void RoleFillerStore::Merge() const {
+  mStatements += merge_pending(mForward, mPendingForward, &mRoleFillers);
+  merge_pending(mReverse, mPendingReverse);
+}
+
+void RoleFillerStore::Settle(std::shared_lock<std::shared_mutex>& lock,
+                             common::ProfileNode* profile) const {
+  if (mPendingForward.empty() && mPendingReverse.empty()) return;
+  lock.unlock();
+  {
+    common::ProfileNode* merge =
+        common::profile_child(profile, "merge_pending");
+    common::ProfileTimer merge_timer(merge);
+    std::unique_lock<std::shared_mutex> exclusive(mMutex);
+    if (merge) {
+      merge->loops = 1;
+      merge->rows_in = mPendingForward.size() + mPendingReverse.size();
+    }
+    Merge();
+  }
+  lock.lock();
+}
+
+bool RoleFillerStore::Erase(const std::string& owner, const std::string& role,
+                            const std::string& filler) {
+  std::unique_lock<std::shared_mutex> lock(mMutex);
+  Merge();
+  uint32_t owner_id, role_id, filler_id;
+  if (!Find(owner, owner_id) || !Find(role, role_id) ||
+      !Find(filler, filler_id)) {
+    return false;
+  }
+  auto forward = mForward.find(Key(owner_id, role_id));
+  if (forward == mForward.end() || !forward->second.Erase(filler_id)) {
+    return false;
+  }
+  if (forward->second.Empty()) mForward.erase(forward);
+  auto reverse = mReverse.find(Key(filler_id, role_id));
+  reverse->second.Erase(owner_id);
+  if (reverse->second.Empty()) mReverse.erase(reverse);
+  --mStatements;
+  mRoleFillers.Add(role_id, -1);
+  return true;
+}
+
+void RoleFillerStore::RoleSet(const std::string& role, bool inherit,
+                              std::vector<uint32_t>& roles,
+                              common::ProfileNode* profile) const {
+  common::ProfileTimer timer(profile);
+  if (profile) {
+    profile->index = inherit ? "lineage" : "hash";
+    profile->loops = profile->rows_in = 1;
+  }
+  uint32_t id;
+  if (Find(role, id)) roles.push_back(id);
+  ConceptPtr top;
+  if (!inherit || !mHyperbase.GetConcept(role, top)) {
+    if (profile) profile->rows_out = roles.size();
+    return;
+  }
+
+  std::deque<ConceptPtr> frontier{top};
+  std::unordered_set<std::string> seen{role};
+  while (!frontier.empty()) {
+    ConceptPtr node = std::move(frontier.front());
+    frontier.pop_front();
+    node->ForEachChild([&](const ElementPtr& child) {
+      ConceptPtr sub = std::static_pointer_cast<Concept>(child);
+      if (!sub->IsRole() || !seen.insert(sub->SemName()).second) return;
+      if (Find(sub->SemName(), id)) roles.push_back(id);
+      frontier.push_back(std::move(sub));
+    });
+  }
+  if (profile) profile->rows_out = roles.size();
+}
+
+void RoleFillerStore::Collect(
+    const std::unordered_map<uint64_t, common::IdList>& index, uint32_t first,
+    const std::vector<uint32_t>& roles, std::vector<uint32_t>& ids) const {
+  size_t before = ids.size();
+  size_t lists = 0;
+  for (uint32_t role : roles) {
+    auto found = index.find(Key(first, role));
+    if (found == index.end()) continue;
+    found->second.Decode(ids);
+    ++lists;
+  }
+  if (lists > 1) {
+    std::sort(ids.begin() + before, ids.end());
+    ids.erase(std::unique(ids.begin() + before, ids.end()), ids.end());
+  }
+}
+
+size_t RoleFillerStore::Fillers(const std::string& owner,
+                                const std::string& role, bool inherit,
+                                std::vector<std::string>& out,
+                                common::ProfileNode* profile) const {
+  if (profile) {
+    *profile = common::ProfileNode("role_fillers",
+                                   fmt::format("{}, {}", owner, role));
+    profile->loops = profile->rows_in = 1;
+  }
+  common::ProfileTimer timer(profile);
+  common::ProfileNode* wait = common::profile_child(profile, "lock_wait");
+  common::ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> hyperbase_lock(mHyperbase.Mutex(),
+                                                     std::defer_lock);
+  if (inherit) hyperbase_lock.lock();
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  wait_timer.Stop();
+  Settle(lock, profile);
+  std::vector<uint32_t> roles;
+  RoleSet(role, inherit, roles, common::profile_child(profile, "role_set"));
+  if (roles.empty()) return 0;
+
+  common::ProfileNode* lists =
+      common::profile_child(profile, "forward_lists", "", "(owner, role)");
+  common::ProfileTimer lists_timer(lists);
+  uint64_t probed = 0;
+  uint64_t levels = 0;
+  std::vector<uint32_t> ids;
+  uint32_t id;
+  ConceptPtr origin;
+  if (!inherit || !mHyperbase.GetConcept(owner, origin)) {
+    ++probed;
+    if (Find(owner, id)) Collect(mForward, id, roles, ids);
+  } else {
+    // Nearest level of ancestors with fillers.
+    std::vector<ConceptPtr> level{origin};
+    std::unordered_set<std::string> seen{owner};
+    while (!level.empty() && ids.empty()) {
+      ++levels;
+      std::vector<ConceptPtr> next;
+      for (const auto& node : level) {
+        ++probed;
+        if (Find(node->SemName(), id)) Collect(mForward, id, roles, ids);
+        node->ForEachParent([&](const ElementPtr& parent) {
+          if (seen.insert(parent->SemName()).second) {
+            next.push_back(std::static_pointer_cast<Concept>(parent));
+          }
+        });
+      }
+      level.swap(next);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  }
+  for (uint32_t filler : ids) out.push_back(mNames[filler]);
+  if (profile) {
+    lists->loops = std::max<uint64_t>(levels, 1);
+    lists->rows_in = probed * roles.size();
+    lists->rows_out = profile->rows_out = ids.size();
+  }
+  return ids.size();
+}
+
+size_t RoleFillerStore::Owners(const std::string& filler,
+                               const std::string& role, bool inherit,
+                               std::vector<std::string>& out,
+                               common::ProfileNode* profile) const {
+  if (profile) {
+    *profile = common::ProfileNode("role_owners",
+                                   fmt::format("{}, {}", filler, role));
+    profile->loops = profile->rows_in = 1;
+  }
+  common::ProfileTimer timer(profile);
+  common::ProfileNode* wait = common::profile_child(profile, "lock_wait");
+  common::ProfileTimer wait_timer(wait);
+  std::shared_lock<std::shared_mutex> hyperbase_lock(mHyperbase.Mutex(),
+                                                     std::defer_lock);
+  if (inherit) hyperbase_lock.lock();
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  wait_timer.Stop();
+  Settle(lock, profile);
+  std::vector<uint32_t> roles;
+  RoleSet(role, inherit, roles, common::profile_child(profile, "role_set"));
+  uint32_t filler_id;
+  if (roles.empty() || !Find(filler, filler_id)) return 0;
+
+  std::vector<uint32_t> ids;
+  {
+    common::ProfileNode* lists =
+        common::profile_child(profile, "reverse_lists", "", "(filler, role)");
+    common::ProfileTimer lists_timer(lists);
+    Collect(mReverse, filler_id, roles, ids);
+    if (lists) {
+      lists->loops = 1;
+      lists->rows_in = roles.size();
+      lists->rows_out = ids.size();
+    }
+  }
+  size_t before = out.size();
+  for (uint32_t owner : ids) out.push_back(mNames[owner]);
+  if (!inherit) {
+    if (profile) profile->rows_out = ids.size();
+    return ids.size();
+  }
+
+  // Descendants inherit the filler unless they have fillers of their own.
+  common::ProfileNode* walk =
+      common::profile_child(profile, "descendant_walk", "", "children");
+  common::ProfileTimer walk_timer(walk);
+  uint64_t edges = 0;
+  std::unordered_set<std::string> seen(out.begin() + before, out.end());
+  std::deque<ConceptPtr> frontier;
+  for (uint32_t owner : ids) {
+    ConceptPtr cnpt;
+    if (mHyperbase.GetConcept(mNames[owner], cnpt)) frontier.push_back(cnpt);
+  }
+  std::vector<uint32_t> own;
+  while (!frontier.empty()) {
+    ConceptPtr node = std::move(frontier.front());
+    frontier.pop_front();
+    node->ForEachChild([&](const ElementPtr& child) {
+      ++edges;
+      const std::string name = child->SemName();
+      if (!seen.insert(name).second) return;
+      uint32_t id;
+      own.clear();
+      if (Find(name, id)) Collect(mForward, id, roles, own);
+      if (!own.empty()) return;
+      out.push_back(name);
+      frontier.push_back(std::static_pointer_cast<Concept>(child));
+    });
+  }
+  if (profile) {
+    walk->loops = 1;
+    walk->rows_in = edges;
+    walk->rows_out = out.size() - before - ids.size();
+    profile->rows_out = out.size() - before;
+  }
+  return out.size() - before;
+}
+
+uint64_t RoleFillerStore::EstimateRoleFillers(const std::string& role) const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  Settle(lock);
+  uint32_t id;
+  if (!Find(role, id)) return 0;
+  return static_cast<uint64_t>(mRoleFillers.Estimate(id));
+}
+
+RoleFillerStats RoleFillerStore::Stats() const {
+  std::shared_lock<std::shared_mutex> lock(mMutex);
+  Settle(lock);
+  RoleFillerStats stats;
+  stats.statements = mStatements;
+  stats.forward_keys = mForward.size();
+  stats.reverse_keys = mReverse.size();
+  for (const auto& kv : mForward) stats.list_bytes += kv.second.Bytes();
+  for (const auto& kv : mReverse) stats.list_bytes += kv.second.Bytes();
+  stats.names = mNames.size();
+  stats.distinct_fillers = mDistinctFillers.Estimate();
+  return stats;
+}
+
+void register_role_filler_forms(SconeLoader& loader, RoleFillerStore& store) {
+  // (x-is-the-y-of-z {x} {y} {z}), (x-is-a-y-of-z {x} {y} {z})
+  auto filler = [&store](SconeLoader&, const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 3, args)) return false;
+    store.Add(args[2], args[1], args[0]);
+    return true;
+  };
+  loader.ChainForm("x-is-the-y-of-z", filler);
+  loader.ChainForm("x-is-a-y-of-z", filler);
+  // (the-x-of-y-is-z {x} {y} {z})
+  loader.ChainForm("the-x-of-y-is-z", [&store](SconeLoader&,
+                                               const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 3, args)) return false;
+    store.Add(args[1], args[0], args[2]);
+    return true;
+  });
+  // (new-indv-role {role} {owner} {type} ...), likewise new-type-role
+  auto declare = [&store](SconeLoader&, const SconeForm& form) {
+    std::vector<std::string> args;
+    if (!scone_arg_names(form, 2, args)) return false;
+    store.DeclareRole(args[0], args[1]);
+    return true;
+  };
+  loader.ChainForm("new-indv-role", declare);
+  loader.ChainForm("new-type-role", declare);
+}
+
+}  // namespace base
+}  // namespace hyperon
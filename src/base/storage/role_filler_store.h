@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/compress/id_list.h"
+#include "common/profile/query_profile.h"
+#include "common/sketch/count_min.h"
+#include "common/sketch/hyperloglog.h"
+
+namespace hyperon {
+namespace base {
+
+class SconeLoader;
+
+/**
+ * @brief Counters of a role-filler store.
+ */
+struct RoleFillerStats {
+  // (owner, role, filler) statements.
+  uint64_t statements{0};
+  // Distinct (owner, role) and (filler, role) keys.
+  uint64_t forward_keys{0};
+  uint64_t reverse_keys{0};
+  // Encoded size of all id lists.
+  uint64_t list_bytes{0};
+  uint64_t names{0};
+  // HyperLogLog estimate of the fillers ever added.
+  uint64_t distinct_fillers{0};
+};
+
+/**
+ * @brief "x is the y of z" statements, indexed from the owner z and from the
+ * filler x.
+ *
+ * Names are interned to ids. Each (owner, role) key maps to the sorted,
+ * gap-encoded list of its filler ids and each (filler, role) key to its
+ * owner ids, so both directions are one hash lookup plus a list scan.
+ * Statements whose ids arrive below the largest of a list are buffered and
+ * merged in bulk before the next lookup, so loading stays linear.
+ *
+ * Lookups can follow the hyperbase lineage: roles below the asked one count
+ * as the asked role, and an owner without fillers inherits those of its
+ * nearest ancestors that have some. Such lookups take the shared lock of
+ * the hyperbase.
+ */
+class RoleFillerStore {
+public:
+  explicit RoleFillerStore(const Hyperbase& hyperbase);
+
+  // Declare `role` on `owner` (new-type-role, new-indv-role).
+  void DeclareRole(const std::string& role, const std::string& owner);
+  bool DeclaredOwner(const std::string& role, std::string& owner) const;
+
+  /**
+   * @brief Record that `filler` is the (or a) `role` of `owner`. Known
+   * statements are ignored.
+   */
+  void Add(const std::string& owner, const std::string& role,
+           const std::string& filler);
+  bool Erase(const std::string& owner, const std::string& role,
+             const std::string& filler);
+
+  /**
+   * @brief Fillers of `role` for `owner`, sorted by id. With `inherit`,
+   * subroles count and an owner without fillers takes those of its nearest
+   * ancestors with fillers.
+   *
+   * @param profile Filled with the execution profile if set
+   * @return Number of names appended
+   */
+  size_t Fillers(const std::string& owner, const std::string& role,
+                 bool inherit, std::vector<std::string>& out,
+                 common::ProfileNode* profile = nullptr) const;
+
+  /**
+   * @brief Owners `filler` is the `role` of. With `inherit`, subroles count
+   * and descendants of an owner are included unless they have fillers of
+   * their own.
+   *
+   * @param profile Filled with the execution profile if set
+   * @return Number of names appended
+   */
+  size_t Owners(const std::string& filler, const std::string& role,
+                bool inherit, std::vector<std::string>& out,
+                common::ProfileNode* profile = nullptr) const;
+
+  /**
+   * @brief Estimated number of statements of `role` over all owners, from
+   * a count-min sketch, for planning without touching the lists. Never
+   * underestimates; subroles are not included.
+   */
+  uint64_t EstimateRoleFillers(const std::string& role) const;
+
+  RoleFillerStats Stats() const;
+
+private:
+  static inline uint64_t Key(uint32_t first, uint32_t role) {
+    return (static_cast<uint64_t>(first) << 32) | role;
+  }
+
+  uint32_t Intern(const std::string& name);
+  bool Find(const std::string& name, uint32_t& id) const;
+
+  // `role` and, if `inherit`, the roles below it. Needs the shared lock of
+  // the hyperbase when inheriting.
+  void RoleSet(const std::string& role, bool inherit,
+               std::vector<uint32_t>& roles,
+               common::ProfileNode* profile = nullptr) const;
+
+  // Merge the buffered statements. Needs the exclusive lock.
+  void Merge() const;
+  // Merge the buffered statements if any, trading `lock` for the exclusive
+  // lock meanwhile.
+  void Settle(std::shared_lock<std::shared_mutex>& lock,
+              common::ProfileNode* profile = nullptr) const;
+
+  // Union of the lists of `first` for `roles` in `index`.
+  void Collect(const std::unordered_map<uint64_t, common::IdList>& index,
+               uint32_t first, const std::vector<uint32_t>& roles,
+               std::vector<uint32_t>& ids) const;
+
+  const Hyperbase& mHyperbase;
+
+  mutable std::shared_mutex mMutex;
+  std::vector<std::string> mNames;
+  std::unordered_map<std::string, uint32_t> mIds;
+  // (owner, role) to fillers and (filler, role) to owners. Mutable since
+  // reads merge buffered statements in.
+  mutable std::unordered_map<uint64_t, common::IdList> mForward;
+  mutable std::unordered_map<uint64_t, common::IdList> mReverse;
+  // Out-of-order (key, id) entries of either index, not merged yet.
+  mutable std::vector<std::pair<uint64_t, uint32_t>> mPendingForward;
+  mutable std::vector<std::pair<uint64_t, uint32_t>> mPendingReverse;
+  // Role to declaring owner.
+  std::unordered_map<uint32_t, uint32_t> mDeclared;
+  // Statements, buffered ones counted once merged.
+  mutable uint64_t mStatements{0};
+  // Statements per role id, likewise.
+  mutable common::CountMinSketch mRoleFillers;
+  common::HyperLogLog<> mDistinctFillers;
+};
+
+/**
+ * @brief Feed role statements of Scone files to a store: x-is-the-y-of-z,
+ * x-is-a-y-of-z, the-x-of-y-is-z, new-type-role and new-indv-role. Existing
+ * handlers of these forms still run first.
+ */
+void register_role_filler_forms(SconeLoader& loader, RoleFillerStore& store);
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,484 @@
+#include "base/storage/scone_loader.h"
+
+#include <fmt/core.h>
+
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+#include "base/core/bulk_builder.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+// Core components in dependency order, relative to the data directory.
+constexpr const char* kCoreComponents[] = {
+    "upper",
+    "time-model",
+    "space-model",
+    "simple-physics",
+    "simple-biology",
+    "simple-person-model",
+    "simple-social-model",
+    "simple-information",
+    "simple-episodic-model",
+    "simple-geopolitics",
+    "units",
+};
+
+const std::string kNoHead;
+
+/**
+ * @brief Reader of Common Lisp s-expressions, as far as Scone files use
+ * them. Comments, quote markers and reader conditionals are dropped.
+ */
+class FormReader {
+public:
+  explicit FormReader(std::string text) : mText(std::move(text)) {}
+
+  // Read the next top-level form, false at the end or on error.
+  bool Next(SconeForm& form, std::string& error) {
+    SkipSpace();
+    if (mPos >= mText.size()) return false;
+    return Read(form, error);
+  }
+
+private:
+  int Peek(size_t ahead = 0) const {
+    size_t pos = mPos + ahead;
+    return pos < mText.size() ? static_cast<unsigned char>(mText[pos]) : -1;
+  }
+
+  int Get() {
+    int c = Peek();
+    if (c < 0) return c;
+    if (c == '\n') ++mLine;
+    ++mPos;
+    return c;
+  }
+
+  void SkipSpace() {
+    while (true) {
+      int c = Peek();
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f') {
+        Get();
+      } else if (c == ';') {
+        while (Peek() >= 0 && Peek() != '\n') Get();
+      } else if (c == '#' && Peek(1) == '|') {
+        Get();
+        Get();
+        while (Peek() >= 0 && !(Peek() == '|' && Peek(1) == '#')) Get();
+        Get();
+        Get();
+      } else {
+        return;
+      }
+    }
+  }
+
+  static bool IsDelimiter(int c) {
+    return c < 0 || c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+           c == '\f' || c == '(' || c == ')' || c == '"' || c == ';';
+  }
+
+  bool Read(SconeForm& form, std::string& error) {
+    SkipSpace();
+    form.line = mLine;
+    int c = Peek();
+    switch (c) {
+      case -1:
+        error = fmt::format("line {}: unexpected end of input", mLine);
+        return false;
+      case ')':
+        error = fmt::format("line {}: unexpected ')'", mLine);
+        return false;
+      case '(':
+        return ReadList(form, error);
+      case '\'':
+      case '`':
+        Get();
+        return Read(form, error);
+      case ',':
+        Get();
+        if (Peek() == '@') Get();
+        return Read(form, error);
+      case '"':
+        return ReadString(form, error);
+      case '{':
+        return ReadName(form, error);
+      case '#':
+        if (Peek(1) == '\'' || Peek(1) == '(') {
+          Get();
+          if (Peek() == '\'') Get();
+          return Read(form, error);
+        }
+        if (Peek(1) == '\\') {
+          // Character literal, the character itself may be a delimiter.
+          form.type = SconeForm::SYMBOL;
+          form.text.push_back(static_cast<char>(Get()));
+          form.text.push_back(static_cast<char>(Get()));
+          if (Peek() >= 0) form.text.push_back(static_cast<char>(Get()));
+          ReadSymbolChars(form.text);
+          return true;
+        }
+        break;
+      default:
+        break;
+    }
+    form.type = SconeForm::SYMBOL;
+    ReadSymbolChars(form.text);
+    return true;
+  }
+
+  void ReadSymbolChars(std::string& text) {
+    while (!IsDelimiter(Peek())) text.push_back(static_cast<char>(Get()));
+  }
+
+  bool ReadList(SconeForm& form, std::string& error) {
+    uint32_t line = mLine;
+    form.type = SconeForm::LIST;
+    Get();
+    while (true) {
+      SkipSpace();
+      if (Peek() < 0) {
+        error = fmt::format("line {}: unterminated list", line);
+        return false;
+      }
+      if (Peek() == ')') {
+        Get();
+        return true;
+      }
+      form.items.emplace_back();
+      if (!Read(form.items.back(), error)) return false;
+    }
+  }
+
+  bool ReadString(SconeForm& form, std::string& error) {
+    uint32_t line = mLine;
+    form.type = SconeForm::STRING;
+    Get();
+    while (true) {
+      int c = Get();
+      if (c < 0) {
+        error = fmt::format("line {}: unterminated string", line);
+        return false;
+      }
+      if (c == '"') return true;
+      if (c == '\\') {
+        c = Get();
+        if (c < 0) continue;
+      }
+      form.text.push_back(static_cast<char>(c));
+    }
+  }
+
+  bool ReadName(SconeForm& form, std::string& error) {
+    uint32_t line = mLine;
+    form.type = SconeForm::NAME;
+    Get();
+    while (true) {
+      int c = Get();
+      if (c < 0) {
+        error = fmt::format("line {}: unterminated element name", line);
+        return false;
+      }
+      if (c == '}') return true;
+      form.text.push_back(static_cast<char>(c));
+    }
+  }
+
+  std::string mText;
+  size_t mPos{0};
+  uint32_t mLine{1};
+};
+
+// Names of a list form such as '({a} ({b} :adj "b")), or of a single name.
+std::vector<std::string> scone_names(const SconeForm& form) {
+  std::vector<std::string> names;
+  if (form.IsName()) {
+    names.push_back(form.text);
+  } else if (form.IsList()) {
+    for (const auto& item : form.items) {
+      std::string name = scone_name(item);
+      if (!name.empty()) names.push_back(std::move(name));
+    }
+  }
+  return names;
+}
+
+// (new-type {name} {parent} ...), (new-indv {name} {type} ...),
+// (new-is-a {name} {parent}), (new-context {name} {parent} ...)
+SconeLoader::FormHandler define(Mutation::CONCEPT_KIND kind) {
+  return [kind](SconeLoader& loader, const SconeForm& form) {
+    auto args = form.Args();
+    if (args.empty() || !args[0]->IsName()) return false;
+    std::vector<std::string> parents;
+    if (args.size() > 1) parents = scone_names(*args[1]);
+    loader.Ensure(args[0]->text, kind, parents);
+    return true;
+  };
+}
+
+// (new-intersection-type {name} '({a} {b}) ...),
+// (new-union-type {name} {parent} '({a} {b}) ...)
+bool new_intersection_type(SconeLoader& loader, const SconeForm& form) {
+  auto args = form.Args();
+  if (args.size() < 2 || !args[0]->IsName()) return false;
+  loader.Ensure(args[0]->text, Mutation::KIND_ENTITY, scone_names(*args[1]));
+  return true;
+}
+
+// (new-split-subtypes {parent} '({a} ({b} :adj "b") ...) ...)
+bool new_split_subtypes(SconeLoader& loader, const SconeForm& form) {
+  auto args = form.Args();
+  if (args.size() < 2 || !args[0]->IsName()) return false;
+  const std::string& parent = args[0]->text;
+  std::vector<std::string> subtypes = scone_names(*args[1]);
+  if (subtypes.empty()) return false;
+  for (const auto& subtype : subtypes) {
+    loader.Ensure(subtype, Mutation::KIND_ENTITY, {parent});
+  }
+  if (subtypes.size() > 1) {
+    Mutation split;
+    split.kind = Mutation::MUT_ADD_SPLIT;
+    split.subject = parent;
+    split.objects = std::move(subtypes);
+    loader.Emit(std::move(split));
+  }
+  return true;
+}
+
+// (new-type-role {role} {owner} {type} ...), likewise new-indv-role. The
+// role is a subtype of its filler type.
+bool new_role(SconeLoader& loader, const SconeForm& form) {
+  auto args = form.Args();
+  if (args.size() < 2 || !args[0]->IsName() || !args[1]->IsName()) {
+    return false;
+  }
+  std::vector<std::string> types;
+  if (args.size() > 2) types = scone_names(*args[2]);
+  loader.Ensure(args[1]->text, Mutation::KIND_ENTITY);
+  loader.Ensure(args[0]->text, Mutation::KIND_ROLE, types);
+  return true;
+}
+
+// (new-relation {name} :a-inst-of {x} :b-inst-of {y} ...)
+bool new_relation(SconeLoader& loader, const SconeForm& form) {
+  auto args = form.Args();
+  if (args.empty() || !args[0]->IsName()) return false;
+  loader.Ensure(args[0]->text, Mutation::KIND_RELATION);
+  return true;
+}
+
+}  // namespace
+
+const std::string& SconeForm::Head() const {
+  if (type != LIST || items.empty() || items[0].type != SYMBOL) {
+    return kNoHead;
+  }
+  return items[0].text;
+}
+
+std::vector<const SconeForm*> SconeForm::Args() const {
+  std::vector<const SconeForm*> args;
+  for (size_t i = 1; i < items.size() && !items[i].IsKeyword(); ++i) {
+    args.push_back(&items[i]);
+  }
+  return args;
+}
+
+const SconeForm* SconeForm::Option(const std::string& keyword) const {
+  for (size_t i = 1; i + 1 < items.size(); ++i) {
+    if (items[i].IsKeyword() && items[i].text == keyword) {
+      return &items[i + 1];
+    }
+  }
+  return nullptr;
+}
+
+std::string scone_name(const SconeForm& form) {
+  if (form.IsName()) return form.text;
+  if (form.IsList() && !form.items.empty() && form.items[0].IsName()) {
+    return form.items[0].text;
+  }
+  return "";
+}
+
+bool scone_arg_names(const SconeForm& form, size_t count,
+                     std::vector<std::string>& names) {
+  auto args = form.Args();
+  if (args.size() < count) return false;
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(scone_name(*args[i]));
+    if (names.back().empty()) return false;
+  }
+  return true;
+}
+
+SconeLoader::SconeLoader(Hyperbase& hyperbase) : mHyperbase(hyperbase) {
+  mBatch.reserve(kDefaultBatch);
+  RegisterCoreForms();
+}
+
+void SconeLoader::RegisterCoreForms() {
+  RegisterForm("new-type", define(Mutation::KIND_ENTITY));
+  RegisterForm("new-indv", define(Mutation::KIND_ENTITY));
+  RegisterForm("new-is-a", define(Mutation::KIND_CONCEPT));
+  RegisterForm("new-context", define(Mutation::KIND_CONTEXT));
+  RegisterForm("new-intersection-type", new_intersection_type);
+  RegisterForm("new-union-type", [](SconeLoader& loader,
+                                    const SconeForm& form) {
+    auto args = form.Args();
+    if (args.size() < 2 || !args[0]->IsName()) return false;
+    loader.Ensure(args[0]->text, Mutation::KIND_ENTITY,
+                  scone_names(*args[1]));
+    return true;
+  });
+  RegisterForm("new-split-subtypes", new_split_subtypes);
+  RegisterForm("new-complete-split-subtypes", new_split_subtypes);
+  RegisterForm("new-type-role", new_role);
+  RegisterForm("new-indv-role", new_role);
+  RegisterForm("new-relation", new_relation);
+}
+
+void SconeLoader::RegisterForm(const std::string& head, FormHandler handler) {
+  mHandlers[head] = std::move(handler);
+}
+
+SconeLoader::FormHandler SconeLoader::Handler(const std::string& head) const {
+  auto found = mHandlers.find(head);
+  return found == mHandlers.end() ? FormHandler() : found->second;
+}
+
+void SconeLoader::ChainForm(const std::string& head, FormHandler handler) {
+  FormHandler previous = Handler(head);
+  if (!previous) {
+    RegisterForm(head, std::move(handler));
+    return;
+  }
+  RegisterForm(head, [previous, handler](SconeLoader& loader,
+                                         const SconeForm& form) {
+    return previous(loader, form) && handler(loader, form);
+  });
+}
+
+bool SconeLoader::Load(std::istream& in, const std::string& source,
+                       std::string& error) {
+  std::string text{std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>()};
+  FormReader reader(std::move(text));
+  SconeForm form;
+  std::string syntax_error;
+  while (true) {
+    form = SconeForm();
+    if (!reader.Next(form, syntax_error)) break;
+    ++mStats.forms;
+    auto handler = mHandlers.find(form.Head());
+    if (handler != mHandlers.end() && handler->second(*this, form)) {
+      ++mStats.handled;
+    } else {
+      ++mStats.skipped;
+      ++mStats.skipped_forms[form.Head()];
+    }
+  }
+  Flush();
+  if (!syntax_error.empty()) {
+    error = fmt::format("{}: {}", source, syntax_error);
+    return false;
+  }
+  return true;
+}
+
+bool SconeLoader::LoadFile(const std::string& path, std::string& error) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    error = fmt::format("cannot open '{}'", path);
+    return false;
+  }
+  return Load(in, path, error);
+}
+
+bool SconeLoader::LoadCore(const std::string& dir, std::string& error) {
+  for (const char* component : kCoreComponents) {
+    std::string path =
+        fmt::format("{}/core-components/{}.lisp", dir, component);
+    if (!LoadFile(path, error)) return false;
+  }
+  return true;
+}
+
+void SconeLoader::Flush() {
+  if (mBatch.empty()) return;
+  // Runs of additive mutations are built in one pass each, the others are
+  // applied in between so that the order of the assertions holds.
+  BulkBuilder builder;
+  std::vector<Mutation> rest;
+  auto build = [&]() {
+    if (builder.Size() == 0) return;
+    BulkBuildStats built = builder.Build(mHyperbase);
+    mStats.applied +=
+        built.concepts + built.edges + built.splits + built.members;
+    mStats.failed += built.failed;
+  };
+  auto apply = [&]() {
+    if (rest.empty()) return;
+    BatchResult result = mHyperbase.ApplyBatch(rest);
+    mStats.applied += result.applied;
+    mStats.failed += result.failed;
+    rest.clear();
+  };
+  for (auto& mut : mBatch) {
+    if (builder.Add(mut)) {
+      apply();
+      continue;
+    }
+    build();
+    rest.push_back(std::move(mut));
+  }
+  build();
+  apply();
+  mBatch.clear();
+}
+
+bool SconeLoader::Known(const std::string& name) {
+  if (mKnown.count(name)) return true;
+  bool exists;
+  {
+    std::shared_lock<std::shared_mutex> lock(mHyperbase.Mutex());
+    exists = mHyperbase.HasConcept(name);
+  }
+  if (exists) mKnown.insert(name);
+  return exists;
+}
+
+void SconeLoader::Ensure(const std::string& name, Mutation::CONCEPT_KIND kind,
+                         const std::vector<std::string>& parents) {
+  Mutation mut;
+  mut.subject = name;
+  for (const auto& parent : parents) {
+    if (parent == name) continue;
+    Ensure(parent, Mutation::KIND_CONCEPT);
+    mut.objects.push_back(parent);
+  }
+  if (Known(name)) {
+    if (mut.objects.empty()) return;
+    mut.kind = Mutation::MUT_ADD_PARENT;
+  } else {
+    mKnown.insert(name);
+    mut.kind = Mutation::MUT_ADD_CONCEPT;
+    mut.concept_kind = kind;
+  }
+  Emit(std::move(mut));
+}
+
+void SconeLoader::Emit(Mutation&& mut) {
+  mBatch.push_back(std::move(mut));
+  if (mBatch.size() >= kDefaultBatch) Flush();
+}
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief One parsed s-expression of a Scone knowledge file. Quote markers
+ * ('x, #'x, `x, ,x) are dropped, the quoted form is kept.
+ */
+struct SconeForm {
+  enum TYPE {
+    LIST,    // (...)
+    NAME,    // {element name}, text without braces
+    STRING,  // "...", text without quotes
+    SYMBOL,  // anything else: symbols, keywords, numbers
+  };
+
+  TYPE type{SYMBOL};
+  std::string text;
+  std::vector<SconeForm> items;
+  uint32_t line{0};
+
+  inline bool IsList() const { return type == LIST; }
+  inline bool IsName() const { return type == NAME; }
+  inline bool IsKeyword() const {
+    return type == SYMBOL && !text.empty() && text[0] == ':';
+  }
+
+  // Head symbol of a list, empty otherwise.
+  const std::string& Head() const;
+
+  /**
+   * @brief Positional arguments of a call form, i.e. the items after the
+   * head up to the first keyword.
+   */
+  std::vector<const SconeForm*> Args() const;
+
+  /**
+   * @brief Value following `keyword` among the arguments, nullptr if absent.
+   */
+  const SconeForm* Option(const std::string& keyword) const;
+};
+
+/**
+ * @brief Counters of a Scone load.
+ */
+struct SconeLoadStats {
+  uint64_t forms{0};
+  uint64_t handled{0};
+  uint64_t skipped{0};
+  uint64_t applied{0};
+  uint64_t failed{0};
+  // Skipped top-level forms by head symbol.
+  std::map<std::string, uint64_t> skipped_forms;
+};
+
+/**
+ * @brief Loads Scone knowledge files (data/scone) into a hyperbase.
+ *
+ * Top-level forms are read one at a time and dispatched by their head symbol
+ * to a form handler, which translates the Scone assertion into mutations.
+ * Mutations are applied in batches, with runs of additive ones going through
+ * a BulkBuilder. Element names are the text between the braces. Elements
+ * referenced before being defined, e.g. the bootstrap elements of the Scone
+ * engine such as {thing}, are created on first use.
+ *
+ * Procedural code (defun, let, setq, ...) is not interpreted and counted as
+ * skipped, and so are assertions without a handler. New assertion types are
+ * supported by registering handlers.
+ */
+class SconeLoader {
+public:
+  using FormHandler = std::function<bool(SconeLoader&, const SconeForm&)>;
+
+  static constexpr size_t kDefaultBatch = 8192;
+
+  explicit SconeLoader(Hyperbase& hyperbase);
+
+  /**
+   * @brief Handle top-level forms with the given head symbol. The handler
+   * returns false if it could not make sense of a form.
+   */
+  void RegisterForm(const std::string& head, FormHandler handler);
+
+  // Handler of a head symbol, empty if there is none.
+  FormHandler Handler(const std::string& head) const;
+
+  /**
+   * @brief Run `handler` after the handler already registered for `head`,
+   * if any and unless that one fails.
+   */
+  void ChainForm(const std::string& head, FormHandler handler);
+
+  /**
+   * @brief Load every top-level form of a stream.
+   *
+   * @param in Input stream
+   * @param source Source name for error messages
+   * @param error Error message on failure
+   * @return false on a syntax error. Forms before it are loaded.
+   */
+  bool Load(std::istream& in, const std::string& source, std::string& error);
+  bool LoadFile(const std::string& path, std::string& error);
+
+  /**
+   * @brief Load the core components of a Scone data directory, upper
+   * ontology first.
+   *
+   * @param dir Directory such as data/scone
+   */
+  bool LoadCore(const std::string& dir, std::string& error);
+
+  // Apply pending mutations. Called at the end of every Load().
+  void Flush();
+
+  inline const SconeLoadStats& Stats() const { return mStats; }
+  inline Hyperbase& Target() { return mHyperbase; }
+
+  /**
+   * @brief Make sure an element exists, queueing its creation if not. Known
+   * elements are given the additional parents.
+   *
+   * @param name Element name
+   * @param kind Kind used if the element is created
+   * @param parents Parents, created as plain concepts if unknown
+   */
+  void Ensure(const std::string& name, Mutation::CONCEPT_KIND kind,
+              const std::vector<std::string>& parents = {});
+
+  // Queue a mutation, after the ones creating the elements it refers to.
+  void Emit(Mutation&& mut);
+
+  bool Known(const std::string& name);
+
+private:
+  void RegisterCoreForms();
+
+  Hyperbase& mHyperbase;
+  std::unordered_map<std::string, FormHandler> mHandlers;
+  std::unordered_set<std::string> mKnown;
+  std::vector<Mutation> mBatch;
+  SconeLoadStats mStats;
+};
+
+/**
+ * @brief Text of an element name form, or of the first item of a list such
+ * as ({animal} :adj "animate"). Empty if there is none.
+ */
+std::string scone_name(const SconeForm& form);
+
+/**
+ * @brief Element names of the first `count` arguments of a form.
+ * @return false if there are fewer or one is not a name
+ */
+bool scone_arg_names(const SconeForm& form, size_t count,
+                     std::vector<std::string>& names);
+
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,207 @@
+#include "base/storage/snapshot.h"
+
+#include <fmt/core.h>
+
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <vector>
+
+#include "base/core/bulk_builder.h"
+#include "base/core/event.h"
+#include "base/storage/mutation_codec.h"
+#include "common/utils/fsync.h"
+
+namespace hyperon {
+namespace base {
+
+namespace {
+
+constexpr const char* kSnapshotMagic = "HYPERBASE-SNAPSHOT";
+constexpr int kSnapshotFormat = 1;
+
+void write_line(std::ofstream& out, const Mutation& mut, std::string& buf) {
+  buf.clear();
+  encode_mutation(mut, buf);
+  buf += '\n';
+  out.write(buf.data(), buf.size());
+}
+
+bool parse_header(const std::string& line, SnapshotHeader& header) {
+  // Header fields reuse the mutation escaping: the subject carries the
+  // name, the objects carry owner, version, quota and timestamps.
+  Mutation fields;
+  if (!decode_mutation(line, fields) || fields.category != kSnapshotMagic ||
+      fields.objects.size() != 6) {
+    return false;
+  }
+  try {
+    header.name = fields.subject;
+    header.owner = fields.objects[0];
+    header.version = std::stoull(fields.objects[1]);
+    header.memory_quota = std::stoull(fields.objects[2]);
+    header.status.created_time = std::stoull(fields.objects[3]);
+    header.status.updated_time = std::stoull(fields.objects[4]);
+    header.status.last_read_time = std::stoull(fields.objects[5]);
+  } catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool write_snapshot(const Hyperbase& hyperbase, const std::string& path,
+                    std::string& error) {
+  std::string tmp = path + ".tmp";
+  std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    error = fmt::format("cannot open '{}' for writing", tmp);
+    return false;
+  }
+
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  HyperbaseStatus status = hyperbase.Status();
+  Mutation header;
+  header.category = kSnapshotMagic;
+  header.subject = hyperbase.Name();
+  header.objects = {hyperbase.Owner(),
+                    std::to_string(hyperbase.Version()),
+                    std::to_string(hyperbase.MemoryQuota()),
+                    std::to_string(status.created_time),
+                    std::to_string(status.updated_time),
+                    std::to_string(status.last_read_time)};
+
+  std::string buf;
+  write_line(out, header, buf);
+
+  CategoryPtr root = hyperbase.RootCategory();
+  hyperbase.ForEachConcept([&](const ConceptPtr& cnpt) {
+    Mutation mut;
+    mut.kind = Mutation::MUT_ADD_CONCEPT;
+    mut.concept_kind = concept_kind_of(cnpt);
+    CategoryPtr category = cnpt->GetCategory();
+    if (category && category != root) mut.category = category->Name();
+    mut.subject = cnpt->SemName();
+    write_line(out, mut, buf);
+  });
+
+  hyperbase.ForEachConcept([&](const ConceptPtr& cnpt) {
+    Mutation mut;
+    mut.subject = cnpt->SemName();
+    if (cnpt->ParentCount() > 0) {
+      mut.kind = Mutation::MUT_ADD_PARENT;
+      cnpt->ForEachParent([&mut](const ElementPtr& parent) {
+        mut.objects.push_back(parent->SemName());
+      });
+      write_line(out, mut, buf);
+    }
+    mut.kind = Mutation::MUT_ADD_SPLIT;
+    for (const auto& split : cnpt->Splits()) {
+      mut.objects.assign(split.begin(), split.end());
+      write_line(out, mut, buf);
+    }
+    mut.kind = Mutation::MUT_ADD_UNION;
+    for (const auto& parents : cnpt->Unions()) {
+      mut.objects.assign(parents.begin(), parents.end());
+      write_line(out, mut, buf);
+    }
+    if (cnpt->IsRelation()) {
+      auto relation = std::static_pointer_cast<Relation>(cnpt);
+      if (relation->MemberCount() > 0) {
+        mut.kind = Mutation::MUT_ADD_MEMBER;
+        mut.objects.clear();
+        relation->ForEachMember([&mut](const ConceptPtr& member) {
+          mut.objects.push_back(member->SemName());
+        });
+        write_line(out, mut, buf);
+      }
+    }
+  });
+
+  const EventIntervalIndex& events = hyperbase.Events();
+  events.Visit(EventIntervalIndex::kMin, EventIntervalIndex::kMax,
+               EventIntervalIndex::kMin, EventIntervalIndex::kMax,
+               [&](EventIntervalIndex::Handle handle) {
+                 Mutation mut;
+                 mut.kind = Mutation::MUT_SET_INTERVAL;
+                 mut.subject = events.Value(handle)->SemName();
+                 mut.objects = {std::to_string(events.Start(handle))};
+                 if (events.End(handle) != Event::kOpenEnd) {
+                   mut.objects.push_back(std::to_string(events.End(handle)));
+                 }
+                 write_line(out, mut, buf);
+                 return true;
+               });
+  lock.unlock();
+
+  out.close();
+  // The file must be on disk before it replaces the previous snapshot, and
+  // the rename itself before the caller forgets the in-memory state.
+  if (!out || !common::sync_file(tmp)) {
+    error = fmt::format("failed writing '{}'", tmp);
+    std::remove(tmp.c_str());
+    return false;
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    error = fmt::format("cannot rename '{}' to '{}'", tmp, path);
+    std::remove(tmp.c_str());
+    return false;
+  }
+  if (!common::sync_parent_dir(path)) {
+    error = fmt::format("cannot sync the directory of '{}'", path);
+    return false;
+  }
+  return true;
+}
+
+bool read_snapshot_header(const std::string& path, SnapshotHeader& header,
+                          std::string& error) {
+  std::ifstream in(path, std::ios::binary);
+  std::string line;
+  if (!in || !std::getline(in, line) || !parse_header(line, header)) {
+    error = fmt::format("'{}' is not a hyperbase snapshot", path);
+    return false;
+  }
+  return true;
+}
+
+bool read_snapshot(const std::string& path, HyperbasePtr& result,
+                   std::string& error) {
+  std::ifstream in(path, std::ios::binary);
+  std::string line;
+  SnapshotHeader header;
+  if (!in || !std::getline(in, line) || !parse_header(line, header)) {
+    error = fmt::format("'{}' is not a hyperbase snapshot", path);
+    return false;
+  }
+
+  auto hyperbase = std::make_shared<Hyperbase>(header.name, header.owner);
+  // Concepts, lineage and members are rebuilt in one pass, intervals are
+  // set afterwards.
+  BulkBuilder builder;
+  std::vector<Mutation> rest;
+  Mutation mut;
+  uint64_t lineno = 1;
+  while (std::getline(in, line)) {
+    ++lineno;
+    mut = Mutation();
+    if (!decode_mutation(line, mut)) {
+      error = fmt::format("{}:{}: malformed record", path, lineno);
+      return false;
+    }
+    if (!builder.Add(mut)) rest.push_back(std::move(mut));
+  }
+  builder.Build(*hyperbase);
+  if (!rest.empty()) hyperbase->ApplyBatch(rest);
+
+  hyperbase->Restore(header.version, header.status);
+  hyperbase->SetMemoryQuota(header.memory_quota);
+  result = hyperbase;
+  return true;
+}
+
+}  // namespace base
+}  // namespace hyperon
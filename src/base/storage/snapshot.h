@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+
+/**
+ * @brief Metadata stored in the first line of a snapshot file.
+ */
+struct SnapshotHeader {
+  std::string name;
+  std::string owner;
+  uint64_t version{0};
+  uint64_t memory_quota{0};
+  HyperbaseStatus status;
+};
+
+/**
+ * @brief Write a consistent snapshot of a hyperbase under its shared lock.
+ *
+ * The file holds a header line followed by encoded mutations which rebuild
+ * the hyperbase when replayed in order: concepts first, then lineage, splits,
+ * unions and relation members. It is written to a temporary file, synced,
+ * renamed and the directory synced, so a crash never leaves a truncated
+ * snapshot behind and a successful return means the snapshot is durable.
+ *
+ * @param hyperbase Hyperbase to persist
+ * @param path Target file
+ * @param error Error message on failure
+ * @return true on success.
+ */
+bool write_snapshot(const Hyperbase& hyperbase, const std::string& path,
+                    std::string& error);
+
+/**
+ * @brief Read only the header of a snapshot file.
+ */
+bool read_snapshot_header(const std::string& path, SnapshotHeader& header,
+                          std::string& error);
+
+/**
+ * @brief Rebuild a hyperbase from a snapshot file.
+ *
+ * @param path Snapshot file
+ * @param result Loaded hyperbase
+ * @param error Error message on failure
+ * @return true on success.
+ */
+bool read_snapshot(const std::string& path, HyperbasePtr& result,
+                   std::string& error);
+
+}  // namespace base
+}  // namespace hyperon
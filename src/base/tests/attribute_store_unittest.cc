@@ -0,0 +1,337 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/storage/attribute_store.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation isa(const std::string& cnpt, std::vector<std::string> parents) {
+  Mutation mut;
+  mut.kind = Mutation::MUT_ADD_CONCEPT;
+  mut.subject = cnpt;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+AttributeQuery query(const std::string& attribute,
+                     const std::string& unit = "",
+                     const std::string& under = "") {
+  AttributeQuery result;
+  result.attribute = attribute;
+  result.unit = unit;
+  result.under = under;
+  return result;
+}
+
+using Names = std::vector<std::string>;
+
+// Europe <- {France <- {Paris, Lyon, Marseille}, Germany <- {Berlin,
+// Munich}}, Asia <- Tokyo, with populations and temperatures, and units of
+// temperature, length and time.
+class AttributeStoreTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mHyperbase->ApplyBatch(
+        {isa("place", {}), isa("Europe", {"place"}), isa("Asia", {"place"}),
+         isa("France", {"Europe"}), isa("Germany", {"Europe"}),
+         isa("Paris", {"France"}), isa("Lyon", {"France"}),
+         isa("Marseille", {"France"}), isa("Berlin", {"Germany"}),
+         isa("Munich", {"Germany"}), isa("Tokyo", {"Asia"})});
+
+    mStore.DefineQuality("temperature");
+    Define("Kelvin", "temperature", "", 1, 0);
+    Define("degree Celsius", "temperature", "Kelvin", 1, 273.15);
+    // Relative to Celsius, whose zero point is added on.
+    Define("degree Fahrenheit", "temperature", "degree Celsius", 5.0 / 9,
+           -160.0 / 9);
+    mStore.DefineQuality("length");
+    Define("meter", "length", "", 1, 0);
+    Define("kilometer", "length", "meter", 1000, 0);
+    Define("mile", "length", "meter", 1609.344, 0);
+    mStore.DefineQuality("time");
+    Define("second", "time", "", 1, 0);
+    Define("minute", "time", "second", 60, 0);
+    mStore.AddUnitAlias("km", "kilometer");
+    mStore.AddUnitAlias("m", "meter");
+    mStore.AddUnitAlias("m", "minute");
+    mStore.AddUnitAlias("s", "second");
+
+    Set("Paris", "population", 2.1e6);
+    Set("Lyon", "population", 0.5e6);
+    Set("Marseille", "population", 0.87e6);
+    Set("Berlin", "population", 3.6e6);
+    Set("Munich", "population", 1.5e6);
+    Set("Tokyo", "population", 14e6);
+
+    Set("Paris", "mean temperature", 12.5, "degree Celsius");
+    Set("Berlin", "mean temperature", 10, "degree Celsius");
+    Set("Tokyo", "mean temperature", 16, "degree Celsius");
+    Set("Lyon", "mean temperature", 55.4, "degree Fahrenheit");
+  }
+
+  void Define(const std::string& unit, const std::string& quality,
+              const std::string& relative, double ratio, double offset) {
+    std::string error;
+    ASSERT_TRUE(
+        mStore.DefineUnit(unit, quality, relative, ratio, offset, error))
+        << error;
+  }
+
+  void Set(const std::string& cnpt, const std::string& attribute,
+           double value, const std::string& unit = "") {
+    std::string error;
+    ASSERT_TRUE(mStore.Set(cnpt, attribute, value, unit, error)) << error;
+  }
+
+  double Convert(double value, const std::string& from,
+                 const std::string& to) {
+    double result = 0;
+    std::string error;
+    EXPECT_TRUE(mStore.Convert(value, from, to, result, error)) << error;
+    return result;
+  }
+
+  std::vector<AttributeValue> Range(const AttributeQuery& query) {
+    std::vector<AttributeValue> out;
+    std::string error;
+    EXPECT_TRUE(mStore.Range(query, out, error)) << error;
+    return out;
+  }
+
+  Names RangeNames(const AttributeQuery& query) {
+    Names names;
+    for (const auto& value : Range(query)) names.push_back(value.cnpt);
+    return names;
+  }
+
+  HyperbasePtr mHyperbase = std::make_shared<Hyperbase>("attributes");
+  NumericAttributeStore mStore{*mHyperbase};
+};
+
+TEST_F(AttributeStoreTest, ConvertsOffsetScales) {
+  EXPECT_NEAR(Convert(0, "degree Celsius", "Kelvin"), 273.15, 1e-9);
+  EXPECT_NEAR(Convert(300, "Kelvin", "degree Celsius"), 26.85, 1e-9);
+  EXPECT_NEAR(Convert(212, "degree Fahrenheit", "degree Celsius"), 100,
+              1e-9);
+  EXPECT_NEAR(Convert(-40, "degree Celsius", "degree Fahrenheit"), -40,
+              1e-9);
+  EXPECT_NEAR(Convert(0, "Kelvin", "degree Fahrenheit"), -459.67, 1e-9);
+  // Lower-case names of units are accepted too.
+  EXPECT_NEAR(Convert(1, "kelvin", "Kelvin"), 1, 1e-12);
+  EXPECT_NEAR(Convert(3, "mile", "km"), 4.828032, 1e-9);
+
+  double value = 0;
+  ASSERT_TRUE(mStore.Get("Lyon", "mean temperature", value));
+  // Stored in the base unit.
+  EXPECT_NEAR(value, 286.15, 1e-9);
+
+  std::string error;
+  double result;
+  EXPECT_FALSE(mStore.Convert(1, "meter", "second", result, error));
+  EXPECT_EQ(error, "cannot convert meter to second");
+  EXPECT_FALSE(mStore.Convert(1, "meter", "furlong", result, error));
+  EXPECT_EQ(error, "unknown unit furlong");
+  EXPECT_FALSE(mStore.DefineUnit("rankine", "temperature", "", 5.0 / 9, 0,
+                                 error));
+  EXPECT_EQ(error, "temperature already has the base unit Kelvin");
+  EXPECT_FALSE(mStore.DefineUnit("hour", "time", "meter", 3600, 0, error));
+  EXPECT_FALSE(mStore.DefineUnit("hour", "time", "minute", 0, 0, error));
+}
+
+TEST_F(AttributeStoreTest, DropsAmbiguousAliases) {
+  std::string quality;
+  ASSERT_TRUE(mStore.UnitQuality("km", quality));
+  EXPECT_EQ(quality, "length");
+  ASSERT_TRUE(mStore.UnitQuality("s", quality));
+  EXPECT_EQ(quality, "time");
+  // "m" was given to meter and minute.
+  EXPECT_FALSE(mStore.UnitQuality("m", quality));
+  std::string error;
+  EXPECT_FALSE(mStore.Set("Paris", "elevation", 35, "m", error));
+  EXPECT_EQ(error, "unknown unit m");
+  // And stays ambiguous, even when given again to either unit.
+  mStore.AddUnitAlias("m", "meter");
+  EXPECT_FALSE(mStore.UnitQuality("m", quality));
+  // Repeating an alias for the same unit keeps it.
+  mStore.AddUnitAlias("km", "kilometer");
+  EXPECT_TRUE(mStore.UnitQuality("km", quality));
+  // Aliases of unknown units are ignored.
+  mStore.AddUnitAlias("fl", "furlong");
+  EXPECT_FALSE(mStore.UnitQuality("fl", quality));
+}
+
+TEST_F(AttributeStoreTest, KeepsAttributesToOneQuality) {
+  Set("Paris", "elevation", 35, "meter");
+  std::string error;
+  EXPECT_FALSE(mStore.Set("Lyon", "elevation", 1, "minute", error));
+  EXPECT_EQ(error, "minute is no unit of attribute elevation");
+  EXPECT_FALSE(mStore.DeclareAttribute("elevation", "time", error));
+  EXPECT_TRUE(mStore.DeclareAttribute("elevation", "length", error));
+  std::vector<AttributeValue> out;
+  EXPECT_FALSE(mStore.Range(query("elevation", "second"), out, error));
+  EXPECT_EQ(error, "second is no unit of attribute elevation");
+  EXPECT_FALSE(mStore.Range(query("altitude"), out, error));
+  EXPECT_EQ(error, "unknown attribute altitude");
+}
+
+TEST_F(AttributeStoreTest, MergesPendingWritesOnRead) {
+  AttributeStats stats = mStore.Stats();
+  EXPECT_EQ(stats.values, 10u);
+  EXPECT_EQ(stats.pending, 10u);
+  EXPECT_EQ(RangeNames(query("population")),
+            (Names{"Lyon", "Marseille", "Munich", "Paris", "Berlin",
+                   "Tokyo"}));
+  // Only the read column was merged.
+  EXPECT_EQ(mStore.Stats().pending, 4u);
+
+  // Unchanged values are not pending.
+  Set("Paris", "population", 2.1e6);
+  EXPECT_EQ(mStore.Stats().pending, 4u);
+  Set("Lyon", "population", 5e6);
+  ASSERT_TRUE(mStore.Erase("Berlin", "population"));
+  EXPECT_FALSE(mStore.Erase("Berlin", "population"));
+  EXPECT_FALSE(mStore.Erase("Atlantis", "population"));
+  // Erased and set again before the merge.
+  ASSERT_TRUE(mStore.Erase("Munich", "population"));
+  Set("Munich", "population", 1.6e6);
+  EXPECT_EQ(mStore.Stats().pending, 8u);
+  // Point reads do not wait for the merge.
+  double value = 0;
+  ASSERT_TRUE(mStore.Get("Lyon", "population", value));
+  EXPECT_EQ(value, 5e6);
+  EXPECT_FALSE(mStore.Get("Berlin", "population", value));
+
+  common::ProfileNode profile;
+  std::vector<AttributeValue> out;
+  std::string error;
+  ASSERT_TRUE(mStore.Range(query("population"), out, error, &profile));
+  ASSERT_EQ(out.size(), 5u);
+  EXPECT_EQ(out[0].cnpt, "Marseille");
+  EXPECT_EQ(out[1].cnpt, "Munich");
+  EXPECT_EQ(out[1].value, 1.6e6);
+  EXPECT_EQ(out[2].cnpt, "Paris");
+  EXPECT_EQ(out[3].cnpt, "Lyon");
+  EXPECT_EQ(out[4].cnpt, "Tokyo");
+  EXPECT_EQ(profile.Child("merge_pending").rows_in, 4u);
+  EXPECT_EQ(profile.Child("merge_pending").rows_out, 5u);
+  stats = mStore.Stats();
+  EXPECT_EQ(stats.pending, 4u);
+  EXPECT_EQ(stats.values, 9u);
+}
+
+TEST_F(AttributeStoreTest, FiltersRangesByLineage) {
+  AttributeQuery millions = query("population", "", "Europe");
+  millions.low = 1e6;
+  EXPECT_EQ(RangeNames(millions), (Names{"Munich", "Paris", "Berlin"}));
+  millions.high = 3e6;
+  millions.under = "France";
+  EXPECT_EQ(RangeNames(millions), (Names{"Paris"}));
+  millions.under = "Paris";
+  EXPECT_EQ(RangeNames(millions), (Names{"Paris"}));
+  millions.under = "Atlantis";
+  EXPECT_EQ(RangeNames(millions), Names{});
+
+  common::ProfileNode profile;
+  std::vector<AttributeValue> out;
+  std::string error;
+  ASSERT_TRUE(mStore.Range(query("population", "", "Europe"), out, error,
+                           &profile));
+  EXPECT_EQ(out.size(), 5u);
+  const common::ProfileNode& lineage = profile.Child("lineage");
+  // Europe, the two countries and the five cities.
+  EXPECT_EQ(lineage.rows_in, 8u);
+  EXPECT_EQ(profile.Child("column_scan").index, "sorted_column");
+}
+
+TEST_F(AttributeStoreTest, ReadsTopKFromTheFarEnd) {
+  AttributeQuery top = query("population");
+  top.descending = true;
+  top.limit = 2;
+  EXPECT_EQ(RangeNames(top), (Names{"Tokyo", "Berlin"}));
+  top.under = "Europe";
+  EXPECT_EQ(RangeNames(top), (Names{"Berlin", "Paris"}));
+  top.under = "France";
+  top.limit = 5;
+  EXPECT_EQ(RangeNames(top), (Names{"Paris", "Marseille", "Lyon"}));
+  top.high = 2e6;
+  top.limit = 1;
+  EXPECT_EQ(RangeNames(top), (Names{"Marseille"}));
+
+  // Ascending with a limit is bottom-k.
+  AttributeQuery bottom = query("population", "", "Germany");
+  bottom.limit = 1;
+  EXPECT_EQ(RangeNames(bottom), (Names{"Munich"}));
+
+  common::ProfileNode profile;
+  std::vector<AttributeValue> out;
+  std::string error;
+  top = query("population", "", "Germany");
+  top.descending = true;
+  top.limit = 1;
+  ASSERT_TRUE(mStore.Range(top, out, error, &profile));
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0].cnpt, "Berlin");
+  // Probes parents from Tokyo on instead of marking the subtree.
+  EXPECT_EQ(profile.Child("column_scan").index, "sorted_column, parents");
+  EXPECT_EQ(profile.Child("column_scan").rows_in, 2u);
+}
+
+TEST_F(AttributeStoreTest, AnswersInTheQueryUnit) {
+  AttributeQuery mild = query("mean temperature", "degree Celsius");
+  mild.low = 11;
+  mild.high = 14;
+  std::vector<AttributeValue> out = Range(mild);
+  ASSERT_EQ(out.size(), 2u);
+  EXPECT_EQ(out[0].cnpt, "Paris");
+  EXPECT_NEAR(out[0].value, 12.5, 1e-9);
+  EXPECT_EQ(out[1].cnpt, "Lyon");
+  EXPECT_NEAR(out[1].value, 13, 1e-9);
+
+  AttributeAggregate result;
+  std::string error;
+  ASSERT_TRUE(mStore.Aggregate(query("mean temperature", "degree Celsius"),
+                               result, error))
+      << error;
+  EXPECT_EQ(result.count, 4u);
+  EXPECT_NEAR(result.sum, 51.5, 1e-9);
+  EXPECT_NEAR(result.Mean(), 12.875, 1e-9);
+  EXPECT_NEAR(result.min, 10, 1e-9);
+  EXPECT_NEAR(result.max, 16, 1e-9);
+
+  ASSERT_TRUE(mStore.Aggregate(query("mean temperature"), result, error));
+  EXPECT_NEAR(result.sum, 51.5 + 4 * 273.15, 1e-9);
+  EXPECT_NEAR(result.min, 283.15, 1e-9);
+
+  // Offsets apply per value: 54.5, 50 and 55.4 degrees Fahrenheit.
+  ASSERT_TRUE(mStore.Aggregate(
+      query("mean temperature", "degree Fahrenheit", "Europe"), result,
+      error));
+  EXPECT_EQ(result.count, 3u);
+  EXPECT_NEAR(result.sum, 159.9, 1e-9);
+  EXPECT_NEAR(result.min, 50, 1e-9);
+  EXPECT_NEAR(result.max, 55.4, 1e-9);
+
+  // Bounds are in the query unit too, order and limit are ignored.
+  AttributeQuery warm = query("mean temperature", "degree Fahrenheit");
+  warm.low = 55;
+  warm.limit = 1;
+  warm.descending = true;
+  ASSERT_TRUE(mStore.Aggregate(warm, result, error));
+  EXPECT_EQ(result.count, 2u);
+  EXPECT_NEAR(result.min, 55.4, 1e-9);
+  EXPECT_NEAR(result.max, 60.8, 1e-9);
+
+  warm.low = 100;
+  ASSERT_TRUE(mStore.Aggregate(warm, result, error));
+  EXPECT_EQ(result.count, 0u);
+  EXPECT_EQ(result.Mean(), 0);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
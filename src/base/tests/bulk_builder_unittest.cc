@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/core/bulk_builder.h"
+#include "base/core/relation.h"
+#include "base/storage/mutation_codec.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation create(const std::string& name, std::vector<std::string> parents = {},
+                Mutation::CONCEPT_KIND kind = Mutation::KIND_CONCEPT,
+                const std::string& category = "") {
+  Mutation mut;
+  mut.subject = name;
+  mut.objects = std::move(parents);
+  mut.concept_kind = kind;
+  mut.category = category;
+  return mut;
+}
+
+Mutation member(const std::string& relation, const std::string& member) {
+  Mutation mut;
+  mut.kind = Mutation::MUT_ADD_MEMBER;
+  mut.subject = relation;
+  mut.objects = {member};
+  return mut;
+}
+
+std::vector<std::string> sorted(std::vector<std::string> names) {
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// Concepts with kind, category, lineage and members, one line each.
+std::vector<std::string> describe(const Hyperbase& hyperbase) {
+  std::vector<std::string> lines;
+  hyperbase.ForEachConcept([&lines](const ConceptPtr& cnpt) {
+    std::vector<std::string> parents, children, members;
+    cnpt->ForEachParent([&parents](const ElementPtr& parent) {
+      parents.push_back(parent->SemName());
+    });
+    cnpt->ForEachChild([&children](const ElementPtr& child) {
+      children.push_back(child->SemName());
+    });
+    if (cnpt->IsRelation()) {
+      std::static_pointer_cast<Relation>(cnpt)->ForEachMember(
+          [&members](const ConceptPtr& member) {
+            members.push_back(member->SemName());
+          });
+    }
+    std::string line = cnpt->SemName() + " " +
+                       std::to_string(concept_kind_of(cnpt)) + " " +
+                       cnpt->GetCategory()->Name();
+    for (const auto& list : {parents, children, members}) {
+      line += " |";
+      for (const auto& name : sorted(list)) line += " " + name;
+    }
+    lines.push_back(line);
+  });
+  return sorted(lines);
+}
+
+std::vector<std::string> parents_of(const Hyperbase& hyperbase,
+                                    const std::string& name) {
+  ConceptPtr cnpt;
+  EXPECT_TRUE(hyperbase.GetConcept(name, cnpt)) << name;
+  std::vector<std::string> parents;
+  if (cnpt) {
+    cnpt->ForEachParent([&parents](const ElementPtr& parent) {
+      parents.push_back(parent->SemName());
+    });
+  }
+  return sorted(parents);
+}
+
+class NullObserver : public CommitObserver {
+public:
+  void OnCommit(const Hyperbase&, uint64_t,
+                const std::vector<const Mutation*>& applied) override {
+    mApplied += applied.size();
+  }
+
+  size_t mApplied{0};
+};
+
+TEST(BulkBuilderTest, LinksEdgesNamingLaterConcepts) {
+  Hyperbase hyperbase("bulk");
+  BulkBuilder builder(2);
+  builder.AddEdge("puppy", "dog");
+  builder.Add(create("puppy", {"dog"}));
+  builder.Add(create("dog", {"animal"}));
+  builder.AddConcept("animal");
+  EXPECT_EQ(builder.Size(), 6u);
+
+  BulkBuildStats stats = builder.Build(hyperbase);
+  EXPECT_EQ(stats.concepts, 3u);
+  EXPECT_EQ(stats.edges, 2u);
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_EQ(stats.version, hyperbase.Version());
+  EXPECT_EQ(builder.Size(), 0u);
+  EXPECT_EQ(parents_of(hyperbase, "puppy"), (std::vector<std::string>{"dog"}));
+  EXPECT_EQ(parents_of(hyperbase, "dog"),
+            (std::vector<std::string>{"animal"}));
+}
+
+TEST(BulkBuilderTest, DropsEdgesToUnknownConcepts) {
+  Hyperbase hyperbase("bulk");
+  BulkBuilder builder(2);
+  builder.Add(create("dog", {"ghost", "animal"}));
+  builder.AddConcept("animal");
+  builder.AddEdge("phantom", "animal");
+  builder.AddSplit("animal", {"dog", "ghost"});
+  builder.AddConcept("walks", Mutation::KIND_RELATION);
+  builder.AddMember("walks", "dog");
+  builder.AddMember("walks", "nobody");
+
+  BulkBuildStats stats = builder.Build(hyperbase);
+  EXPECT_EQ(stats.concepts, 3u);
+  EXPECT_EQ(stats.edges, 1u);
+  EXPECT_EQ(stats.splits, 0u);
+  // Two edges, the split and both members: dog is no entity.
+  EXPECT_EQ(stats.failed, 5u);
+  EXPECT_EQ(stats.members, 0u);
+  EXPECT_EQ(parents_of(hyperbase, "dog"),
+            (std::vector<std::string>{"animal"}));
+  EXPECT_FALSE(hyperbase.HasConcept("ghost"));
+  EXPECT_FALSE(hyperbase.HasConcept("phantom"));
+}
+
+TEST(BulkBuilderTest, CountsDuplicateAndExistingConceptsAsFailed) {
+  Hyperbase hyperbase("bulk");
+  hyperbase.ApplyBatch({create("cat")});
+  BulkBuilder builder(2);
+  builder.AddConcept("cat", Mutation::KIND_ENTITY);
+  builder.AddConcept("dog", Mutation::KIND_ENTITY);
+  builder.AddConcept("dog", Mutation::KIND_RELATION);
+  builder.AddConcept("");
+
+  BulkBuildStats stats = builder.Build(hyperbase);
+  EXPECT_EQ(stats.concepts, 1u);
+  EXPECT_EQ(stats.failed, 3u);
+  EXPECT_EQ(hyperbase.ConceptCount(), 2u);
+  ConceptPtr cnpt;
+  ASSERT_TRUE(hyperbase.GetConcept("dog", cnpt));
+  // The first row of a name wins.
+  EXPECT_TRUE(cnpt->IsEntity());
+  ASSERT_TRUE(hyperbase.GetConcept("cat", cnpt));
+  EXPECT_FALSE(cnpt->IsEntity());
+}
+
+TEST(BulkBuilderTest, StopsAtTheLastDenseId) {
+  Hyperbase hyperbase("bulk");
+  hyperbase.ApplyBatch({create("root")});
+  hyperbase.LimitDenseIds(4);
+  BulkBuilder builder(2);
+  for (int i = 0; i < 5; ++i) {
+    builder.Add(create("c" + std::to_string(i), {"root"}));
+  }
+
+  BulkBuildStats stats = builder.Build(hyperbase);
+  EXPECT_EQ(stats.concepts, 3u);
+  EXPECT_EQ(stats.failed, 4u);
+  EXPECT_EQ(stats.edges, 3u);
+  EXPECT_EQ(hyperbase.ConceptCount(), 4u);
+  // Created in name order.
+  EXPECT_TRUE(hyperbase.HasConcept("c2"));
+  EXPECT_FALSE(hyperbase.HasConcept("c3"));
+  EXPECT_FALSE(hyperbase.ApplyBatch({create("late")}).applied);
+}
+
+TEST(BulkBuilderTest, BuildsTheSameStateThroughObservers) {
+  std::vector<Mutation> batch = {
+      create("animal"),
+      create("dog", {"animal"}, Mutation::KIND_ENTITY, "pets"),
+      create("cat", {"animal"}, Mutation::KIND_ENTITY, "pets"),
+      create("owns", {}, Mutation::KIND_RELATION),
+      member("owns", "dog"),
+      member("owns", "cat"),
+      create("puppy", {"dog", "animal"}, Mutation::KIND_ENTITY, "pets"),
+  };
+  Mutation split;
+  split.kind = Mutation::MUT_ADD_SPLIT;
+  split.subject = "animal";
+  split.objects = {"dog", "cat"};
+  batch.push_back(split);
+
+  Hyperbase applied("bulk");
+  BatchResult result = applied.ApplyBatch(batch);
+  EXPECT_EQ(result.failed, 0u);
+
+  Hyperbase built("bulk");
+  BulkBuilder builder(2);
+  for (const auto& mut : batch) ASSERT_TRUE(builder.Add(mut));
+  EXPECT_EQ(builder.Build(built).failed, 0u);
+
+  Hyperbase observed("bulk");
+  auto observer = std::make_shared<NullObserver>();
+  observed.AddCommitObserver(observer);
+  for (const auto& mut : batch) builder.Add(mut);
+  BulkBuildStats stats = builder.Build(observed);
+  EXPECT_EQ(stats.failed, 0u);
+  EXPECT_EQ(stats.concepts, 5u);
+  EXPECT_EQ(stats.members, 2u);
+  EXPECT_GT(observer->mApplied, 0u);
+  observed.RemoveCommitObserver(observer);
+
+  EXPECT_EQ(describe(built), describe(applied));
+  EXPECT_EQ(describe(observed), describe(applied));
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/datalog/datalog_engine.h"
+#include "base/datalog/datalog_view.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+using Facts = std::set<std::vector<std::string>>;
+
+const char* const kAncestors =
+    "ancestor(X, Y) :- isa(X, Y).\n"
+    "ancestor(X, Z) :- isa(X, Y), ancestor(Y, Z).\n";
+
+DatalogProgram parse(const std::string& text) {
+  DatalogProgram program;
+  std::string error;
+  EXPECT_TRUE(program.Parse(text, error)) << error;
+  return program;
+}
+
+template <typename Engine>
+Facts facts(const Engine& engine, const std::string& predicate) {
+  Facts result;
+  engine.ForEachFact(predicate, [&result](const std::vector<std::string>& f) {
+    result.insert(f);
+  });
+  return result;
+}
+
+// Facts of a fresh evaluation, the reference for incremental updates.
+Facts evaluated(const Hyperbase& hyperbase, const std::string& text,
+                const std::string& predicate) {
+  DatalogEngine engine(parse(text));
+  std::string error;
+  EXPECT_TRUE(engine.Evaluate(hyperbase, error)) << error;
+  return facts(engine, predicate);
+}
+
+Mutation edge(Mutation::MUTATION_KIND kind, const std::string& child,
+              const std::string& parent) {
+  Mutation mut;
+  mut.kind = kind;
+  mut.subject = child;
+  mut.objects = {parent};
+  return mut;
+}
+
+// a0 <- a1 <- .. <- a{n-1}, each the child of the previous one.
+void chain(Hyperbase& hyperbase, int n) {
+  std::vector<Mutation> batch;
+  for (int i = 0; i < n; ++i) {
+    Mutation mut;
+    mut.subject = "a" + std::to_string(i);
+    if (i > 0) mut.objects = {"a" + std::to_string(i - 1)};
+    batch.push_back(std::move(mut));
+  }
+  hyperbase.ApplyBatch(batch);
+}
+
+TEST(DatalogEngineTest, EvaluatesRecursionSemiNaively) {
+  Hyperbase hyperbase("chain");
+  chain(hyperbase, 10);
+  DatalogEngine engine(parse(kAncestors));
+  std::string error;
+  ASSERT_TRUE(engine.Evaluate(hyperbase, error)) << error;
+  EXPECT_EQ(engine.FactCount("ancestor"), 45u);
+  EXPECT_TRUE(engine.HasFact("ancestor", {"a9", "a0"}));
+  EXPECT_FALSE(engine.HasFact("ancestor", {"a0", "a9"}));
+  // Every round derives the paths one edge longer, so the number of rounds
+  // follows the depth rather than the number of facts.
+  EXPECT_LE(engine.Stats().iterations, 11u);
+  EXPECT_EQ(engine.Stats().derived_facts, 45u);
+  EXPECT_EQ(engine.Stats().version, hyperbase.Version());
+}
+
+TEST(DatalogEngineTest, StratifiesNegation) {
+  Hyperbase hyperbase("negation");
+  chain(hyperbase, 3);
+  std::string text = std::string(kAncestors) +
+                     "unrelated(X, Y) :- kind(X, concept), kind(Y, concept), "
+                     "X != Y, \\+ ancestor(X, Y), \\+ ancestor(Y, X).\n";
+  hyperbase.ApplyBatch({edge(Mutation::MUT_ADD_CONCEPT, "b", "a0")});
+  DatalogEngine engine(parse(text));
+  std::string error;
+  ASSERT_TRUE(engine.Evaluate(hyperbase, error)) << error;
+  EXPECT_EQ(facts(engine, "unrelated"),
+            (Facts{{"a1", "b"}, {"a2", "b"}, {"b", "a1"}, {"b", "a2"}}));
+  EXPECT_GE(engine.Stats().strata, 2u);
+}
+
+TEST(DatalogEngineTest, RejectsUnsafeAndUnstratifiablePrograms) {
+  std::string error;
+  DatalogEngine cyclic(parse("p(X) :- kind(X, concept), \\+ q(X).\n"
+                             "q(X) :- kind(X, concept), \\+ p(X).\n"));
+  EXPECT_FALSE(cyclic.Compile(error));
+  EXPECT_FALSE(error.empty());
+
+  error.clear();
+  DatalogEngine unsafe(parse("p(X, Y) :- kind(X, concept).\n"));
+  EXPECT_FALSE(unsafe.Compile(error));
+  EXPECT_FALSE(error.empty());
+}
+
+TEST(DatalogEngineTest, OrdersJoinsByRelationFanout) {
+  // crowd has 40 members, pair has 2, both shared with crowd.
+  Hyperbase hyperbase("fanout");
+  std::vector<Mutation> batch;
+  Mutation crowd, pair, in_crowd, in_pair;
+  crowd.concept_kind = pair.concept_kind = Mutation::KIND_RELATION;
+  crowd.subject = "crowd";
+  pair.subject = "pair";
+  batch.push_back(crowd);
+  batch.push_back(pair);
+  in_crowd.kind = in_pair.kind = Mutation::MUT_ADD_MEMBER;
+  in_crowd.subject = "crowd";
+  in_pair.subject = "pair";
+  for (int i = 0; i < 40; ++i) {
+    Mutation person;
+    person.concept_kind = Mutation::KIND_ENTITY;
+    person.subject = "p" + std::to_string(i);
+    batch.push_back(person);
+    in_crowd.objects.push_back(person.subject);
+    if (i % 20 == 0) in_pair.objects.push_back(person.subject);
+  }
+  batch.push_back(in_crowd);
+  batch.push_back(in_pair);
+  ASSERT_EQ(hyperbase.ApplyBatch(batch).failed, 0u);
+
+  // Written with the large relation first, planned with the small one.
+  DatalogEngine engine(
+      parse("both(X) :- member(crowd, X), member(pair, X).\n"));
+  std::string error;
+  common::ProfileNode profile;
+  ASSERT_TRUE(engine.Evaluate(hyperbase, error, &profile)) << error;
+  EXPECT_EQ(facts(engine, "both"), (Facts{{"p0"}, {"p20"}}));
+  std::string text = profile.ToString();
+  size_t small = text.find("probe (member(pair, X)) index=member[bf]");
+  size_t large = text.find("exists (member(crowd, X)) index=member[bb]");
+  ASSERT_NE(small, std::string::npos) << text;
+  ASSERT_NE(large, std::string::npos) << text;
+  EXPECT_LT(small, large);
+}
+
+TEST(DatalogEngineTest, CountsDerivationsOfNonRecursiveRules) {
+  // Two paths from d up to a: d-b-a and d-c-a.
+  Hyperbase hyperbase("diamond");
+  Mutation root;
+  root.subject = "a";
+  hyperbase.ApplyBatch({root, edge(Mutation::MUT_ADD_CONCEPT, "b", "a"),
+                        edge(Mutation::MUT_ADD_CONCEPT, "c", "a")});
+  hyperbase.ApplyBatch({edge(Mutation::MUT_ADD_CONCEPT, "d", "b"),
+                        edge(Mutation::MUT_ADD_PARENT, "d", "c")});
+  DatalogEngine engine(parse("grand(X, Z) :- isa(X, Y), isa(Y, Z).\n"));
+  std::string error;
+  ASSERT_TRUE(engine.Evaluate(hyperbase, error)) << error;
+  ASSERT_TRUE(engine.HasFact("grand", {"d", "a"}));
+
+  ASSERT_TRUE(engine.Update({{"isa", {"d", "b"}, false}}, error)) << error;
+  EXPECT_TRUE(engine.HasFact("grand", {"d", "a"}));
+  ASSERT_TRUE(engine.Update({{"isa", {"d", "c"}, false}}, error)) << error;
+  EXPECT_FALSE(engine.HasFact("grand", {"d", "a"}));
+  EXPECT_EQ(engine.Stats().erased_facts, 1u);
+
+  ASSERT_TRUE(engine.Update({{"isa", {"d", "c"}, true}}, error)) << error;
+  EXPECT_TRUE(engine.HasFact("grand", {"d", "a"}));
+}
+
+TEST(DatalogEngineTest, DeletesAndRederivesRecursiveFacts) {
+  Hyperbase hyperbase("dred");
+  chain(hyperbase, 6);
+  // A shortcut keeps a5 below a1 when a2-a1 goes away.
+  hyperbase.ApplyBatch({edge(Mutation::MUT_ADD_PARENT, "a3", "a1")});
+  DatalogEngine engine(parse(kAncestors));
+  std::string error;
+  ASSERT_TRUE(engine.Evaluate(hyperbase, error)) << error;
+
+  const std::vector<Mutation> changes = {
+      edge(Mutation::MUT_REMOVE_PARENT, "a2", "a1"),
+      edge(Mutation::MUT_REMOVE_PARENT, "a3", "a1"),
+      edge(Mutation::MUT_ADD_PARENT, "a5", "a0"),
+      edge(Mutation::MUT_REMOVE_PARENT, "a4", "a3"),
+  };
+  for (const auto& mut : changes) {
+    std::vector<DatalogChange> base;
+    hyperbase.ApplyBatch({mut});
+    std::vector<const Mutation*> applied = {&mut};
+    DatalogEngine::BaseChanges(hyperbase, applied, base);
+    ASSERT_TRUE(engine.Update(base, error)) << error;
+    EXPECT_EQ(facts(engine, "ancestor"),
+              evaluated(hyperbase, kAncestors, "ancestor"))
+        << "after " << mut.subject;
+  }
+  EXPECT_TRUE(engine.HasFact("ancestor", {"a5", "a0"}));
+  EXPECT_FALSE(engine.HasFact("ancestor", {"a5", "a1"}));
+  EXPECT_FALSE(engine.HasFact("ancestor", {"a5", "a3"}));
+  EXPECT_TRUE(engine.HasFact("ancestor", {"a3", "a2"}));
+  EXPECT_GT(engine.Stats().erased_facts, 0u);
+}
+
+TEST(DatalogViewTest, FollowsCommits) {
+  auto hyperbase = std::make_shared<Hyperbase>("view");
+  chain(*hyperbase, 5);
+  auto view = std::make_shared<DatalogView>(*hyperbase, parse(kAncestors));
+  hyperbase->AddCommitObserver(view);
+  std::string error;
+  ASSERT_TRUE(view->Refresh(error)) << error;
+  EXPECT_EQ(view->FactCount("ancestor"), 10u);
+
+  hyperbase->ApplyBatch({edge(Mutation::MUT_REMOVE_PARENT, "a2", "a1")});
+  hyperbase->ApplyBatch({edge(Mutation::MUT_ADD_CONCEPT, "b", "a4")});
+  EXPECT_EQ(view->PendingCommits(), 2u);
+  ASSERT_TRUE(view->Refresh(error)) << error;
+  EXPECT_EQ(view->PendingCommits(), 0u);
+  EXPECT_EQ(view->Version(), hyperbase->Version());
+  EXPECT_EQ(facts(*view, "ancestor"),
+            evaluated(*hyperbase, kAncestors, "ancestor"));
+  hyperbase->RemoveCommitObserver(view);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
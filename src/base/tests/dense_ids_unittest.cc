@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/core/dense_ids.h"
+#include "base/core/hyperbase.h"
+#include "base/query/batch_query.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation create(const std::string& name, std::vector<std::string> parents = {},
+                const std::string& category = "") {
+  Mutation mut;
+  mut.subject = name;
+  mut.objects = std::move(parents);
+  mut.category = category;
+  return mut;
+}
+
+uint32_t id_of(const Hyperbase& hyperbase, const std::string& name) {
+  ConceptPtr cnpt;
+  EXPECT_TRUE(hyperbase.GetConcept(name, cnpt)) << name;
+  return cnpt ? cnpt->DenseId() : DenseIds::kNone;
+}
+
+TEST(DenseIdsTest, ReusesFreedIdsUpToTheLimit) {
+  Concept a("a"), b("b"), c("c");
+  DenseIds ids(DenseIds::allocator_type(), 3);
+  EXPECT_EQ(ids.Allocate(&a), 0u);
+  EXPECT_EQ(ids.Allocate(&b), 1u);
+  EXPECT_EQ(ids.Allocate(&c), 2u);
+  EXPECT_EQ(ids.Allocate(&a), DenseIds::kNone);
+  EXPECT_EQ(ids.Size(), 3u);
+
+  ids.Release(1);
+  ids.Release(1);
+  EXPECT_EQ(ids.Find(1), nullptr);
+  EXPECT_EQ(ids.Size(), 2u);
+  EXPECT_EQ(ids.Allocate(&c), 1u);
+  EXPECT_EQ(ids.Find(1), &c);
+  EXPECT_EQ(ids.Find(7), nullptr);
+}
+
+TEST(DenseIdsTest, RecyclesIdsOfDetachedElements) {
+  uint32_t id;
+  {
+    Concept detached("detached");
+    id = detached.DenseId();
+  }
+  Concept next("next");
+  EXPECT_EQ(next.DenseId(), id);
+}
+
+TEST(DenseIdsTest, NumbersDetachedElementsOnFirstUse) {
+  Concept first("first");
+  Concept second("second");
+  uint32_t id = second.DenseId();
+  EXPECT_NE(first.DenseId(), id);
+  EXPECT_EQ(second.DenseId(), id);
+}
+
+TEST(DenseIdsTest, NumbersEachHyperbaseOnItsOwn) {
+  Hyperbase first("first");
+  Hyperbase second("second");
+  first.ApplyBatch({create("animal"), create("bird", {"animal"}, "zoo")});
+  second.ApplyBatch({create("rock")});
+
+  EXPECT_EQ(id_of(first, "animal"), 0u);
+  EXPECT_EQ(id_of(first, "bird"), 1u);
+  EXPECT_EQ(id_of(second, "rock"), 0u);
+}
+
+TEST(DenseIdsTest, KeepsTheIdsOfAHyperbaseDense) {
+  Hyperbase hyperbase("dense");
+  std::vector<Mutation> batch;
+  for (int i = 0; i < 5; ++i) batch.push_back(create(std::to_string(i)));
+  BatchResult result = hyperbase.ApplyBatch(batch);
+  EXPECT_EQ(result.failed, 0u);
+  std::vector<uint32_t> ids;
+  for (int i = 0; i < 5; ++i) {
+    ids.push_back(id_of(hyperbase, std::to_string(i)));
+  }
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(ids, (std::vector<uint32_t>{0, 1, 2, 3, 4}));
+}
+
+TEST(DenseIdsTest, NamesCommonChildrenFromTheirIds) {
+  Hyperbase hyperbase("types");
+  std::vector<Mutation> batch = {create("person"), create("musician")};
+  for (int i = 0; i < 100; ++i) {
+    std::string name = "p" + std::to_string(i);
+    if (i % 10 == 0) {
+      batch.push_back(create(name, {"person", "musician"}));
+    } else {
+      batch.push_back(create(name, {"person"}));
+    }
+  }
+  hyperbase.ApplyBatch(batch);
+
+  std::vector<std::string> out;
+  common::ProfileNode profile;
+  EXPECT_EQ(common_children(hyperbase, {"person", "musician"}, out, &profile),
+            10u);
+  std::sort(out.begin(), out.end());
+  EXPECT_EQ(out.front(), "p0");
+  EXPECT_EQ(out.back(), "p90");
+  EXPECT_EQ(common_children(hyperbase, {"person", "nobody"}, out), 0u);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
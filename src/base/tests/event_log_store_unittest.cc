@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/storage/event_log_store.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+EventRecord event(int64_t start, int64_t end, uint32_t type = 0) {
+  EventRecord record;
+  record.start = start;
+  record.end = end;
+  record.type = type;
+  return record;
+}
+
+std::vector<EventView> all(const EventLogStore& store) {
+  std::vector<EventView> out;
+  std::string error;
+  EXPECT_TRUE(store.Overlapping(std::numeric_limits<int64_t>::min(),
+                                std::numeric_limits<int64_t>::max(), out,
+                                error))
+      << error;
+  return out;
+}
+
+bool ordered(const std::vector<EventView>& views) {
+  return std::is_sorted(views.begin(), views.end(),
+                        [](const EventView& a, const EventView& b) {
+                          return a.record.start != b.record.start
+                                     ? a.record.start < b.record.start
+                                     : a.id < b.id;
+                        });
+}
+
+TEST(EventLogStoreTest, AppendsConcurrentlyAcrossSegments) {
+  EventLogOptions options;
+  options.segment_records = 64;
+  EventLogStore store(options);
+  constexpr int kThreads = 4;
+  constexpr int kEvents = 1000;
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&store, t] {
+      for (int i = 0; i < kEvents; ++i) {
+        store.Append(event(i * 10, i * 10 + 5, static_cast<uint32_t>(t)));
+      }
+    });
+  }
+  for (auto& producer : producers) producer.join();
+
+  std::vector<EventView> views = all(store);
+  ASSERT_EQ(views.size(), static_cast<size_t>(kThreads * kEvents));
+  EXPECT_TRUE(ordered(views));
+  std::set<uint64_t> ids;
+  for (const auto& view : views) ids.insert(view.id);
+  EXPECT_EQ(ids.size(), views.size());
+  EventLogStats stats = store.Stats();
+  EXPECT_EQ(stats.events, views.size());
+  EXPECT_GE(stats.sealed_segments, views.size() / 64 - kThreads);
+}
+
+TEST(EventLogStoreTest, SealingKeepsEventsAndIds) {
+  EventLogStore store;
+  for (int i = 0; i < 100; ++i) {
+    // Out of order, with a few events still going on.
+    int64_t start = (i * 37) % 100;
+    store.Append(event(start, i % 10 == 0 ? Event::kOpenEnd : start + 3));
+  }
+  std::vector<EventView> before = all(store);
+  store.Flush();
+  EventLogStats stats = store.Stats();
+  EXPECT_EQ(stats.sealed_segments, 1u);
+  EXPECT_GT(stats.blocks, 0u);
+  EXPECT_LT(stats.packed_bytes, 100 * sizeof(EventRecord));
+
+  std::vector<EventView> after = all(store);
+  ASSERT_EQ(after.size(), before.size());
+  EXPECT_TRUE(ordered(after));
+  for (size_t i = 0; i < after.size(); ++i) {
+    EXPECT_EQ(after[i].id, before[i].id);
+    EXPECT_EQ(after[i].record.end, before[i].record.end);
+  }
+
+  // Open events overlap every later range.
+  std::vector<EventView> late;
+  std::string error;
+  ASSERT_TRUE(store.Overlapping(1000, 2000, late, error)) << error;
+  EXPECT_EQ(late.size(), 10u);
+  std::vector<EventView> limited;
+  ASSERT_TRUE(store.Overlapping(0, 10, limited, error, 3)) << error;
+  EXPECT_EQ(limited.size(), 3u);
+}
+
+TEST(EventLogStoreTest, SpillsColdPartitionsAndReadsThemBack) {
+  auto dir = std::filesystem::temp_directory_path() / "hyperon_event_spill";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  EventLogOptions options;
+  options.segment_records = 256;
+  options.partition_millis = 1000;
+  options.hot_millis = 2000;
+  options.directory = dir.string();
+  {
+    EventLogStore store(options);
+    for (int64_t t = 0; t < 20000; t += 10) store.Append(event(t, t + 1));
+    store.Flush();
+    EventLogStats stats = store.Stats();
+    EXPECT_GT(stats.spilled_blocks, 0u);
+    EXPECT_GT(stats.spilled_bytes, 0u);
+    EXPECT_FALSE(std::filesystem::is_empty(dir));
+
+    std::vector<EventView> cold;
+    std::string error;
+    ASSERT_TRUE(store.Overlapping(1000, 1999, cold, error)) << error;
+    ASSERT_EQ(cold.size(), 100u);
+    EXPECT_EQ(cold.front().record.start, 1000);
+    EXPECT_EQ(cold.back().record.start, 1990);
+    EXPECT_EQ(all(store).size(), 2000u);
+
+    // A lost partition file fails the queries reaching into it rather
+    // than leaving its events out.
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+      std::filesystem::resize_file(entry.path(), 0);
+    }
+    std::vector<EventView> lost = {cold.front()};
+    EXPECT_FALSE(store.Overlapping(1000, 1999, lost, error));
+    EXPECT_NE(error.find("cannot read"), std::string::npos) << error;
+    EXPECT_EQ(lost.size(), 1u);
+    std::vector<EventView> hot;
+    EXPECT_TRUE(store.Overlapping(19000, 19999, hot, error)) << error;
+    EXPECT_EQ(hot.size(), 100u);
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST(EventLogStoreTest, MaterializesEvents) {
+  Hyperbase hyperbase("episodes");
+  Mutation eat;
+  eat.subject = "eat";
+  Mutation alice;
+  alice.subject = "alice";
+  alice.concept_kind = Mutation::KIND_ENTITY;
+  hyperbase.ApplyBatch({eat, alice});
+
+  EventLogStore store;
+  EventRecord record = event(5, 9, store.Intern("eat"));
+  record.agent = store.Intern("alice");
+  record.location = store.Intern("nowhere");
+  EXPECT_EQ(store.Intern("eat"), record.type);
+  EXPECT_EQ(store.Name(record.agent), "alice");
+  EXPECT_EQ(store.Name(0), "");
+  uint64_t id = store.Append(record);
+
+  std::string name;
+  std::string error;
+  ASSERT_TRUE(store.Materialize({id, record}, hyperbase, name, error))
+      << error;
+  EXPECT_EQ(name, "eat#" + std::to_string(id));
+  ConceptPtr cnpt;
+  ASSERT_TRUE(hyperbase.GetConcept(name, cnpt));
+  auto materialized = std::dynamic_pointer_cast<Event>(cnpt);
+  ASSERT_TRUE(materialized);
+  EXPECT_EQ(materialized->Start(), 5);
+  EXPECT_EQ(materialized->End(), 9);
+  EXPECT_TRUE(materialized->HasEntityOrRelation("alice"));
+  EXPECT_TRUE(cnpt->HasParent("eat"));
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
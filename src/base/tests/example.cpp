@@ -1,12 +1,42 @@
-#include "hyperkdb/core/hyperon.h"
-#include <vector>
+#include <fmt/core.h>
+
 #include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/batch_query.h"
 
+using namespace hyperon::base;
+
+// Build a tiny hyperbase through mutations and walk its lineage.
 int main() {
-    hyperkdb_core();
-    
-    std::vector<std::string> vec;
-    vec.push_back("test_package");
+  Hyperbase hb("example", "hyperon");
+
+  std::vector<Mutation> batch(4);
+  batch[0].subject = "animal";
+  batch[1].subject = "bird";
+  batch[1].objects = {"animal"};
+  batch[2].subject = "penguin";
+  batch[2].objects = {"bird"};
+  batch[3].concept_kind = Mutation::KIND_ENTITY;
+  batch[3].subject = "Tweety";
+  batch[3].objects = {"bird"};
+  BatchResult result = hb.ApplyBatch(batch);
+  fmt::print("applied {} failed {} version {}\n", result.applied,
+             result.failed, result.version);
+
+  std::vector<std::vector<std::string>> ancestors;
+  walk_lineage(hb, {"Tweety", "penguin"}, LineageCursor::ANCESTORS, 0,
+               ancestors);
+  for (const auto& names : ancestors) {
+    fmt::print("ancestors:");
+    for (const auto& name : names) fmt::print(" {}", name);
+    fmt::print("\n");
+  }
 
-    hyperkdb_core_print_vector(vec);
+  HyperbaseStatistics stats = hb.Statistics();
+  fmt::print("concepts {} entities {} lineage edges {}\n",
+             stats.totals.concepts, stats.totals.entities,
+             stats.lineage_edges);
+  return result.failed == 0 ? 0 : 1;
 }
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+using common::MEM_CATEGORY_MAPS;
+using common::MEM_CONCEPTS;
+using common::MEM_KIND_COUNT;
+using common::MEM_LINEAGE;
+using common::MEM_MEMBERS;
+using common::MEMORY_KIND;
+
+Mutation add(const std::string& cnpt, Mutation::CONCEPT_KIND kind,
+             const std::string& category = "",
+             std::vector<std::string> parents = {}) {
+  Mutation mut;
+  mut.concept_kind = kind;
+  mut.category = category;
+  mut.subject = cnpt;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+Mutation edit(Mutation::MUTATION_KIND kind, const std::string& subject,
+              std::vector<std::string> objects) {
+  Mutation mut;
+  mut.kind = kind;
+  mut.subject = subject;
+  mut.objects = std::move(objects);
+  return mut;
+}
+
+// Breakdown bytes by category and kind.
+std::map<std::pair<std::string, MEMORY_KIND>, uint64_t> breakdown(
+    const Hyperbase& hyperbase) {
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  std::map<std::pair<std::string, MEMORY_KIND>, uint64_t> bytes;
+  for (const auto& entry : hyperbase.MemoryBreakdown()) {
+    EXPECT_GT(entry.bytes, 0u);
+    bytes[{entry.category, entry.kind}] += entry.bytes;
+  }
+  return bytes;
+}
+
+// "people" with a person and 20 entities, "links" with the relation knows.
+class HyperbaseMemoryTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::vector<Mutation> batch = {
+        add("person", Mutation::KIND_CONCEPT, "people"),
+        add("knows", Mutation::KIND_RELATION, "links")};
+    for (int i = 0; i < 20; ++i) {
+      batch.push_back(add(Name(i), Mutation::KIND_ENTITY, "people",
+                          {"person"}));
+    }
+    ASSERT_EQ(mHyperbase.ApplyBatch(batch).failed, 0u);
+  }
+
+  static std::string Name(int i) { return "p" + std::to_string(i); }
+
+  Hyperbase mHyperbase{"memory"};
+};
+
+TEST_F(HyperbaseMemoryTest, BreaksFootprintDownByCategoryAndKind) {
+  auto bytes = breakdown(mHyperbase);
+  EXPECT_GT((bytes[{"people", MEM_CONCEPTS}]),
+            (bytes[{"links", MEM_CONCEPTS}]));
+  EXPECT_GT((bytes[{"links", MEM_CONCEPTS}]), 0u);
+  EXPECT_GT((bytes[{"people", MEM_LINEAGE}]), 0u);
+  EXPECT_GT((bytes[{"people", MEM_CATEGORY_MAPS}]), 0u);
+  EXPECT_EQ(bytes.count({"links", MEM_MEMBERS}), 0u);
+
+  // Categories charge through to the hyperbase, kind by kind.
+  std::vector<uint64_t> totals(MEM_KIND_COUNT, 0);
+  for (const auto& kv : bytes) totals[kv.first.second] += kv.second;
+  uint64_t total = 0;
+  for (uint32_t k = 0; k < MEM_KIND_COUNT; ++k) {
+    EXPECT_EQ(totals[k], mHyperbase.MemoryUsage(static_cast<MEMORY_KIND>(k)))
+        << common::memory_kind_name(static_cast<MEMORY_KIND>(k));
+    total += totals[k];
+  }
+  EXPECT_EQ(total, mHyperbase.MemoryUsage());
+}
+
+TEST_F(HyperbaseMemoryTest, ReleasesBytesOfShrinkingMutations) {
+  uint64_t lineage = mHyperbase.MemoryUsage(MEM_LINEAGE);
+  std::vector<std::string> everyone;
+  for (int i = 0; i < 20; ++i) everyone.push_back(Name(i));
+  ASSERT_EQ(mHyperbase
+                .ApplyBatch({edit(Mutation::MUT_ADD_MEMBER, "knows", everyone)})
+                .failed,
+            0u);
+  uint64_t members = mHyperbase.MemoryUsage(MEM_MEMBERS);
+  EXPECT_GT(members, 0u);
+  EXPECT_GT((breakdown(mHyperbase)[{"links", MEM_MEMBERS}]), 0u);
+
+  ASSERT_EQ(mHyperbase
+                .ApplyBatch({edit(Mutation::MUT_ERASE_MEMBER, "knows",
+                                  everyone)})
+                .failed,
+            0u);
+  EXPECT_LT(mHyperbase.MemoryUsage(MEM_MEMBERS), members);
+
+  std::vector<Mutation> orphans;
+  for (int i = 0; i < 20; ++i) {
+    orphans.push_back(
+        edit(Mutation::MUT_REMOVE_PARENT, Name(i), {"person"}));
+  }
+  ASSERT_EQ(mHyperbase.ApplyBatch(orphans).failed, 0u);
+  EXPECT_LT(mHyperbase.MemoryUsage(MEM_LINEAGE), lineage);
+}
+
+TEST_F(HyperbaseMemoryTest, RejectsOnlyGrowingMutationsOverQuota) {
+  EXPECT_FALSE(mHyperbase.OverQuota());
+  std::vector<std::string> some = {Name(0), Name(1), Name(2)};
+  ASSERT_EQ(
+      mHyperbase.ApplyBatch({edit(Mutation::MUT_ADD_MEMBER, "knows", some)})
+          .failed,
+      0u);
+
+  // Just below the current footprint.
+  mHyperbase.SetMemoryQuota(mHyperbase.MemoryUsage() - 1);
+  EXPECT_TRUE(mHyperbase.OverQuota());
+  uint64_t usage = mHyperbase.MemoryUsage();
+  BatchResult result = mHyperbase.ApplyBatch(
+      {add("late", Mutation::KIND_ENTITY, "people", {"person"}),
+       edit(Mutation::MUT_ADD_PARENT, Name(3), {"knows"}),
+       edit(Mutation::MUT_ADD_MEMBER, "knows", {Name(4)})});
+  EXPECT_EQ(result.failed, 3u);
+  EXPECT_EQ(mHyperbase.MemoryUsage(), usage);
+
+  // Shrinking ones still go through, until the footprint fits again.
+  result = mHyperbase.ApplyBatch(
+      {edit(Mutation::MUT_ERASE_MEMBER, "knows", some),
+       edit(Mutation::MUT_REMOVE_PARENT, Name(5), {"person"})});
+  EXPECT_EQ(result.failed, 0u);
+  EXPECT_FALSE(mHyperbase.OverQuota());
+  EXPECT_EQ(mHyperbase
+                .ApplyBatch({add("late", Mutation::KIND_ENTITY, "people")})
+                .failed,
+            0u);
+
+  mHyperbase.SetMemoryQuota(0);
+  EXPECT_EQ(mHyperbase.MemoryQuota(), 0u);
+  EXPECT_FALSE(mHyperbase.OverQuota());
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
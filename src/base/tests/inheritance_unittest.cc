@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/query/inheritance.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation isa(const std::string& cnpt, std::vector<std::string> parents,
+             Mutation::MUTATION_KIND kind = Mutation::MUT_ADD_CONCEPT) {
+  Mutation mut;
+  mut.kind = kind;
+  mut.subject = cnpt;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+// animal <- bird <- penguin, animal <- swimmer <- penguin, bird <- robin.
+class InheritanceTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mHyperbase->ApplyBatch({isa("animal", {}), isa("bird", {"animal"}),
+                            isa("swimmer", {"animal"}),
+                            isa("penguin", {"bird", "swimmer"}),
+                            isa("robin", {"bird"}), isa("rock", {})});
+    mHyperbase->AddCommitObserver(mResolver);
+    mResolver->DeclareRole("locomotion", "animal");
+    mResolver->SetValue("animal", "locomotion", "walking");
+    mResolver->SetValue("bird", "locomotion", "flying");
+  }
+
+  void TearDown() override { mHyperbase->RemoveCommitObserver(mResolver); }
+
+  RoleValue Resolve(const std::string& cnpt) {
+    RoleValue value;
+    EXPECT_TRUE(mResolver->Resolve(cnpt, "locomotion", value));
+    return value;
+  }
+
+  HyperbasePtr mHyperbase = std::make_shared<Hyperbase>("inheritance");
+  std::shared_ptr<InheritanceResolver> mResolver =
+      std::make_shared<InheritanceResolver>(*mHyperbase);
+};
+
+TEST_F(InheritanceTest, InheritsFromTheNearestAncestor) {
+  RoleValue robin = Resolve("robin");
+  EXPECT_TRUE(robin.applicable);
+  EXPECT_EQ(robin.value, "flying");
+  EXPECT_EQ(robin.source, "bird");
+  EXPECT_EQ(robin.distance, 1u);
+
+  EXPECT_EQ(Resolve("swimmer").value, "walking");
+  EXPECT_FALSE(Resolve("rock").applicable);
+  RoleValue missing;
+  EXPECT_FALSE(mResolver->Resolve("nothing", "locomotion", missing));
+}
+
+TEST_F(InheritanceTest, CancelsTypesAndWhatIsOnlyReachableThroughThem) {
+  EXPECT_EQ(Resolve("penguin").value, "flying");
+  mResolver->AddIsNotA("penguin", "bird");
+  RoleValue penguin = Resolve("penguin");
+  // Still an animal through swimmer.
+  EXPECT_EQ(penguin.value, "walking");
+  EXPECT_EQ(penguin.source, "animal");
+  EXPECT_EQ(penguin.distance, 2u);
+  EXPECT_FALSE(mResolver->IsA("penguin", "bird"));
+  EXPECT_TRUE(mResolver->IsA("penguin", "animal"));
+
+  ASSERT_TRUE(mResolver->RemoveIsNotA("penguin", "bird"));
+  EXPECT_EQ(Resolve("penguin").value, "flying");
+  EXPECT_TRUE(mResolver->IsA("penguin", "bird"));
+}
+
+TEST_F(InheritanceTest, InvalidatesEntriesOnTheWalk) {
+  Resolve("robin");
+  Resolve("swimmer");
+  Resolve("robin");
+  InheritanceStats stats = mResolver->Stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 2u);
+
+  // Unrelated commits and assertions keep the entries.
+  mHyperbase->ApplyBatch({isa("stone", {"rock"})});
+  mResolver->SetValue("rock", "locomotion", "none");
+  EXPECT_EQ(mResolver->Stats().invalidated, 0u);
+
+  // An assertion on a visited concept drops the entries through it.
+  mResolver->SetValue("bird", "locomotion", "gliding");
+  EXPECT_EQ(Resolve("robin").value, "gliding");
+  EXPECT_EQ(Resolve("swimmer").value, "walking");
+  EXPECT_EQ(mResolver->Stats().invalidated, 1u);
+
+  // So does a lineage change of a visited concept.
+  mHyperbase->ApplyBatch({isa("robin", {"swimmer"}, Mutation::MUT_ADD_PARENT),
+                          isa("robin", {"bird"}, Mutation::MUT_REMOVE_PARENT)});
+  RoleValue robin = Resolve("robin");
+  EXPECT_EQ(robin.value, "walking");
+  EXPECT_EQ(robin.distance, 2u);
+  EXPECT_EQ(mResolver->Stats().invalidated, 2u);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
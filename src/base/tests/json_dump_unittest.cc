@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/storage/json_dump.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation make(Mutation::MUTATION_KIND kind, const std::string& subject,
+              std::vector<std::string> objects = {}) {
+  Mutation mut;
+  mut.kind = kind;
+  mut.subject = subject;
+  mut.objects = std::move(objects);
+  return mut;
+}
+
+// Every section, with more concepts than fit in one export chunk.
+void populate(Hyperbase& hyperbase) {
+  std::vector<Mutation> batch;
+  batch.push_back(make(Mutation::MUT_ADD_CONCEPT, "thing"));
+  for (int i = 0; i < 10000; ++i) {
+    Mutation mut = make(Mutation::MUT_ADD_CONCEPT, "c" + std::to_string(i),
+                        {i < 2 ? "thing" : "c" + std::to_string(i / 2)});
+    if (i % 3 == 0) mut.category = "third";
+    batch.push_back(std::move(mut));
+  }
+  Mutation entity = make(Mutation::MUT_ADD_CONCEPT, "alice");
+  entity.concept_kind = Mutation::KIND_ENTITY;
+  entity.category = "people";
+  batch.push_back(entity);
+  Mutation event = make(Mutation::MUT_ADD_CONCEPT, "meeting");
+  event.concept_kind = Mutation::KIND_EVENT;
+  batch.push_back(event);
+  Mutation ongoing = make(Mutation::MUT_ADD_CONCEPT, "party");
+  ongoing.concept_kind = Mutation::KIND_EVENT;
+  batch.push_back(ongoing);
+
+  batch.push_back(make(Mutation::MUT_ADD_SPLIT, "thing", {"c0", "c1"}));
+  batch.push_back(make(Mutation::MUT_ADD_UNION, "c9", {"c4", "c7"}));
+  batch.push_back(make(Mutation::MUT_ADD_MEMBER, "meeting", {"alice"}));
+  batch.push_back(make(Mutation::MUT_SET_INTERVAL, "meeting", {"10", "20"}));
+  batch.push_back(make(Mutation::MUT_SET_INTERVAL, "party", {"-5"}));
+  BatchResult result = hyperbase.ApplyBatch(batch);
+  ASSERT_EQ(result.failed, 0u);
+}
+
+std::string dump(const Hyperbase& hyperbase) {
+  std::string out;
+  std::string error;
+  common::JsonWriter writer([&out](const char* data, size_t size) {
+    out.append(data, size);
+    return true;
+  });
+  EXPECT_TRUE(write_json_dump(hyperbase, writer, error)) << error;
+  writer.Flush();
+  return out;
+}
+
+// The sections of a dump with records and names sorted, as both follow the
+// order of hash maps.
+nlohmann::json normalize(const std::string& dump) {
+  nlohmann::json doc = nlohmann::json::parse(dump);
+  doc.erase("hyperbase");
+  for (auto& section : doc) {
+    for (auto& record : section) {
+      for (auto& field : record) {
+        if (field.is_array() && !field.empty() && field[0].is_string()) {
+          std::sort(field.begin(), field.end());
+        }
+      }
+    }
+    std::sort(section.begin(), section.end(),
+              [](const nlohmann::json& a, const nlohmann::json& b) {
+                return a.dump() < b.dump();
+              });
+  }
+  return doc;
+}
+
+TEST(JsonDumpTest, RoundTripsEverySection) {
+  Hyperbase original("original", "alice");
+  populate(original);
+  std::string out = dump(original);
+  EXPECT_NE(out.find("\"unions\":[\n{\"concept\":\"c9\""),
+            std::string::npos);
+  EXPECT_NE(out.find("{\"event\":\"party\",\"times\":[-5]}"),
+            std::string::npos);
+
+  Hyperbase restored("restored");
+  std::istringstream in(out);
+  JsonImportResult result;
+  std::string error;
+  ASSERT_TRUE(read_json_dump(in, restored, result, error)) << error;
+  EXPECT_EQ(result.name, "original");
+  EXPECT_EQ(result.owner, "alice");
+  EXPECT_EQ(result.failed, 0u);
+  EXPECT_EQ(restored.ConceptCount(), original.ConceptCount());
+
+  ConceptPtr child;
+  ASSERT_TRUE(restored.GetConcept("c9", child));
+  ASSERT_EQ(child->Unions().size(), 1u);
+  EXPECT_EQ(normalize(dump(restored)), normalize(out));
+}
+
+TEST(JsonDumpTest, ReleasesTheLockBetweenChunks) {
+  Hyperbase hyperbase("chunked");
+  populate(hyperbase);
+  size_t flushes = 0;
+  std::string error;
+  // Large enough for the sink to be called at chunk boundaries only.
+  common::JsonWriter writer(
+      [&hyperbase, &flushes](const char*, size_t) {
+        std::unique_lock<std::shared_mutex> lock(hyperbase.Mutex(),
+                                                 std::try_to_lock);
+        EXPECT_TRUE(lock.owns_lock());
+        ++flushes;
+        return true;
+      },
+      64 << 20);
+  ASSERT_TRUE(write_json_dump(hyperbase, writer, error)) << error;
+  EXPECT_GT(flushes, 6u);
+}
+
+TEST(JsonDumpTest, ReportsFailingSinks) {
+  Hyperbase hyperbase("failing");
+  populate(hyperbase);
+  common::JsonWriter writer([](const char*, size_t) { return false; });
+  std::string error;
+  EXPECT_FALSE(write_json_dump(hyperbase, writer, error));
+  EXPECT_EQ(error, "failed writing JSON dump of 'failing'");
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/query/lineage_cursor.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+// Layers of `width` concepts below "top", each concept a child of every
+// concept of the layer above.
+HyperbasePtr make_lattice(int layers, int width) {
+  auto hyperbase = std::make_shared<Hyperbase>("lattice");
+  std::vector<Mutation> batch;
+  Mutation top;
+  top.subject = "top";
+  batch.push_back(top);
+  std::vector<std::string> above = {"top"};
+  for (int layer = 0; layer < layers; ++layer) {
+    std::vector<std::string> names;
+    for (int i = 0; i < width; ++i) {
+      Mutation mut;
+      mut.subject = "l" + std::to_string(layer) + "." + std::to_string(i);
+      mut.objects = above;
+      names.push_back(mut.subject);
+      batch.push_back(std::move(mut));
+    }
+    above = std::move(names);
+  }
+  hyperbase->ApplyBatch(batch);
+  return hyperbase;
+}
+
+std::vector<std::string> drain(LineageCursor& cursor,
+                               const Hyperbase& hyperbase, size_t chunk) {
+  std::vector<std::string> out;
+  while (!cursor.Exhausted()) cursor.Next(hyperbase, chunk, out);
+  return out;
+}
+
+TEST(LineageCursorTest, ProducesSharedDescendantsOnce) {
+  HyperbasePtr hyperbase = make_lattice(4, 3);
+  LineageCursor cursor("top", LineageCursor::DESCENDANTS);
+  std::vector<std::string> out = drain(cursor, *hyperbase, 5);
+  std::set<std::string> names(out.begin(), out.end());
+  EXPECT_EQ(out.size(), 12u);
+  EXPECT_EQ(names.size(), 12u);
+  EXPECT_EQ(cursor.Produced(), 12u);
+  EXPECT_FALSE(cursor.Overflowed());
+}
+
+TEST(LineageCursorTest, WalksAncestors) {
+  HyperbasePtr hyperbase = make_lattice(3, 2);
+  LineageCursor cursor("l2.0", LineageCursor::ANCESTORS);
+  std::vector<std::string> out = drain(cursor, *hyperbase, 1);
+  std::set<std::string> names(out.begin(), out.end());
+  EXPECT_EQ(names, (std::set<std::string>{"l1.0", "l1.1", "l0.0", "l0.1",
+                                          "top"}));
+  EXPECT_EQ(out.size(), names.size());
+}
+
+TEST(LineageCursorTest, TreesNeedNoVisitedSet) {
+  auto hyperbase = std::make_shared<Hyperbase>("tree");
+  std::vector<Mutation> batch;
+  for (int i = 0; i < 1000; ++i) {
+    Mutation mut;
+    mut.subject = "n" + std::to_string(i);
+    if (i > 0) mut.objects = {"n" + std::to_string((i - 1) / 4)};
+    batch.push_back(std::move(mut));
+  }
+  hyperbase->ApplyBatch(batch);
+  // Only the origin is recorded, so a bound of one is enough.
+  LineageCursor cursor("n0", LineageCursor::DESCENDANTS, 1);
+  EXPECT_EQ(drain(cursor, *hyperbase, 64).size(), 999u);
+  EXPECT_FALSE(cursor.Overflowed());
+}
+
+TEST(LineageCursorTest, OverflowsPastMaxVisited) {
+  HyperbasePtr hyperbase = make_lattice(4, 3);
+  LineageCursor cursor("top", LineageCursor::DESCENDANTS, 4);
+  drain(cursor, *hyperbase, 100);
+  EXPECT_TRUE(cursor.Overflowed());
+  EXPECT_TRUE(cursor.Exhausted());
+  EXPECT_LT(cursor.Produced(), 12u);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/storage/mutation_log.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation create(const std::string& name, std::vector<std::string> parents) {
+  Mutation mut;
+  mut.subject = name;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+class MutationLogTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    mPath = std::filesystem::temp_directory_path() /
+            (std::string("hyperon_wal_") + info->name());
+    std::filesystem::remove(mPath);
+  }
+
+  void TearDown() override { std::filesystem::remove(mPath); }
+
+  // A leader logging to the file, with `count` concepts in as many commits.
+  HyperbasePtr Leader(int count) {
+    auto leader = std::make_shared<Hyperbase>("leader");
+    auto log = std::make_shared<MutationLog>(16, mPath.string());
+    leader->AddCommitObserver(log);
+    for (int i = 0; i < count; ++i) {
+      std::vector<std::string> parents;
+      if (i > 0) parents.push_back("c" + std::to_string(i - 1));
+      // Failed mutations are not logged.
+      leader->ApplyBatch({create("c" + std::to_string(i), parents),
+                          create("c0", {})});
+    }
+    EXPECT_EQ(log->LastError(), "");
+    leader->RemoveCommitObserver(log);
+    return leader;
+  }
+
+  std::filesystem::path mPath;
+};
+
+TEST(HyperbaseTest, RejectsStaleReplicatedBatches) {
+  Hyperbase replica("replica");
+  BatchResult result = replica.ApplyReplicatedBatch({create("a", {})}, 5);
+  EXPECT_EQ(result.applied, 1u);
+  EXPECT_EQ(replica.Version(), 5u);
+
+  for (uint64_t version : {5, 3}) {
+    result = replica.ApplyReplicatedBatch({create("b", {})}, version);
+    EXPECT_EQ(result.applied, 0u);
+    EXPECT_EQ(result.failed, 1u);
+    EXPECT_EQ(result.version, 5u);
+  }
+  EXPECT_FALSE(replica.HasConcept("b"));
+}
+
+TEST_F(MutationLogTest, ReplaysTheWriteAheadFile) {
+  HyperbasePtr leader = Leader(10);
+  Hyperbase restored("restored");
+  std::string error;
+  ASSERT_TRUE(MutationLog::Replay(mPath.string(), restored, error)) << error;
+  EXPECT_EQ(restored.Version(), leader->Version());
+  EXPECT_EQ(restored.ConceptCount(), 10u);
+
+  // Entries at or below the version of a snapshot are skipped.
+  ASSERT_TRUE(MutationLog::Replay(mPath.string(), restored, error)) << error;
+  EXPECT_EQ(restored.Version(), leader->Version());
+}
+
+TEST_F(MutationLogTest, CutsOffATornEntry) {
+  HyperbasePtr leader = Leader(3);
+  uint64_t size = std::filesystem::file_size(mPath);
+  // A crash in the middle of the next append.
+  std::ofstream(mPath, std::ios::app) << "@99\t0\t2\n0\t0\t\tc9\n0\t0\t";
+
+  Hyperbase restored("restored");
+  std::string error;
+  ASSERT_TRUE(MutationLog::Replay(mPath.string(), restored, error)) << error;
+  EXPECT_EQ(restored.Version(), leader->Version());
+  EXPECT_FALSE(restored.HasConcept("c9"));
+  EXPECT_EQ(std::filesystem::file_size(mPath), size);
+}
+
+TEST_F(MutationLogTest, RejectsMalformedFiles) {
+  std::ofstream(mPath) << "@1\t0\t1\nnot a mutation\n";
+  Hyperbase restored("restored");
+  std::string error;
+  EXPECT_FALSE(MutationLog::Replay(mPath.string(), restored, error));
+  EXPECT_NE(error.find(":2: malformed mutation"), std::string::npos);
+}
+
+TEST(MutationLogWindowTest, DropsEntriesPastRetention) {
+  auto log = std::make_shared<MutationLog>(2);
+  Hyperbase leader("leader");
+  leader.AddCommitObserver(log);
+  for (int i = 0; i < 4; ++i) {
+    leader.ApplyBatch({create("c" + std::to_string(i), {})});
+  }
+  std::vector<LogEntry> entries;
+  EXPECT_FALSE(log->ReadAfter(1, 10, 0, entries));
+  ASSERT_TRUE(log->ReadAfter(2, 10, 0, entries));
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].version, 3u);
+  EXPECT_EQ(entries[1].mutations[0].subject, "c3");
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
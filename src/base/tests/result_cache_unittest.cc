@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/query/result_cache.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation edge(Mutation::MUTATION_KIND kind, const std::string& child,
+              std::vector<std::string> parents) {
+  Mutation mut;
+  mut.kind = kind;
+  mut.subject = child;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+// animal <- bird <- robin, and a rock on its own.
+class ResultCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mHyperbase->ApplyBatch({edge(Mutation::MUT_ADD_CONCEPT, "animal", {}),
+                            edge(Mutation::MUT_ADD_CONCEPT, "bird", {"animal"}),
+                            edge(Mutation::MUT_ADD_CONCEPT, "robin", {"bird"}),
+                            edge(Mutation::MUT_ADD_CONCEPT, "rock", {})});
+    mHyperbase->AddCommitObserver(mCache);
+  }
+
+  void TearDown() override { mHyperbase->RemoveCommitObserver(mCache); }
+
+  HyperbasePtr mHyperbase = std::make_shared<Hyperbase>("cache");
+  std::shared_ptr<QueryResultCache> mCache =
+      std::make_shared<QueryResultCache>(*mHyperbase);
+};
+
+TEST_F(ResultCacheTest, ProbesTheCachedAncestorSet) {
+  EXPECT_TRUE(mCache->IsA("robin", "animal"));
+  EXPECT_TRUE(mCache->IsA("robin", "bird"));
+  EXPECT_TRUE(mCache->IsA("robin", "robin"));
+  EXPECT_FALSE(mCache->IsA("robin", "rock"));
+  EXPECT_FALSE(mCache->IsA("nothing", "animal"));
+  ResultCacheStats stats = mCache->Stats();
+  EXPECT_EQ(stats.misses, 2u);
+  EXPECT_EQ(stats.hits, 2u);
+
+  CachedResultPtr ancestors =
+      mCache->Lineage("robin", LineageCursor::ANCESTORS);
+  EXPECT_EQ(ancestors->index.size(), 2u);
+  EXPECT_TRUE(
+      mCache->Lineage("animal", LineageCursor::DESCENDANTS)->index.empty());
+}
+
+TEST_F(ResultCacheTest, DropsEntriesOnTheChangedLineage) {
+  EXPECT_FALSE(mCache->IsA("robin", "rock"));
+  mCache->Lineage("rock", LineageCursor::DESCENDANTS);
+
+  // Unrelated concepts keep the entries.
+  mHyperbase->ApplyBatch({edge(Mutation::MUT_ADD_CONCEPT, "stone", {})});
+  EXPECT_FALSE(mCache->IsA("robin", "rock"));
+  EXPECT_EQ(mCache->Stats().invalidated, 0u);
+
+  mHyperbase->ApplyBatch({edge(Mutation::MUT_ADD_PARENT, "bird", {"rock"})});
+  EXPECT_TRUE(mCache->IsA("robin", "rock"));
+  EXPECT_EQ(mCache->Stats().invalidated, 1u);
+  EXPECT_EQ(
+      mCache->CachedLineage("rock", LineageCursor::DESCENDANTS, 0, 10),
+      nullptr);
+  EXPECT_EQ(mCache->Stats().invalidated, 2u);
+}
+
+TEST_F(ResultCacheTest, FindsOnlyCachedResultsWithinTheRowLimit) {
+  EXPECT_EQ(mCache->CachedLineage("animal", LineageCursor::DESCENDANTS, 0, 10),
+            nullptr);
+  mCache->Lineage("animal", LineageCursor::DESCENDANTS);
+  EXPECT_EQ(mCache->CachedLineage("animal", LineageCursor::DESCENDANTS, 0, 1),
+            nullptr);
+  CachedResultPtr cached =
+      mCache->CachedLineage("animal", LineageCursor::DESCENDANTS, 0, 2);
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(cached->rows.size(), 2u);
+  ResultCacheStats stats = mCache->Stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 1u);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
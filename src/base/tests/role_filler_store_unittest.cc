@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/storage/role_filler_store.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation isa(const std::string& cnpt, std::vector<std::string> parents,
+             Mutation::CONCEPT_KIND kind = Mutation::KIND_CONCEPT) {
+  Mutation mut;
+  mut.kind = Mutation::MUT_ADD_CONCEPT;
+  mut.concept_kind = kind;
+  mut.subject = cnpt;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+std::vector<std::string> sorted(std::vector<std::string> names) {
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// animal <- bird <- {robin, penguin}, animal <- fish <- trout, rock, and the
+// roles limb <- wing.
+class RoleFillerStoreTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mHyperbase->ApplyBatch(
+        {isa("animal", {}), isa("bird", {"animal"}), isa("robin", {"bird"}),
+         isa("penguin", {"bird"}), isa("fish", {"animal"}),
+         isa("trout", {"fish"}), isa("rock", {}),
+         isa("limb", {}, Mutation::KIND_ROLE),
+         isa("wing", {"limb"}, Mutation::KIND_ROLE)});
+    mStore.Add("animal", "limb", "leg");
+    mStore.Add("bird", "wing", "left wing");
+    mStore.Add("bird", "wing", "right wing");
+    mStore.Add("penguin", "limb", "flipper");
+  }
+
+  std::vector<std::string> Fillers(const std::string& owner,
+                                   const std::string& role, bool inherit) {
+    std::vector<std::string> out;
+    size_t count = mStore.Fillers(owner, role, inherit, out);
+    EXPECT_EQ(count, out.size());
+    return out;
+  }
+
+  std::vector<std::string> Owners(const std::string& filler,
+                                  const std::string& role, bool inherit) {
+    std::vector<std::string> out;
+    size_t count = mStore.Owners(filler, role, inherit, out);
+    EXPECT_EQ(count, out.size());
+    return sorted(out);
+  }
+
+  HyperbasePtr mHyperbase = std::make_shared<Hyperbase>("roles");
+  RoleFillerStore mStore{*mHyperbase};
+};
+
+TEST_F(RoleFillerStoreTest, LooksUpBothDirections) {
+  EXPECT_EQ(Fillers("bird", "wing", false),
+            (std::vector<std::string>{"left wing", "right wing"}));
+  EXPECT_TRUE(Fillers("bird", "limb", false).empty());
+  EXPECT_TRUE(Fillers("nobody", "wing", false).empty());
+  EXPECT_EQ(Owners("left wing", "wing", false),
+            (std::vector<std::string>{"bird"}));
+  EXPECT_TRUE(Owners("left wing", "limb", false).empty());
+  EXPECT_TRUE(Owners("nothing", "wing", false).empty());
+
+  mStore.DeclareRole("wing", "bird");
+  std::string owner;
+  ASSERT_TRUE(mStore.DeclaredOwner("wing", owner));
+  EXPECT_EQ(owner, "bird");
+  EXPECT_FALSE(mStore.DeclaredOwner("limb", owner));
+}
+
+TEST_F(RoleFillerStoreTest, InheritsFillersOfTheNearestAncestors) {
+  // Subroles count as the asked role.
+  EXPECT_EQ(Fillers("bird", "limb", true),
+            (std::vector<std::string>{"left wing", "right wing"}));
+  // robin has none and takes those of bird, not those of animal too.
+  EXPECT_EQ(Fillers("robin", "limb", true),
+            (std::vector<std::string>{"left wing", "right wing"}));
+  EXPECT_EQ(Fillers("penguin", "limb", true),
+            (std::vector<std::string>{"flipper"}));
+  EXPECT_EQ(Fillers("trout", "limb", true),
+            (std::vector<std::string>{"leg"}));
+  EXPECT_TRUE(Fillers("trout", "limb", false).empty());
+  EXPECT_TRUE(Fillers("rock", "limb", true).empty());
+  // Roles above the asked one do not count.
+  EXPECT_TRUE(Fillers("animal", "wing", true).empty());
+}
+
+TEST_F(RoleFillerStoreTest, InheritsOwnersDownToConceptsWithOwnFillers) {
+  // bird and its subtree have limbs of their own.
+  EXPECT_EQ(Owners("leg", "limb", true),
+            (std::vector<std::string>{"animal", "fish", "trout"}));
+  EXPECT_EQ(Owners("leg", "limb", false),
+            (std::vector<std::string>{"animal"}));
+  // penguin has its own flipper.
+  EXPECT_EQ(Owners("left wing", "limb", true),
+            (std::vector<std::string>{"bird", "robin"}));
+  EXPECT_TRUE(Owners("leg", "wing", true).empty());
+
+  ASSERT_TRUE(mStore.Erase("penguin", "limb", "flipper"));
+  EXPECT_FALSE(mStore.Erase("penguin", "limb", "flipper"));
+  EXPECT_EQ(Owners("left wing", "limb", true),
+            (std::vector<std::string>{"bird", "penguin", "robin"}));
+}
+
+TEST_F(RoleFillerStoreTest, ProfilesInheritingLookups) {
+  common::ProfileNode profile;
+  std::vector<std::string> out;
+  mStore.Fillers("robin", "limb", true, out, &profile);
+  EXPECT_EQ(profile.op, "role_fillers");
+  EXPECT_EQ(profile.rows_out, 2u);
+  // robin, then bird.
+  EXPECT_EQ(profile.Child("forward_lists").loops, 2u);
+  EXPECT_EQ(profile.Child("role_set").rows_out, 2u);
+}
+
+TEST_F(RoleFillerStoreTest, MergesOutOfOrderStatements) {
+  RoleFillerStats before = mStore.Stats();
+  EXPECT_EQ(before.statements, 4u);
+  // leg and flipper are interned before the fillers of trout.
+  mStore.Add("trout", "limb", "fin");
+  mStore.Add("trout", "limb", "leg");
+  mStore.Add("trout", "limb", "flipper");
+  mStore.Add("trout", "limb", "leg");
+  mStore.Add("bird", "wing", "left wing");
+
+  std::vector<std::string> out;
+  EXPECT_EQ(mStore.Fillers("trout", "limb", false, out), 3u);
+  EXPECT_EQ(out, (std::vector<std::string>{"leg", "flipper", "fin"}));
+  EXPECT_EQ(Owners("leg", "limb", false),
+            (std::vector<std::string>{"animal", "trout"}));
+  RoleFillerStats after = mStore.Stats();
+  EXPECT_EQ(after.statements, 7u);
+  EXPECT_EQ(after.forward_keys, before.forward_keys + 1);
+
+  // Erasing merges buffered statements first.
+  mStore.Add("fish", "limb", "flipper");
+  mStore.Add("fish", "limb", "leg");
+  EXPECT_TRUE(mStore.Erase("fish", "limb", "leg"));
+  EXPECT_EQ(Fillers("fish", "limb", false),
+            (std::vector<std::string>{"flipper"}));
+  EXPECT_EQ(mStore.Stats().statements, 8u);
+}
+
+TEST_F(RoleFillerStoreTest, SketchesFillersPerRole) {
+  EXPECT_EQ(mStore.EstimateRoleFillers("wing"), 2u);
+  EXPECT_EQ(mStore.EstimateRoleFillers("limb"), 2u);
+  EXPECT_EQ(mStore.EstimateRoleFillers("tail"), 0u);
+  // Buffered statements count once merged, duplicates not at all.
+  mStore.Add("trout", "limb", "fin");
+  mStore.Add("trout", "limb", "leg");
+  mStore.Add("trout", "limb", "leg");
+  EXPECT_EQ(mStore.EstimateRoleFillers("limb"), 4u);
+  ASSERT_TRUE(mStore.Erase("animal", "limb", "leg"));
+  EXPECT_EQ(mStore.EstimateRoleFillers("limb"), 3u);
+  EXPECT_EQ(mStore.Stats().distinct_fillers, 5u);
+}
+
+TEST(RoleFillerStoreRandomTest, MatchesAMapOfSets) {
+  Hyperbase hyperbase("roles");
+  RoleFillerStore store(hyperbase);
+  std::map<std::string, std::set<std::string>> fillers, owners;
+  std::mt19937 rng(5);
+  uint64_t statements = 0;
+  for (int i = 0; i < 3000; ++i) {
+    std::string owner = "o" + std::to_string(rng() % 40);
+    std::string filler = "f" + std::to_string(rng() % 60);
+    store.Add(owner, "r", filler);
+    statements += fillers[owner].insert(filler).second;
+    owners[filler].insert(owner);
+  }
+  EXPECT_EQ(store.Stats().statements, statements);
+  for (const auto& kv : fillers) {
+    std::vector<std::string> out;
+    store.Fillers(kv.first, "r", false, out);
+    ASSERT_EQ(sorted(out),
+              std::vector<std::string>(kv.second.begin(), kv.second.end()));
+  }
+  for (const auto& kv : owners) {
+    std::vector<std::string> out;
+    store.Owners(kv.first, "r", false, out);
+    ASSERT_EQ(sorted(out),
+              std::vector<std::string>(kv.second.begin(), kv.second.end()));
+  }
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/core/entity.h"
+#include "base/core/hyperbase.h"
+#include "base/core/relation.h"
+#include "base/core/role.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation add(const std::string& cnpt, Mutation::CONCEPT_KIND kind,
+             const std::string& category = "",
+             std::vector<std::string> parents = {}) {
+  Mutation mut;
+  mut.concept_kind = kind;
+  mut.category = category;
+  mut.subject = cnpt;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+Mutation members(const std::string& relation,
+                 std::vector<std::string> names,
+                 Mutation::MUTATION_KIND kind = Mutation::MUT_ADD_MEMBER) {
+  Mutation mut;
+  mut.kind = kind;
+  mut.subject = relation;
+  mut.objects = std::move(names);
+  return mut;
+}
+
+TEST(CategoryStatisticsTest, RollsUpThroughEnclosedCategories) {
+  auto outer = std::make_shared<Category>("outer", nullptr);
+  auto inner = std::make_shared<Category>("inner", nullptr);
+  inner->AddConcept(std::make_shared<Entity>("ann"));
+  inner->AddConcept(std::make_shared<Relation>("knows"));
+  outer->AddConcept(std::make_shared<Concept>("person"));
+
+  ASSERT_TRUE(outer->AddEnclosedCategory(inner));
+  const CategoryStatistics& total = outer->TotalStatistics();
+  EXPECT_EQ(total.categories, 1u);
+  EXPECT_EQ(total.concepts, 3u);
+  EXPECT_EQ(total.entities, 1u);
+  EXPECT_EQ(total.relations, 1u);
+  EXPECT_EQ(outer->LocalStatistics().concepts, 1u);
+  EXPECT_EQ(outer->LocalStatistics().categories, 1u);
+
+  // Changes below an enclosed category reach every superior.
+  auto innermost = std::make_shared<Category>("innermost", nullptr);
+  ASSERT_TRUE(inner->AddEnclosedCategory(innermost));
+  innermost->AddConcept(std::make_shared<Role>("friend"));
+  innermost->AddConcept(std::make_shared<Entity>("bob"));
+  EXPECT_EQ(total.categories, 2u);
+  EXPECT_EQ(total.concepts, 5u);
+  EXPECT_EQ(total.entities, 2u);
+  EXPECT_EQ(total.roles, 1u);
+  EXPECT_EQ(inner->TotalStatistics().concepts, 4u);
+
+  ASSERT_TRUE(innermost->RemoveConcept("bob"));
+  EXPECT_FALSE(innermost->RemoveConcept("bob"));
+  EXPECT_EQ(total.concepts, 4u);
+  EXPECT_EQ(total.entities, 1u);
+  EXPECT_EQ(innermost->LocalStatistics().entities, 0u);
+}
+
+TEST(HyperbaseStatisticsTest, FollowsMutationsWithoutScanning) {
+  Hyperbase hyperbase("statistics");
+  BatchResult result = hyperbase.ApplyBatch(
+      {add("person", Mutation::KIND_CONCEPT, "people"),
+       add("ann", Mutation::KIND_ENTITY, "people", {"person"}),
+       add("bob", Mutation::KIND_ENTITY, "people", {"person"}),
+       add("eve", Mutation::KIND_ENTITY, "people", {"person"}),
+       add("knows", Mutation::KIND_RELATION, "links"),
+       add("likes", Mutation::KIND_RELATION, "links"),
+       members("knows", {"ann", "bob", "eve"}), members("likes", {"ann"})});
+  ASSERT_EQ(result.failed, 0u);
+
+  HyperbaseStatistics stats = hyperbase.Statistics();
+  EXPECT_EQ(stats.totals.categories, 2u);
+  EXPECT_EQ(stats.totals.entities, 3u);
+  EXPECT_EQ(stats.totals.relations, 2u);
+  EXPECT_EQ(stats.lineage_edges, 3u);
+  EXPECT_EQ(stats.relation_members, 4u);
+  EXPECT_EQ(stats.distinct_members, 3u);
+
+  {
+    std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+    EXPECT_GE(hyperbase.EstimateRelationFanout("knows"), 3u);
+    EXPECT_GE(hyperbase.EstimateRelationFanout("likes"), 1u);
+    EXPECT_DOUBLE_EQ(hyperbase.AverageRelationFanout(), 2.0);
+  }
+
+  hyperbase.ApplyBatch(
+      {members("knows", {"bob", "eve"}, Mutation::MUT_ERASE_MEMBER)});
+  stats = hyperbase.Statistics();
+  EXPECT_EQ(stats.relation_members, 2u);
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  EXPECT_GE(hyperbase.EstimateRelationFanout("knows"), 1u);
+  EXPECT_DOUBLE_EQ(hyperbase.AverageRelationFanout(), 1.0);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
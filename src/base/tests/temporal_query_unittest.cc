@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/event.h"
+#include "base/query/temporal_query.h"
+
+namespace hyperon {
+namespace base {
+namespace {
+
+Mutation event(const std::string& name) {
+  Mutation mut;
+  mut.kind = Mutation::MUT_ADD_CONCEPT;
+  mut.concept_kind = Mutation::KIND_EVENT;
+  mut.subject = name;
+  return mut;
+}
+
+Mutation interval(const std::string& name, int64_t start,
+                  const std::string& end = "") {
+  Mutation mut;
+  mut.kind = Mutation::MUT_SET_INTERVAL;
+  mut.subject = name;
+  mut.objects = {std::to_string(start), end};
+  return mut;
+}
+
+using Names = std::vector<std::string>;
+
+// breakfast [8, 9], meeting [10, 12], lunch [12, 13], workday [8, 17] and
+// the open-ended project from 11 on; "idea" has no interval.
+class TemporalQueryTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    BatchResult result = mHyperbase.ApplyBatch(
+        {event("breakfast"), event("meeting"), event("lunch"),
+         event("workday"), event("project"), event("idea"),
+         interval("meeting", 10, "12"), interval("breakfast", 8, "9"),
+         interval("lunch", 12, "13"), interval("workday", 8, "17"),
+         interval("project", 11)});
+    ASSERT_EQ(result.failed, 0u);
+  }
+
+  Names Find(TEMPORAL_RELATION relation, int64_t start, int64_t end,
+             size_t limit = 0) {
+    std::vector<TimedEvent> found;
+    size_t count =
+        find_events(mHyperbase, relation, start, end, found, limit);
+    EXPECT_EQ(count, found.size());
+    Names names;
+    for (const auto& one : found) names.push_back(one.name);
+    return names;
+  }
+
+  Hyperbase mHyperbase{"temporal"};
+};
+
+TEST_F(TemporalQueryTest, AnswersEveryRelation) {
+  // Start order, ties by insertion.
+  EXPECT_EQ(Find(TEMPORAL_OVERLAPS, 12, 12),
+            (Names{"workday", "meeting", "project", "lunch"}));
+  EXPECT_EQ(Find(TEMPORAL_OVERLAPS, 18, 100), (Names{"project"}));
+  EXPECT_EQ(Find(TEMPORAL_DURING, 8, 12),
+            (Names{"breakfast", "meeting"}));
+  EXPECT_EQ(Find(TEMPORAL_DURING, 9, 11), Names{});
+  EXPECT_EQ(Find(TEMPORAL_CONTAINS, 12, 13),
+            (Names{"workday", "project", "lunch"}));
+  EXPECT_EQ(Find(TEMPORAL_CONTAINS, 8, 18), Names{});
+  EXPECT_EQ(Find(TEMPORAL_BEFORE, 12, 12), (Names{"breakfast"}));
+  EXPECT_EQ(Find(TEMPORAL_BEFORE, 13, 20), (Names{"breakfast", "meeting"}));
+  EXPECT_EQ(Find(TEMPORAL_AFTER, 0, 11), (Names{"lunch"}));
+  EXPECT_EQ(Find(TEMPORAL_AFTER, 0, 7),
+            (Names{"breakfast", "workday", "meeting", "project", "lunch"}));
+  // The window end does not matter.
+  EXPECT_EQ(Find(TEMPORAL_AS_OF, 9, 0),
+            (Names{"breakfast", "workday"}));
+  EXPECT_EQ(Find(TEMPORAL_AS_OF, 1000, 0), (Names{"project"}));
+}
+
+TEST_F(TemporalQueryTest, RejectsEmptyWindows) {
+  EXPECT_EQ(Find(TEMPORAL_OVERLAPS, 12, 11), Names{});
+  EXPECT_EQ(Find(TEMPORAL_DURING, 12, 11), Names{});
+  EXPECT_EQ(Find(TEMPORAL_CONTAINS, 12, 11), Names{});
+  // Nothing ends before the smallest point or starts after the largest.
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  EXPECT_EQ(Find(TEMPORAL_BEFORE, kMin, 0), Names{});
+  EXPECT_EQ(Find(TEMPORAL_AFTER, 0, kMax), Names{});
+}
+
+TEST_F(TemporalQueryTest, StopsAtTheLimit) {
+  EXPECT_EQ(Find(TEMPORAL_OVERLAPS, 12, 12, 2),
+            (Names{"workday", "meeting"}));
+  // Appends after what the vector holds.
+  std::vector<TimedEvent> found(1);
+  EXPECT_EQ(find_events(mHyperbase, TEMPORAL_OVERLAPS, 0, 100, found, 3),
+            3u);
+  EXPECT_EQ(found.size(), 4u);
+  EXPECT_EQ(found[1].name, "breakfast");
+  EXPECT_EQ(found[1].start, 8);
+  EXPECT_EQ(found[1].end, 9);
+}
+
+TEST_F(TemporalQueryTest, FollowsRetimedEvents) {
+  BatchResult result = mHyperbase.ApplyBatch(
+      {interval("meeting", 14, "15"),
+       // Unchanged, before its start, not an event, no such concept.
+       interval("lunch", 12, "13"), interval("breakfast", 9, "8"),
+       interval("idea", 1, "x"), interval("nobody", 1, "2")});
+  EXPECT_EQ(result.failed, 4u);
+  EXPECT_EQ(Find(TEMPORAL_OVERLAPS, 10, 11),
+            (Names{"workday", "project"}));
+  EXPECT_EQ(Find(TEMPORAL_DURING, 14, 15), (Names{"meeting"}));
+  EXPECT_EQ(mHyperbase.Events().Size(), 5u);
+
+  std::vector<TimedEvent> found;
+  find_events(mHyperbase, TEMPORAL_AS_OF, 20, 20, found);
+  ASSERT_EQ(found.size(), 1u);
+  EXPECT_EQ(found[0].end, Event::kOpenEnd);
+}
+
+TEST_F(TemporalQueryTest, ProfilesTheScan) {
+  common::ProfileNode profile;
+  std::vector<TimedEvent> found;
+  find_events(mHyperbase, TEMPORAL_DURING, 8, 12, found, 0, &profile);
+  EXPECT_EQ(profile.op, "find_events");
+  EXPECT_EQ(profile.detail, "during [8, 12]");
+  EXPECT_EQ(profile.rows_in, 5u);
+  EXPECT_EQ(profile.rows_out, 2u);
+  const common::ProfileNode& scan = profile.Child("interval_scan");
+  EXPECT_EQ(scan.index, "interval_tree");
+  EXPECT_EQ(scan.rows_out, 2u);
+  EXPECT_GE(scan.rows_in, 2u);
+}
+
+// Relations by their definition, for the comparison below.
+bool relates(TEMPORAL_RELATION relation, const TimedEvent& event,
+             int64_t start, int64_t end) {
+  switch (relation) {
+    case TEMPORAL_OVERLAPS:
+      return event.start <= end && event.end >= start;
+    case TEMPORAL_DURING:
+      return event.start >= start && event.end <= end;
+    case TEMPORAL_CONTAINS:
+      return event.start <= start && event.end >= end;
+    case TEMPORAL_BEFORE:
+      return event.end < start;
+    case TEMPORAL_AFTER:
+      return event.start > end;
+    case TEMPORAL_AS_OF:
+      return event.start <= start && event.end >= start;
+  }
+  return false;
+}
+
+TEST(TemporalQueryRandomTest, MatchesTheDefinitions) {
+  Hyperbase hyperbase("temporal");
+  std::mt19937 rng(13);
+  std::vector<Mutation> batch;
+  std::vector<TimedEvent> events;
+  for (int i = 0; i < 500; ++i) {
+    std::string name = "e" + std::to_string(i);
+    batch.push_back(event(name));
+    int64_t start = rng() % 2000;
+    int64_t end = start + rng() % 100;
+    bool open = rng() % 20 == 0;
+    batch.push_back(interval(name, start, open ? "" : std::to_string(end)));
+    events.push_back({name, start, open ? Event::kOpenEnd : end});
+  }
+  ASSERT_EQ(hyperbase.ApplyBatch(batch).failed, 0u);
+
+  for (int q = 0; q < 300; ++q) {
+    auto relation = static_cast<TEMPORAL_RELATION>(q % 6);
+    int64_t start = static_cast<int64_t>(rng() % 2200) - 100;
+    int64_t end = start + rng() % 200;
+    Names expected;
+    for (const auto& one : events) {
+      if (relates(relation, one, start, end)) expected.push_back(one.name);
+    }
+    std::vector<TimedEvent> found;
+    find_events(hyperbase, relation, start, end, found);
+    Names names;
+    for (size_t i = 0; i < found.size(); ++i) {
+      names.push_back(found[i].name);
+      if (i > 0) ASSERT_LE(found[i - 1].start, found[i].start);
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(names.begin(), names.end());
+    ASSERT_EQ(names, expected) << temporal_relation_name(relation) << " ["
+                               << start << ", " << end << "]";
+  }
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace hyperon
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief A fixed set of threads running posted closures in FIFO order.
+ *
+ * Asynchronous APIs run their blocking parts here and complete their tasks
+ * from these threads, so that callers chaining continuations never block a
+ * thread of their own. Closures must not wait for other closures of the
+ * same executor, which may never get a thread.
+ */
+class Executor {
+public:
+  // Use all cores if 0.
+  explicit Executor(size_t threads = 0) {
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    mThreads.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+      mThreads.emplace_back(&Executor::Run, this);
+    }
+  }
+
+  // Runs the closures already posted, then joins.
+  ~Executor() {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStopping = true;
+    }
+    mWake.notify_all();
+    for (auto& thread : mThreads) thread.join();
+  }
+
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  // Shared by the asynchronous APIs unless given another one. Never
+  // destroyed, so that closures may still be posted at exit.
+  static Executor& Default() {
+    static Executor* instance = new Executor();
+    return *instance;
+  }
+
+  void Post(std::function<void()> fn) {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mQueue.push_back(std::move(fn));
+    }
+    mWake.notify_one();
+  }
+
+  inline size_t Threads() const { return mThreads.size(); }
+
+private:
+  void Run() {
+    while (true) {
+      std::function<void()> fn;
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWake.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+        if (mQueue.empty()) return;
+        fn = std::move(mQueue.front());
+        mQueue.pop_front();
+      }
+      fn();
+    }
+  }
+
+  std::mutex mMutex;
+  std::condition_variable mWake;
+  std::deque<std::function<void()>> mQueue;
+  bool mStopping{false};
+  std::vector<std::thread> mThreads;
+};
+
+}  // namespace common
+}  // namespace hyperon
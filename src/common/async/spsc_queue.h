@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace hyperon {
+namespace common {
+
+// Bytes of a cache line, to keep data written by different cores apart.
+constexpr size_t kCacheLine = 64;
+
+/**
+ * @brief Bounded lock-free queue between exactly one producer thread and
+ * one consumer thread.
+ *
+ * The producer owns the tail and the consumer the head, each on its own
+ * cache line along with its cached copy of the other index, so that a
+ * push or pop only reads the other side's line when the cached copy says
+ * the queue is full or empty.
+ */
+template <typename T>
+class SpscQueue {
+public:
+  // Capacity is rounded up to a power of two.
+  explicit SpscQueue(size_t capacity) {
+    size_t slots = 2;
+    while (slots < capacity) slots <<= 1;
+    mSlots.resize(slots);
+    mMask = slots - 1;
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer side. Leaves `value` untouched and returns false if full.
+  bool TryPush(T& value) {
+    size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mCachedHead == mSlots.size()) {
+      mCachedHead = mHead.load(std::memory_order_acquire);
+      if (tail - mCachedHead == mSlots.size()) return false;
+    }
+    mSlots[tail & mMask] = std::move(value);
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if empty.
+  bool TryPop(T& value) {
+    size_t head = mHead.load(std::memory_order_relaxed);
+    if (head == mCachedTail) {
+      mCachedTail = mTail.load(std::memory_order_acquire);
+      if (head == mCachedTail) return false;
+    }
+    value = std::move(mSlots[head & mMask]);
+    mSlots[head & mMask] = T();
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Exact on the consumer side, a hint elsewhere.
+  inline bool Empty() const {
+    return mHead.load(std::memory_order_acquire) ==
+           mTail.load(std::memory_order_acquire);
+  }
+
+  inline size_t Capacity() const { return mSlots.size(); }
+
+private:
+  alignas(kCacheLine) std::atomic<size_t> mHead{0};
+  size_t mCachedTail{0};
+  alignas(kCacheLine) std::atomic<size_t> mTail{0};
+  size_t mCachedHead{0};
+  alignas(kCacheLine) std::vector<T> mSlots;
+  size_t mMask{0};
+};
+
+}  // namespace common
+}  // namespace hyperon
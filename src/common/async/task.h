@@ -0,0 +1,159 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "common/async/executor.h"
+
+namespace hyperon {
+namespace common {
+
+template <typename T>
+class Promise;
+
+/**
+ * @brief Result of an asynchronous operation, available once its Promise
+ * is set.
+ *
+ * A caller either chains a continuation with Then(), which runs on the
+ * thread completing the task, or right away if it is complete already, or
+ * blocks in Get(). Continuations should be short or post their work to an
+ * executor. Failures are part of `T`, in the manner of the bool and error
+ * message pairs of the synchronous APIs.
+ */
+template <typename T>
+class Task {
+public:
+  Task() = default;
+
+  inline bool Valid() const { return mState != nullptr; }
+
+  bool Ready() const {
+    std::lock_guard<std::mutex> lock(mState->mutex);
+    return mState->ready;
+  }
+
+  // Wait for the result. Must not be called from a thread the task needs.
+  const T& Get() const {
+    std::unique_lock<std::mutex> lock(mState->mutex);
+    mState->done.wait(lock, [this] { return mState->ready; });
+    return mState->value;
+  }
+
+  // Run `fn(const T&)` once the result is set. One continuation per task.
+  void Then(std::function<void(const T&)> fn) const {
+    std::unique_lock<std::mutex> lock(mState->mutex);
+    if (!mState->ready) {
+      mState->next = std::move(fn);
+      return;
+    }
+    lock.unlock();
+    fn(mState->value);
+  }
+
+private:
+  friend class Promise<T>;
+
+  struct State {
+    std::mutex mutex;
+    std::condition_variable done;
+    bool ready{false};
+    T value{};
+    std::function<void(const T&)> next;
+  };
+
+  explicit Task(std::shared_ptr<State> state) : mState(std::move(state)) {}
+
+  std::shared_ptr<State> mState;
+};
+
+/**
+ * @brief Producer side of a Task, set exactly once.
+ */
+template <typename T>
+class Promise {
+public:
+  Promise() : mState(std::make_shared<typename Task<T>::State>()) {}
+
+  inline Task<T> GetTask() const { return Task<T>(mState); }
+
+  void Set(T value) const {
+    std::function<void(const T&)> next;
+    {
+      std::lock_guard<std::mutex> lock(mState->mutex);
+      mState->value = std::move(value);
+      mState->ready = true;
+      next = std::move(mState->next);
+    }
+    mState->done.notify_all();
+    if (next) next(mState->value);
+  }
+
+private:
+  std::shared_ptr<typename Task<T>::State> mState;
+};
+
+/**
+ * @brief Run `fn()` on `executor` and complete the returned task with its
+ * result.
+ */
+template <typename Fn, typename T = std::invoke_result_t<Fn>>
+Task<T> run_async(Executor& executor, Fn fn) {
+  Promise<T> promise;
+  Task<T> task = promise.GetTask();
+  executor.Post([promise, fn = std::move(fn)]() mutable {
+    promise.Set(fn());
+  });
+  return task;
+}
+
+/**
+ * @brief Run `fn(lock)` on `executor` holding `mutex` shared, and complete
+ * the returned task with its result once the lock is released.
+ *
+ * While a writer holds `mutex` the closure is posted again rather than
+ * waiting, so that readers never park a thread of the executor behind a
+ * write. `fn` may release the lock early.
+ */
+template <typename Fn,
+          typename T = std::invoke_result_t<
+              Fn&, std::shared_lock<std::shared_mutex>&>>
+Task<T> run_shared_async(Executor& executor, std::shared_mutex& mutex,
+                         Fn fn) {
+  struct Attempt {
+    Executor& executor;
+    std::shared_mutex& mutex;
+    Promise<T> promise;
+    Fn fn;
+
+    static void Post(std::shared_ptr<Attempt> attempt) {
+      Executor& executor = attempt->executor;
+      executor.Post([attempt = std::move(attempt)]() mutable {
+        std::shared_lock<std::shared_mutex> lock(attempt->mutex,
+                                                 std::try_to_lock);
+        if (!lock.owns_lock()) {
+          std::this_thread::yield();
+          Post(std::move(attempt));
+          return;
+        }
+        T value = attempt->fn(lock);
+        if (lock.owns_lock()) lock.unlock();
+        attempt->promise.Set(std::move(value));
+      });
+    }
+  };
+  auto attempt = std::make_shared<Attempt>(
+      Attempt{executor, mutex, Promise<T>(), std::move(fn)});
+  Task<T> task = attempt->promise.GetTask();
+  Attempt::Post(std::move(attempt));
+  return task;
+}
+
+}  // namespace common
+}  // namespace hyperon
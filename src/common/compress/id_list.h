@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Sorted set of 32-bit ids stored as varint-encoded gaps, typically
+ * one or two bytes per id for clustered ids. Appending an id above the
+ * largest one is O(1); other inserts and erases re-encode the list, which
+ * is meant for short lists or rare updates. Batches of out-of-order ids
+ * should be collected and merged at once.
+ */
+class IdList {
+public:
+  inline uint32_t Size() const { return mCount; }
+  inline bool Empty() const { return mCount == 0; }
+  inline size_t Bytes() const { return mBytes.size(); }
+  // Largest id, undefined if empty.
+  inline uint32_t Back() const { return mLast; }
+
+  // @return false if the id was present.
+  bool Insert(uint32_t id) {
+    if (mCount == 0 || id > mLast) {
+      Append(id);
+      return true;
+    }
+    std::vector<uint32_t> ids;
+    Decode(ids);
+    auto at = std::lower_bound(ids.begin(), ids.end(), id);
+    if (at != ids.end() && *at == id) return false;
+    ids.insert(at, id);
+    Assign(ids);
+    return true;
+  }
+
+  // @return false if the id was absent.
+  bool Erase(uint32_t id) {
+    if (mCount == 0 || id > mLast) return false;
+    std::vector<uint32_t> ids;
+    Decode(ids);
+    auto at = std::lower_bound(ids.begin(), ids.end(), id);
+    if (at == ids.end() || *at != id) return false;
+    ids.erase(at);
+    Assign(ids);
+    return true;
+  }
+
+  bool Contains(uint32_t id) const {
+    if (mCount == 0 || id > mLast) return false;
+    bool found = false;
+    ForEach([id, &found](uint32_t each) {
+      found = each == id;
+      return each < id;
+    });
+    return found;
+  }
+
+  /**
+   * @brief Visit ids in ascending order while `fn` returns true.
+   */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    uint32_t id = 0;
+    size_t pos = 0;
+    for (uint32_t i = 0; i < mCount; ++i) {
+      uint32_t gap = 0;
+      for (unsigned shift = 0;; shift += 7) {
+        uint8_t byte = mBytes[pos++];
+        gap |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) break;
+      }
+      // The first gap is the id itself.
+      id = i == 0 ? gap : id + gap;
+      if (!fn(id)) return;
+    }
+  }
+
+  void Decode(std::vector<uint32_t>& out) const {
+    out.reserve(out.size() + mCount);
+    ForEach([&out](uint32_t id) {
+      out.push_back(id);
+      return true;
+    });
+  }
+
+  /**
+   * @brief Add sorted, distinct ids, re-encoding the list at most once.
+   * @return Number of ids that were absent
+   */
+  size_t Merge(const std::vector<uint32_t>& ids) {
+    if (ids.empty()) return 0;
+    if (mCount == 0 || ids.front() > mLast) {
+      for (uint32_t id : ids) Append(id);
+      return ids.size();
+    }
+    std::vector<uint32_t> merged;
+    merged.reserve(mCount + ids.size());
+    size_t added = 0;
+    auto next = ids.begin();
+    ForEach([&](uint32_t id) {
+      for (; next != ids.end() && *next < id; ++next, ++added) {
+        merged.push_back(*next);
+      }
+      if (next != ids.end() && *next == id) ++next;
+      merged.push_back(id);
+      return true;
+    });
+    added += ids.end() - next;
+    merged.insert(merged.end(), next, ids.end());
+    if (added > 0) Assign(merged);
+    return added;
+  }
+
+  // Replace the contents by sorted, distinct ids.
+  void Assign(const std::vector<uint32_t>& ids) {
+    Clear();
+    for (uint32_t id : ids) Append(id);
+  }
+
+  void Clear() {
+    mBytes.clear();
+    mCount = 0;
+    mLast = 0;
+  }
+
+private:
+  void Append(uint32_t id) {
+    uint32_t gap = mCount == 0 ? id : id - mLast;
+    while (gap >= 0x80) {
+      mBytes.push_back(static_cast<uint8_t>(gap | 0x80));
+      gap >>= 7;
+    }
+    mBytes.push_back(static_cast<uint8_t>(gap));
+    mLast = id;
+    ++mCount;
+  }
+
+  std::vector<uint8_t> mBytes;
+  uint32_t mCount{0};
+  uint32_t mLast{0};
+};
+
+}  // namespace common
+}  // namespace hyperon
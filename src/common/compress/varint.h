@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace hyperon {
+namespace common {
+
+// Signed to unsigned so that small magnitudes encode short.
+inline uint64_t zigzag_encode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Append `value` in LEB128, 7 bits per byte.
+inline void put_varint(std::string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Read a varint at `pos` and advance past it.
+ * @return false if the input ends inside the varint.
+ */
+inline bool get_varint(const std::string& in, size_t& pos, uint64_t& value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(in[pos++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/sketch/mix.h"
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Closed intervals [start, end] with values, in a treap ordered by
+ * start and augmented with the smallest and largest end of every subtree.
+ *
+ * All queries are one primitive: the intervals whose start and end both
+ * fall in given ranges, reported in start order. Subtrees are skipped by
+ * the start range and by their end bounds, so a query costs O(log n) plus
+ * the paths to its k results, i.e. O(log n + k) when ends grow with starts
+ * as in append-only event streams, and O(log n + k log(n / k)) at worst.
+ * Insert and erase are O(log n) expected, appending in start order is as
+ * cheap as any other insert.
+ *
+ * Nodes live in one vector and link by index, handles stay valid until
+ * the interval is erased.
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class IntervalTree {
+public:
+  using Handle = uint32_t;
+  using allocator_type = Allocator;
+  static constexpr Handle kNone = std::numeric_limits<Handle>::max();
+  static constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  static constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+
+  IntervalTree() = default;
+  explicit IntervalTree(const Allocator& allocator)
+      : mNodes(NodeAllocator(allocator)), mFree(HandleAllocator(allocator)) {}
+
+  inline size_t Size() const { return mSize; }
+  inline bool Empty() const { return mSize == 0; }
+
+  inline int64_t Start(Handle handle) const { return mNodes[handle].start; }
+  inline int64_t End(Handle handle) const { return mNodes[handle].end; }
+  inline const T& Value(Handle handle) const { return mNodes[handle].value; }
+
+  // @return Handle of the new interval, start must not be above end.
+  Handle Insert(int64_t start, int64_t end, T value) {
+    Handle handle;
+    if (!mFree.empty()) {
+      handle = mFree.back();
+      mFree.pop_back();
+    } else {
+      handle = static_cast<Handle>(mNodes.size());
+      mNodes.emplace_back();
+    }
+    Node& node = mNodes[handle];
+    node.start = start;
+    node.end = end;
+    node.min_end = end;
+    node.max_end = end;
+    node.priority = static_cast<uint32_t>(mix64(handle));
+    node.left = kNone;
+    node.right = kNone;
+    node.value = std::move(value);
+    mRoot = InsertAt(mRoot, handle);
+    ++mSize;
+    return handle;
+  }
+
+  void Erase(Handle handle) {
+    mRoot = EraseAt(mRoot, handle);
+    mNodes[handle].value = T();
+    mFree.push_back(handle);
+    --mSize;
+  }
+
+  void Clear() {
+    mNodes.clear();
+    mFree.clear();
+    mRoot = kNone;
+    mSize = 0;
+  }
+
+  /**
+   * @brief Visit, in start order, every interval with start in
+   * [start_lo, start_hi] and end in [end_lo, end_hi].
+   *
+   * @param fn Called as fn(handle), returns false to stop
+   * @return Number of nodes examined, for profiles
+   */
+  template <typename Fn>
+  size_t Visit(int64_t start_lo, int64_t start_hi, int64_t end_lo,
+               int64_t end_hi, Fn&& fn) const {
+    Range range{start_lo, start_hi, end_lo, end_hi};
+    size_t examined = 0;
+    VisitAt(mRoot, range, fn, examined);
+    return examined;
+  }
+
+  // Intervals sharing a point with [start, end].
+  template <typename Fn>
+  size_t Overlapping(int64_t start, int64_t end, Fn&& fn) const {
+    return Visit(kMin, end, start, kMax, fn);
+  }
+
+  // Intervals inside [start, end].
+  template <typename Fn>
+  size_t Within(int64_t start, int64_t end, Fn&& fn) const {
+    return Visit(start, end, kMin, end, fn);
+  }
+
+  // Intervals covering [start, end].
+  template <typename Fn>
+  size_t Containing(int64_t start, int64_t end, Fn&& fn) const {
+    return Visit(kMin, start, end, kMax, fn);
+  }
+
+private:
+  struct Node {
+    int64_t start{0};
+    int64_t end{0};
+    int64_t min_end{0};
+    int64_t max_end{0};
+    uint32_t priority{0};
+    Handle left{kNone};
+    Handle right{kNone};
+    T value{};
+  };
+
+  struct Range {
+    int64_t start_lo;
+    int64_t start_hi;
+    int64_t end_lo;
+    int64_t end_hi;
+  };
+
+  using Traits = std::allocator_traits<Allocator>;
+  using NodeAllocator = typename Traits::template rebind_alloc<Node>;
+  using HandleAllocator = typename Traits::template rebind_alloc<Handle>;
+
+  // Ordered by start, ties by handle, so that every key is unique.
+  inline bool Less(Handle a, Handle b) const {
+    const Node& x = mNodes[a];
+    const Node& y = mNodes[b];
+    return x.start < y.start || (x.start == y.start && a < b);
+  }
+
+  void Pull(Handle handle) {
+    Node& node = mNodes[handle];
+    node.min_end = node.end;
+    node.max_end = node.end;
+    for (Handle child : {node.left, node.right}) {
+      if (child == kNone) continue;
+      node.min_end = std::min(node.min_end, mNodes[child].min_end);
+      node.max_end = std::max(node.max_end, mNodes[child].max_end);
+    }
+  }
+
+  // Split `root` into the keys below `key` and the others.
+  void Split(Handle root, Handle key, Handle& left, Handle& right) {
+    if (root == kNone) {
+      left = right = kNone;
+      return;
+    }
+    if (Less(root, key)) {
+      Split(mNodes[root].right, key, mNodes[root].right, right);
+      left = root;
+    } else {
+      Split(mNodes[root].left, key, left, mNodes[root].left);
+      right = root;
+    }
+    Pull(root);
+  }
+
+  // Join two treaps, all keys of `left` below those of `right`.
+  Handle Merge(Handle left, Handle right) {
+    if (left == kNone) return right;
+    if (right == kNone) return left;
+    if (mNodes[left].priority > mNodes[right].priority) {
+      mNodes[left].right = Merge(mNodes[left].right, right);
+      Pull(left);
+      return left;
+    }
+    mNodes[right].left = Merge(left, mNodes[right].left);
+    Pull(right);
+    return right;
+  }
+
+  Handle InsertAt(Handle root, Handle handle) {
+    if (root == kNone) return handle;
+    if (mNodes[handle].priority > mNodes[root].priority) {
+      Split(root, handle, mNodes[handle].left, mNodes[handle].right);
+      Pull(handle);
+      return handle;
+    }
+    if (Less(handle, root)) {
+      mNodes[root].left = InsertAt(mNodes[root].left, handle);
+    } else {
+      mNodes[root].right = InsertAt(mNodes[root].right, handle);
+    }
+    Pull(root);
+    return root;
+  }
+
+  Handle EraseAt(Handle root, Handle handle) {
+    if (root == kNone) return kNone;
+    if (root == handle) {
+      return Merge(mNodes[root].left, mNodes[root].right);
+    }
+    if (Less(handle, root)) {
+      mNodes[root].left = EraseAt(mNodes[root].left, handle);
+    } else {
+      mNodes[root].right = EraseAt(mNodes[root].right, handle);
+    }
+    Pull(root);
+    return root;
+  }
+
+  template <typename Fn>
+  bool VisitAt(Handle root, const Range& range, Fn& fn,
+               size_t& examined) const {
+    if (root == kNone) return true;
+    const Node& node = mNodes[root];
+    ++examined;
+    if (node.max_end < range.end_lo || node.min_end > range.end_hi) {
+      return true;
+    }
+    if (node.start >= range.start_lo &&
+        !VisitAt(node.left, range, fn, examined)) {
+      return false;
+    }
+    if (node.start > range.start_hi) return true;
+    if (node.start >= range.start_lo && node.end >= range.end_lo &&
+        node.end <= range.end_hi && !fn(root)) {
+      return false;
+    }
+    return VisitAt(node.right, range, fn, examined);
+  }
+
+  std::vector<Node, NodeAllocator> mNodes;
+  std::vector<Handle, HandleAllocator> mFree;
+  Handle mRoot{kNone};
+  size_t mSize{0};
+};
+
+}  // namespace common
+}  // namespace hyperon
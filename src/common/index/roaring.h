@@ -0,0 +1,587 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Compressed set of 32-bit ids after Roaring bitmaps: ids are
+ * grouped by their upper 16 bits and every group is a sorted array of the
+ * lower bits while it holds at most 4096 ids, a 65536-bit bitmap beyond.
+ * A group thus never takes more than 8 KiB, sparse ids take two bytes and
+ * dense ones a bit.
+ *
+ * Intersections, unions and their cardinalities work a group at a time,
+ * with word-wise ANDs and ORs between bitmaps, probes of arrays into
+ * bitmaps and merges or gallops between arrays.
+ */
+template <typename Allocator = std::allocator<uint32_t>>
+class RoaringBitmap {
+  using Traits = std::allocator_traits<Allocator>;
+  using KeyAllocator = typename Traits::template rebind_alloc<uint16_t>;
+  using WordAllocator = typename Traits::template rebind_alloc<uint64_t>;
+
+public:
+  using allocator_type = Allocator;
+  // Largest group stored as an array.
+  static constexpr uint32_t kArrayMax = 4096;
+  static constexpr uint32_t kWords = 65536 / 64;
+
+  RoaringBitmap() = default;
+  explicit RoaringBitmap(const Allocator& allocator)
+      : mKeys(KeyAllocator(allocator)),
+        mGroups(GroupAllocator(allocator)),
+        mAllocator(allocator) {}
+
+  inline allocator_type get_allocator() const { return mAllocator; }
+  inline uint64_t Cardinality() const { return mCardinality; }
+  inline bool Empty() const { return mCardinality == 0; }
+
+  // @return false if the id was present.
+  bool Add(uint32_t id) {
+    uint16_t key = static_cast<uint16_t>(id >> 16);
+    size_t at = std::lower_bound(mKeys.begin(), mKeys.end(), key) -
+                mKeys.begin();
+    if (at == mKeys.size() || mKeys[at] != key) {
+      mKeys.insert(mKeys.begin() + at, key);
+      mGroups.insert(mGroups.begin() + at, Group(mAllocator));
+    }
+    if (!Insert(mGroups[at], static_cast<uint16_t>(id))) return false;
+    ++mCardinality;
+    return true;
+  }
+
+  // @return false if the id was absent.
+  bool Remove(uint32_t id) {
+    size_t at = Find(static_cast<uint16_t>(id >> 16));
+    if (at == mKeys.size()) return false;
+    Group& group = mGroups[at];
+    uint16_t low = static_cast<uint16_t>(id);
+    if (group.IsBitmap()) {
+      uint64_t bit = uint64_t{1} << (low & 63);
+      if (!(group.bits[low >> 6] & bit)) return false;
+      group.bits[low >> 6] &= ~bit;
+      if (--group.cardinality == kArrayMax) ToArray(group);
+    } else {
+      auto found = std::lower_bound(group.array.begin(), group.array.end(),
+                                    low);
+      if (found == group.array.end() || *found != low) return false;
+      group.array.erase(found);
+      --group.cardinality;
+    }
+    --mCardinality;
+    if (group.cardinality == 0) {
+      mKeys.erase(mKeys.begin() + at);
+      mGroups.erase(mGroups.begin() + at);
+    }
+    return true;
+  }
+
+  bool Contains(uint32_t id) const {
+    size_t at = Find(static_cast<uint16_t>(id >> 16));
+    return at != mKeys.size() && Has(mGroups[at], static_cast<uint16_t>(id));
+  }
+
+  void Clear() {
+    mKeys.clear();
+    mGroups.clear();
+    mCardinality = 0;
+  }
+
+  /**
+   * @brief Visit ids in ascending order while `fn` returns true.
+   */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (size_t i = 0; i < mKeys.size(); ++i) {
+      uint32_t high = static_cast<uint32_t>(mKeys[i]) << 16;
+      const Group& group = mGroups[i];
+      if (!group.IsBitmap()) {
+        for (uint16_t low : group.array) {
+          if (!fn(high | low)) return;
+        }
+        continue;
+      }
+      for (uint32_t w = 0; w < kWords; ++w) {
+        for (uint64_t word = group.bits[w]; word; word &= word - 1) {
+          uint32_t low = w * 64 + __builtin_ctzll(word);
+          if (!fn(high | low)) return;
+        }
+      }
+    }
+  }
+
+  // Number of groups stored as bitmaps rather than arrays.
+  size_t BitmapGroups() const {
+    return std::count_if(mGroups.begin(), mGroups.end(),
+                         [](const Group& group) { return group.IsBitmap(); });
+  }
+
+  // Approximate heap bytes.
+  size_t Bytes() const {
+    size_t bytes = mKeys.capacity() * sizeof(uint16_t) +
+                   mGroups.capacity() * sizeof(Group);
+    for (const Group& group : mGroups) {
+      bytes += group.array.capacity() * sizeof(uint16_t) +
+               group.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+  }
+
+  // Ids in both, charged to the allocator of `a`.
+  static RoaringBitmap And(const RoaringBitmap& a, const RoaringBitmap& b) {
+    RoaringBitmap result(a.mAllocator);
+    for (size_t i = 0, j = 0; i < a.mKeys.size() && j < b.mKeys.size();) {
+      if (a.mKeys[i] != b.mKeys[j]) {
+        a.mKeys[i] < b.mKeys[j] ? ++i : ++j;
+        continue;
+      }
+      Group group(a.mAllocator);
+      Intersect(a.mGroups[i], b.mGroups[j], group);
+      if (group.cardinality > 0) {
+        result.mCardinality += group.cardinality;
+        result.mKeys.push_back(a.mKeys[i]);
+        result.mGroups.push_back(std::move(group));
+      }
+      ++i;
+      ++j;
+    }
+    return result;
+  }
+
+  // Number of ids in both, without building the intersection.
+  static uint64_t AndCardinality(const RoaringBitmap& a,
+                                 const RoaringBitmap& b) {
+    uint64_t count = 0;
+    for (size_t i = 0, j = 0; i < a.mKeys.size() && j < b.mKeys.size();) {
+      if (a.mKeys[i] != b.mKeys[j]) {
+        a.mKeys[i] < b.mKeys[j] ? ++i : ++j;
+        continue;
+      }
+      count += IntersectCount(a.mGroups[i++], b.mGroups[j++]);
+    }
+    return count;
+  }
+
+  // Ids in either, charged to the allocator of `a`.
+  static RoaringBitmap Or(const RoaringBitmap& a, const RoaringBitmap& b) {
+    RoaringBitmap result(a.mAllocator);
+    size_t i = 0, j = 0;
+    while (i < a.mKeys.size() || j < b.mKeys.size()) {
+      bool left = j == b.mKeys.size() ||
+                  (i < a.mKeys.size() && a.mKeys[i] < b.mKeys[j]);
+      bool right = i == a.mKeys.size() ||
+                   (j < b.mKeys.size() && b.mKeys[j] < a.mKeys[i]);
+      Group group(a.mAllocator);
+      uint16_t key;
+      if (left) {
+        key = a.mKeys[i];
+        Copy(a.mGroups[i++], group);
+      } else if (right) {
+        key = b.mKeys[j];
+        Copy(b.mGroups[j++], group);
+      } else {
+        key = a.mKeys[i];
+        Unite(a.mGroups[i++], b.mGroups[j++], group);
+      }
+      result.mCardinality += group.cardinality;
+      result.mKeys.push_back(key);
+      result.mGroups.push_back(std::move(group));
+    }
+    return result;
+  }
+
+private:
+  struct Group {
+    explicit Group(const Allocator& allocator)
+        : array(KeyAllocator(allocator)), bits(WordAllocator(allocator)) {}
+
+    inline bool IsBitmap() const { return !bits.empty(); }
+
+    uint32_t cardinality{0};
+    // Sorted lower bits up to kArrayMax ids, empty as a bitmap.
+    std::vector<uint16_t, KeyAllocator> array;
+    // kWords words beyond kArrayMax ids, empty as an array.
+    std::vector<uint64_t, WordAllocator> bits;
+  };
+  using GroupAllocator = typename Traits::template rebind_alloc<Group>;
+
+  size_t Find(uint16_t key) const {
+    auto found = std::lower_bound(mKeys.begin(), mKeys.end(), key);
+    if (found == mKeys.end() || *found != key) return mKeys.size();
+    return found - mKeys.begin();
+  }
+
+  static bool Has(const Group& group, uint16_t low) {
+    if (group.IsBitmap()) return group.bits[low >> 6] >> (low & 63) & 1;
+    return std::binary_search(group.array.begin(), group.array.end(), low);
+  }
+
+  static bool Insert(Group& group, uint16_t low) {
+    if (group.IsBitmap()) {
+      uint64_t bit = uint64_t{1} << (low & 63);
+      if (group.bits[low >> 6] & bit) return false;
+      group.bits[low >> 6] |= bit;
+      ++group.cardinality;
+      return true;
+    }
+    auto at = std::lower_bound(group.array.begin(), group.array.end(), low);
+    if (at != group.array.end() && *at == low) return false;
+    if (group.cardinality == kArrayMax) {
+      ToBitmap(group);
+      return Insert(group, low);
+    }
+    group.array.insert(at, low);
+    ++group.cardinality;
+    return true;
+  }
+
+  static void ToBitmap(Group& group) {
+    group.bits.assign(kWords, 0);
+    for (uint16_t low : group.array) {
+      group.bits[low >> 6] |= uint64_t{1} << (low & 63);
+    }
+    group.array.clear();
+    group.array.shrink_to_fit();
+  }
+
+  static void ToArray(Group& group) {
+    group.array.clear();
+    group.array.reserve(group.cardinality);
+    for (uint32_t w = 0; w < kWords; ++w) {
+      for (uint64_t word = group.bits[w]; word; word &= word - 1) {
+        group.array.push_back(
+            static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+      }
+    }
+    group.bits.clear();
+    group.bits.shrink_to_fit();
+  }
+
+  static void Copy(const Group& from, Group& to) {
+    to.cardinality = from.cardinality;
+    to.array.assign(from.array.begin(), from.array.end());
+    to.bits.assign(from.bits.begin(), from.bits.end());
+  }
+
+  // Arrays gallop when one is this many times longer than the other.
+  static constexpr size_t kGallopRatio = 32;
+
+  template <typename Fn>
+  static void IntersectArrays(const Group& a, const Group& b, Fn&& fn) {
+    const auto* small = &a.array;
+    const auto* large = &b.array;
+    if (small->size() > large->size()) std::swap(small, large);
+    if (small->size() * kGallopRatio < large->size()) {
+      auto from = large->begin();
+      for (uint16_t low : *small) {
+        from = std::lower_bound(from, large->end(), low);
+        if (from == large->end()) return;
+        if (*from == low) fn(low);
+      }
+      return;
+    }
+    auto i = small->begin();
+    auto j = large->begin();
+    while (i != small->end() && j != large->end()) {
+      if (*i < *j) {
+        ++i;
+      } else if (*j < *i) {
+        ++j;
+      } else {
+        fn(*i);
+        ++i;
+        ++j;
+      }
+    }
+  }
+
+  static void Intersect(const Group& a, const Group& b, Group& out) {
+    if (a.IsBitmap() && b.IsBitmap()) {
+      out.bits.resize(kWords);
+      uint32_t count = 0;
+      for (uint32_t w = 0; w < kWords; ++w) {
+        out.bits[w] = a.bits[w] & b.bits[w];
+        count += __builtin_popcountll(out.bits[w]);
+      }
+      out.cardinality = count;
+      if (count <= kArrayMax) ToArray(out);
+      return;
+    }
+    if (a.IsBitmap() || b.IsBitmap()) {
+      const Group& array = a.IsBitmap() ? b : a;
+      const Group& bitmap = a.IsBitmap() ? a : b;
+      for (uint16_t low : array.array) {
+        if (Has(bitmap, low)) out.array.push_back(low);
+      }
+    } else {
+      IntersectArrays(a, b, [&out](uint16_t low) { out.array.push_back(low); });
+    }
+    out.cardinality = static_cast<uint32_t>(out.array.size());
+  }
+
+  static uint32_t IntersectCount(const Group& a, const Group& b) {
+    uint32_t count = 0;
+    if (a.IsBitmap() && b.IsBitmap()) {
+      for (uint32_t w = 0; w < kWords; ++w) {
+        count += __builtin_popcountll(a.bits[w] & b.bits[w]);
+      }
+    } else if (a.IsBitmap() || b.IsBitmap()) {
+      const Group& array = a.IsBitmap() ? b : a;
+      const Group& bitmap = a.IsBitmap() ? a : b;
+      for (uint16_t low : array.array) count += Has(bitmap, low);
+    } else {
+      IntersectArrays(a, b, [&count](uint16_t) { ++count; });
+    }
+    return count;
+  }
+
+  static void Unite(const Group& a, const Group& b, Group& out) {
+    if (a.IsBitmap() || b.IsBitmap()) {
+      const Group& bitmap = a.IsBitmap() ? a : b;
+      const Group& other = a.IsBitmap() ? b : a;
+      out.bits.assign(bitmap.bits.begin(), bitmap.bits.end());
+      if (other.IsBitmap()) {
+        for (uint32_t w = 0; w < kWords; ++w) out.bits[w] |= other.bits[w];
+      } else {
+        for (uint16_t low : other.array) {
+          out.bits[low >> 6] |= uint64_t{1} << (low & 63);
+        }
+      }
+      uint32_t count = 0;
+      for (uint64_t word : out.bits) count += __builtin_popcountll(word);
+      out.cardinality = count;
+      return;
+    }
+    out.array.resize(a.array.size() + b.array.size());
+    auto end = std::set_union(a.array.begin(), a.array.end(),
+                              b.array.begin(), b.array.end(),
+                              out.array.begin());
+    out.array.erase(end, out.array.end());
+    out.cardinality = static_cast<uint32_t>(out.array.size());
+    if (out.cardinality > kArrayMax) ToBitmap(out);
+  }
+
+  std::vector<uint16_t, KeyAllocator> mKeys;
+  std::vector<Group, GroupAllocator> mGroups;
+  uint64_t mCardinality{0};
+  Allocator mAllocator;
+};
+
+/**
+ * @brief Set of ids for adjacency, where most sets are tiny and a few are
+ * huge. Up to kInline ids are kept sorted in place without allocating; a
+ * set growing beyond is promoted to a RoaringBitmap, and goes back inline
+ * once it shrinks to half of that.
+ */
+template <typename Allocator = std::allocator<uint32_t>>
+class IdSet {
+public:
+  using allocator_type = Allocator;
+  using Bitmap = RoaringBitmap<Allocator>;
+  static constexpr uint32_t kInline = 8;
+
+  IdSet() = default;
+  explicit IdSet(const Allocator& allocator) : mAllocator(allocator) {}
+  IdSet(const IdSet& other) : mAllocator(other.mAllocator) { *this = other; }
+  IdSet(IdSet&& other) noexcept : mAllocator(other.mAllocator) {
+    Swap(other);
+  }
+  IdSet& operator=(const IdSet& other) {
+    if (this == &other) return *this;
+    Clear();
+    if (other.mBitmap) {
+      mBitmap = NewBitmap();
+      other.mBitmap->ForEach([this](uint32_t id) {
+        mBitmap->Add(id);
+        return true;
+      });
+    } else {
+      mSize = other.mSize;
+      std::copy(other.mInline, other.mInline + mSize, mInline);
+    }
+    return *this;
+  }
+  IdSet& operator=(IdSet&& other) noexcept {
+    Clear();
+    Swap(other);
+    return *this;
+  }
+  ~IdSet() { Clear(); }
+
+  inline allocator_type get_allocator() const { return mAllocator; }
+  inline uint64_t Size() const {
+    return mBitmap ? mBitmap->Cardinality() : mSize;
+  }
+  inline bool Empty() const { return Size() == 0; }
+  // Whether the ids live in a bitmap.
+  inline bool Promoted() const { return mBitmap != nullptr; }
+
+  // @return false if the id was present.
+  bool Insert(uint32_t id) {
+    if (mBitmap) return mBitmap->Add(id);
+    uint32_t* end = mInline + mSize;
+    uint32_t* at = std::lower_bound(mInline, end, id);
+    if (at != end && *at == id) return false;
+    if (mSize == kInline) {
+      Bitmap* bitmap = NewBitmap();
+      for (uint32_t i = 0; i < mSize; ++i) bitmap->Add(mInline[i]);
+      bitmap->Add(id);
+      mBitmap = bitmap;
+      mSize = 0;
+      return true;
+    }
+    std::copy_backward(at, end, end + 1);
+    *at = id;
+    ++mSize;
+    return true;
+  }
+
+  // @return false if the id was absent.
+  bool Erase(uint32_t id) {
+    if (mBitmap) {
+      if (!mBitmap->Remove(id)) return false;
+      if (mBitmap->Cardinality() <= kInline / 2) Demote();
+      return true;
+    }
+    uint32_t* end = mInline + mSize;
+    uint32_t* at = std::lower_bound(mInline, end, id);
+    if (at == end || *at != id) return false;
+    std::copy(at + 1, end, at);
+    --mSize;
+    return true;
+  }
+
+  bool Contains(uint32_t id) const {
+    if (mBitmap) return mBitmap->Contains(id);
+    return std::binary_search(mInline, mInline + mSize, id);
+  }
+
+  void Clear() {
+    if (mBitmap) {
+      BitmapAllocator allocator(mAllocator);
+      mBitmap->~Bitmap();
+      allocator.deallocate(mBitmap, 1);
+      mBitmap = nullptr;
+    }
+    mSize = 0;
+  }
+
+  /**
+   * @brief Visit ids in ascending order while `fn` returns true.
+   */
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    if (mBitmap) {
+      mBitmap->ForEach(std::forward<Fn>(fn));
+      return;
+    }
+    for (uint32_t i = 0; i < mSize; ++i) {
+      if (!fn(mInline[i])) return;
+    }
+  }
+
+  // Approximate heap bytes.
+  inline size_t Bytes() const {
+    return mBitmap ? sizeof(Bitmap) + mBitmap->Bytes() : 0;
+  }
+
+  // Number of ids in both sets.
+  static uint64_t IntersectionCount(const IdSet& a, const IdSet& b) {
+    if (a.mBitmap && b.mBitmap) {
+      return Bitmap::AndCardinality(*a.mBitmap, *b.mBitmap);
+    }
+    const IdSet& small = a.mBitmap ? b : a;
+    const IdSet& other = a.mBitmap ? a : b;
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < small.mSize; ++i) {
+      count += other.Contains(small.mInline[i]);
+    }
+    return count;
+  }
+
+  // Replace `out` by the ids in both sets.
+  static void Intersect(const IdSet& a, const IdSet& b, IdSet& out) {
+    if (a.mBitmap && b.mBitmap) {
+      Bitmap both = Bitmap::And(*a.mBitmap, *b.mBitmap);
+      out.Assign(std::move(both));
+      return;
+    }
+    const IdSet& small = a.mBitmap ? b : a;
+    const IdSet& other = a.mBitmap ? a : b;
+    uint32_t ids[kInline];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < small.mSize; ++i) {
+      if (other.Contains(small.mInline[i])) ids[count++] = small.mInline[i];
+    }
+    out.Clear();
+    std::copy(ids, ids + count, out.mInline);
+    out.mSize = count;
+  }
+
+  // Replace `out` by the ids in either set.
+  static void Unite(const IdSet& a, const IdSet& b, IdSet& out) {
+    if (a.mBitmap && b.mBitmap) {
+      Bitmap either = Bitmap::Or(*a.mBitmap, *b.mBitmap);
+      out.Assign(std::move(either));
+      return;
+    }
+    const IdSet& small = a.mBitmap ? b : a;
+    IdSet either = a.mBitmap ? a : b;
+    for (uint32_t i = 0; i < small.mSize; ++i) {
+      either.Insert(small.mInline[i]);
+    }
+    out = std::move(either);
+  }
+
+private:
+  using BitmapAllocator =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Bitmap>;
+
+  Bitmap* NewBitmap() {
+    BitmapAllocator allocator(mAllocator);
+    Bitmap* bitmap = allocator.allocate(1);
+    return new (bitmap) Bitmap(mAllocator);
+  }
+
+  void Demote() {
+    uint32_t ids[kInline];
+    uint32_t count = 0;
+    mBitmap->ForEach([&](uint32_t id) {
+      ids[count++] = id;
+      return true;
+    });
+    Clear();
+    std::copy(ids, ids + count, mInline);
+    mSize = count;
+  }
+
+  // Take the ids of a bitmap, going inline if few.
+  void Assign(Bitmap&& bitmap) {
+    Clear();
+    mBitmap = NewBitmap();
+    *mBitmap = std::move(bitmap);
+    if (mBitmap->Cardinality() <= kInline / 2) Demote();
+  }
+
+  void Swap(IdSet& other) noexcept {
+    std::swap(mAllocator, other.mAllocator);
+    std::swap(mSize, other.mSize);
+    std::swap(mInline, other.mInline);
+    std::swap(mBitmap, other.mBitmap);
+  }
+
+  Allocator mAllocator;
+  uint32_t mSize{0};
+  uint32_t mInline[kInline]{};
+  Bitmap* mBitmap{nullptr};
+};
+
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <functional>
+#include <streambuf>
+#include <string>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Read-only stream buffer pulling its bytes chunk by chunk, e.g. from
+ * the messages of a gRPC client stream. Lets stream parsers consume such
+ * input without assembling it first; only the current chunk is held.
+ */
+class ChunkStreambuf : public std::streambuf {
+public:
+  // Fills the next chunk, returns false at the end of the input.
+  using NextChunk = std::function<bool(std::string& chunk)>;
+
+  explicit ChunkStreambuf(NextChunk next) : mNext(std::move(next)) {}
+
+protected:
+  /* override */ int_type underflow() {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    do {
+      mChunk.clear();
+      if (!mNext(mChunk)) return traits_type::eof();
+    } while (mChunk.empty());
+    char* begin = &mChunk[0];
+    setg(begin, begin, begin + mChunk.size());
+    return traits_type::to_int_type(*gptr());
+  }
+
+private:
+  NextChunk mNext;
+  std::string mChunk;
+};
+
+}  // namespace common
+}  // namespace hyperon
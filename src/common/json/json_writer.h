@@ -0,0 +1,239 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Destination of serialized bytes, e.g. a file descriptor or a gRPC
+ * stream writer. Returns false if the bytes could not be delivered.
+ */
+using JsonSink = std::function<bool(const char* data, size_t size)>;
+
+/**
+ * @brief Sink writing to a file descriptor.
+ */
+inline JsonSink fd_sink(int fd) {
+  return [fd](const char* data, size_t size) {
+    while (size > 0) {
+      ssize_t n = ::write(fd, data, size);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      data += n;
+      size -= static_cast<size_t>(n);
+    }
+    return true;
+  };
+}
+
+/**
+ * @brief Streaming JSON writer. Values are appended to a fixed-size buffer
+ * which is handed over to the sink whenever it fills up, so serializing a
+ * document of any size takes constant memory. Commas are inserted
+ * automatically; the caller is responsible for a well-formed nesting of
+ * objects, arrays and keys.
+ */
+class JsonWriter {
+public:
+  static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+  explicit JsonWriter(JsonSink sink, size_t buffer_size = kDefaultBufferSize)
+      : mSink(std::move(sink)), mBufferSize(buffer_size) {
+    mBuffer.reserve(mBufferSize);
+  }
+
+  ~JsonWriter() { Flush(); }
+
+  JsonWriter(const JsonWriter&) = delete;
+  JsonWriter& operator=(const JsonWriter&) = delete;
+
+  JsonWriter& BeginObject() {
+    Open('{');
+    return *this;
+  }
+
+  JsonWriter& EndObject() {
+    Close('}');
+    return *this;
+  }
+
+  JsonWriter& BeginArray() {
+    Open('[');
+    return *this;
+  }
+
+  JsonWriter& EndArray() {
+    Close(']');
+    return *this;
+  }
+
+  JsonWriter& Key(const std::string& key) {
+    Separate();
+    AppendString(key);
+    Put(':');
+    mAfterKey = true;
+    return *this;
+  }
+
+  JsonWriter& String(const std::string& value) {
+    Separate();
+    AppendString(value);
+    return *this;
+  }
+
+  JsonWriter& Uint(uint64_t value) {
+    Separate();
+    Append(std::to_string(value));
+    return *this;
+  }
+
+  JsonWriter& Int(int64_t value) {
+    Separate();
+    Append(std::to_string(value));
+    return *this;
+  }
+
+  JsonWriter& Bool(bool value) {
+    Separate();
+    Append(value ? "true" : "false");
+    return *this;
+  }
+
+  JsonWriter& Null() {
+    Separate();
+    Append("null");
+    return *this;
+  }
+
+  /**
+   * @brief Start the next value, or the closing bracket, on a new line.
+   * Keeps large dumps diffable and readable by line-oriented tools.
+   */
+  JsonWriter& Newline() {
+    mBreak = true;
+    return *this;
+  }
+
+  /**
+   * @brief Hand over buffered bytes to the sink.
+   *
+   * @return false if the sink failed now or on any earlier flush.
+   */
+  bool Flush() {
+    Break();
+    return FlushBuffer();
+  }
+
+  inline bool Ok() const { return mOk; }
+
+  // Bytes handed over to the sink or still buffered.
+  inline uint64_t BytesWritten() const { return mFlushed + mBuffer.size(); }
+
+private:
+  void Open(char c) {
+    Separate();
+    Put(c);
+    mFirst.push_back(true);
+  }
+
+  void Close(char c) {
+    mFirst.pop_back();
+    Break();
+    Put(c);
+  }
+
+  bool FlushBuffer() {
+    if (!mBuffer.empty()) {
+      mFlushed += mBuffer.size();
+      if (mOk) mOk = mSink(mBuffer.data(), mBuffer.size());
+      mBuffer.clear();
+    }
+    return mOk;
+  }
+
+  void Break() {
+    if (!mBreak) return;
+    mBreak = false;
+    Put('\n');
+  }
+
+  // Emit the comma between siblings, nothing right after a key.
+  void Separate() {
+    if (mAfterKey) {
+      mAfterKey = false;
+      return;
+    }
+    if (!mFirst.empty()) {
+      if (!mFirst.back()) Put(',');
+      mFirst.back() = false;
+    }
+    Break();
+  }
+
+  void AppendString(const std::string& value) {
+    Put('"');
+    for (char c : value) {
+      switch (c) {
+        case '"':
+          Append("\\\"");
+          break;
+        case '\\':
+          Append("\\\\");
+          break;
+        case '\n':
+          Append("\\n");
+          break;
+        case '\r':
+          Append("\\r");
+          break;
+        case '\t':
+          Append("\\t");
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                          static_cast<unsigned>(c));
+            Append(escaped);
+          } else {
+            Put(c);
+          }
+      }
+    }
+    Put('"');
+  }
+
+  void Append(const char* s) {
+    while (*s) Put(*s++);
+  }
+
+  void Append(const std::string& s) {
+    for (char c : s) Put(c);
+  }
+
+  inline void Put(char c) {
+    mBuffer.push_back(c);
+    if (mBuffer.size() >= mBufferSize) FlushBuffer();
+  }
+
+  JsonSink mSink;
+  const size_t mBufferSize;
+  std::string mBuffer;
+  // Per open container, whether no value was written into it yet.
+  std::vector<bool> mFirst;
+  bool mAfterKey{false};
+  bool mBreak{false};
+  bool mOk{true};
+  uint64_t mFlushed{0};
+};
+
+}  // namespace common
+}  // namespace hyperon
@@ -6,6 +6,9 @@
 namespace hyperon {
 namespace common {
 
+// DOM-based (de)serialization of small objects. Whole hyperbases are too
+// large for a DOM, they are streamed with common::JsonWriter and
+// base::read_json_dump instead.
 template <typename T>
 class IJsonizable {
 public:
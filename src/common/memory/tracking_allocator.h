@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * Structures that memory is accounted to.
+ */
+enum MEMORY_KIND {
+  // Concept objects themselves.
+  MEM_CONCEPTS = 0,
+  // Name index of all concepts of a hyperbase.
+  MEM_CONCEPT_INDEX,
+  // Concept and sub-category maps of categories.
+  MEM_CATEGORY_MAPS,
+  // Parents, children, unions and splits.
+  MEM_LINEAGE,
+  // Relation members and the relations bound to a member.
+  MEM_MEMBERS,
+  // Representations of concepts.
+  MEM_REPRESENTATIONS,
+  // Interval index of events.
+  MEM_EVENT_INDEX,
+  MEM_KIND_COUNT
+};
+
+inline const char* memory_kind_name(MEMORY_KIND kind) {
+  switch (kind) {
+    case MEM_CONCEPTS:
+      return "concepts";
+    case MEM_CONCEPT_INDEX:
+      return "concept_index";
+    case MEM_CATEGORY_MAPS:
+      return "category_maps";
+    case MEM_LINEAGE:
+      return "lineage";
+    case MEM_MEMBERS:
+      return "members";
+    case MEM_REPRESENTATIONS:
+      return "representations";
+    case MEM_EVENT_INDEX:
+      return "event_index";
+    default:
+      return "unknown";
+  }
+}
+
+/**
+ * @brief Live bytes by kind allocated through the tracking allocators of
+ * one owner, e.g. a category. Every charge also rolls up into the parent
+ * account, e.g. the hyperbase, so that both levels are read without a
+ * scan. Counters are relaxed atomics: a charge costs one uncontended
+ * atomic add per level, and the figures are exact whenever writers are
+ * quiet.
+ *
+ * Accounts are reference counted by their allocators, since containers
+ * may outlive the owner of their account, e.g. a concept still referenced
+ * by a query after its hyperbase was evicted.
+ */
+class MemoryAccount {
+public:
+  MemoryAccount(const MemoryAccount&) = delete;
+  MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+  inline void Ref() { mRefs.fetch_add(1, std::memory_order_relaxed); }
+  inline void Unref() {
+    if (mRefs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+  inline void Charge(MEMORY_KIND kind, int64_t bytes) {
+    for (MemoryAccount* cur = this; cur != nullptr; cur = cur->mParent) {
+      cur->mBytes[kind].fetch_add(bytes, std::memory_order_relaxed);
+    }
+  }
+
+  // Live bytes of a kind, 0 while a concurrent free runs ahead.
+  inline uint64_t Bytes(MEMORY_KIND kind) const {
+    int64_t bytes = mBytes[kind].load(std::memory_order_relaxed);
+    return bytes > 0 ? static_cast<uint64_t>(bytes) : 0;
+  }
+
+  inline uint64_t Total() const {
+    uint64_t total = 0;
+    for (uint32_t kind = 0; kind < MEM_KIND_COUNT; ++kind) {
+      total += Bytes(static_cast<MEMORY_KIND>(kind));
+    }
+    return total;
+  }
+
+  inline MemoryAccount* Parent() const { return mParent; }
+
+private:
+  friend class MemoryAccountRef;
+
+  explicit MemoryAccount(MemoryAccount* parent) : mParent(parent) {
+    if (mParent) mParent->Ref();
+  }
+  ~MemoryAccount() {
+    if (mParent) mParent->Unref();
+  }
+
+  MemoryAccount* const mParent;
+  std::atomic<uint32_t> mRefs{1};
+  std::array<std::atomic<int64_t>, MEM_KIND_COUNT> mBytes{};
+};
+
+/**
+ * @brief Owning reference to a MemoryAccount.
+ */
+class MemoryAccountRef {
+public:
+  MemoryAccountRef() = default;
+  MemoryAccountRef(const MemoryAccountRef& other) : mAccount(other.mAccount) {
+    if (mAccount) mAccount->Ref();
+  }
+  MemoryAccountRef& operator=(const MemoryAccountRef& other) {
+    MemoryAccountRef copy(other);
+    std::swap(mAccount, copy.mAccount);
+    return *this;
+  }
+  ~MemoryAccountRef() {
+    if (mAccount) mAccount->Unref();
+  }
+
+  // A new account charging through to `parent`, if any.
+  static MemoryAccountRef Create(MemoryAccount* parent = nullptr) {
+    MemoryAccountRef ref;
+    ref.mAccount = new MemoryAccount(parent);
+    return ref;
+  }
+
+  inline MemoryAccount* get() const { return mAccount; }
+  inline MemoryAccount* operator->() const { return mAccount; }
+  inline MemoryAccount& operator*() const { return *mAccount; }
+
+private:
+  MemoryAccount* mAccount{nullptr};
+};
+
+/**
+ * @brief Standard allocator charging the bytes it hands out to an account
+ * under a fixed kind. Default constructed, it charges nothing, so tracked
+ * containers behave as plain ones outside of a hyperbase.
+ *
+ * Allocators of different accounts compare unequal and propagate on move
+ * and swap, so a container keeps charging the account it was built with.
+ * Moving a container to another account is done by rebind_container().
+ */
+template <typename T, MEMORY_KIND Kind>
+class TrackingAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  template <typename U>
+  struct rebind {
+    using other = TrackingAllocator<U, Kind>;
+  };
+
+  TrackingAllocator() noexcept = default;
+  explicit TrackingAllocator(MemoryAccount* account) noexcept
+      : mAccount(account) {
+    if (mAccount) mAccount->Ref();
+  }
+  TrackingAllocator(const TrackingAllocator& other) noexcept
+      : TrackingAllocator(other.mAccount) {}
+  template <typename U>
+  TrackingAllocator(const TrackingAllocator<U, Kind>& other) noexcept
+      : TrackingAllocator(other.Account()) {}
+  TrackingAllocator& operator=(const TrackingAllocator& other) noexcept {
+    if (other.mAccount) other.mAccount->Ref();
+    if (mAccount) mAccount->Unref();
+    mAccount = other.mAccount;
+    return *this;
+  }
+  ~TrackingAllocator() {
+    if (mAccount) mAccount->Unref();
+  }
+
+  T* allocate(size_t n) {
+    T* p = std::allocator<T>().allocate(n);
+    if (mAccount) mAccount->Charge(Kind, n * sizeof(T));
+    return p;
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    if (mAccount) mAccount->Charge(Kind, -static_cast<int64_t>(n * sizeof(T)));
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  inline MemoryAccount* Account() const { return mAccount; }
+
+private:
+  MemoryAccount* mAccount{nullptr};
+};
+
+template <typename T, typename U, MEMORY_KIND Kind>
+inline bool operator==(const TrackingAllocator<T, Kind>& a,
+                       const TrackingAllocator<U, Kind>& b) {
+  return a.Account() == b.Account();
+}
+
+template <typename T, typename U, MEMORY_KIND Kind>
+inline bool operator!=(const TrackingAllocator<T, Kind>& a,
+                       const TrackingAllocator<U, Kind>& b) {
+  return a.Account() != b.Account();
+}
+
+template <typename T, MEMORY_KIND Kind>
+using TrackedList = std::list<T, TrackingAllocator<T, Kind>>;
+
+template <typename T, MEMORY_KIND Kind>
+using TrackedSet = std::set<T, std::less<T>, TrackingAllocator<T, Kind>>;
+
+template <typename K, typename V, MEMORY_KIND Kind>
+using TrackedMap = std::map<K, V, std::less<K>,
+                           TrackingAllocator<std::pair<const K, V>, Kind>>;
+
+template <typename K, typename V, MEMORY_KIND Kind>
+using TrackedHashMap =
+    std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                       TrackingAllocator<std::pair<const K, V>, Kind>>;
+
+/**
+ * @brief Charge a tracked container to `account` from now on, moving its
+ * elements over. Free for an empty container; nested tracked containers
+ * keep their own account and must be rebound by the caller.
+ */
+template <typename Container>
+void rebind_container(Container& container, MemoryAccount* account) {
+  using Allocator = typename Container::allocator_type;
+  if (container.get_allocator().Account() == account) return;
+  Container rebound{Allocator(account)};
+  for (auto& value : container) {
+    rebound.insert(rebound.end(), std::move(value));
+  }
+  container.swap(rebound);
+}
+
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,559 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * Process-wide metrics with per-thread storage.
+ *
+ * Every thread owns a block of counter and histogram cells. Only the owning
+ * thread writes its cells, with relaxed loads and stores instead of atomic
+ * read-modify-writes, so recording costs a thread-local access and an add.
+ * A scrape sums the blocks of all live threads and of exited ones.
+ *
+ * Counters, histograms and gauges are registered once by name and labels,
+ * typically as namespace-scope objects; registering the same series again
+ * returns the existing one. Series registered beyond kMaxCounters or
+ * kMaxHistograms share an overflow slot that is never scraped, and are
+ * counted by the hyperon_metrics_dropped_series gauge.
+ */
+
+constexpr uint32_t kMaxCounters = 256;
+constexpr uint32_t kMaxHistograms = 64;
+
+// Log-linear buckets in the manner of HDR histograms: values below 8 get
+// their own bucket, larger ones 8 buckets per power of two, so that a
+// bucket is at most 12.5% wide.
+constexpr uint32_t kHistogramSubBits = 3;
+constexpr uint32_t kHistogramSub = 1u << kHistogramSubBits;
+constexpr uint32_t kHistogramBuckets =
+    kHistogramSub + (64 - kHistogramSubBits) * kHistogramSub;
+
+inline uint32_t histogram_bucket(uint64_t value) {
+  if (value < kHistogramSub) return static_cast<uint32_t>(value);
+  uint32_t exp = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+  uint32_t sub = static_cast<uint32_t>(value >> (exp - kHistogramSubBits)) &
+                 (kHistogramSub - 1);
+  return kHistogramSub + (exp - kHistogramSubBits) * kHistogramSub + sub;
+}
+
+// Largest value falling into `bucket`.
+inline uint64_t histogram_bucket_upper(uint32_t bucket) {
+  if (bucket < kHistogramSub) return bucket;
+  uint32_t exp = (bucket - kHistogramSub) / kHistogramSub + kHistogramSubBits;
+  uint64_t sub = (bucket - kHistogramSub) % kHistogramSub;
+  uint64_t low = (kHistogramSub + sub) << (exp - kHistogramSubBits);
+  return low + (uint64_t{1} << (exp - kHistogramSubBits)) - 1;
+}
+
+/**
+ * @brief Aggregated state of a histogram.
+ */
+struct HistogramSnapshot {
+  uint64_t count{0};
+  uint64_t sum{0};
+  std::array<uint64_t, kHistogramBuckets> buckets{};
+
+  // Upper bound of the bucket holding the q-quantile, 0 if empty.
+  uint64_t Quantile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < kHistogramBuckets; ++b) {
+      seen += buckets[b];
+      if (seen >= rank) return histogram_bucket_upper(b);
+    }
+    return histogram_bucket_upper(kHistogramBuckets - 1);
+  }
+
+  // Upper bound of the highest non-empty bucket, 0 if empty.
+  uint64_t Max() const {
+    for (uint32_t b = kHistogramBuckets; b-- > 0;) {
+      if (buckets[b] > 0) return histogram_bucket_upper(b);
+    }
+    return 0;
+  }
+
+  // Number of values not above `bound`, exact when `bound` + 1 is a power
+  // of two or below 8.
+  uint64_t CountAtMost(uint64_t bound) const {
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < kHistogramBuckets; ++b) {
+      if (histogram_bucket_upper(b) > bound) break;
+      seen += buckets[b];
+    }
+    return seen;
+  }
+};
+
+/**
+ * @brief One series of a scrape.
+ */
+struct MetricSample {
+  enum METRIC_TYPE { COUNTER, GAUGE, HISTOGRAM };
+
+  std::string name;
+  std::string help;
+  // Prometheus label list without braces, e.g. method="BulkIngest".
+  std::string labels;
+  METRIC_TYPE type{COUNTER};
+  // Counter or gauge value.
+  double value{0};
+  // Histograms only, values in nanoseconds.
+  HistogramSnapshot histogram;
+};
+
+using MetricsSnapshot = std::vector<MetricSample>;
+
+class MetricsRegistry {
+public:
+  // Never destroyed, so that threads exiting late can still retire.
+  static MetricsRegistry& Instance() {
+    static MetricsRegistry* instance = new MetricsRegistry();
+    return *instance;
+  }
+
+  uint32_t RegisterCounter(const std::string& name, const std::string& help,
+                           const std::string& labels) {
+    return Register(mCounters, kMaxCounters, name, help, labels);
+  }
+
+  uint32_t RegisterHistogram(const std::string& name, const std::string& help,
+                             const std::string& labels) {
+    return Register(mHistograms, kMaxHistograms, name, help, labels);
+  }
+
+  // @return Id for UnregisterGauge
+  uint64_t RegisterGauge(const std::string& name, const std::string& help,
+                         const std::string& labels,
+                         std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mGaugeMutex);
+    uint64_t id = mNextGauge++;
+    mGauges.emplace(id, GaugeSeries{{name, help, labels}, std::move(read)});
+    return id;
+  }
+
+  // Waits for a scrape reading the gauge.
+  void UnregisterGauge(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mGaugeMutex);
+    mGauges.erase(id);
+    mCollectors.erase(id);
+  }
+
+  /**
+   * @brief Register a function appending any number of samples to every
+   * scrape, for families whose label sets come and go, e.g. per tenant.
+   *
+   * @return Id for UnregisterGauge
+   */
+  uint64_t RegisterCollector(std::function<void(MetricsSnapshot&)> collect) {
+    std::lock_guard<std::mutex> lock(mGaugeMutex);
+    uint64_t id = mNextGauge++;
+    mCollectors.emplace(id, std::move(collect));
+    return id;
+  }
+
+  /**
+   * @brief Sum the cells of all threads and read the gauges. Gauges are
+   * read under their own lock, so they may record metrics themselves.
+   */
+  void Snapshot(MetricsSnapshot& out) const {
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (uint32_t id = 0; id < mCounters.size(); ++id) {
+      MetricSample sample = Describe(mCounters[id], MetricSample::COUNTER);
+      uint64_t total = 0;
+      ForEachBlock([&](const Block& block) {
+        total += block.counters[id].load(std::memory_order_relaxed);
+      });
+      sample.value = static_cast<double>(total);
+      out.push_back(std::move(sample));
+    }
+    for (uint32_t id = 0; id < mHistograms.size(); ++id) {
+      MetricSample sample = Describe(mHistograms[id], MetricSample::HISTOGRAM);
+      ForEachBlock([&](const Block& block) {
+        const Cells* cells =
+            block.histograms[id].load(std::memory_order_acquire);
+        if (cells) cells->AddTo(sample.histogram);
+      });
+      out.push_back(std::move(sample));
+    }
+    MetricSample dropped;
+    dropped.name = "hyperon_metrics_dropped_series";
+    dropped.help =
+        "Counters and histograms registered beyond capacity, not scraped.";
+    dropped.type = MetricSample::GAUGE;
+    dropped.value = static_cast<double>(mDropped.size());
+    out.push_back(std::move(dropped));
+    lock.unlock();
+
+    std::lock_guard<std::mutex> gauge_lock(mGaugeMutex);
+    for (const auto& kv : mGauges) {
+      MetricSample sample = Describe(kv.second.series, MetricSample::GAUGE);
+      sample.value = kv.second.read();
+      out.push_back(std::move(sample));
+    }
+    for (const auto& kv : mCollectors) kv.second(out);
+  }
+
+  inline void AddCounter(uint32_t id, uint64_t delta) {
+    std::atomic<uint64_t>& cell = Local().counters[id];
+    cell.store(cell.load(std::memory_order_relaxed) + delta,
+               std::memory_order_relaxed);
+  }
+
+  inline void Record(uint32_t id, uint64_t value) {
+    Block& block = Local();
+    Cells* cells = block.histograms[id].load(std::memory_order_relaxed);
+    if (!cells) {
+      cells = new Cells();
+      block.histograms[id].store(cells, std::memory_order_release);
+    }
+    cells->Record(value);
+  }
+
+  // Number of distinct series registered beyond capacity.
+  size_t Dropped() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDropped.size();
+  }
+
+private:
+  struct Series {
+    std::string name;
+    std::string help;
+    std::string labels;
+  };
+
+  struct GaugeSeries {
+    Series series;
+    std::function<double()> read;
+  };
+
+  // Histogram cells of one thread.
+  struct Cells {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::array<std::atomic<uint64_t>, kHistogramBuckets> buckets{};
+
+    inline static void Bump(std::atomic<uint64_t>& cell, uint64_t delta) {
+      cell.store(cell.load(std::memory_order_relaxed) + delta,
+                 std::memory_order_relaxed);
+    }
+
+    inline void Record(uint64_t value) {
+      Bump(buckets[histogram_bucket(value)], 1);
+      Bump(count, 1);
+      Bump(sum, value);
+    }
+
+    void AddTo(HistogramSnapshot& snapshot) const {
+      snapshot.count += count.load(std::memory_order_relaxed);
+      snapshot.sum += sum.load(std::memory_order_relaxed);
+      for (uint32_t b = 0; b < kHistogramBuckets; ++b) {
+        snapshot.buckets[b] += buckets[b].load(std::memory_order_relaxed);
+      }
+    }
+  };
+
+  // Cells of one thread. The extra last slots absorb metrics registered
+  // beyond capacity.
+  struct Block {
+    std::array<std::atomic<uint64_t>, kMaxCounters + 1> counters{};
+    std::array<std::atomic<Cells*>, kMaxHistograms + 1> histograms{};
+
+    ~Block() {
+      for (auto& cells : histograms) delete cells.load();
+    }
+  };
+
+  // Hands the block of an exiting thread back to the registry.
+  struct Retirer {
+    Block* block{nullptr};
+    ~Retirer() {
+      if (block) Instance().Retire(block);
+    }
+  };
+
+  MetricsRegistry() : mRetired(std::make_unique<Block>()) {}
+
+  static inline Block*& LocalSlot() {
+    static thread_local Block* block = nullptr;
+    return block;
+  }
+
+  inline Block& Local() {
+    Block*& block = LocalSlot();
+    if (!block) block = Attach();
+    return *block;
+  }
+
+  Block* Attach() {
+    static thread_local Retirer retirer;
+    auto block = std::make_unique<Block>();
+    retirer.block = block.get();
+    std::lock_guard<std::mutex> lock(mMutex);
+    mBlocks.push_back(std::move(block));
+    return mBlocks.back().get();
+  }
+
+  // Fold an exiting thread's cells into mRetired.
+  void Retire(Block* block) {
+    LocalSlot() = nullptr;
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (uint32_t id = 0; id <= kMaxCounters; ++id) {
+      Cells::Bump(mRetired->counters[id],
+                  block->counters[id].load(std::memory_order_relaxed));
+    }
+    for (uint32_t id = 0; id <= kMaxHistograms; ++id) {
+      Cells* cells = block->histograms[id].load(std::memory_order_relaxed);
+      if (!cells) continue;
+      Cells* into = mRetired->histograms[id].load(std::memory_order_relaxed);
+      if (!into) {
+        mRetired->histograms[id].store(cells, std::memory_order_release);
+        block->histograms[id].store(nullptr, std::memory_order_relaxed);
+        continue;
+      }
+      Cells::Bump(into->count, cells->count.load(std::memory_order_relaxed));
+      Cells::Bump(into->sum, cells->sum.load(std::memory_order_relaxed));
+      for (uint32_t b = 0; b < kHistogramBuckets; ++b) {
+        Cells::Bump(into->buckets[b],
+                    cells->buckets[b].load(std::memory_order_relaxed));
+      }
+    }
+    for (auto it = mBlocks.begin(); it != mBlocks.end(); ++it) {
+      if (it->get() == block) {
+        mBlocks.erase(it);
+        break;
+      }
+    }
+  }
+
+  uint32_t Register(std::vector<Series>& series, uint32_t capacity,
+                    const std::string& name, const std::string& help,
+                    const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (uint32_t id = 0; id < series.size(); ++id) {
+      if (series[id].name == name && series[id].labels == labels) return id;
+    }
+    if (series.size() == capacity) {
+      mDropped.insert(name + '{' + labels + '}');
+      return capacity;
+    }
+    series.push_back({name, help, labels});
+    return static_cast<uint32_t>(series.size() - 1);
+  }
+
+  template <typename Fn>
+  void ForEachBlock(Fn&& fn) const {
+    fn(*mRetired);
+    for (const auto& block : mBlocks) fn(*block);
+  }
+
+  static MetricSample Describe(const Series& series,
+                               MetricSample::METRIC_TYPE type) {
+    MetricSample sample;
+    sample.name = series.name;
+    sample.help = series.help;
+    sample.labels = series.labels;
+    sample.type = type;
+    return sample;
+  }
+
+  mutable std::mutex mMutex;
+  std::vector<Series> mCounters;
+  std::vector<Series> mHistograms;
+  // Names and labels of series past capacity.
+  std::set<std::string> mDropped;
+  mutable std::mutex mGaugeMutex;
+  std::map<uint64_t, GaugeSeries> mGauges;
+  std::map<uint64_t, std::function<void(MetricsSnapshot&)>> mCollectors;
+  uint64_t mNextGauge{0};
+  std::vector<std::unique_ptr<Block>> mBlocks;
+  std::unique_ptr<Block> mRetired;
+};
+
+/**
+ * @brief Monotonic counter.
+ */
+class Counter {
+public:
+  Counter(const std::string& name, const std::string& help,
+          const std::string& labels = "")
+      : mId(MetricsRegistry::Instance().RegisterCounter(name, help, labels)) {}
+
+  inline void Add(uint64_t delta = 1) const {
+    MetricsRegistry::Instance().AddCounter(mId, delta);
+  }
+
+private:
+  uint32_t mId;
+};
+
+/**
+ * @brief Latency histogram, recording nanoseconds and exported in seconds.
+ */
+class Histogram {
+public:
+  Histogram(const std::string& name, const std::string& help,
+            const std::string& labels = "")
+      : mId(MetricsRegistry::Instance().RegisterHistogram(name, help,
+                                                          labels)) {}
+
+  inline void Record(uint64_t nanos) const {
+    MetricsRegistry::Instance().Record(mId, nanos);
+  }
+
+private:
+  uint32_t mId;
+};
+
+/**
+ * @brief Value read at scrape time, for as long as the object lives.
+ */
+class Gauge {
+public:
+  Gauge(const std::string& name, const std::string& help,
+        std::function<double()> read, const std::string& labels = "")
+      : mId(MetricsRegistry::Instance().RegisterGauge(name, help, labels,
+                                                      std::move(read))) {}
+  ~Gauge() { MetricsRegistry::Instance().UnregisterGauge(mId); }
+
+  Gauge(const Gauge&) = delete;
+  Gauge& operator=(const Gauge&) = delete;
+
+private:
+  uint64_t mId;
+};
+
+/**
+ * @brief Samples appended to every scrape, for as long as the object lives.
+ */
+class Collector {
+public:
+  explicit Collector(std::function<void(MetricsSnapshot&)> collect)
+      : mId(MetricsRegistry::Instance().RegisterCollector(
+            std::move(collect))) {}
+  ~Collector() { MetricsRegistry::Instance().UnregisterGauge(mId); }
+
+  Collector(const Collector&) = delete;
+  Collector& operator=(const Collector&) = delete;
+
+private:
+  uint64_t mId;
+};
+
+/**
+ * @brief A Prometheus label pair with the value escaped.
+ */
+inline std::string prometheus_label(const std::string& name,
+                                    const std::string& value) {
+  std::string out = name + "=\"";
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+  return out;
+}
+
+/**
+ * @brief Record the lifetime of the scope into a histogram.
+ */
+class ScopedLatency {
+public:
+  explicit ScopedLatency(const Histogram& histogram)
+      : mHistogram(histogram), mStart(std::chrono::steady_clock::now()) {}
+  ~ScopedLatency() {
+    mHistogram.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - mStart)
+                          .count());
+  }
+
+private:
+  const Histogram& mHistogram;
+  std::chrono::steady_clock::time_point mStart;
+};
+
+/**
+ * @brief Render a scrape in the Prometheus text exposition format, version
+ * 0.0.4. Histograms get cumulative buckets at powers of two from 1us to
+ * about 68s.
+ */
+inline std::string format_prometheus(const MetricsSnapshot& snapshot) {
+  static const char* const kTypes[] = {"counter", "gauge", "histogram"};
+  std::string out;
+  std::string last;
+  auto series = [&out](const std::string& name, const std::string& labels,
+                       const std::string& extra) {
+    out += name;
+    if (!labels.empty() || !extra.empty()) {
+      out += '{';
+      out += labels;
+      if (!labels.empty() && !extra.empty()) out += ',';
+      out += extra;
+      out += '}';
+    }
+    out += ' ';
+  };
+  // Families must be contiguous, keep the scrape order otherwise.
+  std::vector<const MetricSample*> ordered;
+  std::map<std::string, size_t> first;
+  for (const auto& sample : snapshot) {
+    first.emplace(sample.name, first.size());
+    ordered.push_back(&sample);
+  }
+  std::stable_sort(ordered.begin(), ordered.end(),
+                   [&first](const MetricSample* a, const MetricSample* b) {
+                     return first[a->name] < first[b->name];
+                   });
+  for (const MetricSample* sample : ordered) {
+    if (sample->name != last) {
+      out += "# HELP " + sample->name + " " + sample->help + "\n";
+      out += "# TYPE " + sample->name + " " + kTypes[sample->type] + "\n";
+      last = sample->name;
+    }
+    if (sample->type != MetricSample::HISTOGRAM) {
+      series(sample->name, sample->labels, "");
+      out += fmt::format("{}\n", sample->value);
+      continue;
+    }
+    const HistogramSnapshot& h = sample->histogram;
+    for (uint32_t exp = 10; exp <= 36; ++exp) {
+      uint64_t bound = (uint64_t{1} << exp) - 1;
+      series(sample->name + "_bucket", sample->labels,
+             fmt::format("le=\"{}\"", (bound + 1) / 1e9));
+      out += std::to_string(h.CountAtMost(bound)) + "\n";
+    }
+    series(sample->name + "_bucket", sample->labels, "le=\"+Inf\"");
+    out += std::to_string(h.count) + "\n";
+    series(sample->name + "_sum", sample->labels, "");
+    out += fmt::format("{}\n", h.sum / 1e9);
+    series(sample->name + "_count", sample->labels, "");
+    out += std::to_string(h.count) + "\n";
+  }
+  return out;
+}
+
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <utility>
+
+namespace hyperon {
+namespace common {
+
+/**
+ * Execution profiles of queries, in the manner of EXPLAIN ANALYZE.
+ *
+ * Query APIs take an optional `ProfileNode*` and, when it is set, fill it
+ * with the operator they ran and append a child per phase: lock waits,
+ * index lookups, lineage walks, joins. Time is measured per operator, not
+ * per row, so that profiling a query does not change where its time goes;
+ * rows and cache outcomes are counted exactly. Without a profile the only
+ * cost is a null check per operator.
+ */
+struct ProfileNode {
+  std::string op;
+  // Arguments of the operator, e.g. an origin or a rule.
+  std::string detail;
+  // Index or access path used, empty for none.
+  std::string index;
+  // Times the operator ran, e.g. once per origin or per fixpoint round.
+  uint64_t loops{0};
+  uint64_t rows_in{0};
+  uint64_t rows_out{0};
+  // Inclusive of the children.
+  uint64_t nanos{0};
+  uint64_t cache_hits{0};
+  uint64_t cache_misses{0};
+  // A list, so that references to children survive adding more.
+  std::list<ProfileNode> children;
+
+  ProfileNode() = default;
+  ProfileNode(std::string op_, std::string detail_ = "",
+              std::string index_ = "")
+      : op(std::move(op_)),
+        detail(std::move(detail_)),
+        index(std::move(index_)) {}
+
+  ProfileNode& AddChild(std::string op_, std::string detail_ = "",
+                        std::string index_ = "") {
+    children.emplace_back(std::move(op_), std::move(detail_),
+                          std::move(index_));
+    return children.back();
+  }
+
+  // Child named `op_`, added on first use.
+  ProfileNode& Child(const std::string& op_, const std::string& index_ = "") {
+    for (auto& child : children) {
+      if (child.op == op_) return child;
+    }
+    return AddChild(op_, "", index_);
+  }
+
+  /**
+   * @brief The tree as indented text, one operator per line:
+   *
+   *   walk_lineage (ancestors) time=1.204ms loops=1 rows=4096->40960
+   *     -> lock_wait time=0.002ms
+   *     -> concept_index index=hash rows=4096->4096
+   */
+  std::string ToString() const {
+    std::string text;
+    Format(text, 0);
+    return text;
+  }
+
+private:
+  void Format(std::string& text, size_t depth) const {
+    if (depth > 0) text += std::string(2 * depth, ' ') + "-> ";
+    text += op;
+    if (!detail.empty()) text += fmt::format(" ({})", detail);
+    if (!index.empty()) text += fmt::format(" index={}", index);
+    if (nanos > 0) text += fmt::format(" time={:.3f}ms", nanos / 1e6);
+    if (loops > 0) text += fmt::format(" loops={}", loops);
+    if (rows_in > 0 || rows_out > 0) {
+      text += fmt::format(" rows={}->{}", rows_in, rows_out);
+    }
+    if (cache_hits > 0 || cache_misses > 0) {
+      text += fmt::format(" cache={}/{}", cache_hits,
+                          cache_hits + cache_misses);
+    }
+    text += '\n';
+    for (const auto& child : children) child.Format(text, depth + 1);
+  }
+};
+
+// Child of `parent`, or null without a profile.
+inline ProfileNode* profile_child(ProfileNode* parent, std::string op,
+                                  std::string detail = "",
+                                  std::string index = "") {
+  if (!parent) return nullptr;
+  return &parent->AddChild(std::move(op), std::move(detail),
+                           std::move(index));
+}
+
+/**
+ * @brief Adds the time from construction to Stop() or destruction to a
+ * node. Does nothing, not even read the clock, for a null node.
+ */
+class ProfileTimer {
+public:
+  explicit ProfileTimer(ProfileNode* node) : mNode(node) {
+    if (mNode) mStart = std::chrono::steady_clock::now();
+  }
+  ~ProfileTimer() { Stop(); }
+
+  ProfileTimer(const ProfileTimer&) = delete;
+  ProfileTimer& operator=(const ProfileTimer&) = delete;
+
+  void Stop() {
+    if (!mNode) return;
+    mNode->nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - mStart)
+                        .count();
+    mNode = nullptr;
+  }
+
+private:
+  ProfileNode* mNode;
+  std::chrono::steady_clock::time_point mStart;
+};
+
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/proto/wire_writer.h"
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Decoder of the protobuf wire format, the counterpart of
+ * ProtoWriter. Reads the fields of one message in order from a
+ * caller-owned buffer; nested messages are read by a reader over their
+ * bytes, with no copies. Any malformed or truncated input makes the reader
+ * fail and stay failed.
+ */
+class ProtoReader {
+public:
+  using WIRE_TYPE = ProtoWriter::WIRE_TYPE;
+
+  explicit ProtoReader(const std::string& in)
+      : mIn(&in), mPos(0), mEnd(in.size()) {}
+
+  /**
+   * @brief Read the tag of the next field.
+   * @return false at the end of the message or on malformed input.
+   */
+  bool Next(uint32_t& field, WIRE_TYPE& type) {
+    uint64_t tag = 0;
+    if (!mOk || mPos == mEnd || !Read(tag)) return false;
+    field = static_cast<uint32_t>(tag >> 3);
+    type = static_cast<WIRE_TYPE>(tag & 7);
+    return mOk;
+  }
+
+  inline bool Varint(uint64_t& value) { return Read(value); }
+
+  bool String(std::string& value) {
+    size_t size = 0;
+    if (!Length(size)) return false;
+    value.assign(*mIn, mPos, size);
+    mPos += size;
+    return true;
+  }
+
+  // Reader of a nested message or packed field.
+  bool Message(ProtoReader& nested) {
+    size_t size = 0;
+    if (!Length(size)) return false;
+    nested = ProtoReader(*mIn, mPos, mPos + size);
+    mPos += size;
+    return true;
+  }
+
+  // Skip the value of a field of no interest.
+  bool Skip(WIRE_TYPE type) {
+    uint64_t value = 0;
+    size_t size = 0;
+    switch (type) {
+      case ProtoWriter::WIRE_VARINT:
+        return Read(value);
+      case ProtoWriter::WIRE_FIXED64:
+        return Advance(8);
+      case ProtoWriter::WIRE_LENGTH:
+        return Length(size) && Advance(size);
+      case ProtoWriter::WIRE_FIXED32:
+        return Advance(4);
+    }
+    return mOk = false;
+  }
+
+  // False if the input was malformed.
+  inline bool Ok() const { return mOk; }
+  inline bool AtEnd() const { return mPos == mEnd; }
+
+private:
+  ProtoReader(const std::string& in, size_t begin, size_t end)
+      : mIn(&in), mPos(begin), mEnd(end) {}
+
+  bool Read(uint64_t& value) {
+    if (!mOk || !get_varint(*mIn, mPos, value) || mPos > mEnd) mOk = false;
+    return mOk;
+  }
+
+  bool Length(size_t& size) {
+    uint64_t value = 0;
+    if (!Read(value) || value > mEnd - mPos) return mOk = false;
+    size = static_cast<size_t>(value);
+    return true;
+  }
+
+  bool Advance(size_t size) {
+    if (!mOk || size > mEnd - mPos) return mOk = false;
+    mPos += size;
+    return true;
+  }
+
+  const std::string* mIn;
+  size_t mPos;
+  size_t mEnd;
+  bool mOk{true};
+};
+
+}  // namespace common
+}  // namespace hyperon
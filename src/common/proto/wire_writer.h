@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/compress/varint.h"
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Encoder of the protobuf wire format into a caller-owned buffer.
+ *
+ * Handlers write their responses field by field straight from the element
+ * store, with no message objects or copies of the strings in between, and
+ * hand the bytes over to the transport as they are. Keep the buffer across
+ * calls and its capacity is reused.
+ *
+ * Nested messages and packed fields are written in place: Begin() reserves
+ * room for the longest length prefix, End() writes the actual length and
+ * moves the body up if it turned out shorter. Default values are written
+ * as given, so fields without presence should be skipped by the caller
+ * when zero or empty.
+ */
+class ProtoWriter {
+public:
+  enum WIRE_TYPE {
+    WIRE_VARINT = 0,
+    WIRE_FIXED64 = 1,
+    WIRE_LENGTH = 2,
+    WIRE_FIXED32 = 5,
+  };
+
+  // Position of a nested message or packed field being written.
+  struct Mark {
+    size_t tag;
+    size_t body;
+  };
+
+  explicit ProtoWriter(std::string& out) : mOut(out) {}
+
+  inline std::string& Buffer() { return mOut; }
+
+  inline void Tag(uint32_t field, WIRE_TYPE type) {
+    put_varint(mOut, (static_cast<uint64_t>(field) << 3) | type);
+  }
+
+  inline void Varint(uint32_t field, uint64_t value) {
+    Tag(field, WIRE_VARINT);
+    put_varint(mOut, value);
+  }
+
+  inline void Bool(uint32_t field, bool value) {
+    Varint(field, value ? 1 : 0);
+  }
+
+  inline void String(uint32_t field, const char* data, size_t size) {
+    Tag(field, WIRE_LENGTH);
+    put_varint(mOut, size);
+    mOut.append(data, size);
+  }
+
+  inline void String(uint32_t field, const std::string& value) {
+    String(field, value.data(), value.size());
+  }
+
+  // Open a nested message or packed field, close it with End().
+  Mark Begin(uint32_t field) {
+    Mark mark;
+    mark.tag = mOut.size();
+    Tag(field, WIRE_LENGTH);
+    mOut.append(kMaxPrefix, '\0');
+    mark.body = mOut.size();
+    return mark;
+  }
+
+  // Element of an open packed field.
+  inline void Packed(uint64_t value) { put_varint(mOut, value); }
+
+  /**
+   * @param keep_empty Keep an empty field, e.g. a nested message whose
+   * presence matters. Empty packed fields are dropped.
+   */
+  void End(const Mark& mark, bool keep_empty = true) {
+    size_t size = mOut.size() - mark.body;
+    if (size == 0 && !keep_empty) {
+      mOut.resize(mark.tag);
+      return;
+    }
+    char prefix[kMaxPrefix];
+    size_t length = 0;
+    uint64_t value = size;
+    while (value >= 0x80) {
+      prefix[length++] = static_cast<char>(value | 0x80);
+      value >>= 7;
+    }
+    prefix[length++] = static_cast<char>(value);
+    mOut.replace(mark.body - kMaxPrefix, kMaxPrefix, prefix, length);
+  }
+
+private:
+  // Varint bytes of the largest length, messages are below 4 GiB.
+  static constexpr size_t kMaxPrefix = 5;
+
+  std::string& mOut;
+};
+
+}  // namespace common
+}  // namespace hyperon
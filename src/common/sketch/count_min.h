@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common/sketch/mix.h"
+
+namespace hyperon {
+namespace common {
+
+/**
+ * @brief Count-min sketch of per-key counts in `depth` rows of `width`
+ * counters. Estimates never undercount while all true counts stay
+ * non-negative, and overcount by at most e/width of the total with
+ * probability 1 - exp(-depth). Negative updates are allowed for keys whose
+ * count was incremented before (turnstile model).
+ */
+class CountMinSketch {
+public:
+  explicit CountMinSketch(uint32_t width = 2048, uint32_t depth = 4)
+      : mWidth(std::max(width, 1u)),
+        mDepth(std::max(depth, 1u)),
+        mCounters(static_cast<size_t>(mWidth) * mDepth, 0) {}
+
+  inline void Add(uint64_t hash, int64_t delta = 1) {
+    uint64_t x = mix64(hash);
+    for (uint32_t row = 0; row < mDepth; ++row) {
+      mCounters[Slot(x, row)] += delta;
+    }
+    mTotal += delta;
+  }
+
+  inline int64_t Estimate(uint64_t hash) const {
+    uint64_t x = mix64(hash);
+    int64_t estimate = std::numeric_limits<int64_t>::max();
+    for (uint32_t row = 0; row < mDepth; ++row) {
+      estimate = std::min(estimate, mCounters[Slot(x, row)]);
+    }
+    return std::max<int64_t>(estimate, 0);
+  }
+
+  // Sum of all updates.
+  inline int64_t Total() const { return mTotal; }
+
+  void Clear() {
+    std::fill(mCounters.begin(), mCounters.end(), 0);
+    mTotal = 0;
+  }
+
+private:
+  // Row hashes derived by double hashing from one 64-bit value.
+  inline size_t Slot(uint64_t x, uint32_t row) const {
+    uint64_t h = (x & 0xffffffffULL) + row * (x >> 32 | 1);
+    return static_cast<size_t>(row) * mWidth + h % mWidth;
+  }
+
+  uint32_t mWidth;
+  uint32_t mDepth;
+  std::vector<int64_t> mCounters;
+  int64_t mTotal{0};
+};
+
+}  // namespace common
+}  // namespace hyperon
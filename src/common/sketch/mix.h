@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+namespace hyperon {
+namespace common {
+
+// SplitMix64 finalizer, spreads weak hashes such as std::hash over all bits.
+inline uint64_t mix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "common/compress/id_list.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+std::vector<uint32_t> ids(const IdList& list) {
+  std::vector<uint32_t> out;
+  list.Decode(out);
+  return out;
+}
+
+TEST(IdListTest, EncodesGapsOfAscendingIds) {
+  IdList list;
+  EXPECT_TRUE(list.Empty());
+  EXPECT_FALSE(list.Contains(0));
+  for (uint32_t id : {3u, 4u, 200u, 70000u, 0xffffffffu}) {
+    EXPECT_TRUE(list.Insert(id));
+  }
+  EXPECT_EQ(list.Size(), 5u);
+  EXPECT_EQ(list.Back(), 0xffffffffu);
+  // One byte for 3 and 1, two for 196, three for 69800, five for the last.
+  EXPECT_EQ(list.Bytes(), 12u);
+  EXPECT_EQ(ids(list),
+            (std::vector<uint32_t>{3, 4, 200, 70000, 0xffffffffu}));
+  EXPECT_TRUE(list.Contains(200));
+  EXPECT_FALSE(list.Contains(199));
+  EXPECT_FALSE(list.Insert(70000));
+}
+
+TEST(IdListTest, InsertsAndErasesOutOfOrder) {
+  IdList list;
+  for (uint32_t id : {10u, 30u}) list.Insert(id);
+  EXPECT_TRUE(list.Insert(20));
+  EXPECT_TRUE(list.Insert(0));
+  EXPECT_FALSE(list.Insert(20));
+  EXPECT_EQ(ids(list), (std::vector<uint32_t>{0, 10, 20, 30}));
+
+  EXPECT_FALSE(list.Erase(15));
+  EXPECT_FALSE(list.Erase(31));
+  EXPECT_TRUE(list.Erase(0));
+  EXPECT_TRUE(list.Erase(30));
+  EXPECT_EQ(ids(list), (std::vector<uint32_t>{10, 20}));
+  EXPECT_EQ(list.Back(), 20u);
+  list.Clear();
+  EXPECT_TRUE(list.Empty());
+  EXPECT_EQ(list.Bytes(), 0u);
+}
+
+TEST(IdListTest, StopsVisitingWhenAsked) {
+  IdList list;
+  list.Assign({1, 2, 3, 4});
+  std::vector<uint32_t> seen;
+  list.ForEach([&seen](uint32_t id) {
+    seen.push_back(id);
+    return id < 2;
+  });
+  EXPECT_EQ(seen, (std::vector<uint32_t>{1, 2}));
+}
+
+TEST(IdListTest, MergesSortedBatches) {
+  IdList list;
+  EXPECT_EQ(list.Merge({5, 9}), 2u);
+  // Above the largest id, appended without re-encoding.
+  EXPECT_EQ(list.Merge({12, 40}), 2u);
+  EXPECT_EQ(list.Merge({}), 0u);
+  EXPECT_EQ(list.Merge({1, 9, 10, 40, 41}), 3u);
+  EXPECT_EQ(ids(list), (std::vector<uint32_t>{1, 5, 9, 10, 12, 40, 41}));
+  EXPECT_EQ(list.Merge({5, 12}), 0u);
+  EXPECT_EQ(list.Size(), 7u);
+}
+
+TEST(IdListTest, MatchesASetUnderRandomUpdates) {
+  std::mt19937 rng(37);
+  IdList list;
+  std::set<uint32_t> expected;
+  for (int round = 0; round < 50; ++round) {
+    for (int i = 0; i < 20; ++i) {
+      uint32_t id = rng() % 500;
+      if (rng() % 3 == 0) {
+        EXPECT_EQ(list.Erase(id), expected.erase(id) == 1);
+      } else {
+        EXPECT_EQ(list.Insert(id), expected.insert(id).second);
+      }
+    }
+    std::vector<uint32_t> batch;
+    for (int i = 0; i < 30; ++i) batch.push_back(rng() % 600);
+    std::sort(batch.begin(), batch.end());
+    batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+    size_t absent = 0;
+    for (uint32_t id : batch) absent += expected.insert(id).second;
+    EXPECT_EQ(list.Merge(batch), absent);
+    ASSERT_EQ(ids(list),
+              std::vector<uint32_t>(expected.begin(), expected.end()));
+    ASSERT_EQ(list.Size(), expected.size());
+  }
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
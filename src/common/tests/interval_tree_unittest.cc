@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "common/index/interval_tree.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+using Tree = IntervalTree<std::string>;
+
+constexpr int64_t kMin = Tree::kMin;
+constexpr int64_t kMax = Tree::kMax;
+
+// Values of the visited intervals, in visiting order.
+template <typename Query>
+std::vector<std::string> values(const Tree& tree, Query&& query) {
+  std::vector<std::string> out;
+  query([&](Tree::Handle handle) {
+    out.push_back(tree.Value(handle));
+    return true;
+  });
+  return out;
+}
+
+std::vector<std::string> overlapping(const Tree& tree, int64_t start,
+                                     int64_t end) {
+  return values(tree, [&](auto fn) { tree.Overlapping(start, end, fn); });
+}
+
+std::vector<std::string> within(const Tree& tree, int64_t start,
+                                int64_t end) {
+  return values(tree, [&](auto fn) { tree.Within(start, end, fn); });
+}
+
+std::vector<std::string> containing(const Tree& tree, int64_t start,
+                                    int64_t end) {
+  return values(tree, [&](auto fn) { tree.Containing(start, end, fn); });
+}
+
+using Names = std::vector<std::string>;
+
+// [0, 100], [5, 9], [10, 20], [15, 15], [20, 30] and [25, open].
+class IntervalTreeTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    // Out of start order on purpose.
+    mTree.Insert(20, 30, "c");
+    mTree.Insert(10, 20, "b");
+    mTree.Insert(0, 100, "all");
+    mTree.Insert(15, 15, "point");
+    mTree.Insert(5, 9, "a");
+    mTree.Insert(25, kMax, "open");
+  }
+
+  Tree mTree;
+};
+
+TEST_F(IntervalTreeTest, IncludesBothBounds) {
+  EXPECT_EQ(overlapping(mTree, 20, 20), (Names{"all", "b", "c"}));
+  EXPECT_EQ(overlapping(mTree, 9, 10), (Names{"all", "a", "b"}));
+  EXPECT_EQ(overlapping(mTree, 101, 200), (Names{"open"}));
+  EXPECT_EQ(overlapping(mTree, -10, -1), Names{});
+
+  EXPECT_EQ(within(mTree, 10, 20), (Names{"b", "point"}));
+  EXPECT_EQ(within(mTree, 15, 15), (Names{"point"}));
+  EXPECT_EQ(within(mTree, 11, 29), (Names{"point"}));
+  EXPECT_EQ(within(mTree, kMin, kMax),
+            (Names{"all", "a", "b", "point", "c", "open"}));
+
+  EXPECT_EQ(containing(mTree, 15, 15), (Names{"all", "b", "point"}));
+  EXPECT_EQ(containing(mTree, 10, 20), (Names{"all", "b"}));
+  EXPECT_EQ(containing(mTree, 20, 30), (Names{"all", "c"}));
+  EXPECT_EQ(containing(mTree, 1000, 2000), (Names{"open"}));
+  EXPECT_EQ(containing(mTree, -1, 0), Names{});
+}
+
+TEST_F(IntervalTreeTest, StopsWhenAsked) {
+  Names seen;
+  mTree.Overlapping(kMin, kMax, [&](Tree::Handle handle) {
+    seen.push_back(mTree.Value(handle));
+    return seen.size() < 3;
+  });
+  EXPECT_EQ(seen, (Names{"all", "a", "b"}));
+}
+
+TEST(IntervalTreeScanTest, SkipsSubtreesByTheirEnds) {
+  Tree tree;
+  for (int64_t i = 0; i < 1024; ++i) tree.Insert(i * 10, i * 10 + 5, "");
+  size_t examined = tree.Overlapping(5000, 5000, [](Tree::Handle) {
+    return true;
+  });
+  // Two root paths of a treap of 1024 nodes, not the whole tree.
+  EXPECT_LT(examined, 200u);
+}
+
+TEST_F(IntervalTreeTest, ReusesErasedHandles) {
+  EXPECT_EQ(mTree.Size(), 6u);
+  Tree::Handle b = 1;
+  ASSERT_EQ(mTree.Value(b), "b");
+  mTree.Erase(b);
+  EXPECT_EQ(mTree.Size(), 5u);
+  EXPECT_EQ(overlapping(mTree, 20, 20), (Names{"all", "c"}));
+
+  Tree::Handle late = mTree.Insert(-5, 12, "late");
+  EXPECT_EQ(late, b);
+  EXPECT_EQ(mTree.Start(late), -5);
+  EXPECT_EQ(mTree.End(late), 12);
+  EXPECT_EQ(overlapping(mTree, 11, 12), (Names{"late", "all"}));
+  // Other handles are untouched.
+  EXPECT_EQ(mTree.Value(0), "c");
+  EXPECT_EQ(mTree.Start(0), 20);
+
+  mTree.Clear();
+  EXPECT_TRUE(mTree.Empty());
+  EXPECT_EQ(mTree.Insert(1, 2, "new"), 0u);
+  EXPECT_EQ(overlapping(mTree, kMin, kMax), (Names{"new"}));
+}
+
+TEST(IntervalTreeScanTest, OrdersEqualStartsByHandle) {
+  Tree tree;
+  std::vector<Tree::Handle> erased;
+  for (int i = 0; i < 50; ++i) {
+    Tree::Handle handle = tree.Insert(7, 7 + i % 5, std::to_string(i));
+    if (i % 3 == 0) erased.push_back(handle);
+  }
+  // Erase every third one, roots included, then refill the freed handles.
+  for (Tree::Handle handle : erased) tree.Erase(handle);
+  EXPECT_EQ(tree.Size(), 33u);
+  std::vector<Tree::Handle> reused;
+  for (size_t i = 0; i < erased.size(); ++i) {
+    reused.push_back(tree.Insert(7, 7, "again"));
+  }
+  std::sort(reused.begin(), reused.end());
+  EXPECT_EQ(reused, erased);
+
+  std::vector<Tree::Handle> order;
+  tree.Overlapping(kMin, kMax, [&](Tree::Handle handle) {
+    order.push_back(handle);
+    return true;
+  });
+  EXPECT_EQ(order.size(), 50u);
+  EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+}
+
+struct Entry {
+  int64_t start;
+  int64_t end;
+  Tree::Handle handle;
+};
+
+// Handles of `entries` matching the ranges, by start and then handle.
+std::vector<Tree::Handle> scan(const std::vector<Entry>& entries,
+                               int64_t start_lo, int64_t start_hi,
+                               int64_t end_lo, int64_t end_hi) {
+  std::vector<Entry> found;
+  for (const auto& entry : entries) {
+    if (entry.start >= start_lo && entry.start <= start_hi &&
+        entry.end >= end_lo && entry.end <= end_hi) {
+      found.push_back(entry);
+    }
+  }
+  std::sort(found.begin(), found.end(), [](const Entry& a, const Entry& b) {
+    return std::tie(a.start, a.handle) < std::tie(b.start, b.handle);
+  });
+  std::vector<Tree::Handle> out;
+  for (const auto& entry : found) out.push_back(entry.handle);
+  return out;
+}
+
+template <typename Query>
+std::vector<Tree::Handle> handles(Query&& query) {
+  std::vector<Tree::Handle> out;
+  query([&](Tree::Handle handle) {
+    out.push_back(handle);
+    return true;
+  });
+  return out;
+}
+
+TEST(IntervalTreeRandomTest, MatchesABruteForceScan) {
+  std::mt19937_64 rng(29);
+  Tree tree;
+  std::vector<Entry> entries;
+  auto point = [&rng] { return static_cast<int64_t>(rng() % 1000) - 200; };
+  for (int round = 0; round < 200; ++round) {
+    for (int i = 0; i < 20; ++i) {
+      if (!entries.empty() && rng() % 3 == 0) {
+        size_t victim = rng() % entries.size();
+        tree.Erase(entries[victim].handle);
+        entries[victim] = entries.back();
+        entries.pop_back();
+        continue;
+      }
+      int64_t start = point();
+      // Short, long and open intervals.
+      int64_t length = rng() % 2 ? rng() % 10 : rng() % 400;
+      int64_t end = rng() % 10 == 0 ? kMax : start + length;
+      Tree::Handle handle = tree.Insert(start, end, "");
+      entries.push_back({start, end, handle});
+    }
+    ASSERT_EQ(tree.Size(), entries.size());
+    for (int q = 0; q < 5; ++q) {
+      int64_t start = point();
+      int64_t end = start + rng() % 300;
+      ASSERT_EQ(handles([&](auto fn) { tree.Overlapping(start, end, fn); }),
+                scan(entries, kMin, end, start, kMax));
+      ASSERT_EQ(handles([&](auto fn) { tree.Within(start, end, fn); }),
+                scan(entries, start, end, kMin, end));
+      ASSERT_EQ(handles([&](auto fn) { tree.Containing(start, end, fn); }),
+                scan(entries, kMin, start, end, kMax));
+      int64_t end_lo = point();
+      int64_t end_hi = end_lo + rng() % 500;
+      ASSERT_EQ(handles([&](auto fn) {
+                  tree.Visit(start, end, end_lo, end_hi, fn);
+                }),
+                scan(entries, start, end, end_lo, end_hi));
+    }
+  }
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
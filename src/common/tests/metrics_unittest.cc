@@ -0,0 +1,231 @@
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/metrics/metrics.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+const MetricSample* find(const MetricsSnapshot& snapshot,
+                         const std::string& name,
+                         const std::string& labels = "") {
+  for (const auto& sample : snapshot) {
+    if (sample.name == name && sample.labels == labels) return &sample;
+  }
+  return nullptr;
+}
+
+MetricsSnapshot scrape() {
+  MetricsSnapshot snapshot;
+  MetricsRegistry::Instance().Snapshot(snapshot);
+  return snapshot;
+}
+
+TEST(HistogramBucketTest, KeepsBucketsWithinAnEighth) {
+  for (uint64_t value = 0; value < kHistogramSub; ++value) {
+    EXPECT_EQ(histogram_bucket(value), value);
+    EXPECT_EQ(histogram_bucket_upper(value), value);
+  }
+  // Every bucket starts right after the previous one.
+  for (uint32_t b = 1; b < kHistogramBuckets; ++b) {
+    uint64_t lower = histogram_bucket_upper(b - 1) + 1;
+    uint64_t upper = histogram_bucket_upper(b);
+    ASSERT_EQ(histogram_bucket(lower), b);
+    ASSERT_EQ(histogram_bucket(upper), b);
+    uint64_t width = upper - lower + 1;
+    ASSERT_LE(width * kHistogramSub,
+              std::max<uint64_t>(lower, kHistogramSub));
+  }
+  EXPECT_EQ(histogram_bucket(std::numeric_limits<uint64_t>::max()),
+            kHistogramBuckets - 1);
+  EXPECT_EQ(histogram_bucket_upper(kHistogramBuckets - 1),
+            std::numeric_limits<uint64_t>::max());
+
+  std::mt19937_64 rng(11);
+  for (int i = 0; i < 10000; ++i) {
+    uint64_t value = rng() >> (rng() % 64);
+    uint32_t bucket = histogram_bucket(value);
+    ASSERT_LE(value, histogram_bucket_upper(bucket));
+    ASSERT_TRUE(bucket == 0 || value > histogram_bucket_upper(bucket - 1));
+  }
+}
+
+TEST(HistogramBucketTest, ReadsQuantilesFromBucketBounds) {
+  HistogramSnapshot h;
+  EXPECT_EQ(h.Quantile(0.5), 0u);
+  EXPECT_EQ(h.Max(), 0u);
+  for (uint64_t value = 1; value <= 100; ++value) {
+    ++h.buckets[histogram_bucket(value)];
+    ++h.count;
+    h.sum += value;
+  }
+  // 50 falls into [48, 51], 100 into [96, 103].
+  EXPECT_EQ(h.Quantile(0.5), 51u);
+  EXPECT_EQ(h.Quantile(0.0), 1u);
+  EXPECT_EQ(h.Quantile(1.0), 103u);
+  EXPECT_EQ(h.Max(), 103u);
+  // Exact at powers of two.
+  EXPECT_EQ(h.CountAtMost(7), 7u);
+  EXPECT_EQ(h.CountAtMost(63), 63u);
+  EXPECT_EQ(h.CountAtMost(1023), 100u);
+  EXPECT_EQ(h.CountAtMost(0), 0u);
+}
+
+TEST(MetricsRegistryTest, KeepsTheCellsOfExitedThreads) {
+  Counter calls("test_thread_calls_total", "Calls.", "pool=\"a\"");
+  Histogram latency("test_thread_latency_seconds", "Latency.");
+  // Registering again yields the same series.
+  Counter again("test_thread_calls_total", "Calls.", "pool=\"a\"");
+
+  auto run = [&](int threads) {
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+      pool.emplace_back([&calls, &latency, t] {
+        calls.Add(100);
+        for (uint64_t i = 0; i < 10; ++i) latency.Record(1000 * (t + 1));
+      });
+    }
+    for (auto& thread : pool) thread.join();
+  };
+  run(4);
+  again.Add(1);
+
+  MetricsSnapshot snapshot = scrape();
+  const MetricSample* counter =
+      find(snapshot, "test_thread_calls_total", "pool=\"a\"");
+  ASSERT_NE(counter, nullptr);
+  EXPECT_EQ(counter->value, 401.0);
+  EXPECT_EQ(counter->type, MetricSample::COUNTER);
+  const MetricSample* histogram =
+      find(snapshot, "test_thread_latency_seconds");
+  ASSERT_NE(histogram, nullptr);
+  EXPECT_EQ(histogram->histogram.count, 40u);
+  EXPECT_EQ(histogram->histogram.sum, 100000u);
+
+  // Later threads fold into the cells retired before.
+  run(3);
+  snapshot = scrape();
+  EXPECT_EQ(find(snapshot, "test_thread_calls_total", "pool=\"a\"")->value,
+            701.0);
+  const HistogramSnapshot& h =
+      find(snapshot, "test_thread_latency_seconds")->histogram;
+  EXPECT_EQ(h.count, 70u);
+  EXPECT_EQ(h.sum, 160000u);
+  EXPECT_EQ(h.buckets[histogram_bucket(1000)], 20u);
+  EXPECT_EQ(h.buckets[histogram_bucket(4000)], 10u);
+}
+
+TEST(MetricsRegistryTest, ReadsGaugesAndCollectorsWhileRegistered) {
+  double level = 2;
+  {
+    Gauge gauge("test_level", "Level.", [&level] { return level; });
+    Collector collector([](MetricsSnapshot& out) {
+      MetricSample sample;
+      sample.name = "test_tenant_bytes";
+      sample.labels = "tenant=\"t\"";
+      sample.type = MetricSample::GAUGE;
+      sample.value = 7;
+      out.push_back(sample);
+    });
+    level = 3;
+    MetricsSnapshot snapshot = scrape();
+    ASSERT_NE(find(snapshot, "test_level"), nullptr);
+    EXPECT_EQ(find(snapshot, "test_level")->value, 3.0);
+    ASSERT_NE(find(snapshot, "test_tenant_bytes", "tenant=\"t\""), nullptr);
+  }
+  MetricsSnapshot snapshot = scrape();
+  EXPECT_EQ(find(snapshot, "test_level"), nullptr);
+  EXPECT_EQ(find(snapshot, "test_tenant_bytes", "tenant=\"t\""), nullptr);
+}
+
+TEST(PrometheusFormatTest, RendersFamiliesContiguously) {
+  EXPECT_EQ(prometheus_label("path", "a\"b\\c\nd"),
+            "path=\"a\\\"b\\\\c\\nd\"");
+
+  MetricsSnapshot snapshot(4);
+  snapshot[0].name = "calls_total";
+  snapshot[0].help = "Calls.";
+  snapshot[0].labels = prometheus_label("method", "Get");
+  snapshot[0].value = 3;
+  snapshot[1].name = "level";
+  snapshot[1].help = "Level.";
+  snapshot[1].type = MetricSample::GAUGE;
+  snapshot[1].value = 1.5;
+  snapshot[2] = snapshot[0];
+  snapshot[2].labels = prometheus_label("method", "Put");
+  snapshot[2].value = 4;
+  snapshot[3].name = "latency_seconds";
+  snapshot[3].help = "Latency.";
+  snapshot[3].type = MetricSample::HISTOGRAM;
+  HistogramSnapshot& h = snapshot[3].histogram;
+  for (uint64_t nanos : {2000ull, 3000000000ull}) {
+    ++h.buckets[histogram_bucket(nanos)];
+    ++h.count;
+    h.sum += nanos;
+  }
+
+  std::string text = format_prometheus(snapshot);
+  std::string expected_head =
+      "# HELP calls_total Calls.\n"
+      "# TYPE calls_total counter\n"
+      "calls_total{method=\"Get\"} 3\n"
+      "calls_total{method=\"Put\"} 4\n"
+      "# HELP level Level.\n"
+      "# TYPE level gauge\n"
+      "level 1.5\n"
+      "# HELP latency_seconds Latency.\n"
+      "# TYPE latency_seconds histogram\n"
+      "latency_seconds_bucket{le=\"1.024e-06\"} 0\n"
+      "latency_seconds_bucket{le=\"2.048e-06\"} 1\n";
+  EXPECT_EQ(text.substr(0, expected_head.size()), expected_head);
+  // 3s is at most 2^32 ns.
+  EXPECT_NE(text.find("latency_seconds_bucket{le=\"2.147483648\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("latency_seconds_bucket{le=\"4.294967296\"} 2\n"),
+            std::string::npos);
+  std::string expected_tail =
+      "latency_seconds_bucket{le=\"68.719476736\"} 2\n"
+      "latency_seconds_bucket{le=\"+Inf\"} 2\n"
+      "latency_seconds_sum 3.000002\n"
+      "latency_seconds_count 2\n";
+  ASSERT_GE(text.size(), expected_tail.size());
+  EXPECT_EQ(text.substr(text.size() - expected_tail.size()), expected_tail);
+}
+
+TEST(MetricsRegistryTest, CountsSeriesBeyondCapacity) {
+  MetricsRegistry& registry = MetricsRegistry::Instance();
+  size_t before = registry.Dropped();
+  std::vector<Counter> counters;
+  for (uint32_t i = 0; i <= kMaxCounters; ++i) {
+    counters.emplace_back("test_overflow_total", "Overflow.",
+                          fmt::format("i=\"{}\"", i));
+  }
+  size_t dropped = registry.Dropped();
+  EXPECT_GE(dropped, before + 1);
+  // The same series again is not counted twice.
+  Counter repeated("test_overflow_total", "Overflow.",
+                   fmt::format("i=\"{}\"", kMaxCounters));
+  EXPECT_EQ(registry.Dropped(), dropped);
+  // Recording into the overflow slot is harmless and never scraped.
+  repeated.Add(5);
+  MetricsSnapshot snapshot = scrape();
+  EXPECT_EQ(find(snapshot, "test_overflow_total",
+                 fmt::format("i=\"{}\"", kMaxCounters)),
+            nullptr);
+  const MetricSample* gauge = find(snapshot, "hyperon_metrics_dropped_series");
+  ASSERT_NE(gauge, nullptr);
+  EXPECT_EQ(gauge->value, static_cast<double>(dropped));
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
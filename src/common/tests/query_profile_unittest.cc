@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+TEST(QueryProfileTest, AddsChildrenOnFirstUse) {
+  ProfileNode root("walk_lineage", "ancestors");
+  ProfileNode& wait = root.Child("lock_wait");
+  wait.loops = 1;
+  ProfileNode& index = root.Child("concept_index", "hash");
+  EXPECT_EQ(index.index, "hash");
+  // References stay valid as children are added.
+  for (int i = 0; i < 10; ++i) root.AddChild("probe");
+  EXPECT_EQ(&root.Child("lock_wait"), &wait);
+  EXPECT_EQ(root.Child("lock_wait").loops, 1u);
+  EXPECT_EQ(root.children.size(), 12u);
+
+  EXPECT_EQ(profile_child(nullptr, "nothing"), nullptr);
+  ProfileNode* child = profile_child(&root, "join", "r(X)", "member[bf]");
+  ASSERT_NE(child, nullptr);
+  EXPECT_EQ(child->detail, "r(X)");
+  EXPECT_EQ(&root.children.back(), child);
+}
+
+TEST(QueryProfileTest, PrintsOnlyTheCountersThatWereSet) {
+  ProfileNode root("walk_lineage", "ancestors");
+  root.nanos = 1204000;
+  root.loops = 1;
+  root.rows_in = 4096;
+  root.rows_out = 40960;
+  ProfileNode& wait = root.AddChild("lock_wait");
+  wait.nanos = 2000;
+  ProfileNode& index = root.AddChild("concept_index", "", "hash");
+  index.rows_in = 4096;
+  index.rows_out = 4096;
+  ProfileNode& cache = index.AddChild("result_cache");
+  cache.cache_hits = 3;
+  cache.cache_misses = 1;
+  // Rows out alone are printed too.
+  root.AddChild("filter").rows_out = 7;
+
+  EXPECT_EQ(root.ToString(),
+            "walk_lineage (ancestors) time=1.204ms loops=1 rows=4096->40960\n"
+            "  -> lock_wait time=0.002ms\n"
+            "  -> concept_index index=hash rows=4096->4096\n"
+            "    -> result_cache cache=3/4\n"
+            "  -> filter rows=0->7\n");
+  EXPECT_EQ(ProfileNode("empty").ToString(), "empty\n");
+}
+
+TEST(QueryProfileTest, TimesUntilStoppedOnce) {
+  ProfileNode node("sleep");
+  {
+    ProfileTimer timer(&node);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    timer.Stop();
+    uint64_t stopped = node.nanos;
+    EXPECT_GE(stopped, 2000000u);
+    // Neither a second Stop() nor the destructor add more.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    timer.Stop();
+    EXPECT_EQ(node.nanos, stopped);
+  }
+  uint64_t first = node.nanos;
+  {
+    // Timers of repeated runs accumulate.
+    ProfileTimer timer(&node);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_GE(node.nanos, first + 1000000);
+
+  // A null node is ignored.
+  ProfileTimer idle(nullptr);
+  idle.Stop();
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "common/index/roaring.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+using Bitmap = RoaringBitmap<>;
+using Set = IdSet<>;
+
+template <typename T>
+std::vector<uint32_t> ids(const T& set) {
+  std::vector<uint32_t> out;
+  set.ForEach([&out](uint32_t id) {
+    out.push_back(id);
+    return true;
+  });
+  return out;
+}
+
+std::vector<uint32_t> ids(const std::set<uint32_t>& set) {
+  return std::vector<uint32_t>(set.begin(), set.end());
+}
+
+TEST(RoaringBitmapTest, SwitchesContainersAtTheArrayLimit) {
+  Bitmap bitmap;
+  // Ids of group 1, so that the group key matters.
+  const uint32_t base = 1u << 16;
+  for (uint32_t i = 0; i < Bitmap::kArrayMax; ++i) {
+    EXPECT_TRUE(bitmap.Add(base + 2 * i));
+  }
+  EXPECT_EQ(bitmap.Cardinality(), 4096u);
+  EXPECT_EQ(bitmap.BitmapGroups(), 0u);
+  EXPECT_FALSE(bitmap.Add(base));
+  EXPECT_EQ(bitmap.BitmapGroups(), 0u);
+
+  EXPECT_TRUE(bitmap.Add(base + 1));
+  EXPECT_EQ(bitmap.Cardinality(), 4097u);
+  EXPECT_EQ(bitmap.BitmapGroups(), 1u);
+  EXPECT_TRUE(bitmap.Contains(base + 1));
+  EXPECT_TRUE(bitmap.Contains(base + 2 * 4095));
+  EXPECT_FALSE(bitmap.Contains(base + 3));
+
+  EXPECT_FALSE(bitmap.Remove(base + 3));
+  EXPECT_EQ(bitmap.BitmapGroups(), 1u);
+  EXPECT_TRUE(bitmap.Remove(base + 1));
+  EXPECT_EQ(bitmap.Cardinality(), 4096u);
+  EXPECT_EQ(bitmap.BitmapGroups(), 0u);
+  std::vector<uint32_t> expected;
+  for (uint32_t i = 0; i < Bitmap::kArrayMax; ++i) {
+    expected.push_back(base + 2 * i);
+  }
+  EXPECT_EQ(ids(bitmap), expected);
+
+  // And back over the limit from the array.
+  EXPECT_TRUE(bitmap.Add(base + 9999));
+  EXPECT_EQ(bitmap.BitmapGroups(), 1u);
+  EXPECT_TRUE(bitmap.Remove(base));
+  EXPECT_EQ(bitmap.BitmapGroups(), 0u);
+  EXPECT_TRUE(bitmap.Contains(base + 9999));
+
+  for (uint32_t id : ids(bitmap)) EXPECT_TRUE(bitmap.Remove(id));
+  EXPECT_TRUE(bitmap.Empty());
+  EXPECT_TRUE(ids(bitmap).empty());
+}
+
+// Group 0 dense in `a` and sparse in `b`, group 1 the other way round,
+// groups 2 and 3 in one side only.
+class RoaringMixedTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    for (uint32_t i = 0; i < 5000; ++i) Put(mA, mSetA, 2 * i);
+    for (uint32_t i = 0; i < 1000; ++i) Put(mB, mSetB, 3 * i);
+    for (uint32_t i = 0; i < 300; ++i) Put(mA, mSetA, (1u << 16) + 7 * i);
+    for (uint32_t i = 0; i < 6000; ++i) Put(mB, mSetB, (1u << 16) + i);
+    for (uint32_t i = 0; i < 10; ++i) Put(mA, mSetA, (2u << 16) + i);
+    for (uint32_t i = 0; i < 10; ++i) Put(mB, mSetB, (3u << 16) + i);
+    ASSERT_EQ(mA.BitmapGroups(), 1u);
+    ASSERT_EQ(mB.BitmapGroups(), 1u);
+  }
+
+  static void Put(Bitmap& bitmap, std::set<uint32_t>& set, uint32_t id) {
+    bitmap.Add(id);
+    set.insert(id);
+  }
+
+  Bitmap mA, mB;
+  std::set<uint32_t> mSetA, mSetB;
+};
+
+TEST_F(RoaringMixedTest, IntersectsAcrossContainerKinds) {
+  std::set<uint32_t> both;
+  std::set_intersection(mSetA.begin(), mSetA.end(), mSetB.begin(),
+                        mSetB.end(), std::inserter(both, both.end()));
+  Bitmap result = Bitmap::And(mA, mB);
+  EXPECT_EQ(ids(result), ids(both));
+  EXPECT_EQ(result.Cardinality(), both.size());
+  EXPECT_EQ(Bitmap::AndCardinality(mA, mB), both.size());
+  EXPECT_EQ(Bitmap::AndCardinality(mB, mA), both.size());
+  EXPECT_EQ(ids(Bitmap::And(mB, mA)), ids(both));
+  EXPECT_EQ(result.BitmapGroups(), 0u);
+}
+
+TEST_F(RoaringMixedTest, UnitesAcrossContainerKinds) {
+  std::set<uint32_t> either = mSetA;
+  either.insert(mSetB.begin(), mSetB.end());
+  Bitmap result = Bitmap::Or(mA, mB);
+  EXPECT_EQ(ids(result), ids(either));
+  EXPECT_EQ(result.Cardinality(), either.size());
+  EXPECT_EQ(ids(Bitmap::Or(mB, mA)), ids(either));
+}
+
+TEST(RoaringBitmapTest, ResizesContainersOfSetOperations) {
+  // Two bitmaps whose intersection fits an array.
+  Bitmap evens, thirds;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    evens.Add(2 * i);
+    thirds.Add(3 * i);
+  }
+  Bitmap sixths = Bitmap::And(evens, thirds);
+  EXPECT_EQ(sixths.Cardinality(), 1667u);
+  EXPECT_EQ(sixths.BitmapGroups(), 0u);
+
+  // Two arrays whose union does not.
+  Bitmap low, high;
+  for (uint32_t i = 0; i < 3000; ++i) {
+    low.Add(i);
+    high.Add(30000 + i);
+  }
+  Bitmap both = Bitmap::Or(low, high);
+  EXPECT_EQ(both.Cardinality(), 6000u);
+  EXPECT_EQ(both.BitmapGroups(), 1u);
+  EXPECT_TRUE(both.Contains(32999));
+  EXPECT_FALSE(both.Contains(3000));
+}
+
+TEST(IdSetTest, PromotesAndDemotesWithHysteresis) {
+  Set set;
+  for (uint32_t id = Set::kInline; id > 0; --id) EXPECT_TRUE(set.Insert(id));
+  EXPECT_FALSE(set.Insert(3));
+  EXPECT_FALSE(set.Promoted());
+  EXPECT_EQ(set.Bytes(), 0u);
+  EXPECT_EQ(ids(set), (std::vector<uint32_t>{1, 2, 3, 4, 5, 6, 7, 8}));
+
+  EXPECT_TRUE(set.Insert(100000));
+  EXPECT_TRUE(set.Promoted());
+  EXPECT_EQ(set.Size(), 9u);
+  EXPECT_GT(set.Bytes(), 0u);
+
+  // Stays a bitmap down to half of the inline capacity.
+  for (uint32_t id = 1; id <= 4; ++id) EXPECT_TRUE(set.Erase(id));
+  EXPECT_TRUE(set.Promoted());
+  EXPECT_FALSE(set.Erase(1));
+  EXPECT_TRUE(set.Erase(5));
+  EXPECT_FALSE(set.Promoted());
+  EXPECT_EQ(ids(set), (std::vector<uint32_t>{6, 7, 8, 100000}));
+  EXPECT_TRUE(set.Contains(100000));
+  EXPECT_FALSE(set.Contains(5));
+}
+
+TEST(IdSetTest, CopiesAndMovesPromotedSets) {
+  Set promoted;
+  for (uint32_t id = 0; id < 100; ++id) promoted.Insert(id * 1000);
+  ASSERT_TRUE(promoted.Promoted());
+
+  Set copy(promoted);
+  EXPECT_TRUE(copy.Promoted());
+  EXPECT_EQ(ids(copy), ids(promoted));
+  copy.Erase(0);
+  EXPECT_TRUE(promoted.Contains(0));
+  EXPECT_EQ(promoted.Size(), 100u);
+
+  Set assigned;
+  assigned.Insert(7);
+  assigned = promoted;
+  EXPECT_EQ(ids(assigned), ids(promoted));
+  assigned = assigned;
+  EXPECT_EQ(assigned.Size(), 100u);
+
+  Set moved(std::move(copy));
+  EXPECT_EQ(moved.Size(), 99u);
+  EXPECT_TRUE(moved.Promoted());
+  EXPECT_TRUE(copy.Empty());
+  EXPECT_FALSE(copy.Promoted());
+
+  Set target;
+  for (uint32_t id = 0; id < 20; ++id) target.Insert(id);
+  target = std::move(moved);
+  EXPECT_EQ(target.Size(), 99u);
+  EXPECT_FALSE(target.Contains(0));
+  EXPECT_TRUE(moved.Empty());
+  // Usable after being moved from.
+  moved.Insert(3);
+  EXPECT_EQ(ids(moved), (std::vector<uint32_t>{3}));
+}
+
+TEST(IdSetTest, CombinesInlineAndPromotedSets) {
+  std::mt19937 random(7);
+  for (int round = 0; round < 50; ++round) {
+    Set a, b;
+    std::set<uint32_t> set_a, set_b;
+    uint32_t size_a = random() % 30;
+    uint32_t size_b = random() % 30;
+    for (uint32_t i = 0; i < size_a; ++i) {
+      uint32_t id = random() % 64;
+      a.Insert(id);
+      set_a.insert(id);
+    }
+    for (uint32_t i = 0; i < size_b; ++i) {
+      uint32_t id = random() % 64;
+      b.Insert(id);
+      set_b.insert(id);
+    }
+    std::set<uint32_t> both, either = set_a;
+    std::set_intersection(set_a.begin(), set_a.end(), set_b.begin(),
+                          set_b.end(), std::inserter(both, both.end()));
+    either.insert(set_b.begin(), set_b.end());
+
+    Set out;
+    Set::Intersect(a, b, out);
+    EXPECT_EQ(ids(out), ids(both));
+    EXPECT_EQ(Set::IntersectionCount(a, b), both.size());
+    Set::Unite(a, b, out);
+    EXPECT_EQ(ids(out), ids(either));
+    EXPECT_EQ(out.Size(), either.size());
+  }
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+#include "common/sketch/count_min.h"
+#include "common/sketch/hyperloglog.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+TEST(CountMinSketchTest, NeverUndercountsAndStaysWithinTheBound) {
+  CountMinSketch sketch(256, 4);
+  std::unordered_map<uint64_t, int64_t> counts;
+  std::mt19937_64 rng(3);
+  // Skewed keys: a few heavy ones and a long tail.
+  for (int i = 0; i < 20000; ++i) {
+    uint64_t key = rng() % 8 == 0 ? rng() % 4 : rng() % 5000;
+    sketch.Add(key);
+    ++counts[key];
+  }
+  EXPECT_EQ(sketch.Total(), 20000);
+  // e / width of the total with probability 1 - exp(-depth) per key.
+  const double bound = std::exp(1.0) / 256 * sketch.Total();
+  size_t over = 0;
+  for (const auto& kv : counts) {
+    int64_t estimate = sketch.Estimate(kv.first);
+    ASSERT_GE(estimate, kv.second);
+    over += estimate - kv.second > bound ? 1 : 0;
+  }
+  EXPECT_LE(over, counts.size() / 20);
+}
+
+TEST(CountMinSketchTest, TakesBackRemovedCounts) {
+  CountMinSketch sketch(64, 3);
+  sketch.Add(7, 5);
+  sketch.Add(9);
+  sketch.Add(7, -2);
+  EXPECT_EQ(sketch.Estimate(7), 3);
+  EXPECT_EQ(sketch.Total(), 4);
+  sketch.Add(7, -3);
+  sketch.Add(9, -1);
+  EXPECT_EQ(sketch.Estimate(7), 0);
+  EXPECT_EQ(sketch.Estimate(9), 0);
+  sketch.Add(1);
+  sketch.Clear();
+  EXPECT_EQ(sketch.Estimate(1), 0);
+  EXPECT_EQ(sketch.Total(), 0);
+}
+
+TEST(CountMinSketchTest, KeepsAtLeastOneCounter) {
+  CountMinSketch sketch(0, 0);
+  sketch.Add(1);
+  sketch.Add(2);
+  // Everything shares the only counter.
+  EXPECT_EQ(sketch.Estimate(3), 2);
+}
+
+TEST(HyperLogLogTest, CountsSmallSetsAlmostExactly) {
+  HyperLogLog<> hll;
+  EXPECT_EQ(hll.Estimate(), 0u);
+  for (uint64_t i = 0; i < 100; ++i) {
+    hll.Add(i);
+    hll.Add(i);
+  }
+  // Linear counting, a standard error of about one item here.
+  EXPECT_NEAR(static_cast<double>(hll.Estimate()), 100.0, 4.0);
+  hll.Clear();
+  EXPECT_EQ(hll.Estimate(), 0u);
+}
+
+TEST(HyperLogLogTest, EstimatesLargeSetsWithinTheStandardError) {
+  HyperLogLog<> hll;
+  std::mt19937_64 rng(17);
+  const double n = 200000;
+  for (int i = 0; i < n; ++i) hll.Add(rng());
+  // Three standard errors of 1.04 / sqrt(4096).
+  EXPECT_NEAR(hll.Estimate() / n, 1.0, 3 * 1.04 / 64);
+
+  HyperLogLog<6> coarse;
+  for (uint64_t i = 0; i < 10000; ++i) coarse.Add(i);
+  EXPECT_NEAR(coarse.Estimate() / 10000.0, 1.0, 3 * 1.04 / 8);
+}
+
+TEST(HyperLogLogTest, MergesIntoTheUnion) {
+  HyperLogLog<> left, right, both;
+  for (uint64_t i = 0; i < 30000; ++i) {
+    (i % 2 ? left : right).Add(i);
+    // Overlap of a third.
+    if (i % 3 == 0) left.Add(i);
+    both.Add(i);
+  }
+  left.Merge(right);
+  EXPECT_EQ(left.Estimate(), both.Estimate());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
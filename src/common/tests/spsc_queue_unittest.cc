@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "common/async/spsc_queue.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+TEST(SpscQueueTest, KeepsValuesWhenFull) {
+  SpscQueue<std::unique_ptr<int>> queue(3);
+  EXPECT_EQ(queue.Capacity(), 4u);
+  EXPECT_TRUE(queue.Empty());
+  for (int i = 0; i < 4; ++i) {
+    auto value = std::make_unique<int>(i);
+    ASSERT_TRUE(queue.TryPush(value));
+    EXPECT_FALSE(value);
+  }
+  auto extra = std::make_unique<int>(4);
+  EXPECT_FALSE(queue.TryPush(extra));
+  ASSERT_TRUE(extra);
+  EXPECT_EQ(*extra, 4);
+
+  std::unique_ptr<int> out;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.TryPop(out));
+    EXPECT_EQ(*out, i);
+  }
+  EXPECT_FALSE(queue.TryPop(out));
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_TRUE(queue.TryPush(extra));
+}
+
+TEST(SpscQueueTest, PassesValuesInOrderBetweenThreads) {
+  constexpr uint64_t kValues = 200000;
+  SpscQueue<uint64_t> queue(64);
+  std::thread producer([&queue] {
+    for (uint64_t i = 1; i <= kValues; ++i) {
+      uint64_t value = i;
+      while (!queue.TryPush(value)) std::this_thread::yield();
+    }
+  });
+  uint64_t expected = 1;
+  uint64_t value = 0;
+  while (expected <= kValues) {
+    if (!queue.TryPop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(value, expected);
+    ++expected;
+  }
+  producer.join();
+  EXPECT_TRUE(queue.Empty());
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+
+#include "common/async/task.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+TEST(TaskTest, RunsContinuationsSetBeforeOrAfter) {
+  Promise<int> early;
+  Task<int> waiting = early.GetTask();
+  int seen = 0;
+  waiting.Then([&seen](const int& value) { seen = value; });
+  EXPECT_FALSE(waiting.Ready());
+  early.Set(7);
+  EXPECT_EQ(seen, 7);
+  EXPECT_TRUE(waiting.Ready());
+
+  Promise<std::string> late;
+  late.Set("done");
+  std::string text;
+  late.GetTask().Then([&text](const std::string& value) { text = value; });
+  EXPECT_EQ(text, "done");
+  EXPECT_EQ(late.GetTask().Get(), "done");
+}
+
+TEST(TaskTest, CompletesOnTheExecutor) {
+  Executor executor(2);
+  Promise<bool> start;
+  Task<std::thread::id> task = run_async(executor, [start] {
+    start.GetTask().Get();
+    return std::this_thread::get_id();
+  });
+  Promise<std::thread::id> next;
+  task.Then([next](const std::thread::id&) {
+    next.Set(std::this_thread::get_id());
+  });
+  start.Set(true);
+
+  // Continuations chained before completion run on the completing thread.
+  EXPECT_NE(task.Get(), std::this_thread::get_id());
+  EXPECT_EQ(next.GetTask().Get(), task.Get());
+}
+
+TEST(TaskTest, RetriesSharedRunsWhileAWriterHoldsTheLock) {
+  Executor executor(1);
+  std::shared_mutex mutex;
+  std::atomic<bool> ran{false};
+  std::unique_lock<std::shared_mutex> writer(mutex);
+  Task<bool> task = run_shared_async(
+      executor, mutex, [&ran](std::shared_lock<std::shared_mutex>& lock) {
+        ran = true;
+        return lock.owns_lock();
+      });
+
+  // The executor thread is not parked on the lock meanwhile.
+  Task<int> other = run_async(executor, [] { return 1; });
+  EXPECT_EQ(other.Get(), 1);
+  EXPECT_FALSE(ran);
+  EXPECT_FALSE(task.Ready());
+
+  writer.unlock();
+  EXPECT_TRUE(task.Get());
+  EXPECT_TRUE(ran);
+}
+
+TEST(TaskTest, ReleasesTheSharedLockBeforeContinuations) {
+  Executor executor(1);
+  std::shared_mutex mutex;
+  Task<int> task = run_shared_async(
+      executor, mutex, [](std::shared_lock<std::shared_mutex>&) { return 3; });
+  Promise<bool> exclusive;
+  task.Then([&mutex, exclusive](const int&) {
+    bool locked = mutex.try_lock();
+    if (locked) mutex.unlock();
+    exclusive.Set(locked);
+  });
+  EXPECT_TRUE(exclusive.GetTask().Get());
+  EXPECT_EQ(task.Get(), 3);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
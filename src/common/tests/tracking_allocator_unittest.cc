@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/memory/tracking_allocator.h"
+
+namespace hyperon {
+namespace common {
+namespace {
+
+template <MEMORY_KIND Kind>
+using TrackedVector = std::vector<uint64_t, TrackingAllocator<uint64_t, Kind>>;
+
+using Members = TrackedVector<MEM_MEMBERS>;
+using Lineage = TrackedSet<int, MEM_LINEAGE>;
+
+// Bytes of every kind but `kind`.
+uint64_t others(const MemoryAccount& account, MEMORY_KIND kind) {
+  return account.Total() - account.Bytes(kind);
+}
+
+TEST(TrackingAllocatorTest, ChargesAndReleasesByKind) {
+  MemoryAccountRef account = MemoryAccountRef::Create();
+  {
+    Members members{Members::allocator_type(account.get())};
+    members.reserve(100);
+    EXPECT_EQ(account->Bytes(MEM_MEMBERS), 800u);
+    Lineage lineage{Lineage::allocator_type(account.get())};
+    for (int i = 0; i < 50; ++i) lineage.insert(i);
+    uint64_t nodes = account->Bytes(MEM_LINEAGE);
+    EXPECT_GE(nodes, 50 * sizeof(int));
+    EXPECT_EQ(account->Total(), 800u + nodes);
+
+    members.clear();
+    members.shrink_to_fit();
+    EXPECT_EQ(account->Bytes(MEM_MEMBERS), 0u);
+    lineage.erase(lineage.begin(), lineage.find(25));
+    EXPECT_EQ(account->Bytes(MEM_LINEAGE), nodes / 2);
+    EXPECT_EQ(others(*account, MEM_LINEAGE), 0u);
+  }
+  EXPECT_EQ(account->Total(), 0u);
+}
+
+TEST(TrackingAllocatorTest, RollsChargesUpToTheParent) {
+  MemoryAccountRef parent = MemoryAccountRef::Create();
+  MemoryAccountRef first = MemoryAccountRef::Create(parent.get());
+  MemoryAccountRef second = MemoryAccountRef::Create(parent.get());
+  EXPECT_EQ(first->Parent(), parent.get());
+
+  Members a{Members::allocator_type(first.get())};
+  a.reserve(10);
+  TrackedVector<MEM_CONCEPTS> b{
+      TrackedVector<MEM_CONCEPTS>::allocator_type(second.get())};
+  b.reserve(20);
+  EXPECT_EQ(first->Total(), 80u);
+  EXPECT_EQ(second->Total(), 160u);
+  EXPECT_EQ(parent->Bytes(MEM_MEMBERS), 80u);
+  EXPECT_EQ(parent->Bytes(MEM_CONCEPTS), 160u);
+  EXPECT_EQ(parent->Total(), 240u);
+
+  // Accounts outlive their owners while containers still charge them.
+  first = MemoryAccountRef();
+  a.reserve(30);
+  EXPECT_EQ(parent->Bytes(MEM_MEMBERS), 240u);
+  a = Members();
+  EXPECT_EQ(parent->Bytes(MEM_MEMBERS), 0u);
+}
+
+TEST(TrackingAllocatorTest, KeepsTheAccountOfMovedAndCopiedContainers) {
+  MemoryAccountRef mine = MemoryAccountRef::Create();
+  MemoryAccountRef theirs = MemoryAccountRef::Create();
+  Members source{Members::allocator_type(mine.get())};
+  source.assign(10, 1);
+  ASSERT_EQ(mine->Bytes(MEM_MEMBERS), 80u);
+
+  // Moving takes the buffer and its account along.
+  Members moved(std::move(source));
+  EXPECT_EQ(moved.get_allocator().Account(), mine.get());
+  EXPECT_EQ(mine->Bytes(MEM_MEMBERS), 80u);
+
+  // A copy charges the account of the original too.
+  Members copy(moved);
+  EXPECT_EQ(copy.get_allocator().Account(), mine.get());
+  EXPECT_EQ(mine->Bytes(MEM_MEMBERS), 160u);
+
+  // Copy assignment keeps the account of the target...
+  Members target{Members::allocator_type(theirs.get())};
+  target = moved;
+  EXPECT_EQ(target.get_allocator().Account(), theirs.get());
+  EXPECT_EQ(theirs->Bytes(MEM_MEMBERS), 80u);
+  EXPECT_EQ(mine->Bytes(MEM_MEMBERS), 160u);
+
+  // ...move assignment adopts that of the source and frees the old buffer.
+  target = std::move(copy);
+  EXPECT_EQ(target.get_allocator().Account(), mine.get());
+  EXPECT_EQ(theirs->Bytes(MEM_MEMBERS), 0u);
+  EXPECT_EQ(mine->Bytes(MEM_MEMBERS), 160u);
+
+  // Swapping exchanges the accounts with the buffers.
+  Members other{Members::allocator_type(theirs.get())};
+  other.assign(4, 2);
+  other.swap(target);
+  EXPECT_EQ(other.get_allocator().Account(), mine.get());
+  EXPECT_EQ(target.get_allocator().Account(), theirs.get());
+  EXPECT_EQ(theirs->Bytes(MEM_MEMBERS), 32u);
+  EXPECT_EQ(mine->Bytes(MEM_MEMBERS), 160u);
+}
+
+TEST(TrackingAllocatorTest, RebindsContainersToAnotherAccount) {
+  MemoryAccountRef from = MemoryAccountRef::Create();
+  MemoryAccountRef to = MemoryAccountRef::Create();
+  TrackedMap<int, std::string, MEM_CATEGORY_MAPS> map{
+      TrackedMap<int, std::string, MEM_CATEGORY_MAPS>::allocator_type(
+          from.get())};
+  for (int i = 0; i < 20; ++i) map.emplace(i, std::to_string(i));
+  uint64_t bytes = from->Bytes(MEM_CATEGORY_MAPS);
+  ASSERT_GT(bytes, 0u);
+
+  rebind_container(map, to.get());
+  EXPECT_EQ(from->Total(), 0u);
+  EXPECT_EQ(to->Bytes(MEM_CATEGORY_MAPS), bytes);
+  EXPECT_EQ(map.size(), 20u);
+  EXPECT_EQ(map.at(7), "7");
+  // Already there, nothing moves.
+  rebind_container(map, to.get());
+  EXPECT_EQ(to->Bytes(MEM_CATEGORY_MAPS), bytes);
+}
+
+TEST(TrackingAllocatorTest, ChargesNothingWithoutAnAccount) {
+  Members plain;
+  plain.assign(100, 3);
+  EXPECT_EQ(plain.get_allocator().Account(), nullptr);
+  MemoryAccountRef account = MemoryAccountRef::Create();
+  rebind_container(plain, account.get());
+  // Rebuilt by appending, so with some spare capacity.
+  EXPECT_GE(account->Bytes(MEM_MEMBERS), 800u);
+  EXPECT_EQ(plain.size(), 100u);
+}
+
+}  // namespace
+}  // namespace common
+}  // namespace hyperon
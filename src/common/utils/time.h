@@ -0,0 +1,17 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace hyperon {
+namespace common {
+
+// Wall-clock milliseconds since epoch, as stored in hyperbase timestamps.
+inline uint64_t now_millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace common
+}  // namespace hyperon
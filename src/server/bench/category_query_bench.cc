@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/proto/wire_writer.h"
+#include "server/category_query.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+constexpr uint32_t kTypes = 100000;
+constexpr uint32_t kRequested = 1000;
+
+std::string type_name(uint32_t i) {
+  return "http://example.org/ontology/type/" + std::to_string(i);
+}
+
+// A tree of types with long names, fan-out 8, queried near the top.
+struct EncodeFixture {
+  base::HyperbasePtr hyperbase = std::make_shared<base::Hyperbase>("encode");
+  std::vector<std::string> names;
+
+  EncodeFixture() {
+    std::vector<base::Mutation> batch;
+    for (uint32_t i = 0; i < kTypes; ++i) {
+      base::Mutation mut;
+      mut.subject = type_name(i);
+      if (i > 0) mut.objects.push_back(type_name((i - 1) / 8));
+      batch.push_back(std::move(mut));
+    }
+    hyperbase->ApplyBatch(batch);
+    for (uint32_t i = 0; i < kRequested; ++i) names.push_back(type_name(i));
+  }
+};
+
+EncodeFixture& fixture() {
+  static EncodeFixture instance;
+  return instance;
+}
+
+// Records with packed dictionary indexes, as served by FetchConcepts.
+void BM_EncodeConceptsDictionary(benchmark::State& state) {
+  EncodeFixture& f = fixture();
+  ConceptFields fields;
+  fields.parents = true;
+  fields.children = true;
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    encode_concepts(*f.hyperbase, f.names, fields, out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.counters["bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_EncodeConceptsDictionary);
+
+// The same records with every name repeated as a string field, as repeated
+// string fields of generated messages would be.
+void BM_EncodeConceptsNames(benchmark::State& state) {
+  EncodeFixture& f = fixture();
+  std::string out;
+  std::vector<std::string> parents;
+  std::vector<std::string> children;
+  for (auto _ : state) {
+    out.clear();
+    common::ProtoWriter writer(out);
+    std::shared_lock<std::shared_mutex> lock(f.hyperbase->Mutex());
+    for (const auto& name : f.names) {
+      base::ConceptPtr cnpt;
+      if (!f.hyperbase->GetConcept(name, cnpt)) continue;
+      parents.clear();
+      children.clear();
+      cnpt->ForEachParent([&parents](const base::ElementPtr& parent) {
+        parents.push_back(parent->SemName());
+      });
+      cnpt->ForEachChild([&children](const base::ElementPtr& child) {
+        children.push_back(child->SemName());
+      });
+      common::ProtoWriter::Mark record = writer.Begin(5);
+      writer.String(1, cnpt->SemName());
+      for (const auto& parent : parents) writer.String(4, parent);
+      for (const auto& child : children) writer.String(5, child);
+      writer.End(record);
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  state.counters["bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_EncodeConceptsNames);
+
+void BM_EncodeCategoryPage(benchmark::State& state) {
+  EncodeFixture& f = fixture();
+  CategoryQuery query;
+  query.fields.parents = true;
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    std::string error;
+    encode_category(*f.hyperbase, query, out, error);
+    benchmark::DoNotOptimize(out);
+  }
+  state.counters["bytes"] = static_cast<double>(out.size());
+}
+BENCHMARK(BM_EncodeCategoryPage);
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/batch_query.h"
+#include "server/core_shards.h"
+#include "server/sharded_hyperbase.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+constexpr uint32_t kShards = 4;
+constexpr uint32_t kTypes = 20000;
+// Walks start from the upper levels of the tree.
+constexpr uint32_t kOrigins = 1000;
+
+std::string type_name(uint32_t i) { return "type " + std::to_string(i); }
+
+std::vector<base::Mutation> type_tree() {
+  std::vector<base::Mutation> batch;
+  for (uint32_t i = 0; i < kTypes; ++i) {
+    base::Mutation mut;
+    mut.subject = type_name(i);
+    if (i > 0) mut.objects.push_back(type_name((i - 1) / 4));
+    batch.push_back(std::move(mut));
+  }
+  return batch;
+}
+
+// The same tree in one hyperbase shared by all threads, sharded over an
+// executor, and sharded over pinned cores.
+struct ModeFixture {
+  base::HyperbasePtr shared = std::make_shared<base::Hyperbase>("shared");
+  std::unique_ptr<ShardedHyperbase> pooled;
+  std::unique_ptr<CoreShards> cores;
+  std::unique_ptr<ShardedHyperbase> per_core;
+
+  ModeFixture() {
+    std::vector<base::Mutation> batch = type_tree();
+    shared->ApplyBatch(batch);
+
+    std::vector<std::shared_ptr<ShardClient>> shards;
+    for (uint32_t i = 0; i < kShards; ++i) {
+      shards.push_back(std::make_shared<LocalShardClient>(
+          std::make_shared<base::Hyperbase>("pooled")));
+    }
+    pooled = std::make_unique<ShardedHyperbase>(
+        std::make_unique<ShardRouter>(kShards), shards);
+
+    CoreShards::Options options;
+    options.cores = kShards;
+    cores = std::make_unique<CoreShards>(options);
+    per_core = std::make_unique<ShardedHyperbase>(
+        std::make_unique<ShardRouter>(kShards), cores->Clients());
+
+    base::BatchResult result;
+    std::string error;
+    pooled->ApplyBatch(batch, result, error);
+    per_core->ApplyBatch(batch, result, error);
+  }
+};
+
+ModeFixture& fixture() {
+  static ModeFixture instance;
+  return instance;
+}
+
+void BM_LineageSharedMemory(benchmark::State& state) {
+  ModeFixture& f = fixture();
+  std::mt19937 rng(7 + state.thread_index());
+  std::vector<std::vector<std::string>> out;
+  for (auto _ : state) {
+    out.clear();
+    base::walk_lineage(*f.shared, {type_name(rng() % kOrigins)},
+                       base::LineageCursor::DESCENDANTS, 0, out);
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_LineageSharedMemory)->ThreadRange(1, 8)->UseRealTime();
+
+void run_sharded(ShardedHyperbase& sharded, benchmark::State& state) {
+  std::mt19937 rng(7 + state.thread_index());
+  std::vector<std::string> out;
+  std::string error;
+  for (auto _ : state) {
+    out.clear();
+    sharded.Lineage(type_name(rng() % kOrigins),
+                    base::LineageCursor::DESCENDANTS, out, error);
+    benchmark::DoNotOptimize(out);
+  }
+}
+
+void BM_LineageShardedPool(benchmark::State& state) {
+  run_sharded(*fixture().pooled, state);
+}
+BENCHMARK(BM_LineageShardedPool)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_LineageShardPerCore(benchmark::State& state) {
+  run_sharded(*fixture().per_core, state);
+}
+BENCHMARK(BM_LineageShardPerCore)->ThreadRange(1, 8)->UseRealTime();
+
+// Many walks in flight from one thread, continuations only.
+void BM_LineageShardPerCoreAsync(benchmark::State& state) {
+  ShardedHyperbase& sharded = *fixture().per_core;
+  std::mt19937 rng(7);
+  std::vector<common::Task<ShardedHyperbase::LineageReply>> tasks;
+  for (auto _ : state) {
+    tasks.clear();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      tasks.push_back(sharded.LineageAsync(type_name(rng() % kOrigins),
+                                           base::LineageCursor::DESCENDANTS));
+    }
+    for (const auto& task : tasks) benchmark::DoNotOptimize(task.Get());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LineageShardPerCoreAsync)->Arg(64)->UseRealTime();
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
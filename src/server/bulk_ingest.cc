@@ -0,0 +1,107 @@
+#include "server/bulk_ingest.h"
+
+#include <utility>
+
+#include "server/rpc_metrics.h"
+
+namespace hyperon {
+namespace server {
+
+BulkIngestor::BulkIngestor(const base::HyperbasePtr& hyperbase,
+                           AckCallback on_ack, size_t batch_size,
+                           uint32_t window)
+    : mHyperbase(hyperbase),
+      mOnAck(std::move(on_ack)),
+      mBatchSize(batch_size > 0 ? batch_size : 1),
+      mWindow(window > 0 ? window : 1) {
+  mCurrent.reserve(mBatchSize);
+  mApplier = std::thread(&BulkIngestor::RunApplier, this);
+}
+
+BulkIngestor::~BulkIngestor() {
+  Finish();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosing = true;
+  }
+  mQueueCv.notify_all();
+  if (mApplier.joinable()) mApplier.join();
+}
+
+void BulkIngestor::Push(base::Mutation&& mut, uint64_t client_seq) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCurrent.push_back(std::move(mut));
+  mCurrentSeq = client_seq;
+  if (mCurrent.size() >= mBatchSize) SealLocked(lock);
+}
+
+void BulkIngestor::Finish() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  if (!mCurrent.empty()) SealLocked(lock);
+  mSpaceCv.wait(lock, [this] { return mQueue.empty() && !mApplying; });
+}
+
+uint32_t BulkIngestor::Credits() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mWindow - static_cast<uint32_t>(mQueue.size());
+}
+
+uint64_t BulkIngestor::TotalApplied() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mTotalApplied;
+}
+
+uint64_t BulkIngestor::TotalFailed() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mTotalFailed;
+}
+
+void BulkIngestor::SealLocked(std::unique_lock<std::mutex>& lock) {
+  mSpaceCv.wait(lock, [this] { return mQueue.size() < mWindow; });
+  mQueue.push_back(
+      SealedBatch{mNextBatchId++, mCurrentSeq, std::move(mCurrent)});
+  mCurrent = std::vector<base::Mutation>();
+  mCurrent.reserve(mBatchSize);
+  mQueueCv.notify_one();
+}
+
+void BulkIngestor::RunApplier() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (true) {
+    mQueueCv.wait(lock, [this] { return mClosing || !mQueue.empty(); });
+    if (mQueue.empty()) return;
+
+    SealedBatch batch = std::move(mQueue.front());
+    mQueue.pop_front();
+    mApplying = true;
+    mSpaceCv.notify_all();
+    lock.unlock();
+
+    // One BulkIngest call per batch, from apply to delivered ack.
+    RpcScope scope(RPC_BULK_INGEST);
+    base::BatchResult result = mHyperbase->ApplyBatch(batch.mutations);
+
+    IngestAck ack;
+    ack.batch_id = batch.batch_id;
+    ack.applied = result.applied;
+    ack.failed = result.failed;
+    ack.last_client_seq = batch.last_client_seq;
+    ack.version = result.version;
+
+    lock.lock();
+    mTotalApplied += result.applied;
+    mTotalFailed += result.failed;
+    ack.credits = mWindow - static_cast<uint32_t>(mQueue.size());
+    if (mOnAck) {
+      lock.unlock();
+      mOnAck(ack);
+      lock.lock();
+    }
+    // Only now may Finish() return: the last ack has been delivered.
+    mApplying = false;
+    mSpaceCv.notify_all();
+  }
+}
+
+}  // namespace server
+}  // namespace hyperon
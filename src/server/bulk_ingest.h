@@ -0,0 +1,119 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/core/mutation.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Per-batch acknowledgement of the BulkIngest stream, mirrors
+ * api.v1.BulkIngestAck.
+ */
+struct IngestAck {
+  uint64_t batch_id{0};
+  uint64_t applied{0};
+  uint64_t failed{0};
+  // Highest client sequence number covered by this batch.
+  uint64_t last_client_seq{0};
+  // Hyperbase version once the batch became visible.
+  uint64_t version{0};
+  // Number of batches the client may still send before waiting for an ack.
+  uint32_t credits{0};
+};
+
+/**
+ * @brief Server side of the client-streaming BulkIngest RPC.
+ *
+ * The stream handler pushes decoded mutations one by one. They are grouped
+ * into batches of `batch_size` and handed over to a dedicated applier thread,
+ * which commits each batch with Hyperbase::ApplyBatch, i.e. one exclusive lock
+ * and one version bump per batch. Decoding of the next batch thus overlaps
+ * with applying the previous one.
+ *
+ * At most `window` sealed batches may wait for the applier. Push() blocks
+ * while the window is full, which stops reading from the stream and lets
+ * gRPC flow control push back on the client. Every ack carries the remaining
+ * credits so well-behaved clients can pace themselves without stalling.
+ */
+class BulkIngestor {
+public:
+  using AckCallback = std::function<void(const IngestAck&)>;
+
+  static constexpr size_t kDefaultBatchSize = 8192;
+  static constexpr uint32_t kDefaultWindow = 4;
+
+  BulkIngestor(const base::HyperbasePtr& hyperbase, AckCallback on_ack,
+               size_t batch_size = kDefaultBatchSize,
+               uint32_t window = kDefaultWindow);
+  ~BulkIngestor();
+
+  BulkIngestor(const BulkIngestor&) = delete;
+  BulkIngestor& operator=(const BulkIngestor&) = delete;
+
+  /**
+   * @brief Add a decoded mutation to the current batch. Blocks while the
+   * window of sealed batches is full.
+   *
+   * @param mut Mutation decoded from the stream
+   * @param client_seq Client-assigned sequence number of the mutation
+   */
+  void Push(base::Mutation&& mut, uint64_t client_seq);
+
+  /**
+   * @brief Seal the partial batch, if any, and wait until every batch has
+   * been applied and acknowledged. Called when the client half-closes.
+   */
+  void Finish();
+
+  /**
+   * @brief Number of batches the client may send without waiting.
+   */
+  uint32_t Credits() const;
+
+  uint64_t TotalApplied() const;
+  uint64_t TotalFailed() const;
+
+private:
+  struct SealedBatch {
+    uint64_t batch_id;
+    uint64_t last_client_seq;
+    std::vector<base::Mutation> mutations;
+  };
+
+  // Move the current batch to the queue. Caller holds mMutex.
+  void SealLocked(std::unique_lock<std::mutex>& lock);
+  void RunApplier();
+
+  base::HyperbasePtr mHyperbase;
+  AckCallback mOnAck;
+  const size_t mBatchSize;
+  const uint32_t mWindow;
+
+  // Current batch being filled by the stream handler.
+  std::vector<base::Mutation> mCurrent;
+  uint64_t mCurrentSeq{0};
+  uint64_t mNextBatchId{1};
+
+  mutable std::mutex mMutex;
+  std::condition_variable mQueueCv;
+  std::condition_variable mSpaceCv;
+  std::deque<SealedBatch> mQueue;
+  bool mApplying{false};
+  bool mClosing{false};
+
+  uint64_t mTotalApplied{0};
+  uint64_t mTotalFailed{0};
+  std::thread mApplier;
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,338 @@
+#include "server/category_query.h"
+
+#include <fmt/core.h>
+
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/core/category.h"
+#include "base/core/relation.h"
+#include "base/storage/mutation_codec.h"
+#include "common/proto/wire_writer.h"
+#include "server/rpc_metrics.h"
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+using common::ProtoWriter;
+
+// Field numbers of hyperbase.proto. Both responses start with the same
+// four fields.
+enum RESPONSE_FIELD {
+  RESPONSE_VERSION = 3,
+  RESPONSE_DICTIONARY = 4,
+  CONCEPTS_RECORDS = 5,
+  CONCEPTS_MISSING = 6,
+  CATEGORY_NAME = 5,
+  CATEGORY_ENCLOSED = 6,
+  CATEGORY_LOCAL = 7,
+  CATEGORY_TOTAL = 8,
+  CATEGORY_RECORDS = 9,
+  CATEGORY_NEXT = 10,
+};
+
+enum RECORD_FIELD {
+  RECORD_NAME = 1,
+  RECORD_KIND = 2,
+  RECORD_CATEGORY = 3,
+  RECORD_PARENTS = 4,
+  RECORD_CHILDREN = 5,
+  RECORD_MEMBERS = 6,
+  RECORD_REPRESENTATIONS = 7,
+};
+
+/**
+ * @brief Names referenced by a response, indexed in order of first use.
+ * Concept names are referenced in place, so the dictionary must be written
+ * before the lock is released.
+ *
+ * Elements are looked up by dense id in an open-addressing table, as most
+ * references of a response are to distinct concepts and a node-based map
+ * would allocate for each.
+ */
+class NameDictionary {
+public:
+  NameDictionary() : mSlots(kInitialSlots) {}
+
+  uint32_t Of(const base::Element& element) {
+    uint32_t id = element.DenseId();
+    size_t slot = Find(id);
+    if (mSlots[slot].index != kEmpty) return mSlots[slot].index;
+    const std::string* name;
+    if (element.IsConcept()) {
+      name = &static_cast<const base::Concept&>(element).SemNameRef();
+    } else {
+      mOwned.push_back(element.SemName());
+      name = &mOwned.back();
+    }
+    mSlots[slot] = {id, Add(name)};
+    if (mNames.size() * 2 > mSlots.size()) Grow();
+    return mSlots[slot].index;
+  }
+
+  uint32_t Of(const base::Category& category) {
+    for (const auto& known : mCategories) {
+      if (known.first == &category) return known.second;
+    }
+    mOwned.push_back(category.Name());
+    uint32_t index = Add(&mOwned.back());
+    mCategories.emplace_back(&category, index);
+    return index;
+  }
+
+  // A name outside the hyperbase, e.g. of a request, which must outlive
+  // the dictionary.
+  uint32_t Of(const std::string& name) {
+    auto known = mOthers.find(name);
+    if (known != mOthers.end()) return known->second;
+    uint32_t index = Add(&name);
+    mOthers.emplace(name, index);
+    return index;
+  }
+
+  void Write(ProtoWriter& writer) const {
+    if (mNames.empty()) return;
+    ProtoWriter::Mark mark = writer.Begin(RESPONSE_DICTIONARY);
+    for (const std::string* name : mNames) writer.String(1, *name);
+    writer.End(mark);
+  }
+
+private:
+  static constexpr size_t kInitialSlots = 256;
+  static constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+
+  struct Slot {
+    uint32_t id{0};
+    uint32_t index{kEmpty};
+  };
+
+  inline uint32_t Add(const std::string* name) {
+    mNames.push_back(name);
+    return static_cast<uint32_t>(mNames.size() - 1);
+  }
+
+  // Slot holding `id`, or the empty slot to put it in.
+  size_t Find(uint32_t id) const {
+    size_t mask = mSlots.size() - 1;
+    size_t slot = (id * 0x9e3779b1u) & mask;
+    while (mSlots[slot].index != kEmpty && mSlots[slot].id != id) {
+      slot = (slot + 1) & mask;
+    }
+    return slot;
+  }
+
+  void Grow() {
+    std::vector<Slot> slots(mSlots.size() * 2);
+    slots.swap(mSlots);
+    for (const auto& slot : slots) {
+      if (slot.index != kEmpty) mSlots[Find(slot.id)] = slot;
+    }
+  }
+
+  std::vector<Slot> mSlots;
+  std::vector<const std::string*> mNames;
+  // Few per response, searched linearly.
+  std::vector<std::pair<const base::Category*, uint32_t>> mCategories;
+  // Names that are not stored as strings, e.g. of categories.
+  std::deque<std::string> mOwned;
+  // Indexes of the names outside the hyperbase, by the names themselves.
+  std::unordered_map<std::string_view, uint32_t> mOthers;
+};
+
+void write_record(ProtoWriter& writer, uint32_t field,
+                  NameDictionary& dictionary, const base::ConceptPtr& cnpt,
+                  const base::CategoryPtr& root, const ConceptFields& fields) {
+  ProtoWriter::Mark record = writer.Begin(field);
+  writer.Varint(RECORD_NAME, dictionary.Of(*cnpt));
+  base::Mutation::CONCEPT_KIND kind = base::concept_kind_of(cnpt);
+  if (kind != base::Mutation::KIND_CONCEPT) writer.Varint(RECORD_KIND, kind);
+  base::CategoryPtr category = cnpt->GetCategory();
+  if (category && category != root) {
+    writer.Varint(RECORD_CATEGORY, dictionary.Of(*category));
+  }
+
+  auto pack = [&writer, &dictionary](const base::ElementPtr& element) {
+    writer.Packed(dictionary.Of(*element));
+  };
+  if (fields.parents) {
+    ProtoWriter::Mark parents = writer.Begin(RECORD_PARENTS);
+    cnpt->ForEachParent(pack);
+    writer.End(parents, false);
+  }
+  if (fields.children) {
+    ProtoWriter::Mark children = writer.Begin(RECORD_CHILDREN);
+    cnpt->ForEachChild(pack);
+    writer.End(children, false);
+  }
+  if (fields.members && cnpt->IsRelation()) {
+    ProtoWriter::Mark members = writer.Begin(RECORD_MEMBERS);
+    std::static_pointer_cast<base::Relation>(cnpt)->ForEachMember(
+        [&writer, &dictionary](const base::ConceptPtr& member) {
+          writer.Packed(dictionary.Of(*member));
+        });
+    writer.End(members, false);
+  }
+  if (fields.representations && cnpt->ReprCount() > 0) {
+    for (int modal = base::ConceptRepr::MODAL_NATLANG;
+         modal <= base::ConceptRepr::MODAL_GUILE_E; ++modal) {
+      auto reprs =
+          cnpt->GetRepr(static_cast<base::ConceptRepr::REPR_MODAL>(modal));
+      for (const auto& repr : reprs) {
+        ProtoWriter::Mark mark = writer.Begin(RECORD_REPRESENTATIONS);
+        if (modal != 0) writer.Varint(1, modal);
+        std::string_view text = repr->View();
+        if (!text.empty()) writer.String(2, text.data(), text.size());
+        writer.End(mark);
+      }
+    }
+  }
+  writer.End(record);
+}
+
+void write_counts(ProtoWriter& writer, uint32_t field,
+                  const base::CategoryStatistics& stats) {
+  ProtoWriter::Mark mark = writer.Begin(field);
+  const uint64_t counts[] = {stats.categories, stats.concepts,
+                             stats.entities,   stats.relations,
+                             stats.roles,      stats.contexts};
+  for (uint32_t i = 0; i < 6; ++i) {
+    if (counts[i] > 0) writer.Varint(i + 1, counts[i]);
+  }
+  writer.End(mark);
+}
+
+size_t encode_concepts_locked(const base::Hyperbase& hyperbase,
+                              const std::vector<std::string>& names,
+                              const ConceptFields& fields, std::string& out) {
+  RpcScope scope(RPC_FETCH_CONCEPTS);
+  ProtoWriter writer(out);
+  NameDictionary dictionary;
+  std::vector<uint32_t> missing;
+  size_t found = 0;
+
+  base::CategoryPtr root = hyperbase.RootCategory();
+  if (hyperbase.Version() > 0) {
+    writer.Varint(RESPONSE_VERSION, hyperbase.Version());
+  }
+  for (const auto& name : names) {
+    base::ConceptPtr cnpt;
+    if (!hyperbase.GetConcept(name, cnpt)) {
+      missing.push_back(dictionary.Of(name));
+      continue;
+    }
+    write_record(writer, CONCEPTS_RECORDS, dictionary, cnpt, root, fields);
+    ++found;
+  }
+  ProtoWriter::Mark mark = writer.Begin(CONCEPTS_MISSING);
+  for (uint32_t index : missing) writer.Packed(index);
+  writer.End(mark, false);
+  dictionary.Write(writer);
+  return found;
+}
+
+bool encode_category_locked(const base::Hyperbase& hyperbase,
+                            const CategoryQuery& query, std::string& out,
+                            std::string& error) {
+  RpcScope scope(RPC_FETCH_CATEGORY);
+  base::CategoryPtr root = hyperbase.RootCategory();
+  base::CategoryPtr category = root;
+  if (!query.category.empty()) {
+    root->GetEnclosedCategory(query.category, category);
+  }
+  if (!category) {
+    scope.Fail();
+    error = fmt::format("unknown category '{}'", query.category);
+    return false;
+  }
+
+  ProtoWriter writer(out);
+  NameDictionary dictionary;
+  if (hyperbase.Version() > 0) {
+    writer.Varint(RESPONSE_VERSION, hyperbase.Version());
+  }
+  writer.String(CATEGORY_NAME, category->Name());
+  category->ForEachEnclosedCategory(
+      [&writer](const base::CategoryPtr& enclosed) {
+        writer.String(CATEGORY_ENCLOSED, enclosed->Name());
+      });
+  write_counts(writer, CATEGORY_LOCAL, category->LocalStatistics());
+  write_counts(writer, CATEGORY_TOTAL, category->TotalStatistics());
+
+  uint32_t limit = query.limit > 0 ? query.limit : kDefaultCategoryPage;
+  uint32_t listed = 0;
+  const std::string* last = nullptr;
+  bool more = false;
+  category->ForEachConceptAfter(
+      query.after, [&](const base::ConceptPtr& cnpt) {
+        if (listed == limit) {
+          more = true;
+          return false;
+        }
+        write_record(writer, CATEGORY_RECORDS, dictionary, cnpt, root,
+                     query.fields);
+        last = &cnpt->SemNameRef();
+        ++listed;
+        return true;
+      });
+  if (more) writer.String(CATEGORY_NEXT, *last);
+  dictionary.Write(writer);
+  return true;
+}
+
+}  // namespace
+
+size_t encode_concepts(const base::Hyperbase& hyperbase,
+                       const std::vector<std::string>& names,
+                       const ConceptFields& fields, std::string& out) {
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  return encode_concepts_locked(hyperbase, names, fields, out);
+}
+
+bool encode_category(const base::Hyperbase& hyperbase,
+                     const CategoryQuery& query, std::string& out,
+                     std::string& error) {
+  std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+  return encode_category_locked(hyperbase, query, out, error);
+}
+
+common::Task<EncodeReply> encode_concepts_async(
+    base::HyperbasePtr hyperbase, std::vector<std::string> names,
+    ConceptFields fields, common::Executor& executor) {
+  std::shared_mutex& mutex = hyperbase->Mutex();
+  return common::run_shared_async(
+      executor, mutex,
+      [hyperbase = std::move(hyperbase), names = std::move(names),
+       fields](std::shared_lock<std::shared_mutex>&) {
+        EncodeReply reply;
+        reply.found =
+            encode_concepts_locked(*hyperbase, names, fields, reply.out);
+        reply.ok = true;
+        return reply;
+      });
+}
+
+common::Task<EncodeReply> encode_category_async(
+    base::HyperbasePtr hyperbase, CategoryQuery query,
+    common::Executor& executor) {
+  std::shared_mutex& mutex = hyperbase->Mutex();
+  return common::run_shared_async(
+      executor, mutex,
+      [hyperbase = std::move(hyperbase), query = std::move(query)](
+          std::shared_lock<std::shared_mutex>&) {
+        EncodeReply reply;
+        reply.ok =
+            encode_category_locked(*hyperbase, query, reply.out, reply.error);
+        return reply;
+      });
+}
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/async/task.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Parts of concept records to fill in besides names and kinds,
+ * mirrors api.v1.ConceptFields.
+ */
+struct ConceptFields {
+  bool parents{false};
+  bool children{false};
+  bool members{false};
+  bool representations{false};
+};
+
+/**
+ * @brief A page of a category of the FetchCategory RPC, mirrors
+ * api.v1.CategoryRequest.
+ */
+struct CategoryQuery {
+  // Enclosed category of the root, the root category itself if empty.
+  std::string category;
+  // Concepts per page, kDefaultCategoryPage if 0.
+  uint32_t limit{0};
+  // Resume after this concept, empty for the first page.
+  std::string after;
+  ConceptFields fields;
+};
+
+constexpr uint32_t kDefaultCategoryPage = 1000;
+
+/*
+ * The handlers below encode their response in the protobuf wire format
+ * straight from the hyperbase under its shared lock, appending it to `out`
+ * for the transport to send as is. Names are written once into the
+ * dictionary of the response and referenced by index everywhere else. A
+ * successful response leaves response_code and message unset.
+ */
+
+/**
+ * @brief Handler of the FetchConcepts RPC, encodes an api.v1.ConceptResponse
+ * with the records of `names` in request order.
+ *
+ * @return size_t Number of names found
+ */
+size_t encode_concepts(const base::Hyperbase& hyperbase,
+                       const std::vector<std::string>& names,
+                       const ConceptFields& fields, std::string& out);
+
+/**
+ * @brief Handler of the FetchCategory RPC, encodes an api.v1.CategoryResponse
+ * with the counts of the category and a page of its concepts.
+ *
+ * @return false if the category is unknown, nothing is appended then.
+ */
+bool encode_category(const base::Hyperbase& hyperbase,
+                     const CategoryQuery& query, std::string& out,
+                     std::string& error);
+
+/**
+ * @brief Outcome of the asynchronous handlers, with the results of the
+ * matching synchronous ones.
+ */
+struct EncodeReply {
+  bool ok{false};
+  std::string error;
+  // Names found by encode_concepts_async(), 0 for categories.
+  size_t found{0};
+  std::string out;
+};
+
+/*
+ * The handlers on an executor, for transports completing calls from
+ * continuations. While a batch is being applied they are posted again
+ * rather than waiting for the lock, see common::run_shared_async().
+ */
+
+common::Task<EncodeReply> encode_concepts_async(
+    base::HyperbasePtr hyperbase, std::vector<std::string> names,
+    ConceptFields fields,
+    common::Executor& executor = common::Executor::Default());
+
+common::Task<EncodeReply> encode_category_async(
+    base::HyperbasePtr hyperbase, CategoryQuery query,
+    common::Executor& executor = common::Executor::Default());
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,307 @@
+#include "server/core_shards.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <shared_mutex>
+#include <utility>
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+// Rounds of polling an idle core makes before it sleeps.
+constexpr uint32_t kIdleRounds = 256;
+
+// Group and index of the core running on this thread, if any.
+thread_local const CoreShards* tGroup = nullptr;
+thread_local size_t tCore = 0;
+
+// CPUs the process may run on, in order.
+std::vector<int> allowed_cpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+  }
+#endif
+  return cpus;
+}
+
+void pin_thread(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+}  // namespace
+
+CoreShards::CoreShards(const Options& options) : mOptions(options) {
+  std::vector<int> cpus = allowed_cpus();
+  size_t count = options.cores;
+  if (count == 0) {
+    count = !cpus.empty() ? cpus.size()
+                          : std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < count; ++i) {
+    auto core = std::make_unique<Core>();
+    core->inbox = std::vector<std::atomic<common::SpscQueue<Message>*>>(count);
+    core->pending.resize(count);
+    mCores.push_back(std::move(core));
+    mClients.push_back(std::make_shared<CoreShardClient>(*this, i));
+  }
+  for (size_t i = 0; i < count; ++i) {
+    int cpu = options.pin && !cpus.empty() ? cpus[i % cpus.size()] : -1;
+    mCores[i]->thread = std::thread(&CoreShards::Run, this, i, cpu);
+  }
+  std::unique_lock<std::mutex> lock(mStartMutex);
+  mStarted.wait(lock, [this] { return mReady == mCores.size(); });
+}
+
+CoreShards::~CoreShards() {
+  mStopping.store(true);
+  for (auto& core : mCores) {
+    std::lock_guard<std::mutex> lock(core->mutex);
+    core->wake.notify_one();
+  }
+  for (auto& core : mCores) core->thread.join();
+  for (auto& core : mCores) {
+    for (auto& queue : core->inbox) delete queue.load();
+  }
+}
+
+void CoreShards::Send(size_t core, std::function<void()> fn) {
+  Core& to = *mCores[core];
+  if (tGroup != this) {
+    std::lock_guard<std::mutex> lock(to.mutex);
+    to.ingress.push_back(std::move(fn));
+    to.incoming.store(true, std::memory_order_release);
+    if (to.sleeping.load()) {
+      to.sleeping.store(false);
+      to.wake.notify_one();
+    }
+    return;
+  }
+  if (core == tCore) {
+    to.local.push_back(std::move(fn));
+    return;
+  }
+  // Buffered messages go first to keep the order.
+  auto& pending = mCores[tCore]->pending[core];
+  if (!pending.empty() || !Inbox(core, tCore).TryPush(fn)) {
+    pending.push_back(std::move(fn));
+    return;
+  }
+  Wake(to);
+}
+
+common::SpscQueue<CoreShards::Message>& CoreShards::Inbox(size_t to,
+                                                          size_t from) {
+  auto& slot = mCores[to]->inbox[from];
+  common::SpscQueue<Message>* queue = slot.load(std::memory_order_acquire);
+  if (!queue) {
+    queue = new common::SpscQueue<Message>(mOptions.queue_capacity);
+    slot.store(queue, std::memory_order_release);
+  }
+  return *queue;
+}
+
+void CoreShards::Run(size_t index, int cpu) {
+  tGroup = this;
+  tCore = index;
+  if (cpu >= 0) pin_thread(cpu);
+  Core& core = *mCores[index];
+  // Allocated on this core, see the class comment.
+  core.hyperbase =
+      std::make_shared<base::Hyperbase>(mOptions.name, mOptions.owner);
+  {
+    std::lock_guard<std::mutex> lock(mStartMutex);
+    ++mReady;
+  }
+  mStarted.notify_all();
+
+  uint32_t idle = 0;
+  while (true) {
+    bool buffered = Flush(index);
+    if (Drain(core) > 0 || buffered) {
+      idle = 0;
+      continue;
+    }
+    if (++idle < kIdleRounds) {
+      std::this_thread::yield();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(core.mutex);
+    core.sleeping.store(true);
+    // Pairs with the fence in Wake(): a sender either sees this core
+    // sleeping or its message is seen below.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!Waiting(core)) {
+      if (mStopping.load()) break;
+      core.wake.wait(lock, [this, &core] {
+        return !core.sleeping.load() || mStopping.load();
+      });
+    }
+    core.sleeping.store(false);
+    idle = 0;
+  }
+}
+
+size_t CoreShards::Drain(Core& core) {
+  size_t ran = 0;
+  // Set with the mutex held after the messages are added, so a message
+  // missed here is seen by Waiting() before the core sleeps.
+  if (core.incoming.load(std::memory_order_acquire)) {
+    std::deque<Message> ingress;
+    {
+      std::lock_guard<std::mutex> lock(core.mutex);
+      core.incoming.store(false, std::memory_order_relaxed);
+      ingress.swap(core.ingress);
+    }
+    for (auto& fn : ingress) {
+      fn();
+      ++ran;
+    }
+  }
+  // At most a queue's worth from each sender, to stay fair to the others.
+  Message fn;
+  for (auto& slot : core.inbox) {
+    common::SpscQueue<Message>* queue = slot.load(std::memory_order_acquire);
+    if (!queue) continue;
+    for (size_t i = 0; i < queue->Capacity() && queue->TryPop(fn); ++i) {
+      fn();
+      ++ran;
+    }
+  }
+  for (size_t i = core.local.size(); i > 0; --i) {
+    fn = std::move(core.local.front());
+    core.local.pop_front();
+    fn();
+    ++ran;
+  }
+  return ran;
+}
+
+bool CoreShards::Flush(size_t from) {
+  bool remain = false;
+  auto& pending = mCores[from]->pending;
+  for (size_t to = 0; to < pending.size(); ++to) {
+    if (pending[to].empty()) continue;
+    auto& queue = Inbox(to, from);
+    bool pushed = false;
+    while (!pending[to].empty() && queue.TryPush(pending[to].front())) {
+      pending[to].pop_front();
+      pushed = true;
+    }
+    if (pushed) Wake(*mCores[to]);
+    remain = remain || !pending[to].empty();
+  }
+  return remain;
+}
+
+bool CoreShards::Waiting(const Core& core) const {
+  if (!core.ingress.empty() || !core.local.empty()) return true;
+  for (const auto& slot : core.inbox) {
+    const common::SpscQueue<Message>* queue =
+        slot.load(std::memory_order_acquire);
+    if (queue && !queue->Empty()) return true;
+  }
+  return false;
+}
+
+void CoreShards::Wake(Core& core) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!core.sleeping.load()) return;
+  std::lock_guard<std::mutex> lock(core.mutex);
+  core.sleeping.store(false);
+  core.wake.notify_one();
+}
+
+common::Task<ApplyReply> CoreShardClient::ApplyAsync(ShardBatch batch) {
+  common::Promise<ApplyReply> promise;
+  common::Task<ApplyReply> task = promise.GetTask();
+  mGroup.Send(mCore, [this, promise, batch = std::move(batch)] {
+    ApplyReply reply;
+    reply.ok = true;
+    reply.result =
+        apply_shard_batch(*mGroup.Hyperbase(mCore), batch, &reply.failed);
+    promise.Set(std::move(reply));
+  });
+  return task;
+}
+
+common::Task<AdjacencyReply> CoreShardClient::FetchAdjacencyAsync(
+    std::vector<std::string> names,
+    base::LineageCursor::DIRECTION direction) {
+  common::Promise<AdjacencyReply> promise;
+  common::Task<AdjacencyReply> task = promise.GetTask();
+  mGroup.Send(mCore, [this, promise, names = std::move(names), direction] {
+    AdjacencyReply reply;
+    reply.ok = true;
+    fetch_adjacency(*mGroup.Hyperbase(mCore), names, direction,
+                    reply.adjacency);
+    promise.Set(std::move(reply));
+  });
+  return task;
+}
+
+common::Task<ContainsReply> CoreShardClient::HasConceptAsync(
+    std::string name) {
+  common::Promise<ContainsReply> promise;
+  common::Task<ContainsReply> task = promise.GetTask();
+  mGroup.Send(mCore, [this, promise, name = std::move(name)] {
+    const base::Hyperbase& hyperbase = *mGroup.Hyperbase(mCore);
+    ContainsReply reply;
+    reply.ok = true;
+    {
+      std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+      reply.found = hyperbase.HasConcept(name);
+    }
+    promise.Set(std::move(reply));
+  });
+  return task;
+}
+
+bool CoreShardClient::Apply(const ShardBatch& batch,
+                            base::BatchResult& result,
+                            std::vector<uint32_t>& failed, std::string& error) {
+  common::Task<ApplyReply> task = ApplyAsync(batch);
+  const ApplyReply& reply = task.Get();
+  result = reply.result;
+  failed.insert(failed.end(), reply.failed.begin(), reply.failed.end());
+  if (!reply.ok) error = reply.error;
+  return reply.ok;
+}
+
+bool CoreShardClient::FetchAdjacency(
+    const std::vector<std::string>& names,
+    base::LineageCursor::DIRECTION direction,
+    std::vector<std::vector<std::string>>& adjacency, std::string& error) {
+  common::Task<AdjacencyReply> task = FetchAdjacencyAsync(names, direction);
+  const AdjacencyReply& reply = task.Get();
+  adjacency = reply.adjacency;
+  if (!reply.ok) error = reply.error;
+  return reply.ok;
+}
+
+bool CoreShardClient::HasConcept(const std::string& name, bool& found,
+                                 std::string& error) {
+  common::Task<ContainsReply> task = HasConceptAsync(name);
+  const ContainsReply& reply = task.Get();
+  found = reply.found;
+  if (!reply.ok) error = reply.error;
+  return reply.ok;
+}
+
+}  // namespace server
+}  // namespace hyperon
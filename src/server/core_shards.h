@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "common/async/spsc_queue.h"
+#include "server/shard_client.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Shared-nothing execution of a sharded hyperbase: one thread per
+ * core, each owning the hyperbase of one shard.
+ *
+ * Work on a shard only ever runs on its core, as messages: closures passed
+ * over a lock-free SPSC queue for every pair of cores that talk, created by
+ * the sender on its first message, or over a locked queue per core for
+ * threads outside the group. A lineage walk through
+ * ShardedHyperbase sends one message per shard and level holding the whole
+ * frontier part owned by it, and its continuations run on the core
+ * completing a level, so the next level is sent core to core. A core
+ * spins on its queues for a while when idle, then sleeps until a message
+ * arrives.
+ *
+ * Threads are pinned to the cores the process may run on, in order. Each
+ * shard hyperbase is created and written on its core, so that with the
+ * first-touch policy of Linux its memory is allocated on the core's NUMA
+ * node.
+ *
+ * Use Clients() as the shards of a ShardedHyperbase. Their synchronous
+ * calls must not be made from the core threads, and the group must outlive
+ * every pending call.
+ */
+class CoreShards {
+public:
+  struct Options {
+    // Cores, all the process may run on if 0.
+    uint32_t cores{0};
+    bool pin{true};
+    // Messages in flight from one core to another before the sender
+    // buffers them.
+    size_t queue_capacity{1024};
+    // Name and owner of the shard hyperbases.
+    std::string name{"sharded"};
+    std::string owner;
+  };
+
+  explicit CoreShards(const Options& options);
+  // Joins the cores, no call may be pending.
+  ~CoreShards();
+
+  CoreShards(const CoreShards&) = delete;
+  CoreShards& operator=(const CoreShards&) = delete;
+
+  inline size_t Size() const { return mCores.size(); }
+
+  inline const std::vector<std::shared_ptr<ShardClient>>& Clients() const {
+    return mClients;
+  }
+
+  // Hyperbase of a shard, to be written on its core only.
+  inline const base::HyperbasePtr& Hyperbase(size_t core) const {
+    return mCores[core]->hyperbase;
+  }
+
+  // Run `fn` on `core`. Messages from one thread run in order.
+  void Send(size_t core, std::function<void()> fn);
+
+private:
+  using Message = std::function<void()>;
+
+  struct alignas(common::kCacheLine) Core {
+    base::HyperbasePtr hyperbase;
+    // Messages by sending core, created by the sender, never to itself.
+    std::vector<std::atomic<common::SpscQueue<Message>*>> inbox;
+    // Messages this core sent to itself.
+    std::deque<Message> local;
+    // Messages this core could not push yet, by receiving core.
+    std::vector<std::deque<Message>> pending;
+
+    // Guards the messages of other threads and sleeping.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Message> ingress;
+    // Whether `ingress` may hold messages, so that polls skip the mutex.
+    std::atomic<bool> incoming{false};
+    std::atomic<bool> sleeping{false};
+    std::thread thread;
+  };
+
+  // Queue from core `from` to core `to`, created on first use by `from`.
+  common::SpscQueue<Message>& Inbox(size_t to, size_t from);
+  void Run(size_t core, int cpu);
+  // Run the messages received, return how many.
+  size_t Drain(Core& core);
+  // Push buffered messages, return whether any remain.
+  bool Flush(size_t from);
+  // Whether any message awaits `core`, with its mutex held.
+  bool Waiting(const Core& core) const;
+  void Wake(Core& core);
+
+  Options mOptions;
+  std::vector<std::unique_ptr<Core>> mCores;
+  std::vector<std::shared_ptr<ShardClient>> mClients;
+  std::atomic<bool> mStopping{false};
+
+  std::mutex mStartMutex;
+  std::condition_variable mStarted;
+  size_t mReady{0};
+};
+
+/**
+ * @brief Shard of a CoreShards group, running every call on its core.
+ */
+class CoreShardClient : public ShardClient {
+public:
+  CoreShardClient(CoreShards& group, size_t core)
+      : mGroup(group), mCore(core) {}
+
+  /* override */ common::Task<ApplyReply> ApplyAsync(ShardBatch batch);
+  /* override */ common::Task<AdjacencyReply> FetchAdjacencyAsync(
+      std::vector<std::string> names,
+      base::LineageCursor::DIRECTION direction);
+  /* override */ common::Task<ContainsReply> HasConceptAsync(
+      std::string name);
+
+  /* override */ bool Apply(const ShardBatch& batch, base::BatchResult& result,
+                            std::vector<uint32_t>& failed, std::string& error);
+  /* override */ bool FetchAdjacency(
+      const std::vector<std::string>& names,
+      base::LineageCursor::DIRECTION direction,
+      std::vector<std::vector<std::string>>& adjacency, std::string& error);
+  /* override */ bool HasConcept(const std::string& name, bool& found,
+                                 std::string& error);
+
+private:
+  CoreShards& mGroup;
+  size_t mCore;
+};
+
+}  // namespace server
+}  // namespace hyperon
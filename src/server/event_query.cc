@@ -0,0 +1,25 @@
+#include "server/event_query.h"
+
+#include "server/rpc_metrics.h"
+#include "server/slow_query_log.h"
+
+namespace hyperon {
+namespace server {
+
+size_t query_events(const base::Hyperbase& hyperbase,
+                    base::TEMPORAL_RELATION relation, int64_t start,
+                    int64_t end, uint32_t limit,
+                    std::vector<base::TimedEvent>& out,
+                    common::ProfileNode* profile) {
+  RpcScope scope(RPC_QUERY_EVENTS);
+  SlowQueryLog& slow_log = SlowQueryLog::Instance();
+  common::ProfileNode local;
+  if (!profile && slow_log.Enabled()) profile = &local;
+  size_t found =
+      base::find_events(hyperbase, relation, start, end, out, limit, profile);
+  if (profile) slow_log.Record(RPC_QUERY_EVENTS, hyperbase.Name(), *profile);
+  return found;
+}
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/temporal_query.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Handler of the QueryEvents RPC: events standing in `relation` to
+ * the window [start, end], ordered by start. Profiled if `profile` is set
+ * or the slow query log is enabled.
+ *
+ * @param limit Events to return at most, 0 for all
+ * @return size_t Number of events appended to `out`
+ */
+size_t query_events(const base::Hyperbase& hyperbase,
+                    base::TEMPORAL_RELATION relation, int64_t start,
+                    int64_t end, uint32_t limit,
+                    std::vector<base::TimedEvent>& out,
+                    common::ProfileNode* profile = nullptr);
+
+}  // namespace server
+}  // namespace hyperon
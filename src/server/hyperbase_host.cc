@@ -0,0 +1,365 @@
+#include "server/hyperbase_host.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <shared_mutex>
+
+#include "base/storage/snapshot.h"
+#include "common/utils/time.h"
+#include "server/rpc_metrics.h"
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+constexpr const char* kSnapshotExt = ".hb";
+
+bool valid_tenant_name(const std::string& name) {
+  return !name.empty() && name[0] != '.' &&
+         name.find_first_of("/\\") == std::string::npos;
+}
+
+}  // namespace
+
+HyperbaseHost::HyperbaseHost(const Options& options) : mOptions(options) {}
+
+std::string HyperbaseHost::SnapshotPath(const std::string& name) const {
+  return (std::filesystem::path(mOptions.data_dir) / (name + kSnapshotExt))
+      .string();
+}
+
+uint64_t HyperbaseHost::LastActivity(const base::HyperbaseStatus& status) {
+  return std::max(status.last_read_time, status.updated_time);
+}
+
+void HyperbaseHost::AttachCache(Tenant& tenant) const {
+  if (mOptions.result_cache_bytes == 0) return;
+  tenant.cache = std::make_shared<base::QueryResultCache>(
+      *tenant.hyperbase, mOptions.result_cache_bytes);
+  tenant.hyperbase->AddCommitObserver(tenant.cache);
+}
+
+HyperbaseHost::TenantPtr HyperbaseHost::Find(const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto found = mTenants.find(name);
+  return found == mTenants.end() ? nullptr : found->second;
+}
+
+size_t HyperbaseHost::Discover() {
+  std::error_code ec;
+  std::filesystem::directory_iterator it(mOptions.data_dir, ec);
+  if (ec) return 0;
+
+  size_t discovered = 0;
+  for (const auto& entry : it) {
+    if (!entry.is_regular_file() || entry.path().extension() != kSnapshotExt) {
+      continue;
+    }
+    base::SnapshotHeader header;
+    std::string error;
+    if (!base::read_snapshot_header(entry.path().string(), header, error) ||
+        header.name != entry.path().stem().string()) {
+      continue;
+    }
+    auto tenant = std::make_shared<Tenant>();
+    tenant->name = header.name;
+    tenant->owner = header.owner;
+    tenant->quota = header.memory_quota;
+    tenant->saved_version = header.version;
+    tenant->status = header.status;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    discovered += mTenants.emplace(header.name, tenant).second ? 1 : 0;
+  }
+  return discovered;
+}
+
+bool HyperbaseHost::Create(const std::string& name, const std::string& owner,
+                           uint64_t quota, std::string& error) {
+  RpcScope scope(RPC_CREATE_HYPERBASE);
+  if (!valid_tenant_name(name)) {
+    error = fmt::format("invalid hyperbase name '{}'", name);
+    scope.Fail();
+    return false;
+  }
+  auto tenant = std::make_shared<Tenant>();
+  tenant->name = name;
+  tenant->owner = owner;
+  tenant->quota = quota > 0 ? quota : mOptions.default_quota;
+  tenant->hyperbase = std::make_shared<base::Hyperbase>(name, owner);
+  tenant->hyperbase->SetMemoryQuota(tenant->quota);
+  tenant->status = tenant->hyperbase->Status();
+
+  std::lock_guard<std::mutex> io_lock(tenant->io_mutex);
+  AttachCache(*tenant);
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mTenants.emplace(name, tenant).second) {
+      error = fmt::format("hyperbase '{}' already exists", name);
+      scope.Fail();
+      return false;
+    }
+  }
+  if (!base::write_snapshot(*tenant->hyperbase, SnapshotPath(name), error)) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTenants.erase(name);
+    scope.Fail();
+    return false;
+  }
+  tenant->saved_version = tenant->hyperbase->Version();
+  return true;
+}
+
+bool HyperbaseHost::Acquire(const std::string& name,
+                            base::HyperbasePtr& result, std::string& error) {
+  std::shared_ptr<base::QueryResultCache> cache;
+  return Acquire(name, result, cache, error);
+}
+
+bool HyperbaseHost::Acquire(const std::string& name,
+                            base::HyperbasePtr& result,
+                            std::shared_ptr<base::QueryResultCache>& cache,
+                            std::string& error) {
+  TenantPtr tenant = Find(name);
+  if (!tenant) {
+    error = fmt::format("hyperbase '{}' not found", name);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> io_lock(tenant->io_mutex);
+  if (!tenant->hyperbase) {
+    base::HyperbasePtr loaded;
+    if (!base::read_snapshot(SnapshotPath(name), loaded, error)) return false;
+    loaded->SetMemoryQuota(tenant->quota);
+    tenant->saved_version = loaded->Version();
+    tenant->hyperbase = loaded;
+    AttachCache(*tenant);
+  }
+  tenant->hyperbase->TouchRead();
+  result = tenant->hyperbase;
+  cache = tenant->cache;
+  return true;
+}
+
+bool HyperbaseHost::Delete(const std::string& name, bool permanent,
+                           std::string& error) {
+  RpcScope scope(RPC_DELETE_HYPERBASE);
+  TenantPtr tenant;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto found = mTenants.find(name);
+    if (found == mTenants.end()) {
+      error = fmt::format("hyperbase '{}' not found", name);
+      scope.Fail();
+      return false;
+    }
+    tenant = found->second;
+    mTenants.erase(found);
+  }
+
+  std::lock_guard<std::mutex> io_lock(tenant->io_mutex);
+  if (permanent) {
+    tenant->hyperbase.reset();
+    tenant->cache.reset();
+    std::error_code ec;
+    std::filesystem::remove(SnapshotPath(name), ec);
+    return true;
+  }
+  // A non-permanent deletion detaches the tenant but keeps its latest state
+  // on disk, so that a later Discover() brings it back.
+  if (tenant->hyperbase &&
+      tenant->hyperbase->Version() != tenant->saved_version &&
+      !base::write_snapshot(*tenant->hyperbase, SnapshotPath(name), error)) {
+    scope.Fail();
+    return false;
+  }
+  return true;
+}
+
+bool HyperbaseHost::Flush(const std::string& name, std::string& error) {
+  TenantPtr tenant = Find(name);
+  if (!tenant) {
+    error = fmt::format("hyperbase '{}' not found", name);
+    return false;
+  }
+  std::lock_guard<std::mutex> io_lock(tenant->io_mutex);
+  if (!tenant->hyperbase) return true;
+  uint64_t version = tenant->hyperbase->Version();
+  if (version == tenant->saved_version) return true;
+  if (!base::write_snapshot(*tenant->hyperbase, SnapshotPath(name), error)) {
+    return false;
+  }
+  tenant->saved_version = version;
+  return true;
+}
+
+bool HyperbaseHost::EvictLocked(Tenant& tenant) {
+  // Requests in flight keep their own reference, wait for them to finish.
+  if (!tenant.hyperbase || tenant.hyperbase.use_count() > 1) return false;
+
+  uint64_t version = tenant.hyperbase->Version();
+  if (version != tenant.saved_version) {
+    std::string error;
+    if (!base::write_snapshot(*tenant.hyperbase, SnapshotPath(tenant.name),
+                              error)) {
+      return false;
+    }
+    tenant.saved_version = version;
+  }
+  tenant.status = tenant.hyperbase->Status();
+  tenant.statistics = tenant.hyperbase->Statistics();
+  tenant.statistics.memory.clear();
+  tenant.hyperbase.reset();
+  tenant.cache.reset();
+  return true;
+}
+
+size_t HyperbaseHost::EvictIdle() {
+  std::vector<TenantPtr> tenants;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& kv : mTenants) tenants.push_back(kv.second);
+  }
+
+  size_t evicted = 0;
+  uint64_t now = common::now_millis();
+  struct Candidate {
+    uint64_t last_activity;
+    TenantPtr tenant;
+  };
+  std::vector<Candidate> resident;
+  for (const auto& tenant : tenants) {
+    std::unique_lock<std::mutex> io_lock(tenant->io_mutex, std::try_to_lock);
+    if (!io_lock.owns_lock() || !tenant->hyperbase) continue;
+    uint64_t last = LastActivity(tenant->hyperbase->Status());
+    if (now >= last && now - last >= mOptions.idle_millis) {
+      evicted += EvictLocked(*tenant) ? 1 : 0;
+    } else {
+      resident.push_back({last, tenant});
+    }
+  }
+
+  if (mOptions.resident_budget == 0) return evicted;
+  uint64_t usage = ResidentMemory();
+  std::sort(resident.begin(), resident.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.last_activity < b.last_activity;
+            });
+  for (const auto& candidate : resident) {
+    if (usage <= mOptions.resident_budget) break;
+    std::lock_guard<std::mutex> io_lock(candidate.tenant->io_mutex);
+    if (!candidate.tenant->hyperbase) continue;
+    uint64_t bytes = candidate.tenant->hyperbase->MemoryUsage();
+    if (EvictLocked(*candidate.tenant)) {
+      usage -= std::min(usage, bytes);
+      ++evicted;
+    }
+  }
+  return evicted;
+}
+
+std::vector<TenantInfo> HyperbaseHost::List(const std::string& name) const {
+  RpcScope scope(RPC_FETCH_HYPERBASE);
+  return Infos(name);
+}
+
+std::vector<TenantInfo> HyperbaseHost::Infos(const std::string& name) const {
+  std::vector<TenantPtr> tenants;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& kv : mTenants) {
+      if (name.empty() || kv.first == name) tenants.push_back(kv.second);
+    }
+  }
+
+  std::vector<TenantInfo> infos;
+  infos.reserve(tenants.size());
+  for (const auto& tenant : tenants) {
+    std::lock_guard<std::mutex> io_lock(tenant->io_mutex);
+    TenantInfo info;
+    info.name = tenant->name;
+    info.owner = tenant->owner;
+    info.memory_quota = tenant->quota;
+    info.resident = tenant->hyperbase != nullptr;
+    if (info.resident) {
+      info.memory_usage = tenant->hyperbase->MemoryUsage();
+      info.status = tenant->hyperbase->Status();
+      info.statistics = tenant->hyperbase->Statistics();
+      if (tenant->cache) info.result_cache = tenant->cache->Stats();
+    } else {
+      info.status = tenant->status;
+      info.statistics = tenant->statistics;
+    }
+    infos.push_back(std::move(info));
+  }
+  return infos;
+}
+
+size_t HyperbaseHost::TenantCount() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mTenants.size();
+}
+
+void HyperbaseHost::ForEachResident(
+    const std::function<void(const Tenant&)>& fn) const {
+  std::vector<TenantPtr> tenants;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& kv : mTenants) tenants.push_back(kv.second);
+  }
+  for (const auto& tenant : tenants) {
+    std::unique_lock<std::mutex> io_lock(tenant->io_mutex, std::try_to_lock);
+    if (io_lock.owns_lock() && tenant->hyperbase) fn(*tenant);
+  }
+}
+
+size_t HyperbaseHost::ResidentCount() const {
+  size_t count = 0;
+  ForEachResident([&count](const Tenant&) { ++count; });
+  return count;
+}
+
+uint64_t HyperbaseHost::ResidentMemory() const {
+  uint64_t bytes = 0;
+  ForEachResident([&bytes](const Tenant& tenant) {
+    bytes += tenant.hyperbase->MemoryUsage();
+  });
+  return bytes;
+}
+
+void HyperbaseHost::CollectMemory(common::MetricsSnapshot& out) const {
+  ForEachResident([&out](const Tenant& tenant) {
+    std::vector<base::CategoryMemory> breakdown;
+    {
+      std::shared_lock<std::shared_mutex> lock(tenant.hyperbase->Mutex());
+      breakdown = tenant.hyperbase->MemoryBreakdown();
+    }
+    for (const auto& entry : breakdown) {
+      common::MetricSample sample;
+      sample.name = "hyperon_hyperbase_memory_bytes";
+      sample.help = "Footprint of resident hyperbases by category and kind.";
+      sample.labels =
+          common::prometheus_label("hyperbase", tenant.name) + "," +
+          common::prometheus_label("category", entry.category) + "," +
+          common::prometheus_label("kind", memory_kind_name(entry.kind));
+      sample.type = common::MetricSample::GAUGE;
+      sample.value = static_cast<double>(entry.bytes);
+      out.push_back(std::move(sample));
+    }
+    if (!tenant.cache) return;
+    common::MetricSample sample;
+    sample.name = "hyperon_result_cache_bytes";
+    sample.help = "Footprint of the query result caches of resident "
+                  "hyperbases.";
+    sample.labels = common::prometheus_label("hyperbase", tenant.name);
+    sample.type = common::MetricSample::GAUGE;
+    sample.value = static_cast<double>(tenant.cache->Stats().bytes);
+    out.push_back(std::move(sample));
+  });
+}
+
+}  // namespace server
+}  // namespace hyperon
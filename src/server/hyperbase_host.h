@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/result_cache.h"
+#include "common/metrics/metrics.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Hosting information of one tenant hyperbase, as reported by
+ * FetchHyperbase.
+ */
+struct TenantInfo {
+  std::string name;
+  std::string owner;
+  bool resident{false};
+  uint64_t memory_usage{0};
+  uint64_t memory_quota{0};
+  base::HyperbaseStatus status;
+  // Figures of cold tenants are as of their eviction, zero if never loaded.
+  // Their memory breakdown is empty.
+  base::HyperbaseStatistics statistics;
+  // Query result cache of resident tenants.
+  base::ResultCacheStats result_cache;
+};
+
+/**
+ * @brief Hosts many named hyperbases in one hyperond process.
+ *
+ * Every tenant is persisted as a snapshot file in the data directory. A
+ * tenant is opened lazily on first access and evicted back to its snapshot
+ * when idle, i.e. when neither read nor written for `idle_millis` and no
+ * request holds a reference to it any more. Each tenant carries a memory
+ * quota enforced on writes, and the host keeps the sum of resident
+ * footprints below `resident_budget` by evicting the least recently used
+ * tenants first.
+ *
+ * Resident tenants come with a query result cache of `result_cache_bytes`,
+ * which lives and goes with the loaded hyperbase.
+ */
+class HyperbaseHost {
+public:
+  struct Options {
+    std::string data_dir{"."};
+    uint64_t idle_millis{10 * 60 * 1000};
+    // Quota of tenants created without an explicit one, 0 for unlimited.
+    uint64_t default_quota{0};
+    // Budget of all resident tenants, 0 for unlimited.
+    uint64_t resident_budget{0};
+    // Result cache of every resident tenant, 0 to disable.
+    uint64_t result_cache_bytes{base::QueryResultCache::kDefaultCapacity};
+  };
+
+  explicit HyperbaseHost(const Options& options);
+
+  /**
+   * @brief Register the snapshots found in the data directory as cold
+   * tenants. Called once at startup.
+   *
+   * @return size_t Number of discovered tenants
+   */
+  size_t Discover();
+
+  /**
+   * @brief Create an empty tenant and persist it right away.
+   *
+   * @param quota Memory quota in bytes, default quota if 0
+   */
+  bool Create(const std::string& name, const std::string& owner,
+              uint64_t quota, std::string& error);
+
+  /**
+   * @brief Get a tenant, loading it from its snapshot if cold. The caller
+   * keeps the tenant resident as long as it holds the returned pointer.
+   *
+   * @param name Tenant name
+   * @param result Hyperbase or nullptr
+   * @param error Error message on failure
+   * @return true if the tenant is available.
+   */
+  bool Acquire(const std::string& name, base::HyperbasePtr& result,
+               std::string& error);
+
+  /**
+   * @brief Acquire() with the result cache of the tenant, nullptr if
+   * disabled. The cache is valid as long as the hyperbase is held.
+   */
+  bool Acquire(const std::string& name, base::HyperbasePtr& result,
+               std::shared_ptr<base::QueryResultCache>& cache,
+               std::string& error);
+
+  /**
+   * @brief Remove a tenant from hosting, deleting its snapshot if
+   * `permanent`.
+   */
+  bool Delete(const std::string& name, bool permanent, std::string& error);
+
+  /**
+   * @brief Persist a resident tenant, skipping it if unchanged since the
+   * last snapshot.
+   */
+  bool Flush(const std::string& name, std::string& error);
+
+  /**
+   * @brief Snapshot and unload idle tenants, then the least recently used
+   * ones while the resident budget is exceeded. Meant to run periodically.
+   *
+   * @return size_t Number of evicted tenants
+   */
+  size_t EvictIdle();
+
+  /**
+   * @brief List hosted tenants, or the named one only.
+   */
+  std::vector<TenantInfo> List(const std::string& name = "") const;
+
+  /*
+   * Resident counts and footprints are read without waiting for tenants
+   * being loaded, saved or evicted, which are left out.
+   */
+  size_t TenantCount() const;
+  size_t ResidentCount() const;
+  uint64_t ResidentMemory() const;
+
+  /**
+   * @brief Append the footprint of every resident tenant by category and
+   * kind of structure to a scrape, as hyperon_hyperbase_memory_bytes, and
+   * that of its result cache as hyperon_result_cache_bytes.
+   */
+  void CollectMemory(common::MetricsSnapshot& out) const;
+
+private:
+  struct Tenant {
+    std::string name;
+    std::string owner;
+    uint64_t quota{0};
+    base::HyperbasePtr hyperbase;
+    // Observes `hyperbase`, set while resident if enabled.
+    std::shared_ptr<base::QueryResultCache> cache;
+    // Version persisted in the snapshot file.
+    uint64_t saved_version{0};
+    base::HyperbaseStatus status;
+    base::HyperbaseStatistics statistics;
+    // Serializes loading, saving and eviction of this tenant.
+    std::mutex io_mutex;
+  };
+  using TenantPtr = std::shared_ptr<Tenant>;
+
+  std::string SnapshotPath(const std::string& name) const;
+  TenantPtr Find(const std::string& name) const;
+  // List() without counting an RPC call.
+  std::vector<TenantInfo> Infos(const std::string& name) const;
+  // Visit resident tenants whose io_mutex is free, under that mutex.
+  void ForEachResident(const std::function<void(const Tenant&)>& fn) const;
+  // Snapshot and unload a tenant if nobody holds it. Caller holds io_mutex.
+  bool EvictLocked(Tenant& tenant);
+  static uint64_t LastActivity(const base::HyperbaseStatus& status);
+  // Give a newly resident tenant its result cache. Caller holds io_mutex.
+  void AttachCache(Tenant& tenant) const;
+
+  Options mOptions;
+  mutable std::mutex mMutex;
+  std::map<std::string, TenantPtr> mTenants;
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -1,133 +1,151 @@
-#include <iostream>
-
 #include "server/hyperon_server.h"
 
-void hyperkdb_server() {
-#ifdef NDEBUG
-  std::cout << "hyperkdb-server/1.0: Hello World Release!\n";
-#else
-  std::cout << "hyperkdb-server/1.0: Hello World Debug!\n";
-#endif
-
-// ARCHITECTURES
-#ifdef _M_X64
-  std::cout << "  hyperkdb-server/1.0: _M_X64 defined\n";
-#endif
-
-#ifdef _M_IX86
-  std::cout << "  hyperkdb-server/1.0: _M_IX86 defined\n";
-#endif
-
-#ifdef _M_ARM64
-  std::cout << "  hyperkdb-server/1.0: _M_ARM64 defined\n";
-#endif
-
-#if __i386__
-  std::cout << "  hyperkdb-server/1.0: __i386__ defined\n";
-#endif
-
-#if __x86_64__
-  std::cout << "  hyperkdb-server/1.0: __x86_64__ defined\n";
-#endif
-
-#if __aarch64__
-  std::cout << "  hyperkdb-server/1.0: __aarch64__ defined\n";
-#endif
-
-// Libstdc++
-#if defined _GLIBCXX_USE_CXX11_ABI
-  std::cout << "  hyperkdb-server/1.0: _GLIBCXX_USE_CXX11_ABI "
-            << _GLIBCXX_USE_CXX11_ABI << "\n";
-#endif
-
-// MSVC runtime
-#if defined(_DEBUG)
-#if defined(_MT) && defined(_DLL)
-  std::cout << "  hyperkdb-server/1.0: MSVC runtime: MultiThreadedDebugDLL\n";
-#elif defined(_MT)
-  std::cout << "  hyperkdb-server/1.0: MSVC runtime: MultiThreadedDebug\n";
-#endif
-#else
-#if defined(_MT) && defined(_DLL)
-  std::cout << "  hyperkdb-server/1.0: MSVC runtime: MultiThreadedDLL\n";
-#elif defined(_MT)
-  std::cout << "  hyperkdb-server/1.0: MSVC runtime: MultiThreaded\n";
-#endif
-#endif
-
-// COMPILER VERSIONS
-#if _MSC_VER
-  std::cout << "  hyperkdb-server/1.0: _MSC_VER" << _MSC_VER << "\n";
-#endif
-
-#if _MSVC_LANG
-  std::cout << "  hyperkdb-server/1.0: _MSVC_LANG" << _MSVC_LANG << "\n";
-#endif
-
-#if __cplusplus
-  std::cout << "  hyperkdb-server/1.0: __cplusplus" << __cplusplus << "\n";
-#endif
-
-#if __INTEL_COMPILER
-  std::cout << "  hyperkdb-server/1.0: __INTEL_COMPILER" << __INTEL_COMPILER
-            << "\n";
-#endif
-
-#if __GNUC__
-  std::cout << "  hyperkdb-server/1.0: __GNUC__" << __GNUC__ << "\n";
-#endif
-
-#if __GNUC_MINOR__
-  std::cout << "  hyperkdb-server/1.0: __GNUC_MINOR__" << __GNUC_MINOR__
-            << "\n";
-#endif
-
-#if __clang_major__
-  std::cout << "  hyperkdb-server/1.0: __clang_major__" << __clang_major__
-            << "\n";
-#endif
-
-#if __clang_minor__
-  std::cout << "  hyperkdb-server/1.0: __clang_minor__" << __clang_minor__
-            << "\n";
-#endif
-
-#if __apple_build_version__
-  std::cout << "  hyperkdb-server/1.0: __apple_build_version__"
-            << __apple_build_version__ << "\n";
-#endif
-
-  // SUBSYSTEMS
-
-#if __MSYS__
-  std::cout << "  hyperkdb-server/1.0: __MSYS__" << __MSYS__ << "\n";
-#endif
-
-#if __MINGW32__
-  std::cout << "  hyperkdb-server/1.0: __MINGW32__" << __MINGW32__ << "\n";
-#endif
-
-#if __MINGW64__
-  std::cout << "  hyperkdb-server/1.0: __MINGW64__" << __MINGW64__ << "\n";
-#endif
-
-#if __CYGWIN__
-  std::cout << "  hyperkdb-server/1.0: __CYGWIN__" << __CYGWIN__ << "\n";
-#endif
+#include <fmt/core.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <thread>
+
+#include "common/metrics/metrics.h"
+#include "server/hyperbase_host.h"
+#include "server/metrics_endpoint.h"
+#include "server/slow_query_log.h"
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+constexpr auto kEvictionPeriod = std::chrono::seconds(1);
+
+volatile std::sig_atomic_t gStopRequested = 0;
+
+void request_stop(int) { gStopRequested = 1; }
+
+bool parse_number(const std::string& text, uint64_t& value) {
+  char* end = nullptr;
+  value = std::strtoull(text.c_str(), &end, 10);
+  return !text.empty() && *end == '\0';
 }
 
-void hyperkdb_server_print_vector(const std::vector<std::string> &strings) {
-  for (std::vector<std::string>::const_iterator it = strings.begin();
-       it != strings.end(); ++it) {
-    std::cout << "hyperkdb_server/1.0 " << *it << std::endl;
+}  // namespace
+
+bool parse_server_options(int argc, char** argv, ServerOptions& options,
+                          std::string& error) {
+  for (int i = 1; i < argc; i += 2) {
+    std::string name = argv[i];
+    if (i + 1 >= argc) {
+      error = fmt::format("missing value of {}", name);
+      return false;
+    }
+    std::string value = argv[i + 1];
+    uint64_t number = 0;
+    bool numeric = parse_number(value, number);
+    if (name == "--data-dir") {
+      options.data_dir = value;
+    } else if (name == "--metrics-address") {
+      options.metrics_address = value;
+    } else if (name == "--metrics-port" && numeric && number <= 65535) {
+      options.metrics_port = static_cast<uint16_t>(number);
+    } else if (name == "--idle-millis" && numeric) {
+      options.idle_millis = number;
+    } else if (name == "--default-quota" && numeric) {
+      options.default_quota = number;
+    } else if (name == "--resident-budget" && numeric) {
+      options.resident_budget = number;
+    } else if (name == "--result-cache-bytes" && numeric) {
+      options.result_cache_bytes = number;
+    } else if (name == "--slow-query-millis" && numeric) {
+      options.slow_query_millis = number;
+    } else if (name == "--slow-query-log") {
+      options.slow_query_log = value;
+    } else {
+      error = fmt::format("invalid option {} {}", name, value);
+      return false;
+    }
   }
+  return true;
 }
 
-int main() {
-  hyperkdb_server();
+int run_server(const ServerOptions& options) {
+  HyperbaseHost::Options host_options;
+  host_options.data_dir = options.data_dir;
+  host_options.idle_millis = options.idle_millis;
+  host_options.default_quota = options.default_quota;
+  host_options.resident_budget = options.resident_budget;
+  host_options.result_cache_bytes = options.result_cache_bytes;
+  HyperbaseHost host(host_options);
+  size_t discovered = host.Discover();
+  fmt::print("hyperond: {} hyperbases in {}\n", discovered, options.data_dir);
+
+  common::Gauge tenants(
+      "hyperon_hyperbases", "Hosted hyperbases.",
+      [&host] { return static_cast<double>(host.TenantCount()); });
+  common::Gauge resident(
+      "hyperon_resident_hyperbases", "Hyperbases loaded in memory.",
+      [&host] { return static_cast<double>(host.ResidentCount()); });
+  common::Gauge memory(
+      "hyperon_resident_memory_bytes",
+      "Footprint of the resident hyperbases.",
+      [&host] { return static_cast<double>(host.ResidentMemory()); });
+  common::Collector tenant_memory(
+      [&host](common::MetricsSnapshot& out) { host.CollectMemory(out); });
+
+  MetricsEndpoint endpoint;
+  if (options.metrics_port > 0) {
+    std::string error;
+    if (!endpoint.Start(options.metrics_address, options.metrics_port,
+                        error)) {
+      fmt::print(stderr, "hyperond: {}\n", error);
+      return 1;
+    }
+    fmt::print("hyperond: metrics on http://{}:{}/metrics\n",
+               options.metrics_address, endpoint.Port());
+  }
 
-  std::vector<std::string> vec;
-  vec.push_back("test_package");
+  if (options.slow_query_millis > 0) {
+    std::string error;
+    if (!SlowQueryLog::Instance().Open(options.slow_query_millis,
+                                       options.slow_query_log, error)) {
+      fmt::print(stderr, "hyperond: {}\n", error);
+      return 1;
+    }
+    fmt::print("hyperond: logging queries over {}ms to {}\n",
+               options.slow_query_millis,
+               options.slow_query_log.empty() ? "stderr"
+                                              : options.slow_query_log);
+  }
 
-  hyperkdb_server_print_vector(vec);
+  std::signal(SIGINT, request_stop);
+  std::signal(SIGTERM, request_stop);
+  while (!gStopRequested) {
+    std::this_thread::sleep_for(kEvictionPeriod);
+    host.EvictIdle();
+  }
+
+  endpoint.Stop();
+  SlowQueryLog::Instance().Close();
+  int status = 0;
+  for (const auto& info : host.List()) {
+    std::string error;
+    if (info.resident && !host.Flush(info.name, error)) {
+      fmt::print(stderr, "hyperond: {}\n", error);
+      status = 1;
+    }
+  }
+  return status;
+}
+
+}  // namespace server
+}  // namespace hyperon
+
+int main(int argc, char** argv) {
+  hyperon::server::ServerOptions options;
+  std::string error;
+  if (!hyperon::server::parse_server_options(argc, argv, options, error)) {
+    fmt::print(stderr, "hyperond: {}\n", error);
+    return 2;
+  }
+  return hyperon::server::run_server(options);
 }
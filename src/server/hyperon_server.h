@@ -1,14 +1,43 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <vector>
 
-#ifdef _WIN32
-#define HYPERKDB_SERVER_EXPORT __declspec(dllexport)
-#else
-#define HYPERKDB_SERVER_EXPORT
-#endif
+namespace hyperon {
+namespace server {
 
-HYPERKDB_SERVER_EXPORT void hyperkdb_server();
-HYPERKDB_SERVER_EXPORT void hyperkdb_server_print_vector(
-    const std::vector<std::string> &strings);
+/**
+ * @brief Command line options of hyperond.
+ */
+struct ServerOptions {
+  std::string data_dir{"."};
+  uint64_t idle_millis{10 * 60 * 1000};
+  uint64_t default_quota{0};
+  uint64_t resident_budget{0};
+  // Query result cache of every resident hyperbase, 0 to disable.
+  uint64_t result_cache_bytes{64 << 20};
+  // Prometheus endpoint, disabled if the port is 0.
+  std::string metrics_address{"0.0.0.0"};
+  uint16_t metrics_port{9464};
+  // Queries taking at least this long are logged with their profile,
+  // disabled if 0. The log goes to stderr unless a file is given.
+  uint64_t slow_query_millis{0};
+  std::string slow_query_log;
+};
+
+/**
+ * @brief Parse `--name value` pairs into `options`.
+ */
+bool parse_server_options(int argc, char** argv, ServerOptions& options,
+                          std::string& error);
+
+/**
+ * @brief Host the hyperbases of the data directory and serve metrics until
+ * SIGINT or SIGTERM, then flush resident hyperbases.
+ *
+ * @return int Process exit code
+ */
+int run_server(const ServerOptions& options);
+
+}  // namespace server
+}  // namespace hyperon
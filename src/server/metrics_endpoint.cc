@@ -0,0 +1,144 @@
+#include "server/metrics_endpoint.h"
+
+#include <arpa/inet.h>
+#include <fmt/core.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "server/rpc_metrics.h"
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+constexpr int kPollMillis = 200;
+constexpr size_t kMaxRequestBytes = 8192;
+
+void send_all(int fd, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent,
+                       MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;
+    sent += static_cast<size_t>(n);
+  }
+}
+
+void respond(int fd, const char* status, const char* type,
+             const std::string& body) {
+  send_all(fd, fmt::format("HTTP/1.1 {}\r\n"
+                           "Content-Type: {}\r\n"
+                           "Content-Length: {}\r\n"
+                           "Connection: close\r\n\r\n",
+                           status, type, body.size()));
+  send_all(fd, body);
+}
+
+}  // namespace
+
+MetricsEndpoint::~MetricsEndpoint() { Stop(); }
+
+bool MetricsEndpoint::Start(const std::string& address, uint16_t port,
+                            std::string& error) {
+  if (mThread.joinable()) {
+    error = "metrics endpoint already started";
+    return false;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    error = fmt::format("invalid metrics address '{}'", address);
+    return false;
+  }
+
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    error = fmt::format("socket: {}", std::strerror(errno));
+    return false;
+  }
+  int one = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  socklen_t len = sizeof(addr);
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(fd, 16) != 0 ||
+      ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+    error = fmt::format("cannot listen on {}:{}: {}", address, port,
+                        std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+
+  mListenFd = fd;
+  mPort = ntohs(addr.sin_port);
+  mStopping = false;
+  mThread = std::thread(&MetricsEndpoint::Run, this);
+  return true;
+}
+
+void MetricsEndpoint::Stop() {
+  if (!mThread.joinable()) return;
+  mStopping = true;
+  mThread.join();
+  ::close(mListenFd);
+  mListenFd = -1;
+}
+
+void MetricsEndpoint::Run() {
+  pollfd listener{mListenFd, POLLIN, 0};
+  while (!mStopping) {
+    listener.revents = 0;
+    if (::poll(&listener, 1, kPollMillis) <= 0) continue;
+    int fd = ::accept4(mListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) continue;
+    Serve(fd);
+    ::close(fd);
+  }
+}
+
+void MetricsEndpoint::Serve(int fd) {
+  // Slow or silent clients must not stall the next scrape.
+  timeval timeout{2, 0};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos &&
+         request.size() < kMaxRequestBytes) {
+    ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    request.append(buffer, static_cast<size_t>(n));
+  }
+
+  size_t line_end = request.find("\r\n");
+  std::string line = request.substr(0, line_end);
+  size_t method_end = line.find(' ');
+  size_t path_end = line.find(' ', method_end + 1);
+  if (method_end == std::string::npos || path_end == std::string::npos) {
+    respond(fd, "400 Bad Request", "text/plain", "bad request\n");
+    return;
+  }
+  std::string method = line.substr(0, method_end);
+  std::string path = line.substr(method_end + 1, path_end - method_end - 1);
+  if (path != "/metrics") {
+    respond(fd, "404 Not Found", "text/plain", "try /metrics\n");
+  } else if (method != "GET") {
+    respond(fd, "405 Method Not Allowed", "text/plain", "GET only\n");
+  } else {
+    common::MetricsSnapshot snapshot;
+    collect_metrics(snapshot);
+    respond(fd, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+            common::format_prometheus(snapshot));
+  }
+}
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Minimal HTTP listener serving GET /metrics in the Prometheus text
+ * format. Requests are answered one at a time on a background thread, which
+ * is plenty for periodic scrapes; every response closes the connection.
+ */
+class MetricsEndpoint {
+public:
+  MetricsEndpoint() = default;
+  ~MetricsEndpoint();
+
+  MetricsEndpoint(const MetricsEndpoint&) = delete;
+  MetricsEndpoint& operator=(const MetricsEndpoint&) = delete;
+
+  /**
+   * @brief Bind and start serving.
+   *
+   * @param address IPv4 address to bind, e.g. "0.0.0.0"
+   * @param port TCP port, 0 for an ephemeral one
+   * @param error Error message on failure
+   */
+  bool Start(const std::string& address, uint16_t port, std::string& error);
+  void Stop();
+
+  // Bound port, useful after starting on port 0.
+  inline uint16_t Port() const { return mPort; }
+
+private:
+  void Run();
+  void Serve(int fd);
+
+  int mListenFd{-1};
+  uint16_t mPort{0};
+  std::atomic<bool> mStopping{false};
+  std::thread mThread;
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,242 @@
+#include "server/query_stream.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <shared_mutex>
+
+#include "common/utils/time.h"
+#include "server/rpc_metrics.h"
+#include "server/slow_query_log.h"
+
+namespace hyperon {
+namespace server {
+
+CursorRegistry::CursorRegistry(uint64_t ttl_millis, size_t capacity)
+    : mTtlMillis(ttl_millis),
+      mCapacity(capacity),
+      mIdGen(std::random_device{}()) {}
+
+bool CursorRegistry::StreamLineage(
+    const base::Hyperbase& hyperbase, const LineageQuery& query,
+    const std::function<bool(const LineageChunk&)>& write,
+    std::string& error, base::QueryResultCache* cache) {
+  RpcScope scope(RPC_STREAM_LINEAGE);
+  if (Stream(hyperbase, query, write, error, cache)) return true;
+  scope.Fail();
+  return false;
+}
+
+bool CursorRegistry::Stream(
+    const base::Hyperbase& hyperbase, const LineageQuery& query,
+    const std::function<bool(const LineageChunk&)>& write,
+    std::string& error, base::QueryResultCache* cache) {
+  std::shared_ptr<Entry> entry;
+  std::string id;
+  bool replay = false;
+
+  if (query.cursor.empty()) {
+    {
+      std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+      if (!hyperbase.HasConcept(query.origin)) {
+        error = fmt::format("unknown concept '{}'", query.origin);
+        return false;
+      }
+    }
+    entry = std::make_shared<Entry>();
+    entry->hyperbase = hyperbase.Name();
+    entry->cursor = std::make_unique<base::LineageCursor>(query.origin,
+                                                          query.direction);
+    entry->busy = true;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mEntries.size() >= mCapacity &&
+        ExpireLocked(common::now_millis()) == 0) {
+      error = "too many open cursors";
+      return false;
+    }
+    id = NewId();
+    mEntries.emplace(id, entry);
+  } else {
+    uint64_t seq = 0;
+    if (!ParseToken(query.cursor, id, seq)) {
+      error = "malformed cursor";
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto found = mEntries.find(id);
+    if (found == mEntries.end()) {
+      error = "unknown or expired cursor";
+      return false;
+    }
+    entry = found->second;
+    if (entry->busy) {
+      error = "cursor is being streamed";
+      return false;
+    }
+    if (entry->hyperbase != hyperbase.Name()) {
+      error = "cursor belongs to another hyperbase";
+      return false;
+    }
+    if (seq + 1 == entry->seq) {
+      replay = true;
+    } else if (seq != entry->seq) {
+      error = "cursor position is out of date";
+      return false;
+    } else if (!entry->cursor) {
+      error = "cursor is exhausted";
+      return false;
+    }
+    entry->busy = true;
+  }
+
+  if (replay) {
+    if (!write(entry->last) || entry->last.done) {
+      Release(id, entry);
+      return true;
+    }
+  }
+
+  uint32_t chunk_size = query.chunk_size == 0 ? kDefaultChunkSize
+                                              : query.chunk_size;
+  chunk_size = std::min(chunk_size, kMaxChunkSize);
+
+  SlowQueryLog& slow_log = SlowQueryLog::Instance();
+  std::unique_ptr<common::ProfileNode> profile;
+  common::ProfileNode* walk = nullptr;
+  common::ProfileNode* sent = nullptr;
+  auto start = std::chrono::steady_clock::now();
+  auto elapsed = [&start] {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+  };
+  if (query.profile || slow_log.Enabled()) {
+    profile = std::make_unique<common::ProfileNode>(
+        "stream_lineage", fmt::format("chunk size {}", chunk_size));
+    // Filled by the cursor on its first chunk, or by the cache lookup.
+    walk = &profile->AddChild("");
+    // Time blocked under flow control shows up here.
+    sent = &profile->AddChild("write_chunks");
+  }
+
+  // Only a walk that is already cached and fits in one chunk is taken from
+  // the cache, nothing of it stays with the cursor.
+  base::CachedResultPtr cached;
+  if (cache && query.cursor.empty()) {
+    cached = cache->CachedLineage(query.origin, query.direction, 0,
+                                  chunk_size, walk);
+  }
+
+  while (true) {
+    LineageChunk& chunk = entry->last;
+    chunk.concepts.clear();
+    chunk.profile.reset();
+    if (cached) {
+      chunk.concepts = cached->rows;
+      chunk.done = true;
+      chunk.version = cached->version;
+    } else {
+      entry->cursor->Next(hyperbase, chunk_size, chunk.concepts, walk);
+      if (entry->cursor->Overflowed()) {
+        error = fmt::format(
+            "lineage of '{}' reaches more than {} shared concepts",
+            entry->cursor->Origin(), entry->cursor->MaxVisited());
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.erase(id);
+        return false;
+      }
+      chunk.done = entry->cursor->Exhausted();
+      chunk.version = entry->cursor->StartVersion();
+    }
+    chunk.cursor = MakeToken(id, ++entry->seq);
+    if (profile) {
+      ++profile->loops;
+      profile->rows_out += chunk.concepts.size();
+      ++sent->loops;
+      sent->rows_in += chunk.concepts.size();
+      if (chunk.done && query.profile) {
+        auto copy = std::make_shared<common::ProfileNode>(*profile);
+        copy->nanos = elapsed();
+        chunk.profile = std::move(copy);
+      }
+    }
+    common::ProfileTimer write_timer(sent);
+    bool written = write(chunk);
+    write_timer.Stop();
+    if (written && sent) sent->rows_out += chunk.concepts.size();
+    if (!written || chunk.done) break;
+  }
+  Release(id, entry);
+  if (profile) {
+    profile->nanos = elapsed();
+    slow_log.Record(RPC_STREAM_LINEAGE, hyperbase.Name(), *profile);
+  }
+  return true;
+}
+
+void CursorRegistry::Release(const std::string&,
+                             const std::shared_ptr<Entry>& entry) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  entry->busy = false;
+  entry->last_access = common::now_millis();
+  // A finished walk is kept until expiry only in case its last chunk was
+  // lost; release the cursor state itself right away.
+  if (entry->last.done) entry->cursor.reset();
+}
+
+size_t CursorRegistry::Expire() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return ExpireLocked(common::now_millis());
+}
+
+size_t CursorRegistry::ExpireLocked(uint64_t now) {
+  size_t dropped = 0;
+  for (auto it = mEntries.begin(); it != mEntries.end();) {
+    const Entry& entry = *it->second;
+    if (!entry.busy && now - entry.last_access > mTtlMillis) {
+      it = mEntries.erase(it);
+      ++dropped;
+    } else {
+      ++it;
+    }
+  }
+  return dropped;
+}
+
+size_t CursorRegistry::Size() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mEntries.size();
+}
+
+std::string CursorRegistry::NewId() {
+  std::string id;
+  do {
+    id = fmt::format("{:016x}", mIdGen());
+  } while (mEntries.find(id) != mEntries.end());
+  return id;
+}
+
+std::string CursorRegistry::MakeToken(const std::string& id, uint64_t seq) {
+  return fmt::format("{}.{}", id, seq);
+}
+
+bool CursorRegistry::ParseToken(const std::string& token, std::string& id,
+                                uint64_t& seq) {
+  auto dot = token.find('.');
+  if (dot == std::string::npos || dot == 0 || dot + 1 == token.size()) {
+    return false;
+  }
+  char* end = nullptr;
+  seq = std::strtoull(token.c_str() + dot + 1, &end, 10);
+  if (*end != '\0') return false;
+  id = token.substr(0, dot);
+  return true;
+}
+
+}  // namespace server
+}  // namespace hyperon
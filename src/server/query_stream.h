@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/query/lineage_cursor.h"
+#include "base/query/result_cache.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Lineage query of the StreamLineage RPC, mirrors
+ * api.v1.LineageQueryRequest.
+ */
+struct LineageQuery {
+  std::string origin;
+  base::LineageCursor::DIRECTION direction{base::LineageCursor::DESCENDANTS};
+  uint32_t chunk_size{0};
+  // Resume token of the last received chunk, empty for a new query.
+  std::string cursor;
+  // Return the execution profile with the last chunk.
+  bool profile{false};
+};
+
+/**
+ * @brief One streamed chunk, mirrors api.v1.LineageQueryChunk.
+ */
+struct LineageChunk {
+  std::vector<std::string> concepts;
+  // Token to resume right after this chunk.
+  std::string cursor;
+  // Hyperbase version the walk started at.
+  uint64_t version{0};
+  bool done{false};
+  // Execution profile of this call, on the last chunk of a profiled query.
+  std::shared_ptr<const common::ProfileNode> profile;
+};
+
+/**
+ * @brief Parked cursors of streamed queries, so a client can resume after a
+ * disconnect without re-running the query.
+ *
+ * A token names a cursor and the number of chunks the client has received.
+ * The last emitted chunk is kept with the cursor, because the transport may
+ * have lost it: resuming one chunk behind replays it, resuming at the head
+ * continues the walk. Idle cursors expire after `ttl_millis`.
+ */
+class CursorRegistry {
+public:
+  static constexpr uint64_t kDefaultTtlMillis = 5 * 60 * 1000;
+  static constexpr size_t kDefaultCapacity = 1 << 16;
+  static constexpr uint32_t kDefaultChunkSize = 1024;
+  static constexpr uint32_t kMaxChunkSize = 65536;
+
+  explicit CursorRegistry(uint64_t ttl_millis = kDefaultTtlMillis,
+                          size_t capacity = kDefaultCapacity);
+
+  /**
+   * @brief Stream a lineage query chunk by chunk through `write`, which
+   * blocks under transport flow control and returns false once the client
+   * has gone away. The cursor stays parked in that case.
+   *
+   * The query is profiled if it asks for it or if the slow query log is
+   * enabled. A profile covers the chunks of this call, resumed calls get
+   * their own.
+   *
+   * With a result cache, a new query whose whole walk is cached and fits
+   * in one chunk is answered from the cache, with the version the walk was
+   * computed at. Other queries walk with a cursor, so that parked queries
+   * hold a frontier rather than a whole result.
+   *
+   * @param hyperbase Queried hyperbase
+   * @param query Query or resume request
+   * @param write Chunk writer of the stream
+   * @param cache Result cache of `hyperbase`, if any
+   * @param error Error message when returning false
+   * @return true if the stream ended normally or the client disconnected.
+   * @return false if the request is invalid, e.g. an expired cursor, or if
+   * the walk overflowed, see base::LineageCursor, which drops the cursor.
+   */
+  bool StreamLineage(const base::Hyperbase& hyperbase,
+                     const LineageQuery& query,
+                     const std::function<bool(const LineageChunk&)>& write,
+                     std::string& error,
+                     base::QueryResultCache* cache = nullptr);
+
+  /**
+   * @brief Drop cursors idle for longer than the TTL.
+   * @return size_t Number of dropped cursors
+   */
+  size_t Expire();
+
+  size_t Size() const;
+
+private:
+  struct Entry {
+    std::string hyperbase;
+    std::unique_ptr<base::LineageCursor> cursor;
+    // Chunks emitted so far, and the last one for replay.
+    uint64_t seq{0};
+    LineageChunk last;
+    uint64_t last_access{0};
+    bool busy{false};
+  };
+
+  // StreamLineage() without the call metrics.
+  bool Stream(const base::Hyperbase& hyperbase, const LineageQuery& query,
+              const std::function<bool(const LineageChunk&)>& write,
+              std::string& error, base::QueryResultCache* cache);
+  // Give a streamed entry back to the registry, or drop it once done.
+  void Release(const std::string& id, const std::shared_ptr<Entry>& entry);
+  size_t ExpireLocked(uint64_t now);
+
+  std::string NewId();
+  static std::string MakeToken(const std::string& id, uint64_t seq);
+  static bool ParseToken(const std::string& token, std::string& id,
+                         uint64_t& seq);
+
+  const uint64_t mTtlMillis;
+  const size_t mCapacity;
+  mutable std::mutex mMutex;
+  std::unordered_map<std::string, std::shared_ptr<Entry>> mEntries;
+  std::mt19937_64 mIdGen;
+};
+
+}  // namespace server
+}  // namespace hyperon
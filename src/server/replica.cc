@@ -0,0 +1,168 @@
+#include "server/replica.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "common/utils/time.h"
+
+namespace hyperon {
+namespace server {
+
+ReplicaFollower::ReplicaFollower(const base::HyperbasePtr& replica,
+                                 LogSourcePtr source, ResyncCallback resync)
+    : ReplicaFollower(replica, std::move(source), std::move(resync),
+                      Options()) {}
+
+ReplicaFollower::ReplicaFollower(const base::HyperbasePtr& replica,
+                                 LogSourcePtr source, ResyncCallback resync,
+                                 const Options& options)
+    : mSource(std::move(source)),
+      mResync(std::move(resync)),
+      mOptions(options),
+      mReplica(replica) {
+  mStatus.applied_version = replica->Version();
+}
+
+ReplicaFollower::~ReplicaFollower() { Stop(); }
+
+void ReplicaFollower::Start() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mStatus.running) return;
+  mStatus.running = true;
+  mStopping = false;
+  mTail = std::thread(&ReplicaFollower::Run, this);
+}
+
+void ReplicaFollower::Stop() {
+  mStopping = true;
+  if (mTail.joinable()) mTail.join();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mStatus.running = false;
+  mApplied.notify_all();
+}
+
+base::HyperbasePtr ReplicaFollower::Hyperbase() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mReplica;
+}
+
+ReplicationStatus ReplicaFollower::Status() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  ReplicationStatus status = mStatus;
+  if (mPendingCommitTime > 0) {
+    uint64_t now = common::now_millis();
+    status.lag_millis =
+        now > mPendingCommitTime ? now - mPendingCommitTime : 0;
+  }
+  return status;
+}
+
+bool ReplicaFollower::WaitForVersion(uint64_t min_version,
+                                     uint64_t timeout_millis,
+                                     base::HyperbasePtr& replica) const {
+  std::unique_lock<std::mutex> lock(mMutex);
+  bool reached = mApplied.wait_for(
+      lock, std::chrono::milliseconds(timeout_millis), [this, min_version] {
+        return mStatus.applied_version >= min_version || !mStatus.running;
+      });
+  if (!reached || mStatus.applied_version < min_version) return false;
+  replica = mReplica;
+  return true;
+}
+
+std::string ReplicaFollower::LastError() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mLastError;
+}
+
+void ReplicaFollower::Run() {
+  std::vector<base::LogEntry> entries;
+  std::vector<base::Mutation> batch;
+  while (!mStopping) {
+    base::HyperbasePtr replica = Hyperbase();
+    uint64_t after = replica->Version();
+
+    // One entry more than applied, so that the commit time of the oldest
+    // entry still pending after a partial catch-up is known.
+    entries.clear();
+    if (!mSource->ReadAfter(after, mOptions.batch_entries + 1,
+                            mOptions.poll_millis, entries)) {
+      if (!Resync()) {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(mOptions.poll_millis));
+      }
+      continue;
+    }
+    uint64_t leader_version = mSource->LastVersion();
+
+    if (entries.empty()) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStatus.leader_version = leader_version;
+      mStatus.lag_versions = 0;
+      mPendingCommitTime = 0;
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStatus.leader_version = leader_version;
+      mPendingCommitTime = entries.front().commit_time;
+    }
+
+    size_t count =
+        std::min(entries.size(), std::max<size_t>(mOptions.batch_entries, 1));
+    batch.clear();
+    for (size_t i = 0; i < count; ++i) {
+      for (auto& mut : entries[i].mutations) batch.push_back(std::move(mut));
+    }
+    base::BatchResult result =
+        replica->ApplyReplicatedBatch(batch, entries[count - 1].version);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (result.failed > 0) {
+      // The leader logs only mutations that took effect, so a failure means
+      // the replica diverged, e.g. because of a memory quota.
+      mLastError = "replica diverged from leader at version " +
+                   std::to_string(result.version);
+    }
+    mStatus.applied_version = result.version;
+    mStatus.lag_versions = leader_version > result.version
+                               ? leader_version - result.version
+                               : 0;
+    mPendingCommitTime = 0;
+    if (mStatus.lag_versions > 0) {
+      // Without the extra entry, the leader committed after the read.
+      mPendingCommitTime = count < entries.size()
+                               ? entries[count].commit_time
+                               : common::now_millis();
+    }
+    mApplied.notify_all();
+  }
+}
+
+bool ReplicaFollower::Resync() {
+  base::HyperbasePtr fresh;
+  std::string error;
+  if (!mResync || !mResync(fresh, error) || !fresh) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mLastError = mResync ? "resync failed: " + error
+                         : "log truncated and no resync configured";
+    return false;
+  }
+  uint64_t leader_version = mSource->LastVersion();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mReplica = fresh;
+  mStatus.applied_version = fresh->Version();
+  mStatus.leader_version = leader_version;
+  mStatus.lag_versions = leader_version > mStatus.applied_version
+                             ? leader_version - mStatus.applied_version
+                             : 0;
+  ++mStatus.resyncs;
+  mPendingCommitTime = 0;
+  mLastError.clear();
+  mApplied.notify_all();
+  return true;
+}
+
+}  // namespace server
+}  // namespace hyperon
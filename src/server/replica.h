@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/storage/mutation_log.h"
+#include "server/rpc_metrics.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Replication progress of a follower, mirrors api.v1.ReplicationStatus.
+ */
+struct ReplicationStatus {
+  uint64_t applied_version{0};
+  // Latest leader version seen by the follower.
+  uint64_t leader_version{0};
+  uint64_t lag_versions{0};
+  // Age of the oldest leader commit not yet applied, 0 when caught up.
+  uint64_t lag_millis{0};
+  uint64_t resyncs{0};
+  bool running{false};
+};
+
+/**
+ * @brief Leader side of the TailLog stream as seen by a follower.
+ */
+class LogSource {
+public:
+  virtual ~LogSource() = default;
+
+  /**
+   * @brief Same contract as base::MutationLog::ReadAfter().
+   */
+  virtual bool ReadAfter(uint64_t after_version, size_t max_entries,
+                         uint64_t wait_millis,
+                         std::vector<base::LogEntry>& out) = 0;
+
+  virtual uint64_t LastVersion() = 0;
+};
+using LogSourcePtr = std::shared_ptr<LogSource>;
+
+/**
+ * @brief Log source backed by a mutation log of the same process.
+ */
+class LocalLogSource : public LogSource {
+public:
+  explicit LocalLogSource(std::shared_ptr<base::MutationLog> log)
+      : mLog(std::move(log)) {}
+
+  /* override */ bool ReadAfter(uint64_t after_version, size_t max_entries,
+                                uint64_t wait_millis,
+                                std::vector<base::LogEntry>& out) {
+    RpcScope scope(RPC_TAIL_LOG);
+    if (mLog->ReadAfter(after_version, max_entries, wait_millis, out)) {
+      return true;
+    }
+    scope.Fail();
+    return false;
+  }
+
+  /* override */ uint64_t LastVersion() { return mLog->LastVersion(); }
+
+private:
+  std::shared_ptr<base::MutationLog> mLog;
+};
+
+/**
+ * @brief Read replica of a leader hyperbase.
+ *
+ * A tail thread pulls committed entries from the leader's log, concatenates
+ * up to `batch_entries` of them and applies them with one
+ * Hyperbase::ApplyReplicatedBatch, so the replica exposes leader versions
+ * and readers can compare them across instances. Readers only ever see
+ * states at entry boundaries the leader also went through.
+ *
+ * If the follower fell behind the leader's retained log, the resync callback
+ * provides a fresh copy, typically loaded from the latest snapshot, and
+ * tailing resumes from its version.
+ */
+class ReplicaFollower {
+public:
+  using ResyncCallback =
+      std::function<bool(base::HyperbasePtr& fresh, std::string& error)>;
+
+  struct Options {
+    size_t batch_entries{64};
+    uint64_t poll_millis{100};
+  };
+
+  ReplicaFollower(const base::HyperbasePtr& replica, LogSourcePtr source,
+                  ResyncCallback resync);
+  ReplicaFollower(const base::HyperbasePtr& replica, LogSourcePtr source,
+                  ResyncCallback resync, const Options& options);
+  ~ReplicaFollower();
+
+  ReplicaFollower(const ReplicaFollower&) = delete;
+  ReplicaFollower& operator=(const ReplicaFollower&) = delete;
+
+  void Start();
+  void Stop();
+
+  /**
+   * @brief Current replica, may be replaced by a resync.
+   */
+  base::HyperbasePtr Hyperbase() const;
+
+  ReplicationStatus Status() const;
+
+  /**
+   * @brief Wait until the replica reached `min_version`, for reads that must
+   * not be older than a version the client already observed.
+   *
+   * @param min_version Minimal acceptable version, 0 for any
+   * @param timeout_millis Upper bound of the wait
+   * @param replica Replica to read from, set on success
+   * @return true if the replica is at `min_version` or later.
+   */
+  bool WaitForVersion(uint64_t min_version, uint64_t timeout_millis,
+                      base::HyperbasePtr& replica) const;
+
+  // Last error of the tail thread, empty if none.
+  std::string LastError() const;
+
+private:
+  void Run();
+  bool Resync();
+
+  LogSourcePtr mSource;
+  ResyncCallback mResync;
+  const Options mOptions;
+
+  mutable std::mutex mMutex;
+  mutable std::condition_variable mApplied;
+  base::HyperbasePtr mReplica;
+  ReplicationStatus mStatus;
+  uint64_t mPendingCommitTime{0};
+  std::string mLastError;
+
+  std::atomic<bool> mStopping{false};
+  std::thread mTail;
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,98 @@
+#include "server/rpc_metrics.h"
+
+#include <fmt/core.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+const char* const kMethodNames[RPC_METHOD_COUNT] = {
+    "CreateHyperbase", "FetchHyperbase", "DeleteHyperbase", "BulkIngest",
+    "StreamLineage",   "TailLog",        "ExportJson",      "ImportJson",
+    "FetchMetrics",    "ApplyShardBatch", "FetchAdjacency",  "QueryEvents",
+    "FetchConcepts",   "FetchCategory",
+};
+
+struct MethodMetrics {
+  common::Counter ok;
+  common::Counter failed;
+  common::Histogram latency;
+
+  explicit MethodMetrics(const std::string& method)
+      : ok("hyperon_rpc_requests_total", "RPC calls by method and outcome.",
+           fmt::format("method=\"{}\",outcome=\"ok\"", method)),
+        failed("hyperon_rpc_requests_total",
+               "RPC calls by method and outcome.",
+               fmt::format("method=\"{}\",outcome=\"error\"", method)),
+        latency("hyperon_rpc_latency_seconds",
+                "RPC latency by method; streaming calls count each message "
+                "or chunk batch.",
+                fmt::format("method=\"{}\"", method)) {}
+};
+
+const std::vector<std::unique_ptr<MethodMetrics>>& method_metrics() {
+  static const auto* metrics = [] {
+    auto* all = new std::vector<std::unique_ptr<MethodMetrics>>();
+    for (const char* name : kMethodNames) {
+      all->push_back(std::make_unique<MethodMetrics>(name));
+    }
+    return all;
+  }();
+  return *metrics;
+}
+
+}  // namespace
+
+const char* rpc_method_name(RPC_METHOD method) {
+  return method < RPC_METHOD_COUNT ? kMethodNames[method] : "Unknown";
+}
+
+RpcScope::RpcScope(RPC_METHOD method)
+    : mMethod(method), mStart(std::chrono::steady_clock::now()) {}
+
+RpcScope::~RpcScope() {
+  const MethodMetrics& metrics = *method_metrics()[mMethod];
+  (mFailed ? metrics.failed : metrics.ok).Add();
+  metrics.latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - mStart)
+                             .count());
+}
+
+void collect_metrics(common::MetricsSnapshot& out) {
+  RpcScope scope(RPC_FETCH_METRICS);
+  // Register every method up front, so that scrapes list all series.
+  method_metrics();
+  common::MetricsRegistry::Instance().Snapshot(out);
+}
+
+void fetch_metrics(const std::string& prefix, std::vector<MetricSeries>& out) {
+  common::MetricsSnapshot snapshot;
+  collect_metrics(snapshot);
+  for (const auto& sample : snapshot) {
+    if (sample.name.compare(0, prefix.size(), prefix) != 0) continue;
+    MetricSeries series;
+    series.name = sample.name;
+    series.labels = sample.labels;
+    series.type = sample.type;
+    series.value = sample.value;
+    if (sample.type == common::MetricSample::HISTOGRAM) {
+      const common::HistogramSnapshot& h = sample.histogram;
+      series.latency.count = h.count;
+      series.latency.sum = h.sum;
+      series.latency.p50 = h.Quantile(0.5);
+      series.latency.p90 = h.Quantile(0.9);
+      series.latency.p99 = h.Quantile(0.99);
+      series.latency.p999 = h.Quantile(0.999);
+      series.latency.max = h.Max();
+    }
+    out.push_back(std::move(series));
+  }
+}
+
+}  // namespace server
+}  // namespace hyperon
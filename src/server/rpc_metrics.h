@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/metrics/metrics.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Methods of the HyperbaseService and ShardService APIs.
+ */
+enum RPC_METHOD {
+  RPC_CREATE_HYPERBASE,
+  RPC_FETCH_HYPERBASE,
+  RPC_DELETE_HYPERBASE,
+  RPC_BULK_INGEST,
+  RPC_STREAM_LINEAGE,
+  RPC_TAIL_LOG,
+  RPC_EXPORT_JSON,
+  RPC_IMPORT_JSON,
+  RPC_FETCH_METRICS,
+  RPC_APPLY_SHARD_BATCH,
+  RPC_FETCH_ADJACENCY,
+  RPC_QUERY_EVENTS,
+  RPC_FETCH_CONCEPTS,
+  RPC_FETCH_CATEGORY,
+  RPC_METHOD_COUNT,
+};
+
+const char* rpc_method_name(RPC_METHOD method);
+
+/**
+ * @brief Count one call of `method` and record its latency, labeled by
+ * method and by outcome. Calls are successful unless Fail() is called.
+ */
+class RpcScope {
+public:
+  explicit RpcScope(RPC_METHOD method);
+  ~RpcScope();
+
+  RpcScope(const RpcScope&) = delete;
+  RpcScope& operator=(const RpcScope&) = delete;
+
+  inline void Fail() { mFailed = true; }
+
+private:
+  RPC_METHOD mMethod;
+  bool mFailed{false};
+  std::chrono::steady_clock::time_point mStart;
+};
+
+/**
+ * @brief Scrape of all process metrics, as served by FetchMetrics and the
+ * Prometheus endpoint.
+ */
+void collect_metrics(common::MetricsSnapshot& out);
+
+/**
+ * @brief Latencies of a histogram in nanoseconds, mirrors
+ * api.v1.LatencySummary. Quantiles are upper bounds of their bucket.
+ */
+struct LatencySummary {
+  uint64_t count{0};
+  uint64_t sum{0};
+  uint64_t p50{0};
+  uint64_t p90{0};
+  uint64_t p99{0};
+  uint64_t p999{0};
+  uint64_t max{0};
+};
+
+/**
+ * @brief One series of the FetchMetrics RPC, mirrors api.v1.MetricSeries.
+ */
+struct MetricSeries {
+  std::string name;
+  std::string labels;
+  common::MetricSample::METRIC_TYPE type{common::MetricSample::COUNTER};
+  // Counters and gauges.
+  double value{0};
+  // Histograms.
+  LatencySummary latency;
+};
+
+/**
+ * @brief Handler of the FetchMetrics RPC, the series of a scrape whose name
+ * starts with `prefix`, all if empty, with histograms summarized.
+ */
+void fetch_metrics(const std::string& prefix, std::vector<MetricSeries>& out);
+
+}  // namespace server
+}  // namespace hyperon
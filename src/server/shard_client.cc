@@ -0,0 +1,147 @@
+#include "server/shard_client.h"
+
+#include <mutex>
+#include <shared_mutex>
+
+#include "server/rpc_metrics.h"
+#include "server/slow_query_log.h"
+
+namespace hyperon {
+namespace server {
+
+const char* const kGhostCategory = "__ghost__";
+
+base::BatchResult apply_shard_batch(base::Hyperbase& hyperbase,
+                                    const ShardBatch& batch,
+                                    std::vector<uint32_t>* failed) {
+  RpcScope scope(RPC_APPLY_SHARD_BATCH);
+  // Ghosts go first in a separate commit, so that the result only counts
+  // the routed mutations. Creating an existing ghost is a no-op.
+  if (!batch.ghosts.empty()) {
+    std::vector<base::Mutation> ghosts;
+    {
+      std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+      for (const auto& ghost : batch.ghosts) {
+        if (hyperbase.HasConcept(ghost.name)) continue;
+        base::Mutation mut;
+        mut.concept_kind = ghost.kind;
+        mut.category = kGhostCategory;
+        mut.subject = ghost.name;
+        ghosts.push_back(std::move(mut));
+      }
+    }
+    if (!ghosts.empty()) hyperbase.ApplyBatch(ghosts);
+  }
+  return hyperbase.ApplyBatch(batch.mutations, failed);
+}
+
+void fetch_adjacency(const base::Hyperbase& hyperbase,
+                     const std::vector<std::string>& names,
+                     base::LineageCursor::DIRECTION direction,
+                     std::vector<std::vector<std::string>>& adjacency,
+                     common::ProfileNode* profile) {
+  RpcScope scope(RPC_FETCH_ADJACENCY);
+  SlowQueryLog& slow_log = SlowQueryLog::Instance();
+  common::ProfileNode local;
+  if (!profile && slow_log.Enabled()) profile = &local;
+  bool descend = direction == base::LineageCursor::DESCENDANTS;
+  if (profile) {
+    *profile = common::ProfileNode("fetch_adjacency",
+                                   descend ? "children" : "parents");
+    profile->loops = 1;
+    profile->rows_in = names.size();
+  }
+  common::ProfileTimer timer(profile);
+  common::ProfileNode* wait = common::profile_child(profile, "lock_wait");
+  common::ProfileNode* index =
+      common::profile_child(profile, "concept_index", "", "hash");
+
+  adjacency.assign(names.size(), {});
+  {
+    common::ProfileTimer wait_timer(wait);
+    std::shared_lock<std::shared_mutex> lock(hyperbase.Mutex());
+    wait_timer.Stop();
+    uint64_t found = 0;
+    uint64_t edges = 0;
+    for (size_t i = 0; i < names.size(); ++i) {
+      base::ConceptPtr cnpt;
+      if (!hyperbase.GetConcept(names[i], cnpt)) continue;
+      ++found;
+      auto& out = adjacency[i];
+      auto collect = [&out](const base::ElementPtr& next) {
+        out.push_back(next->SemName());
+      };
+      if (descend) {
+        out.reserve(cnpt->ChildCount());
+        cnpt->ForEachChild(collect);
+      } else {
+        out.reserve(cnpt->ParentCount());
+        cnpt->ForEachParent(collect);
+      }
+      edges += out.size();
+    }
+    if (profile) {
+      index->loops = 1;
+      index->rows_in = names.size();
+      index->rows_out = found;
+      profile->rows_out = edges;
+    }
+  }
+  if (profile) {
+    timer.Stop();
+    slow_log.Record(RPC_FETCH_ADJACENCY, hyperbase.Name(), *profile);
+  }
+}
+
+common::Task<ApplyReply> ShardClient::ApplyAsync(ShardBatch batch) {
+  return common::run_async(*mExecutor, [this, batch = std::move(batch)] {
+    ApplyReply reply;
+    reply.ok = Apply(batch, reply.result, reply.failed, reply.error);
+    return reply;
+  });
+}
+
+common::Task<AdjacencyReply> ShardClient::FetchAdjacencyAsync(
+    std::vector<std::string> names,
+    base::LineageCursor::DIRECTION direction) {
+  return common::run_async(
+      *mExecutor, [this, names = std::move(names), direction] {
+        AdjacencyReply reply;
+        reply.ok =
+            FetchAdjacency(names, direction, reply.adjacency, reply.error);
+        return reply;
+      });
+}
+
+common::Task<ContainsReply> ShardClient::HasConceptAsync(std::string name) {
+  return common::run_async(*mExecutor, [this, name = std::move(name)] {
+    ContainsReply reply;
+    reply.ok = HasConcept(name, reply.found, reply.error);
+    return reply;
+  });
+}
+
+bool LocalShardClient::Apply(const ShardBatch& batch,
+                             base::BatchResult& result,
+                             std::vector<uint32_t>& failed, std::string&) {
+  result = apply_shard_batch(*mHyperbase, batch, &failed);
+  return true;
+}
+
+bool LocalShardClient::FetchAdjacency(
+    const std::vector<std::string>& names,
+    base::LineageCursor::DIRECTION direction,
+    std::vector<std::vector<std::string>>& adjacency, std::string&) {
+  fetch_adjacency(*mHyperbase, names, direction, adjacency);
+  return true;
+}
+
+bool LocalShardClient::HasConcept(const std::string& name, bool& found,
+                                  std::string&) {
+  std::shared_lock<std::shared_mutex> lock(mHyperbase->Mutex());
+  found = mHyperbase->HasConcept(name);
+  return true;
+}
+
+}  // namespace server
+}  // namespace hyperon
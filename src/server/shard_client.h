@@ -0,0 +1,159 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/core/hyperbase.h"
+#include "base/core/mutation.h"
+#include "base/query/lineage_cursor.h"
+#include "common/async/task.h"
+#include "common/profile/query_profile.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Mutations routed to one shard, mirrors api.v1.ShardBatchRequest.
+ *
+ * A lineage edge or membership may connect concepts owned by different
+ * shards. Each side then refers to the remote end through a ghost: a plain
+ * stub concept in the reserved ghost category, created on demand before the
+ * mutations are applied.
+ */
+struct ShardBatch {
+  struct Ghost {
+    std::string name;
+    base::Mutation::CONCEPT_KIND kind{base::Mutation::KIND_CONCEPT};
+  };
+  std::vector<Ghost> ghosts;
+  std::vector<base::Mutation> mutations;
+};
+
+/**
+ * @brief Outcomes of asynchronous shard calls, with the results of the
+ * matching synchronous ones.
+ */
+struct ApplyReply {
+  bool ok{false};
+  std::string error;
+  base::BatchResult result;
+  // Positions of the mutations of the batch that did not take effect.
+  std::vector<uint32_t> failed;
+};
+
+struct AdjacencyReply {
+  bool ok{false};
+  std::string error;
+  std::vector<std::vector<std::string>> adjacency;
+};
+
+struct ContainsReply {
+  bool ok{false};
+  std::string error;
+  bool found{false};
+};
+
+/**
+ * @brief Connection from the routing layer to one shard. A remote
+ * implementation issues the ShardService RPCs, one call per method
+ * invocation, so every method takes a whole batch. RemoteShardClient in
+ * shard_transport.h is the one for shards in other processes.
+ *
+ * Every call also has an asynchronous form completing on an executor. The
+ * defaults run the synchronous call there; remote implementations override
+ * them to keep many calls in flight without holding a thread each. The
+ * client must outlive its pending calls.
+ */
+class ShardClient {
+public:
+  virtual ~ShardClient() = default;
+
+  // Executor of the default asynchronous calls, the shared one unless set.
+  inline void SetExecutor(common::Executor& executor) {
+    mExecutor = &executor;
+  }
+
+  virtual common::Task<ApplyReply> ApplyAsync(ShardBatch batch);
+  virtual common::Task<AdjacencyReply> FetchAdjacencyAsync(
+      std::vector<std::string> names,
+      base::LineageCursor::DIRECTION direction);
+  virtual common::Task<ContainsReply> HasConceptAsync(std::string name);
+
+  /**
+   * @brief Apply a batch, ghosts first.
+   *
+   * @param batch Routed mutations and the ghosts they need
+   * @param result Counts and version of the shard
+   * @param failed Appended positions in `batch.mutations` of the mutations
+   * that did not take effect
+   * @param error Error message on failure
+   * @return true if the shard applied the batch, even partially.
+   */
+  virtual bool Apply(const ShardBatch& batch, base::BatchResult& result,
+                     std::vector<uint32_t>& failed, std::string& error) = 0;
+
+  /**
+   * @brief Fetch the direct lineage of many concepts in one round trip.
+   *
+   * @param names Concepts owned by the shard
+   * @param direction Children or parents
+   * @param adjacency One list per requested name, empty for unknown names
+   * @param error Error message on failure
+   * @return true on success.
+   */
+  virtual bool FetchAdjacency(
+      const std::vector<std::string>& names,
+      base::LineageCursor::DIRECTION direction,
+      std::vector<std::vector<std::string>>& adjacency,
+      std::string& error) = 0;
+
+  virtual bool HasConcept(const std::string& name, bool& found,
+                          std::string& error) = 0;
+
+protected:
+  common::Executor* mExecutor{&common::Executor::Default()};
+};
+
+// Category holding ghost concepts on a shard.
+extern const char* const kGhostCategory;
+
+/**
+ * @brief Shard-side handlers of ShardService, shared by the RPC service and
+ * LocalShardClient.
+ */
+base::BatchResult apply_shard_batch(base::Hyperbase& hyperbase,
+                                    const ShardBatch& batch,
+                                    std::vector<uint32_t>* failed = nullptr);
+
+// Profiled if `profile` is set or the slow query log is enabled.
+void fetch_adjacency(const base::Hyperbase& hyperbase,
+                     const std::vector<std::string>& names,
+                     base::LineageCursor::DIRECTION direction,
+                     std::vector<std::vector<std::string>>& adjacency,
+                     common::ProfileNode* profile = nullptr);
+
+/**
+ * @brief Shard living in the same process, for tests and single-box setups.
+ */
+class LocalShardClient : public ShardClient {
+public:
+  explicit LocalShardClient(const base::HyperbasePtr& hyperbase)
+      : mHyperbase(hyperbase) {}
+
+  inline const base::HyperbasePtr& Hyperbase() const { return mHyperbase; }
+
+  /* override */ bool Apply(const ShardBatch& batch, base::BatchResult& result,
+                            std::vector<uint32_t>& failed, std::string& error);
+  /* override */ bool FetchAdjacency(
+      const std::vector<std::string>& names,
+      base::LineageCursor::DIRECTION direction,
+      std::vector<std::vector<std::string>>& adjacency, std::string& error);
+  /* override */ bool HasConcept(const std::string& name, bool& found,
+                                 std::string& error);
+
+private:
+  base::HyperbasePtr mHyperbase;
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,630 @@
+#include "server/shard_transport.h"
+
+#include <arpa/inet.h>
+#include <fmt/core.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <shared_mutex>
+
+#include "common/proto/wire_reader.h"
+#include "common/proto/wire_writer.h"
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+using common::ProtoReader;
+using common::ProtoWriter;
+
+constexpr int kPollMillis = 200;
+// Time allowed to a router to send the rest of a frame.
+constexpr int kFrameMillis = 10000;
+constexpr uint32_t kResponseFailed = 1;
+
+void set_timeout(int fd, uint32_t millis) {
+  timeval timeout{static_cast<time_t>(millis / 1000),
+                  static_cast<suseconds_t>(millis % 1000 * 1000)};
+  ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+std::string socket_error(ssize_t n) {
+  if (n == 0) return "connection closed";
+  if (errno == EAGAIN || errno == EWOULDBLOCK) return "timed out";
+  return std::strerror(errno);
+}
+
+bool send_all(int fd, const char* data, size_t size, int flags,
+              std::string& error) {
+  size_t sent = 0;
+  while (sent < size) {
+    ssize_t n = ::send(fd, data + sent, size - sent, flags | MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      error = socket_error(n);
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool recv_all(int fd, char* data, size_t size, std::string& error) {
+  size_t received = 0;
+  while (received < size) {
+    ssize_t n = ::recv(fd, data + received, size - received, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      error = socket_error(n);
+      return false;
+    }
+    received += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Send the length of `message` and the message, after `prefix` if any.
+bool send_frame(int fd, const std::string& prefix, const std::string& message,
+                std::string& error) {
+  std::string header = prefix;
+  common::put_varint(header, message.size());
+  return send_all(fd, header.data(), header.size(), MSG_MORE, error) &&
+         send_all(fd, message.data(), message.size(), 0, error);
+}
+
+// Read a length and as many bytes into `message`.
+bool recv_frame(int fd, std::string& message, std::string& error) {
+  uint64_t size = 0;
+  for (unsigned shift = 0;; shift += 7) {
+    char byte = 0;
+    if (!recv_all(fd, &byte, 1, error)) return false;
+    size |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) break;
+    if (shift >= 28) {
+      error = "malformed frame length";
+      return false;
+    }
+  }
+  if (size > kMaxShardFrameBytes) {
+    error = fmt::format("frame of {} bytes exceeds the limit", size);
+    return false;
+  }
+  message.resize(size);
+  return recv_all(fd, &message[0], size, error);
+}
+
+void write_failure(const std::string& message, std::string& out) {
+  out.clear();
+  ProtoWriter writer(out);
+  writer.Varint(1, kResponseFailed);
+  writer.String(2, message);
+}
+
+// Response code and message common to every response, false if failed.
+bool read_status(uint32_t field, ProtoReader& reader, uint64_t& code,
+                 std::string& message) {
+  if (field == 1) return reader.Varint(code);
+  return reader.String(message);
+}
+
+/* api.v1.ShardBatchRequest */
+
+void write_shard_batch(const std::string& hyperbase, const ShardBatch& batch,
+                       std::string& out) {
+  out.clear();
+  ProtoWriter writer(out);
+  writer.String(1, hyperbase);
+  for (const auto& ghost : batch.ghosts) {
+    auto mark = writer.Begin(2);
+    writer.String(1, ghost.name);
+    if (ghost.kind) writer.Varint(2, ghost.kind);
+    writer.End(mark);
+  }
+  for (const auto& mut : batch.mutations) {
+    auto mark = writer.Begin(3);
+    if (mut.kind) writer.Varint(1, mut.kind);
+    if (mut.concept_kind) writer.Varint(2, mut.concept_kind);
+    if (!mut.category.empty()) writer.String(3, mut.category);
+    writer.String(4, mut.subject);
+    for (const auto& object : mut.objects) writer.String(5, object);
+    writer.End(mark);
+  }
+}
+
+bool read_concept_kind(ProtoReader& reader,
+                       base::Mutation::CONCEPT_KIND& kind) {
+  uint64_t value = 0;
+  if (!reader.Varint(value) || value > base::Mutation::KIND_EVENT) {
+    return false;
+  }
+  kind = static_cast<base::Mutation::CONCEPT_KIND>(value);
+  return true;
+}
+
+bool read_mutation(ProtoReader& reader, base::Mutation& mut) {
+  uint32_t field = 0;
+  ProtoReader::WIRE_TYPE type;
+  uint64_t value = 0;
+  while (reader.Next(field, type)) {
+    bool ok = true;
+    switch (field) {
+      case 1:
+        ok = reader.Varint(value) && value <= base::Mutation::MUT_ADD_UNION;
+        mut.kind = static_cast<base::Mutation::MUTATION_KIND>(value);
+        break;
+      case 2:
+        ok = read_concept_kind(reader, mut.concept_kind);
+        break;
+      case 3:
+        ok = reader.String(mut.category);
+        break;
+      case 4:
+        ok = reader.String(mut.subject);
+        break;
+      case 5:
+        mut.objects.emplace_back();
+        ok = reader.String(mut.objects.back());
+        break;
+      default:
+        ok = reader.Skip(type);
+    }
+    if (!ok) return false;
+  }
+  return reader.Ok();
+}
+
+bool read_shard_batch(const std::string& in, std::string& hyperbase,
+                      ShardBatch& batch) {
+  ProtoReader reader(in);
+  ProtoReader nested(in);
+  uint32_t field = 0;
+  ProtoReader::WIRE_TYPE type;
+  while (reader.Next(field, type)) {
+    bool ok = true;
+    if (field == 1) {
+      ok = reader.String(hyperbase);
+    } else if (field == 2) {
+      batch.ghosts.emplace_back();
+      auto& ghost = batch.ghosts.back();
+      uint32_t ghost_field = 0;
+      ok = reader.Message(nested);
+      while (ok && nested.Next(ghost_field, type)) {
+        if (ghost_field == 1) {
+          ok = nested.String(ghost.name);
+        } else if (ghost_field == 2) {
+          ok = read_concept_kind(nested, ghost.kind);
+        } else {
+          ok = nested.Skip(type);
+        }
+      }
+      ok = ok && nested.Ok();
+    } else if (field == 3) {
+      batch.mutations.emplace_back();
+      ok = reader.Message(nested) && read_mutation(nested,
+                                                   batch.mutations.back());
+    } else {
+      ok = reader.Skip(type);
+    }
+    if (!ok) return false;
+  }
+  return reader.Ok();
+}
+
+/* api.v1.ShardBatchResponse */
+
+void write_batch_result(const base::BatchResult& result,
+                        const std::vector<uint32_t>& failed,
+                        std::string& out) {
+  out.clear();
+  ProtoWriter writer(out);
+  if (result.applied) writer.Varint(3, result.applied);
+  if (result.failed) writer.Varint(4, result.failed);
+  if (result.version) writer.Varint(5, result.version);
+  auto mark = writer.Begin(6);
+  for (uint32_t position : failed) writer.Packed(position);
+  writer.End(mark, false);
+}
+
+bool read_batch_result(const std::string& in, base::BatchResult& result,
+                       std::vector<uint32_t>& failed, std::string& error) {
+  ProtoReader reader(in);
+  ProtoReader packed(in);
+  uint64_t code = 0;
+  uint64_t value = 0;
+  uint32_t field = 0;
+  ProtoReader::WIRE_TYPE type;
+  while (reader.Next(field, type)) {
+    bool ok = true;
+    switch (field) {
+      case 1:
+      case 2:
+        ok = read_status(field, reader, code, error);
+        break;
+      case 3:
+        ok = reader.Varint(result.applied);
+        break;
+      case 4:
+        ok = reader.Varint(result.failed);
+        break;
+      case 5:
+        ok = reader.Varint(result.version);
+        break;
+      case 6:
+        // Packed as written, one by one as older encoders do.
+        if (type == ProtoWriter::WIRE_VARINT) {
+          ok = reader.Varint(value);
+          failed.push_back(static_cast<uint32_t>(value));
+          break;
+        }
+        ok = reader.Message(packed);
+        while (ok && !packed.AtEnd()) {
+          ok = packed.Varint(value);
+          failed.push_back(static_cast<uint32_t>(value));
+        }
+        break;
+      default:
+        ok = reader.Skip(type);
+    }
+    if (!ok) break;
+  }
+  if (!reader.Ok()) {
+    error = "malformed ShardBatchResponse";
+    return false;
+  }
+  if (code != 0 && error.empty()) error = "shard batch failed";
+  return code == 0;
+}
+
+/* api.v1.AdjacencyRequest */
+
+void write_adjacency_request(const std::string& hyperbase,
+                             const std::vector<std::string>& names,
+                             base::LineageCursor::DIRECTION direction,
+                             std::string& out) {
+  out.clear();
+  ProtoWriter writer(out);
+  writer.String(1, hyperbase);
+  for (const auto& name : names) writer.String(2, name);
+  if (direction == base::LineageCursor::ANCESTORS) writer.Varint(3, 1);
+}
+
+bool read_adjacency_request(const std::string& in, std::string& hyperbase,
+                            std::vector<std::string>& names,
+                            base::LineageCursor::DIRECTION& direction) {
+  ProtoReader reader(in);
+  uint64_t value = 0;
+  uint32_t field = 0;
+  ProtoReader::WIRE_TYPE type;
+  direction = base::LineageCursor::DESCENDANTS;
+  while (reader.Next(field, type)) {
+    bool ok = true;
+    if (field == 1) {
+      ok = reader.String(hyperbase);
+    } else if (field == 2) {
+      names.emplace_back();
+      ok = reader.String(names.back());
+    } else if (field == 3) {
+      ok = reader.Varint(value) && value <= 1;
+      if (value) direction = base::LineageCursor::ANCESTORS;
+    } else {
+      ok = reader.Skip(type);
+    }
+    if (!ok) return false;
+  }
+  return reader.Ok();
+}
+
+/* api.v1.AdjacencyResponse */
+
+void write_adjacency(const std::vector<std::vector<std::string>>& adjacency,
+                     const std::vector<bool>& found, std::string& out) {
+  out.clear();
+  ProtoWriter writer(out);
+  for (size_t i = 0; i < adjacency.size(); ++i) {
+    auto mark = writer.Begin(3);
+    for (const auto& name : adjacency[i]) writer.String(1, name);
+    if (found[i]) writer.Bool(2, true);
+    writer.End(mark);
+  }
+}
+
+bool read_adjacency(const std::string& in,
+                    std::vector<std::vector<std::string>>& adjacency,
+                    std::vector<bool>& found, std::string& error) {
+  ProtoReader reader(in);
+  ProtoReader list(in);
+  uint64_t code = 0;
+  uint64_t value = 0;
+  uint32_t field = 0;
+  uint32_t list_field = 0;
+  ProtoReader::WIRE_TYPE type;
+  while (reader.Next(field, type)) {
+    bool ok = true;
+    if (field == 1 || field == 2) {
+      ok = read_status(field, reader, code, error);
+    } else if (field == 3) {
+      adjacency.emplace_back();
+      found.push_back(false);
+      ok = reader.Message(list);
+      while (ok && list.Next(list_field, type)) {
+        if (list_field == 1) {
+          adjacency.back().emplace_back();
+          ok = list.String(adjacency.back().back());
+        } else if (list_field == 2) {
+          ok = list.Varint(value);
+          found.back() = value != 0;
+        } else {
+          ok = list.Skip(type);
+        }
+      }
+      ok = ok && list.Ok();
+    } else {
+      ok = reader.Skip(type);
+    }
+    if (!ok) break;
+  }
+  if (!reader.Ok() || !list.Ok()) {
+    error = "malformed AdjacencyResponse";
+    return false;
+  }
+  if (code != 0 && error.empty()) error = "adjacency fetch failed";
+  return code == 0;
+}
+
+}  // namespace
+
+ShardEndpoint::~ShardEndpoint() { Stop(); }
+
+bool ShardEndpoint::Start(const std::string& address, uint16_t port,
+                          std::string& error) {
+  if (mThread.joinable()) {
+    error = "shard endpoint already started";
+    return false;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    error = fmt::format("invalid shard address '{}'", address);
+    return false;
+  }
+
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    error = fmt::format("socket: {}", std::strerror(errno));
+    return false;
+  }
+  int one = 1;
+  ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  socklen_t len = sizeof(addr);
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(fd, 16) != 0 ||
+      ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+    error = fmt::format("cannot listen on {}:{}: {}", address, port,
+                        std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+
+  mListenFd = fd;
+  mPort = ntohs(addr.sin_port);
+  mStopping = false;
+  mThread = std::thread(&ShardEndpoint::Run, this);
+  return true;
+}
+
+void ShardEndpoint::Stop() {
+  if (!mThread.joinable()) return;
+  mStopping = true;
+  mThread.join();
+  ::close(mListenFd);
+  mListenFd = -1;
+  Reap(true);
+}
+
+void ShardEndpoint::Run() {
+  pollfd listener{mListenFd, POLLIN, 0};
+  while (!mStopping) {
+    Reap(false);
+    listener.revents = 0;
+    if (::poll(&listener, 1, kPollMillis) <= 0) continue;
+    int fd = ::accept4(mListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) continue;
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    set_timeout(fd, kFrameMillis);
+    mConnections.emplace_back();
+    Connection& connection = mConnections.back();
+    connection.fd = fd;
+    connection.thread =
+        std::thread(&ShardEndpoint::Serve, this, std::ref(connection));
+  }
+}
+
+void ShardEndpoint::Reap(bool all) {
+  for (auto it = mConnections.begin(); it != mConnections.end();) {
+    if (!all && !it->done) {
+      ++it;
+      continue;
+    }
+    // Wakes up a connection waiting for its next request.
+    ::shutdown(it->fd, SHUT_RDWR);
+    it->thread.join();
+    ::close(it->fd);
+    it = mConnections.erase(it);
+  }
+}
+
+void ShardEndpoint::Serve(Connection& connection) {
+  int fd = connection.fd;
+  pollfd peer{fd, POLLIN, 0};
+  std::string request;
+  std::string response;
+  std::string error;
+  while (!mStopping) {
+    peer.revents = 0;
+    if (::poll(&peer, 1, kPollMillis) <= 0) continue;
+    char method = 0;
+    if (!recv_all(fd, &method, 1, error) ||
+        !recv_frame(fd, request, error) ||
+        !Handle(static_cast<uint8_t>(method), request, response) ||
+        !send_frame(fd, "", response, error)) {
+      break;
+    }
+  }
+  connection.done = true;
+}
+
+bool ShardEndpoint::Handle(uint8_t method, const std::string& request,
+                           std::string& response) {
+  std::string hyperbase;
+  if (method == SHARD_APPLY_BATCH) {
+    ShardBatch batch;
+    if (!read_shard_batch(request, hyperbase, batch)) {
+      write_failure("malformed ShardBatchRequest", response);
+    } else if (hyperbase != mHyperbase->Name()) {
+      write_failure(fmt::format("unknown hyperbase '{}'", hyperbase),
+                    response);
+    } else {
+      std::vector<uint32_t> failed;
+      base::BatchResult result =
+          apply_shard_batch(*mHyperbase, batch, &failed);
+      write_batch_result(result, failed, response);
+    }
+    return true;
+  }
+  if (method == SHARD_FETCH_ADJACENCY) {
+    std::vector<std::string> names;
+    base::LineageCursor::DIRECTION direction;
+    if (!read_adjacency_request(request, hyperbase, names, direction)) {
+      write_failure("malformed AdjacencyRequest", response);
+    } else if (hyperbase != mHyperbase->Name()) {
+      write_failure(fmt::format("unknown hyperbase '{}'", hyperbase),
+                    response);
+    } else {
+      std::vector<std::vector<std::string>> adjacency;
+      fetch_adjacency(*mHyperbase, names, direction, adjacency);
+      // Only concepts without edges may be unknown.
+      std::vector<bool> found(names.size(), true);
+      std::shared_lock<std::shared_mutex> lock(mHyperbase->Mutex());
+      for (size_t i = 0; i < names.size(); ++i) {
+        if (adjacency[i].empty()) found[i] = mHyperbase->HasConcept(names[i]);
+      }
+      lock.unlock();
+      write_adjacency(adjacency, found, response);
+    }
+    return true;
+  }
+  return false;
+}
+
+RemoteShardClient::~RemoteShardClient() { Disconnect(); }
+
+bool RemoteShardClient::Connect(std::string& error) {
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(mPort);
+  if (::inet_pton(AF_INET, mAddress.c_str(), &addr.sin_addr) != 1) {
+    error = fmt::format("invalid shard address '{}'", mAddress);
+    return false;
+  }
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    error = fmt::format("socket: {}", std::strerror(errno));
+    return false;
+  }
+  // Also bounds the time to connect.
+  set_timeout(fd, mTimeoutMillis);
+  int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    error = fmt::format("cannot connect to shard {}:{}: {}", mAddress, mPort,
+                        std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  mFd = fd;
+  return true;
+}
+
+void RemoteShardClient::Disconnect() {
+  if (mFd < 0) return;
+  ::close(mFd);
+  mFd = -1;
+}
+
+bool RemoteShardClient::Call(SHARD_METHOD method, std::string& error) {
+  if (mFd < 0 && !Connect(error)) return false;
+  std::string cause;
+  if (!send_frame(mFd, std::string(1, static_cast<char>(method)), mRequest,
+                  cause) ||
+      !recv_frame(mFd, mResponse, cause)) {
+    Disconnect();
+    error = fmt::format("shard {}:{}: {}", mAddress, mPort, cause);
+    return false;
+  }
+  return true;
+}
+
+bool RemoteShardClient::Apply(const ShardBatch& batch,
+                              base::BatchResult& result,
+                              std::vector<uint32_t>& failed,
+                              std::string& error) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  write_shard_batch(mHyperbase, batch, mRequest);
+  result = base::BatchResult();
+  return Call(SHARD_APPLY_BATCH, error) &&
+         read_batch_result(mResponse, result, failed, error);
+}
+
+bool RemoteShardClient::Adjacency(
+    const std::vector<std::string>& names,
+    base::LineageCursor::DIRECTION direction,
+    std::vector<std::vector<std::string>>& adjacency, std::vector<bool>& found,
+    std::string& error) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  write_adjacency_request(mHyperbase, names, direction, mRequest);
+  adjacency.clear();
+  found.clear();
+  if (!Call(SHARD_FETCH_ADJACENCY, error) ||
+      !read_adjacency(mResponse, adjacency, found, error)) {
+    return false;
+  }
+  if (adjacency.size() != names.size()) {
+    error = fmt::format("shard {}:{} answered {} of {} concepts", mAddress,
+                        mPort, adjacency.size(), names.size());
+    return false;
+  }
+  return true;
+}
+
+bool RemoteShardClient::FetchAdjacency(
+    const std::vector<std::string>& names,
+    base::LineageCursor::DIRECTION direction,
+    std::vector<std::vector<std::string>>& adjacency, std::string& error) {
+  std::vector<bool> found;
+  return Adjacency(names, direction, adjacency, found, error);
+}
+
+bool RemoteShardClient::HasConcept(const std::string& name, bool& found,
+                                   std::string& error) {
+  // Parents rather than children, of which there may be many.
+  std::vector<std::vector<std::string>> adjacency;
+  std::vector<bool> flags;
+  if (!Adjacency({name}, base::LineageCursor::ANCESTORS, adjacency, flags,
+                 error)) {
+    return false;
+  }
+  found = flags[0];
+  return true;
+}
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/shard_client.h"
+
+namespace hyperon {
+namespace server {
+
+/*
+ * ShardService over plain TCP, between the routing layer and shards living
+ * in other processes. Every call is one request frame answered by one
+ * response frame on a persistent connection:
+ *
+ *   request  = method byte, varint length, api.v1 request message
+ *   response = varint length, api.v1 response message
+ *
+ * with the length counting the bytes of the message. Methods are numbered in
+ * the order of the ShardService definition. A response_code other than 0
+ * fails the call with the message of the response.
+ */
+enum SHARD_METHOD : uint8_t {
+  SHARD_APPLY_BATCH = 1,
+  SHARD_FETCH_ADJACENCY = 2,
+};
+
+// Frames above this size are rejected by both ends.
+constexpr uint64_t kMaxShardFrameBytes = 64u << 20;
+
+/**
+ * @brief TCP listener serving ShardService for one shard of a hyperbase.
+ * Every connection is served on its own thread, a shard having one
+ * connection per router.
+ */
+class ShardEndpoint {
+public:
+  explicit ShardEndpoint(const base::HyperbasePtr& hyperbase)
+      : mHyperbase(hyperbase) {}
+  ~ShardEndpoint();
+
+  ShardEndpoint(const ShardEndpoint&) = delete;
+  ShardEndpoint& operator=(const ShardEndpoint&) = delete;
+
+  /**
+   * @brief Bind and start serving.
+   *
+   * @param address IPv4 address to bind, e.g. "0.0.0.0"
+   * @param port TCP port, 0 for an ephemeral one
+   * @param error Error message on failure
+   */
+  bool Start(const std::string& address, uint16_t port, std::string& error);
+  // Close the listener and every connection.
+  void Stop();
+
+  // Bound port, useful after starting on port 0.
+  inline uint16_t Port() const { return mPort; }
+
+private:
+  struct Connection {
+    int fd{-1};
+    std::atomic<bool> done{false};
+    std::thread thread;
+  };
+
+  void Run();
+  void Serve(Connection& connection);
+  // Joins the threads of connections closed by their peer.
+  void Reap(bool all);
+  /**
+   * @brief Handle one request, writing the response message to `response`.
+   * @return false for an unknown method.
+   */
+  bool Handle(uint8_t method, const std::string& request,
+              std::string& response);
+
+  base::HyperbasePtr mHyperbase;
+  int mListenFd{-1};
+  uint16_t mPort{0};
+  std::atomic<bool> mStopping{false};
+  std::thread mThread;
+  // Owned by the listener thread until it stops.
+  std::list<Connection> mConnections;
+};
+
+/**
+ * @brief Shard in another process, reached through its ShardEndpoint.
+ *
+ * Calls share one connection, opened on first use and again after a
+ * failure, and are sent one at a time; several clients to the same shard
+ * give more calls in flight. A call fails if the shard does not answer
+ * within the timeout. A failed call is not retried, the connection is
+ * dropped instead, as the response may still come, and the next call
+ * connects again.
+ */
+class RemoteShardClient : public ShardClient {
+public:
+  /**
+   * @param address IPv4 address of the shard
+   * @param port TCP port of its ShardEndpoint
+   * @param hyperbase Name of the hyperbase the shard holds
+   * @param timeout_millis Time allowed to connect and to answer a call
+   */
+  RemoteShardClient(const std::string& address, uint16_t port,
+                    const std::string& hyperbase,
+                    uint32_t timeout_millis = 5000)
+      : mAddress(address),
+        mPort(port),
+        mHyperbase(hyperbase),
+        mTimeoutMillis(timeout_millis) {}
+  ~RemoteShardClient();
+
+  RemoteShardClient(const RemoteShardClient&) = delete;
+  RemoteShardClient& operator=(const RemoteShardClient&) = delete;
+
+  /* override */ bool Apply(const ShardBatch& batch, base::BatchResult& result,
+                            std::vector<uint32_t>& failed, std::string& error);
+  /* override */ bool FetchAdjacency(
+      const std::vector<std::string>& names,
+      base::LineageCursor::DIRECTION direction,
+      std::vector<std::vector<std::string>>& adjacency, std::string& error);
+  // Asks for the parents of `name`, which also tell whether it exists.
+  /* override */ bool HasConcept(const std::string& name, bool& found,
+                                 std::string& error);
+
+private:
+  // Send the request in mRequest and read the response into mResponse.
+  bool Call(SHARD_METHOD method, std::string& error);
+  bool Connect(std::string& error);
+  void Disconnect();
+  bool Adjacency(const std::vector<std::string>& names,
+                 base::LineageCursor::DIRECTION direction,
+                 std::vector<std::vector<std::string>>& adjacency,
+                 std::vector<bool>& found, std::string& error);
+
+  std::string mAddress;
+  uint16_t mPort;
+  std::string mHyperbase;
+  uint32_t mTimeoutMillis;
+  std::mutex mMutex;
+  int mFd{-1};
+  // Kept across calls so that their capacity is reused.
+  std::string mRequest;
+  std::string mResponse;
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,582 @@
+#include "server/sharded_hyperbase.h"
+
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "base/storage/mutation_codec.h"
+#include "common/sketch/mix.h"
+#include "common/utils/fsync.h"
+
+namespace hyperon {
+namespace server {
+
+ShardRouter::ShardRouter(uint32_t shard_count, PARTITIONING partitioning)
+    : mShardCount(std::max(shard_count, 1u)), mPartitioning(partitioning) {}
+
+ShardRouter::~ShardRouter() {
+  if (mFile >= 0) ::close(mFile);
+}
+
+uint32_t ShardRouter::HashShard(const std::string& key) const {
+  return common::mix64(std::hash<std::string>{}(key)) % mShardCount;
+}
+
+bool ShardRouter::Open(const std::string& path, std::string& error) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  std::ifstream in(path, std::ios::binary);
+  std::string line;
+  uint64_t lineno = 0;
+  // End of the last complete record.
+  std::streamoff end = 0;
+  while (std::getline(in, line)) {
+    ++lineno;
+    // Records are appended whole, an unterminated one is what a crash
+    // mid-append leaves behind. Its write was reported as failed.
+    if (in.eof()) {
+      in.close();
+      std::error_code ec;
+      std::filesystem::resize_file(path, end, ec);
+      break;
+    }
+    base::Mutation record;
+    uint32_t shard = 0;
+    try {
+      if (!base::decode_mutation(line, record) || record.objects.size() != 1) {
+        throw std::invalid_argument(line);
+      }
+      shard = static_cast<uint32_t>(std::stoul(record.objects[0]));
+    } catch (const std::exception&) {
+      error = fmt::format("{}:{}: malformed directory record", path, lineno);
+      return false;
+    }
+    if (shard >= mShardCount) {
+      error = fmt::format("{}:{}: shard {} out of range", path, lineno, shard);
+      return false;
+    }
+    mDirectory.emplace(std::move(record.subject), shard);
+    end = in.tellg();
+  }
+  int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+                  0644);
+  if (fd < 0 || !common::sync_parent_dir(path)) {
+    if (fd >= 0) ::close(fd);
+    error = fmt::format("cannot open '{}' for appending", path);
+    return false;
+  }
+  if (mFile >= 0) ::close(mFile);
+  mFile = fd;
+  return true;
+}
+
+uint32_t ShardRouter::Place(const std::string& name,
+                            const std::string& category) const {
+  if (mPartitioning == HASH) return HashShard(name);
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto found = mDirectory.find(name);
+  return found != mDirectory.end() ? found->second : HashShard(category);
+}
+
+uint32_t ShardRouter::Owner(const std::string& name) const {
+  if (mPartitioning == HASH) return HashShard(name);
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto found = mDirectory.find(name);
+  // Unknown concepts fall back to the root category's shard.
+  return found != mDirectory.end() ? found->second : HashShard("");
+}
+
+bool ShardRouter::Record(
+    const std::vector<std::pair<std::string, uint32_t>>& placed,
+    std::string& error) {
+  if (mPartitioning == HASH) return true;
+  std::lock_guard<std::mutex> lock(mMutex);
+  mBuffer.clear();
+  base::Mutation record;
+  for (const auto& kv : placed) {
+    if (!mDirectory.emplace(kv.first, kv.second).second) continue;
+    if (mFile < 0) continue;
+    record.subject = kv.first;
+    record.objects = {std::to_string(kv.second)};
+    base::encode_mutation(record, mBuffer);
+    mBuffer += '\n';
+  }
+  if (mBuffer.empty()) return true;
+  if (!common::write_all(mFile, mBuffer.data(), mBuffer.size()) ||
+      ::fsync(mFile) != 0) {
+    error = "cannot persist the shard directory";
+    return false;
+  }
+  return true;
+}
+
+size_t ShardRouter::DirectorySize() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mDirectory.size();
+}
+
+// A routed batch, applied in two rounds: the home round applies every
+// mutation on the owner of its subject, the remote round the other ends of
+// the edges whose home mutation took effect.
+struct ShardedHyperbase::Write {
+  // Remote end of an edge, waiting for its home mutation.
+  struct Remote {
+    uint32_t home;
+    uint32_t position;
+    uint32_t shard;
+    // Ghost of the subject needed on `shard`, if any.
+    std::string ghost;
+    base::Mutation edge;
+  };
+  // Concept created by the write, to record once it exists.
+  struct Placement {
+    uint32_t home;
+    uint32_t position;
+    std::string name;
+  };
+
+  // Batches of the current round by shard.
+  std::vector<ShardBatch> batches;
+  std::vector<Remote> remote;
+  std::vector<Placement> placements;
+  std::unordered_map<std::string, uint32_t> placed;
+
+  std::mutex mutex;
+  size_t pending{0};
+  // Outcome of the home round by shard: whether the call succeeded and
+  // the positions of the failed mutations, in ascending order.
+  std::vector<bool> applied;
+  std::vector<std::vector<uint32_t>> failed;
+  ApplyReply merged;
+  common::Promise<ApplyReply> promise;
+
+  bool TookEffect(uint32_t shard, uint32_t position) const {
+    return applied[shard] && !std::binary_search(failed[shard].begin(),
+                                                 failed[shard].end(),
+                                                 position);
+  }
+};
+
+ShardedHyperbase::ShardedHyperbase(
+    std::unique_ptr<ShardRouter> router,
+    std::vector<std::shared_ptr<ShardClient>> shards)
+    : mRouter(std::move(router)), mShards(std::move(shards)) {}
+
+uint32_t ShardedHyperbase::Owner(const std::string& name,
+                                 const Write& write) const {
+  auto found = write.placed.find(name);
+  return found != write.placed.end() ? found->second : mRouter->Owner(name);
+}
+
+void ShardedHyperbase::Route(const base::Mutation& mut, Write& write) {
+  using base::Mutation;
+
+  uint32_t home;
+  if (mut.kind != Mutation::MUT_ADD_CONCEPT) {
+    home = Owner(mut.subject, write);
+  } else if (write.placed.count(mut.subject) > 0) {
+    // Created twice in the write, the second create fails on the same shard.
+    home = write.placed[mut.subject];
+  } else {
+    home = mRouter->Place(mut.subject, mut.category);
+    if (mRouter->Partitioning() == ShardRouter::CATEGORY) {
+      write.placed.emplace(mut.subject, home);
+    }
+  }
+  ShardBatch& home_batch = write.batches[home];
+  uint32_t position = static_cast<uint32_t>(home_batch.mutations.size());
+  home_batch.mutations.push_back(mut);
+  if (mut.kind == Mutation::MUT_ADD_CONCEPT &&
+      mRouter->Partitioning() == ShardRouter::CATEGORY) {
+    write.placements.push_back({home, position, mut.subject});
+  }
+  // Times are not concepts.
+  if (mut.kind == Mutation::MUT_SET_INTERVAL) return;
+
+  // Objects owned elsewhere are referenced through ghosts on the home shard.
+  // Lineage is kept on both ends, so the owners of remote objects also get
+  // the edge, with a ghost of the subject.
+  bool links_lineage = mut.kind != Mutation::MUT_ADD_MEMBER &&
+                       mut.kind != Mutation::MUT_ERASE_MEMBER;
+  std::map<uint32_t, std::vector<std::string>> remote;
+  for (const auto& object : mut.objects) {
+    uint32_t owner = Owner(object, write);
+    if (owner == home) continue;
+    if (mut.kind != Mutation::MUT_REMOVE_PARENT &&
+        mut.kind != Mutation::MUT_ERASE_MEMBER) {
+      // Relation members of other shards are assumed to be entities.
+      home_batch.ghosts.push_back({object, links_lineage
+                                               ? Mutation::KIND_CONCEPT
+                                               : Mutation::KIND_ENTITY});
+    }
+    if (links_lineage) remote[owner].push_back(object);
+  }
+
+  for (auto& kv : remote) {
+    if (mut.kind == Mutation::MUT_ADD_SPLIT) {
+      // Remote children get their parent edge, the split stays at home.
+      for (auto& child : kv.second) {
+        Mutation edge;
+        edge.kind = Mutation::MUT_ADD_PARENT;
+        edge.subject = std::move(child);
+        edge.objects = {mut.subject};
+        write.remote.push_back(
+            {home, position, kv.first, mut.subject, std::move(edge)});
+      }
+      continue;
+    }
+    Mutation edge;
+    edge.kind = mut.kind == Mutation::MUT_REMOVE_PARENT
+                    ? Mutation::MUT_REMOVE_PARENT
+                    : Mutation::MUT_ADD_PARENT;
+    edge.subject = mut.subject;
+    edge.objects = std::move(kv.second);
+    std::string ghost =
+        edge.kind == Mutation::MUT_ADD_PARENT ? mut.subject : "";
+    write.remote.push_back(
+        {home, position, kv.first, std::move(ghost), std::move(edge)});
+  }
+}
+
+bool ShardedHyperbase::ApplyBatch(const std::vector<base::Mutation>& batch,
+                                  base::BatchResult& result,
+                                  std::string& error) {
+  common::Task<ApplyReply> task = ApplyBatchAsync(batch);
+  const ApplyReply& reply = task.Get();
+  result = reply.result;
+  if (!reply.ok) error = reply.error;
+  return reply.ok;
+}
+
+common::Task<ApplyReply> ShardedHyperbase::ApplyBatchAsync(
+    const std::vector<base::Mutation>& batch) {
+  auto write = std::make_shared<Write>();
+  write->batches.resize(mShards.size());
+  write->applied.resize(mShards.size());
+  write->failed.resize(mShards.size());
+  write->merged.ok = true;
+  for (const auto& mut : batch) Route(mut, *write);
+  common::Task<ApplyReply> task = write->promise.GetTask();
+  Send(write, true);
+  return task;
+}
+
+void ShardedHyperbase::Send(const std::shared_ptr<Write>& write, bool home) {
+  std::vector<uint32_t> shards;
+  for (uint32_t i = 0; i < mShards.size(); ++i) {
+    if (!write->batches[i].mutations.empty()) shards.push_back(i);
+  }
+  if (shards.empty()) {
+    Finish(write, home);
+    return;
+  }
+  write->pending = shards.size();
+  for (uint32_t i : shards) {
+    ShardBatch batch = std::move(write->batches[i]);
+    write->batches[i] = ShardBatch();
+    mShards[i]
+        ->ApplyAsync(std::move(batch))
+        .Then([this, write, i, home](const ApplyReply& reply) {
+          std::unique_lock<std::mutex> lock(write->mutex);
+          ApplyReply& merged = write->merged;
+          if (!reply.ok) {
+            merged.ok = false;
+            merged.error = fmt::format("shard {}: {}", i, reply.error);
+          } else {
+            merged.result.applied += reply.result.applied;
+            merged.result.failed += reply.result.failed;
+            merged.result.version =
+                std::max(merged.result.version, reply.result.version);
+            if (home) {
+              write->applied[i] = true;
+              write->failed[i] = reply.failed;
+            }
+          }
+          if (--write->pending > 0) return;
+          lock.unlock();
+          Finish(write, home);
+        });
+  }
+}
+
+void ShardedHyperbase::Finish(const std::shared_ptr<Write>& write,
+                              bool home) {
+  if (!home) {
+    write->promise.Set(std::move(write->merged));
+    return;
+  }
+  // Only concepts that were created enter the directory, and only edges
+  // whose home mutation took effect get their remote end.
+  std::vector<std::pair<std::string, uint32_t>> placed;
+  for (auto& placement : write->placements) {
+    if (write->TookEffect(placement.home, placement.position)) {
+      placed.emplace_back(std::move(placement.name), placement.home);
+    }
+  }
+  std::string error;
+  if (!placed.empty() && !mRouter->Record(placed, error)) {
+    write->merged.ok = false;
+    write->merged.error = error;
+  }
+  for (auto& remote : write->remote) {
+    if (!write->TookEffect(remote.home, remote.position)) continue;
+    ShardBatch& batch = write->batches[remote.shard];
+    if (!remote.ghost.empty()) {
+      batch.ghosts.push_back(
+          {std::move(remote.ghost), base::Mutation::KIND_CONCEPT});
+    }
+    batch.mutations.push_back(std::move(remote.edge));
+  }
+  Send(write, false);
+}
+
+common::Task<ShardedHyperbase::LineageReply> ShardedHyperbase::Expand(
+    const Frontier& frontier, base::LineageCursor::DIRECTION direction,
+    QueryStats* stats, common::ProfileNode* profile) {
+  std::vector<Frontier> groups(mShards.size());
+  for (const auto& name : frontier) {
+    groups[mRouter->Owner(name)].push_back(name);
+  }
+  // Nodes are created before the fetches complete concurrently.
+  std::vector<common::ProfileNode*> fetches(mShards.size(), nullptr);
+  for (size_t i = 0; profile && i < mShards.size(); ++i) {
+    if (!groups[i].empty()) {
+      fetches[i] =
+          &profile->Child(fmt::format("shard {}", i), "fetch_adjacency");
+    }
+  }
+
+  struct Join {
+    std::mutex mutex;
+    size_t pending{0};
+    // Replies by shard, merged in shard order once all are in.
+    std::vector<AdjacencyReply> replies;
+    std::vector<bool> issued;
+    common::Promise<LineageReply> promise;
+  };
+  auto join = std::make_shared<Join>();
+  join->replies.resize(mShards.size());
+  join->issued.resize(mShards.size());
+  for (size_t i = 0; i < mShards.size(); ++i) {
+    join->issued[i] = !groups[i].empty();
+    join->pending += join->issued[i] ? 1 : 0;
+  }
+  common::Task<LineageReply> task = join->promise.GetTask();
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < mShards.size(); ++i) {
+    if (groups[i].empty()) continue;
+    if (stats) ++stats->round_trips;
+    size_t asked = groups[i].size();
+    common::ProfileNode* fetch = fetches[i];
+    auto done = [join, i, asked, fetch, start, stats,
+                 profile](const AdjacencyReply& reply) {
+      if (fetch) {
+        fetch->nanos += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count());
+        ++fetch->loops;
+        fetch->rows_in += asked;
+        for (const auto& list : reply.adjacency) {
+          fetch->rows_out += list.size();
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(join->mutex);
+        join->replies[i] = reply;
+        if (--join->pending > 0) return;
+      }
+      LineageReply merged;
+      merged.ok = true;
+      for (size_t shard = 0; shard < join->replies.size(); ++shard) {
+        if (!join->issued[shard]) continue;
+        AdjacencyReply& shard_reply = join->replies[shard];
+        if (!shard_reply.ok) {
+          merged.ok = false;
+          merged.error =
+              fmt::format("shard {}: {}", shard, shard_reply.error);
+          continue;
+        }
+        for (auto& list : shard_reply.adjacency) {
+          for (auto& name : list) merged.concepts.push_back(std::move(name));
+        }
+      }
+      if (stats) ++stats->levels;
+      if (profile) ++profile->loops;
+      join->promise.Set(std::move(merged));
+    };
+    mShards[i]->FetchAdjacencyAsync(std::move(groups[i]), direction)
+        .Then(std::move(done));
+  }
+  return task;
+}
+
+struct ShardedHyperbase::Walk {
+  std::string origin;
+  base::LineageCursor::DIRECTION direction;
+  QueryStats* stats{nullptr};
+  common::ProfileNode* profile{nullptr};
+  std::chrono::steady_clock::time_point start;
+  std::unordered_set<std::string> visited;
+  Frontier frontier;
+  std::vector<std::string> concepts;
+  // Is-a checks stop at the first ancestor named `target`.
+  bool is_a{false};
+  std::string target;
+  bool matched{false};
+  common::Promise<LineageReply> lineage;
+  common::Promise<IsAReply> checked;
+
+  void Finish(bool ok, const std::string& error) {
+    if (profile) {
+      profile->nanos += static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+      profile->rows_out += is_a ? (matched ? 1 : 0) : concepts.size();
+    }
+    if (is_a) {
+      IsAReply reply;
+      reply.ok = ok;
+      reply.error = error;
+      reply.result = matched;
+      checked.Set(std::move(reply));
+      return;
+    }
+    LineageReply reply;
+    reply.ok = ok;
+    reply.error = error;
+    reply.concepts = std::move(concepts);
+    lineage.Set(std::move(reply));
+  }
+};
+
+void ShardedHyperbase::Step(const std::shared_ptr<Walk>& walk) {
+  Expand(walk->frontier, walk->direction, walk->stats, walk->profile)
+      .Then([this, walk](const LineageReply& level) {
+        if (!level.ok) {
+          walk->Finish(false, level.error);
+          return;
+        }
+        walk->frontier.clear();
+        for (const auto& name : level.concepts) {
+          if (walk->is_a && name == walk->target) {
+            walk->matched = true;
+            break;
+          }
+          if (!walk->visited.insert(name).second) continue;
+          if (!walk->is_a) walk->concepts.push_back(name);
+          walk->frontier.push_back(name);
+        }
+        if (walk->matched || walk->frontier.empty()) {
+          walk->Finish(true, "");
+          return;
+        }
+        Step(walk);
+      });
+}
+
+bool ShardedHyperbase::Lineage(const std::string& origin,
+                               base::LineageCursor::DIRECTION direction,
+                               std::vector<std::string>& result,
+                               std::string& error, QueryStats* stats,
+                               common::ProfileNode* profile) {
+  common::Task<LineageReply> task =
+      LineageAsync(origin, direction, stats, profile);
+  const LineageReply& reply = task.Get();
+  if (!reply.ok) {
+    error = reply.error;
+    return false;
+  }
+  result.insert(result.end(), reply.concepts.begin(), reply.concepts.end());
+  return true;
+}
+
+common::Task<ShardedHyperbase::LineageReply> ShardedHyperbase::LineageAsync(
+    const std::string& origin, base::LineageCursor::DIRECTION direction,
+    QueryStats* stats, common::ProfileNode* profile) {
+  if (profile) {
+    *profile = common::ProfileNode(
+        "sharded_lineage",
+        fmt::format("{}, {}", origin,
+                    direction == base::LineageCursor::DESCENDANTS
+                        ? "descendants"
+                        : "ancestors"));
+    profile->rows_in = 1;
+  }
+  auto walk = std::make_shared<Walk>();
+  walk->origin = origin;
+  walk->direction = direction;
+  walk->stats = stats;
+  walk->profile = profile;
+  walk->start = std::chrono::steady_clock::now();
+  walk->visited.insert(origin);
+  walk->frontier.push_back(origin);
+  common::Task<LineageReply> task = walk->lineage.GetTask();
+  mShards[mRouter->Owner(origin)]->HasConceptAsync(origin).Then(
+      [this, walk](const ContainsReply& reply) {
+        if (!reply.ok) {
+          walk->Finish(false, reply.error);
+        } else if (!reply.found) {
+          walk->Finish(false,
+                       fmt::format("unknown concept '{}'", walk->origin));
+        } else {
+          Step(walk);
+        }
+      });
+  return task;
+}
+
+bool ShardedHyperbase::IsA(const std::string& descendant,
+                           const std::string& ancestor, bool& result,
+                           std::string& error, QueryStats* stats,
+                           common::ProfileNode* profile) {
+  common::Task<IsAReply> task =
+      IsAAsync(descendant, ancestor, stats, profile);
+  const IsAReply& reply = task.Get();
+  result = reply.result;
+  if (!reply.ok) error = reply.error;
+  return reply.ok;
+}
+
+common::Task<ShardedHyperbase::IsAReply> ShardedHyperbase::IsAAsync(
+    const std::string& descendant, const std::string& ancestor,
+    QueryStats* stats, common::ProfileNode* profile) {
+  if (profile) {
+    *profile = common::ProfileNode(
+        "sharded_isa", fmt::format("{}, {}", descendant, ancestor));
+    profile->rows_in = 1;
+  }
+  auto walk = std::make_shared<Walk>();
+  walk->origin = descendant;
+  walk->direction = base::LineageCursor::ANCESTORS;
+  walk->stats = stats;
+  walk->profile = profile;
+  walk->start = std::chrono::steady_clock::now();
+  walk->is_a = true;
+  walk->target = ancestor;
+  walk->matched = descendant == ancestor;
+  walk->visited.insert(descendant);
+  walk->frontier.push_back(descendant);
+  common::Task<IsAReply> task = walk->checked.GetTask();
+  if (walk->matched) {
+    walk->Finish(true, "");
+  } else {
+    Step(walk);
+  }
+  return task;
+}
+
+}  // namespace server
+}  // namespace hyperon
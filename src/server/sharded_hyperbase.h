@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/async/task.h"
+#include "common/profile/query_profile.h"
+#include "server/shard_client.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Decides which shard owns a concept.
+ *
+ * With HASH partitioning the owner is derived from the semantic name alone.
+ * With CATEGORY partitioning all concepts of a top-level category live on
+ * the shard its name hashes to, which keeps category-local walks on one
+ * node; the router then keeps a directory from concept to shard, filled as
+ * concepts are created through it. Once opened on a file, the directory is
+ * loaded from it and every recorded placement is appended and synced.
+ */
+class ShardRouter {
+public:
+  enum PARTITIONING { HASH, CATEGORY };
+
+  ShardRouter(uint32_t shard_count, PARTITIONING partitioning = HASH);
+  ~ShardRouter();
+
+  ShardRouter(const ShardRouter&) = delete;
+  ShardRouter& operator=(const ShardRouter&) = delete;
+
+  inline uint32_t ShardCount() const { return mShardCount; }
+  inline PARTITIONING Partitioning() const { return mPartitioning; }
+
+  /**
+   * @brief Load the directory from `path`, creating the file if needed, and
+   * persist placements recorded from now on. Directory records reuse the
+   * mutation line format: the concept as subject, its shard as object.
+   */
+  bool Open(const std::string& path, std::string& error);
+
+  // Owner of a concept being created in `category`, the current owner if
+  // the concept is known already.
+  uint32_t Place(const std::string& name, const std::string& category) const;
+  // Owner of an existing concept.
+  uint32_t Owner(const std::string& name) const;
+
+  /**
+   * @brief Record the owners of concepts created on their shards. Known
+   * names keep their owner. A no-op with HASH partitioning.
+   *
+   * @return false if the placements could not be persisted, they are known
+   * to this router anyway.
+   */
+  bool Record(const std::vector<std::pair<std::string, uint32_t>>& placed,
+              std::string& error);
+
+  // Number of concepts in the directory.
+  size_t DirectorySize() const;
+
+private:
+  uint32_t HashShard(const std::string& key) const;
+
+  uint32_t mShardCount;
+  PARTITIONING mPartitioning;
+  mutable std::mutex mMutex;
+  std::unordered_map<std::string, uint32_t> mDirectory;
+  int mFile{-1};
+  std::string mBuffer;
+};
+
+/**
+ * @brief Routing and scatter-gather layer over a hyperbase partitioned
+ * across several hyperond nodes.
+ *
+ * Writes are split by owner and sent as one batch per shard, in parallel,
+ * in two rounds: the mutations go to the shards owning their subjects
+ * first, then the remote ends of the edges of those that took effect go to
+ * the owners of the objects. New concepts enter the directory of the router
+ * only once created on their shard.
+ * Lineage queries run level-synchronously: the frontier is grouped by
+ * owner, and each shard answers one batched adjacency fetch per level, so a
+ * walk costs at most depth x shards round trips, issued in parallel per
+ * level.
+ *
+ * Calls are issued through the asynchronous shard API and every level
+ * continues from the completion of its last fetch, so a walk holds no
+ * thread while waiting for shards. The asynchronous forms return as soon
+ * as the first calls are issued; the synchronous ones wait for them and
+ * must not be called from an executor thread the shards complete on. The
+ * sharded hyperbase, the stats and the profile must outlive pending calls.
+ */
+class ShardedHyperbase {
+public:
+  struct QueryStats {
+    uint32_t levels{0};
+    uint32_t round_trips{0};
+  };
+
+  struct LineageReply {
+    bool ok{false};
+    std::string error;
+    std::vector<std::string> concepts;
+  };
+
+  struct IsAReply {
+    bool ok{false};
+    std::string error;
+    bool result{false};
+  };
+
+  ShardedHyperbase(std::unique_ptr<ShardRouter> router,
+                   std::vector<std::shared_ptr<ShardClient>> shards);
+
+  /**
+   * @brief Route and apply a batch. Counts in the result refer to the
+   * per-shard mutations a routed mutation is split into.
+   */
+  bool ApplyBatch(const std::vector<base::Mutation>& batch,
+                  base::BatchResult& result, std::string& error);
+  common::Task<ApplyReply> ApplyBatchAsync(
+      const std::vector<base::Mutation>& batch);
+
+  /**
+   * @brief Transitive lineage of a concept across all shards, excluding the
+   * concept itself. The profile, if set, has one operator per shard
+   * accumulated over the levels.
+   */
+  bool Lineage(const std::string& origin,
+               base::LineageCursor::DIRECTION direction,
+               std::vector<std::string>& result, std::string& error,
+               QueryStats* stats = nullptr,
+               common::ProfileNode* profile = nullptr);
+  common::Task<LineageReply> LineageAsync(
+      const std::string& origin, base::LineageCursor::DIRECTION direction,
+      QueryStats* stats = nullptr, common::ProfileNode* profile = nullptr);
+
+  /**
+   * @brief Check whether `descendant` is below `ancestor`, walking upwards
+   * from the descendant with early exit.
+   */
+  bool IsA(const std::string& descendant, const std::string& ancestor,
+           bool& result, std::string& error, QueryStats* stats = nullptr,
+           common::ProfileNode* profile = nullptr);
+  common::Task<IsAReply> IsAAsync(const std::string& descendant,
+                                  const std::string& ancestor,
+                                  QueryStats* stats = nullptr,
+                                  common::ProfileNode* profile = nullptr);
+
+private:
+  using Frontier = std::vector<std::string>;
+  struct Walk;
+  struct Write;
+
+  // Route one mutation into the per-shard batches of a write.
+  void Route(const base::Mutation& mut, Write& write);
+  // Owner of a concept, including those created earlier in the write.
+  uint32_t Owner(const std::string& name, const Write& write) const;
+  // Send the batches of a round of a write, finishing the round once all
+  // shards replied.
+  void Send(const std::shared_ptr<Write>& write, bool home);
+  void Finish(const std::shared_ptr<Write>& write, bool home);
+  // Expand one level, completing with the neighbours of the frontier in
+  // shard order.
+  common::Task<LineageReply> Expand(const Frontier& frontier,
+                                    base::LineageCursor::DIRECTION direction,
+                                    QueryStats* stats,
+                                    common::ProfileNode* profile);
+  // Expand the frontier of a walk until it is done.
+  void Step(const std::shared_ptr<Walk>& walk);
+
+  std::unique_ptr<ShardRouter> mRouter;
+  std::vector<std::shared_ptr<ShardClient>> mShards;
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,73 @@
+#include "server/slow_query_log.h"
+
+#include <fmt/core.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "common/utils/time.h"
+
+namespace hyperon {
+namespace server {
+
+namespace {
+
+const common::Counter kSlowQueries("hyperon_slow_queries_total",
+                                   "Queries written to the slow query log.");
+
+}  // namespace
+
+SlowQueryLog& SlowQueryLog::Instance() {
+  // Leaked, so that handlers may still record during static destruction.
+  static SlowQueryLog* log = new SlowQueryLog();
+  return *log;
+}
+
+bool SlowQueryLog::Open(uint64_t threshold_millis, const std::string& path,
+                        std::string& error) {
+  std::FILE* file = nullptr;
+  if (threshold_millis > 0 && !path.empty()) {
+    file = std::fopen(path.c_str(), "a");
+    if (!file) {
+      error = fmt::format("cannot open slow query log {}: {}", path,
+                          std::strerror(errno));
+      return false;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mFile) std::fclose(mFile);
+  mFile = file;
+  mThresholdNanos.store(threshold_millis * 1000000,
+                        std::memory_order_relaxed);
+  return true;
+}
+
+void SlowQueryLog::Close() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mThresholdNanos.store(0, std::memory_order_relaxed);
+  if (mFile) std::fclose(mFile);
+  mFile = nullptr;
+}
+
+bool SlowQueryLog::Record(RPC_METHOD method, const std::string& hyperbase,
+                          const common::ProfileNode& profile) {
+  uint64_t threshold = mThresholdNanos.load(std::memory_order_relaxed);
+  if (threshold == 0 || profile.nanos < threshold) return false;
+  std::string entry = fmt::format(
+      "{} slow query: {} on {} took {:.3f}ms\n{}", common::now_millis(),
+      rpc_method_name(method), hyperbase, profile.nanos / 1e6,
+      profile.ToString());
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  // Closed concurrently.
+  if (mThresholdNanos.load(std::memory_order_relaxed) == 0) return false;
+  std::FILE* out = mFile ? mFile : stderr;
+  std::fwrite(entry.data(), 1, entry.size(), out);
+  std::fflush(out);
+  mLogged.fetch_add(1, std::memory_order_relaxed);
+  kSlowQueries.Add();
+  return true;
+}
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include "common/profile/query_profile.h"
+#include "server/rpc_metrics.h"
+
+namespace hyperon {
+namespace server {
+
+/**
+ * @brief Process-wide log of queries slower than a threshold, each entry
+ * with the execution profile of the query.
+ *
+ * Query handlers take a profile whenever the log is enabled, since
+ * slowness is only known afterwards, and pass it to Record() once done.
+ * Profiling costs one clock read per operator and the counting of rows.
+ */
+class SlowQueryLog {
+public:
+  static SlowQueryLog& Instance();
+
+  /**
+   * @brief Log queries taking at least `threshold_millis`, appending to
+   * `path` or to stderr if it is empty. A threshold of 0 disables the log.
+   */
+  bool Open(uint64_t threshold_millis, const std::string& path,
+            std::string& error);
+  void Close();
+
+  inline bool Enabled() const {
+    return mThresholdNanos.load(std::memory_order_relaxed) > 0;
+  }
+
+  /**
+   * @brief Log a finished query if its profiled time reaches the threshold.
+   *
+   * @param method RPC the query came in through
+   * @param hyperbase Queried hyperbase
+   * @param profile Profile of the whole query
+   * @return true if the query was logged.
+   */
+  bool Record(RPC_METHOD method, const std::string& hyperbase,
+              const common::ProfileNode& profile);
+
+  inline uint64_t Logged() const {
+    return mLogged.load(std::memory_order_relaxed);
+  }
+
+private:
+  SlowQueryLog() = default;
+
+  std::atomic<uint64_t> mThresholdNanos{0};
+  std::atomic<uint64_t> mLogged{0};
+  std::mutex mMutex;
+  std::FILE* mFile{nullptr};
+};
+
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/bulk_ingest.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+base::Mutation add_concept(const std::string& name) {
+  base::Mutation mut;
+  mut.subject = name;
+  return mut;
+}
+
+TEST(BulkIngestTest, AcksBatchesInOrder) {
+  auto hyperbase = std::make_shared<base::Hyperbase>("ingest");
+  std::mutex mutex;
+  std::vector<IngestAck> acks;
+  {
+    BulkIngestor ingestor(
+        hyperbase,
+        [&](const IngestAck& ack) {
+          std::lock_guard<std::mutex> lock(mutex);
+          acks.push_back(ack);
+        },
+        /*batch_size=*/10, /*window=*/2);
+    for (uint64_t seq = 1; seq <= 95; ++seq) {
+      ingestor.Push(add_concept("c" + std::to_string(seq)), seq);
+    }
+    // A duplicate fails without failing the stream.
+    ingestor.Push(add_concept("c1"), 96);
+    ingestor.Finish();
+    EXPECT_EQ(ingestor.TotalApplied(), 95u);
+    EXPECT_EQ(ingestor.TotalFailed(), 1u);
+  }
+
+  ASSERT_EQ(acks.size(), 10u);
+  uint64_t applied = 0;
+  for (size_t i = 0; i < acks.size(); ++i) {
+    EXPECT_EQ(acks[i].batch_id, i + 1);
+    EXPECT_EQ(acks[i].last_client_seq, std::min<uint64_t>(10 * (i + 1), 96));
+    if (i > 0) {
+      EXPECT_GT(acks[i].version, acks[i - 1].version);
+    }
+    EXPECT_LE(acks[i].credits, 2u);
+    applied += acks[i].applied;
+  }
+  EXPECT_EQ(applied, 95u);
+  EXPECT_EQ(acks.back().version, hyperbase->Version());
+  EXPECT_EQ(hyperbase->ConceptCount(), 95u);
+}
+
+TEST(BulkIngestTest, PushBlocksWhileWindowIsFull) {
+  auto hyperbase = std::make_shared<base::Hyperbase>("ingest");
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::atomic<uint64_t> acked{0};
+  BulkIngestor ingestor(
+      hyperbase,
+      [&](const IngestAck& ack) {
+        // Hold the applier on the first ack, as a stalled client would.
+        if (ack.batch_id == 1) released.wait();
+        acked = ack.batch_id;
+      },
+      /*batch_size=*/1, /*window=*/1);
+
+  std::atomic<int> pushed{0};
+  std::thread producer([&] {
+    for (uint64_t seq = 1; seq <= 4; ++seq) {
+      ingestor.Push(add_concept("c" + std::to_string(seq)), seq);
+      ++pushed;
+    }
+  });
+  // Batch 1 is being acked, batch 2 fills the window and batch 3 waits.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (pushed < 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pushed.load(), 2);
+  EXPECT_EQ(ingestor.Credits(), 0u);
+  EXPECT_EQ(acked.load(), 0u);
+
+  release.set_value();
+  producer.join();
+  ingestor.Finish();
+  EXPECT_EQ(pushed.load(), 4);
+  EXPECT_EQ(acked.load(), 4u);
+  EXPECT_EQ(ingestor.Credits(), 1u);
+  EXPECT_EQ(ingestor.TotalApplied(), 4u);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/core/concept_repr.h"
+#include "common/compress/varint.h"
+#include "common/proto/wire_writer.h"
+#include "server/category_query.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+// A field of an encoded message, varint or length-delimited.
+struct Field {
+  uint32_t number{0};
+  uint64_t value{0};
+  std::string bytes;
+};
+
+std::vector<Field> parse(const std::string& in) {
+  std::vector<Field> fields;
+  size_t pos = 0;
+  uint64_t tag = 0;
+  while (pos < in.size()) {
+    EXPECT_TRUE(common::get_varint(in, pos, tag));
+    Field field;
+    field.number = static_cast<uint32_t>(tag >> 3);
+    EXPECT_TRUE(common::get_varint(in, pos, field.value));
+    if ((tag & 7) == common::ProtoWriter::WIRE_LENGTH) {
+      EXPECT_LE(pos + field.value, in.size());
+      field.bytes = in.substr(pos, field.value);
+      pos += field.value;
+    } else {
+      EXPECT_EQ(tag & 7, common::ProtoWriter::WIRE_VARINT);
+    }
+    fields.push_back(std::move(field));
+  }
+  return fields;
+}
+
+std::vector<Field> all(const std::vector<Field>& fields, uint32_t number) {
+  std::vector<Field> out;
+  for (const auto& field : fields) {
+    if (field.number == number) out.push_back(field);
+  }
+  return out;
+}
+
+std::vector<uint64_t> packed(const std::string& bytes) {
+  std::vector<uint64_t> values;
+  size_t pos = 0;
+  uint64_t value = 0;
+  while (pos < bytes.size() && common::get_varint(bytes, pos, value)) {
+    values.push_back(value);
+  }
+  return values;
+}
+
+// Names of the dictionary of a response, field 4.
+std::vector<std::string> dictionary(const std::vector<Field>& response) {
+  std::vector<std::string> names;
+  for (const auto& dict : all(response, 4)) {
+    for (const auto& name : parse(dict.bytes)) names.push_back(name.bytes);
+  }
+  return names;
+}
+
+base::Mutation create(const std::string& name,
+                      std::vector<std::string> parents = {},
+                      const std::string& category = "") {
+  base::Mutation mut;
+  mut.subject = name;
+  mut.objects = std::move(parents);
+  mut.category = category;
+  return mut;
+}
+
+class CategoryQueryTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mHyperbase->ApplyBatch({create("animal"), create("bird", {"animal"}, "zoo"),
+                            create("robin", {"bird"}, "zoo"),
+                            create("wren", {"bird"}, "zoo")});
+    base::ConceptPtr bird;
+    ASSERT_TRUE(mHyperbase->GetConcept("bird", bird));
+    bird->AddRepr(std::make_shared<base::ConceptReprNL>(
+                      "a feathered animal", base::ConceptReprNL::ENGLISH),
+                  base::ConceptRepr::MODAL_NATLANG);
+  }
+
+  base::HyperbasePtr mHyperbase = std::make_shared<base::Hyperbase>("zoo");
+};
+
+TEST_F(CategoryQueryTest, EncodesRecordsAgainstOneDictionary) {
+  ConceptFields fields;
+  fields.parents = true;
+  fields.children = true;
+  fields.representations = true;
+  std::string out;
+  EXPECT_EQ(encode_concepts(*mHyperbase,
+                            {"bird", "nobody", "robin", "nobody", "bird"},
+                            fields, out),
+            3u);
+
+  std::vector<Field> response = parse(out);
+  std::vector<std::string> names = dictionary(response);
+  // Every name once, in order of first use. Children come in no order.
+  ASSERT_EQ(names.size(), 6u);
+  EXPECT_EQ(names[0], "bird");
+  EXPECT_EQ(names[1], "zoo");
+  EXPECT_EQ(names[2], "animal");
+  EXPECT_EQ(names[5], "nobody");
+  std::vector<Field> records = all(response, 5);
+  ASSERT_EQ(records.size(), 3u);
+  std::vector<Field> bird = parse(records[0].bytes);
+  EXPECT_EQ(names[all(bird, 1).at(0).value], "bird");
+  EXPECT_EQ(names[all(bird, 3).at(0).value], "zoo");
+  EXPECT_EQ(packed(all(bird, 4).at(0).bytes), (std::vector<uint64_t>{2}));
+  EXPECT_EQ(packed(all(bird, 5).at(0).bytes).size(), 2u);
+  std::vector<Field> repr = parse(all(bird, 7).at(0).bytes);
+  EXPECT_TRUE(all(repr, 1).empty());
+  EXPECT_EQ(all(repr, 2).at(0).bytes, "a feathered animal");
+  // Repeated requests reference the same names.
+  EXPECT_EQ(records[2].bytes, records[0].bytes);
+  EXPECT_EQ(packed(all(response, 6).at(0).bytes),
+            (std::vector<uint64_t>{5, 5}));
+}
+
+TEST_F(CategoryQueryTest, EncodesCategoryPages) {
+  CategoryQuery query;
+  query.category = "zoo";
+  query.limit = 2;
+  std::string out;
+  std::string error;
+  ASSERT_TRUE(encode_category(*mHyperbase, query, out, error)) << error;
+  std::vector<Field> response = parse(out);
+  EXPECT_EQ(all(response, 5).at(0).bytes, "zoo");
+  std::vector<Field> records = all(response, 9);
+  ASSERT_EQ(records.size(), 2u);
+  std::string next = all(response, 10).at(0).bytes;
+  std::vector<Field> local = parse(all(response, 7).at(0).bytes);
+  EXPECT_EQ(all(local, 2).at(0).value, 3u);
+
+  query.after = next;
+  std::string rest;
+  ASSERT_TRUE(encode_category(*mHyperbase, query, rest, error)) << error;
+  response = parse(rest);
+  EXPECT_EQ(all(response, 9).size(), 1u);
+  EXPECT_TRUE(all(response, 10).empty());
+
+  query.category = "nowhere";
+  std::string none;
+  EXPECT_FALSE(encode_category(*mHyperbase, query, none, error));
+  EXPECT_TRUE(none.empty());
+  EXPECT_EQ(error, "unknown category 'nowhere'");
+}
+
+TEST_F(CategoryQueryTest, EncodesTheSameOnTheExecutor) {
+  ConceptFields fields;
+  fields.parents = true;
+  std::vector<std::string> names = {"robin", "nobody"};
+  std::string out;
+  encode_concepts(*mHyperbase, names, fields, out);
+  common::Task<EncodeReply> concepts =
+      encode_concepts_async(mHyperbase, names, fields);
+  EXPECT_TRUE(concepts.Get().ok);
+  EXPECT_EQ(concepts.Get().found, 1u);
+  EXPECT_EQ(concepts.Get().out, out);
+
+  CategoryQuery query;
+  query.category = "nowhere";
+  common::Task<EncodeReply> category =
+      encode_category_async(mHyperbase, query);
+  EXPECT_FALSE(category.Get().ok);
+  EXPECT_FALSE(category.Get().error.empty());
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/core_shards.h"
+#include "server/sharded_hyperbase.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+constexpr uint32_t kCores = 3;
+
+CoreShards::Options small_group() {
+  CoreShards::Options options;
+  options.cores = kCores;
+  // Not pinned, the tests may share few cpus with others.
+  options.pin = false;
+  options.queue_capacity = 4;
+  return options;
+}
+
+TEST(CoreShardsTest, RunsMessagesInOrderOnTheirCore) {
+  CoreShards group(small_group());
+  ASSERT_EQ(group.Size(), kCores);
+  constexpr int kMessages = 100;
+  // Written on core 2 only.
+  std::vector<int> seen;
+  common::Promise<bool> done;
+  // Core 0 sends more than a queue holds to core 2, then itself, from a
+  // message of core 1.
+  group.Send(1, [&group, &seen, done] {
+    group.Send(0, [&group, &seen, done] {
+      for (int i = 0; i < kMessages; ++i) {
+        group.Send(2, [&seen, i] { seen.push_back(i); });
+      }
+      group.Send(0, [&group, &seen, done] {
+        group.Send(2, [&seen, done] { done.Set(seen.size() == kMessages); });
+      });
+    });
+  });
+  EXPECT_TRUE(done.GetTask().Get());
+  for (int i = 0; i < kMessages; ++i) EXPECT_EQ(seen[i], i);
+}
+
+TEST(CoreShardsTest, WakesSleepingCores) {
+  CoreShards group(small_group());
+  std::atomic<int> ran{0};
+  for (int round = 0; round < 3; ++round) {
+    // Long enough for every core to go to sleep.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    common::Promise<int> done;
+    group.Send(round % kCores, [&group, &ran, done, round] {
+      ++ran;
+      group.Send((round + 1) % kCores, [&ran, done] { done.Set(++ran); });
+    });
+    EXPECT_EQ(done.GetTask().Get(), 2 * (round + 1));
+  }
+}
+
+TEST(CoreShardsTest, WalksLineageAcrossCores) {
+  CoreShards group(small_group());
+  ShardedHyperbase sharded(std::make_unique<ShardRouter>(kCores),
+                           group.Clients());
+  std::vector<base::Mutation> batch;
+  for (int i = 0; i < 40; ++i) {
+    base::Mutation mut;
+    mut.subject = "type " + std::to_string(i);
+    if (i > 0) mut.objects.push_back("type " + std::to_string((i - 1) / 3));
+    batch.push_back(std::move(mut));
+  }
+  base::BatchResult result;
+  std::string error;
+  ASSERT_TRUE(sharded.ApplyBatch(batch, result, error)) << error;
+  EXPECT_EQ(result.failed, 0u);
+  // Each core holds a part, written on the core.
+  for (uint32_t core = 0; core < kCores; ++core) {
+    common::Promise<uint64_t> count;
+    group.Send(core, [&group, count, core] {
+      count.Set(group.Hyperbase(core)->ConceptCount());
+    });
+    EXPECT_GT(count.GetTask().Get(), 0u) << core;
+  }
+
+  std::vector<std::string> lineage;
+  ASSERT_TRUE(sharded.Lineage("type 39", base::LineageCursor::ANCESTORS,
+                              lineage, error))
+      << error;
+  std::sort(lineage.begin(), lineage.end());
+  EXPECT_EQ(lineage, (std::vector<std::string>{"type 0", "type 12",
+                                               "type 3"}));
+  bool isa = false;
+  ASSERT_TRUE(sharded.IsA("type 39", "type 0", isa, error)) << error;
+  EXPECT_TRUE(isa);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/storage/snapshot.h"
+#include "server/hyperbase_host.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+class HyperbaseHostTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    mDir = std::filesystem::temp_directory_path() /
+           (std::string("hyperon_host_") + info->name());
+    std::filesystem::remove_all(mDir);
+    std::filesystem::create_directories(mDir);
+    mOptions.data_dir = mDir.string();
+  }
+
+  void TearDown() override { std::filesystem::remove_all(mDir); }
+
+  static void AddConcepts(const base::HyperbasePtr& hyperbase, int count) {
+    std::vector<base::Mutation> batch;
+    for (int i = 0; i < count; ++i) {
+      base::Mutation mut;
+      mut.subject = "c" + std::to_string(i);
+      if (i > 0) mut.objects = {"c0"};
+      batch.push_back(std::move(mut));
+    }
+    hyperbase->ApplyBatch(batch);
+  }
+
+  std::filesystem::path mDir;
+  HyperbaseHost::Options mOptions;
+};
+
+TEST_F(HyperbaseHostTest, EvictsIdleTenantsAndReloadsThem) {
+  mOptions.idle_millis = 0;
+  HyperbaseHost host(mOptions);
+  std::string error;
+  ASSERT_TRUE(host.Create("a", "alice", 0, error)) << error;
+
+  uint64_t version = 0;
+  {
+    base::HyperbasePtr hyperbase;
+    ASSERT_TRUE(host.Acquire("a", hyperbase, error)) << error;
+    AddConcepts(hyperbase, 100);
+    version = hyperbase->Version();
+    // Requests in flight keep their tenant resident.
+    EXPECT_EQ(host.EvictIdle(), 0u);
+    EXPECT_EQ(host.ResidentCount(), 1u);
+    EXPECT_EQ(host.ResidentMemory(), hyperbase->MemoryUsage());
+  }
+  EXPECT_EQ(host.EvictIdle(), 1u);
+  EXPECT_EQ(host.ResidentCount(), 0u);
+  EXPECT_EQ(host.ResidentMemory(), 0u);
+
+  std::vector<TenantInfo> infos = host.List("a");
+  ASSERT_EQ(infos.size(), 1u);
+  EXPECT_FALSE(infos[0].resident);
+  EXPECT_EQ(infos[0].statistics.totals.concepts, 100u);
+
+  base::HyperbasePtr reloaded;
+  ASSERT_TRUE(host.Acquire("a", reloaded, error)) << error;
+  EXPECT_EQ(reloaded->Version(), version);
+  EXPECT_EQ(reloaded->ConceptCount(), 100u);
+  EXPECT_EQ(reloaded->Owner(), "alice");
+  EXPECT_EQ(host.ResidentCount(), 1u);
+}
+
+TEST_F(HyperbaseHostTest, DiscoversSnapshotsOfAnotherProcess) {
+  {
+    HyperbaseHost host(mOptions);
+    std::string error;
+    ASSERT_TRUE(host.Create("a", "alice", 0, error)) << error;
+    base::HyperbasePtr hyperbase;
+    ASSERT_TRUE(host.Acquire("a", hyperbase, error)) << error;
+    AddConcepts(hyperbase, 10);
+    ASSERT_TRUE(host.Flush("a", error)) << error;
+  }
+  // No temporary file is left next to the snapshot.
+  EXPECT_FALSE(std::filesystem::exists(mDir / "a.hb.tmp"));
+
+  HyperbaseHost host(mOptions);
+  EXPECT_EQ(host.Discover(), 1u);
+  EXPECT_EQ(host.ResidentCount(), 0u);
+  base::HyperbasePtr hyperbase;
+  std::string error;
+  ASSERT_TRUE(host.Acquire("a", hyperbase, error)) << error;
+  EXPECT_EQ(hyperbase->ConceptCount(), 10u);
+}
+
+TEST_F(HyperbaseHostTest, EvictsLeastRecentlyUsedOverBudget) {
+  HyperbaseHost host(mOptions);
+  std::string error;
+  for (const char* name : {"old", "new"}) {
+    ASSERT_TRUE(host.Create(name, "", 0, error)) << error;
+    base::HyperbasePtr hyperbase;
+    ASSERT_TRUE(host.Acquire(name, hyperbase, error)) << error;
+    AddConcepts(hyperbase, 1000);
+    ASSERT_TRUE(host.Flush(name, error)) << error;
+  }
+  // Footprint of a tenant as loaded from its snapshot.
+  base::HyperbasePtr loaded;
+  ASSERT_TRUE(base::read_snapshot((mDir / "new.hb").string(), loaded, error))
+      << error;
+  uint64_t one = loaded->MemoryUsage();
+
+  HyperbaseHost::Options options = mOptions;
+  options.resident_budget = one + one / 2;
+  HyperbaseHost budgeted(options);
+  ASSERT_EQ(budgeted.Discover(), 2u);
+  base::HyperbasePtr hyperbase;
+  ASSERT_TRUE(budgeted.Acquire("old", hyperbase, error)) << error;
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_TRUE(budgeted.Acquire("new", hyperbase, error)) << error;
+  hyperbase.reset();
+  EXPECT_EQ(budgeted.ResidentCount(), 2u);
+
+  EXPECT_EQ(budgeted.EvictIdle(), 1u);
+  EXPECT_EQ(budgeted.ResidentCount(), 1u);
+  EXPECT_FALSE(budgeted.List("old")[0].resident);
+  EXPECT_TRUE(budgeted.List("new")[0].resident);
+}
+
+TEST_F(HyperbaseHostTest, ScrapesResidentMemory) {
+  HyperbaseHost host(mOptions);
+  std::string error;
+  ASSERT_TRUE(host.Create("a", "", 0, error)) << error;
+  base::HyperbasePtr hyperbase;
+  ASSERT_TRUE(host.Acquire("a", hyperbase, error)) << error;
+  AddConcepts(hyperbase, 10);
+
+  common::MetricsSnapshot scrape;
+  host.CollectMemory(scrape);
+  double bytes = 0;
+  bool cache = false;
+  for (const auto& sample : scrape) {
+    if (sample.name == "hyperon_hyperbase_memory_bytes") bytes += sample.value;
+    cache |= sample.name == "hyperon_result_cache_bytes";
+  }
+  EXPECT_EQ(bytes, static_cast<double>(hyperbase->MemoryUsage()));
+  EXPECT_TRUE(cache);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "server/query_stream.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+// "root" with 10 children, each with 2 children of its own.
+base::HyperbasePtr make_tree() {
+  auto hyperbase = std::make_shared<base::Hyperbase>("stream");
+  std::vector<base::Mutation> batch;
+  base::Mutation root;
+  root.subject = "root";
+  batch.push_back(root);
+  for (int i = 0; i < 10; ++i) {
+    base::Mutation child;
+    child.subject = "c" + std::to_string(i);
+    child.objects = {"root"};
+    batch.push_back(child);
+    for (int j = 0; j < 2; ++j) {
+      base::Mutation leaf;
+      leaf.subject = child.subject + "." + std::to_string(j);
+      leaf.objects = {child.subject};
+      batch.push_back(leaf);
+    }
+  }
+  hyperbase->ApplyBatch(batch);
+  return hyperbase;
+}
+
+TEST(CursorRegistryTest, ResumesAfterDisconnect) {
+  base::HyperbasePtr hyperbase = make_tree();
+  CursorRegistry registry;
+  LineageQuery query;
+  query.origin = "root";
+  query.chunk_size = 4;
+
+  std::vector<LineageChunk> received;
+  std::string error;
+  // The client goes away after the second chunk.
+  ASSERT_TRUE(registry.StreamLineage(
+      *hyperbase, query,
+      [&received](const LineageChunk& chunk) {
+        received.push_back(chunk);
+        return received.size() < 2;
+      },
+      error));
+  ASSERT_EQ(received.size(), 2u);
+  EXPECT_FALSE(received.back().done);
+  EXPECT_EQ(registry.Size(), 1u);
+
+  query.cursor = received.back().cursor;
+  ASSERT_TRUE(registry.StreamLineage(
+      *hyperbase, query,
+      [&received](const LineageChunk& chunk) {
+        received.push_back(chunk);
+        return true;
+      },
+      error))
+      << error;
+  ASSERT_TRUE(received.back().done);
+
+  std::set<std::string> names;
+  size_t count = 0;
+  for (const auto& chunk : received) {
+    EXPECT_LE(chunk.concepts.size(), 4u);
+    EXPECT_EQ(chunk.version, hyperbase->Version());
+    names.insert(chunk.concepts.begin(), chunk.concepts.end());
+    count += chunk.concepts.size();
+  }
+  EXPECT_EQ(count, 30u);
+  EXPECT_EQ(names.size(), 30u);
+  EXPECT_EQ(names.count("root"), 0u);
+}
+
+TEST(CursorRegistryTest, ReplaysTheLastChunk) {
+  base::HyperbasePtr hyperbase = make_tree();
+  CursorRegistry registry;
+  LineageQuery query;
+  query.origin = "root";
+  query.chunk_size = 8;
+
+  std::vector<LineageChunk> received;
+  std::string error;
+  ASSERT_TRUE(registry.StreamLineage(
+      *hyperbase, query,
+      [&received](const LineageChunk& chunk) {
+        received.push_back(chunk);
+        return received.size() < 2;
+      },
+      error));
+  ASSERT_EQ(received.size(), 2u);
+
+  // The second chunk was lost in transit, resume from the first one.
+  std::vector<LineageChunk> resumed;
+  query.cursor = received[0].cursor;
+  ASSERT_TRUE(registry.StreamLineage(
+      *hyperbase, query,
+      [&resumed](const LineageChunk& chunk) {
+        resumed.push_back(chunk);
+        return true;
+      },
+      error))
+      << error;
+  ASSERT_GE(resumed.size(), 2u);
+  EXPECT_EQ(resumed[0].concepts, received[1].concepts);
+  EXPECT_EQ(resumed[0].cursor, received[1].cursor);
+  EXPECT_TRUE(resumed.back().done);
+
+  // Tokens older than the last chunk cannot be served any more.
+  EXPECT_FALSE(registry.StreamLineage(
+      *hyperbase, query, [](const LineageChunk&) { return true; }, error));
+  EXPECT_EQ(error, "cursor position is out of date");
+}
+
+TEST(CursorRegistryTest, RejectsUnknownCursors) {
+  base::HyperbasePtr hyperbase = make_tree();
+  CursorRegistry registry;
+  LineageQuery query;
+  std::string error;
+  auto ignore = [](const LineageChunk&) { return true; };
+
+  query.origin = "nowhere";
+  EXPECT_FALSE(registry.StreamLineage(*hyperbase, query, ignore, error));
+  query.origin = "root";
+  query.cursor = "garbage";
+  EXPECT_FALSE(registry.StreamLineage(*hyperbase, query, ignore, error));
+  EXPECT_EQ(error, "malformed cursor");
+  query.cursor = "0123456789abcdef.1";
+  EXPECT_FALSE(registry.StreamLineage(*hyperbase, query, ignore, error));
+  EXPECT_EQ(error, "unknown or expired cursor");
+}
+
+TEST(CursorRegistryTest, ExpiresIdleCursors) {
+  base::HyperbasePtr hyperbase = make_tree();
+  CursorRegistry registry(/*ttl_millis=*/0);
+  LineageQuery query;
+  query.origin = "root";
+  query.chunk_size = 1;
+  std::string error;
+  ASSERT_TRUE(registry.StreamLineage(
+      *hyperbase, query, [](const LineageChunk&) { return false; }, error));
+  EXPECT_EQ(registry.Size(), 1u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  EXPECT_EQ(registry.Expire(), 1u);
+  EXPECT_EQ(registry.Size(), 0u);
+}
+
+TEST(CursorRegistryTest, TakesOnlyCachedWalksFittingAChunk) {
+  base::HyperbasePtr hyperbase = make_tree();
+  base::QueryResultCache cache(*hyperbase);
+  CursorRegistry registry;
+  LineageQuery query;
+  query.origin = "root";
+  query.chunk_size = 4;
+  std::string error;
+  std::vector<LineageChunk> received;
+  auto stream = [&] {
+    received.clear();
+    return registry.StreamLineage(
+        *hyperbase, query,
+        [&received](const LineageChunk& chunk) {
+          received.push_back(chunk);
+          return true;
+        },
+        error, &cache);
+  };
+
+  // Nothing cached: the cursor walks and nothing is computed for the cache.
+  ASSERT_TRUE(stream()) << error;
+  EXPECT_GT(received.size(), 1u);
+  EXPECT_EQ(cache.Stats().misses, 0u);
+  EXPECT_EQ(cache.Stats().entries, 0u);
+
+  // Cached but larger than a chunk: walked again.
+  cache.Lineage("root", base::LineageCursor::DESCENDANTS);
+  cache.Lineage("c0", base::LineageCursor::DESCENDANTS);
+  ASSERT_TRUE(stream()) << error;
+  EXPECT_GT(received.size(), 1u);
+  EXPECT_EQ(cache.Stats().hits, 0u);
+
+  query.origin = "c0";
+  ASSERT_TRUE(stream()) << error;
+  ASSERT_EQ(received.size(), 1u);
+  EXPECT_TRUE(received[0].done);
+  EXPECT_EQ(received[0].concepts.size(), 2u);
+  EXPECT_EQ(cache.Stats().hits, 1u);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/utils/time.h"
+#include "server/replica.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+base::Mutation create(const std::string& name) {
+  base::Mutation mut;
+  mut.subject = name;
+  return mut;
+}
+
+// Serves fixed entries, `reads` read calls at a time until opened.
+class GatedLogSource : public LogSource {
+public:
+  explicit GatedLogSource(std::vector<base::LogEntry> entries)
+      : mEntries(std::move(entries)) {}
+
+  /* override */ bool ReadAfter(uint64_t after_version, size_t max_entries,
+                                uint64_t, std::vector<base::LogEntry>& out) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mOpened.wait(lock, [this] { return mReads > 0 || mOpen; });
+    if (!mOpen) --mReads;
+    for (const auto& entry : mEntries) {
+      if (entry.version > after_version && out.size() < max_entries) {
+        out.push_back(entry);
+      }
+    }
+    return true;
+  }
+
+  /* override */ uint64_t LastVersion() { return mEntries.back().version; }
+
+  void Allow(size_t reads) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mReads += reads;
+    mOpened.notify_all();
+  }
+
+  // Serve every read from now on.
+  void Open() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mOpen = true;
+    mOpened.notify_all();
+  }
+
+private:
+  const std::vector<base::LogEntry> mEntries;
+  std::mutex mMutex;
+  std::condition_variable mOpened;
+  size_t mReads{0};
+  bool mOpen{false};
+};
+
+TEST(ReplicaFollowerTest, ReportsTheLagOfThePendingEntries) {
+  uint64_t now = common::now_millis();
+  std::vector<base::LogEntry> entries;
+  for (uint64_t age : {10000, 8000, 300, 200}) {
+    base::LogEntry entry;
+    entry.version = entries.size() + 1;
+    entry.commit_time = now - age;
+    entry.mutations = {create("c" + std::to_string(entry.version))};
+    entries.push_back(std::move(entry));
+  }
+  auto source = std::make_shared<GatedLogSource>(entries);
+  ReplicaFollower::Options options;
+  options.batch_entries = 2;
+  ReplicaFollower follower(std::make_shared<base::Hyperbase>("replica"),
+                           source, nullptr, options);
+  follower.Start();
+  source->Allow(1);
+
+  base::HyperbasePtr replica;
+  ASSERT_TRUE(follower.WaitForVersion(2, 5000, replica));
+  ReplicationStatus status = follower.Status();
+  EXPECT_EQ(status.applied_version, 2u);
+  EXPECT_EQ(status.lag_versions, 2u);
+  // The oldest pending entry is the third one, not the first.
+  EXPECT_GE(status.lag_millis, 300u);
+  EXPECT_LT(status.lag_millis, 5000u);
+
+  source->Allow(2);
+  ASSERT_TRUE(follower.WaitForVersion(4, 5000, replica));
+  EXPECT_EQ(replica->ConceptCount(), 4u);
+  // Let the follower exit its next read.
+  source->Open();
+  follower.Stop();
+  EXPECT_EQ(follower.Status().lag_millis, 0u);
+  EXPECT_EQ(follower.LastError(), "");
+}
+
+TEST(ReplicaFollowerTest, ResyncsPastTheRetainedLog) {
+  auto leader = std::make_shared<base::Hyperbase>("leader");
+  auto log = std::make_shared<base::MutationLog>(2);
+  leader->AddCommitObserver(log);
+  for (int i = 0; i < 5; ++i) {
+    leader->ApplyBatch({create("c" + std::to_string(i))});
+  }
+
+  // Stands in for the snapshot the leader took at version 3.
+  int resyncs = 0;
+  auto resync = [&resyncs](base::HyperbasePtr& fresh, std::string&) {
+    ++resyncs;
+    fresh = std::make_shared<base::Hyperbase>("replica");
+    fresh->ApplyReplicatedBatch({create("c0"), create("c1"), create("c2")}, 3);
+    return true;
+  };
+  ReplicaFollower::Options options;
+  options.poll_millis = 10;
+  ReplicaFollower follower(std::make_shared<base::Hyperbase>("replica"),
+                           std::make_shared<LocalLogSource>(log), resync,
+                           options);
+  follower.Start();
+  base::HyperbasePtr replica;
+  ASSERT_TRUE(follower.WaitForVersion(5, 5000, replica));
+  EXPECT_EQ(replica->ConceptCount(), 5u);
+  EXPECT_EQ(follower.Status().resyncs, 1u);
+
+  // Tailing resumes from the resynced replica.
+  leader->ApplyBatch({create("c5")});
+  ASSERT_TRUE(follower.WaitForVersion(6, 5000, replica));
+  EXPECT_TRUE(replica->HasConcept("c5"));
+  follower.Stop();
+  EXPECT_EQ(resyncs, 1);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "server/rpc_metrics.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+const MetricSeries* find(const std::vector<MetricSeries>& series,
+                         const std::string& name, const std::string& labels) {
+  for (const auto& one : series) {
+    if (one.name == name && one.labels == labels) return &one;
+  }
+  return nullptr;
+}
+
+TEST(RpcMetricsTest, FetchesSeriesByPrefix) {
+  std::vector<MetricSeries> before;
+  fetch_metrics("hyperon_rpc_", before);
+  ASSERT_FALSE(before.empty());
+  // Every method is listed before its first call.
+  const MetricSeries* failed = find(before, "hyperon_rpc_requests_total",
+                                    "method=\"BulkIngest\",outcome=\"error\"");
+  ASSERT_NE(failed, nullptr);
+  double failed_before = failed->value;
+
+  for (int i = 0; i < 3; ++i) {
+    RpcScope scope(RPC_BULK_INGEST);
+    if (i == 0) scope.Fail();
+  }
+
+  std::vector<MetricSeries> after;
+  fetch_metrics("hyperon_rpc_", after);
+  for (const auto& series : after) {
+    EXPECT_EQ(series.name.compare(0, 12, "hyperon_rpc_"), 0) << series.name;
+  }
+  EXPECT_EQ(find(after, "hyperon_rpc_requests_total",
+                 "method=\"BulkIngest\",outcome=\"error\"")
+                ->value,
+            failed_before + 1);
+  // The first fetch counts as a call too.
+  const MetricSeries* fetches = find(after, "hyperon_rpc_requests_total",
+                                     "method=\"FetchMetrics\",outcome=\"ok\"");
+  ASSERT_NE(fetches, nullptr);
+  EXPECT_GE(fetches->value, 1.0);
+  EXPECT_EQ(fetches->type, common::MetricSample::COUNTER);
+
+  const MetricSeries* latency = find(after, "hyperon_rpc_latency_seconds",
+                                     "method=\"BulkIngest\"");
+  ASSERT_NE(latency, nullptr);
+  EXPECT_EQ(latency->type, common::MetricSample::HISTOGRAM);
+  EXPECT_GE(latency->latency.count, 3u);
+  EXPECT_LE(latency->latency.p50, latency->latency.p90);
+  EXPECT_LE(latency->latency.p90, latency->latency.p99);
+  EXPECT_LE(latency->latency.p99, latency->latency.p999);
+  EXPECT_LE(latency->latency.p999, latency->latency.max);
+
+  std::vector<MetricSeries> none;
+  fetch_metrics("no_such_prefix", none);
+  EXPECT_TRUE(none.empty());
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
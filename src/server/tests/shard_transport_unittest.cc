@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "server/shard_transport.h"
+#include "server/sharded_hyperbase.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+base::Mutation create(const std::string& name, const std::string& category,
+                      std::vector<std::string> parents = {}) {
+  base::Mutation mut;
+  mut.subject = name;
+  mut.category = category;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+base::Mutation add_parent(const std::string& child,
+                          const std::string& parent) {
+  base::Mutation mut;
+  mut.kind = base::Mutation::MUT_ADD_PARENT;
+  mut.subject = child;
+  mut.objects = {parent};
+  return mut;
+}
+
+// A shard served on a loopback port, and a client to it.
+class ShardTransportTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    Serve(0);
+    mClient = std::make_unique<RemoteShardClient>("127.0.0.1", mPort, "hb");
+  }
+
+  void Serve(uint16_t port) {
+    mEndpoint = std::make_unique<ShardEndpoint>(mHyperbase);
+    std::string error;
+    ASSERT_TRUE(mEndpoint->Start("127.0.0.1", port, error)) << error;
+    mPort = mEndpoint->Port();
+  }
+
+  void Apply(const ShardBatch& batch, base::BatchResult& result,
+             std::vector<uint32_t>& failed) {
+    std::string error;
+    ASSERT_TRUE(mClient->Apply(batch, result, failed, error)) << error;
+  }
+
+  base::HyperbasePtr mHyperbase{std::make_shared<base::Hyperbase>("hb")};
+  std::unique_ptr<ShardEndpoint> mEndpoint;
+  std::unique_ptr<RemoteShardClient> mClient;
+  uint16_t mPort{0};
+};
+
+TEST_F(ShardTransportTest, AppliesBatchesWithTheirGhosts) {
+  ShardBatch batch;
+  batch.ghosts.push_back({"remote", base::Mutation::KIND_ENTITY});
+  batch.mutations = {create("animal", "nature"),
+                     create("dog", "nature", {"animal", "remote"}),
+                     add_parent("dog", "nothing"),
+                     create("animal", "nature")};
+  base::Hyperbase local("hb");
+  std::vector<uint32_t> local_failed;
+  base::BatchResult expected = apply_shard_batch(local, batch, &local_failed);
+
+  base::BatchResult result;
+  std::vector<uint32_t> failed = {7};
+  Apply(batch, result, failed);
+  EXPECT_EQ(result.applied, expected.applied);
+  EXPECT_EQ(result.failed, 2u);
+  EXPECT_EQ(result.version, mHyperbase->Version());
+  // Appended to what was there.
+  local_failed.insert(local_failed.begin(), 7);
+  EXPECT_EQ(failed, local_failed);
+
+  base::ConceptPtr ghost;
+  ASSERT_TRUE(mHyperbase->GetConcept("remote", ghost));
+  EXPECT_EQ(ghost->GetCategory()->Name(), kGhostCategory);
+  EXPECT_TRUE(mHyperbase->HasConcept("dog"));
+
+  // Nothing failed, no positions.
+  batch.ghosts.clear();
+  batch.mutations = {create("cat", "", {"animal"})};
+  failed.clear();
+  Apply(batch, result, failed);
+  EXPECT_EQ(result.applied, 1u);
+  EXPECT_EQ(result.failed, 0u);
+  EXPECT_TRUE(failed.empty());
+}
+
+TEST_F(ShardTransportTest, FetchesAdjacencyAndLooksConceptsUp) {
+  base::BatchResult result;
+  std::vector<uint32_t> failed;
+  ShardBatch batch;
+  batch.mutations = {create("animal", ""), create("dog", "", {"animal"}),
+                     create("cat", "", {"animal"}), create("plant", "")};
+  Apply(batch, result, failed);
+
+  std::vector<std::vector<std::string>> adjacency;
+  std::string error;
+  ASSERT_TRUE(mClient->FetchAdjacency({"animal", "unknown", "plant", "dog"},
+                                      base::LineageCursor::DESCENDANTS,
+                                      adjacency, error))
+      << error;
+  ASSERT_EQ(adjacency.size(), 4u);
+  std::sort(adjacency[0].begin(), adjacency[0].end());
+  EXPECT_EQ(adjacency[0], (std::vector<std::string>{"cat", "dog"}));
+  EXPECT_TRUE(adjacency[1].empty());
+  EXPECT_TRUE(adjacency[2].empty());
+  EXPECT_TRUE(adjacency[3].empty());
+  ASSERT_TRUE(mClient->FetchAdjacency({"dog"}, base::LineageCursor::ANCESTORS,
+                                      adjacency, error))
+      << error;
+  EXPECT_EQ(adjacency, (std::vector<std::vector<std::string>>{{"animal"}}));
+
+  bool found = false;
+  ASSERT_TRUE(mClient->HasConcept("plant", found, error)) << error;
+  EXPECT_TRUE(found);
+  ASSERT_TRUE(mClient->HasConcept("unknown", found, error)) << error;
+  EXPECT_FALSE(found);
+
+  // The asynchronous calls go through the same connection.
+  ContainsReply reply = mClient->HasConceptAsync("dog").Get();
+  EXPECT_TRUE(reply.ok) << reply.error;
+  EXPECT_TRUE(reply.found);
+}
+
+TEST_F(ShardTransportTest, FailsCallsForAnotherHyperbase) {
+  RemoteShardClient other("127.0.0.1", mPort, "other");
+  ShardBatch batch;
+  batch.mutations = {create("animal", "")};
+  base::BatchResult result;
+  std::vector<uint32_t> failed;
+  std::string error;
+  EXPECT_FALSE(other.Apply(batch, result, failed, error));
+  EXPECT_EQ(error, "unknown hyperbase 'other'");
+  bool found = false;
+  EXPECT_FALSE(other.HasConcept("animal", found, error));
+  EXPECT_EQ(error, "unknown hyperbase 'other'");
+  EXPECT_FALSE(mHyperbase->HasConcept("animal"));
+}
+
+TEST_F(ShardTransportTest, ReconnectsAfterTheShardRestarts) {
+  bool found = false;
+  std::string error;
+  ASSERT_TRUE(mClient->HasConcept("animal", found, error)) << error;
+
+  uint16_t port = mPort;
+  mEndpoint->Stop();
+  EXPECT_FALSE(mClient->HasConcept("animal", found, error));
+  EXPECT_NE(error.find("127.0.0.1"), std::string::npos) << error;
+  EXPECT_FALSE(mClient->HasConcept("animal", found, error));
+  EXPECT_NE(error.find("cannot connect to shard"), std::string::npos)
+      << error;
+
+  Serve(port);
+  ASSERT_TRUE(mClient->HasConcept("animal", found, error)) << error;
+  EXPECT_FALSE(found);
+}
+
+TEST(RemoteShardClientTest, RejectsInvalidAddresses) {
+  RemoteShardClient client("not an address", 1, "hb");
+  bool found = false;
+  std::string error;
+  EXPECT_FALSE(client.HasConcept("animal", found, error));
+  EXPECT_EQ(error, "invalid shard address 'not an address'");
+}
+
+TEST(ShardTransportRoutingTest, WalksLineageAcrossServedShards) {
+  constexpr uint32_t kShards = 3;
+  std::vector<std::unique_ptr<ShardEndpoint>> endpoints;
+  std::vector<std::shared_ptr<ShardClient>> clients;
+  for (uint32_t i = 0; i < kShards; ++i) {
+    endpoints.push_back(std::make_unique<ShardEndpoint>(
+        std::make_shared<base::Hyperbase>("hb")));
+    std::string error;
+    ASSERT_TRUE(endpoints.back()->Start("127.0.0.1", 0, error)) << error;
+    clients.push_back(std::make_shared<RemoteShardClient>(
+        "127.0.0.1", endpoints.back()->Port(), "hb"));
+  }
+  ShardedHyperbase sharded(
+      std::make_unique<ShardRouter>(kShards, ShardRouter::CATEGORY),
+      std::move(clients));
+
+  std::vector<base::Mutation> batch = {create("animal", "a")};
+  for (int i = 0; i < 12; ++i) {
+    std::string name = "c" + std::to_string(i);
+    batch.push_back(create(name, name, {i ? "c" + std::to_string(i - 1)
+                                          : std::string("animal")}));
+  }
+  base::BatchResult result;
+  std::string error;
+  ASSERT_TRUE(sharded.ApplyBatch(batch, result, error)) << error;
+  EXPECT_EQ(result.failed, 0u);
+
+  std::vector<std::string> lineage;
+  ASSERT_TRUE(sharded.Lineage("animal", base::LineageCursor::DESCENDANTS,
+                              lineage, error))
+      << error;
+  EXPECT_EQ(lineage.size(), 12u);
+  bool isa = false;
+  ASSERT_TRUE(sharded.IsA("c11", "animal", isa, error)) << error;
+  EXPECT_TRUE(isa);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
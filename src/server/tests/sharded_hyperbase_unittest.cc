@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "server/sharded_hyperbase.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+constexpr uint32_t kShards = 3;
+
+base::Mutation create(const std::string& name, const std::string& category,
+                      std::vector<std::string> parents = {}) {
+  base::Mutation mut;
+  mut.subject = name;
+  mut.category = category;
+  mut.objects = std::move(parents);
+  return mut;
+}
+
+// Category partitioned hyperbase over in-process shards.
+class ShardedHyperbaseTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    mPath = std::filesystem::temp_directory_path() /
+            (std::string("hyperon_directory_") + info->name());
+    std::filesystem::remove(mPath);
+    for (uint32_t i = 0; i < kShards; ++i) {
+      mHyperbases.push_back(
+          std::make_shared<base::Hyperbase>("shard" + std::to_string(i)));
+    }
+    // Unknown concepts are looked up on the shard of the root category.
+    // Find one category placed there and one placed elsewhere.
+    ShardRouter probe(kShards, ShardRouter::CATEGORY);
+    mFallback = probe.Owner("");
+    for (int i = 0; mNear.empty() || mFar.empty(); ++i) {
+      std::string category = "category" + std::to_string(i);
+      bool near = probe.Place("", category) == mFallback;
+      (near ? mNear : mFar) = category;
+    }
+    mFarShard = probe.Place("", mFar);
+    Reopen();
+  }
+
+  void TearDown() override { std::filesystem::remove(mPath); }
+
+  // A new router over the same shards, as after a restart.
+  void Reopen() {
+    auto router =
+        std::make_unique<ShardRouter>(kShards, ShardRouter::CATEGORY);
+    std::string error;
+    ASSERT_TRUE(router->Open(mPath.string(), error)) << error;
+    mRouter = router.get();
+    std::vector<std::shared_ptr<ShardClient>> shards;
+    for (const auto& hyperbase : mHyperbases) {
+      shards.push_back(std::make_shared<LocalShardClient>(hyperbase));
+    }
+    mSharded = std::make_unique<ShardedHyperbase>(std::move(router),
+                                                  std::move(shards));
+  }
+
+  void Apply(const std::vector<base::Mutation>& batch) {
+    base::BatchResult result;
+    std::string error;
+    ASSERT_TRUE(mSharded->ApplyBatch(batch, result, error)) << error;
+  }
+
+  size_t ChildCount(uint32_t shard, const std::string& name) const {
+    base::ConceptPtr cnpt;
+    if (!mHyperbases[shard]->GetConcept(name, cnpt)) return 0;
+    size_t count = 0;
+    cnpt->ForEachChild([&count](const base::ElementPtr&) { ++count; });
+    return count;
+  }
+
+  std::filesystem::path mPath;
+  std::vector<base::HyperbasePtr> mHyperbases;
+  std::string mNear;
+  std::string mFar;
+  uint32_t mFallback{0};
+  uint32_t mFarShard{0};
+  ShardRouter* mRouter{nullptr};
+  std::unique_ptr<ShardedHyperbase> mSharded;
+};
+
+TEST_F(ShardedHyperbaseTest, WalksLineageAcrossShards) {
+  Apply({create("animal", mFar), create("dog", mNear, {"animal"}),
+         create("puppy", mNear, {"dog"})});
+  EXPECT_TRUE(mHyperbases[mFarShard]->HasConcept("animal"));
+  EXPECT_TRUE(mHyperbases[mFallback]->HasConcept("dog"));
+  EXPECT_EQ(mRouter->DirectorySize(), 3u);
+
+  std::vector<std::string> result;
+  std::string error;
+  ASSERT_TRUE(mSharded->Lineage("animal", base::LineageCursor::DESCENDANTS,
+                                result, error))
+      << error;
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ(result, (std::vector<std::string>{"dog", "puppy"}));
+  bool isa = false;
+  ASSERT_TRUE(mSharded->IsA("puppy", "animal", isa, error)) << error;
+  EXPECT_TRUE(isa);
+}
+
+TEST_F(ShardedHyperbaseTest, DuplicateCreatesKeepTheirShard) {
+  Apply({create("plant", mNear), create("dog", mFar)});
+  // Created again in another category, with a parent on another shard.
+  Apply({create("dog", mNear, {"plant"})});
+  EXPECT_EQ(mRouter->Owner("dog"), mFarShard);
+  EXPECT_FALSE(mHyperbases[mFallback]->HasConcept("dog"));
+  EXPECT_EQ(ChildCount(mFallback, "plant"), 0u);
+  EXPECT_EQ(mRouter->DirectorySize(), 2u);
+}
+
+TEST_F(ShardedHyperbaseTest, FailedCreatesLeaveNoRemoteEdges) {
+  Apply({create("plant", mFar)});
+  // The first parent does not exist on the home shard.
+  base::BatchResult result;
+  std::string error;
+  ASSERT_TRUE(mSharded->ApplyBatch({create("lost", mNear, {"none", "plant"})},
+                                   result, error))
+      << error;
+  EXPECT_EQ(result.applied, 0u);
+  EXPECT_EQ(result.failed, 1u);
+  EXPECT_EQ(mRouter->DirectorySize(), 1u);
+  EXPECT_EQ(ChildCount(mFarShard, "plant"), 0u);
+  EXPECT_FALSE(mHyperbases[mFarShard]->HasConcept("lost"));
+}
+
+TEST_F(ShardedHyperbaseTest, ReloadsTheDirectory) {
+  Apply({create("animal", mFar), create("dog", mFar, {"animal"})});
+  Apply({create("dog", mNear)});
+  Reopen();
+  EXPECT_EQ(mRouter->DirectorySize(), 2u);
+  EXPECT_EQ(mRouter->Owner("dog"), mFarShard);
+
+  // A record torn by a crash is dropped, earlier ones are kept.
+  std::ofstream(mPath, std::ios::app) << "0\t0\t\tcat\t";
+  Reopen();
+  EXPECT_EQ(mRouter->DirectorySize(), 2u);
+  Apply({create("cat", mFar, {"animal"})});
+  Reopen();
+  EXPECT_EQ(mRouter->DirectorySize(), 3u);
+  std::vector<std::string> result;
+  std::string error;
+  ASSERT_TRUE(mSharded->Lineage("animal", base::LineageCursor::DESCENDANTS,
+                                result, error))
+      << error;
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ(result, (std::vector<std::string>{"cat", "dog"}));
+}
+
+TEST(ShardRouterTest, RejectsCorruptDirectories) {
+  auto path = std::filesystem::temp_directory_path() / "hyperon_corrupt";
+  std::ofstream(path) << "garbage\n0\t0\t\tdog\t0\n";
+  ShardRouter router(kShards, ShardRouter::CATEGORY);
+  std::string error;
+  EXPECT_FALSE(router.Open(path.string(), error));
+  EXPECT_NE(error.find(":1: malformed"), std::string::npos);
+  std::filesystem::remove(path);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "server/slow_query_log.h"
+
+namespace hyperon {
+namespace server {
+namespace {
+
+std::string read_file(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+double slow_queries() {
+  std::vector<MetricSeries> series;
+  fetch_metrics("hyperon_slow_queries_total", series);
+  return series.empty() ? 0 : series[0].value;
+}
+
+common::ProfileNode profile(uint64_t millis) {
+  common::ProfileNode root("find_events", "during [8, 12]");
+  root.nanos = millis * 1000000;
+  root.loops = 1;
+  root.rows_out = 2;
+  root.AddChild("interval_scan", "", "interval_tree").rows_out = 2;
+  return root;
+}
+
+class SlowQueryLogTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    mPath = ::testing::TempDir() + "slow_query_log_unittest.log";
+    std::remove(mPath.c_str());
+  }
+
+  void TearDown() override {
+    SlowQueryLog::Instance().Close();
+    std::remove(mPath.c_str());
+  }
+
+  SlowQueryLog& mLog = SlowQueryLog::Instance();
+  std::string mPath;
+};
+
+TEST_F(SlowQueryLogTest, LogsQueriesReachingTheThreshold) {
+  EXPECT_FALSE(mLog.Enabled());
+  EXPECT_FALSE(mLog.Record(RPC_QUERY_EVENTS, "hb", profile(1000)));
+
+  std::string error;
+  ASSERT_TRUE(mLog.Open(5, mPath, error)) << error;
+  EXPECT_TRUE(mLog.Enabled());
+  uint64_t logged = mLog.Logged();
+  double counted = slow_queries();
+
+  EXPECT_FALSE(mLog.Record(RPC_QUERY_EVENTS, "hb", profile(4)));
+  // The threshold is inclusive.
+  EXPECT_TRUE(mLog.Record(RPC_QUERY_EVENTS, "hb", profile(5)));
+  EXPECT_TRUE(mLog.Record(RPC_FETCH_CATEGORY, "other", profile(70)));
+  EXPECT_EQ(mLog.Logged(), logged + 2);
+  EXPECT_EQ(slow_queries(), counted + 2);
+
+  std::string text = read_file(mPath);
+  EXPECT_NE(text.find(" slow query: QueryEvents on hb took 5.000ms\n"
+                      "find_events (during [8, 12]) time=5.000ms loops=1 "
+                      "rows=0->2\n"
+                      "  -> interval_scan index=interval_tree rows=0->2\n"),
+            std::string::npos)
+      << text;
+  EXPECT_NE(text.find("slow query: FetchCategory on other took 70.000ms"),
+            std::string::npos);
+  EXPECT_EQ(text.find("took 4.000ms"), std::string::npos);
+}
+
+TEST_F(SlowQueryLogTest, DisablesWithAZeroThresholdOrOnClose) {
+  std::string error;
+  ASSERT_TRUE(mLog.Open(1, mPath, error)) << error;
+  ASSERT_TRUE(mLog.Open(0, mPath, error)) << error;
+  EXPECT_FALSE(mLog.Enabled());
+  EXPECT_FALSE(mLog.Record(RPC_QUERY_EVENTS, "hb", profile(1000)));
+
+  ASSERT_TRUE(mLog.Open(1, mPath, error)) << error;
+  mLog.Close();
+  EXPECT_FALSE(mLog.Enabled());
+  EXPECT_FALSE(mLog.Record(RPC_QUERY_EVENTS, "hb", profile(1000)));
+  EXPECT_EQ(read_file(mPath), "");
+}
+
+TEST_F(SlowQueryLogTest, KeepsTheLogWhenTheFileCannotBeOpened) {
+  std::string error;
+  ASSERT_TRUE(mLog.Open(10, mPath, error)) << error;
+  EXPECT_FALSE(mLog.Open(1, "/nonexistent/dir/slow.log", error));
+  EXPECT_EQ(error.find("cannot open slow query log /nonexistent/dir/slow.log"),
+            0u);
+  // Still logging to the first file, at the first threshold.
+  EXPECT_FALSE(mLog.Record(RPC_QUERY_EVENTS, "hb", profile(5)));
+  EXPECT_TRUE(mLog.Record(RPC_QUERY_EVENTS, "hb", profile(10)));
+  EXPECT_NE(read_file(mPath).find("took 10.000ms"), std::string::npos);
+}
+
+}  // namespace
+}  // namespace server
+}  // namespace hyperon